@@ -95,6 +95,8 @@ for /F "tokens=1* delims=]" %%i in ('find /v /n "" ^.\..\src\silo\silo.h.in') do
         @echo %%A%pre%>> %SiloOut% 
       ) else if "%%B"=="SILO_VERS_TAG" (
         @echo %%A Silo_version_%major%_%minor%%underpatch%%underpre%>> %SiloOut%
+      ) else if "%%B"=="SILO_THREADSAFE" (
+          @echo %%A0%%C>> %SiloOut%
       ) else if "%%B"=="SILO_DTYPPTR" (
           @echo %%Avoid%%C>> %SiloOut%
       ) else if "%%B"=="SILO_DTYPPTR1" (
@@ -103,7 +103,7 @@ product endorsement purposes.
      11. Fix skipping truncate (maybe by 3)
     *12. Sanity check block size on read relative to write.
      13. Get performance studies on other systems
-     14. Study read performance too.
+    *14. Study read performance too.
      15. Move to DICHOTOMY and write all meta blocks at end of file.
      16. Write blocks from different MPI tasks to same file. On read
          back, need to specify which 'task' but should otherwise work.
@@ -139,6 +139,12 @@ product endorsement purposes.
 #endif
 #define MAX(X,Y)	((X)>(Y)?(X):(Y))
 
+/* Silo's per-DBfile statistics (see DBGetFileStats) collect seeks and block
+   cache lookups from here. Declared directly rather than pulling in
+   silo_private.h. */
+extern void db_StatSeek(void);
+extern void db_StatCache(int hit);
+
 /* File operations */
 #define OP_UNKNOWN      0
 #define OP_READ         1
@@ -151,6 +157,10 @@ product endorsement purposes.
 #define SILO_BLKCNT_PROPNAME "silo_block_count"
 #define SILO_LOGSTS_PROPNAME "silo_log_stats"
 #define SILO_USEDIR_PROPNAME "silo_use_direct"
+#define SILO_RDAHEAD_PROPNAME "silo_read_ahead"
+
+/* consecutive forward block misses before read-ahead kicks in */
+#define SILO_SEQ_THRESHOLD 2
 
 /* definitions related to the file stat utilities.
  * For Unix, if off_t is not 64bit big, try use the pseudo-standard
@@ -252,13 +262,13 @@ static const char *flavors(H5F_mem_t m)
         snprintf(msg, sizeof(msg), Msg "(errno=%d, \"%s\")",	\
             Errno, strerror(Errno));					\
     ret_value = Ret;							\
-    H5Epush_ret(Func, Cls, Maj, Min, msg, Ret)				\
+    H5Epush_ret(Func, Cls, Maj, Min, msg, Ret);				\
 }
 #else
 #define H5E_PUSH_HELPER(Func,Cls,Maj,Min,Msg,Ret,Errno)			\
 {									\
     ret_value = Ret;							\
-    H5Epush_ret(Func, Cls, Maj, Min, Msg, Ret)				\
+    H5Epush_ret(Func, Cls, Maj, Min, Msg, Ret);				\
 }
 #endif
 
@@ -302,6 +312,17 @@ typedef struct silo_vfd_stats_t_
     hsize_t total_block_re_reads;
     double total_time_in_reads;
 
+    /* read-only block cache behavior */
+    hsize_t num_block_hits;
+    hsize_t num_block_misses;
+    hsize_t num_blocks_read_ahead;
+    hsize_t num_read_ahead_hits;
+    hsize_t num_read_ahead_unused;
+    hsize_t num_raw_evictions;
+    hsize_t num_md_evictions;
+    hsize_t num_bypass_reads;
+    hsize_t num_bypass_blocks;
+
     int num_hot_blocks;
     int max_hot_blocks;
     silo_vfd_hot_block_stats_t *hot_block_list;
@@ -352,6 +373,7 @@ typedef struct silo_vfd_block_t_
     hsize_t age;
     void *buf;
     unsigned dirty;
+    unsigned prefetched; /* read ahead and not yet referenced */
     hsize_t minmoff, maxmoff;
     hsize_t minroff, maxroff;
 } silo_vfd_block_t;
@@ -403,6 +425,9 @@ typedef struct H5FD_silo_t {
     int         log_stats;
     char       *log_name;
     int         use_direct;
+    int         read_ahead;             /* max blocks to read ahead in read-only mode */
+    hsize_t     seq_next_id;            /* block id of next miss if reading forward */
+    int         seq_run;                /* number of consecutive forward misses */
     silo_vfd_block_bitmap_t was_written_map;
     silo_vfd_block_bitmap_t was_in_mem_map;
     silo_vfd_stats_t stats;
@@ -769,6 +794,66 @@ static int find_block_to_preempt(H5FD_silo_t *file)
     return min_ridx;
 }
 
+static int block_is_md(const silo_vfd_block_t *b)
+{
+    int msize = b->maxmoff - b->minmoff;
+    int rsize = b->maxroff - b->minroff;
+    return msize > rsize;
+}
+
+/*
+ * Eviction order for files opened read-only. Blocks that were read ahead
+ * but never referenced go first, then raw data blocks in LRU order. Meta
+ * data blocks are pinned and given up only when nothing else is left.
+ */
+static int find_block_to_preempt_for_read(H5FD_silo_t *file)
+{
+    int i;
+    int min_pidx = -1;
+    int min_ridx = -1;
+    int min_midx = -1;
+    silo_vfd_block_t *bl = file->block_list;
+    hsize_t min_page = file->op_counter;
+    hsize_t min_rage = file->op_counter;
+    hsize_t min_mage = file->op_counter;
+
+    for (i = 1; i < file->num_blocks; i++)
+    {
+        if (bl[i].prefetched)
+        {
+            if (bl[i].age < min_page)
+            {
+                min_page = bl[i].age;
+                min_pidx = i;
+            }
+        }
+        else if (block_is_md(&bl[i]))
+        {
+            if (bl[i].age < min_mage)
+            {
+                min_mage = bl[i].age;
+                min_midx = i;
+            }
+        }
+        else
+        {
+            if (bl[i].age < min_rage)
+            {
+                min_rage = bl[i].age;
+                min_ridx = i;
+            }
+        }
+    }
+
+    if (min_pidx != -1)
+        return min_pidx;
+    if (min_ridx != -1)
+        return min_ridx;
+    if (min_midx != -1)
+        return min_midx;
+    return file->num_blocks ? 0 : -1;
+}
+
 static herr_t put_data_to_block_by_index(H5FD_silo_t *file, H5FD_mem_t type, const void *srcbuf, hsize_t size,
     int blidx, int off)
 {
@@ -818,6 +903,12 @@ static herr_t get_data_from_block_by_index(H5FD_silo_t *file, H5FD_mem_t type, v
 
     block->age = file->op_counter++;
 
+    if (block->prefetched)
+    {
+        block->prefetched = 0;
+        file->stats.num_read_ahead_hits++;
+    }
+
     if (type == H5FD_MEM_DRAW)
     {
         if (off < block->minroff) block->minroff = off;
@@ -855,6 +946,7 @@ static herr_t file_write(H5FD_silo_t *file, haddr_t addr, size_t size, const voi
         if (HDlseek(file->fd, (file_offset_t)addr, SEEK_SET) < 0)
             H5E_PUSH_HELPER (func, H5E_ERR_CLS, H5E_IO, H5E_SEEKERROR, "HDlseek failed", -1, errno)
         file->stats.total_seeks++;
+        db_StatSeek();
     }
 
     /* Write data, being careful of interrupted system calls and partial results */
@@ -914,6 +1006,7 @@ static herr_t file_read(H5FD_silo_t *file, haddr_t addr, size_t size, void *buf)
         if (HDlseek(file->fd, (file_offset_t)addr, SEEK_SET) < 0)
             H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_IO, H5E_SEEKERROR, "HDlseek failed", -1, errno)
         file->stats.total_seeks++;
+        db_StatSeek();
     }
 
     /* Read data, careful of interrupted system calls, partial results and eof */
@@ -1074,9 +1167,9 @@ static herr_t insert_block_by_index(H5FD_silo_t *file, int blidx)
     return 0;
 }
 
-static int alloc_block_by_id(H5FD_silo_t *file, hsize_t id)
+/* insert an empty block for id in the list but do not read its contents */
+static int new_block_by_id(H5FD_silo_t *file, hsize_t id)
 {
-    haddr_t addr0 = id * file->block_size;
     silo_vfd_block_t *b;
     int blidx = find_block_by_id(file, id, CLOSEST);
 
@@ -1097,6 +1190,14 @@ static int alloc_block_by_id(H5FD_silo_t *file, hsize_t id)
     b->minroff = file->block_size;
     b->maxroff = 0;
 
+    return blidx;
+}
+
+static int alloc_block_by_id(H5FD_silo_t *file, hsize_t id)
+{
+    haddr_t addr0 = id * file->block_size;
+    int blidx = new_block_by_id(file, id);
+
     if (addr0<file->file_eof)
         file_read_block(file, blidx);
 
@@ -1129,6 +1230,109 @@ static herr_t free_block_by_index(H5FD_silo_t *file, int blidx)
     return 0;
 }
 
+static herr_t preempt_block_for_read(H5FD_silo_t *file)
+{
+    int blidx = find_block_to_preempt_for_read(file);
+    silo_vfd_block_t *b;
+
+    if (blidx < 0)
+        return -1;
+
+    b = &(file->block_list[blidx]);
+    if (b->prefetched)
+        file->stats.num_read_ahead_unused++;
+    else if (block_is_md(b))
+        file->stats.num_md_evictions++;
+    else
+        file->stats.num_raw_evictions++;
+
+    return free_block_by_index(file, blidx);
+}
+
+/*
+ * Bring block id, which missed, into memory for a read-only file. Once the
+ * misses have been walking forward through the file for a while, the blocks
+ * following id that are not in memory are read along with it in a single
+ * request and the OS is advised of the window after those so it can fetch
+ * it while we work on this one.
+ */
+static int load_block_for_read(H5FD_silo_t *file, hsize_t id)
+{
+    static const char  *func = "load_block_for_read";
+    hsize_t nblocks = 1, i;
+    herr_t ret_value = 0;
+    char *tmpbuf;
+    int blidx;
+
+    if (id == file->seq_next_id)
+        file->seq_run++;
+    else
+        file->seq_run = 0;
+
+    if (file->read_ahead > 0 && file->seq_run >= SILO_SEQ_THRESHOLD)
+    {
+        hsize_t max_ahead = file->read_ahead;
+        if (max_ahead > (hsize_t) file->max_blocks / 2)
+            max_ahead = file->max_blocks / 2;
+        while (nblocks <= max_ahead &&
+               (id + nblocks) * file->block_size < file->file_eof &&
+               find_block_by_id(file, id + nblocks, EXACT) < 0)
+            nblocks++;
+    }
+    file->seq_next_id = id + nblocks;
+
+    /* make room for all of them before any are inserted */
+    while (file->num_blocks > file->max_blocks - (int) nblocks)
+    {
+        if (preempt_block_for_read(file) < 0)
+            break;
+    }
+
+    if (nblocks == 1)
+        return alloc_block_by_id(file, id);
+
+    if (NULL == (tmpbuf = (char *) malloc(nblocks * file->block_size)))
+        return alloc_block_by_id(file, id);
+
+    H5Eclear2(H5E_DEFAULT);
+
+    if (file_read(file, id * file->block_size, nblocks * file->block_size, tmpbuf) < 0)
+    {
+        free(tmpbuf);
+        H5E_PUSH_HELPER (func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "read ahead failed", -1, -1)
+    }
+
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    if ((id + nblocks) * file->block_size < file->file_eof)
+        (void) posix_fadvise(file->fd, (file_offset_t) ((id + nblocks) * file->block_size),
+                   (file_offset_t) (nblocks * file->block_size), POSIX_FADV_WILLNEED);
+#endif
+
+    for (i = 0; i < nblocks; i++)
+    {
+        int tmpblidx = new_block_by_id(file, id + i);
+        silo_vfd_block_t *b = &(file->block_list[tmpblidx]);
+
+        memcpy(b->buf, tmpbuf + i * file->block_size, file->block_size);
+        b->prefetched = i > 0;
+        file->stats.total_block_reads++;
+
+        if (file->log_stats)
+        {
+            if (get_block_bitmap_by_id(&(file->was_in_mem_map), id + i))
+                update_hotblock_stats(file, id + i, OP_READ, 0);
+            set_block_bitmap_by_id(&(file->was_in_mem_map), id + i);
+            if (id + i > file->stats.max_block_id) file->stats.max_block_id = id + i;
+        }
+    }
+    free(tmpbuf);
+
+    file->stats.num_blocks_read_ahead += nblocks - 1;
+
+    blidx = find_block_by_id(file, id, EXACT);
+    return blidx;
+}
+
 /*-------------------------------------------------------------------------
  * Function:	H5FD_silo_init
  *
@@ -1213,6 +1417,7 @@ H5Pset_fapl_silo(hid_t fapl_id)
     int default_block_count = H5FD_SILO_DEFAULT_BLOCK_COUNT;
     int default_log_stats = H5FD_SILO_DEFAULT_LOG_STATS;
     int default_use_direct = H5FD_SILO_DEFAULT_USE_DIRECT;
+    int default_read_ahead = H5FD_SILO_DEFAULT_READ_AHEAD;
 
     H5Eclear2(H5E_DEFAULT);
 
@@ -1227,6 +1432,8 @@ H5Pset_fapl_silo(hid_t fapl_id)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTINSERT, "can't insert " SILO_LOGSTS_PROPNAME, -1, -1)
     if (H5Pinsert(fapl_id, SILO_USEDIR_PROPNAME, sizeof(int), &default_use_direct, 0, 0, 0, 0, 0) < 0)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTINSERT, "can't insert " SILO_USEDIR_PROPNAME, -1, -1)
+    if (H5Pinsert(fapl_id, SILO_RDAHEAD_PROPNAME, sizeof(int), &default_read_ahead, 0, 0, 0, 0, 0) < 0)
+        H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTINSERT, "can't insert " SILO_RDAHEAD_PROPNAME, -1, -1)
 
     if (H5Pset(fapl_id, SILO_BLKSZ_PROPNAME, &default_block_size) < 0)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTSET, "can't set " SILO_BLKSZ_PROPNAME, -1, -1)
@@ -1236,6 +1443,8 @@ H5Pset_fapl_silo(hid_t fapl_id)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTSET, "can't set " SILO_LOGSTS_PROPNAME, -1, -1)
     if (H5Pset(fapl_id, SILO_USEDIR_PROPNAME, &default_use_direct) < 0)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTSET, "can't set " SILO_USEDIR_PROPNAME, -1, -1)
+    if (H5Pset(fapl_id, SILO_RDAHEAD_PROPNAME, &default_read_ahead) < 0)
+        H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTSET, "can't set " SILO_RDAHEAD_PROPNAME, -1, -1)
 
     return H5Pset_driver(fapl_id, H5FD_SILO, NULL);
 }
@@ -1293,6 +1502,23 @@ H5Pset_silo_use_direct(hid_t fapl_id, int used)
     return ret_value;
 }
 
+herr_t
+H5Pset_silo_read_ahead(hid_t fapl_id, int nblocks)
+{
+    static const char *func="H5Pset_silo_read_ahead";
+    herr_t ret_value = 0;
+
+    /* Clear the error stack */
+    H5Eclear2(H5E_DEFAULT);
+
+    if(0 == H5Pisa_class(fapl_id, H5P_FILE_ACCESS))
+        H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_BADTYPE, "not a file access property list", -1, -1)
+    if (H5Pset(fapl_id, SILO_RDAHEAD_PROPNAME, &nblocks) < 0)
+        H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTSET, "can't set " SILO_RDAHEAD_PROPNAME, -1, -1)
+
+    return ret_value;
+}
+
 /*-------------------------------------------------------------------------
  * Function:	H5FD_silo_sb_size
  *
@@ -1355,7 +1581,7 @@ H5FD_silo_sb_encode(H5FD_t *_file, char *name/*out*/,
     assert(sizeof(hsize_t)<=8);
     memcpy(p, &file->block_size, sizeof(hsize_t));
     if (H5Tconvert(H5T_NATIVE_HSIZE, H5T_STD_U64LE, 1, buf+8, NULL, H5P_DEFAULT)<0)
-        H5Epush_ret(func, H5E_ERR_CLS, H5E_DATATYPE, H5E_CANTCONVERT, "can't convert superblock info", -1)
+        H5Epush_ret(func, H5E_ERR_CLS, H5E_DATATYPE, H5E_CANTCONVERT, "can't convert superblock info", -1);
 
     return 0;
 }
@@ -1383,14 +1609,14 @@ H5FD_silo_sb_decode(H5FD_t *_file, const char *name, const unsigned char *buf)
 
     /* Make sure the name/version number is correct */
     if (strcmp(name, "LLNLsilo"))
-        H5Epush_ret(func, H5E_ERR_CLS, H5E_FILE, H5E_BADVALUE, "invalid silo superblock", -1)
+        H5Epush_ret(func, H5E_ERR_CLS, H5E_FILE, H5E_BADVALUE, "invalid silo superblock", -1);
 
     buf += 8;
     /* Decode block size */
     assert(sizeof(hsize_t)<=8);
     memcpy(x, buf, 8);
     if (H5Tconvert(H5T_STD_U64LE, H5T_NATIVE_HSIZE, 1, x, NULL, H5P_DEFAULT)<0)
-        H5Epush_ret(func, H5E_ERR_CLS, H5E_DATATYPE, H5E_CANTCONVERT, "can't convert superblock info", -1)
+        H5Epush_ret(func, H5E_ERR_CLS, H5E_DATATYPE, H5E_CANTCONVERT, "can't convert superblock info", -1);
     ap = (hsize_t*)x;
     /*file->block_size = *ap; ignore stored value for now */
 
@@ -1444,6 +1670,7 @@ H5FD_silo_open( const char *name, unsigned flags, hid_t fapl_id,
     hsize_t silo_block_size = H5FD_SILO_DEFAULT_BLOCK_SIZE;
     int     silo_log_stats = H5FD_SILO_DEFAULT_LOG_STATS;
     int     silo_use_direct = H5FD_SILO_DEFAULT_USE_DIRECT;
+    int     silo_read_ahead = H5FD_SILO_DEFAULT_READ_AHEAD;
     H5FD_t *ret_value = 0;
     mode_t mode;
 
@@ -1474,6 +1701,8 @@ H5FD_silo_open( const char *name, unsigned flags, hid_t fapl_id,
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTGET, "can't get " SILO_LOGSTS_PROPNAME, 0, -1)
     if (H5Pget(fapl_id, SILO_USEDIR_PROPNAME, &silo_use_direct) < 0)
         H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTGET, "can't get " SILO_USEDIR_PROPNAME, 0, -1)
+    if (H5Pget(fapl_id, SILO_RDAHEAD_PROPNAME, &silo_read_ahead) < 0)
+        H5E_PUSH_HELPER(func, H5E_ERR_CLS, H5E_PLIST, H5E_CANTGET, "can't get " SILO_RDAHEAD_PROPNAME, 0, -1)
 
     /* Build the open flags */
     o_flags = (H5F_ACC_RDWR & flags) ? O_RDWR : O_RDONLY;
@@ -1524,6 +1753,8 @@ H5FD_silo_open( const char *name, unsigned flags, hid_t fapl_id,
     file->block_size = silo_block_size;
     file->max_blocks = silo_block_count;
     file->log_stats = silo_log_stats;
+    file->read_ahead = write_access ? 0 : silo_read_ahead;
+    file->seq_next_id = (hsize_t) -1;
     if (silo_log_stats)
     {
         const char *ext = "-h5-vfd-log";
@@ -1576,6 +1807,8 @@ H5FD_silo_open( const char *name, unsigned flags, hid_t fapl_id,
  * Modifications:
  *      Ported to VFL/H5FD layer - QAK, 10/18/99
  *
+ *      Free the blocks of files opened read-only too. Log the block
+ *      cache statistics.
  *-------------------------------------------------------------------------
  */
 static herr_t
@@ -1612,6 +1845,15 @@ H5FD_silo_close(H5FD_t *_file)
         }
         free(sorted_pairs);
     }
+    else
+    {
+        int i;
+        for (i = 0; i < file->num_blocks; i++)
+        {
+            if (file->block_list[i].buf)
+                free(file->block_list[i].buf);
+        }
+    }
 
     errno = 0;
     if (close(file->fd) < 0)
@@ -1620,6 +1862,7 @@ H5FD_silo_close(H5FD_t *_file)
     if (file->log_stats)
     {
         int i, first;
+        hsize_t hits;
         hsize_t cum_raw_count, cum_raw_bytes, cum_md_count, cum_md_bytes;
         hsize_t tot_raw_count, tot_raw_bytes, tot_md_count, tot_md_bytes;
         FILE* logf = fopen(file->log_name, "w");
@@ -1653,6 +1896,21 @@ H5FD_silo_close(H5FD_t *_file)
         fprintf(logf, "number of times a block was read = %llu\n", file->stats.total_block_reads);
         fprintf(logf, "number of times a block was read more than once = %llu\n", file->stats.total_block_re_reads);
         fprintf(logf, "\n");
+        hits = file->stats.num_block_hits + file->stats.num_block_misses;
+        if (hits < 1) hits = 1;
+        fprintf(logf, "read ahead = %d blocks\n", file->read_ahead);
+        fprintf(logf, "number of block cache hits = %llu (%3d%%)\n", file->stats.num_block_hits,
+            (int) (100.0 * file->stats.num_block_hits / hits));
+        fprintf(logf, "number of block cache misses = %llu (%3d%%)\n", file->stats.num_block_misses,
+            (int) (100.0 * file->stats.num_block_misses / hits));
+        fprintf(logf, "number of blocks read ahead = %llu\n", file->stats.num_blocks_read_ahead);
+        fprintf(logf, "number of read ahead blocks used = %llu\n", file->stats.num_read_ahead_hits);
+        fprintf(logf, "number of read ahead blocks evicted unused = %llu\n", file->stats.num_read_ahead_unused);
+        fprintf(logf, "number of raw blocks evicted = %llu\n", file->stats.num_raw_evictions);
+        fprintf(logf, "number of md blocks evicted = %llu\n", file->stats.num_md_evictions);
+        fprintf(logf, "number of uncached raw reads = %llu (%llu blocks)\n", file->stats.num_bypass_reads,
+            file->stats.num_bypass_blocks);
+        fprintf(logf, "\n");
         fprintf(logf, "number of hot blocks %d\n", file->stats.num_hot_blocks);
         fprintf(logf, "hot blocks...\n");
         for (i = 0; i < file->stats.num_hot_blocks; i++)
@@ -2038,6 +2296,9 @@ H5FD_silo_get_handle(H5FD_t *_file, hid_t fapl, void** file_handle)
  *
  *      Ported to VFL/H5FD layer - QAK, 10/18/99
  *
+ *      For files opened read-only, misses go through load_block_for_read
+ *      for read ahead and raw data covering whole blocks bypasses the
+ *      block cache. Block cache hits and misses are counted.
  *-------------------------------------------------------------------------
  */
 static herr_t
@@ -2087,8 +2348,15 @@ H5FD_silo_read(H5FD_t *_file, H5FD_mem_t type, hid_t dxpl_id, haddr_t addr, size
         else
             blidx++;
 
-        if (blidx < 0)
+        if (blidx >= 0)
+        {
+            file->stats.num_block_hits++;
+            db_StatCache(1);
+        }
+        else if (file->write_access)
         {
+            file->stats.num_block_misses++;
+            db_StatCache(0);
             if (file->num_blocks == file->max_blocks)
             {
                 int tmpblidx = find_block_to_preempt(file);
@@ -2096,6 +2364,38 @@ H5FD_silo_read(H5FD_t *_file, H5FD_mem_t type, hid_t dxpl_id, haddr_t addr, size
             }
             blidx = alloc_block_by_id(file, id);
         }
+        else
+        {
+            hsize_t id1 = id;
+
+            /* Raw data filling whole blocks that are not in memory goes
+               straight to the caller's buffer, in one request, so that large
+               reads neither churn the cache nor push meta data out of it. */
+            while (type == H5FD_MEM_DRAW && id1 <= rb.id1 &&
+                   (id1 != rb.id0 || rb.off0 == 0) &&
+                   (id1 != rb.id1 || (hsize_t) rb.off1 == file->block_size-1) &&
+                   (id1 == id || find_block_by_id(file, id1, EXACT) < 0))
+                id1++;
+
+            if (id1 > id)
+            {
+                nbytes = (id1 - id) * file->block_size;
+                if (file_read(file, id * file->block_size, nbytes, (char*)buf+bufoff) < 0)
+                    H5E_PUSH_HELPER (func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "file_read failed", -1, -1)
+                file->stats.num_bypass_reads++;
+                file->stats.num_bypass_blocks += id1 - id;
+                file->seq_next_id = id1;
+                bufoff += nbytes;
+                id = id1 - 1;
+                blidx = -1;
+                continue;
+            }
+
+            file->stats.num_block_misses++;
+            db_StatCache(0);
+            if ((blidx = load_block_for_read(file, id)) < 0)
+                H5E_PUSH_HELPER (func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "load_block_for_read failed", -1, -1)
+        }
 
         /* put the data in the block */
 	if (id == rb.id0 && id == rb.id1)
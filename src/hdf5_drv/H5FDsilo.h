@@ -66,6 +66,8 @@ be used for advertising or product endorsement purposes.
  *
  *   Mark C. Miller, Wed Jul 21 22:02:53 PDT 2010
  *   Set larger defaults for BG/P and BG/L systems.
+ *
+ *   Added read ahead block count for files opened read-only.
  */
 #ifndef H5FDsilo_H
 #define H5FDsilo_H
@@ -94,6 +96,7 @@ be used for advertising or product endorsement purposes.
 #endif
 #define H5FD_SILO_DEFAULT_LOG_STATS 0
 #define H5FD_SILO_DEFAULT_USE_DIRECT 0
+#define H5FD_SILO_DEFAULT_READ_AHEAD 4
 
 #ifdef __cplusplus
 extern "C" {
@@ -105,6 +108,7 @@ herr_t H5Pset_fapl_silo(hid_t fapl_id);
 herr_t H5Pset_silo_block_size_and_count(hid_t fapl_id, hsize_t block_size, int max_blocks_in_mem);
 herr_t H5Pset_silo_log_stats(hid_t fapl_id, int log);
 herr_t H5Pset_silo_use_direct(hid_t fapl_id, int used);
+herr_t H5Pset_silo_read_ahead(hid_t fapl_id, int nblocks);
 
 #ifdef __cplusplus
 }
@@ -64,6 +64,7 @@ be used for advertising or product endorsement purposes.
 
 #include <errno.h>
 #include <assert.h>
+#include <limits.h>
 #if HAVE_STRING_H
 #include <string.h>
 #endif
@@ -73,6 +74,10 @@ be used for advertising or product endorsement purposes.
 #include <stdio.h>
 #include "silo_hdf5_private.h"
 #include "H5FDsilo.h"
+#include <time.h>
+#if SILO_THREADSAFE
+#include <pthread.h>
+#endif
 #if defined(HAVE_HDF5_H) && defined(HAVE_LIBHDF5) /* [ */
 
 /* HZIP node order permuation vector construction.
@@ -208,8 +213,6 @@ static const unsigned SILO_HZIP_PERMUTATION[4] = {0,0,((unsigned) (0x00002130)),
 #   define UNWIND()     ; 
 #endif
 
-#define COMPRESSION_ERRMODE_FALLBACK 0
-#define COMPRESSION_ERRMODE_FAIL     1
 #define ALLOW_MESH_COMPRESSION 0x00000001
 
 #define FALSE           0
@@ -243,6 +246,7 @@ PRIVATE int hdf2silo_type(hid_t type);
 PRIVATE int db_hdf5_WriteCKZ(DBfile *_dbfile, char const *vname, void const *var,
               int const *dims, int ndims, int datatype, int nofilters);
 PRIVATE int db_hdf5_getslink(hid_t cwg, char const *in_candidate_link, char *out_target);
+PRIVATE int db_hdf5_async_finish(DBfile_hdf5 *dbfile);
 
 /* callbacks prototypes for file image ops */
 #if HDF5_VERSION_GE(1,8,9)
@@ -1048,12 +1052,19 @@ db_hdf5_fpzip_set_local(hid_t dcpl_id, hid_t type_id, hid_t space_id)
     int i;
     hsize_t dims[10] = {1,1,1,1,1,1,1,1,1,1}, maxdims[10];
     db_hdf5_fpzip_params.dp = H5Tget_size(type_id) > sizeof(float) ? 1 : 0;
-    db_hdf5_fpzip_params.totsize1d = (int) H5Sget_simple_extent_npoints(space_id);
     db_hdf5_fpzip_params.isfp = H5Tget_class(type_id) == H5T_FLOAT;
     db_hdf5_fpzip_params.ndims = H5Sget_simple_extent_ndims(space_id);
-    H5Sget_simple_extent_dims(space_id, dims, maxdims);
+
+    /* The filter sees one chunk at a time, which is less than the whole
+       dataset when it is tiled */
+    if (H5Pget_chunk(dcpl_id, 10, dims) != db_hdf5_fpzip_params.ndims)
+        H5Sget_simple_extent_dims(space_id, dims, maxdims);
+    db_hdf5_fpzip_params.totsize1d = 1;
     for (i = 0; i < db_hdf5_fpzip_params.ndims; i++)
+    {
         db_hdf5_fpzip_params.dims[i] = (int) dims[i];
+        db_hdf5_fpzip_params.totsize1d *= (int) dims[i];
+    }
     return 1;
 }
 
@@ -1151,6 +1162,19 @@ db_hdf5_fpzip_filter_op(unsigned int flags, size_t cd_nelmts,
         return outbytes;
     }
 }
+
+/* Times the fpzip filter as compression work in the file's statistics */
+static size_t
+db_hdf5_fpzip_filter_timed(unsigned int flags, size_t cd_nelmts,
+    const unsigned int cd_values[], size_t nbytes,
+    size_t *buf_size, void **buf)
+{
+    double t0 = db_WallTime();
+    size_t retval = db_hdf5_fpzip_filter_op(flags, cd_nelmts, cd_values, nbytes,
+                                          buf_size, buf);
+    db_StatCompress(db_WallTime() - t0);
+    return retval;
+}
 static H5Z_class_t db_hdf5_fpzip_class;
 #endif /* HAVE_FPZIP } */
 
@@ -1700,6 +1724,19 @@ db_hdf5_hzip_filter_op(unsigned int flags, size_t cd_nelmts,
         }
     }
 }
+
+/* Times the hzip filter as compression work in the file's statistics */
+static size_t
+db_hdf5_hzip_filter_timed(unsigned int flags, size_t cd_nelmts,
+    const unsigned int cd_values[], size_t nbytes,
+    size_t *buf_size, void **buf)
+{
+    double t0 = db_WallTime();
+    size_t retval = db_hdf5_hzip_filter_op(flags, cd_nelmts, cd_values, nbytes,
+                                          buf_size, buf);
+    db_StatCompress(db_WallTime() - t0);
+    return retval;
+}
 static H5Z_class_t db_hdf5_hzip_class;
 #endif /* !HAVE_HZIP } */
 
@@ -2088,7 +2125,7 @@ db_hdf5_init(void)
 #endif
 
     /* Turn off error messages from the hdf5 library */
-    if (SILO_Globals._db_err_level_drvr == DB_ALL)
+    if (DB_ERR_LEVEL_DRVR == DB_ALL)
         H5Eset_auto((H5E_auto1_t) H5Eprint1, stderr);
     else
         H5Eset_auto(NULL, NULL);
@@ -2128,7 +2165,7 @@ db_hdf5_init(void)
     db_hdf5_fpzip_class.name = "Lindstrom-fpzip";
     db_hdf5_fpzip_class.can_apply = db_hdf5_fpzip_can_apply;
     db_hdf5_fpzip_class.set_local = db_hdf5_fpzip_set_local;
-    db_hdf5_fpzip_class.filter = db_hdf5_fpzip_filter_op;
+    db_hdf5_fpzip_class.filter = db_hdf5_fpzip_filter_timed;
     H5Zregister(&db_hdf5_fpzip_class);
 #endif /* HAVE_FPZIP } */
 
@@ -2160,7 +2197,7 @@ db_hdf5_init(void)
     db_hdf5_hzip_class.name = "Lindstrom-hzip";
     db_hdf5_hzip_class.can_apply = db_hdf5_hzip_can_apply;
     db_hdf5_hzip_class.set_local = db_hdf5_hzip_set_local;
-    db_hdf5_hzip_class.filter = db_hdf5_hzip_filter_op;
+    db_hdf5_hzip_class.filter = db_hdf5_hzip_filter_timed;
 
     H5Zregister(&db_hdf5_hzip_class);
     /* Initialize support data structures for hzip */
@@ -2909,6 +2946,7 @@ db_hdf5_InitCallbacks(DBfile_hdf5 *dbfile, int target)
     dbfile->pub.free_z = db_hdf5_FreeCompressionResources;
 
     dbfile->pub.sort_obo = db_hdf5_SortObjectsByOffset;
+    dbfile->pub.prefetch = db_hdf5_Prefetch;
 }
 
 /*-------------------------------------------------------------------------
@@ -3280,6 +3318,128 @@ hdf2hdf_type(hid_t ftype)
     return mtype;
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_xfer_bytes
+ *
+ * Purpose:     Number of bytes of memory type MTYPE moved by a dataset
+ *              transfer through memory space MSPACE (H5S_ALL meaning all
+ *              of DSET).
+ *-------------------------------------------------------------------------
+ */
+PRIVATE long long
+db_hdf5_xfer_bytes(hid_t dset, hid_t mtype, hid_t mspace)
+{
+    hid_t space = mspace == H5S_ALL ? H5Dget_space(dset) : mspace;
+    hssize_t npoints = space < 0 ? 0 : H5Sget_select_npoints(space);
+
+    if (mspace == H5S_ALL && space >= 0)
+        H5Sclose(space);
+    return npoints < 0 ? 0 : (long long) npoints * (long long) H5Tget_size(mtype);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_Dread, db_hdf5_Dwrite
+ *
+ * Purpose:     H5Dread and H5Dwrite, counting the bytes handed to HDF5 in
+ *              the current file's statistics.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE herr_t
+db_hdf5_Dread(hid_t dset, hid_t mtype, hid_t mspace, hid_t fspace,
+              hid_t props, void *buf)
+{
+    herr_t status = H5Dread(dset, mtype, mspace, fspace, props, buf);
+    if (status >= 0 && DB_STATS_ON)
+        db_StatRead(DB_STATS_META, db_hdf5_xfer_bytes(dset, mtype, mspace));
+    return status;
+}
+
+PRIVATE herr_t
+db_hdf5_Dwrite(hid_t dset, hid_t mtype, hid_t mspace, hid_t fspace,
+               hid_t props, void const *buf)
+{
+    herr_t status = H5Dwrite(dset, mtype, mspace, fspace, props, buf);
+    if (status >= 0 && DB_STATS_ON)
+        db_StatWrite(DB_STATS_META, db_hdf5_xfer_bytes(dset, mtype, mspace));
+    return status;
+}
+
+/*-------------------------------------------------------------------------
+ * Raw data read ahead by db_hdf5_Prefetch for DBGetObjects: ranges of the
+ * file, in ascending order, each read with one system call.
+ *-------------------------------------------------------------------------
+ */
+typedef struct db_hdf5_range_t {
+    haddr_t        addr;        /*file offset of the first byte          */
+    size_t         size;        /*number of bytes                        */
+    unsigned char  *buf;        /*the bytes, or NULL while gathering     */
+} db_hdf5_range_t;
+
+typedef struct db_hdf5_prefetch_t {
+    int            n;           /*number of ranges                       */
+    db_hdf5_range_t *ranges;    /*the ranges, by ascending address       */
+} db_hdf5_prefetch_t;
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_prefetch_read
+ *
+ * Purpose:     Copy all of dataset D into BUF from the data read ahead by
+ *              db_hdf5_Prefetch, when the memory type is the file type
+ *              and the dataset lies within one range.
+ *
+ * Return:      1 if BUF was filled, else 0 and the caller reads D itself.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_prefetch_read(DBfile_hdf5 *dbfile, hid_t d, hid_t ftype, hid_t mtype,
+                      void *buf, size_t nbytes)
+{
+    db_hdf5_prefetch_t *pf = dbfile->prefetch;
+    db_hdf5_range_t *r;
+    haddr_t addr;
+    int lo, hi, mid;
+
+    if (!pf || pf->n == 0 || nbytes == 0 || H5Tequal(ftype, mtype) <= 0)
+        return 0;
+    H5E_BEGIN_TRY {
+        addr = H5Dget_offset(d);
+    } H5E_END_TRY;
+    if (addr == HADDR_UNDEF)
+        return 0;
+
+    /* Find the last range starting at or before addr */
+    for (lo = 0, hi = pf->n - 1; lo < hi; )
+    {
+        mid = (lo + hi + 1) / 2;
+        if (pf->ranges[mid].addr <= addr) lo = mid;
+        else                              hi = mid - 1;
+    }
+    r = &pf->ranges[lo];
+    if (addr < r->addr || addr - r->addr + nbytes > r->size)
+        return 0;
+
+    memcpy(buf, r->buf + (addr - r->addr), nbytes);
+    if (DB_STATS_ON)
+        db_StatCache(1);
+    return 1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_hdrrd_attr
+ *
+ * Purpose:     H5Aread of an object header attribute, counted as a
+ *              metadata read in the current file's statistics.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE herr_t
+db_hdf5_hdrrd_attr(hid_t attr, hid_t mtype, void *buf)
+{
+    herr_t status = H5Aread(attr, mtype, buf);
+    if (status >= 0 && DB_STATS_ON)
+        db_StatRead(1, (long long) H5Aget_storage_size(attr));
+    return status;
+}
+
 /*-------------------------------------------------------------------------
  * Function:    db_hdf5_set_compression
  *
@@ -3299,363 +3459,137 @@ hdf2hdf_type(hid_t ftype)
  *   Added globals for minimum compression ratio and error mode.
  *   Added support for HZIP and FPZIP. Added flags to control whether
  *   HZIP compression filter gets added or not.
+ *
+ *   Apply a rule of the compiled compression string instead of searching
+ *   the string. The caller empties the filter pipeline first, so the
+ *   settings of one dataset no longer stick to the next.
  *-------------------------------------------------------------------------
  */
 PRIVATE int
-db_hdf5_set_compression(DBfile *dbfile, int flags)
+db_hdf5_set_compression(DBfile *dbfile, db_comprule_t const *rule)
 {
     static char *me = "db_hdf5_set_compression";
-    char *ptr;
-    char chararray[32];
-    char *check;
-    int level, block, nfilters;
-    int nbits, prec;
-    int have_gzip, have_szip, have_fpzip, have_hzip, have_zfp, i;
-    H5Z_filter_t filtn;
-    unsigned int filter_config_flags, opt_flag;
-
-    /* Check what filters already exist */
-    have_gzip = FALSE;
-    have_szip = FALSE;
-    have_fpzip = FALSE;
-    have_hzip = FALSE;
-    have_zfp = FALSE;
-    if ((nfilters = H5Pget_nfilters(P_ckcrprops))<0)
-    {
-       db_perror("H5Pget_nfilters", E_CALLFAIL, me);
-       return (-1);
-    }
-    for (i=0; i<nfilters; i++) {           
-#if defined H5_USE_16_API || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR < 8)
-            filtn = H5Pget_filter(P_ckcrprops,(unsigned)i,0,0,0,0,0);
-#else
-            filtn = H5Pget_filter(P_ckcrprops,(unsigned)i,0,0,0,0,0,NULL);
-#endif
-        if (H5Z_FILTER_DEFLATE==filtn)     
-            have_gzip = TRUE;
-#ifdef H5_HAVE_FILTER_SZIP
-        if (H5Z_FILTER_SZIP==filtn)     
-            have_szip = TRUE;
-#endif
-        if (DB_HDF5_FPZIP_ID==filtn)
-            have_fpzip = TRUE;
-        if (DB_HDF5_HZIP_ID==filtn)
-            have_hzip = TRUE;
-        if (H5Z_FILTER_ZFP==filtn)
-            have_zfp = TRUE;
-    }
-#warning WHAT ABOUT NULL RETURN FROM DBGETCOMPRESSION
-/* Handle some global compression parameters */
-    if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "ERRMODE=")) != (char *)NULL) 
-    {
-        (void)strncpy(chararray, ptr+8, 4); 
-        chararray[4] = '\0';
-        if (strcmp(chararray, "FALL") == 0)
-            SILO_Globals.compressionErrmode = COMPRESSION_ERRMODE_FALLBACK;
-        else if (strcmp(chararray, "FAIL") == 0)
-            SILO_Globals.compressionErrmode = COMPRESSION_ERRMODE_FAIL;
-        else
-        {
-            db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-            return (-1);
-        }
-    }
-    if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "MINRATIO=")) != (char *)NULL) 
-    {
-        float mcr;
-        (void)strncpy(chararray, ptr+9, 5); 
-        mcr = (float) strtod(chararray, &check);
-        if (mcr > 1.0)
-            SILO_Globals.compressionMinratio = mcr;
-        else
-        {
-            db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-            return (-1);
-        }
-    }
-#warning FIX MISSING .compressionMinsize member
-#if 0
-    if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "MINSIZE=")) != (char *)NULL) 
-    {
-        unsigned int minsize;
-        strncpy(chararray, ptr+8, 8); 
-        minsize = strtol(chararray, &check, 10);
-        if (minsize > 0)
-            SILO_Globals.compressionMinsize = minsize;
-        else
-        {
-            db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-            return -1;
-        }
-    }
-#endif
+    unsigned int opt_flag;
 
-#warning QUERY FILE LEVEL COMPRESSION PARAMS HERE
-    opt_flag = SILO_Globals.compressionErrmode == COMPRESSION_ERRMODE_FALLBACK ?
+    SILO_Globals.compressionErrmode = rule->errmode;
+    SILO_Globals.compressionMinratio = rule->minratio;
+    opt_flag = rule->errmode == COMPRESSION_ERRMODE_FALLBACK ?
                    H5Z_FLAG_OPTIONAL : H5Z_FLAG_MANDATORY;
 
     /* Select the compression algorthm */
-    if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "METHOD=GZIP")) != (char *)NULL) 
+    if (rule->method == DB_COMPMETHOD_GZIP)
     {
-       if (have_gzip == FALSE)
+       if (H5Pset_shuffle(P_ckcrprops)<0 ||
+           H5Pset_deflate(P_ckcrprops, rule->level)<0)
        {
-          if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "LEVEL=")) != (char *)NULL)
-          {
-             (void)strncpy(chararray, ptr+6, 1); 
-             level = (int) strtol(chararray, &check, 10);
-             if ((chararray != check) && (level >= 0) && (level <=9))
-             {
-                if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                    H5Pset_deflate(P_ckcrprops, level)<0)
-                {
-                   db_perror("H5Pset_deflate", E_CALLFAIL, me);
-                   return (-1);
-                }
-             }
-             else
-             {
-                db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-                return (-1);
-             }
-          }
-          else
-          {
-             if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                 H5Pset_deflate(P_ckcrprops, 1)<0)
-             {
-                db_perror("H5Pset_deflate", E_CALLFAIL, me);
-                return (-1);
-             }
-          }
-       }  /* if (have_gzip == FALSE) */
+          db_perror("H5Pset_deflate", E_CALLFAIL, me);
+          return (-1);
+       }
     }
 #ifdef H5_HAVE_FILTER_SZIP
-    else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile),
-       "METHOD=SZIP"))!=(char *)NULL)
+    else if (rule->method == DB_COMPMETHOD_SZIP)
     {
-       if (have_szip == FALSE)
+       unsigned int filter_config_flags;
+
+       if (H5Zget_filter_info(H5Z_FILTER_SZIP, &filter_config_flags)<0)
+       {
+          db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
+          return (-1);
+       }
+       if ((filter_config_flags &
+       (H5Z_FILTER_CONFIG_ENCODE_ENABLED|H5Z_FILTER_CONFIG_DECODE_ENABLED))==
+       (H5Z_FILTER_CONFIG_ENCODE_ENABLED|H5Z_FILTER_CONFIG_DECODE_ENABLED))
        {
-          filtn = H5Z_FILTER_SZIP;
-          if (H5Zget_filter_info(filtn, &filter_config_flags)<0)
+          if (H5Pset_shuffle(P_ckcrprops)<0 ||
+              H5Pset_szip(P_ckcrprops, rule->szipec ? H5_SZIP_EC_OPTION_MASK :
+                          H5_SZIP_NN_OPTION_MASK, rule->block)<0)
           {
-             db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
+             db_perror("H5Pset_szip", E_CALLFAIL, me);
              return (-1);
           }
-          if ((filter_config_flags &
-          (H5Z_FILTER_CONFIG_ENCODE_ENABLED|H5Z_FILTER_CONFIG_DECODE_ENABLED))==
-          (H5Z_FILTER_CONFIG_ENCODE_ENABLED|H5Z_FILTER_CONFIG_DECODE_ENABLED))
-          {
-             if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-                "BLOCK=")) != (char *)NULL)
-             {
-                (void)strncpy(chararray, ptr+6, 2); 
-                block = (int) strtol(chararray, &check, 10);
-                if ((chararray != check) && (block >= 0) && (block <=32))
-                { 
-                   if (strstr(DBGetCompressionFile(dbfile), 
-                      "MASK=EC") != NULL)
-                   {
-                      if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                          H5Pset_szip(P_ckcrprops, H5_SZIP_EC_OPTION_MASK,block)<0)
-                      {
-                         db_perror("H5Pset_szip", E_CALLFAIL, me);
-                         return (-1);
-                      }
-                   }
-                   else if(strstr(DBGetCompressionFile(dbfile),
-                      "MASK=NN")!=NULL)
-                   {
-                      if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                          H5Pset_szip(P_ckcrprops, H5_SZIP_NN_OPTION_MASK,block)<0)
-                      {
-                         db_perror("H5Pset_szip", E_CALLFAIL, me);
-                         return (-1);
-                      }
-                   }
-                   else
-                   {
-                      if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                          H5Pset_szip(P_ckcrprops, H5_SZIP_NN_OPTION_MASK, block)<0)
-                      {
-                         db_perror("H5Pset_szip", E_CALLFAIL, me);
-                         return (-1);
-                      }
-                   }
-                }
-                else
-                {
-                   db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-                   return (-1);
-                }
-             }
-             else
-             {
-                if (H5Pset_shuffle(P_ckcrprops)<0 ||
-                    H5Pset_szip(P_ckcrprops, H5_SZIP_NN_OPTION_MASK, 4)<0)
-                {
-                   db_perror("H5Pset_szip", E_CALLFAIL, me);
-                   return (-1);
-                }
-             }
-          }  /* if ((filter_config_flags & */
-       }  /* if (have_szip == FALSE) */
+       }
     }
 #endif
 #ifdef HAVE_HZIP
-    else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "METHOD=HZIP")) != (char *)NULL) 
+    else if (rule->method == DB_COMPMETHOD_HZIP)
     {
-       if (have_hzip == FALSE && (flags & ALLOW_MESH_COMPRESSION))
+       if (rule->hzcodec == 1)
        {
-           if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-              "CODEC=")) != (char *)NULL)
-           {
-              (void)strncpy(chararray, ptr+6, 4); 
-              chararray[4] = '\0';
 #ifdef HAVE_LIBZ
-              if (strcmp(chararray, "zlib") == 0)
-              {
-                  db_hdf5_hzip_params.codec = HZM_CODEC_ZLIB;
-                  db_hdf5_hzip_params.params = &hzm_codec_zlib;
-              }
-              else
+           db_hdf5_hzip_params.codec = HZM_CODEC_ZLIB;
+           db_hdf5_hzip_params.params = &hzm_codec_zlib;
+#else
+           db_perror("hzip codec not recongized", E_COMPRESSION, me);
+           return (-1);
 #endif
-              if (strcmp(chararray, "base") == 0)
-              {
-                  db_hdf5_hzip_params.codec = HZM_CODEC_BASE;
-                  db_hdf5_hzip_params.params = &hzm_codec_base;
-              }
-              else
-              {
-                  db_perror("hzip codec not recongized", E_COMPRESSION, me);
-                  return (-1);
-              }
-           }
-           if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-              "BITS=")) != (char *)NULL)
-           {
-              (void)strncpy(chararray, ptr+5, 2); 
-              nbits = (int) strtol(chararray, &check, 10);
-              if ((chararray != check) && (nbits >= 0) && (nbits <=64))
-              {
+       }
+       else if (rule->hzcodec == 0)
+       {
+           db_hdf5_hzip_params.codec = HZM_CODEC_BASE;
+           db_hdf5_hzip_params.params = &hzm_codec_base;
+       }
+       if (rule->hzbits >= 0)
+       {
 #ifdef HAVE_LIBZ
-                  if (db_hdf5_hzip_params.codec == HZM_CODEC_ZLIB)
-                      ((struct HZMCODECzlib *) db_hdf5_hzip_params.params)->bits = nbits;
-                  else
+           if (db_hdf5_hzip_params.codec == HZM_CODEC_ZLIB)
+               ((struct HZMCODECzlib *) db_hdf5_hzip_params.params)->bits = rule->hzbits;
+           else
 #endif
-                  if (db_hdf5_hzip_params.codec == HZM_CODEC_BASE)
-                      ((struct HZMCODECbase *) db_hdf5_hzip_params.params)->bits = nbits;
-              }
-              else
-              {
-                 db_perror("invalid nbits for hzip", E_COMPRESSION, me);
-                 return (-1);
-              }
-           }
+           if (db_hdf5_hzip_params.codec == HZM_CODEC_BASE)
+               ((struct HZMCODECbase *) db_hdf5_hzip_params.params)->bits = rule->hzbits;
+       }
 
-           if (H5Pset_filter(P_ckcrprops, DB_HDF5_HZIP_ID, opt_flag, 0, 0)<0)
-           {
-               db_perror("hzip filter setup", E_CALLFAIL, me);
-               return (-1);
-           }
+       if (H5Pset_filter(P_ckcrprops, DB_HDF5_HZIP_ID, opt_flag, 0, 0)<0)
+       {
+           db_perror("hzip filter setup", E_CALLFAIL, me);
+           return (-1);
        }
     }
 #endif
 #ifdef HAVE_FPZIP
-    else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "METHOD=FPZIP")) != (char *)NULL) 
+    else if (rule->method == DB_COMPMETHOD_FPZIP)
     {
-       if (have_fpzip == FALSE)
+       db_hdf5_fpzip_params.loss = rule->loss;
+       if (H5Pset_filter(P_ckcrprops, DB_HDF5_FPZIP_ID, opt_flag, 0, 0)<0)
        {
-          if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "LOSS=")) != (char *)NULL)
-          {
-             (void)strncpy(chararray, ptr+5, 2); 
-             prec = (int) strtol(chararray, &check, 10);
-             if ((chararray != check) && (prec >= 0) && (prec <=3))
-             {
-                db_hdf5_fpzip_params.loss = prec;
-             }
-             else
-             {
-                db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-                return (-1);
-             }
-          }
-
-          if (H5Pset_filter(P_ckcrprops, DB_HDF5_FPZIP_ID, opt_flag, 0, 0)<0)
-          {
-              db_perror("H5Pset_filter", E_CALLFAIL, me);
-              return (-1);
-          }
+           db_perror("H5Pset_filter", E_CALLFAIL, me);
+           return (-1);
        }
     }
 #endif
 #ifdef HAVE_ZFP
-    else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-       "METHOD=ZFP")) != (char *)NULL) 
+    else if (rule->method == DB_COMPMETHOD_ZFP)
     {
-       if (have_zfp == FALSE)
+       unsigned int cd_values[H5Z_ZFP_CD_NELMTS_MEM];
+       int cd_nelmts = H5Z_ZFP_CD_NELMTS_MEM;
+
+       switch (rule->zfpmode)
        {
-          double tmpdbl = -1;
-          uint tmpuint = 0;
-          unsigned int cd_values[H5Z_ZFP_CD_NELMTS_MEM];
-          int cd_nelmts = H5Z_ZFP_CD_NELMTS_MEM;
-          
-          if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "RATE=")) != (char *)NULL)
-          {
-             strncpy(chararray, ptr+5, 8); 
-             tmpdbl = strtod(chararray, &check);
-             if (chararray != check && errno == 0 && tmpdbl > 0)
-                 H5Pset_zfp_rate_cdata(tmpdbl, cd_nelmts, cd_values);
-          }
-          else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "PRECISION=")) != (char *)NULL)
-          {
-             strncpy(chararray, ptr+10, 2); 
-             tmpuint = (uint) strtoul(chararray, &check, 10);
-             if (chararray != check && errno == 0 && tmpuint > 0)
-                 H5Pset_zfp_precision_cdata(tmpuint, cd_nelmts, cd_values);
-          }
-          else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "ACCURACY=")) != (char *)NULL)
-          {
-             strncpy(chararray, ptr+9, 8); 
-             tmpdbl = strtod(chararray, &check);
-             if (chararray != check && errno == 0 && tmpdbl > 0)
-                 H5Pset_zfp_accuracy_cdata(tmpdbl, cd_nelmts, cd_values);
-          }
-          else if ((ptr=(char *)strstr(DBGetCompressionFile(dbfile), 
-             "EXPERT=")) != (char *)NULL)
-          {
-             int nvals, minexp; unsigned int minbits, maxbits, maxprec;
-             strncpy(chararray, ptr+7, 20); 
-             nvals = sscanf(chararray, "%u,%u,%u,%d", &minbits, &maxbits, &maxprec, &minexp);
-             if (nvals == 4 && errno == 0)
-                 H5Pset_zfp_expert_cdata(minbits, maxbits, maxprec, minexp, cd_nelmts, cd_values);
-          }
-          else if ((ptr=(char *)strstr(SILO_Globals.compressionParams, 
-             "REVERSIBLE")) != (char *)NULL)
-          {
-              H5Pset_zfp_reversible_cdata(cd_nelmts, cd_values);
-          }
-          else
-          {
-              db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
-              return -1;
-          }
+       case DB_ZFPMODE_RATE:
+           H5Pset_zfp_rate_cdata(rule->zfpparam, cd_nelmts, cd_values);
+           break;
+       case DB_ZFPMODE_PRECISION:
+           H5Pset_zfp_precision_cdata(rule->zfpprec, cd_nelmts, cd_values);
+           break;
+       case DB_ZFPMODE_ACCURACY:
+           H5Pset_zfp_accuracy_cdata(rule->zfpparam, cd_nelmts, cd_values);
+           break;
+       case DB_ZFPMODE_EXPERT:
+           H5Pset_zfp_expert_cdata(rule->zfpexpert[0], rule->zfpexpert[1],
+               rule->zfpexpert[2], rule->zfpminexp, cd_nelmts, cd_values);
+           break;
+       case DB_ZFPMODE_REVERSIBLE:
+           H5Pset_zfp_reversible_cdata(cd_nelmts, cd_values);
+           break;
+       default:
+           db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
+           return -1;
+       }
 
-          if (H5Pset_filter(P_ckcrprops, H5Z_FILTER_ZFP, opt_flag, cd_nelmts, cd_values)<0)
-          {
-              db_perror("H5Pset_filter", E_CALLFAIL, me);
-              return (-1);
-          }
+       if (H5Pset_filter(P_ckcrprops, H5Z_FILTER_ZFP, opt_flag, cd_nelmts, cd_values)<0)
+       {
+           db_perror("H5Pset_filter", E_CALLFAIL, me);
+           return (-1);
        }
     }
 #endif
@@ -3668,66 +3602,864 @@ db_hdf5_set_compression(DBfile *dbfile, int flags)
 }
 
 /*-------------------------------------------------------------------------
- * Function:    db_hdf5_set_properties
- *
- * Purpose:     Set the HDF5 properties.
- *
- * Bugs:        
- *
- * Return:      Success:        0
- *
- *              Failure:        -1
- *
- * Programmer:  Thomas R. Treadway, Tue Mar  6 14:23:50 PST 2007
- *
- * Modifications:
- *
- *
+ * Tiled datasets.
+ *
+ * A CHUNK=n entry in the compression string splits each compressed
+ * dataset into tiles of at most n values instead of a single chunk. Each
+ * tile is compressed on its own, so a partial read only decompresses the
+ * tiles it touches. When a tiled dataset is filtered with just shuffle
+ * and deflate, which Silo can reproduce with zlib, its tiles are
+ * (de)compressed on up to DB_THREADS threads while this
+ * thread moves them to and from the file with HDF5's direct chunk I/O.
+ * No HDF5 call is made off this thread.
  *-------------------------------------------------------------------------
  */
-PRIVATE int
-db_hdf5_set_properties(DBfile *dbfile, int rank, hsize_t size[])
+
+/* Tiles in flight for each thread */
+#define DB_HDF5_TILE_WINDOW 4
+
+#if SILO_THREADSAFE && defined(HAVE_LIBZ) && HDF5_VERSION_GE(1,10,3)
+#define DB_HDF5_TILE_THREADS
+#include <zlib.h>
+#endif
+
+PRIVATE void
+db_hdf5_chunk_dims(long long maxvals, int rank, hsize_t const size[],
+    hsize_t chunk[])
 {
-    static char *me = "db_hdf5_set_properties";
-    P_crprops = H5P_DEFAULT;
-    if (DBGetEnableChecksumsFile(dbfile) && 
-        !DBGetCompressionFile(dbfile))
+    int i;
+
+    /* Keep the fastest varying dimensions whole as far as possible */
+    for (i = rank-1; i >= 0; i--)
     {
-        H5Pset_chunk(P_ckcrprops, rank, size);
-        P_crprops = P_ckcrprops;
+        chunk[i] = size[i] > 0 ? size[i] : 1;
+        if (maxvals > 0)
+        {
+            if (chunk[i] > (hsize_t) maxvals)
+                chunk[i] = (hsize_t) maxvals;
+            maxvals /= (long long) chunk[i];
+            if (maxvals < 1) maxvals = 1;
+        }
     }
-    else if (DBGetEnableChecksumsFile(dbfile) && 
-        DBGetCompressionFile(dbfile))
+}
+
+#ifdef DB_HDF5_TILE_THREADS
+typedef struct db_hdf5_tiles_t {
+    hid_t           dset;
+    int             rank;
+    hsize_t         dims[H5S_MAX_RANK];   /* dataset size                 */
+    hsize_t         chunk[H5S_MAX_RANK];  /* tile size                    */
+    hsize_t         off[H5S_MAX_RANK];    /* selection offset             */
+    hsize_t         len[H5S_MAX_RANK];    /* selection (and memory) size  */
+    hsize_t         first[H5S_MAX_RANK];  /* first tile in the selection  */
+    hsize_t         ntiles[H5S_MAX_RANK]; /* tiles across the selection   */
+    size_t          esize;                /* bytes per value              */
+    size_t          tile_bytes;
+    int             shuffle;              /* pipeline index or -1         */
+    int             deflate;              /* pipeline index               */
+    int             level;                /* deflate level                */
+    unsigned char  *mem;
+    db_jobs_t      *jobs;                 /* the tile threads             */
+
+    pthread_mutex_t mutex;                /* protects all members below   */
+    pthread_cond_t  cond;
+    size_t          count;                /* tiles in the selection       */
+    size_t          next;                 /* next tile to hand a thread   */
+    size_t          retired;              /* tiles done with              */
+    size_t          window;               /* most tiles in flight         */
+    unsigned char **data;                 /* compressed tiles             */
+    size_t         *nbytes;
+    unsigned       *mask;                 /* skipped filters per tile     */
+    char           *ready;
+    int             failed;
+} db_hdf5_tiles_t;
+
+/* Offset in the dataset of the K'th tile of the selection */
+PRIVATE void
+db_hdf5_tile_origin(db_hdf5_tiles_t const *t, size_t k, hsize_t origin[])
+{
+    int i;
+    for (i = t->rank-1; i >= 0; i--)
     {
-        H5Pset_chunk(P_ckcrprops, rank, size);
-        if (db_hdf5_set_compression(dbfile, 0)<0) {
-            db_perror("db_hdf5_set_compression", E_CALLFAIL, me);
-            return(-1);
+        origin[i] = (t->first[i] + k % t->ntiles[i]) * t->chunk[i];
+        k /= t->ntiles[i];
+    }
+}
+
+/* Copy between a tile buffer and the part of memory that it overlaps */
+PRIVATE void
+db_hdf5_tile_copy(db_hdf5_tiles_t const *t, hsize_t const origin[],
+    unsigned char *tile, int to_tile)
+{
+    hsize_t lo[H5S_MAX_RANK], hi[H5S_MAX_RANK], p[H5S_MAX_RANK];
+    size_t run;
+    int i, last = t->rank-1;
+
+    for (i = 0; i < t->rank; i++)
+    {
+        lo[i] = MAX(origin[i], t->off[i]);
+        hi[i] = MIN(origin[i] + t->chunk[i], t->off[i] + t->len[i]);
+        if (lo[i] >= hi[i]) return;
+        p[i] = lo[i];
+    }
+    run = (size_t) (hi[last] - lo[last]) * t->esize;
+
+    for (;;)
+    {
+        size_t toff = 0, moff = 0;
+        for (i = 0; i < t->rank; i++)
+        {
+            toff = toff * t->chunk[i] + (p[i] - origin[i]);
+            moff = moff * t->len[i] + (p[i] - t->off[i]);
+        }
+        if (to_tile)
+            memcpy(tile + toff * t->esize, t->mem + moff * t->esize, run);
+        else
+            memcpy(t->mem + moff * t->esize, tile + toff * t->esize, run);
+
+        /* Step to the next row */
+        for (i = last-1; i >= 0; i--)
+        {
+            if (++p[i] < hi[i]) break;
+            p[i] = lo[i];
         }
-        P_crprops = P_ckcrprops;
+        if (i < 0) break;
     }
-    else if (DBGetCompressionFile(dbfile))
+}
+
+/* HDF5's byte shuffle filter and its inverse */
+PRIVATE void
+db_hdf5_tile_shuffle(unsigned char const *src, unsigned char *dst,
+    size_t nbytes, size_t esize, int unshuffle)
+{
+    size_t n = nbytes / esize, i, j;
+    for (j = 0; j < esize; j++)
     {
-        H5Pset_chunk(P_ckcrprops, rank, size);
-        if (db_hdf5_set_compression(dbfile, 0)<0) {
-            db_perror("db_hdf5_set_compression", E_CALLFAIL, me);
-            return(-1);
+        for (i = 0; i < n; i++)
+        {
+            if (unshuffle)
+                dst[i*esize + j] = src[j*n + i];
+            else
+                dst[j*n + i] = src[i*esize + j];
         }
-        P_crprops = P_ckcrprops;
     }
-    return 0;
 }
-/*-------------------------------------------------------------------------
- * Function:    db_hdf5_get_comp_var 
- *
- * Purpose:     Given a file handle and varname containing at least one
- *              underscore, attempts to get size and, optionally, read
- *              the corresponding HDF5 datatype name and member
- *              name pair, if it exists, formed by splitting the given
- *              varname at the underscore character. If multiple splits
- *              could possibly match with an HDF5 datatype name and member
- *              name pair in the file, only the first found is returned.
- *
+
+SILO_CALLBACK void
+db_hdf5_tile_compress(void *arg)
+{
+    db_hdf5_tiles_t *t = (db_hdf5_tiles_t *) arg;
+    hsize_t origin[H5S_MAX_RANK];
+
+    for (;;)
+    {
+        unsigned char *raw, *tmp = 0, *out = 0;
+        uLongf outlen = compressBound((uLong) t->tile_bytes);
+        size_t k;
+        int ok;
+
+        pthread_mutex_lock(&t->mutex);
+        while (!t->failed && t->next < t->count &&
+               t->next - t->retired >= t->window)
+            pthread_cond_wait(&t->cond, &t->mutex);
+        if (t->failed || t->next >= t->count)
+        {
+            pthread_mutex_unlock(&t->mutex);
+            return;
+        }
+        k = t->next++;
+        pthread_mutex_unlock(&t->mutex);
+
+        /* The part of an edge tile beyond the dataset is written as zero,
+           which is also HDF5's default fill value */
+        raw = (unsigned char *) calloc(t->tile_bytes, 1);
+        if (raw && t->shuffle >= 0)
+            tmp = (unsigned char *) malloc(t->tile_bytes);
+        ok = raw && (t->shuffle < 0 || tmp) &&
+             (out = (unsigned char *) malloc(outlen)) != 0;
+        if (ok)
+        {
+            db_hdf5_tile_origin(t, k, origin);
+            db_hdf5_tile_copy(t, origin, raw, 1);
+            if (tmp)
+            {
+                db_hdf5_tile_shuffle(raw, tmp, t->tile_bytes, t->esize, 0);
+                free(raw);
+                raw = tmp;
+                tmp = 0;
+            }
+            ok = compress2(out, &outlen, raw, (uLong) t->tile_bytes,
+                           t->level) == Z_OK;
+        }
+        free(raw);
+        free(tmp);
+        if (!ok)
+        {
+            free(out);
+            out = 0;
+        }
+
+        pthread_mutex_lock(&t->mutex);
+        t->data[k] = out;
+        t->nbytes[k] = (size_t) outlen;
+        t->ready[k] = 1;
+        if (!ok) t->failed = 1;
+        pthread_cond_broadcast(&t->cond);
+        pthread_mutex_unlock(&t->mutex);
+    }
+}
+
+SILO_CALLBACK void
+db_hdf5_tile_decompress(void *arg)
+{
+    db_hdf5_tiles_t *t = (db_hdf5_tiles_t *) arg;
+    hsize_t origin[H5S_MAX_RANK];
+
+    for (;;)
+    {
+        unsigned char *in, *raw, *tmp = 0;
+        size_t k, nbytes;
+        unsigned mask;
+        int ok = 1;
+
+        pthread_mutex_lock(&t->mutex);
+        while (!t->failed && t->next < t->count && !t->ready[t->next])
+            pthread_cond_wait(&t->cond, &t->mutex);
+        if (t->failed || t->next >= t->count)
+        {
+            pthread_mutex_unlock(&t->mutex);
+            return;
+        }
+        k = t->next++;
+        in = t->data[k];
+        nbytes = t->nbytes[k];
+        mask = t->mask[k];
+        t->data[k] = 0;
+        pthread_mutex_unlock(&t->mutex);
+
+        raw = in;
+        if (!(mask & (1u << t->deflate)))
+        {
+            uLongf rawlen = (uLongf) t->tile_bytes;
+            raw = (unsigned char *) malloc(t->tile_bytes);
+            ok = raw && uncompress(raw, &rawlen, in, (uLong) nbytes) == Z_OK &&
+                 rawlen == t->tile_bytes;
+        }
+        else
+        {
+            ok = nbytes == t->tile_bytes;
+        }
+        if (ok && t->shuffle >= 0 && !(mask & (1u << t->shuffle)))
+        {
+            ok = (tmp = (unsigned char *) malloc(t->tile_bytes)) != 0;
+            if (ok)
+                db_hdf5_tile_shuffle(raw, tmp, t->tile_bytes, t->esize, 1);
+        }
+        if (ok)
+        {
+            db_hdf5_tile_origin(t, k, origin);
+            db_hdf5_tile_copy(t, origin, tmp ? tmp : raw, 0);
+        }
+        if (raw != in) free(raw);
+        free(in);
+        free(tmp);
+
+        pthread_mutex_lock(&t->mutex);
+        t->retired++;
+        if (!ok) t->failed = 1;
+        pthread_cond_broadcast(&t->cond);
+        pthread_mutex_unlock(&t->mutex);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tiles_init
+ *
+ * Purpose:     Decide whether the selection of a dataset given by OFF and
+ *              LEN can be moved tile by tile on threads and, if so, set
+ *              up T for it.
+ *
+ * Return:      1 if it can, 0 if not.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_tiles_init(db_hdf5_tiles_t *t, hid_t dset, hid_t mtype,
+    int rank, hsize_t const off[], hsize_t const len[])
+{
+    hid_t dcpl = -1, ftype = -1, space = -1;
+    int nfilters, i, ok = 0;
+
+    if (DB_THREADS < 2 || rank < 1 || rank > H5S_MAX_RANK)
+        return 0;
+
+    memset(t, 0, sizeof(*t));
+    t->dset = dset;
+    t->rank = rank;
+    t->shuffle = t->deflate = -1;
+
+    H5E_BEGIN_TRY {
+        if ((dcpl = H5Dget_create_plist(dset)) >= 0 &&
+            H5Pget_layout(dcpl) == H5D_CHUNKED &&
+            H5Pget_chunk(dcpl, rank, t->chunk) == rank &&
+            (ftype = H5Dget_type(dset)) >= 0 && H5Tequal(ftype, mtype) > 0 &&
+            (space = H5Dget_space(dset)) >= 0 &&
+            H5Sget_simple_extent_ndims(space) == rank &&
+            H5Sget_simple_extent_dims(space, t->dims, 0) == rank &&
+            (nfilters = H5Pget_nfilters(dcpl)) > 0 && nfilters <= 2)
+        {
+            ok = 1;
+            for (i = 0; i < nfilters && ok; i++)
+            {
+                unsigned flags, cd_values[8];
+                size_t cd_nelmts = NELMTS(cd_values);
+#if defined H5_USE_16_API || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR < 8)
+                H5Z_filter_t id = H5Pget_filter(dcpl, (unsigned) i, &flags,
+                                      &cd_nelmts, cd_values, 0, 0);
+#else
+                H5Z_filter_t id = H5Pget_filter(dcpl, (unsigned) i, &flags,
+                                      &cd_nelmts, cd_values, 0, 0, NULL);
+#endif
+                if (id == H5Z_FILTER_SHUFFLE && i == 0)
+                    t->shuffle = i;
+                else if (id == H5Z_FILTER_DEFLATE && i == nfilters-1 && cd_nelmts > 0)
+                {
+                    t->deflate = i;
+                    t->level = (int) cd_values[0];
+                }
+                else
+                    ok = 0;
+            }
+            ok = ok && t->deflate >= 0;
+        }
+    } H5E_END_TRY;
+    if (ok)
+    {
+        t->esize = H5Tget_size(mtype);
+        t->tile_bytes = t->esize;
+        t->count = 1;
+        for (i = 0; i < rank; i++)
+        {
+            t->off[i] = off[i];
+            t->len[i] = len[i];
+            if (len[i] == 0 || off[i] + len[i] > t->dims[i])
+                ok = 0;
+            else
+            {
+                t->first[i] = off[i] / t->chunk[i];
+                t->ntiles[i] = (off[i] + len[i] - 1) / t->chunk[i] - t->first[i] + 1;
+            }
+            t->tile_bytes *= (size_t) t->chunk[i];
+            t->count *= (size_t) t->ntiles[i];
+        }
+        ok = ok && t->count > 1;
+    }
+
+    H5E_BEGIN_TRY {
+        H5Pclose(dcpl);
+        H5Tclose(ftype);
+        H5Sclose(space);
+    } H5E_END_TRY;
+    return ok;
+}
+
+/* Start up to DB_THREADS tile threads running FUNC, allocating the per
+   tile state */
+PRIVATE int
+db_hdf5_tiles_start(db_hdf5_tiles_t *t, db_job_func_t func)
+{
+    int nthreads = (int) MIN((size_t) DB_THREADS, t->count);
+    int nstarted;
+
+    t->window = (size_t) nthreads * DB_HDF5_TILE_WINDOW;
+    t->data = (unsigned char **) calloc(t->count, sizeof(*t->data));
+    t->nbytes = (size_t *) calloc(t->count, sizeof(*t->nbytes));
+    t->mask = (unsigned *) calloc(t->count, sizeof(*t->mask));
+    t->ready = (char *) calloc(t->count, 1);
+    if (!t->data || !t->nbytes || !t->mask || !t->ready)
+        return -1;
+    pthread_mutex_init(&t->mutex, 0);
+    pthread_cond_init(&t->cond, 0);
+    if (NULL == (t->jobs = db_StartJobs(func, t, 0, nthreads, &nstarted)))
+    {
+        pthread_mutex_destroy(&t->mutex);
+        pthread_cond_destroy(&t->cond);
+        return -1;
+    }
+    return nstarted > 0 ? 0 : -1;
+}
+
+/* Stop the tile threads and release everything */
+PRIVATE void
+db_hdf5_tiles_finish(db_hdf5_tiles_t *t)
+{
+    size_t k;
+
+    if (t->jobs)
+    {
+        /* Any thread that never started runs now and finds no work */
+        pthread_mutex_lock(&t->mutex);
+        t->failed |= t->retired < t->count;
+        pthread_cond_broadcast(&t->cond);
+        pthread_mutex_unlock(&t->mutex);
+        db_FinishJobs(t->jobs);
+        pthread_mutex_destroy(&t->mutex);
+        pthread_cond_destroy(&t->cond);
+    }
+    for (k = 0; t->data && k < t->count; k++)
+        free(t->data[k]);
+    free(t->data);
+    free(t->nbytes);
+    free(t->mask);
+    free(t->ready);
+}
+#endif /* DB_HDF5_TILE_THREADS */
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_write_tiles
+ *
+ * Purpose:     Write all of BUF to the new, tiled dataset DSET by
+ *              compressing its tiles on threads.
+ *
+ * Return:      1 if written, 0 if the dataset must be written with
+ *              H5Dwrite instead, -1 on failure.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_write_tiles(hid_t dset, hid_t mtype, void const *buf)
+{
+#ifdef DB_HDF5_TILE_THREADS
+    db_hdf5_tiles_t t;
+    hsize_t dims[H5S_MAX_RANK], zero[H5S_MAX_RANK], origin[H5S_MAX_RANK];
+    hid_t space;
+    int rank, failed = 0;
+    size_t k;
+    double t0;
+
+    if (!buf || (space = H5Dget_space(dset)) < 0)
+        return 0;
+    rank = H5Sget_simple_extent_ndims(space);
+    if (rank > 0 && rank <= H5S_MAX_RANK)
+        H5Sget_simple_extent_dims(space, dims, 0);
+    H5Sclose(space);
+    memset(zero, 0, sizeof(zero));
+    if (!db_hdf5_tiles_init(&t, dset, mtype, rank, zero, dims))
+        return 0;
+    t.mem = (unsigned char *) buf;
+    t0 = db_WallTime();
+    if (db_hdf5_tiles_start(&t, db_hdf5_tile_compress) < 0)
+    {
+        db_hdf5_tiles_finish(&t);
+        return 0;
+    }
+    for (k = 0; k < t.count && !failed; k++)
+    {
+        pthread_mutex_lock(&t.mutex);
+        while (!t.ready[k] && !t.failed)
+            pthread_cond_wait(&t.cond, &t.mutex);
+        failed = t.failed;
+        pthread_mutex_unlock(&t.mutex);
+        if (failed) break;
+
+        db_hdf5_tile_origin(&t, k, origin);
+        failed = H5Dwrite_chunk(dset, H5P_DEFAULT, 0, origin, t.nbytes[k],
+                                t.data[k]) < 0;
+        if (!failed) db_StatWrite(0, (long long) t.nbytes[k]);
+        free(t.data[k]);
+        t.data[k] = 0;
+
+        pthread_mutex_lock(&t.mutex);
+        t.retired++;
+        if (failed) t.failed = 1;
+        pthread_cond_broadcast(&t.cond);
+        pthread_mutex_unlock(&t.mutex);
+    }
+    db_hdf5_tiles_finish(&t);
+    db_StatCompress(db_WallTime() - t0);
+    return failed ? -1 : 1;
+#else
+    return 0;
+#endif
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_read_tiles
+ *
+ * Purpose:     Read the part of DSET given by OFFSET and LENGTH into BUF
+ *              by decompressing the tiles it overlaps on threads. A
+ *              NULL OFFSET means the whole dataset.
+ *
+ * Return:      1 if read, 0 if the data must be read with H5Dread
+ *              instead, -1 on failure.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_read_tiles(hid_t dset, hid_t mtype, int ndims, int const *offset,
+    int const *length, int const *stride, void *buf)
+{
+#ifdef DB_HDF5_TILE_THREADS
+    db_hdf5_tiles_t t;
+    hsize_t off[H5S_MAX_RANK], len[H5S_MAX_RANK], origin[H5S_MAX_RANK];
+    int i, failed = 0;
+    size_t k;
+    double t0;
+
+    if (DB_THREADS < 2 || ndims < 1 || ndims > H5S_MAX_RANK)
+        return 0;
+    if (offset)
+    {
+        for (i = 0; i < ndims; i++)
+        {
+            if (offset[i] < 0 || length[i] <= 0 || (stride && stride[i] != 1))
+                return 0;
+            off[i] = (hsize_t) offset[i];
+            len[i] = (hsize_t) length[i];
+        }
+    }
+    else
+    {
+        hid_t space = H5Dget_space(dset);
+        if (space < 0) return 0;
+        i = H5Sget_simple_extent_ndims(space) == ndims &&
+            H5Sget_simple_extent_dims(space, len, 0) == ndims;
+        H5Sclose(space);
+        if (!i) return 0;
+        memset(off, 0, sizeof(off));
+    }
+    if (!db_hdf5_tiles_init(&t, dset, mtype, ndims, off, len))
+        return 0;
+    t.mem = (unsigned char *) buf;
+
+    /* Fall back to HDF5 if any tile was never written */
+    for (k = 0; k < t.count; k++)
+    {
+        hsize_t nbytes = 0;
+        herr_t status;
+        db_hdf5_tile_origin(&t, k, origin);
+        H5E_BEGIN_TRY {
+            status = H5Dget_chunk_storage_size(dset, origin, &nbytes);
+        } H5E_END_TRY;
+        if (status < 0 || nbytes == 0)
+            return 0;
+    }
+    t0 = db_WallTime();
+    if (db_hdf5_tiles_start(&t, db_hdf5_tile_decompress) < 0)
+    {
+        db_hdf5_tiles_finish(&t);
+        return 0;
+    }
+    for (k = 0; k < t.count && !failed; k++)
+    {
+        hsize_t nbytes = 0;
+        unsigned char *data = 0;
+        uint32_t mask = 0;
+
+        pthread_mutex_lock(&t.mutex);
+        while (k - t.retired >= t.window && !t.failed)
+            pthread_cond_wait(&t.cond, &t.mutex);
+        failed = t.failed;
+        pthread_mutex_unlock(&t.mutex);
+        if (failed) break;
+
+        db_hdf5_tile_origin(&t, k, origin);
+        failed = H5Dget_chunk_storage_size(dset, origin, &nbytes) < 0 ||
+                 (data = (unsigned char *) malloc((size_t) nbytes)) == 0 ||
+                 H5Dread_chunk(dset, H5P_DEFAULT, origin, &mask, data) < 0;
+        if (!failed) db_StatRead(0, (long long) nbytes);
+
+        pthread_mutex_lock(&t.mutex);
+        t.data[k] = data;
+        t.nbytes[k] = (size_t) nbytes;
+        t.mask[k] = (unsigned) mask;
+        t.ready[k] = 1;
+        if (failed) t.failed = 1;
+        pthread_cond_broadcast(&t.cond);
+        pthread_mutex_unlock(&t.mutex);
+    }
+
+    /* Wait for the threads to drain the tiles */
+    pthread_mutex_lock(&t.mutex);
+    while (!t.failed && t.retired < t.count)
+        pthread_cond_wait(&t.cond, &t.mutex);
+    failed = t.failed;
+    pthread_mutex_unlock(&t.mutex);
+    db_hdf5_tiles_finish(&t);
+    db_StatCompress(db_WallTime() - t0);
+    return failed ? -1 : 1;
+#else
+    return 0;
+#endif
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_auto_trial
+ *
+ * Purpose:     Write a sample of an array through the filters of rule
+ *              CAND into FID, an in-memory file, and measure the ratio
+ *              and time. The sample keeps the array's fastest varying
+ *              dimensions so that FPZIP and ZFP see its structure.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1, the candidate can't be used
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_auto_trial(DBfile *dbfile, hid_t fid, db_comprule_t const *cand,
+    int dtype, int rank, hsize_t const dims[], void const *sample,
+    double *ratio, double *seconds)
+{
+    hid_t mtype = silom2hdfm_type(dtype);
+    hid_t space = -1, dapl = -1, dset = -1;
+    hsize_t nbytes, stored = 0;
+    double t0;
+    int i, err = -1;
+
+    for (i = 0, nbytes = H5Tget_size(mtype); i < rank; i++)
+        nbytes *= dims[i];
+
+    H5E_BEGIN_TRY {
+        if (H5Premove_filter(P_ckcrprops, H5Z_FILTER_ALL) >= 0 &&
+            H5Pset_chunk(P_ckcrprops, rank, dims) >= 0 &&
+            db_hdf5_set_compression(dbfile, cand) >= 0 &&
+            (space = H5Screate_simple(rank, dims, 0)) >= 0 &&
+            (dapl = H5Pcreate(H5P_DATASET_ACCESS)) >= 0 &&
+            H5Pset_chunk_cache(dapl, 0, 0, 1.0) >= 0)
+        {
+            /* Without a chunk cache the data is filtered by H5Dwrite,
+               so only it is timed. Wall time counts tile threads. */
+            if ((dset = H5Dcreate2(fid, "trial", mtype, space, H5P_DEFAULT,
+                                   P_ckcrprops, dapl)) >= 0)
+            {
+                t0 = db_WallTime();
+                if (H5Dwrite(dset, mtype, space, space, H5P_DEFAULT, sample) >= 0)
+                    stored = H5Dget_storage_size(dset);
+                *seconds = db_WallTime() - t0;
+            }
+            H5Dclose(dset);
+            H5Ldelete(fid, "trial", H5P_DEFAULT);
+        }
+        H5Pclose(dapl);
+        H5Sclose(space);
+    } H5E_END_TRY;
+
+    if (stored > 0)
+    {
+        *ratio = (double) nbytes / (double) stored;
+        err = 0;
+    }
+    return err;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_auto_select
+ *
+ * Purpose:     Choose a compression method for an array written with
+ *              METHOD=AUTO by trial compressing a sample of it with each
+ *              candidate. CHOSEN gets a copy of RULE with the method to
+ *              use, which is DB_COMPMETHOD_NONE if nothing is worth it.
+ *              The choice is counted for DBGetCompressionStats.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE void
+db_hdf5_auto_select(DBfile *dbfile, db_comprule_t const *rule, int dtype,
+    int rank, hsize_t const size[], void const *buf, db_comprule_t *chosen)
+{
+    int cands[3], ncands = 0, best = -1, fastest = -1, i;
+    double ratio[3], speed[3], secs, total = 0;
+    long long nvals = 1, plane = 1, nsample;
+    hsize_t dims[H5S_MAX_RANK];
+    unsigned char const *sample = (unsigned char const *) buf;
+    size_t esize = (size_t) db_GetMachDataSize(dtype);
+    hid_t fapl = -1, fid = -1;
+
+    *chosen = *rule;
+    chosen->method = DB_COMPMETHOD_GZIP;
+    if (!buf)
+        return;
+
+    cands[ncands++] = DB_COMPMETHOD_GZIP;
+    if (dtype == DB_FLOAT || dtype == DB_DOUBLE)
+    {
+#ifdef HAVE_FPZIP
+        cands[ncands++] = DB_COMPMETHOD_FPZIP;
+#endif
+#ifdef HAVE_ZFP
+        if (rule->zfpmode)
+            cands[ncands++] = DB_COMPMETHOD_ZFP;
+#endif
+    }
+
+    /* Take whole rows (planes) from the middle of the array if one fits
+       in the sample, otherwise a run of values */
+    for (i = 0; i < rank; i++)
+    {
+        dims[i] = size[i];
+        nvals *= (long long) size[i];
+        if (i > 0)
+            plane *= (long long) size[i];
+    }
+    if (nvals <= rule->sample)
+        nsample = nvals;
+    else if (rank > 1 && plane <= rule->sample)
+    {
+        dims[0] = (hsize_t) (rule->sample / plane);
+        nsample = (long long) dims[0] * plane;
+        sample += ((size[0] - dims[0]) / 2) * plane * esize;
+    }
+    else
+    {
+        rank = 1;
+        dims[0] = (hsize_t) rule->sample;
+        nsample = rule->sample;
+        sample += ((nvals - nsample) / 2) * esize;
+    }
+
+    H5E_BEGIN_TRY {
+        if ((fapl = H5Pcreate(H5P_FILE_ACCESS)) >= 0 &&
+            H5Pset_fapl_core(fapl, (size_t) (nsample * esize), FALSE) >= 0)
+            fid = H5Fcreate("db_hdf5_auto_select", H5F_ACC_TRUNC,
+                            H5P_DEFAULT, fapl);
+        H5Pclose(fapl);
+    } H5E_END_TRY;
+    if (fid < 0)
+        return;
+
+    for (i = 0; i < ncands; i++)
+    {
+        db_comprule_t cand = *rule;
+        cand.method = cands[i];
+        cand.errmode = COMPRESSION_ERRMODE_FALLBACK;
+        speed[i] = -1;
+        if (db_hdf5_auto_trial(dbfile, fid, &cand, dtype, rank, dims,
+                               sample, &ratio[i], &secs) < 0)
+            continue;
+        total += secs;
+        speed[i] = nsample * esize / (secs > 1e-6 ? secs : 1e-6) / 1e6;
+        if (ratio[i] < rule->minratio)
+            continue;
+        if (fastest < 0 || speed[i] > speed[fastest])
+            fastest = i;
+        if (speed[i] >= rule->minspeed &&
+            (best < 0 || ratio[i] > ratio[best]))
+            best = i;
+    }
+    H5E_BEGIN_TRY {
+        H5Fclose(fid);
+    } H5E_END_TRY;
+
+    if (best < 0)
+        best = fastest;
+    chosen->method = best < 0 ? DB_COMPMETHOD_NONE : cands[best];
+    db_RecordCompression(chosen->method, nvals * (long long) esize,
+        (long long) (nvals * esize / (best < 0 ? 1.0 : ratio[best])),
+        nsample * (long long) esize * ncands, total);
+}
+
+/* Remember the object being written for db_hdf5_set_properties */
+PRIVATE void
+db_hdf5_put_context(DBfile_hdf5 *dbfile, int objtype, char const *name)
+{
+    dbfile->cur_objtype = objtype;
+    FREE(dbfile->cur_objname);
+    dbfile->cur_objname = STRDUP(name);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_set_properties
+ *
+ * Purpose:     Set the HDF5 properties.
+ *
+ * Bugs:        
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  Thomas R. Treadway, Tue Mar  6 14:23:50 PST 2007
+ *
+ * Modifications:
+ *
+ *   Compressed datasets are split into tiles when the compression
+ *   string has CHUNK=.
+ *
+ *   Added DTYPE and FLAGS. The rule of the compiled compression string
+ *   for the object being written and DTYPE is applied to a pipeline
+ *   emptied of the last dataset's filters. Arrays with fewer values than
+ *   the rule's MINSIZE are stored uncompressed. FLAGS replaces the
+ *   separate call compwrz made to add mesh compression.
+ *
+ *   Added BUF, the data to be written or NULL, from which METHOD=AUTO
+ *   samples.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_set_properties(DBfile *dbfile, int dtype, int rank, hsize_t size[],
+    int flags, void const *buf)
+{
+    static char *me = "db_hdf5_set_properties";
+    DBfile_hdf5 *dbf = (DBfile_hdf5 *) dbfile;
+    db_comprule_t const *rule;
+    db_comprule_t autorule;
+    int checksums = DBGetEnableChecksumsFile(dbfile);
+    hsize_t chunk[H5S_MAX_RANK];
+    long long nvals = 1;
+    int i;
+
+    P_crprops = H5P_DEFAULT;
+    rule = db_SelectCompression(db_GetCompressionPolicy(dbfile),
+               dbf->cur_objtype, dbf->cur_objname, dtype);
+    if (rule && rule->bad)
+        return db_perror(DBGetCompressionFile(dbfile), E_COMPRESSION, me);
+
+    for (i = 0; i < rank; i++)
+        nvals *= (long long) size[i];
+    if (rule && rule->method == DB_COMPMETHOD_AUTO &&
+        nvals >= rule->minsize)
+    {
+        db_hdf5_auto_select(dbfile, rule, dtype, rank, size, buf, &autorule);
+        rule = &autorule;
+    }
+    if (rule && (rule->method == DB_COMPMETHOD_NONE ||
+                 nvals < rule->minsize ||
+                 (rule->method == DB_COMPMETHOD_HZIP &&
+                  !(flags & ALLOW_MESH_COMPRESSION))))
+        rule = 0;
+    if (!rule && !checksums)
+        return 0;
+
+    if (H5Premove_filter(P_ckcrprops, H5Z_FILTER_ALL) < 0 ||
+        (checksums && H5Pset_fletcher32(P_ckcrprops) < 0))
+        return db_perror("filter pipeline", E_CALLFAIL, me);
+
+    if (!rule)
+        H5Pset_chunk(P_ckcrprops, rank, size);
+    else
+    {
+        /* HZIP compresses a whole mesh array at once */
+        if (rule->method == DB_COMPMETHOD_HZIP)
+            db_hdf5_chunk_dims(0, rank, size, chunk);
+        else
+            db_hdf5_chunk_dims(rule->chunk, rank, size, chunk);
+        H5Pset_chunk(P_ckcrprops, rank, chunk);
+        if (db_hdf5_set_compression(dbfile, rule)<0) {
+            db_perror("db_hdf5_set_compression", E_CALLFAIL, me);
+            return(-1);
+        }
+    }
+    P_crprops = P_ckcrprops;
+    return 0;
+}
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_get_comp_var 
+ *
+ * Purpose:     Given a file handle and varname containing at least one
+ *              underscore, attempts to get size and, optionally, read
+ *              the corresponding HDF5 datatype name and member
+ *              name pair, if it exists, formed by splitting the given
+ *              varname at the underscore character. If multiple splits
+ *              could possibly match with an HDF5 datatype name and member
+ *              name pair in the file, only the first found is returned.
+ *
  *              This function is necessary to support the old pdb-ish way
  *              of permitting a Silo client to request raw data arrays
  *              for the component of an object by the naming convention
@@ -3826,6 +4558,8 @@ db_hdf5_get_comp_var(DBfile *_dbfile, char const *name, hsize_t *nelmts,
             char tmp[256];
             int buf_was_allocated = 0;
 
+            db_hdf5_async_finish(dbfile);
+
             valsize = H5Tget_size(comptype);
 
             if (comptype != T_str256 && *buf == 0)
@@ -3873,7 +4607,7 @@ db_hdf5_get_comp_var(DBfile *_dbfile, char const *name, hsize_t *nelmts,
                     if (!DBGetEnableChecksumsFile(_dbfile))
                         P_rdprops = P_ckrdprops;
 
-                    if (H5Dread(d, mtype, H5S_ALL, H5S_ALL, P_rdprops, *buf)<0) {
+                    if (db_hdf5_Dread(d, mtype, H5S_ALL, H5S_ALL, P_rdprops, *buf)<0) {
                         hdf5_to_silo_error(name, "db_hdf5_get_comp_var");
                         if (buf_was_allocated)
                         {
@@ -3933,11 +4667,13 @@ db_hdf5_get_comp_var(DBfile *_dbfile, char const *name, hsize_t *nelmts,
 }
 
 /*-------------------------------------------------------------------------
- * Function:    load_toc
+ * Function:    db_hdf5_classify_link
  *
- * Purpose:     Add an object to the table of contents
+ * Purpose:     Determine the silo object type of the link NAME in GRP and
+ *              whether it is a symbolic or external link.
  *
- * Return:      Success:        0
+ * Return:      Success:        0, *objtype is DB_INVALID_OBJECT for
+ *                              things that do not belong in the toc
  *
  *              Failure:        -1
  *
@@ -3945,21 +4681,16 @@ db_hdf5_get_comp_var(DBfile *_dbfile, char const *name, hsize_t *nelmts,
  *              Thursday, February 11, 1999
  *
  * Modifications:
- *
- *   Mark C. Miller, Tue Feb  1 13:48:33 PST 2005
- *   Made it deal with case of QUAD_RECT or QUAD_CURV
- *
+ *   Split out of load_toc so the toc index can classify links too.
  *-------------------------------------------------------------------------
  */
-PRIVATE herr_t
-load_toc(hid_t grp, char const *name, H5L_info_t const *dummy, void *_toc)
+PRIVATE int
+db_hdf5_classify_link(hid_t grp, char const *name, DBObjectType *objtype_out, int *islink_out)
 {
-    DBtoc               *toc = (DBtoc*)_toc;
     H5G_stat_t          sb;
     H5L_info_t          lb;
     DBObjectType        objtype = DB_INVALID_OBJECT;
-    int                 *nvals=NULL, _objtype, islink=0;
-    char                ***names=NULL;
+    int                 _objtype, islink=0;
     hid_t               obj=-1, attr=-1;
 
     if (H5Gget_objinfo(grp, name, FALSE, &sb)<0) return -1;
@@ -4008,6 +4739,37 @@ load_toc(hid_t grp, char const *name, H5L_info_t const *dummy, void *_toc)
         break;
     }
 
+    *objtype_out = objtype;
+    *islink_out = islink;
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_toc_append
+ *
+ * Purpose:     Add an object NAME of type OBJTYPE to the table of contents.
+ *              For links, TARGET is what the link points at.
+ *
+ * Return:      void
+ *
+ * Programmer:  Robb Matzke
+ *              Thursday, February 11, 1999
+ *
+ * Modifications:
+ *
+ *   Mark C. Miller, Tue Feb  1 13:48:33 PST 2005
+ *   Made it deal with case of QUAD_RECT or QUAD_CURV
+ *
+ *   Split out of load_toc so the toc index can fill a toc too.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE void
+db_hdf5_toc_append(DBtoc *toc, DBObjectType objtype, char const *name,
+    int islink, char const *target)
+{
+    int                 *nvals=NULL;
+    char                ***names=NULL;
+
     /* What table of contents field does this object belong to? */
     switch (objtype) {
     case DB_INVALID_OBJECT:
@@ -4117,40 +4879,433 @@ load_toc(hid_t grp, char const *name, H5L_info_t const *dummy, void *_toc)
         break;
     }
 
-    /* Append to table of contents */
-#warning REVISIT THIS CODE BLOCK
-#if 0
-    if (islink) {
-        int n = toc->nsymlink++;
-        toc->symlink_names = (char **) realloc(toc->symlink_names, (n+1)*sizeof(char*));
-        toc->symlink_names[n] = STRDUP(name);
-    }
-    else if (names && nvals) {
-        int n = (*nvals)++;
-        *names = (char **)realloc(*names, *nvals*sizeof(char*));
-        (*names)[n] = STRDUP(name);
-    }
-#endif
     if (names && nvals) {
         int n1 = (*nvals)++;
         *names = (char **)realloc(*names, *nvals*sizeof(char*));
         (*names)[n1] = STRDUP(name);
         if (islink) {
-            char target[2*256];
             int n2 = toc->nsymlink++;
             toc->symlink_names = (char **) realloc(toc->symlink_names, (n2+1)*sizeof(char*));
             toc->symlink_names[n2] = (*names)[n1]; /* note: copy of the pointer */
             toc->symlink_target_names = (char **) realloc(toc->symlink_target_names, (n2+1)*sizeof(char*));
-            if (db_hdf5_getslink(grp, name, target) == 0)
-                toc->symlink_target_names[n2] = STRDUP(target);
-            else
-                toc->symlink_target_names[n2] = STRDUP("unknown");
+            toc->symlink_target_names[n2] = STRDUP(target);
         }
     }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    load_toc
+ *
+ * Purpose:     Add an object to the table of contents
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  Robb Matzke
+ *              Thursday, February 11, 1999
+ *
+ * Modifications:
+ *
+ *   Mark C. Miller, Tue Feb  1 13:48:33 PST 2005
+ *   Made it deal with case of QUAD_RECT or QUAD_CURV
+ *
+ *   Classification and appending moved to db_hdf5_classify_link and
+ *   db_hdf5_toc_append.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE herr_t
+load_toc(hid_t grp, char const *name, H5L_info_t const *dummy, void *_toc)
+{
+    DBtoc               *toc = (DBtoc*)_toc;
+    DBObjectType        objtype;
+    int                 islink;
+    char                target[2*256];
+
+    if (db_hdf5_classify_link(grp, name, &objtype, &islink)<0) return -1;
+    if (objtype == DB_INVALID_OBJECT) return 0;
+
+    if (islink && db_hdf5_getslink(grp, name, target) != 0)
+        strcpy(target, "unknown");
+    db_hdf5_toc_append(toc, objtype, name, islink, target);
 
     return 0;
 }
 
+/*-------------------------------------------------------------------------
+ * Table of contents index, enabled per file with DBOPT_H5_TOC_INDEX.
+ *
+ * Walking a group for DBNewToc costs a link lookup per entry and, for
+ * every silo object, an open of its named type to read the silo_type
+ * attribute. On directories of tens of thousands of domain objects that
+ * takes seconds. When the index is enabled, DBClose stores each silo
+ * directory's names and object types as one byte dataset in the link
+ * group, named after the directory's object address. DBNewToc reads that
+ * dataset in place of the walk whenever the directory still has the
+ * number of links recorded in it, and walks as before otherwise.
+ *
+ * The layout is little-endian and independent of the writer:
+ *
+ *      "STOC", version byte, 3 pad bytes, u64 nlinks, u32 nentries
+ *      per entry: i32 object type, u8 islink, name\0 [, target\0]
+ *-------------------------------------------------------------------------
+ */
+#define TOCIDX_MAGIC    "STOC"
+#define TOCIDX_VERSION  1
+#define TOCIDX_HDRSIZE  20
+
+typedef struct db_hdf5_tocidx_t {
+    unsigned char       *buf;
+    size_t              len;
+    size_t              cap;
+    unsigned            nentries;
+} db_hdf5_tocidx_t;
+
+PRIVATE int
+db_hdf5_tocidx_wanted(int opts_set_id)
+{
+    int _opts_set_id = opts_set_id - NUM_DEFAULT_FILE_OPTIONS_SETS;
+    DBoptlist const *opts;
+    void *p;
+
+    if (_opts_set_id < 0 || _opts_set_id >= MAX_FILE_OPTIONS_SETS ||
+        (opts = SILO_Globals.fileOptionsSets[_opts_set_id]) == 0 ||
+        (p = DBGetOption(opts, DBOPT_H5_TOC_INDEX)) == 0)
+        return 0;
+    return *((int*)p) != 0;
+}
+
+PRIVATE int
+db_hdf5_tocidx_put(db_hdf5_tocidx_t *idx, void const *data, size_t n)
+{
+    if (idx->len + n > idx->cap)
+    {
+        size_t newcap = idx->cap ? 2 * idx->cap : 4096;
+        unsigned char *newbuf;
+        while (newcap < idx->len + n) newcap *= 2;
+        if ((newbuf = (unsigned char *) realloc(idx->buf, newcap)) == 0)
+            return -1;
+        idx->buf = newbuf;
+        idx->cap = newcap;
+    }
+    memcpy(idx->buf + idx->len, data, n);
+    idx->len += n;
+    return 0;
+}
+
+PRIVATE void
+db_hdf5_tocidx_encode(unsigned char *p, unsigned long long val, int nbytes)
+{
+    int i;
+    for (i = 0; i < nbytes; i++, val >>= 8)
+        p[i] = (unsigned char) (val & 0xff);
+}
+
+PRIVATE unsigned long long
+db_hdf5_tocidx_decode(unsigned char const *p, int nbytes)
+{
+    unsigned long long val = 0;
+    int i;
+    for (i = nbytes-1; i >= 0; i--)
+        val = (val << 8) | p[i];
+    return val;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_name
+ *
+ * Purpose:     Name, in the link group, of the toc index for GRP and the
+ *              number of links GRP has now.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1, including for groups that live in
+ *                              another file by way of an external link
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_tocidx_name(DBfile_hdf5 *dbfile, hid_t grp, char *name, hsize_t *nlinks)
+{
+    H5G_stat_t          sb, lsb;
+    H5G_info_t          gi;
+
+    if (H5Gget_objinfo(grp, ".", TRUE, &sb)<0 ||
+        H5Gget_objinfo(dbfile->link, ".", TRUE, &lsb)<0 ||
+        H5Gget_info(grp, &gi)<0)
+        return -1;
+    if (sb.fileno[0] != lsb.fileno[0] || sb.fileno[1] != lsb.fileno[1])
+        return -1;
+    sprintf(name, "toc_%lx_%lx", sb.objno[1], sb.objno[0]);
+    *nlinks = gi.nlinks;
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_next
+ *
+ * Purpose:     Decode the index entry at P, which must end before END.
+ *
+ * Return:      Success:        pointer to the following entry
+ *
+ *              Failure:        NULL for a truncated entry
+ *-------------------------------------------------------------------------
+ */
+PRIVATE unsigned char const *
+db_hdf5_tocidx_next(unsigned char const *p, unsigned char const *end,
+    DBObjectType *objtype, int *islink, char const **name, char const **target)
+{
+    unsigned char const *q;
+
+    if (end - p < 6)
+        return 0;
+    *objtype = (DBObjectType) (int) db_hdf5_tocidx_decode(p, 4);
+    *islink = p[4];
+    *name = (char const *) p + 5;
+    if ((q = (unsigned char const *) memchr(p+5, '\0', end-(p+5))) == 0)
+        return 0;
+    p = q + 1;
+    *target = 0;
+    if (*islink)
+    {
+        if ((q = (unsigned char const *) memchr(p, '\0', end-p)) == 0)
+            return 0;
+        *target = (char const *) p;
+        p = q + 1;
+    }
+    return p;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_read
+ *
+ * Purpose:     Read the toc index of GRP if there is one and it is still
+ *              current.
+ *
+ * Return:      Success:        buffer of *len bytes, header included, the
+ *                              caller frees it
+ *
+ *              Failure:        NULL, there is no usable index
+ *-------------------------------------------------------------------------
+ */
+PRIVATE unsigned char *
+db_hdf5_tocidx_read(DBfile_hdf5 *dbfile, hid_t grp, size_t *len)
+{
+    char                name[64];
+    hsize_t             nlinks;
+    hid_t               dset=-1, space=-1;
+    hssize_t            n = 0;
+    unsigned char       *buf = 0;
+
+    H5E_BEGIN_TRY {
+        if (db_hdf5_tocidx_name(dbfile, grp, name, &nlinks)>=0 &&
+            (dset = H5Dopen(dbfile->link, name))>=0 &&
+            (space = H5Dget_space(dset))>=0 &&
+            (n = H5Sget_simple_extent_npoints(space)) >= TOCIDX_HDRSIZE &&
+            (buf = (unsigned char *) malloc((size_t) n)) != 0)
+        {
+            if (H5Dread(dset, H5T_NATIVE_UCHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf)<0 ||
+                memcmp(buf, TOCIDX_MAGIC, 4) != 0 || buf[4] != TOCIDX_VERSION ||
+                db_hdf5_tocidx_decode(buf+8, 8) != (unsigned long long) nlinks)
+            {
+                free(buf);
+                buf = 0;
+            }
+        }
+        if (space>=0) H5Sclose(space);
+        if (dset>=0) H5Dclose(dset);
+    } H5E_END_TRY;
+
+    if (buf) db_StatRead(1, (long long) n);
+    *len = buf ? (size_t) n : 0;
+    return buf;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_load
+ *
+ * Purpose:     Fill TOC from the toc index of GRP.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1, TOC is left partially filled
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_tocidx_load(DBfile_hdf5 *dbfile, hid_t grp, DBtoc *toc)
+{
+    size_t              len;
+    unsigned char       *buf = db_hdf5_tocidx_read(dbfile, grp, &len);
+    unsigned char const *p, *end;
+    unsigned            i, nentries;
+
+    if (!buf)
+        return -1;
+
+    nentries = (unsigned) db_hdf5_tocidx_decode(buf+16, 4);
+    for (i = 0, p = buf + TOCIDX_HDRSIZE, end = buf + len; i < nentries; i++)
+    {
+        DBObjectType objtype;
+        int islink;
+        char const *name, *target;
+
+        if ((p = db_hdf5_tocidx_next(p, end, &objtype, &islink, &name, &target)) == 0)
+            break;
+        db_hdf5_toc_append(toc, objtype, name, islink, target);
+    }
+
+    free(buf);
+    return i == nentries ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_remove
+ *
+ * Purpose:     Discard the toc index of the group holding object NAME,
+ *              which is relative to LOC and may be a path. Used when the
+ *              object is replaced, which leaves the number of links in
+ *              its group unchanged.
+ *
+ * Return:      void
+ *-------------------------------------------------------------------------
+ */
+PRIVATE void
+db_hdf5_tocidx_remove(DBfile_hdf5 *dbfile, hid_t loc, char const *name)
+{
+    char                idxname[64];
+    char const          *slash = strrchr(name, '/');
+    char                *dir = 0;
+    hid_t               grp = loc;
+    hsize_t             nlinks;
+
+    H5E_BEGIN_TRY {
+        if (slash)
+        {
+            dir = slash == name ? STRDUP("/") : STRNDUP(name, (int) (slash - name));
+            grp = dir ? H5Gopen(loc, dir) : -1;
+        }
+        if (grp>=0 && db_hdf5_tocidx_name(dbfile, grp, idxname, &nlinks)>=0)
+            H5Gunlink(dbfile->link, idxname);
+        if (grp>=0 && grp != loc)
+            H5Gclose(grp);
+    } H5E_END_TRY;
+    FREE(dir);
+}
+
+PRIVATE herr_t
+build_tocidx(hid_t grp, char const *name, H5L_info_t const *dummy, void *_idx)
+{
+    db_hdf5_tocidx_t    *idx = (db_hdf5_tocidx_t*)_idx;
+    DBObjectType        objtype;
+    int                 islink;
+    unsigned char       hdr[5];
+    char                target[2*256];
+
+    if (db_hdf5_classify_link(grp, name, &objtype, &islink)<0) return -1;
+    if (objtype == DB_INVALID_OBJECT) return 0;
+
+    db_hdf5_tocidx_encode(hdr, (unsigned long long) (unsigned) objtype, 4);
+    hdr[4] = (unsigned char) (islink != 0);
+    if (db_hdf5_tocidx_put(idx, hdr, 5)<0 ||
+        db_hdf5_tocidx_put(idx, name, strlen(name)+1)<0)
+        return -1;
+    if (islink)
+    {
+        if (db_hdf5_getslink(grp, name, target) != 0)
+            strcpy(target, "unknown");
+        if (db_hdf5_tocidx_put(idx, target, strlen(target)+1)<0)
+            return -1;
+    }
+    idx->nentries++;
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_tocidx_update
+ *
+ * Purpose:     Make sure GRP and the silo directories below it all have a
+ *              current toc index, writing those that are missing or
+ *              stale.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_tocidx_update(DBfile_hdf5 *dbfile, hid_t grp)
+{
+    db_hdf5_tocidx_t    idx;
+    char                name[64];
+    hsize_t             nlinks, dims[1];
+    hid_t               dset=-1, space=-1;
+    unsigned char const *p, *end;
+    unsigned            i;
+    int                 retval = -1;
+
+    memset(&idx, 0, sizeof(idx));
+    if ((idx.buf = db_hdf5_tocidx_read(dbfile, grp, &idx.len)) == 0)
+    {
+        unsigned char hdr[TOCIDX_HDRSIZE];
+
+        if (db_hdf5_tocidx_name(dbfile, grp, name, &nlinks)<0)
+            return -1;
+        memset(hdr, 0, sizeof(hdr));
+        memcpy(hdr, TOCIDX_MAGIC, 4);
+        hdr[4] = TOCIDX_VERSION;
+        db_hdf5_tocidx_encode(hdr+8, (unsigned long long) nlinks, 8);
+        if (db_hdf5_tocidx_put(&idx, hdr, sizeof(hdr))<0 ||
+            H5Literate(grp, H5_INDEX_NAME, H5_ITER_INC, NULL, build_tocidx, &idx)<0)
+        {
+            FREE(idx.buf);
+            return -1;
+        }
+        db_hdf5_tocidx_encode(idx.buf+16, (unsigned long long) idx.nentries, 4);
+
+        /* Replace any stale index */
+        H5Gunlink(dbfile->link, name);
+        dims[0] = idx.len;
+        if ((space = H5Screate_simple(1, dims, NULL))<0 ||
+            (dset = H5Dcreate(dbfile->link, name, H5T_STD_U8LE, space, H5P_DEFAULT))<0 ||
+            H5Dwrite(dset, H5T_NATIVE_UCHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, idx.buf)<0)
+        {
+            if (dset>=0) H5Dclose(dset);
+            if (space>=0) H5Sclose(space);
+            FREE(idx.buf);
+            return -1;
+        }
+        db_StatWrite(1, (long long) idx.len);
+        H5Dclose(dset);
+        H5Sclose(space);
+    }
+
+    /* Descend into subdirectories, but not through links */
+    retval = 0;
+    idx.nentries = (unsigned) db_hdf5_tocidx_decode(idx.buf+16, 4);
+    for (i = 0, p = idx.buf + TOCIDX_HDRSIZE, end = idx.buf + idx.len; i < idx.nentries; i++)
+    {
+        DBObjectType objtype;
+        int islink;
+        char const *ename, *target;
+        hid_t subgrp;
+
+        if ((p = db_hdf5_tocidx_next(p, end, &objtype, &islink, &ename, &target)) == 0)
+            break;
+        if (objtype != DB_DIR || islink)
+            continue;
+        if ((subgrp = H5Gopen(grp, ename))<0)
+        {
+            retval = -1;
+            continue;
+        }
+        if (db_hdf5_tocidx_update(dbfile, subgrp)<0)
+            retval = -1;
+        H5Gclose(subgrp);
+    }
+
+    FREE(idx.buf);
+    return retval;
+}
+
 /*-------------------------------------------------------------------------
  * Function:    find_objno
  *
@@ -4241,7 +5396,7 @@ db_hdf5_handle_ctdt(DBfile_hdf5 *dbfile, int ts, float t, int dts, double dt, in
             if (space == -1)
                 space = H5Screate_simple(1, &one, &one);
             dset = H5Dcreate(dbfile->cwg, names[i], ftype, space, H5P_DEFAULT);
-            H5Dwrite(dset, mtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf[i]);
+            db_hdf5_Dwrite(dset, mtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf[i]);
             H5Dclose(dset);
         }
 
@@ -4249,76 +5404,437 @@ db_hdf5_handle_ctdt(DBfile_hdf5 *dbfile, int ts, float t, int dts, double dt, in
             H5Sclose(space);
 
     }
-    H5E_END_TRY;
+    H5E_END_TRY;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_compname
+ *
+ * Purpose:     Returns a new name relative to the link directory. The name
+ *              is generated by incrementing the link counter of the file,
+ *              which is read from the `nlinks' attribute of the link
+ *              directory on first use and saved back to it by
+ *              db_hdf5_save_nlinks.
+ *
+ * Return:      Success:        0, A new link name not more than 32
+ *                              characters long counting the null
+ *                              terminator is returned through the NAME
+ *                              argument.
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  Robb Matzke
+ *              Tuesday, March 23, 1999
+ *
+ * Modifications:
+ *
+ *   Keep the counter in the file struct rather than reading and writing
+ *   the attribute for every name. Names are at least 6 digits but widen
+ *   as needed, so there is no longer a limit of 999999 links.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_compname(DBfile_hdf5 *dbfile, char name[32]/*out*/)
+{
+    static char *me = "db_hdf5_compname";
+    hid_t       attr=-1;
+
+    PROTECT {
+        /* Read the counter from the `nlinks' attribute of the link group
+           if there is one. A new file starts at zero. */
+        if (dbfile->nlinks_state == 0) {
+            H5E_BEGIN_TRY {
+                attr = H5Aopen_name(dbfile->link, "nlinks");
+            } H5E_END_TRY;
+            dbfile->nlinks = 0;
+            if (attr>=0 && H5Aread(attr, H5T_NATIVE_LLONG, &dbfile->nlinks)<0) {
+                db_perror("nlinks attribute", E_CALLFAIL, me);
+                UNWIND();
+            }
+            if (attr>=0) H5Aclose(attr);
+            attr = -1;
+            dbfile->nlinks_state = 1;
+        }
+
+        /* Create a name */
+        dbfile->nlinks++;
+        dbfile->nlinks_state = 2;
+        sprintf(name, "#%06lld", dbfile->nlinks);
+        
+    } CLEANUP {
+        H5E_BEGIN_TRY {
+            H5Aclose(attr);
+        } H5E_END_TRY;
+    } END_PROTECT;
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_save_nlinks
+ *
+ * Purpose:     Write the link counter of the file back to the `nlinks'
+ *              attribute of the link directory if db_hdf5_compname has
+ *              handed out names since it was last saved. The attribute
+ *              stays a native int, which older readers expect, until the
+ *              counter no longer fits in one.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_save_nlinks(DBfile_hdf5 *dbfile)
+{
+    static char *me = "db_hdf5_save_nlinks";
+    hid_t       attr=-1, atype=-1;
+    int         wide;
+
+    if (dbfile->nlinks_state != 2)
+        return 0;
+
+    PROTECT {
+        wide = dbfile->nlinks > INT_MAX;
+
+        /* Replace an int attribute that is too narrow for the counter */
+        H5E_BEGIN_TRY {
+            attr = H5Aopen_name(dbfile->link, "nlinks");
+        } H5E_END_TRY;
+        if (attr>=0 && wide) {
+            if ((atype = H5Aget_type(attr))<0) {
+                db_perror("nlinks attribute", E_CALLFAIL, me);
+                UNWIND();
+            }
+            if (H5Tget_size(atype) < sizeof(long long)) {
+                H5Aclose(attr);
+                attr = -1;
+                if (H5Adelete(dbfile->link, "nlinks")<0) {
+                    db_perror("nlinks attribute", E_CALLFAIL, me);
+                    UNWIND();
+                }
+            }
+            H5Tclose(atype);
+            atype = -1;
+        }
+
+        if (attr<0 && (attr=H5Acreate(dbfile->link, "nlinks",
+                                      wide ? H5T_NATIVE_LLONG : H5T_NATIVE_INT,
+                                      SCALAR, H5P_DEFAULT))<0) {
+            db_perror("nlinks attribute", E_CALLFAIL, me);
+            UNWIND();
+        }
+        if (H5Awrite(attr, H5T_NATIVE_LLONG, &dbfile->nlinks)<0) {
+            db_perror("nlinks attribute", E_CALLFAIL, me);
+            UNWIND();
+        }
+        H5Aclose(attr);
+        dbfile->nlinks_state = 1;
+
+    } CLEANUP {
+        H5E_BEGIN_TRY {
+            H5Tclose(atype);
+            H5Aclose(attr);
+        } H5E_END_TRY;
+    } END_PROTECT;
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Asynchronous write-behind, enabled per file with DBOPT_H5_ASYNC.
+ *
+ * db_hdf5_compwrz creates the dataset as usual but, rather than calling
+ * H5Dwrite inline, copies the caller's buffer and queues the write. A
+ * worker thread owned by the file drains the queue. It holds the HDF5
+ * driver lock while it writes, so it only makes progress between the
+ * application's Silo calls, which is exactly when the application is
+ * computing. Anything that needs the data in the file (reads, slice
+ * writes, object copies, DBFlush and DBClose) first finishes the queue
+ * itself, in the calling thread, which already holds the driver lock.
+ *
+ * The worker requires a thread-safe build. Otherwise DBOPT_H5_ASYNC is
+ * accepted and writes remain synchronous.
+ *-------------------------------------------------------------------------
+ */
+#if SILO_THREADSAFE
+#define DB_HDF5_ASYNC_MAX_BYTES (256<<20) /* max bytes copied but unwritten */
+
+typedef struct db_hdf5_async_op_t {
+    hid_t       dset;                   /*open dataset to write         */
+    hid_t       mtype;                  /*memory type of buf            */
+    hid_t       space;                  /*dataspace of dset             */
+    void       *buf;                    /*private copy of caller's data */
+    size_t      nbytes;                 /*size of buf                   */
+    struct db_hdf5_async_op_t *next;
+} db_hdf5_async_op_t;
+
+typedef struct db_hdf5_async_t {
+    pthread_t           worker;
+    pthread_mutex_t     mutex;          /*protects all members below    */
+    pthread_cond_t      cond;           /*signaled on queue or stop     */
+    db_hdf5_async_op_t *head, *tail;
+    size_t              nbytes;         /*bytes queued                  */
+    int                 stop;           /*tells worker to exit          */
+    int                 nerrs;          /*failed writes not yet reported*/
+} db_hdf5_async_t;
+
+/* Do one queued write. Caller must hold the HDF5 driver lock. */
+static void
+db_hdf5_async_write(db_hdf5_async_t *a, db_hdf5_async_op_t *op)
+{
+    herr_t status;
+
+    H5E_BEGIN_TRY {
+        status = H5Dwrite(op->dset, op->mtype, op->space, op->space,
+                          H5P_DEFAULT, op->buf);
+        H5Dclose(op->dset);
+        H5Sclose(op->space);
+    } H5E_END_TRY;
+    if (status < 0)
+    {
+        pthread_mutex_lock(&a->mutex);
+        a->nerrs++;
+        pthread_mutex_unlock(&a->mutex);
+    }
+    free(op->buf);
+    free(op);
+}
+
+static db_hdf5_async_op_t *
+db_hdf5_async_pop(db_hdf5_async_t *a)
+{
+    db_hdf5_async_op_t *op;
+
+    pthread_mutex_lock(&a->mutex);
+    if ((op = a->head))
+    {
+        if (!(a->head = op->next))
+            a->tail = 0;
+        a->nbytes -= op->nbytes;
+    }
+    pthread_mutex_unlock(&a->mutex);
+    return op;
+}
+
+/* The worker never blocks on the driver lock. A thread that holds it
+   may be waiting in db_hdf5_async_stop for the worker to exit. */
+static void *
+db_hdf5_async_main(void *arg)
+{
+    db_hdf5_async_t *a = (db_hdf5_async_t *) arg;
+    db_hdf5_async_op_t *op;
+    struct timespec ts;
+
+    pthread_mutex_lock(&a->mutex);
+    while (!a->stop)
+    {
+        if (!a->head)
+        {
+            pthread_cond_wait(&a->cond, &a->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&a->mutex);
+        if (db_api_trylock_driver(DB_HDF5) == 0)
+        {
+            while ((op = db_hdf5_async_pop(a)))
+                db_hdf5_async_write(a, op);
+            db_api_unlock();
+            pthread_mutex_lock(&a->mutex);
+            continue;
+        }
+
+        /* Some Silo call is using HDF5; look again shortly */
+        pthread_mutex_lock(&a->mutex);
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        if (!a->stop)
+            pthread_cond_timedwait(&a->cond, &a->mutex, &ts);
+    }
+    pthread_mutex_unlock(&a->mutex);
+    return 0;
+}
+#endif
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_async_start
+ *
+ * Purpose:     Start write-behind for a file if its options set asks for
+ *              it with DBOPT_H5_ASYNC.
+ *
+ * Return:      void; if the worker can't be started writes just remain
+ *              synchronous.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE void
+db_hdf5_async_start(DBfile_hdf5 *dbfile, int opts_set_id)
+{
+#if SILO_THREADSAFE
+    int _opts_set_id = opts_set_id - NUM_DEFAULT_FILE_OPTIONS_SETS;
+    DBoptlist const *opts;
+    db_hdf5_async_t *a;
+    void *p;
+
+    if (_opts_set_id < 0 || _opts_set_id >= MAX_FILE_OPTIONS_SETS ||
+        (opts = SILO_Globals.fileOptionsSets[_opts_set_id]) == 0 ||
+        (p = DBGetOption(opts, DBOPT_H5_ASYNC)) == 0 || *((int*)p) == 0)
+        return;
+
+    if ((a = (db_hdf5_async_t *) calloc(1, sizeof(db_hdf5_async_t))) == 0)
+        return;
+    pthread_mutex_init(&a->mutex, 0);
+    pthread_cond_init(&a->cond, 0);
+    if (pthread_create(&a->worker, 0, db_hdf5_async_main, a) != 0)
+    {
+        pthread_cond_destroy(&a->cond);
+        pthread_mutex_destroy(&a->mutex);
+        free(a);
+        return;
+    }
+    dbfile->async = a;
+#endif
 }
 
 /*-------------------------------------------------------------------------
- * Function:    db_hdf5_compname
+ * Function:    db_hdf5_async_finish
  *
- * Purpose:     Returns a new name relative to the link directory. The name
- *              is generated by reading the `nlinks' attribute of the link
- *              directory, incrementing it, creating a file name, and saving
- *              it back to the file.
+ * Purpose:     Complete all queued writes for a file in the calling
+ *              thread. Caller must be inside a Silo call on the file.
  *
- * Return:      Success:        0, A new link name not more than 8 characters
- *                              long counting the null terminator is returned
- *                              through the NAME argument.
+ * Return:      Success:        0
  *
- *              Failure:        -1
+ *              Failure:        -1, some write queued on this file
+ *                              (maybe one done by the worker) has failed
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_async_finish(DBfile_hdf5 *dbfile)
+{
+#if SILO_THREADSAFE
+    db_hdf5_async_t *a = dbfile ? dbfile->async : 0;
+    db_hdf5_async_op_t *op;
+    int nerrs;
+
+    if (!a)
+        return 0;
+    while ((op = db_hdf5_async_pop(a)))
+        db_hdf5_async_write(a, op);
+    pthread_mutex_lock(&a->mutex);
+    nerrs = a->nerrs;
+    pthread_mutex_unlock(&a->mutex);
+    return nerrs ? -1 : 0;
+#else
+    return 0;
+#endif
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_async_stop
  *
- * Programmer:  Robb Matzke
- *              Tuesday, March 23, 1999
+ * Purpose:     Complete all queued writes for a file and stop its worker.
  *
- * Modifications:
+ * Return:      Success:        0
  *
+ *              Failure:        -1, some queued write failed
  *-------------------------------------------------------------------------
  */
 PRIVATE int
-db_hdf5_compname(DBfile_hdf5 *dbfile, char name[8]/*out*/)
+db_hdf5_async_stop(DBfile_hdf5 *dbfile)
 {
-    static char *me = "db_hdf5_compname";
-    hid_t       attr=-1;
-    int         nlinks;
-
-    PROTECT {
-        /* Open or create the `nlinks' attribute of the link group */
-        H5E_BEGIN_TRY {
-            attr = H5Aopen_name(dbfile->link, "nlinks");
-        } H5E_END_TRY;
-        if (attr<0 && (attr=H5Acreate(dbfile->link, "nlinks", H5T_NATIVE_INT,
-                                      SCALAR, H5P_DEFAULT))<0) {
-            db_perror("nlinks attribute", E_CALLFAIL, me);
-            UNWIND();
-        }
+#if SILO_THREADSAFE
+    db_hdf5_async_t *a = dbfile ? dbfile->async : 0;
+    int retval;
 
-        /* Increment the nlinks value */
-        if (H5Aread(attr, H5T_NATIVE_INT, &nlinks)<0) {
-            db_perror("nlinks attribute", E_CALLFAIL, me);
-            UNWIND();
-        }
+    if (!a)
+        return 0;
+    retval = db_hdf5_async_finish(dbfile);
+    pthread_mutex_lock(&a->mutex);
+    a->stop = 1;
+    pthread_cond_signal(&a->cond);
+    pthread_mutex_unlock(&a->mutex);
+    pthread_join(a->worker, 0);
+
+    /* worker may have finished one last write after the finish above */
+    if (a->nerrs)
+        retval = -1;
+    pthread_cond_destroy(&a->cond);
+    pthread_mutex_destroy(&a->mutex);
+    free(a);
+    dbfile->async = 0;
+    return retval;
+#else
+    return 0;
+#endif
+}
 
-        nlinks++;
-        if (nlinks > 999999) {
-            db_perror("exceeded maximum number of nlinks", E_CALLFAIL, me);
-            UNWIND();
-        }
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_async_queue
+ *
+ * Purpose:     Queue the write of `buf' to the open dataset `dset' whose
+ *              dataspace is `space'. On success the queue owns `dset'
+ *              and `space'.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1, nothing was queued and the caller
+ *                              should do the write itself
+ *-------------------------------------------------------------------------
+ */
+PRIVATE int
+db_hdf5_async_queue(DBfile_hdf5 *dbfile, hid_t dset, hid_t mtype,
+    hid_t space, void const *buf, int nels)
+{
+#if SILO_THREADSAFE
+    db_hdf5_async_t *a = dbfile->async;
+    db_hdf5_async_op_t *op;
+    size_t nbytes = (size_t) nels * H5Tget_size(mtype);
 
-        if (H5Awrite(attr, H5T_NATIVE_INT, &nlinks)<0) {
-            db_perror("nlinks attribute", E_CALLFAIL, me);
-            UNWIND();
-        }
-        H5Aclose(attr);
+    if (!a || nbytes > DB_HDF5_ASYNC_MAX_BYTES)
+        return -1;
 
-        /* Create a name */
-        sprintf(name, "#%06d", nlinks);
-        
-    } CLEANUP {
-        H5E_BEGIN_TRY {
-            H5Aclose(attr);
-        } H5E_END_TRY;
-    } END_PROTECT;
+    /* Bound memory held by copies; errors are picked up at the next
+       completion barrier */
+    if (a->nbytes + nbytes > DB_HDF5_ASYNC_MAX_BYTES)
+    {
+        while ((op = db_hdf5_async_pop(a)))
+            db_hdf5_async_write(a, op);
+    }
 
+    if ((op = (db_hdf5_async_op_t *) malloc(sizeof(db_hdf5_async_op_t))) == 0)
+        return -1;
+    if ((op->buf = malloc(nbytes)) == 0)
+    {
+        free(op);
+        return -1;
+    }
+    memcpy(op->buf, buf, nbytes);
+    op->dset = dset;
+    op->mtype = mtype;
+    op->space = space;
+    op->nbytes = nbytes;
+    op->next = 0;
+
+    pthread_mutex_lock(&a->mutex);
+    if (a->tail)
+        a->tail->next = op;
+    else
+        a->head = op;
+    a->tail = op;
+    a->nbytes += nbytes;
+    pthread_cond_signal(&a->cond);
+    pthread_mutex_unlock(&a->mutex);
+
+    /* Counted here since the worker has no current file statistics */
+    db_StatWrite(DB_STATS_META, (long long) nbytes);
     return 0;
+#else
+    return -1;
+#endif
 }
 
 /*-------------------------------------------------------------------------
@@ -4362,6 +5878,8 @@ db_hdf5_compname(DBfile_hdf5 *dbfile, char name[8]/*out*/)
  *   where no datasets are put in the 'LINKGRP' and are instead put
  *   'next to' the objects they bind with. The intention is to eliminate
  *   the one, very, very large '/.silo' group.
+ *
+ *   Tiled datasets are compressed on threads by db_hdf5_write_tiles.
  *-------------------------------------------------------------------------
  */
 PRIVATE int
@@ -4413,18 +5931,11 @@ db_hdf5_compwrz(DBfile_hdf5 *dbfile, int dtype, int rank, int const _size[],
             UNWIND();
         }
  
-        if (db_hdf5_set_properties((DBfile*) dbfile, rank, size) < 0 ) {
+        if (db_hdf5_set_properties((DBfile*) dbfile, dtype, rank, size,
+                compressionFlags, buf) < 0 ) {
             db_perror("db_hdf5_set_properties", E_CALLFAIL, me);
             UNWIND();
         }
-        if (DBGetCompressionFile((DBfile*)dbfile) && compressionFlags)
-        {
-            if (db_hdf5_set_compression((DBfile*)dbfile, compressionFlags)<0)
-            {
-                db_perror("db_hdf5_set_compression", E_CALLFAIL, me);
-                UNWIND();
-            }
-        }
 
         if (DBGetFriendlyHDF5NamesFile((DBfile*)dbfile) == 2)
         {
@@ -4454,31 +5965,31 @@ db_hdf5_compwrz(DBfile_hdf5 *dbfile, int dtype, int rank, int const _size[],
                 H5Glink(dbfile->cwg, H5G_LINK_SOFT, name, fname);
         }
 
-        if (buf && H5Dwrite(dset, mtype, space, space, H5P_DEFAULT, buf)<0) {
-            hdf5_to_silo_error(name, "db_hdf5_compwrz");
-            UNWIND();
+        /* Queue the write if this file does write-behind. Compressed
+           datasets are always written here since some filters get their
+           parameters from library state at write time. */
+        if (buf && dbfile->async && !DBGetCompressionFile((DBfile*)dbfile) &&
+            db_hdf5_async_queue(dbfile, dset, mtype, space, buf, nels) == 0)
+        {
+            /* the queue owns dset and space now */
+            space = -1;
         }
-
-        /* Release resources */
-        H5Dclose(dset);
-        H5Sclose(space);
-
-        /* remove any mesh specific filters if we have 'em */
-        if (DBGetCompressionFile((DBfile*)dbfile) && compressionFlags)
+        else
         {
-            int i;
-            for (i=0; i<H5Pget_nfilters(P_crprops); i++)
-            {
-#if defined H5_USE_16_API || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR < 8)
-                if (H5Pget_filter(P_crprops,(unsigned)i,0,0,0,0,0) == DB_HDF5_HZIP_ID)
-#else
-                if (H5Pget_filter(P_crprops,(unsigned)i,0,0,0,0,0,NULL) == DB_HDF5_HZIP_ID)
-#endif
-                {
-                    H5Premove_filter(P_crprops, DB_HDF5_HZIP_ID);
-                    break;
-                }
+            int tiled = 0;
+            if (buf && (tiled = db_hdf5_write_tiles(dset, mtype, buf)) < 0) {
+                hdf5_to_silo_error(name, "db_hdf5_compwrz");
+                UNWIND();
+            }
+            if (buf && !tiled &&
+                db_hdf5_Dwrite(dset, mtype, space, space, H5P_DEFAULT, buf)<0) {
+                hdf5_to_silo_error(name, "db_hdf5_compwrz");
+                UNWIND();
             }
+
+            /* Release resources */
+            H5Dclose(dset);
+            H5Sclose(space);
         }
 
     } CLEANUP {
@@ -4581,10 +6092,20 @@ db_hdf5_compckz(DBfile_hdf5 *dbfile, char *name)
  *              Robb Matzke, 1999-10-13
  *              Uses the current working directory instead of the root
  *              directory.
+ *
+ *              Added bulk argument. When set, the returned buffer is
+ *              obtained with db_alloc_bulk() so that it honors any
+ *              caller-supplied allocator and must be released with
+ *              db_free_bulk(). Use db_hdf5_comprd_bulk() for the
+ *              problem-sized arrays of objects returned to the caller.
+ *
+ *              Copy the dataset from the data read ahead for
+ *              DBGetObjects when it is there and needs no conversion.
  *-------------------------------------------------------------------------
  */
-PRIVATE void *
-db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
+static void *
+db_hdf5_comprd_helper(DBfile_hdf5 *dbfile, char *name, int ignore_force_single,
+    int bulk)
 {
     static char *me = "db_hdf5_comprd";
     void        *buf = NULL;
@@ -4593,6 +6114,7 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
     void       *retval = NULL;
     
     PROTECT {
+        db_hdf5_async_finish(dbfile);
         if (name && *name) {
             if ((d=H5Dopen(dbfile->cwg, name))<0) {
                 db_perror(name, E_NOTFOUND, me);
@@ -4615,7 +6137,8 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
                 mtype = H5T_NATIVE_FLOAT;
 
             /* Read the data */
-            if (NULL==(buf=malloc(nelmts*H5Tget_size(mtype)))) {
+            if (NULL==(buf=(bulk ? db_alloc_bulk((DBfile*)dbfile, nelmts*H5Tget_size(mtype))
+                                 : malloc(nelmts*H5Tget_size(mtype))))) {
                 db_perror(name, E_NOMEM, me);
                 UNWIND();
             }
@@ -4624,7 +6147,9 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
             if (!DBGetEnableChecksumsFile((DBfile*)dbfile))
                 P_rdprops = P_ckrdprops;
 
-            if (H5Dread(d, mtype, H5S_ALL, H5S_ALL, P_rdprops, buf)<0) {
+            if (!db_hdf5_prefetch_read(dbfile, d, ftype, mtype, buf,
+                                       nelmts*H5Tget_size(mtype)) &&
+                db_hdf5_Dread(d, mtype, H5S_ALL, H5S_ALL, P_rdprops, buf)<0) {
                 hdf5_to_silo_error(name, me);
                 UNWIND();
             }
@@ -4649,7 +6174,8 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
                 float *newbuf;
 
                 /* allocate a new buffer */
-                if (NULL==(newbuf=(float*)malloc(nelmts*sizeof(float)))) {
+                if (NULL==(newbuf=(float*)(bulk ? db_alloc_bulk((DBfile*)dbfile, nelmts*sizeof(float))
+                                                : malloc(nelmts*sizeof(float))))) {
                     db_perror(name, E_NOMEM, me);
                     UNWIND();
                 }
@@ -4687,7 +6213,9 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
                 }
 
                 /* Free old buffer and setup return value */
-                free(buf);
+                if (bulk) db_free_bulk(buf);
+                else      free(buf);
+                buf = NULL;
                 retval = newbuf;
             }
         }
@@ -4697,12 +6225,25 @@ db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
             H5Tclose(ftype);
             H5Sclose(fspace);
         } H5E_END_TRY;
-        FREE(buf);
+        if (bulk) FREE_BULK(buf)
+        else      FREE(buf);
     } END_PROTECT;
 
     return retval;
 }
 
+PRIVATE void *
+db_hdf5_comprd(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
+{
+    return db_hdf5_comprd_helper(dbfile, name, ignore_force_single, 0);
+}
+
+PRIVATE void *
+db_hdf5_comprd_bulk(DBfile_hdf5 *dbfile, char *name, int ignore_force_single)
+{
+    return db_hdf5_comprd_helper(dbfile, name, ignore_force_single, 1);
+}
+
 /*-------------------------------------------------------------------------
  * Function:    db_hdf5_fullname
  *
@@ -4822,6 +6363,10 @@ db_hdf5_fullname(DBfile_hdf5 *dbfile, char *name, char *full/*out*/)
  *
  * Modifications:
  *
+ *   Count the header as a metadata write in the file's statistics.
+ *
+ *   Discard the toc index of the object's group when an existing object
+ *   is rewritten.
  *-------------------------------------------------------------------------
  */
 PRIVATE int
@@ -4866,6 +6411,7 @@ db_hdf5_hdrwr(DBfile_hdf5 *dbfile, char *name, hid_t mtype, hid_t ftype,
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
         }
+        db_StatWrite(1, (long long) H5Tget_size(ftype));
         H5Aclose(attr);
 
         /* Open or create the `silo_type' attribute */
@@ -4888,6 +6434,11 @@ db_hdf5_hdrwr(DBfile_hdf5 *dbfile, char *name, hid_t mtype, hid_t ftype,
         H5Aclose(attr);
         H5Tclose(obj);
 
+        /* A rewrite may change the object's type without changing the
+         * number of links, so the toc index can no longer be trusted */
+        if (!created)
+            db_hdf5_tocidx_remove(dbfile, dbfile->cwg, name);
+
     } CLEANUP {
         H5E_BEGIN_TRY {
             H5Aclose(attr);
@@ -4943,6 +6494,8 @@ db_hdf5_ForceSingle(int status)
  *  Mark C. Miller, Wed Aug  4 16:06:41 PDT 2010
  *  Added conditional compilation logic for silo fapl for HDF5 1.8.4 or
  *  greater.
+ *
+ *  Pass DBOPT_H5_SILO_READ_AHEAD through to the silo vfd.
  *-------------------------------------------------------------------------
  */
 PRIVATE hid_t
@@ -4989,7 +6542,7 @@ db_hdf5_process_file_options(int opts_set_id, int mode, hid_t *fcpl)
        automatically. That can wind up hiding coding errors in this
        Silo plugin, so we do that only when user has requested that
        either top or no errors are reported. */
-    if (SILO_Globals._db_err_level_drvr == DB_ALL)
+    if (DB_ERR_LEVEL_DRVR == DB_ALL)
         h5status |= H5Pset_fclose_degree(retval, H5F_CLOSE_SEMI);
     else
         h5status |= H5Pset_fclose_degree(retval, H5F_CLOSE_STRONG);
@@ -5184,6 +6737,7 @@ db_hdf5_process_file_options(int opts_set_id, int mode, hid_t *fcpl)
                     int block_count = H5FD_SILO_DEFAULT_BLOCK_COUNT; 
                     int log_stats = H5FD_SILO_DEFAULT_LOG_STATS;
                     int use_direct = H5FD_SILO_DEFAULT_USE_DIRECT;
+                    int read_ahead = H5FD_SILO_DEFAULT_READ_AHEAD;
 
                     if ((p = DBGetOption(opts, DBOPT_H5_SILO_BLOCK_SIZE)))
                         block_size = (hsize_t) (*((int*) p));
@@ -5193,11 +6747,14 @@ db_hdf5_process_file_options(int opts_set_id, int mode, hid_t *fcpl)
                         log_stats = *((int*) p);
                     if ((p = DBGetOption(opts, DBOPT_H5_SILO_USE_DIRECT)))
                         use_direct = *((int*) p);
+                    if ((p = DBGetOption(opts, DBOPT_H5_SILO_READ_AHEAD)))
+                        read_ahead = *((int*) p);
 
                     h5status |= H5Pset_fapl_silo(retval);
                     h5status |= H5Pset_silo_block_size_and_count(retval, block_size, block_count);
                     h5status |= H5Pset_silo_log_stats(retval, log_stats);
                     h5status |= H5Pset_silo_use_direct(retval, use_direct);
+                    h5status |= H5Pset_silo_read_ahead(retval, read_ahead);
 #else
                     H5Pclose(retval);
                     return db_perror("Silo block VFD >= HDF5 1.8.4", E_NOTENABLEDINBUILD, me);
@@ -5792,10 +7349,11 @@ db_hdf5_initiate_close(DBfile *_dbfile)
     if (dbfile->cwg_name)
         free(dbfile->cwg_name);
     dbfile->cwg_name = NULL;
+    FREE(dbfile->cur_objname);
 
     /* Check for any open objects in this file */
 #if HDF5_VERSION_GE(1,6,0)
-    if (SILO_Globals._db_err_level_drvr == DB_ALL)
+    if (DB_ERR_LEVEL_DRVR == DB_ALL)
     {
         const unsigned int obj_flags = H5F_OBJ_LOCAL | H5F_OBJ_DATASET |
             H5F_OBJ_GROUP | H5F_OBJ_DATATYPE | H5F_OBJ_ATTR;
@@ -5871,12 +7429,13 @@ INTERNAL DBfile *
 db_hdf5_Open(char const *name, int mode, int opts_set_id)
 {
     DBfile_hdf5 *dbfile=NULL;
+    DBfile      *retval=NULL;
     hid_t       fid=-1, faprops=-1;
     hid_t      *fidp = 0;
     unsigned    hmode;
     static char *me = "db_hdf5_Open";
 
-    if (SILO_Globals._db_err_level_drvr == DB_ALL)
+    if (DB_ERR_LEVEL_DRVR == DB_ALL)
         H5Eset_auto((H5E_auto1_t) H5Eprint1, stderr);
     else
         H5Eset_auto(NULL, NULL);
@@ -5915,7 +7474,12 @@ db_hdf5_Open(char const *name, int mode, int opts_set_id)
     *fidp = fid;
     dbfile->pub.GrabId = (void*) fidp;
     dbfile->fid = fid;
-    return db_hdf5_finish_open(dbfile);
+    if ((retval = db_hdf5_finish_open(dbfile)) && DB_APPEND==mode)
+    {
+        db_hdf5_async_start(dbfile, opts_set_id);
+        dbfile->toc_index = db_hdf5_tocidx_wanted(opts_set_id);
+    }
+    return retval;
 }
 
 /*-------------------------------------------------------------------------
@@ -5952,12 +7516,13 @@ INTERNAL DBfile *
 db_hdf5_Create(char const *name, int mode, int target, int opts_set_id, char const *finfo)
 {
     DBfile_hdf5 *dbfile=NULL;
+    DBfile      *retval=NULL;
     hid_t       fid=-1, faprops=-1, fcprops=-1;
     hid_t      *fidp = 0;
     static char *me = "db_hdf5_Create";
 
     /* Turn off error messages from the hdf5 library */
-    if (SILO_Globals._db_err_level_drvr == DB_ALL)
+    if (DB_ERR_LEVEL_DRVR == DB_ALL)
         H5Eset_auto((H5E_auto1_t) H5Eprint1, stderr);
     else
         H5Eset_auto(NULL, NULL);
@@ -6013,7 +7578,12 @@ db_hdf5_Create(char const *name, int mode, int target, int opts_set_id, char con
 #if 0
     *(dbfile->pub.file_scope_globals) = SILO_Globals;
 #endif
-    return db_hdf5_finish_create(dbfile, target, finfo);
+    if ((retval = db_hdf5_finish_create(dbfile, target, finfo)))
+    {
+        db_hdf5_async_start(dbfile, opts_set_id);
+        dbfile->toc_index = db_hdf5_tocidx_wanted(opts_set_id);
+    }
+    return retval;
 }
 
 /*-------------------------------------------------------------------------
@@ -6036,6 +7606,12 @@ db_hdf5_Create(char const *name, int mode, int target, int opts_set_id, char con
  *   Mark C. Miller, Tue Feb  3 09:52:51 PST 2009
  *   Moved code to free pub.GrabId and set Grab related entries to zero to
  *   silo_db_close() function and then added a call to that function here.
+ *
+ *   Update the toc indices when DBOPT_H5_TOC_INDEX was given.
+ *
+ *   Save the link counter kept by db_hdf5_compname.
+ *
+ *   Drop any data read ahead for DBGetObjects.
  *-------------------------------------------------------------------------
  */
 SILO_CALLBACK int
@@ -6047,9 +7623,41 @@ db_hdf5_Close(DBfile *_dbfile)
 
     if (dbfile) {
 
+        /* Finish any write-behind first. A failed write is reported but
+           must not keep the file from being closed. */
+        if (db_hdf5_async_stop(dbfile)<0)
+        {
+            retval = -1;
+            PROTECT {
+                db_perror("queued write failed", E_CALLFAIL, me);
+            } CLEANUP {
+                CANCEL_UNWIND;
+            } END_PROTECT;
+        }
+
+        /* Bring the toc indices up to date. The index is only an
+           accelerator, so failing to write it is not an error. */
+        if (dbfile->toc_index)
+        {
+            hid_t root;
+            H5E_BEGIN_TRY {
+                if ((root = H5Gopen(dbfile->fid, "/"))>=0)
+                {
+                    db_hdf5_tocidx_update(dbfile, root);
+                    H5Gclose(root);
+                }
+            } H5E_END_TRY;
+        }
+
+        /* Save the link counter. Failing to do so is reported, since a
+           later append would reuse names, but the file is still closed. */
+        if (db_hdf5_save_nlinks(dbfile)<0)
+            retval = -1;
+
         PROTECT {
 
             FreeNodelists(dbfile, 0);
+            db_hdf5_Prefetch(_dbfile, 0, NULL);
 
             /* Free the private parts of the file */
             if (db_hdf5_initiate_close((DBfile*)dbfile)<0 ||
@@ -6092,6 +7700,10 @@ db_hdf5_Close(DBfile *_dbfile)
  *              Failure:        -1
  *
  * Programmer: Mark C. Miller, Fri Aug 14 11:49:05 PDT 2015
+ *
+ * Modifications:
+ *
+ *   Save the link counter kept by db_hdf5_compname.
  *-------------------------------------------------------------------------
  */
 SILO_CALLBACK int
@@ -6105,7 +7717,11 @@ db_hdf5_Flush(DBfile *_dbfile)
         return retval;
 
     PROTECT {
-        if (H5Fflush(dbfile->fid, H5F_SCOPE_LOCAL)>=0)
+        if (db_hdf5_async_finish(dbfile)<0)
+            db_perror("queued write failed", E_CALLFAIL, me);
+        else if (db_hdf5_save_nlinks(dbfile)<0)
+            db_perror("link counter", E_CALLFAIL, me);
+        else if (H5Fflush(dbfile->fid, H5F_SCOPE_LOCAL)>=0)
             retval = 0;
     } CLEANUP {
     } END_PROTECT;
@@ -6513,7 +8129,7 @@ copy_obj(hid_t hobj, char const *name, void *op_data)
                 if (strncmp(mem_value, "/.silo/#", 8) == 0)
                 {
                     /* get unique name for this dataset in dst file */
-                    char cname[8];
+                    char cname[32];
                     db_hdf5_compname(dstfile, cname);
 
                     /* copy this dataset to /.silo dir in dst file */
@@ -6668,7 +8284,8 @@ db_hdf5_CpListedObjects(int nobjs,
 
     PROTECT {
         int i, pass;
-         
+
+        db_hdf5_async_finish(dbfile);
         /* pass 0 ==> ensure all needed dst dirs are made, pass 1 ==> do the copies */
         dirPresent = (char *) calloc(nobjs,1);
         for (pass = 0; pass < 2; pass++)
@@ -6841,6 +8458,7 @@ db_hdf5_GetSymlink(DBfile *_dbfile, char const *in_candidate_link, char *out_tar
  *
  * Modifications:
  *
+ *   Use the directory's toc index when it has a current one.
  *-------------------------------------------------------------------------
  */
 SILO_CALLBACK int
@@ -6852,6 +8470,13 @@ db_hdf5_NewToc(DBfile *_dbfile)
     db_FreeToc(_dbfile);
     dbfile->pub.toc = toc = db_AllocToc();
 
+    if (db_hdf5_tocidx_load(dbfile, dbfile->cwg, toc)>=0)
+        return 0;
+
+    /* No usable index, or a damaged one. Start over with a walk. */
+    db_FreeToc(_dbfile);
+    dbfile->pub.toc = toc = db_AllocToc();
+
     if (H5Literate(dbfile->cwg, H5_INDEX_NAME, H5_ITER_INC, NULL, load_toc, toc)<0) return -1;
 
     return 0;
@@ -7194,6 +8819,8 @@ db_hdf5_GetComponentNames(DBfile *_dbfile, char const *objname, char ***comp_nam
  *   Added condition of flags!=OVERWRITE before erroring on non-user
  *   defined objects. A user could be using browser to OVERWRITE a
  *   standard Silo object.
+ *
+ *   Discard the toc index of the object's group when it is replaced.
  *-------------------------------------------------------------------------
  */
 static int count_commas(char const *str)
@@ -7225,7 +8852,8 @@ db_hdf5_WriteObject(DBfile *_dbfile,    /*File to write into */
          * name, ignoring failures. */
         if (flags) {
             H5E_BEGIN_TRY {
-                H5Gunlink(dbfile->cwg, obj->name);
+                if (H5Gunlink(dbfile->cwg, obj->name)>=0)
+                    db_hdf5_tocidx_remove(dbfile, dbfile->cwg, obj->name);
             } H5E_END_TRY;
         }
         
@@ -7648,6 +9276,7 @@ db_hdf5_WriteComponent(DBfile *_dbfile, DBobject *obj, char const *compname,
     }
 
     varname[0] = '\0';
+    db_hdf5_put_context(dbfile, DBGetObjtypeTag(obj->type), obj->name);
     db_hdf5_compwr(dbfile, datatype, rank, size, data, varname,
         friendly_name(_dbfile,obj->name, compname, 0));
     DBAddVarComponent(obj, compname, varname);
@@ -7985,6 +9614,7 @@ db_hdf5_GetVar(DBfile *_dbfile, char const *name)
     void        *result=NULL;
 
     PROTECT {
+        db_hdf5_async_finish(dbfile);
 
         /* Get dataset, type, and space */
         if ((dset=H5Dopen(dbfile->cwg, name))>=0) {
@@ -8014,7 +9644,7 @@ db_hdf5_GetVar(DBfile *_dbfile, char const *name)
                     P_rdprops = P_ckrdprops;
 
                 /* Read entire variable */
-                if (H5Dread(dset, mtype, H5S_ALL, H5S_ALL, P_rdprops, result)<0) {
+                if (db_hdf5_Dread(dset, mtype, H5S_ALL, H5S_ALL, P_rdprops, result)<0) {
                     hdf5_to_silo_error(name, me);
                     UNWIND();
                 }
@@ -8063,6 +9693,7 @@ db_hdf5_GetVar(DBfile *_dbfile, char const *name)
  *   Mark C. Miller, Tue Feb 15 14:53:29 PST 2005
  *   Forced it to ignore force_single setting 
  *
+ *   Tiled datasets are decompressed on threads by db_hdf5_read_tiles.
  *-------------------------------------------------------------------------
  */
 SILO_CALLBACK int
@@ -8070,9 +9701,11 @@ db_hdf5_ReadVar(DBfile *_dbfile, char const *vname, void *result)
 {
    DBfile_hdf5  *dbfile = (DBfile_hdf5*)_dbfile;
    static char  *me = "db_hdf5_ReadVar";
-   hid_t        dset=-1, mtype=-1, ftype=-1;
+   hid_t        dset=-1, mtype=-1, ftype=-1, space=-1;
+   int          tiled = 0;
 
    PROTECT {
+       db_hdf5_async_finish(dbfile);
 
        /* Get dataset and data type */
        if ((dset=H5Dopen(dbfile->cwg, vname))>=0) {
@@ -8092,12 +9725,20 @@ db_hdf5_ReadVar(DBfile *_dbfile, char const *vname, void *result)
                P_rdprops = P_ckrdprops;
 
            /* Read entire variable */
-           if (H5Dread(dset, mtype, H5S_ALL, H5S_ALL, P_rdprops, result)<0) {
+           if ((space=H5Dget_space(dset))<0 ||
+               (tiled=db_hdf5_read_tiles(dset, mtype,
+                    H5Sget_simple_extent_ndims(space), 0, 0, 0, result))<0) {
+               hdf5_to_silo_error(vname, me);
+               UNWIND();
+           }
+           if (!tiled &&
+               db_hdf5_Dread(dset, mtype, H5S_ALL, H5S_ALL, P_rdprops, result)<0) {
                hdf5_to_silo_error(vname, me);
                UNWIND();
            }
 
            /* Close everything */
+           H5Sclose(space);
            H5Dclose(dset);
            H5Tclose(ftype);
         }
@@ -8114,6 +9755,7 @@ db_hdf5_ReadVar(DBfile *_dbfile, char const *vname, void *result)
        H5E_BEGIN_TRY {
            H5Dclose(dset);
            H5Tclose(ftype);
+           H5Sclose(space);
        } H5E_END_TRY;
    } END_PROTECT;
    
@@ -8136,6 +9778,8 @@ db_hdf5_ReadVar(DBfile *_dbfile, char const *vname, void *result)
  *
  * Modifications:
  *
+ *   Unstrided slices of tiled datasets are read by db_hdf5_read_tiles,
+ *   which decompresses only the tiles they overlap, on threads.
  *-------------------------------------------------------------------------
  */
 SILO_CALLBACK int
@@ -8146,8 +9790,10 @@ db_hdf5_ReadVarSlice(DBfile *_dbfile, char const *vname, int const *offset, int
    static char  *me = "db_hdf5_ReadVarSlice";
    hid_t        dset=-1, ftype=-1, mtype=-1, mspace=-1, fspace=-1;
    hsize_t      mem_size[H5S_MAX_RANK];
+   int          tiled;
 
    PROTECT {
+       db_hdf5_async_finish(dbfile);
        /* Get dataset and data type */
        if ((dset=H5Dopen(dbfile->cwg, vname))<0) {
            db_perror(vname, E_CALLFAIL, me);
@@ -8182,7 +9828,10 @@ db_hdf5_ReadVarSlice(DBfile *_dbfile, char const *vname, int const *offset, int
            P_rdprops = P_ckrdprops;
 
        /* Read the data */
-       if (H5Dread(dset, mtype, mspace, fspace, P_rdprops, result)<0) {
+       if ((tiled=db_hdf5_read_tiles(dset, mtype, ndims, offset, length,
+                                     stride, result))<0 ||
+           (!tiled &&
+            db_hdf5_Dread(dset, mtype, mspace, fspace, P_rdprops, result)<0)) {
            hdf5_to_silo_error(vname, me);
            UNWIND();
        }
@@ -8236,6 +9885,8 @@ db_hdf5_ReadVarVals(DBfile *_dbfile, char const *vname, int mode,
        int dscount; char **dsnames = 0; char *p;
        hsize_t _dscount, _nvals;
 
+       db_hdf5_async_finish(dbfile);
+
        if (db_hdf5_get_obj_dsnames(_dbfile, vname, &dscount, &dsnames) < 0) {
            db_perror(vname, E_CALLFAIL, me);
            UNWIND();
@@ -8303,7 +9954,7 @@ db_hdf5_ReadVarVals(DBfile *_dbfile, char const *vname, int mode,
            }
 
            /* Read the data */
-           if (H5Dread(dset, mtype, mspace, fspace, P_rdprops, p)<0) {
+           if (db_hdf5_Dread(dset, mtype, mspace, fspace, P_rdprops, p)<0) {
                hdf5_to_silo_error(vname, me);
                UNWIND();
            }
@@ -8367,9 +10018,11 @@ db_hdf5_WriteCKZ(DBfile *_dbfile, char const *vname, void const *var,
    hid_t        mtype=-1, ftype=-1, space=-1, dset=-1, dset_type=-1;
    hsize_t      ds_size[H5S_MAX_RANK];
    H5T_class_t  fclass, mclass;
-   int          i;
+   int          i, created = 0, tiled = 0;
 
    PROTECT {
+       db_hdf5_put_context(dbfile, DB_VARIABLE, vname);
+       db_hdf5_async_finish(dbfile);
        /* Create the memory and file data type */
        if ((mtype=silom2hdfm_type(datatype))<0 ||
            (ftype=silof2hdff_type(dbfile, datatype))<0) {
@@ -8409,7 +10062,7 @@ db_hdf5_WriteCKZ(DBfile *_dbfile, char const *vname, void const *var,
 
            if (nofilters == 0)
            {
-               if (db_hdf5_set_properties(_dbfile, ndims, ds_size) < 0 ) {
+               if (db_hdf5_set_properties(_dbfile, datatype, ndims, ds_size, 0, var) < 0 ) {
                    db_perror("db_hdf5_set_properties", E_CALLFAIL, me);
                    UNWIND();
                }
@@ -8419,6 +10072,7 @@ db_hdf5_WriteCKZ(DBfile *_dbfile, char const *vname, void const *var,
                    db_perror(vname, E_CALLFAIL, me);
                    UNWIND();
                }
+               created = 1;
            }
            else
            {
@@ -8450,7 +10104,11 @@ db_hdf5_WriteCKZ(DBfile *_dbfile, char const *vname, void const *var,
 #endif
 
        /* Write data */
-       if (H5Dwrite(dset, mtype, space, space, H5P_DEFAULT, var)<0) {
+       if (created && (tiled = db_hdf5_write_tiles(dset, mtype, var)) < 0) {
+           db_perror(vname, E_CALLFAIL, me);
+           UNWIND();
+       }
+       if (!tiled && db_hdf5_Dwrite(dset, mtype, space, space, H5P_DEFAULT, var)<0) {
            db_perror(vname, E_CALLFAIL, me);
            UNWIND();
        }
@@ -8508,6 +10166,8 @@ db_hdf5_WriteSlice(
    int          i;
 
    PROTECT {
+       db_hdf5_put_context(dbfile, DB_VARIABLE, vname);
+       db_hdf5_async_finish(dbfile);
        if ((mtype=silom2hdfm_type(dtype))<0 ||
            (ftype=silof2hdff_type(dbfile, dtype))<0) {
            db_perror("datatype", E_BADARGS, me);
@@ -8543,7 +10203,7 @@ db_hdf5_WriteSlice(
                UNWIND();
            }
 
-           if (db_hdf5_set_properties(_dbfile, ndims, ds_size) < 0 ) {
+           if (db_hdf5_set_properties(_dbfile, dtype, ndims, ds_size, 0, 0) < 0 ) {
                db_perror("db_hdf5_set_properties", E_CALLFAIL, me);
                UNWIND();
            }
@@ -8589,7 +10249,7 @@ db_hdf5_WriteSlice(
        }
 
        /* Write data */
-       if (H5Dwrite(dset, mtype, mspace, fspace, H5P_DEFAULT, values)<0) {
+       if (db_hdf5_Dwrite(dset, mtype, mspace, fspace, H5P_DEFAULT, values)<0) {
            db_perror(vname, E_CALLFAIL, me);
            UNWIND();
        }
@@ -8844,6 +10504,7 @@ db_hdf5_PutCurve(DBfile *_dbfile, char const *name, void const *xvals, void cons
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_CURVE, name);
         /* Check datatype */
         if (DB_FLOAT!=dtype && DB_DOUBLE!=dtype) {
             db_perror("invalid floating-point datatype", E_BADARGS, me);
@@ -8965,7 +10626,7 @@ db_hdf5_GetCurve(DBfile *_dbfile, char const *name)
         /* Read the curve data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBcurve_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBcurve_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -9002,8 +10663,8 @@ db_hdf5_GetCurve(DBfile *_dbfile, char const *name)
                 cu->x = NULL;
                 cu->y = NULL;
             } else {
-                cu->x = db_hdf5_comprd(dbfile, m.xvarname, 0);
-                cu->y = db_hdf5_comprd(dbfile, m.yvarname, 0);
+                cu->x = db_hdf5_comprd_bulk(dbfile, m.xvarname, 0);
+                cu->y = db_hdf5_comprd_bulk(dbfile, m.yvarname, 0);
             }
         }
         H5Tclose(o);
@@ -9060,6 +10721,7 @@ db_hdf5_PutCsgmesh(DBfile *_dbfile, char const *name, int ndims,
     memset(&m, 0, sizeof m); 
     
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_CSGMESH, name);
 
         /* Set global options */
         db_ResetGlobalData_Csgmesh();
@@ -9203,7 +10865,7 @@ db_hdf5_GetCsgmesh(DBfile *_dbfile, char const *name)
         /* Read header into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBcsgmesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBcsgmesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror((char*)name, E_CALLFAIL, me);
             UNWIND();
@@ -9313,6 +10975,7 @@ db_hdf5_PutCsgvar(DBfile *_dbfile, char const *vname, char const *meshname,
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_CSGVAR, vname);
         db_ResetGlobalData_Csgmesh();
         strcpy(_csgm._meshname, meshname);
         db_ProcessOptlist(DB_CSGMESH, optlist);
@@ -9437,7 +11100,7 @@ db_hdf5_GetCsgvar(DBfile *_dbfile, char const *name)
         /* Read ucdvar data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBcsgvar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBcsgvar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror((char*)name, E_CALLFAIL, me);
             UNWIND();
@@ -9475,7 +11138,7 @@ db_hdf5_GetCsgvar(DBfile *_dbfile, char const *name)
         {
             csgv->vals = (void **)calloc(m.nvals, sizeof(void*));
             for (i=0; i<m.nvals; i++) {
-                csgv->vals[i] = db_hdf5_comprd(dbfile, m.vals[i], 0);
+                csgv->vals[i] = db_hdf5_comprd_bulk(dbfile, m.vals[i], 0);
             }
         }
 
@@ -9528,6 +11191,7 @@ db_hdf5_PutCSGZonelist(DBfile *_dbfile, char const *name, int nregs,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_CSGZONELIST, name);
         /* Set global options */
         memset(&_csgzl, 0, sizeof _csgzl);
         if (db_ProcessOptlist(DB_CSGZONELIST, optlist)<0) {
@@ -9655,7 +11319,7 @@ db_hdf5_GetCSGZonelist(DBfile *_dbfile, char const *name)
         /* Read zonelist data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBcsgzonelist_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBcsgzonelist_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror((char*)name, E_CALLFAIL, me);
             UNWIND();
@@ -9776,6 +11440,7 @@ db_hdf5_PutDefvars(
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_DEFVARS, name);
 
         DBStringArrayToStringList((char const * const *)names, ndefs, &s, &len);
         db_hdf5_compwr(dbfile, DB_CHAR, 1, &len, s, m.names/*out*/,
@@ -9869,7 +11534,7 @@ db_hdf5_GetDefvars(DBfile *_dbfile, char const *name)
         /* Read the data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBdefvars_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBdefvars_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror((char*)name, E_CALLFAIL, me);
             UNWIND();
@@ -9992,6 +11657,8 @@ db_hdf5_PutQuadmesh(DBfile *_dbfile, char const *name, char const * const *coord
     }
     
     PROTECT {
+        db_hdf5_put_context(dbfile, coordtype == DB_COLLINEAR ?
+            DB_QUAD_RECT : DB_QUAD_CURV, name);
         /* Check datatype */
         if (DB_FLOAT!=datatype && DB_DOUBLE!=datatype) {
             db_perror("invalid floating-point datatype", E_BADARGS, me);
@@ -10246,7 +11913,7 @@ db_hdf5_GetQuadmesh(DBfile *_dbfile, char const *name)
         /* Read quadmesh data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBquadmesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBquadmesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -10300,7 +11967,7 @@ db_hdf5_GetQuadmesh(DBfile *_dbfile, char const *name)
         /* Read coordinate arrays */
         for (i=0; i<qm->ndims; i++) {
             if (DBGetDataReadMask2File(_dbfile) & DBQMCoords)
-                qm->coords[i] = db_hdf5_comprd(dbfile, m.coord[i], 0);
+                qm->coords[i] = db_hdf5_comprd_bulk(dbfile, m.coord[i], 0);
         }
 
         if (DBGetDataReadMask2File(_dbfile) & DBQMGhostNodeLabels)
@@ -10438,6 +12105,7 @@ db_hdf5_PutQuadvar(DBfile *_dbfile, char const *name, char const *meshname, int
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_QUADVAR, name);
         /* Set global options */
         _qm._coord_sys = DB_OTHER;
         _qm._facetype = DB_RECTILINEAR;
@@ -10680,7 +12348,7 @@ db_hdf5_GetQuadvar(DBfile *_dbfile, char const *name)
         /* Read quadvar data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBquadvar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBquadvar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -10731,9 +12399,9 @@ db_hdf5_GetQuadvar(DBfile *_dbfile, char const *name)
             qv->vals = (void **)calloc(m.nvals, sizeof(void*));
             if (m.mixlen) qv->mixvals = (void **)calloc(m.nvals, sizeof(void*));
             for (i=0; i<m.nvals; i++) {
-                qv->vals[i] = db_hdf5_comprd(dbfile, m.value[i], 0);
+                qv->vals[i] = db_hdf5_comprd_bulk(dbfile, m.value[i], 0);
                 if (m.mixlen && m.mixed_value[i][0]) {
-                    qv->mixvals[i] = db_hdf5_comprd(dbfile, m.mixed_value[i], 0);
+                    qv->mixvals[i] = db_hdf5_comprd_bulk(dbfile, m.mixed_value[i], 0);
                 }
             }
         }
@@ -10846,6 +12514,7 @@ db_hdf5_PutUcdmesh(DBfile *_dbfile, char const *name, int ndims, char const * co
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_UCDMESH, name);
         /* Check datatype */
         if (DB_FLOAT!=datatype && DB_DOUBLE!=datatype) {
             db_perror("invalid floating-point datatype", E_BADARGS, me);
@@ -11021,6 +12690,7 @@ db_hdf5_PutUcdsubmesh(DBfile *_dbfile, char const *name, char const *parentmesh,
     DBucdmesh_mt        m;
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_UCDMESH, name);
         /* Get metadata from the parent UCD mesh */
         if ((o=H5Topen(dbfile->cwg, parentmesh))<0) {
             db_perror(name, E_NOTFOUND, me);
@@ -11038,7 +12708,7 @@ db_hdf5_PutUcdsubmesh(DBfile *_dbfile, char const *name, char const *parentmesh,
         }
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBucdmesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBucdmesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -11210,7 +12880,7 @@ db_hdf5_GetUcdmesh(DBfile *_dbfile, char const *name)
         /* Read header into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBucdmesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBucdmesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -11299,11 +12969,11 @@ db_hdf5_GetUcdmesh(DBfile *_dbfile, char const *name)
         if (DBGetDataReadMask2File(_dbfile) & DBUMCoords)
         {
             for (i=0; i<m.ndims; i++) {
-                um->coords[i] = db_hdf5_comprd(dbfile, m.coord[i], 0);
+                um->coords[i] = db_hdf5_comprd_bulk(dbfile, m.coord[i], 0);
             }
         }
         if (DBGetDataReadMask2File(_dbfile) & DBUMGlobNodeNo)
-            um->gnodeno = db_hdf5_comprd(dbfile, m.gnodeno, 1);
+            um->gnodeno = db_hdf5_comprd_bulk(dbfile, m.gnodeno, 1);
         um->gnznodtype = m.gnznodtype?m.gnznodtype:DB_INT;
         if (DBGetDataReadMask2File(_dbfile) & DBUMGhostNodeLabels)
             um->ghost_node_labels = (char *)db_hdf5_comprd(dbfile, m.ghost_node_labels, 1);
@@ -11428,6 +13098,7 @@ db_hdf5_PutUcdvar(DBfile *_dbfile, char const *name, char const *meshname, int n
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_UCDVAR, name);
         /* Set global options  - based on previous PutUcdmesh() call */
         saved_ndims = _um._ndims;
         saved_nnodes = _um._nnodes;
@@ -11661,7 +13332,7 @@ db_hdf5_GetUcdvar(DBfile *_dbfile, char const *name)
         /* Read ucdvar data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBucdvar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBucdvar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -11705,9 +13376,9 @@ db_hdf5_GetUcdvar(DBfile *_dbfile, char const *name)
             uv->vals = (void **)calloc(m.nvals, sizeof(void*));
             if (m.mixlen) uv->mixvals = (void **)calloc(m.nvals, sizeof(void*));
             for (i=0; i<m.nvals; i++) {
-                uv->vals[i] = db_hdf5_comprd(dbfile, m.value[i], 0);
+                uv->vals[i] = db_hdf5_comprd_bulk(dbfile, m.value[i], 0);
                 if (m.mixlen && m.mixed_value[i][0]) {
-                    uv->mixvals[i] = db_hdf5_comprd(dbfile, m.mixed_value[i], 0);
+                    uv->mixvals[i] = db_hdf5_comprd_bulk(dbfile, m.mixed_value[i], 0);
                 }
             }
         }
@@ -11771,6 +13442,7 @@ db_hdf5_PutFacelist(
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_FACELIST, name);
         /* Write variable arrays */
         if (lnodelist) {
             db_hdf5_compwr(dbfile, DB_INT, 1, &lnodelist, nodelist,
@@ -11874,7 +13546,7 @@ db_hdf5_GetFacelist(DBfile *_dbfile, char const *name)
         /* Read facelist data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBfacelist_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBfacelist_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -11892,12 +13564,12 @@ db_hdf5_GetFacelist(DBfile *_dbfile, char const *name)
         /* Read the raw data */
         if (DBGetDataReadMask2File(_dbfile) & DBFacelistInfo)
         {
-            fl->nodelist = (int *)db_hdf5_comprd(dbfile, m.nodelist, 1);
+            fl->nodelist = (int *)db_hdf5_comprd_bulk(dbfile, m.nodelist, 1);
             fl->shapecnt = (int *)db_hdf5_comprd(dbfile, m.shapecnt, 1);
             fl->shapesize = (int *)db_hdf5_comprd(dbfile, m.shapesize, 1);
             fl->typelist = (int *)db_hdf5_comprd(dbfile, m.typelist, 1);
             fl->types = (int *)db_hdf5_comprd(dbfile, m.types, 1);
-            fl->zoneno = (int *)db_hdf5_comprd(dbfile, m.zoneno, 1);
+            fl->zoneno = (int *)db_hdf5_comprd_bulk(dbfile, m.zoneno, 1);
         }
 
         H5Tclose(o);
@@ -12083,6 +13755,7 @@ db_hdf5_PutZonelist2(DBfile *_dbfile, char const *name, int nzones, int ndims,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_ZONELIST, name);
         /* Set global options */
         memset(&_uzl, 0, sizeof _uzl);
         db_ProcessOptlist(DB_ZONELIST, optlist);
@@ -12201,6 +13874,7 @@ db_hdf5_PutPHZonelist(DBfile *_dbfile, char const *name,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_PHZONELIST, name);
         /* Set global options */
         memset(&_phzl, 0, sizeof _phzl);
         db_ProcessOptlist(DB_PHZONELIST, optlist);
@@ -12362,7 +14036,7 @@ db_hdf5_GetZonelist(DBfile *_dbfile, char const *name)
         /* Read zonelist data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBzonelist_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBzonelist_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -12388,10 +14062,10 @@ db_hdf5_GetZonelist(DBfile *_dbfile, char const *name)
             zl->shapecnt = (int *)db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.shapecnt), 1);
             zl->shapesize = (int *)db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.shapesize), 1);
             zl->shapetype = (int *)db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.shapetype), 1);
-            zl->nodelist = (int *)db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.nodelist), 1);
+            zl->nodelist = (int *)db_hdf5_comprd_bulk(dbfile, db_hdf5_resolvename(_dbfile, name, m.nodelist), 1);
         }
         if (DBGetDataReadMask2File(_dbfile) & DBZonelistGlobZoneNo)
-            zl->gzoneno = db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.gzoneno), 1);
+            zl->gzoneno = db_hdf5_comprd_bulk(dbfile, db_hdf5_resolvename(_dbfile, name, m.gzoneno), 1);
         zl->gnznodtype = m.gnznodtype?m.gnznodtype:DB_INT;
         if (DBGetDataReadMask2File(_dbfile) & DBZonelistGhostZoneLabels)
             zl->ghost_zone_labels = (char *)db_hdf5_comprd(dbfile, db_hdf5_resolvename(_dbfile, name, m.ghost_zone_labels), 1);
@@ -12468,7 +14142,7 @@ db_hdf5_GetPHZonelist(DBfile *_dbfile, char const *name)
         /* Read phzonelist data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBphzonelist_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBphzonelist_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -12487,14 +14161,14 @@ db_hdf5_GetPHZonelist(DBfile *_dbfile, char const *name)
 
         if (DBGetDataReadMask2File(_dbfile) & DBZonelistInfo)
         {
-            phzl->nodecnt = (int *)db_hdf5_comprd(dbfile, m.nodecnt, 1);
-            phzl->nodelist = (int *)db_hdf5_comprd(dbfile, m.nodelist, 1);
+            phzl->nodecnt = (int *)db_hdf5_comprd_bulk(dbfile, m.nodecnt, 1);
+            phzl->nodelist = (int *)db_hdf5_comprd_bulk(dbfile, m.nodelist, 1);
             phzl->extface = (char *)db_hdf5_comprd(dbfile, m.extface, 1);
-            phzl->facecnt = (int *)db_hdf5_comprd(dbfile, m.facecnt, 1);
-            phzl->facelist = (int  *)db_hdf5_comprd(dbfile, m.facelist, 1);
+            phzl->facecnt = (int *)db_hdf5_comprd_bulk(dbfile, m.facecnt, 1);
+            phzl->facelist = (int  *)db_hdf5_comprd_bulk(dbfile, m.facelist, 1);
         }
         if (DBGetDataReadMask2File(_dbfile) & DBZonelistGlobZoneNo)
-            phzl->gzoneno = db_hdf5_comprd(dbfile, m.gzoneno, 1);
+            phzl->gzoneno = db_hdf5_comprd_bulk(dbfile, m.gzoneno, 1);
         if (DBGetDataReadMask2File(_dbfile) & DBZonelistGhostZoneLabels)
             phzl->ghost_zone_labels = (char *)db_hdf5_comprd(dbfile, m.ghost_zone_labels, 1);
 
@@ -12582,6 +14256,7 @@ db_hdf5_PutMaterial(
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MATERIAL, name);
         /* Set global options */
         db_ProcessOptlist(DB_MATERIAL, optlist);
         nels = 1;
@@ -12722,7 +14397,7 @@ db_hdf5_GetMaterial(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmaterial_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmaterial_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -12752,15 +14427,15 @@ db_hdf5_GetMaterial(DBfile *_dbfile, char const *name)
 
         /* Read the raw data */
         if (DBGetDataReadMask2File(_dbfile) & DBMatMatlist)
-            ma->matlist = (int *)db_hdf5_comprd(dbfile, m.matlist, 1);
+            ma->matlist = (int *)db_hdf5_comprd_bulk(dbfile, m.matlist, 1);
         if (DBGetDataReadMask2File(_dbfile) & DBMatMatnos)
             ma->matnos = (int *)db_hdf5_comprd(dbfile, m.matnos, 1);
         if (DBGetDataReadMask2File(_dbfile) & DBMatMixList)
         {
-            ma->mix_vf = db_hdf5_comprd(dbfile, m.mix_vf, 0);
-            ma->mix_next = (int *)db_hdf5_comprd(dbfile, m.mix_next, 1);
-            ma->mix_mat = (int *)db_hdf5_comprd(dbfile, m.mix_mat, 1);
-            ma->mix_zone = (int *)db_hdf5_comprd(dbfile, m.mix_zone, 1);
+            ma->mix_vf = db_hdf5_comprd_bulk(dbfile, m.mix_vf, 0);
+            ma->mix_next = (int *)db_hdf5_comprd_bulk(dbfile, m.mix_next, 1);
+            ma->mix_mat = (int *)db_hdf5_comprd_bulk(dbfile, m.mix_mat, 1);
+            ma->mix_zone = (int *)db_hdf5_comprd_bulk(dbfile, m.mix_zone, 1);
         }
         if (DBGetDataReadMask2File(_dbfile) & DBMatMatnames)
         {
@@ -12839,6 +14514,7 @@ db_hdf5_PutMatspecies(DBfile *_dbfile, char const *name, char const *matname, in
     
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MATSPECIES, name);
         /* Set global options */
         db_ProcessOptlist(DB_MATSPECIES, optlist);
 
@@ -12978,7 +14654,7 @@ db_hdf5_GetMatspecies(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmatspecies_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmatspecies_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -13005,9 +14681,9 @@ db_hdf5_GetMatspecies(DBfile *_dbfile, char const *name)
 
         /* Read the raw data */
         ms->nmatspec = (int *)db_hdf5_comprd(dbfile, m.nmatspec, 1);
-        ms->species_mf = db_hdf5_comprd(dbfile, m.species_mf, 0);
-        ms->speclist = (int *)db_hdf5_comprd(dbfile, m.speclist, 1);
-        ms->mix_speclist = (int *)db_hdf5_comprd(dbfile, m.mix_speclist, 1);
+        ms->species_mf = db_hdf5_comprd_bulk(dbfile, m.species_mf, 0);
+        ms->speclist = (int *)db_hdf5_comprd_bulk(dbfile, m.speclist, 1);
+        ms->mix_speclist = (int *)db_hdf5_comprd_bulk(dbfile, m.mix_speclist, 1);
         if (ms->nmatspec && (DBGetDataReadMask2File(_dbfile) & DBMatMatnames))
         {
             for (i=0; i < ms->nmat; i++)
@@ -13093,6 +14769,7 @@ db_hdf5_PutMultimesh(DBfile *_dbfile, char const *name, int nmesh,
     
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MULTIMESH, name);
         /* Set global options */
         db_ResetGlobalData_MultiMesh();
         db_ProcessOptlist(DB_MULTIMESH, optlist);
@@ -13308,7 +14985,7 @@ db_hdf5_GetMultimesh(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmultimesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmultimesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -13451,6 +15128,8 @@ db_hdf5_PutMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
        lneighbors += nneighbors[i];
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MULTIMESHADJ, name);
+        db_hdf5_async_finish(dbfile);
 
        H5E_BEGIN_TRY {
            o = H5Topen(dbfile->cwg, name);
@@ -13472,7 +15151,7 @@ db_hdf5_PutMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
 
             /* Read meta data into memory */
             if ((attr=H5Aopen_name(o, "silo"))<0 ||
-                H5Aread(attr, DBmultimeshadj_mt5, &m)<0 ||
+                db_hdf5_hdrrd_attr(attr, DBmultimeshadj_mt5, &m)<0 ||
                 H5Aclose(attr)<0) {
                 db_perror((char*)name, E_CALLFAIL, me);
                 UNWIND();
@@ -13630,7 +15309,7 @@ db_hdf5_PutMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
                }
 
                /* Write data */
-               if (H5Dwrite(nldset, mtype, mspace, fspace, H5P_DEFAULT, nodelists[i])<0) {
+               if (db_hdf5_Dwrite(nldset, mtype, mspace, fspace, H5P_DEFAULT, nodelists[i])<0) {
                    db_perror("partial write", E_CALLFAIL, me);
                    UNWIND();
                }
@@ -13664,7 +15343,7 @@ db_hdf5_PutMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
                }
 
                /* Write data */
-               if (H5Dwrite(zldset, mtype, mspace, fspace, H5P_DEFAULT, zonelists[i])<0) {
+               if (db_hdf5_Dwrite(zldset, mtype, mspace, fspace, H5P_DEFAULT, zonelists[i])<0) {
                    db_perror("partial write", E_CALLFAIL, me);
                    UNWIND();
                }
@@ -13716,6 +15395,7 @@ db_hdf5_GetMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
     int                 *offsetmap, *offsetmapn=0, *offsetmapz=0, lneighbors, tmpoff;
 
     PROTECT {
+        db_hdf5_async_finish(dbfile);
         /* Open object and make sure it's a multimesh */
         if ((o=H5Topen(dbfile->cwg, name))<0) {
             db_perror((char*)name, E_NOTFOUND, me);
@@ -13735,7 +15415,7 @@ db_hdf5_GetMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmultimeshadj_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmultimeshadj_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror((char*)name, E_CALLFAIL, me);
             UNWIND();
@@ -13858,7 +15538,7 @@ db_hdf5_GetMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
                      P_rdprops = P_ckrdprops;
 
                  /* Read data */
-                 if (H5Dread(nldset, mtype, mspace, fspace, P_rdprops, nlist)<0) {
+                 if (db_hdf5_Dread(nldset, mtype, mspace, fspace, P_rdprops, nlist)<0) {
                      FREE(offsetmap); FREE(offsetmapn); FREE(offsetmapz);
                      DBFreeMultimeshadj(mmadj);
                      hdf5_to_silo_error(name, me);
@@ -13906,7 +15586,7 @@ db_hdf5_GetMultimeshadj(DBfile *_dbfile, char const *name, int nmesh,
                      P_rdprops = P_ckrdprops;
 
                  /* Read data */
-                 if (H5Dread(zldset, mtype, mspace, fspace, P_rdprops, zlist)<0) {
+                 if (db_hdf5_Dread(zldset, mtype, mspace, fspace, P_rdprops, zlist)<0) {
                      FREE(offsetmap); FREE(offsetmapn); FREE(offsetmapz);
                      DBFreeMultimeshadj(mmadj);
                      hdf5_to_silo_error(name, me);
@@ -13996,6 +15676,7 @@ db_hdf5_PutMultivar(DBfile *_dbfile, char const *name, int nvars, char const * c
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MULTIVAR, name);
 
         /* Set global options */
         db_ResetGlobalData_MultiMesh();
@@ -14191,7 +15872,7 @@ db_hdf5_GetMultivar(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmultivar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmultivar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -14294,6 +15975,7 @@ db_hdf5_PutMultimat(DBfile *_dbfile, char const *name, int nmats, char const * c
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MULTIMAT, name);
         /* Set global options */
         db_ResetGlobalData_MultiMesh();
         db_ProcessOptlist(DB_MULTIMESH, optlist);
@@ -14488,7 +16170,7 @@ db_hdf5_GetMultimat(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmultimat_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmultimat_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -14592,6 +16274,7 @@ db_hdf5_PutMultimatspecies(DBfile *_dbfile, char const *name, int nspec,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MULTIMATSPECIES, name);
         /* Set global options */
         db_ResetGlobalData_MultiMesh();
         db_ProcessOptlist(DB_MULTIMESH, optlist);
@@ -14772,7 +16455,7 @@ db_hdf5_GetMultimatspecies(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmultimatspecies_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmultimatspecies_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -14883,6 +16566,7 @@ db_hdf5_PutPointmesh(DBfile *_dbfile, char const *name, int ndims, DBVCP2_t _coo
     
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_POINTMESH, name);
         /* Check datatype */
         if (DB_FLOAT!=datatype && DB_DOUBLE!=datatype) {
             db_perror("invalid floating-point datatype", E_BADARGS, me);
@@ -15054,7 +16738,7 @@ db_hdf5_GetPointmesh(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBpointmesh_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBpointmesh_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -15094,11 +16778,11 @@ db_hdf5_GetPointmesh(DBfile *_dbfile, char const *name)
         if (DBGetDataReadMask2File(_dbfile) & DBPMCoords)
         {
             for (i=0; i<m.ndims; i++) {
-                pm->coords[i] = db_hdf5_comprd(dbfile, m.coord[i], 0);
+                pm->coords[i] = db_hdf5_comprd_bulk(dbfile, m.coord[i], 0);
             }
         }
         if (DBGetDataReadMask2File(_dbfile) & DBPMGlobNodeNo)
-            pm->gnodeno = db_hdf5_comprd(dbfile, m.gnodeno, 1);
+            pm->gnodeno = db_hdf5_comprd_bulk(dbfile, m.gnodeno, 1);
         pm->gnznodtype = m.gnznodtype?m.gnznodtype:DB_INT;
 
         if (DBGetDataReadMask2File(_dbfile) & DBPMGhostNodeLabels)
@@ -15166,6 +16850,7 @@ db_hdf5_PutPointvar(DBfile *_dbfile, char const *name, char const *meshname, int
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_POINTVAR, name);
         /* Set global options */
         saved_ndims = _pm._ndims;
         memset(&_pm, 0, sizeof _pm);
@@ -15310,7 +16995,7 @@ db_hdf5_GetPointvar(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBpointvar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBpointvar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -15351,7 +17036,7 @@ db_hdf5_GetPointvar(DBfile *_dbfile, char const *name)
         {
             pv->vals = (void **)calloc(m.nvals, sizeof(void*));
             for (i=0; i<m.nvals; i++) {
-                pv->vals[i] = db_hdf5_comprd(dbfile, m.data[i], 0);
+                pv->vals[i] = db_hdf5_comprd_bulk(dbfile, m.data[i], 0);
             }
         }
 
@@ -15409,6 +17094,7 @@ db_hdf5_PutCompoundarray(
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_ARRAY, name);
         /*
          * Create a character string which is a semi-colon separated list of
          * component names.
@@ -15504,7 +17190,7 @@ db_hdf5_GetCompoundarray(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBcompoundarray_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBcompoundarray_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -15731,6 +17417,7 @@ db_hdf5_PutMrgtree(DBfile *_dbfile, char const *name, char const *mesh_name,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MRGTREE, name);
 
         /* Set global options */
         db_ResetGlobalData_Mrgtree();
@@ -15985,7 +17672,7 @@ db_hdf5_GetMrgtree(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmrgtree_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmrgtree_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -16176,6 +17863,7 @@ db_hdf5_PutGroupelmap(DBfile *_dbfile, char const *name,
 
     memset(&m, 0, sizeof m);
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_GROUPELMAP, name);
         /* Set global options */
         db_ProcessOptlist(DB_GROUPELMAP, opts);
 
@@ -16317,7 +18005,7 @@ db_hdf5_GetGroupelmap(DBfile *_dbfile, char const *name)
         /* Read meta data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBgroupelmap_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBgroupelmap_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -16433,6 +18121,7 @@ db_hdf5_PutMrgvar(DBfile *_dbfile, char const *name,
     memset(&m, 0, sizeof m);
 
     PROTECT {
+        db_hdf5_put_context(dbfile, DB_MRGVAR, name);
 
         db_ProcessOptlist(DB_MRGVAR, optlist);
 
@@ -16539,7 +18228,7 @@ db_hdf5_GetMrgvar(DBfile *_dbfile, char const *name)
         /* Read ucdvar data into memory */
         memset(&m, 0, sizeof m);
         if ((attr=H5Aopen_name(o, "silo"))<0 ||
-            H5Aread(attr, DBmrgvar_mt5, &m)<0 ||
+            db_hdf5_hdrrd_attr(attr, DBmrgvar_mt5, &m)<0 ||
             H5Aclose(attr)<0) {
             db_perror(name, E_CALLFAIL, me);
             UNWIND();
@@ -16603,6 +18292,13 @@ db_hdf5_FreeCompressionResources(DBfile *_dbfile, char const *meshname)
  *
  * Programmer: Mark C. Miller, Thu Jul 15 07:42:46 PDT 2010
  *
+ * Modifications:
+ *   Use the object header address from H5Gget_objinfo rather than
+ *   H5Dopen'ing each name. Silo objects are named datatypes, not
+ *   datasets, so the H5Dopen failed for them and left them unsorted.
+ *   This also no longer opens and closes every dataset. An object's
+ *   component datasets are written just ahead of its header, so the
+ *   header address orders its data too.
  *-------------------------------------------------------------------------
  */
 
@@ -16644,11 +18340,19 @@ db_hdf5_SortObjectsByOffset(DBfile *_dbfile, int nobjs,
             iop[i].offset = HADDR_MAX;
         else
         {
-            hid_t dsid;
-            if ((dsid=H5Dopen(dbfile->cwg, names[i]))<0 ||
-                (iop[i].offset=H5Dget_offset(dsid))==HADDR_UNDEF ||
-                H5Dclose(dsid)<0)
+            H5G_stat_t sb;
+            herr_t status;
+            H5E_BEGIN_TRY {
+                status = H5Gget_objinfo(dbfile->cwg, names[i], TRUE, &sb);
+            } H5E_END_TRY;
+            /* objno holds the address split across two longs; two half
+               shifts keep this valid where haddr_t is no wider */
+            if (status<0)
                 iop[i].offset = HADDR_MAX;
+            else
+                iop[i].offset = (haddr_t) sb.objno[0] |
+                    (((haddr_t) sb.objno[1] << (4*sizeof(unsigned long)))
+                                            << (4*sizeof(unsigned long)));
         }
     }
 
@@ -16664,6 +18368,251 @@ db_hdf5_SortObjectsByOffset(DBfile *_dbfile, int nobjs,
     return 0;
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_prefetch_add
+ *
+ * Purpose:     Add the file ranges of the contiguous datasets that make up
+ *              object NAME to the LIST of N ranges. A dataset is added
+ *              itself. For an object, the datasets named by the string
+ *              members of its `silo' attribute are added, along with
+ *              those of the zonelist, facelist and polyhedral zonelist a
+ *              mesh reads with it. Chunked (and so filtered) datasets
+ *              have no single file range and are left out.
+ *-------------------------------------------------------------------------
+ */
+PRIVATE void
+db_hdf5_prefetch_add(DBfile_hdf5 *dbfile, char const *name, int sub,
+                     db_hdf5_range_t **list, int *n, int *nalloc)
+{
+    H5G_stat_t  sb;
+    herr_t      status;
+    hid_t       o=-1, attr=-1, atype=-1, mtype;
+    haddr_t     addr;
+    hsize_t     size;
+    char        *value=NULL, str[1024], *mname;
+    size_t      asize, ssize, off;
+    int         i, j, nmembs, ndims, dims[4], nelmts;
+
+    H5E_BEGIN_TRY {
+        status = H5Gget_objinfo(dbfile->cwg, name, TRUE, &sb);
+    } H5E_END_TRY;
+    if (status < 0)
+        return;
+
+    if (sb.type == H5G_DATASET)
+    {
+        H5E_BEGIN_TRY {
+            addr = HADDR_UNDEF;
+            size = 0;
+            if ((o = H5Dopen(dbfile->cwg, name)) >= 0)
+            {
+                addr = H5Dget_offset(o);
+                size = H5Dget_storage_size(o);
+                H5Dclose(o);
+            }
+        } H5E_END_TRY;
+        if (addr == HADDR_UNDEF || size == 0)
+            return;
+        if (*n == *nalloc)
+        {
+            *nalloc = *nalloc ? 2 * *nalloc : 64;
+            *list = REALLOC_N(*list, db_hdf5_range_t, *nalloc);
+        }
+        (*list)[*n].addr = addr;
+        (*list)[*n].size = (size_t) size;
+        (*list)[*n].buf  = NULL;
+        (*n)++;
+        return;
+    }
+    if (sb.type != H5G_TYPE)
+        return;
+
+    H5E_BEGIN_TRY {
+        if ((o = H5Topen(dbfile->cwg, name)) >= 0 &&
+            (attr = H5Aopen_name(o, "silo")) >= 0 &&
+            (atype = H5Aget_type(attr)) >= 0 &&
+            (asize = H5Tget_size(atype)) > 0 &&
+            (value = (char *) calloc(1, asize)) != NULL &&
+            H5Aread(attr, atype, value) >= 0)
+        {
+            nmembs = H5Tget_nmembers(atype);
+            for (i = 0; i < nmembs; i++)
+            {
+                if ((mtype = db_hdf5_get_cmemb(atype, i, &ndims, dims)) < 0)
+                    continue;
+                if (H5Tget_class(mtype) == H5T_STRING &&
+                    H5Tis_variable_str(mtype) <= 0)
+                {
+                    mname = H5Tget_member_name(atype, i);
+                    off = H5Tget_member_offset(atype, i);
+                    ssize = H5Tget_size(mtype);
+                    for (nelmts = 1, j = 0; j < ndims; j++) nelmts *= dims[j];
+                    for (j = 0; j < nelmts && off + ssize <= asize; j++, off += ssize)
+                    {
+                        memcpy(str, value + off, MIN(ssize, sizeof(str) - 1));
+                        str[MIN(ssize, sizeof(str) - 1)] = '\0';
+                        if (!str[0])
+                            continue;
+                        if (!sub && mname &&
+                            (!strcmp(mname, "zonelist") ||
+                             !strcmp(mname, "facelist") ||
+                             !strcmp(mname, "phzonelist")))
+                            db_hdf5_prefetch_add(dbfile,
+                                db_hdf5_resolvename((DBfile *) dbfile, name, str),
+                                1, list, n, nalloc);
+                        else
+                            db_hdf5_prefetch_add(dbfile, str, 1, list, n, nalloc);
+                    }
+                    if (mname)
+                        free(mname);
+                }
+                H5Tclose(mtype);
+            }
+        }
+        if (atype >= 0) H5Tclose(atype);
+        if (attr >= 0) H5Aclose(attr);
+        if (o >= 0) H5Tclose(o);
+    } H5E_END_TRY;
+    FREE(value);
+}
+
+/* Support function for db_hdf5_Prefetch */
+static int compare_range(void const *a1, void const *a2)
+{
+    db_hdf5_range_t const *r1 = (db_hdf5_range_t const *) a1;
+    db_hdf5_range_t const *r2 = (db_hdf5_range_t const *) a2;
+    if (r1->addr < r2->addr) return -1;
+    else if (r1->addr > r2->addr) return 1;
+    else return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_hdf5_Prefetch
+ *
+ * Purpose:     Read ahead the raw data of a batch of objects for
+ *              DBGetObjects. The file ranges of their contiguous datasets
+ *              are sorted, and ranges less than DB_HDF5_PREFETCH_GAP
+ *              bytes apart are merged and read with one pread() each.
+ *              db_hdf5_comprd then copies each dataset from these
+ *              buffers instead of reading it, as it fills in the
+ *              objects. With NOBJS zero, drop the buffers.
+ *
+ *              Only files opened with the sec2 driver, the HDF5
+ *              default, are read this way, since only there file
+ *              offsets are offsets in a file descriptor. The file is
+ *              flushed first if it is open for writing.
+ *
+ * Return:      Success:        number of bytes read ahead
+ *
+ *              Failure:        -1; the objects are then read as usual
+ *-------------------------------------------------------------------------
+ */
+#define DB_HDF5_PREFETCH_GAP (64*1024)
+
+SILO_CALLBACK int
+db_hdf5_Prefetch(DBfile *_dbfile, int nobjs, char const *const *names)
+{
+    DBfile_hdf5 *dbfile = (DBfile_hdf5*)_dbfile;
+    db_hdf5_prefetch_t *pf = dbfile->prefetch;
+    db_hdf5_range_t *list = NULL, *r;
+    hid_t       fapl = -1;
+    unsigned    intent = H5F_ACC_RDONLY;
+    int         *fdp = NULL;
+    int         i, n = 0, nalloc = 0, nranges;
+    long long   nbytes = 0;
+    ssize_t     got;
+    size_t      done;
+
+    /* Drop what an earlier call read */
+    if (pf)
+    {
+        for (i = 0; i < pf->n; i++)
+            FREE(pf->ranges[i].buf);
+        FREE(pf->ranges);
+        FREE(pf);
+        dbfile->prefetch = NULL;
+    }
+    if (nobjs <= 0)
+        return 0;
+
+#if !defined(_WIN32)
+    /* Get the file descriptor of a sec2 file, with everything written */
+    if (db_hdf5_async_finish(dbfile) < 0)
+        return -1;
+    H5E_BEGIN_TRY {
+        if ((fapl = H5Fget_access_plist(dbfile->fid)) >= 0 &&
+            H5Pget_driver(fapl) == H5FD_SEC2 &&
+            H5Fget_intent(dbfile->fid, &intent) >= 0 &&
+            (intent == H5F_ACC_RDONLY ||
+             H5Fflush(dbfile->fid, H5F_SCOPE_LOCAL) >= 0) &&
+            H5Fget_vfd_handle(dbfile->fid, fapl, (void **) &fdp) < 0)
+            fdp = NULL;
+        if (fapl >= 0)
+            H5Pclose(fapl);
+    } H5E_END_TRY;
+    if (!fdp)
+        return -1;
+
+    /* Gather the datasets of all the objects and merge nearby ones */
+    for (i = 0; i < nobjs; i++)
+    {
+        if (names[i] && !strchr(names[i], ':'))
+            db_hdf5_prefetch_add(dbfile, names[i], 0, &list, &n, &nalloc);
+    }
+    if (n == 0)
+    {
+        FREE(list);
+        return 0;
+    }
+    qsort(list, n, sizeof(db_hdf5_range_t), compare_range);
+    for (i = 1, nranges = 1; i < n; i++)
+    {
+        r = &list[nranges - 1];
+        if (list[i].addr <= r->addr + r->size + DB_HDF5_PREFETCH_GAP)
+        {
+            if (list[i].addr + list[i].size > r->addr + r->size)
+                r->size = (size_t) (list[i].addr + list[i].size - r->addr);
+        }
+        else
+        {
+            list[nranges++] = list[i];
+        }
+    }
+
+    /* Read each range with one call, dropping any that can't be read */
+    pf = ALLOC(db_hdf5_prefetch_t);
+    pf->ranges = list;
+    for (i = 0, pf->n = 0; i < nranges; i++)
+    {
+        r = &list[i];
+        if (NULL == (r->buf = (unsigned char *) malloc(r->size)))
+            continue;
+        for (done = 0; done < r->size; done += (size_t) got)
+        {
+            got = pread(*fdp, r->buf + done, r->size - done,
+                        (off_t) (r->addr + done));
+            if (got <= 0 && !(got < 0 && errno == EINTR))
+                break;
+            if (got < 0)
+                got = 0;
+        }
+        if (done < r->size)
+        {
+            FREE(r->buf);
+            continue;
+        }
+        if (DB_STATS_ON)
+            db_StatRead(0, (long long) r->size);
+        nbytes += (long long) r->size;
+        list[pf->n++] = *r;
+    }
+    dbfile->prefetch = pf;
+    return (int) MIN(nbytes, INT_MAX);
+#else
+    return -1;
+#endif
+}
+
 #if HDF5_VERSION_GE(1,8,9)
 /* Definition of callbacks for file image operations. [ */
 
@@ -92,6 +92,13 @@ typedef struct DBfile_hdf5 {
     hid_t       T_double;               /*target DB_DOUBLE type         */
     hid_t       T_str256;               /*target 256-char string        */
     hid_t       (*T_str)(char*);        /*target character string       */
+    struct db_hdf5_async_t *async;      /*write-behind queue or NULL    */
+    struct db_hdf5_prefetch_t *prefetch;/*raw data read ahead or NULL   */
+    int         toc_index;              /*update toc indices at close   */
+    long long   nlinks;                 /*link group name counter       */
+    int         nlinks_state;           /*0=unread, 1=clean, 2=dirty    */
+    int         cur_objtype;            /*type of object being written  */
+    char        *cur_objname;           /*name of object being written  */
 } DBfile_hdf5;
 
 #ifndef SILO_NO_CALLBACKS
@@ -393,6 +400,8 @@ SILO_CALLBACK int db_hdf5_FreeCompressionResources(DBfile *_dbfile,
 
 SILO_CALLBACK int db_hdf5_SortObjectsByOffset(DBfile *_dbfile, int nobjs,
                  char const *const *const names, int *ordering);
+SILO_CALLBACK int db_hdf5_Prefetch(DBfile *_dbfile, int nobjs,
+                 char const *const *names);
 
 #endif /* !SILO_NO_CALLBACKS */
 
@@ -280,6 +280,10 @@ lite_PD_error(char *s, int n) {
  *      Mark C. Miller, Thu Jun 14 13:25:02 PDT 2012
  *      Remove call to io_close in ABORT case. The file pointer may not
  *      have been properly initialized.
+ *
+ *      Let appended data reuse the space of a binary symbol table.
+ *
+ *      Memory map files opened read-only when lite_PD_use_mmap is set.
  *-------------------------------------------------------------------------
  */
 PDBfile *
@@ -315,24 +319,33 @@ lite_PD_open (char *name, char *mode) {
     */
    strcpy(str, name);
 
-#ifdef PDB_WRITE
-   fp = io_open(str, BINARY_MODE_RPLUS);
+   /*
+    * Read-only files may be memory mapped.
+    */
+   fp = NULL;
+   if (lite_PD_use_mmap && (strchr(mode,'a') == NULL))
+      fp = _lite_PD_mmap_open(str);
+
    if (fp == NULL) {
-      if (strchr(mode,'r')) {
+#ifdef PDB_WRITE
+      fp = io_open(str, BINARY_MODE_RPLUS);
+      if (fp == NULL) {
+         if (strchr(mode,'r')) {
 #endif
-	 fp = io_open(str, BINARY_MODE_R);
-	 if (fp == NULL) {
-	    lite_PD_error("CAN'T OPEN FILE IN READ-ONLY MODE - PD_OPEN",
-			  PD_OPEN);
-	 }
+	    fp = io_open(str, BINARY_MODE_R);
+	    if (fp == NULL) {
+	       lite_PD_error("CAN'T OPEN FILE IN READ-ONLY MODE - PD_OPEN",
+			     PD_OPEN);
+	    }
 #ifdef PDB_WRITE
-      } else if (strchr(mode,'a')) {
-	 return lite_PD_create (name);
-      } else {
-	 lite_PD_error("CAN'T OPEN FILE - PD_OPEN", PD_OPEN);
+         } else if (strchr(mode,'a')) {
+	    return lite_PD_create (name);
+         } else {
+	    lite_PD_error("CAN'T OPEN FILE - PD_OPEN", PD_OPEN);
+         }
       }
-   }
 #endif
+   }
 
    if (lite_PD_buffer_size != -1) {
       if (io_setvbuf(fp, NULL, _IOFBF, (size_t) lite_PD_buffer_size)) {
@@ -519,6 +532,13 @@ lite_PD_open (char *name, char *mode) {
       lite_PD_error("CAN'T READ STRUCTURE CHART - PD_OPEN", PD_OPEN);
    }
 
+   /*
+    * Like the chart, the binary symbol table is rewritten by the next
+    * flush so new data may go over it.
+    */
+   if ((file->symtbaddr > 0L) && (file->symtbaddr < file->chrtaddr))
+      file->chrtaddr = file->symtbaddr;
+
    ep = lite_PD_inquire_entry(file, PDB_ATTRIBUTE_TABLE, TRUE, NULL);
    if (ep != NULL) {
       if (!lite_PD_read(file, PDB_ATTRIBUTE_TABLE, &file->attrtab)) {
@@ -1477,6 +1497,7 @@ lite_PD_target (data_standard *data, data_alignment *align) {
  *    Eric Brugger, Mon Dec  7 10:53:08 PST 1998
  *    Removed call to lite_PD_reset_ptr_list since it was removed.
  *
+ *    Write the binary symbol table ahead of the structure chart.
  *-------------------------------------------------------------------------
  */
 #ifdef PDB_WRITE
@@ -1517,6 +1538,13 @@ lite_PD_flush (PDBfile *file) {
       lite_PD_error("FSEEK FAILED TO FIND CHART  - PD_FLUSH", PD_WRITE);
    }
 
+   /*
+    * Write the binary symbol table, if any, ahead of the chart.
+    */
+   if (_lite_PD_wr_symt_bin(file) == -1L) {
+      lite_PD_error("CAN'T WRITE BINARY SYMBOL TABLE - PD_FLUSH", PD_WRITE);
+   }
+
    /*
     * Write the structure chart.
     */
@@ -1565,6 +1593,12 @@ lite_PD_flush (PDBfile *file) {
       lite_PD_error("FFLUSH FAILED AFTER HEADER - PD_FLUSH", PD_WRITE);
    }
 
+   /*
+    * New data overwrites the binary symbol table along with the chart
+    * and it is rewritten by the next flush.
+    */
+   if (file->symtbaddr > 0L) file->chrtaddr = file->symtbaddr;
+
    file->flushed = TRUE;
 
    return(TRUE);
@@ -1806,6 +1840,22 @@ int lite_PD_set_buffer_size(int s)
     return lite_PD_buffer_size;
 }
 
+/* Memory map files opened read-only instead of reading them through
+   stdio.  Takes effect for files opened afterwards. */
+int lite_PD_set_mmap(int on)
+{
+    lite_PD_use_mmap = on ? TRUE : FALSE;
+    return lite_PD_use_mmap;
+}
+
+/* Files whose symbol table has at least N entries get a binary copy
+   of it which opens much faster; N <= 0 turns this off. */
+int lite_PD_set_symt_binary_min(int n)
+{
+    lite_PD_symt_binary_min = n;
+    return lite_PD_symt_binary_min;
+}
+
 #warning MOVE TO PDLOW.C
 char *lite_PD_get_error(void)
 {
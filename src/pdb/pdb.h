@@ -125,6 +125,7 @@ extern "C" {
 #define PD_TRACE  6
 #define PD_PRINT  7
 #define PD_GENERIC 8
+#define PD_SEEK    9
 
 #define ROW_MAJOR_ORDER     101
 #define COLUMN_MAJOR_ORDER  102
@@ -277,6 +278,9 @@ struct s_PDBfile {
    long symtaddr;
    long chrtaddr;
    int ignore_apersand_ptr_ia_syms; 
+   SC_arena *symt_arena;               /* syments/dimdes read from file */
+   long symtbaddr;                     /* binary symbol table, if any */
+   long symtbsize;
 };
 
 typedef struct s_PDBfile PDBfile;
@@ -460,6 +464,9 @@ extern jmp_buf		_lite_PD_read_err ;
 extern jmp_buf		_lite_PD_trace_err ;
 extern char		lite_PD_err[] ;
 extern int		lite_PD_buffer_size ;
+extern int		lite_PD_symt_binary_min ;
+extern int		lite_PD_use_mmap ;
+extern void		(*lite_PD_io_stats_hook)(int,long) ;
 extern int		lite_FORMAT_FIELDS ;
 extern char*            lite_PD_DEF_CREATM;
 extern data_standard	lite_IEEEA_STD ;
@@ -555,14 +562,25 @@ LITE_API extern data_alignment *	_lite_PD_mk_alignment (char*);
 LITE_API extern defstr *		_lite_PD_mk_defstr (char*,memdes*,long,int,int,int,
 					    int*,long*);
 extern memdes *		_lite_PD_mk_descriptor (char*,int);
+extern dimdes *		_lite_PD_mk_arena_dimensions (SC_arena*,long,long);
+extern syment *		_lite_PD_mk_arena_syment (SC_arena*,char*,long,long,
+						  dimdes*);
 extern dimdes *		_lite_PD_mk_dimensions (long,long);
 extern PDBfile *	_lite_PD_mk_pdb (char*, const char*);
 extern data_standard *	_lite_PD_mk_standard (void);
 extern syment *		_lite_PD_mk_syment (char*,long,long,symindir*,dimdes*);
 extern int		_lite_PD_null_pointer (char*,int);
 extern int		_lite_PD_pio_close (FILE*);
+extern int		_lite_PD_pio_flush (FILE*);
+extern int		_lite_PD_pio_init (void);
+extern char		*_lite_PD_pio_map (FILE*,long);
 extern int		_lite_PD_pio_printf (FILE*,char*,...);
+extern size_t		_lite_PD_pio_read (lite_SC_byte*,size_t,size_t,FILE*);
 extern int		_lite_PD_pio_seek (FILE*,long,int);
+extern int		_lite_PD_pio_setvbuf (FILE*,char*,int,size_t);
+extern long		_lite_PD_pio_tell (FILE*);
+extern size_t		_lite_PD_pio_write (void*,size_t,size_t,FILE*);
+extern FILE		*_lite_PD_mmap_open (char*);
 extern int		_lite_PD_prim_typep (char*,HASHTAB*,int);
 extern int		_lite_PD_rd_chrt (PDBfile*);
 extern int		_lite_PD_rd_extras (PDBfile*);
@@ -613,6 +631,8 @@ LITE_API extern int      lite_PD_append_as(PDBfile *file, char *name, char *inty
 LITE_API extern int      lite_PD_append_as_alt(PDBfile *file, char *name, char *intype, void *vr, int nd, long *ind);
 /* added 21Mar17 for Collette */
 LITE_API extern int      lite_PD_set_buffer_size(int s);
+LITE_API extern int      lite_PD_set_symt_binary_min(int n);
+LITE_API extern int      lite_PD_set_mmap(int on);
 LITE_API extern char    *lite_PD_get_error(void);
 LITE_API extern syment  *lite_PD_query_entry(PDBfile *file, char *name, char *fullname);
 LITE_API extern int      lite_PD_get_entry_info(syment *ep, char **type, long *size, int *ndims, long **dims);
@@ -637,6 +657,7 @@ extern int		_lite_PD_wr_itag (PDBfile*,long,char*,long,int);
 extern void		_lite_PD_eod (PDBfile*);
 extern long		_lite_PD_wr_chrt (PDBfile*);
 extern long		_lite_PD_wr_symt (PDBfile*);
+extern long		_lite_PD_wr_symt_bin (PDBfile*);
 extern int		_lite_PD_wr_extras (PDBfile*);
 extern int		_lite_PD_rev_chrt (PDBfile*);
 extern void		_lite_PD_wr_prim_extras (FILE*,HASHTAB*,int,int);
@@ -64,8 +64,362 @@ be used for advertising or product endorsement purposes.
 #include <stdarg.h>
 #endif
 #include "pdb.h"
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Files opened read-only may be memory mapped instead of read through
+ * stdio (see lite_PD_set_mmap).  A mapped file is a PD_mapped_file cast
+ * to FILE* so the rest of PDBLib can pass it around like any stream.
+ * The _lite_PD_pio_* hooks recognize mapped files and serve them from
+ * the mapping; every other stream goes to the C library as before.
+ */
+typedef struct s_PD_mapped_file {
+   char                    *base;
+   long                     size;
+   long                     pos;
+   struct s_PD_mapped_file *next;
+} PD_mapped_file;
+
+/*
+ * Reads of at least this many bytes ask the kernel to page the range in
+ * ahead of the copy.  Smaller reads are left to the random access hint
+ * given for the whole mapping.
+ */
+#define PD_MMAP_SEQUENTIAL_MIN 65536L
+
+int			lite_PD_use_mmap = FALSE;
+
+/*
+ * If set, told about every read and write (PD_READ, PD_WRITE and the
+ * bytes moved) and every seek that moves the file position (PD_SEEK)
+ * that goes through the _lite_PD_pio_* hooks.
+ */
+void			(*lite_PD_io_stats_hook)(int,long) = NULL;
 
 static char 	Pbuffer[LRG_TXT_BUFFER];
+static PD_mapped_file	*_PD_mapped_files = NULL;
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_PD_find_mapped
+ *
+ * Purpose:	Find the mapping behind STREAM.
+ *
+ * Return:	Success:	The mapped file
+ *
+ *		Failure:	NULL if STREAM is an ordinary stream.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static PD_mapped_file *
+_PD_find_mapped (FILE *stream) {
+
+   PD_mapped_file *mf;
+
+   for (mf = _PD_mapped_files; mf != NULL; mf = mf->next) {
+      if ((FILE *) mf == stream) return(mf);
+   }
+
+   return(NULL);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_init
+ *
+ * Purpose:	Route the io hooks which are still set to the C library
+ *		through the _lite_PD_pio_* functions.
+ *
+ * Return:	Success:	TRUE if every hook a mapped file needs is
+ *				one of ours.
+ *
+ *		Failure:	FALSE if the application installed its own.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+int
+_lite_PD_pio_init (void) {
+
+   if (lite_io_close_hook == (PFfclose) fclose)
+      lite_io_close_hook = (PFfclose) _lite_PD_pio_close;
+
+   if (lite_io_flush_hook == (PFfflush) fflush)
+      lite_io_flush_hook = (PFfflush) _lite_PD_pio_flush;
+
+   if (lite_io_printf_hook == (PFfprintf) fprintf)
+      lite_io_printf_hook = (PFfprintf) _lite_PD_pio_printf;
+
+   if (lite_io_read_hook == (PFfread) fread)
+      lite_io_read_hook = (PFfread) _lite_PD_pio_read;
+
+   if (lite_io_seek_hook == (PFfseek) fseek)
+      lite_io_seek_hook = (PFfseek) _lite_PD_pio_seek;
+
+   if (lite_io_setvbuf_hook == (PFsetvbuf) setvbuf)
+      lite_io_setvbuf_hook = (PFsetvbuf) _lite_PD_pio_setvbuf;
+
+   if (lite_io_tell_hook == (PFftell) ftell)
+      lite_io_tell_hook = (PFftell) _lite_PD_pio_tell;
+
+   if (lite_io_write_hook == (PFfwrite) fwrite)
+      lite_io_write_hook = (PFfwrite) _lite_PD_pio_write;
+
+   return((lite_io_close_hook == (PFfclose) _lite_PD_pio_close) &&
+          (lite_io_flush_hook == (PFfflush) _lite_PD_pio_flush) &&
+          (lite_io_read_hook == (PFfread) _lite_PD_pio_read) &&
+          (lite_io_seek_hook == (PFfseek) _lite_PD_pio_seek) &&
+          (lite_io_setvbuf_hook == (PFsetvbuf) _lite_PD_pio_setvbuf) &&
+          (lite_io_tell_hook == (PFftell) _lite_PD_pio_tell) &&
+          (lite_io_write_hook == (PFfwrite) _lite_PD_pio_write));
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_mmap_open
+ *
+ * Purpose:	Map the file NAME read-only.
+ *
+ * Return:	Success:	A stream for the io hooks.
+ *
+ *		Failure:	NULL if the file can't be mapped, in which
+ *				case the caller should open it normally.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+FILE *
+_lite_PD_mmap_open (char *name) {
+
+#if HAVE_SYS_MMAN_H
+   int fd;
+   struct stat sb;
+   void *base;
+   PD_mapped_file *mf;
+
+   if (!_lite_PD_pio_init()) return(NULL);
+
+   fd = open(name, O_RDONLY);
+   if (fd < 0) return(NULL);
+
+   if ((fstat(fd, &sb) != 0) || !S_ISREG(sb.st_mode) || (sb.st_size <= 0)) {
+      close(fd);
+      return(NULL);
+   }
+
+   base = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (base == MAP_FAILED) return(NULL);
+
+   /*
+    * Most reads are small and scattered: symbol table entries, itags and
+    * hyperslab pieces.  Large reads ask for their own readahead.
+    */
+#ifdef MADV_RANDOM
+   madvise(base, (size_t) sb.st_size, MADV_RANDOM);
+#endif
+
+   mf = FMAKE(PD_mapped_file, "_PD_MMAP_OPEN:mf");
+   mf->base = (char *) base;
+   mf->size = (long) sb.st_size;
+   mf->pos  = 0L;
+   mf->next = _PD_mapped_files;
+   _PD_mapped_files = mf;
+
+   return((FILE *) mf);
+#else
+   return(NULL);
+#endif
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_map
+ *
+ * Purpose:	Return the NB bytes at the current position of a mapped
+ *		file in place and move past them, so callers that only
+ *		convert the data need not copy it first.
+ *
+ * Return:	Success:	Pointer into the mapping.
+ *
+ *		Failure:	NULL if STREAM is not mapped or the bytes
+ *				run past the end of the file.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+char *
+_lite_PD_pio_map (FILE *stream, long nb) {
+
+   PD_mapped_file *mf;
+   char *p;
+
+   mf = _PD_find_mapped(stream);
+   if ((mf == NULL) || (nb < 0) || (mf->pos + nb > mf->size)) return(NULL);
+
+#if HAVE_SYS_MMAN_H && defined(MADV_WILLNEED)
+   if (nb >= PD_MMAP_SEQUENTIAL_MIN) {
+      long pgsz = sysconf(_SC_PAGESIZE);
+      long beg  = mf->pos - mf->pos % pgsz;
+
+      madvise(mf->base + beg, (size_t) (mf->pos + nb - beg), MADV_WILLNEED);
+   }
+#endif
+
+   p = mf->base + mf->pos;
+   mf->pos += nb;
+
+   if (lite_PD_io_stats_hook) (*lite_PD_io_stats_hook)(PD_READ, nb);
+
+   return(p);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_read
+ *
+ * Purpose:	Do an fread on the file wherever it is.
+ *
+ * Return:	Success:	Number of items read.
+ *
+ *		Failure:	Short count.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+size_t
+_lite_PD_pio_read (lite_SC_byte *p, size_t sz, size_t ni, FILE *stream) {
+
+   PD_mapped_file *mf;
+   size_t avail;
+   char *src;
+
+   mf = _PD_find_mapped(stream);
+   if (mf == NULL) {
+      ni = fread(p, sz, ni, stream);
+      if (lite_PD_io_stats_hook)
+         (*lite_PD_io_stats_hook)(PD_READ, (long) (ni*sz));
+      return(ni);
+   }
+
+   if ((sz == 0) || (mf->pos >= mf->size)) return(0);
+
+   avail = (size_t) (mf->size - mf->pos)/sz;
+   if (ni > avail) ni = avail;
+
+   src = _lite_PD_pio_map(stream, (long) (ni*sz));
+   memcpy(p, src, ni*sz);
+
+   return(ni);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_write
+ *
+ * Purpose:	Do an fwrite on the file wherever it is.  Mapped files
+ *		are read-only.
+ *
+ * Return:	Success:	Number of items written.
+ *
+ *		Failure:	Short count.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+size_t
+_lite_PD_pio_write (void *p, size_t sz, size_t ni, FILE *stream) {
+
+   if (_PD_find_mapped(stream) != NULL) return(0);
+
+   ni = fwrite(p, sz, ni, stream);
+   if (lite_PD_io_stats_hook)
+      (*lite_PD_io_stats_hook)(PD_WRITE, (long) (ni*sz));
+
+   return(ni);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_tell
+ *
+ * Purpose:	Do an ftell on the file wherever it is.
+ *
+ * Return:	Success:	Current address.
+ *
+ *		Failure:	-1
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+long
+_lite_PD_pio_tell (FILE *stream) {
+
+   PD_mapped_file *mf;
+
+   mf = _PD_find_mapped(stream);
+   if (mf == NULL) return(ftell(stream));
+
+   return(mf->pos);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_flush
+ *
+ * Purpose:	Do an fflush on the file wherever it is.
+ *
+ * Return:	Success:	0
+ *
+ *		Failure:	EOF
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+int
+_lite_PD_pio_flush (FILE *stream) {
+
+   if (_PD_find_mapped(stream) != NULL) return(0);
+
+   return(fflush(stream));
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_pio_setvbuf
+ *
+ * Purpose:	Do a setvbuf on the file wherever it is.  Mapped files
+ *		have no buffer to set.
+ *
+ * Return:	Success:	0
+ *
+ *		Failure:	nonzero
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+int
+_lite_PD_pio_setvbuf (FILE *stream, char *buf, int type, size_t size) {
+
+   if (_PD_find_mapped(stream) != NULL) return(0);
+
+   return(setvbuf(stream, buf, type, size));
+}
 
 
 /*-------------------------------------------------------------------------
@@ -82,6 +436,8 @@ static char 	Pbuffer[LRG_TXT_BUFFER];
  *
  * Modifications:
  *
+ *	Unmap memory mapped files.
+ *
  *-------------------------------------------------------------------------
  */
 int
@@ -89,7 +445,22 @@ _lite_PD_pio_close (FILE *stream) {
 
    int ret;
 
+   PD_mapped_file *mf, **pmf;
+
    if (stream == NULL) return(EOF);
+
+   for (pmf = &_PD_mapped_files; (mf = *pmf) != NULL; pmf = &mf->next) {
+      if ((FILE *) mf == stream) {
+         *pmf = mf->next;
+#if HAVE_SYS_MMAN_H
+         ret = munmap(mf->base, (size_t) mf->size);
+#else
+         ret = 0;
+#endif
+         SFREE(mf);
+         return(ret ? EOF : 0);
+      }
+   }
    
    ret = fclose(stream);
    return(ret);
@@ -110,6 +481,10 @@ _lite_PD_pio_close (FILE *stream) {
  *
  * Modifications:
  *
+ *	Seek within memory mapped files.
+ *
+ *	Report seeks that move the position to lite_PD_io_stats_hook.
+ *
  *-------------------------------------------------------------------------
  */
 int
@@ -117,8 +492,30 @@ _lite_PD_pio_seek (FILE *stream, long addr, int offset) {
 
    int ret;
 
+   PD_mapped_file *mf;
+
    if (stream == NULL) return(EOF);
-   
+
+   mf = _PD_find_mapped(stream);
+   if (mf != NULL) {
+      switch (offset) {
+      case SEEK_SET : break;
+      case SEEK_CUR : addr += mf->pos; break;
+      case SEEK_END : addr += mf->size; break;
+      default : return(-1);
+      }
+      if (addr < 0) return(-1);
+      if ((addr != mf->pos) && lite_PD_io_stats_hook)
+         (*lite_PD_io_stats_hook)(PD_SEEK, 0L);
+      mf->pos = addr;
+      return(0);
+   }
+
+   if (lite_PD_io_stats_hook &&
+       ((offset != SEEK_SET) || (addr != ftell(stream))) &&
+       ((offset != SEEK_CUR) || (addr != 0L)))
+      (*lite_PD_io_stats_hook)(PD_SEEK, 0L);
+
    ret = fseek(stream, addr, offset);
 
    return(ret);
@@ -85,6 +85,10 @@ be used for advertising or product endorsement purposes.
  *    Mark C. Miller, Fri Apr 13 22:35:57 PDT 2012
  *    Added options arg and S,M,L,XL hash table size options. Added
  *    ignore_apersand_ia_ptr_syms option.
+ *
+ *    The size options are now only a starting point; the symbol table
+ *    grows as entries are installed. Initialize the symbol table arena
+ *    and binary symbol table fields.
  *-------------------------------------------------------------------------
  */
 PDBfile *
@@ -135,6 +139,10 @@ _lite_PD_mk_pdb (char *name, const char *options) {
    file->ignore_apersand_ptr_ia_syms = 0;
    if (strchr(options, 'i')) file->ignore_apersand_ptr_ia_syms = 1;
 
+   file->symt_arena = NULL;
+   file->symtbaddr  = 0L;
+   file->symtbsize  = 0L;
+
    return(file);
 }
 
@@ -154,6 +162,12 @@ _lite_PD_mk_pdb (char *name, const char *options) {
  *    Removed call to lite_PD_reset_ptr_list since it was removed.  I
  *    added a call to free current_prefix to close a memory leak.
  *
+ *    lite_LAST, lite_PD_DEFSTR_S, lite_PD_SYMENT_S and the io hooks
+ *    set up by _lite_PD_init_chrt are shared by all open files. They
+ *    are no longer released here since doing so broke any other file
+ *    still open (and defstr'ing with lite_LAST) at the time.
+ *
+ *    Release the arena holding the syments read from the file.
  *-------------------------------------------------------------------------
  */
 void
@@ -171,6 +185,7 @@ _lite_PD_rl_pdb (PDBfile *file) {
    _lite_PD_clr_table(file->host_chart,(FreeFuncType)_lite_PD_rl_defstr);
    _lite_PD_clr_table(file->chart,(FreeFuncType)_lite_PD_rl_defstr);
    _lite_PD_clr_table(file->symtab,(FreeFuncType)_lite_PD_rl_syment_d);
+   lite_SC_rl_arena(file->symt_arena);
 
    if (file->previous_file != NULL) SFREE(file->previous_file);
 
@@ -178,23 +193,6 @@ _lite_PD_rl_pdb (PDBfile *file) {
 
    if (file->type != NULL) SFREE(file->type);
 
-   if (lite_LAST != NULL) SFREE(lite_LAST);
-
-   if (lite_PD_DEFSTR_S != NULL) SFREE(lite_PD_DEFSTR_S);
-   lite_PD_DEFSTR_S = NULL;
-
-   if (lite_PD_SYMENT_S != NULL) SFREE(lite_PD_SYMENT_S);
-   lite_PD_SYMENT_S = NULL;
-
-   if (lite_io_close_hook == (PFfclose) _lite_PD_pio_close)
-      lite_io_close_hook = (PFfclose) fclose;
-
-   if (lite_io_seek_hook == (PFfseek) _lite_PD_pio_seek)
-      lite_io_seek_hook = (PFfseek) fseek;
-
-   if (lite_io_printf_hook == (PFfprintf) _lite_PD_pio_printf)
-      lite_io_printf_hook = (PFfprintf) fprintf;
-
    SFREE(file->name);
    SFREE(file);
 }
@@ -641,6 +639,50 @@ _lite_PD_mk_syment (char *type, long numb, long addr,
 }
 
 
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_mk_arena_syment
+ *
+ * Purpose:	Like _lite_PD_mk_syment but the syment comes from ARENA
+ *		and TYPE is stored as given rather than copied, so it must
+ *		live at least as long as the arena. The block list is
+ *		ordinary SCORE memory since the "Blocks" extra may grow it.
+ *
+ * Return:	Success:	a new syment
+ *
+ *		Failure:	NULL
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+syment *
+_lite_PD_mk_arena_syment (SC_arena *arena, char *type, long numb, long addr,
+			  dimdes *dims) {
+
+   syment *ep;
+   symblock *sp;
+
+   ep = (syment *) lite_SC_arena_alloc(arena, 1L, (long) sizeof(syment),
+				       "_PD_MK_ARENA_SYMENT:ep");
+   if (ep == NULL) return(NULL);
+   sp = FMAKE(symblock, "_PD_MK_ARENA_SYMENT:sp");
+
+   sp->number   = numb;
+   sp->diskaddr = addr;
+
+   PD_entry_blocks(ep)     = sp;
+   PD_entry_type(ep)       = type;
+   PD_entry_number(ep)     = numb;
+   PD_entry_dimensions(ep) = dims;
+
+   ep->indirects.addr       = 0L;
+   ep->indirects.n_ind_type = 0L;
+   ep->indirects.arr_offs   = 0L;
+
+   return(ep);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:	_lite_PD_rl_syment
  *
@@ -980,6 +1022,37 @@ _lite_PD_mk_dimensions (long mini, long leng) {
 }
 
 
+/*-------------------------------------------------------------------------
+ * Function:	_lite_PD_mk_arena_dimensions
+ *
+ * Purpose:	Like _lite_PD_mk_dimensions but allocated from ARENA.
+ *
+ * Return:	Success:	a new dimension descriptor
+ *
+ *		Failure:	NULL
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+dimdes *
+_lite_PD_mk_arena_dimensions (SC_arena *arena, long mini, long leng) {
+
+   dimdes *dims;
+
+   dims = (dimdes *) lite_SC_arena_alloc(arena, 1L, (long) sizeof(dimdes),
+					 "_PD_MK_ARENA_DIMENSIONS:dims");
+   if (dims == NULL) return(NULL);
+
+   dims->index_min = mini;
+   dims->index_max = mini + leng - 1L;
+   dims->number    = leng;
+   dims->next      = NULL;
+
+   return(dims);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:	_lite_PD_rl_dimensions
  *
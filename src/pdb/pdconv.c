@@ -62,6 +62,10 @@ be used for advertising or product endorsement purposes.
 #include "pdb.h"
 #include "pdform.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define ONES_COMP_NEG(n, nb, incr)                                           \
     {if (nb == 8*sizeof(long))                                               \
         n = ~n + incr;                                                       \
@@ -74,6 +78,11 @@ be used for advertising or product endorsement purposes.
  * Forward declarations...
  */
 static void             _PD_btrvout (char*,long,long);
+static void             _PD_bswap (char*,char*,long,int);
+static int              _PD_ieee_fconvert (char**,char**,long,long*,int*,
+                                           long*,int*);
+static int              _PD_ieee_kind (long*);
+static int              _PD_order_kind (int*,int);
 static int              _PD_get_bit (char*,int,int,int*);
 static void             _PD_insert_field (long,int,char*,int,int,int);
 static void             _PD_ncopy (char**,char**,long,long);
@@ -634,6 +643,8 @@ _lite_PD_convert_ascii (char *out, char *in, long nitems, int bpci, int offs) {
  *              Mar  6, 1996 12:14 PM EST
  *
  * Modifications:
+ *      Same size integers that differ only in byte order are swapped
+ *      with _PD_bswap instead of being moved a byte column at a time.
  *
  *-------------------------------------------------------------------------
  */
@@ -648,6 +659,20 @@ _lite_PD_iconvert (char **out, char **in, long nitems, long nbi, int ordi,
    lin = *in;
    lout = *out;
 
+   /*
+    * Same size twos complement integers only ever need a copy or a
+    * byte swap.
+    */
+   if ((nbi == nbo) && !onescmp &&
+       ((ordi == ordo) || (nbo == 2) || (nbo == 4) || (nbo == 8))) {
+      if (ordi == ordo) memcpy(lout, lin, nitems*nbo);
+      else _PD_bswap(lout, lin, nitems, (int) nbo);
+
+      *in  += nitems*nbi;
+      *out += nitems*nbo;
+      return;
+   }
+
    /*
     * Convert nitems integers.
     * test sign bit to properly convert negative integers
@@ -819,6 +844,11 @@ _lite_PD_iconvert (char **out, char **in, long nitems, long nbi, int ordi,
  *      Sean Ahern, Fri Mar  2 09:40:15 PST 2001
  *      Reformatted some of the code.
  *
+ *      IEEE single and double precision data in plain big or little
+ *      endian order is handed to _PD_ieee_fconvert, which swaps, widens
+ *      and narrows whole arrays.  Everything else still goes through
+ *      the bit field conversion below.
+ *
  *-------------------------------------------------------------------------*/
 void
 _lite_PD_fconvert (char **out, char **in, long nitems, int boffs, long *infor,
@@ -834,6 +864,10 @@ _lite_PD_fconvert (char **out, char **in, long nitems, int boffs, long *infor,
    unsigned char *rout;
    static int BitsMax = 8*sizeof(long);
 
+   if ((boffs == 0) && !onescmp &&
+       _PD_ieee_fconvert(out, in, nitems, infor, inord, outfor, outord))
+      return;
+
    nbi     = infor[0];
    nbo     = outfor[0];
    nbi_exp = infor[1];
@@ -1001,6 +1035,218 @@ _lite_PD_fconvert (char **out, char **in, long nitems, int boffs, long *infor,
 /*--------------------------------------------------------------------------*/
 
 
+/*-------------------------------------------------------------------------
+ * Function:    _PD_ieee_kind
+ *
+ * Purpose:     Decide whether the floating point format FORMAT is IEEE
+ *              single or double precision.
+ *
+ * Return:      4 or 8 for IEEE single or double precision, 0 for any
+ *              other format.
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_ieee_kind (long *format) {
+
+   int i;
+
+   for (i = 0; i < lite_FORMAT_FIELDS; i++)
+      if (format[i] != lite_ieee_float[i]) break;
+   if (i == lite_FORMAT_FIELDS) return(4);
+
+   for (i = 0; i < lite_FORMAT_FIELDS; i++)
+      if (format[i] != lite_ieeea_double[i]) break;
+   if (i == lite_FORMAT_FIELDS) return(8);
+
+   return(0);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_order_kind
+ *
+ * Purpose:     Classify the byte order ORD of an NB byte item.
+ *
+ * Return:      NORMAL_ORDER for big endian, REVERSE_ORDER for little
+ *              endian and 0 for anything else (e.g. VAX).
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_order_kind (int *ord, int nb) {
+
+   int j;
+
+   for (j = 0; j < nb; j++)
+      if (ord[j] != j + 1) break;
+   if (j == nb) return(NORMAL_ORDER);
+
+   for (j = 0; j < nb; j++)
+      if (ord[j] != nb - j) break;
+   if (j == nb) return(REVERSE_ORDER);
+
+   return(0);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_bswap
+ *
+ * Purpose:     Reverse the bytes of each of the NITEMS items of NB bytes
+ *              (2, 4 or 8) from IN and put them in OUT.  IN and OUT may
+ *              be the same buffer but must not otherwise overlap.
+ *
+ * Return:      void
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+_PD_bswap (char *out, char *in, long nitems, int nb) {
+
+   long i;
+   int j;
+   unsigned char tmp[8];
+#ifdef __SSE2__
+   long n;
+#endif
+
+   i = 0L;
+
+#ifdef __SSE2__
+   /*
+    * Sixteen bytes at a time: put the 16 bit words of each item in
+    * reverse order, then swap the two bytes within every word.
+    */
+   n = (nitems*nb) >> 4;
+   for (; i < n; i++) {
+      __m128i v;
+
+      v = _mm_loadu_si128((__m128i *) (in + 16*i));
+      if (nb == 4) {
+         v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+         v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+      } else if (nb == 8) {
+         v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+         v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+      }
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      _mm_storeu_si128((__m128i *) (out + 16*i), v);
+   }
+
+   /*
+    * Every item size divides sixteen so the vector loop ends on an
+    * item boundary.
+    */
+   i = (16*n)/nb;
+#endif
+
+   for (; i < nitems; i++) {
+      for (j = 0; j < nb; j++) tmp[j] = in[i*nb + nb - 1 - j];
+      memcpy(out + i*nb, tmp, nb);
+   }
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_ieee_fconvert
+ *
+ * Purpose:     Convert NITEMS IEEE floats or doubles from IN to OUT when
+ *              both sides are plain big or little endian.  Same size
+ *              data is copied or byte swapped; float <-> double goes
+ *              through the host's own conversion, so only a host with
+ *              IEEE floating point takes the widening and narrowing
+ *              path.  IN and OUT are advanced past the data.
+ *
+ * Return:      Success:        TRUE
+ *
+ *              Failure:        FALSE if the formats are not handled here
+ *                              and the caller must do the generic
+ *                              conversion.
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_ieee_fconvert (char **out, char **in, long nitems, long *infor,
+                   int *inord, long *outfor, int *outord) {
+
+   static int host_order = -1;
+   long i;
+   int nbi, nbo, kin, kout, j;
+   unsigned char bi[8], bo[8];
+   char *lin, *lout;
+   float f;
+   double d;
+
+   nbi = _PD_ieee_kind(infor);
+   nbo = _PD_ieee_kind(outfor);
+   if ((nbi == 0) || (nbo == 0)) return(FALSE);
+
+   kin  = _PD_order_kind(inord, nbi);
+   kout = _PD_order_kind(outord, nbo);
+   if ((kin == 0) || (kout == 0)) return(FALSE);
+
+   lin  = *in;
+   lout = *out;
+
+   if (nbi == nbo) {
+      if (kin == kout) memcpy(lout, lin, nitems*nbo);
+      else _PD_bswap(lout, lin, nitems, nbo);
+   } else {
+      /*
+       * Find the host byte order from the bit pattern of 1.0 and make
+       * sure the host is IEEE at all.
+       */
+      if (host_order == -1) {
+         static unsigned char one_f[] = {0x3f, 0x80, 0x00, 0x00};
+         static unsigned char one_d[] = {0x3f, 0xf0, 0, 0, 0, 0, 0, 0};
+
+         host_order = 0;
+         f = 1.0f;
+         d = 1.0;
+         memcpy(bi, &f, 4);
+         memcpy(bo, &d, 8);
+         for (j = 0; (j < 4) && (bi[j] == one_f[j]); j++) /*void*/ ;
+         if ((j == 4) && (memcmp(bo, one_d, 8) == 0))
+            host_order = NORMAL_ORDER;
+         for (j = 0; (j < 4) && (bi[j] == one_f[3 - j]); j++) /*void*/ ;
+         if (j == 4) {
+            for (j = 0; (j < 8) && (bo[j] == one_d[7 - j]); j++) /*void*/ ;
+            if (j == 8) host_order = REVERSE_ORDER;
+         }
+      }
+      if ((host_order == 0) ||
+          (sizeof(float) != 4) || (sizeof(double) != 8))
+         return(FALSE);
+
+      for (i = 0L; i < nitems; i++, lin += nbi, lout += nbo) {
+         if (kin == host_order) memcpy(bi, lin, nbi);
+         else for (j = 0; j < nbi; j++) bi[j] = lin[nbi - 1 - j];
+
+         if (nbi == 4) {
+            memcpy(&f, bi, 4);
+            d = (double) f;
+            memcpy(bo, &d, 8);
+         } else {
+            memcpy(&d, bi, 8);
+            f = (float) d;
+            memcpy(bo, &f, 4);
+         }
+
+         if (kout == host_order) memcpy(lout, bo, nbo);
+         else for (j = 0; j < nbo; j++) lout[j] = bo[nbo - 1 - j];
+      }
+   }
+
+   *in  += nitems*nbi;
+   *out += nitems*nbo;
+
+   return(TRUE);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:    _PD_ncopy
  *
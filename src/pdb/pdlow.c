@@ -89,6 +89,14 @@ extern int fprintf(FILE*, const char*, ...);
 #define BUFINCR         4096
 #define N_CASTS_INCR    30
 
+/*
+ * The binary symbol table is written just ahead of the structure chart
+ * and located through this extra. Readers that predate it ignore both.
+ */
+#define PD_SYMT_BIN_KEY         "Binary-Symbol-Table"
+#define PD_SYMT_BIN_MAGIC       "PDBSYMT1"
+#define PD_SYMT_BIN_MAGIC_LEN   8
+
 
 #define PD_REVERSE_LIST(type, var, member)                                  \
    {type *ths, *nxt, *prv;                                                  \
@@ -173,10 +181,18 @@ static defstr * _lite_PD_defstr (HASHTAB*,char*,int,long,int,int,int*,long*);
 static char *   _PD_get_tok (char*,int,FILE*,int);
 static char *   _PD_get_token (char*,char*,int,int);
 static int      _PD_consistent_dims (PDBfile*,syment*,dimdes*);
+static char *   _PD_arena_strsave (SC_arena*,char*,long);
+static int      _PD_get_varint (unsigned char**,unsigned char*,unsigned long*);
+static int      _PD_get_svarint (unsigned char**,unsigned char*,long*);
+static int      _PD_rd_symt_bin (PDBfile*,char*,long);
 
 #ifdef PDB_WRITE
 static int      _PD_put_string (int,char*,...);
+static long     _PD_symt_dim_number (dimdes*,long,long,int*);
+static unsigned char *_PD_put_varint (unsigned char*,unsigned long);
+static unsigned char *_PD_put_svarint (unsigned char*,long);
 #endif /* PDB_WRITE */
+int             lite_PD_symt_binary_min = 1024;
    
 /*-------------------------------------------------------------------------
  * Function:    _lite_PD_rd_format
@@ -414,16 +430,21 @@ _lite_PD_compare_std (data_standard *a, data_standard *b,
  *    Mark C. Miller, Fri Apr 13 22:40:59 PDT 2012
  *    Ignore symbols of the form "/&ptrs/ia_######" when controlling
  *    flag is set.
+ *
+ *    Load the binary symbol table instead when the file has one.
+ *    Syments, dimensions and type names now come from the file's
+ *    symbol table arena, with runs of the same type sharing a string.
  *-------------------------------------------------------------------------
  */
 int
 _lite_PD_rd_symt (PDBfile *file) {
 
-   char *name, *type, *tmp, *pbf;
+   char *name, *type, *tmp, *pbf, *ltype;
    long numb, addr, mini, leng, symt_sz;
    FILE *fp;
    syment *ep;
    HASHTAB *tab;
+   SC_arena *arena;
    dimdes *dims, *next, *prev;
 
    fp = file->stream;
@@ -445,9 +466,16 @@ _lite_PD_rd_symt (PDBfile *file) {
    if (numb != symt_sz) return(FALSE);
    _lite_PD_tbuffer[symt_sz-1] = (char) EOF;
 
-   pbf  = _lite_PD_tbuffer;
-   prev = NULL;
-   tab  = file->symtab;
+   if (file->symt_arena == NULL) file->symt_arena = lite_SC_make_arena(0L);
+   arena = file->symt_arena;
+   if (arena == NULL) return(FALSE);
+
+   if (_PD_rd_symt_bin(file, _lite_PD_tbuffer, symt_sz)) return(TRUE);
+
+   pbf   = _lite_PD_tbuffer;
+   prev  = NULL;
+   ltype = NULL;
+   tab   = file->symtab;
    while (_PD_get_token(pbf, local, LRG_TXT_BUFFER, '\n')) {
       pbf  = NULL;
       name = strtok(local, "\001");
@@ -459,7 +487,8 @@ _lite_PD_rd_symt (PDBfile *file) {
       while ((tmp = strtok(NULL, "\001\n")) != NULL) {
          mini = lite_SC_stol(tmp);
          leng = lite_SC_stol(strtok(NULL, "\001\n"));
-         next = _lite_PD_mk_dimensions(mini, leng);
+         next = _lite_PD_mk_arena_dimensions(arena, mini, leng);
+         if (next == NULL) return(FALSE);
          if (dims == NULL) {
             dims = next;
          } else {
@@ -470,12 +499,272 @@ _lite_PD_rd_symt (PDBfile *file) {
       }
       if (file->ignore_apersand_ptr_ia_syms &&
           strstr(name, "/&ptrs/ia_")) continue;
-      ep = _lite_PD_mk_syment(type, numb, addr, NULL, dims);
+      if ((type != NULL) && ((ltype == NULL) || (strcmp(type, ltype) != 0)))
+         ltype = _PD_arena_strsave(arena, type, (long) strlen(type));
+      ep = _lite_PD_mk_arena_syment(arena, (type == NULL) ? NULL : ltype,
+                                    numb, addr, dims);
+      if (ep == NULL) return(FALSE);
       _lite_PD_e_install(name, ep, tab);
    }
    return(TRUE);
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    _PD_arena_strsave
+ *
+ * Purpose:     Save the first N characters of S in ARENA.
+ *
+ * Return:      Success:        The NUL terminated copy.
+ *
+ *              Failure:        NULL
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static char *
+_PD_arena_strsave (SC_arena *arena, char *s, long n) {
+
+   char *t;
+
+   t = (char *) lite_SC_arena_alloc(arena, n+1, 1L, "char*:_PD_ARENA_STRSAVE");
+   if (t == NULL) return(NULL);
+
+   memcpy(t, s, n);
+   t[n] = '\0';
+
+   return(t);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_get_varint
+ *
+ * Purpose:     Decode an unsigned LEB128 value at *PP, not reading past
+ *              END, and advance *PP over it.
+ *
+ * Return:      Success:        TRUE
+ *
+ *              Failure:        FALSE (truncated or too long)
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_get_varint (unsigned char **pp, unsigned char *end, unsigned long *pv) {
+
+   unsigned char *p;
+   unsigned long v;
+   int shift;
+
+   v = 0;
+   for (p = *pp, shift = 0; p < end; p++, shift += 7) {
+      if (shift >= (int) (8*sizeof(unsigned long))) return(FALSE);
+      v |= ((unsigned long) (*p & 0x7f)) << shift;
+      if ((*p & 0x80) == 0) {
+         *pp = p + 1;
+         *pv = v;
+         return(TRUE);
+      }
+   }
+
+   return(FALSE);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_get_svarint
+ *
+ * Purpose:     Decode a zig-zag encoded signed value. See _PD_get_varint.
+ *
+ * Return:      Success:        TRUE
+ *
+ *              Failure:        FALSE
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_get_svarint (unsigned char **pp, unsigned char *end, long *pv) {
+
+   unsigned long u;
+
+   if (!_PD_get_varint(pp, end, &u)) return(FALSE);
+
+   *pv = (u & 1) ? -((long) (u >> 1)) - 1L : (long) (u >> 1);
+
+   return(TRUE);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_rd_symt_bin
+ *
+ * Purpose:     Load the symbol table from the binary section written by
+ *              _lite_PD_wr_symt_bin, if the extras in BF (the text symbol
+ *              table and extras as read by _lite_PD_rd_symt, NBF bytes)
+ *              point at one. On success the token reader is left at the
+ *              start of the extras exactly as the text parser leaves it
+ *              and file->symtbaddr/symtbsize record where the section is.
+ *
+ *              The section is laid out as the magic string, the number
+ *              of entries and then for each entry: the name, the type
+ *              (a zero length means the type of the previous entry), the
+ *              number of items in the first block, the disk address, the
+ *              number of dimensions and the (min, number) of each. Strings
+ *              are length prefixed and all integers are LEB128 varints
+ *              with signed ones zig-zag encoded.
+ *
+ * Return:      Success:        TRUE
+ *
+ *              Failure:        FALSE, there is no usable binary symbol
+ *                              table and the text one should be parsed.
+ *                              Entries installed before a failure are
+ *                              replaced when the text is parsed.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+static int
+_PD_rd_symt_bin (PDBfile *file, char *bf, long nbf) {
+
+   char *pe, *pl, *pn, *type;
+   unsigned char *bb, *pb, *eb;
+   unsigned long n, i, nd, j, len;
+   long addr, size, numb, mini, leng;
+   int skip, ok;
+   size_t nk;
+   SC_arena *arena;
+   syment *ep;
+   dimdes *dims, *next, *prev;
+   FILE *fp;
+
+   /*
+    * The text symbol table ends at the first empty line.
+    */
+   pl = bf + nbf - 1;
+   for (pe = bf; (pe < pl) && (*pe != '\n'); pe++) {
+      pe = memchr(pe, '\n', pl - pe);
+      if (pe == NULL) return(FALSE);
+   }
+   if (pe >= pl) return(FALSE);
+
+   /*
+    * Look through the extras for the binary symbol table.
+    */
+   addr = 0L;
+   size = 0L;
+   nk   = strlen(PD_SYMT_BIN_KEY);
+   for (pn = pe + 1; pn < pl; pn++) {
+      if ((pl - pn > (long) nk) && (strncmp(pn, PD_SYMT_BIN_KEY, nk) == 0) &&
+          (pn[nk] == ':')) {
+         addr = strtol(pn + nk + 1, &pn, 10);
+         if (*pn == '|') size = strtol(pn + 1, &pn, 10);
+         break;
+      }
+      pn = memchr(pn, '\n', pl - pn);
+      if (pn == NULL) break;
+   }
+   if ((addr <= 0L) || (size <= PD_SYMT_BIN_MAGIC_LEN) ||
+       (addr + size > file->chrtaddr)) return(FALSE);
+
+   fp = file->stream;
+   if (io_seek(fp, addr, SEEK_SET)) return(FALSE);
+   bb = MAKE_N(unsigned char, size);
+   if (bb == NULL) return(FALSE);
+   if (((long) io_read(bb, 1, size, fp) != size) ||
+       (memcmp(bb, PD_SYMT_BIN_MAGIC, PD_SYMT_BIN_MAGIC_LEN) != 0)) {
+      SFREE(bb);
+      return(FALSE);
+   }
+
+   file->symtbaddr = addr;
+   file->symtbsize = size;
+
+   arena = file->symt_arena;
+   pb    = bb + PD_SYMT_BIN_MAGIC_LEN;
+   eb    = bb + size;
+   type  = NULL;
+   ok    = _PD_get_varint(&pb, eb, &n);
+
+   /*
+    * Size the table for the whole symbol table up front rather than
+    * growing it repeatedly.
+    */
+   if (ok && (n > (unsigned long) file->symtab->size) && (n < INT_MAX/2))
+      lite_SC_resize_hash_table(file->symtab, (int) (n | 1));
+
+   for (i = 0; ok && (i < n); i++) {
+      ok = FALSE;
+
+      if (!_PD_get_varint(&pb, eb, &len) || (len == 0) ||
+          (len >= LRG_TXT_BUFFER) || (len > (unsigned long) (eb - pb))) break;
+      memcpy(local, pb, len);
+      local[len] = '\0';
+      pb += len;
+
+      if (!_PD_get_varint(&pb, eb, &len) ||
+          (len > (unsigned long) (eb - pb))) break;
+      if (len > 0) {
+         type = _PD_arena_strsave(arena, (char *) pb, (long) len);
+         pb  += len;
+      }
+      if (type == NULL) break;
+
+      if (!_PD_get_svarint(&pb, eb, &numb) ||
+          !_PD_get_svarint(&pb, eb, &addr) ||
+          !_PD_get_varint(&pb, eb, &nd)) break;
+
+      skip = file->ignore_apersand_ptr_ia_syms &&
+             (strstr(local, "/&ptrs/ia_") != NULL);
+
+      dims = NULL;
+      prev = NULL;
+      for (j = 0; j < nd; j++) {
+         if (!_PD_get_svarint(&pb, eb, &mini) ||
+             !_PD_get_svarint(&pb, eb, &leng)) break;
+         if (skip) continue;
+         next = _lite_PD_mk_arena_dimensions(arena, mini, leng);
+         if (next == NULL) break;
+         if (dims == NULL) {
+            dims = next;
+         } else {
+            prev->next = next;
+         }
+
+         prev = next;
+      }
+      if (j < nd) break;
+
+      /*
+       * Names are unique in a table written by _lite_PD_wr_symt_bin so
+       * the duplicate handling of _lite_PD_e_install is not needed.
+       */
+      if (!skip) {
+         ep = _lite_PD_mk_arena_syment(arena, type, numb, addr, dims);
+         if (ep == NULL) break;
+         lite_SC_install(local, ep, lite_PD_SYMENT_S, file->symtab);
+      }
+
+      ok = TRUE;
+   }
+   SFREE(bb);
+
+   if (!ok || (pb != eb)) {
+      file->symtbaddr = 0L;
+      file->symtbsize = 0L;
+      return(FALSE);
+   }
+
+   /*
+    * Consume the empty line which ends the text symbol table so that
+    * _lite_PD_rd_extras picks up where it expects to.
+    */
+   _PD_get_token(pe, local, LRG_TXT_BUFFER, '\n');
+
+   return(TRUE);
+}
+
 /*-------------------------------------------------------------------------
  * Function:    _lite_PD_rd_chrt
  *
@@ -1302,14 +1591,7 @@ _lite_PD_init_chrt (PDBfile *file) {
       lite_LAST        = FMAKE(int, "_PD_INIT_CHART:LAST");
       *lite_LAST       = 0;
 
-      if (lite_io_close_hook == (PFfclose) fclose)
-         lite_io_close_hook = (PFfclose) _lite_PD_pio_close;
-
-      if (lite_io_seek_hook == (PFfseek) fseek)
-         lite_io_seek_hook = (PFfseek) _lite_PD_pio_seek;
-
-      if (lite_io_printf_hook == (PFfprintf) fprintf)
-         lite_io_printf_hook = (PFfprintf) _lite_PD_pio_printf;
+      _lite_PD_pio_init();
 
       lite_PD_DEFSTR_S = lite_SC_strsavef("defstr *",
                                           "char*:_PD_INT_CHRT:defstr");
@@ -1885,13 +2167,15 @@ _lite_PD_wr_chrt (PDBfile *file) {
  *
  * Modifications:
  *
+ *   Moved the first block dimension adjustment into _PD_symt_dim_number
+ *   so it is shared with _lite_PD_wr_symt_bin.
  *-------------------------------------------------------------------------
  */
 #ifdef PDB_WRITE
 long
 _lite_PD_wr_symt (PDBfile *file) {
 
-   long addr, nt, ne, nb, stride;
+   long addr, nt, ne, nb;
    int i, n, size, flag;
    FILE *fp;
    hashel **s_tab, *hp;
@@ -1931,15 +2215,7 @@ _lite_PD_wr_symt (PDBfile *file) {
           */
          flag = PD_get_major_order(file);
          for (lst = PD_entry_dimensions(ep); lst != NULL; lst = lst->next) {
-            if ((flag == ROW_MAJOR_ORDER) ||
-                ((flag == COLUMN_MAJOR_ORDER) && (lst->next == NULL))) {
-               stride = lst->number?nt/(lst->number):0;
-               ne     = stride?nb/stride:0;
-               flag   = FALSE;
-            } else {
-               ne = lst->number;
-            }
-
+            ne = _PD_symt_dim_number(lst, nt, nb, &flag);
             _PD_put_string(n++, "%ld\001%ld\001", lst->index_min, ne);
          }
 
@@ -1957,6 +2233,221 @@ _lite_PD_wr_symt (PDBfile *file) {
 }
 #endif /* PDB_WRITE */
 
+/*-------------------------------------------------------------------------
+ * Function:    _PD_symt_dim_number
+ *
+ * Purpose:     Return the number of elements to record in the symbol
+ *              table for dimension LST of an entry with NT items whose
+ *              first block holds NB. The slowest varying dimension is
+ *              scaled to cover only the first block; *FLAG starts as the
+ *              file's major order and is cleared once that is done.
+ *
+ * Return:      The element count for LST.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifdef PDB_WRITE
+static long
+_PD_symt_dim_number (dimdes *lst, long nt, long nb, int *flag) {
+
+   long stride;
+
+   if ((*flag == ROW_MAJOR_ORDER) ||
+       ((*flag == COLUMN_MAJOR_ORDER) && (lst->next == NULL))) {
+      stride = lst->number?nt/(lst->number):0;
+      *flag  = FALSE;
+      return(stride?nb/stride:0);
+   }
+
+   return(lst->number);
+}
+#endif /* PDB_WRITE */
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_put_varint
+ *
+ * Purpose:     Encode V as an unsigned LEB128 value at P.
+ *
+ * Return:      The byte following the encoded value.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifdef PDB_WRITE
+static unsigned char *
+_PD_put_varint (unsigned char *p, unsigned long v) {
+
+   while (v >= 0x80) {
+      *p++ = (unsigned char) (v | 0x80);
+      v >>= 7;
+   }
+   *p++ = (unsigned char) v;
+
+   return(p);
+}
+#endif /* PDB_WRITE */
+
+/*-------------------------------------------------------------------------
+ * Function:    _PD_put_svarint
+ *
+ * Purpose:     Encode V zig-zag style so small negative values stay short.
+ *
+ * Return:      The byte following the encoded value.
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifdef PDB_WRITE
+static unsigned char *
+_PD_put_svarint (unsigned char *p, long v) {
+
+   unsigned long u;
+
+   u = (v < 0) ? ((~(unsigned long) v) << 1) | 1 : ((unsigned long) v) << 1;
+
+   return(_PD_put_varint(p, u));
+}
+#endif /* PDB_WRITE */
+
+/*-------------------------------------------------------------------------
+ * Function:    _lite_PD_wr_symt_bin
+ *
+ * Purpose:     Write the symbol table in the binary form read by
+ *              _PD_rd_symt_bin at the current file position. This is
+ *              done only when the table has at least
+ *              lite_PD_symt_binary_min entries (never if that is not
+ *              positive). The location is left in file->symtbaddr and
+ *              file->symtbsize for _lite_PD_wr_extras to record. The
+ *              text symbol table is still written for older readers.
+ *
+ * Return:      Success:        disk address, or 0 if nothing was
+ *                              written
+ *
+ *              Failure:        -1
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifdef PDB_WRITE
+long
+_lite_PD_wr_symt_bin (PDBfile *file) {
+
+   long addr, nt, ne, nb, nc, nx, nd, ln, lt, n;
+   int i, size, flag;
+   char *ltype, *type;
+   unsigned char *bb, *pb;
+   FILE *fp;
+   HASHTAB *tab;
+   hashel **s_tab, *hp;
+   syment *ep;
+   dimdes *lst;
+
+   file->symtbaddr = 0L;
+   file->symtbsize = 0L;
+
+   tab = file->symtab;
+   if ((lite_PD_symt_binary_min <= 0) ||
+       (tab->nelements < lite_PD_symt_binary_min)) return(0L);
+
+   fp   = file->stream;
+   addr = io_tell(fp);
+   if (addr == -1L) return(-1L);
+
+   nx = BUFINCR;
+   bb = MAKE_N(unsigned char, nx);
+   if (bb == NULL) return(-1L);
+   memcpy(bb, PD_SYMT_BIN_MAGIC, PD_SYMT_BIN_MAGIC_LEN);
+   pb = _PD_put_varint(bb + PD_SYMT_BIN_MAGIC_LEN,
+                       (unsigned long) tab->nelements);
+
+   n     = 0L;
+   ltype = NULL;
+   s_tab = tab->table;
+   size  = tab->size;
+   for (i = 0; i < size; i++) {
+      for (hp = s_tab[i]; hp != NULL; hp = hp->next) {
+         ep   = (syment *) (hp->def);
+         type = PD_entry_type(ep);
+         nt   = PD_entry_number(ep);
+         nb   = PD_block_number(ep, 0);
+         if (nb == 0) {
+            if (PD_n_blocks(ep) == 1) {
+               nb = nt;
+            } else {
+               nb = -1L;
+            }
+         }
+
+         /*
+          * Leave anything odd to the text symbol table which reports it.
+          */
+         if ((type == NULL) || (nb == -1L)) {
+            SFREE(bb);
+            return(0L);
+         }
+
+         /*
+          * Each varint takes at most 10 bytes.
+          */
+         nd = 0L;
+         for (lst = PD_entry_dimensions(ep); lst != NULL; lst = lst->next)
+            nd++;
+         ln = strlen(hp->name);
+         lt = strlen(type);
+         nc = pb - bb;
+         if (nc + ln + lt + 50L + 20L*nd > nx) {
+            nx = 2*(nc + ln + lt + 50L + 20L*nd);
+            REMAKE_N(bb, unsigned char, nx);
+            pb = bb + nc;
+         }
+
+         pb = _PD_put_varint(pb, (unsigned long) ln);
+         memcpy(pb, hp->name, ln);
+         pb += ln;
+
+         if ((ltype != NULL) && (strcmp(type, ltype) == 0)) {
+            pb = _PD_put_varint(pb, 0UL);
+         } else {
+            pb = _PD_put_varint(pb, (unsigned long) lt);
+            memcpy(pb, type, lt);
+            pb   += lt;
+            ltype = type;
+         }
+
+         pb = _PD_put_svarint(pb, nb);
+         pb = _PD_put_svarint(pb, PD_entry_address(ep));
+         pb = _PD_put_varint(pb, (unsigned long) nd);
+
+         flag = PD_get_major_order(file);
+         for (lst = PD_entry_dimensions(ep); lst != NULL; lst = lst->next) {
+            ne = _PD_symt_dim_number(lst, nt, nb, &flag);
+            pb = _PD_put_svarint(pb, lst->index_min);
+            pb = _PD_put_svarint(pb, ne);
+         }
+
+         n++;
+      }
+   }
+
+   nc = pb - bb;
+   if ((n != tab->nelements) || ((long) io_write(bb, 1, nc, fp) != nc)) {
+      SFREE(bb);
+      return((n != tab->nelements) ? 0L : -1L);
+   }
+   SFREE(bb);
+
+   file->symtbaddr = addr;
+   file->symtbsize = nc;
+
+   return(addr);
+}
+#endif /* PDB_WRITE */
+
 /*-------------------------------------------------------------------------
  * Function:    _lite_PD_wr_extras
  *
@@ -1997,6 +2488,8 @@ _lite_PD_wr_symt (PDBfile *file) {
  *   Mark C. Miller, Tue Nov 17 22:23:42 PST 2009
  *   Changed support for long long to match more closely what PDB
  *   proper does.
+ *
+ *   Added the Binary-Symbol-Table extra.
  *-------------------------------------------------------------------------
  */
 #ifdef PDB_WRITE
@@ -2092,6 +2585,14 @@ _lite_PD_wr_extras (PDBfile *file) {
    has_dirs = PD_has_directories(file);
    _PD_put_string(1, "Has-Directories:%d\n", has_dirs);
 
+   /*
+    * Write out where the binary symbol table is, if there is one.
+    */
+   if (file->symtbaddr > 0L) {
+      _PD_put_string(1, "%s:%ld|%ld\n", PD_SYMT_BIN_KEY,
+                     file->symtbaddr, file->symtbsize);
+   }
+
    /*
     * Write out the primitives.
     */
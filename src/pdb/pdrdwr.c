@@ -832,6 +832,8 @@ _PD_read_hyper_space (PDBfile *file, syment *ep, char *out, char *intype,
  *
  * Modifications:
  *
+ *    Convert data in memory mapped files without copying it first.
+ *
  *-------------------------------------------------------------------------
  */
 static void
@@ -858,6 +860,22 @@ _PD_rd_leaf_members (PDBfile *file, char *vr, long nitems, char *intype,
       } else {
          nia = nitems;
       }
+
+      /*
+       * Convert straight from the pages of a memory mapped file.
+       */
+      vbuf = _lite_PD_pio_map(fp, nia*bytepitemin);
+      if (vbuf != NULL) {
+         svr      = vr;
+         in_offs  = 0L;
+         out_offs = 0L;
+         lite_PD_convert(&svr, &vbuf, intype, outtype, nitems,
+                         file->std, file->host_std, file->host_std,
+                         &in_offs, &out_offs,
+                         file->chart, file->host_chart, boffs, PD_READ);
+         return;
+      }
+
       buf = (char *) lite_SC_alloc(nia, bytepitemin,
                                    "_PD_RD_LEAF_MEMBERS:buffer");
       if (buf == NULL)
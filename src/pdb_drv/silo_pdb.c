@@ -285,6 +285,8 @@ pj_fixname (PDBfile *file, char const *inname) {
  * Programmer:
  *
  * Modifications:
+ *    Empty the file's object cache since the write may replace a
+ *    cached object.
  *
  *-------------------------------------------------------------------------
  */
@@ -294,6 +296,7 @@ PJ_write (PDBfile *file, char *name, char *type, void *var) {
 
    char          *newname = pj_fixname(file, name);
 
+   PJ_ClearCache(file);
    return (lite_PD_write(file, newname, type, var));
 }
 #endif /* PDB_WRITE */
@@ -311,6 +314,8 @@ PJ_write (PDBfile *file, char *name, char *type, void *var) {
  * Programmer:
  *
  * Modifications:
+ *    Empty the file's object cache since the write may replace a
+ *    cached object.
  *
  *-------------------------------------------------------------------------
  */
@@ -321,6 +326,7 @@ PJ_write_alt (PDBfile *file, char const *name, char const *type,
 
    char          *newname = pj_fixname(file, name);
 
+   PJ_ClearCache(file);
    return (lite_PD_write_alt(file, newname, (char *) type,
               (void *) var, nd, (long *) ind));
 }
@@ -340,6 +346,8 @@ PJ_write_alt (PDBfile *file, char const *name, char const *type,
  * Programmer:
  *
  * Modifications:
+ *    Empty the file's object cache since the write may replace a
+ *    cached object.
  *
  *-------------------------------------------------------------------------
  */
@@ -358,6 +366,7 @@ PJ_write_len (PDBfile *file, char const *name, char const *type, void const *var
       ind[i * 3 + 2] = 1;
    }
 
+   PJ_ClearCache(file);
    return (lite_PD_write_alt(file, newname, (char*) type, (void*) var, nd, ind));
 }
 #endif /* PDB_WRITE */
@@ -414,24 +423,39 @@ static int     _pj_force_single = FALSE;
 
 /* Definition of global variables (bleah!) */
 
-/* The variable use_PJgroup_cache is used in the PJ_GetObject function call.
- * That function will cache any PJgroup that it retrieves, if possible.
- * Sometimes, however, we've changed the state of the file (like changing
- * directories) and must ignore any cache that we already have.  The
- * "use_PJgroup_cache" variable is a boolean value that allows us to ignore
- * the cached value when we need to.  Note that, even if this variable is set
- * to 0 here, it will be reset to 1 after the first group is read.
+/* Parsed object descriptions (PJgroups) are kept in a small cache per open
+ * file so that readers moving back and forth between a few objects (a mesh,
+ * its zonelist and the variables defined on it) don't re-read and re-parse
+ * the group on every DBGet* call.  Each file's cache is a list of at most
+ * "maxsize" groups, most recently used first, keyed by the absolute path of
+ * the object.  Any write to the file empties that file's cache.  The size
+ * comes from DBOPT_PDB_OBJ_CACHE_SIZE in the file options set given to
+ * DBCreate/DBOpen; a size of 0 turns caching off for the file.
+ *
+ * The variable use_PJgroup_cache is a boolean value that allows the next
+ * PJ_GetObject call to ignore any cached group and read it again from the
+ * file.  It is reset to 1 after that group is read.
  */
-static int use_PJgroup_cache = 1;
+#define PJ_OBJ_CACHE_SIZE 32
+
+typedef struct pj_cache_entry_t {
+    char                    *path;      /* absolute path of the object */
+    PJgroup                 *group;
+    struct pj_cache_entry_t *next;
+} pj_cache_entry_t;
+
+typedef struct pj_objcache_t {
+    PDBfile                 *file;
+    int                      maxsize;
+    int                      nentries;
+    long                     hits;
+    long                     misses;
+    pj_cache_entry_t        *head;
+    struct pj_objcache_t    *next;
+} pj_objcache_t;
 
-/* To cache the PJgroup, we need to keep the group, and we need to keep
- * the "definition" of which object it is.  This information can be
- * captured by storing the name of the object, the name of the file it
- * came from, and the directory from which it came.
- */
-static PJgroup *cached_group = NULL;
-static char    *cached_obj_name = NULL;
-static char    *cached_file_name = NULL;
+static int use_PJgroup_cache = 1;
+static pj_objcache_t *pj_objcaches = NULL;
 
 PRIVATE int db_pdb_ParseVDBSpec (char const *mvdbspec, char **varname,
                                  char **filename);
@@ -513,6 +537,260 @@ PJ_NoCache ( void )
 }
 
 
+/*----------------------------------------------------------------------
+ * Function:    pj_find_cache
+ *
+ * Purpose:     Find the object cache of an open file.
+ *
+ * Return:      Success:        the file's cache
+ *
+ *              Failure:        NULL, the file has no cache
+ *--------------------------------------------------------------------*/
+PRIVATE pj_objcache_t *
+pj_find_cache(PDBfile *file)
+{
+    pj_objcache_t *cache;
+
+    for (cache = pj_objcaches; cache; cache = cache->next)
+    {
+        if (cache->file == file)
+            return cache;
+    }
+    return NULL;
+}
+
+/*----------------------------------------------------------------------
+ * Function:    pj_cache_release
+ *
+ * Purpose:     Release the groups held by a cache, leaving it empty.
+ *--------------------------------------------------------------------*/
+PRIVATE void
+pj_cache_release(pj_objcache_t *cache)
+{
+    pj_cache_entry_t *entry, *next;
+
+    for (entry = cache->head; entry; entry = next)
+    {
+        next = entry->next;
+        PJ_rel_group(entry->group);
+        FREE(entry->path);
+        FREE(entry);
+    }
+    cache->head = NULL;
+    cache->nentries = 0;
+}
+
+/*----------------------------------------------------------------------
+ * Function:    pj_cache_lookup
+ *
+ * Purpose:     Look up the group for the object at absolute path PATH.
+ *              A group that is found is moved to the front of the list.
+ *              If REMOVE is set, a group that is found is instead taken
+ *              out of the cache and returned to the caller.
+ *
+ * Return:      Success:        the group
+ *
+ *              Failure:        NULL, not cached
+ *--------------------------------------------------------------------*/
+PRIVATE PJgroup *
+pj_cache_lookup(pj_objcache_t *cache, char const *path, int remove)
+{
+    pj_cache_entry_t *entry, *prev = NULL;
+    PJgroup *group;
+
+    for (entry = cache->head; entry; prev = entry, entry = entry->next)
+    {
+        if (strcmp(entry->path, path) == 0)
+            break;
+    }
+    if (!entry)
+        return NULL;
+
+    if (prev)
+        prev->next = entry->next;
+    else
+        cache->head = entry->next;
+
+    if (remove)
+    {
+        group = entry->group;
+        cache->nentries--;
+        FREE(entry->path);
+        FREE(entry);
+        return group;
+    }
+
+    entry->next = cache->head;
+    cache->head = entry;
+    return entry->group;
+}
+
+/*----------------------------------------------------------------------
+ * Function:    pj_cache_insert
+ *
+ * Purpose:     Put the group for the object at absolute path PATH at the
+ *              front of the cache, evicting the least recently used
+ *              group when the cache is full.  The cache takes ownership
+ *              of the group.
+ *--------------------------------------------------------------------*/
+PRIVATE void
+pj_cache_insert(pj_objcache_t *cache, char const *path, PJgroup *group)
+{
+    pj_cache_entry_t *entry, *prev;
+
+    entry = ALLOC(pj_cache_entry_t);
+    entry->path = STRDUP(path);
+    entry->group = group;
+    entry->next = cache->head;
+    cache->head = entry;
+
+    if (++cache->nentries <= cache->maxsize)
+        return;
+
+    for (prev = cache->head; prev->next->next; prev = prev->next)
+        /*void*/;
+    entry = prev->next;
+    prev->next = NULL;
+    cache->nentries--;
+    PJ_rel_group(entry->group);
+    FREE(entry->path);
+    FREE(entry);
+}
+
+/*----------------------------------------------------------------------
+ * Function:    pj_get_cached_group
+ *
+ * Purpose:     Get the group description of OBJNAME, from the file's
+ *              object cache when possible.
+ *
+ * Return:      Success:        the group.  If *OWNED is set the group
+ *                              was not cached and the caller must
+ *                              release it with PJ_rel_group.
+ *
+ *              Failure:        NULL
+ *--------------------------------------------------------------------*/
+PRIVATE PJgroup *
+pj_get_cached_group(PDBfile *file, char const *objname, int *owned)
+{
+    pj_objcache_t *cache = pj_find_cache(file);
+    char           path[MAXNAME];
+    PJgroup       *group = NULL;
+
+    *owned = 0;
+    if (!cache || cache->maxsize <= 0 ||
+        !PJ_get_fullpath(lite_PD_pwd(file), objname, path))
+    {
+        if (cache) cache->misses++;
+        db_StatCache(0);
+        *owned = 1;
+        if (!PJ_get_group(file, objname, &group))
+            return NULL;
+        return group;
+    }
+
+    if (use_PJgroup_cache == 0)
+    {
+        /* Forget any cached copy and read the group again. */
+        if ((group = pj_cache_lookup(cache, path, 1)))
+            PJ_rel_group(group);
+        group = NULL;
+    }
+    else if ((group = pj_cache_lookup(cache, path, 0)))
+    {
+        cache->hits++;
+        db_StatCache(1);
+        return group;
+    }
+
+    cache->misses++;
+    db_StatCache(0);
+    if (!PJ_get_group(file, objname, &group) || group == NULL)
+        return NULL;
+    pj_cache_insert(cache, path, group);
+
+    /* Now that we've cached a group, turn caching back on. */
+    use_PJgroup_cache = 1;
+
+    return group;
+}
+
+/*----------------------------------------------------------------------
+ * Function:    PJ_InitCache
+ *
+ * Purpose:     Give an open file an object cache holding up to MAXSIZE
+ *              groups.  A MAXSIZE of 0 turns caching off for the file.
+ *
+ * Return:      0
+ *--------------------------------------------------------------------*/
+INTERNAL int
+PJ_InitCache(PDBfile *file, int maxsize)
+{
+    pj_objcache_t *cache = pj_find_cache(file);
+
+    if (!cache)
+    {
+        cache = ALLOC(pj_objcache_t);
+        memset(cache, 0, sizeof(pj_objcache_t));
+        cache->file = file;
+        cache->next = pj_objcaches;
+        pj_objcaches = cache;
+    }
+    else
+    {
+        pj_cache_release(cache);
+    }
+    cache->maxsize = maxsize < 0 ? 0 : maxsize;
+
+    return 0;
+}
+
+/*----------------------------------------------------------------------
+ * Function:    PJ_FreeCache
+ *
+ * Purpose:     Release a file's object cache when the file is closed.
+ *--------------------------------------------------------------------*/
+INTERNAL void
+PJ_FreeCache(PDBfile *file)
+{
+    pj_objcache_t *cache, *prev = NULL;
+
+    for (cache = pj_objcaches; cache; prev = cache, cache = cache->next)
+    {
+        if (cache->file == file)
+            break;
+    }
+    if (!cache)
+        return;
+
+    if (prev)
+        prev->next = cache->next;
+    else
+        pj_objcaches = cache->next;
+    pj_cache_release(cache);
+    FREE(cache);
+}
+
+/*----------------------------------------------------------------------
+ * Function:    PJ_GetCacheStats
+ *
+ * Purpose:     Report how many object lookups in a file were answered
+ *              from its object cache and how many had to read the file.
+ *
+ * Return:      0 on success, -1 if the file has no cache.
+ *--------------------------------------------------------------------*/
+INTERNAL int
+PJ_GetCacheStats(PDBfile *file, long *hits, long *misses)
+{
+    pj_objcache_t *cache = pj_find_cache(file);
+
+    if (!cache)
+        return -1;
+    if (hits) *hits = cache->hits;
+    if (misses) *misses = cache->misses;
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------
  *  Routine                                                 PJ_GetObject
  *
@@ -565,14 +843,18 @@ PJ_NoCache ( void )
  *      Replaced returned 'ret_type' argument with input expected_dbtype
  *      argument and cause it to fail if type that is read doesn't
  *      match the expected_dbtype.
+ *
+ *      Take the group from the file's object cache instead of the
+ *      single cached group.  Close the other file on errors too.
  *--------------------------------------------------------------------*/
 INTERNAL int
 PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int expected_dbtype)
 {
-    int             i, j, error;
+    int             i, j, owned;
     char           *varname=NULL, *filename=NULL;
     char const     *objname=NULL;
     PDBfile        *file=NULL;
+    PJgroup        *group=NULL;
     char           *me = "PJ_GetObject";
 
     if (!file_in)
@@ -608,87 +890,51 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
         file = file_in;
     }
 
-    /* Read object description if we don't have it cached.
-     *
-     * There are three things that we have to check:
-     *     use_PJgroup_cache is true
-     *     cache_obj_name is the same as the passed-in name
-     *     cache_file_name is the same as the passed-in file's name
-     *
-     * If any of these are false, we can't use the cached PJgroup and must
-     * instead read a new one from the PDBfile.
-     */
-    if ((use_PJgroup_cache == 0) ||
-        (cached_obj_name == NULL) || (strcmp(cached_obj_name, objname) != 0) ||
-        (cached_file_name == NULL) || (strcmp(cached_file_name, file->name)))
+    /* Get the object description, from the file's object cache if we
+     * have already read it.  Objects in files named by the object name
+     * itself are never cached since those files are closed again below. */
+    group = pj_get_cached_group(file, objname, &owned);
+    if (group == NULL)
     {
-        PJ_ClearCache();
-        error = !PJ_get_group(file, objname, &cached_group);
-        if (error || cached_group == NULL)
+        char err_str[256];
+        sprintf(err_str,"PJ_get_group: Probably no such object \"%s\".",objname);
+        FREE(varname);
+        if (filename != NULL)
         {
-            char err_str[256];
-            sprintf(err_str,"PJ_get_group: Probably no such object \"%s\".",objname);
-            FREE(varname);
             FREE(filename);
-            db_perror(err_str, E_CALLFAIL, me);
-            return -1;
-        }
-
-        /* Check object type before we do any allocations */
-        if (expected_dbtype > 0)
-        {
-            int matched = 1;
-            if (expected_dbtype == DB_QUADMESH)
-            {
-                if ((strcmp(cached_group->type, DBGetObjtypeName(DB_QUAD_RECT)) != 0) &&
-                    (strcmp(cached_group->type, DBGetObjtypeName(DB_QUAD_CURV)) != 0))
-                    matched = 0;
-            }  
-            else if (strcmp(cached_group->type, DBGetObjtypeName(expected_dbtype)) != 0)
-            {
-                matched = 0;
-            }
-            if (!matched)
-            {
-                char error[256];
-                sprintf(error,"Requested %s object \"%s\" is not a %s.",
-                    cached_group->type, objname_in, DBGetObjtypeName(expected_dbtype));
-                FREE(varname);
-                FREE(filename);
-                db_perror(error, E_NOTFOUND, me);
-                return -1;
-            }
+            lite_PD_close(file);
         }
-
-        /* We've gotten a new group, remember which one it is. */
-        cached_obj_name = STRDUP(objname);
-        cached_file_name = STRDUP(file->name);
-
-        /* Now that we've cached a group, turn caching back on. */
-        use_PJgroup_cache = 1;
+        db_perror(err_str, E_CALLFAIL, me);
+        return -1;
     }
 
-    /* Check object type */
+    /* Check object type before we do any allocations */
     if (expected_dbtype > 0)
     {
         int matched = 1;
         if (expected_dbtype == DB_QUADMESH)
         {
-            if ((strcmp(cached_group->type, DBGetObjtypeName(DB_QUAD_RECT)) != 0) &&
-                (strcmp(cached_group->type, DBGetObjtypeName(DB_QUAD_CURV)) != 0))
+            if ((strcmp(group->type, DBGetObjtypeName(DB_QUAD_RECT)) != 0) &&
+                (strcmp(group->type, DBGetObjtypeName(DB_QUAD_CURV)) != 0))
                 matched = 0;
         }  
-        else if (strcmp(cached_group->type, DBGetObjtypeName(expected_dbtype)) != 0)
+        else if (strcmp(group->type, DBGetObjtypeName(expected_dbtype)) != 0)
         {
             matched = 0;
         }
         if (!matched)
         {
             char error[256];
-            FREE(varname);
-            FREE(filename);
             sprintf(error,"Requested %s object \"%s\" is not a %s.",
-                cached_group->type, objname_in, DBGetObjtypeName(expected_dbtype));
+                group->type, objname_in, DBGetObjtypeName(expected_dbtype));
+            if (owned)
+                PJ_rel_group(group);
+            FREE(varname);
+            if (filename != NULL)
+            {
+                FREE(filename);
+                lite_PD_close(file);
+            }
             db_perror(error, E_NOTFOUND, me);
             return -1;
         }
@@ -698,10 +944,10 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
      * locations.  */
     for (i = 0; i < tobj->num; i++)
     {
-        for (j = 0; j < cached_group->ncomponents; j++)
+        for (j = 0; j < group->ncomponents; j++)
         {
             if (tobj->ptr[i] != NULL &&
-                STR_EQUAL(cached_group->comp_names[j], tobj->name[i]))
+                STR_EQUAL(group->comp_names[j], tobj->name[i]))
             {
 
                 /*
@@ -709,7 +955,7 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
                  *  pointer (i.e., ptr[i]). If not alloced, address
                  *  is already in the ptr[i] element.
                  */
-                PJ_ReadVariable(file, cached_group->pdb_names[j],
+                PJ_ReadVariable(file, group->pdb_names[j],
                                 tobj->type[i], (int)tobj->alloced[i],
                                 (tobj->alloced[i]) ?
                                 (char **)&tobj->ptr[i] :
@@ -719,6 +965,9 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
         }
     }
 
+    if (owned)
+        PJ_rel_group(group);
+
     /*
      * If the variable was from another file the file.
      */
@@ -737,6 +986,7 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
  * Function:                                             PJ_ClearCache
  *
  * Purpose:     Frees up the storage associated with the cache.
+ *              The caches themselves stay in place.
  *
  * Programmer:  Sean Ahern, Mon Nov 23 17:19:17 PST 1998
  *
@@ -748,26 +998,20 @@ PJ_GetObject(PDBfile *file_in, char const *objname_in, PJcomplist *tobj, int exp
  *    Brad Whitlock, Thu Jan 20 15:32:27 PST 2000
  *    Added the void to the argument list to preserve the prototype.
  *
+ *    Clear the object cache of the given file, or of every file if
+ *    FILE is NULL.
  *--------------------------------------------------------------------*/
 INTERNAL int
-PJ_ClearCache(void)
+PJ_ClearCache(PDBfile *file)
 {
-    int error;
-    static char *me = "PJ_ClearCache";
+    pj_objcache_t *cache;
 
-    /* Free up the old group. */
-    if (cached_group)
+    /* Free up the cached groups. */
+    for (cache = pj_objcaches; cache; cache = cache->next)
     {
-        error = !PJ_rel_group(cached_group);
-        if (error)
-        {
-            db_perror("PJ_rel_group", E_CALLFAIL, me);
-            return -1;
-        }
-        cached_group = NULL;
+        if (file == NULL || cache->file == file)
+            pj_cache_release(cache);
     }
-    FREE(cached_obj_name);
-    FREE(cached_file_name);
 
     return 0;
 }
@@ -829,45 +1073,62 @@ PJ_GetComponent (PDBfile *file, char const *objname, char const *compname) {
  *
  *  Modified
  *
+ *      Look the group up in the file's object cache directly instead
+ *      of reading a component through PJ_GetObject first.
  *--------------------------------------------------------------------
  */
 INTERNAL int
-PJ_GetComponentType (PDBfile *file, char const *objname, char const *compname)
+PJ_GetComponentType (PDBfile *file_in, char const *objname_in, char const *compname)
 {
    int  retval = DB_NOTYPE;
+   int  owned;
+   char *varname = NULL, *filename = NULL;
+   char const *objname;
+   PDBfile *file;
+   PJgroup *group;
    char *me = "PJ_GetComponentType";
-   PJcomplist    *_tcl;
 
-   /* If there is no cached group, or we are interested in a
-    * different object, get the one we want.  */
-   if(cached_group == NULL || cached_obj_name == NULL ||
-      (!STR_EQUAL(cached_obj_name, objname)))
+   if (db_pdb_ParseVDBSpec(objname_in, &varname, &filename) < 0)
    {
-       char       *result = NULL;
-       PJcomplist tmp_obj;
-
-       /* Read just the requested component of the given object */
-       INIT_OBJ(&tmp_obj);
-       DEFALL_OBJ(compname, &result, DB_NOTYPE);
-
-       if (PJ_GetObject(file, objname, &tmp_obj, 0) < 0) {
-          db_perror("PJ_GetObject", E_CALLFAIL, me);
-          return DB_NOTYPE;
+       FREE(varname);
+       db_perror("objname", E_BADARGS, me);
+       return DB_NOTYPE;
+   }
+   if (filename != NULL)
+   {
+       objname = varname;
+       if ((file = lite_PD_open(filename, "r")) == NULL)
+       {
+           FREE(varname);
+           FREE(filename);
+           db_perror("objname", E_BADARGS, me);
+           return DB_NOTYPE;
        }
-       FREE(result);
+#ifdef USING_PDB_PROPER
+       PD_set_track_pointers(file, FALSE);
+#endif
+   }
+   else
+   {
+       objname = objname_in;
+       file = file_in;
    }
 
-   /* If there is now cached group information (and there should be)
+   /* Get the group, from the object cache if we've already read it,
     * then look for the component in the group and determine its type.  */
-   if(use_PJgroup_cache && cached_group)
+   if ((group = pj_get_cached_group(file, objname, &owned)) == NULL)
+   {
+       db_perror("PJ_get_group", E_CALLFAIL, me);
+   }
+   else
    {
        int i, index, found = 0;
 
-       /* Look through the cached group's component list to find
+       /* Look through the group's component list to find
         * the appropriate index.  */
-        for(i = 0; i < cached_group->ncomponents; i++)
+        for(i = 0; i < group->ncomponents; i++)
         {
-            if(strcmp(compname, cached_group->comp_names[i]) == 0)
+            if(strcmp(compname, group->comp_names[i]) == 0)
             {
                 found = 1;
                 index = i;
@@ -881,18 +1142,27 @@ PJ_GetComponentType (PDBfile *file, char const *objname, char const *compname)
          * string, or variable.  */
         if(found)
         {
-            if(strncmp(cached_group->pdb_names[index], "'<i>", 4) == 0)
+            if(strncmp(group->pdb_names[index], "'<i>", 4) == 0)
                 retval = DB_INT;
-            else if(strncmp(cached_group->pdb_names[index], "'<f>", 4) == 0)
+            else if(strncmp(group->pdb_names[index], "'<f>", 4) == 0)
                 retval = DB_FLOAT;
-            else if(strncmp(cached_group->pdb_names[index], "'<d>", 4) == 0)
+            else if(strncmp(group->pdb_names[index], "'<d>", 4) == 0)
                 retval = DB_DOUBLE;
-            else if(strncmp(cached_group->pdb_names[index], "'<s>", 4) == 0)
+            else if(strncmp(group->pdb_names[index], "'<s>", 4) == 0)
                 retval = DB_CHAR;
             else
                 retval = DB_VARIABLE;
         }
+        if (owned)
+            PJ_rel_group(group);
+   }
+
+   if (filename != NULL)
+   {
+       FREE(filename);
+       lite_PD_close(file);
    }
+   FREE(varname);
 
    return retval;
 }
@@ -1470,6 +1740,8 @@ reduce_path(char *path, char *npath)
  *    Eric Brugger, Mon Dec  7 11:03:09 PST 1998
  *    Removed call to lite_PD_reset_ptr_list since it was removed.
  *
+ *    Count the read as metadata in the file's statistics.
+ *
  *--------------------------------------------------------------------
  */
 INTERNAL int
@@ -1479,6 +1751,7 @@ PJ_get_group(
    PJgroup      **group)       /* Variable to write into */
 {
    syment	*ep;
+   int		 ret;
    
    /*
     * Make sure the thing we're looking up is really a group.
@@ -1486,8 +1759,11 @@ PJ_get_group(
    ep = lite_PD_inquire_entry (file, (char *) name, TRUE, NULL);
    if (!ep || strcmp(PD_entry_type(ep), "Group *")) return 0;
 
+   DB_STATS_META_BEGIN();
+   ret = (int)PJ_read(file, name, group);
+   DB_STATS_META_END();
 
-   return ((int)PJ_read(file, name, group));
+   return (ret);
 
 }
 
@@ -1662,6 +1938,8 @@ PJ_print_group (PJgroup *group, FILE *fp) {
  *    Eric Brugger, Mon Dec  7 11:03:09 PST 1998
  *    Removed call to lite_PD_reset_ptr_list since it was removed.
  *
+ *    Count the write as metadata in the file's statistics.
+ *
  *--------------------------------------------------------------------
  */
 #ifdef PDB_WRITE
@@ -1674,6 +1952,7 @@ PJ_put_group (
 
    char         **varlist;
    char           name[MAXNAME];
+   int            ret;
 
    if (file == NULL || group == NULL)
       return (FALSE);
@@ -1721,7 +2000,11 @@ PJ_put_group (
    /*----------------------------------------
     *  Write the group description variable.
     *----------------------------------------*/
-   return ((int)PJ_write(file, name, "Group *", &group));
+   DB_STATS_META_BEGIN();
+   ret = (int)PJ_write(file, name, "Group *", &group);
+   DB_STATS_META_END();
+
+   return (ret);
 }
 #endif /* PDB_WRITE */
 
@@ -2002,6 +2285,11 @@ db_pdb_InitCallbacks ( DBfile *dbfile )
  *
  *    Sean Ahern, Mon Nov 23 17:29:17 PST 1998
  *    Added clearing of the object cache when the file is closed.
+ *
+ *    Free only this file's object cache.  Other open files keep theirs.
+ *
+ *    Count the symbol table and structure chart written at close as
+ *    metadata.
  *-------------------------------------------------------------------------*/
 SILO_CALLBACK int
 db_pdb_close(DBfile *_dbfile)
@@ -2013,19 +2301,16 @@ db_pdb_close(DBfile *_dbfile)
       /*
        * Free the private parts of the file.
        */
+      PJ_FreeCache(dbfile->pdb);
+      DB_STATS_META_BEGIN();
       lite_PD_close(dbfile->pdb);
+      DB_STATS_META_END();
       dbfile->pdb = NULL;
 
-      /* We've closed a file, so we can't cache PJgroups any more */
-      PJ_NoCache();
-
       /*
        * Free the public parts of the file.
        */
       silo_db_close(_dbfile);
-
-      /* Clear the current object cache. */
-      PJ_ClearCache();
    }
    return 0;
 }
@@ -2055,6 +2340,58 @@ db_pdb_flush(DBfile *_dbfile)
    return retval;
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    db_pdb_file_option
+ *
+ * Purpose:     Return the value of integer OPTION in a file options set,
+ *              or DFLT if the set doesn't have it.
+ *-------------------------------------------------------------------------*/
+PRIVATE int
+db_pdb_file_option(int opts_set_id, int option, int dflt)
+{
+    if (opts_set_id > DB_FILE_OPTS_LAST)
+    {
+        DBoptlist const *opts =
+            SILO_Globals.fileOptionsSets[opts_set_id-NUM_DEFAULT_FILE_OPTIONS_SETS];
+        void *p;
+
+        if (opts && (p = DBGetOption(opts, option)))
+            return *((int*)p);
+    }
+
+    return dflt;
+}
+
+#ifndef USING_PDB_PROPER
+/* Count PDB-lite's stdio traffic in the current file's statistics */
+SILO_CALLBACK void
+db_pdb_io_stats(int op, long nbytes)
+{
+    if (op == PD_READ)
+        db_StatRead(DB_STATS_META, nbytes);
+    else if (op == PD_WRITE)
+        db_StatWrite(DB_STATS_META, nbytes);
+    else if (op == PD_SEEK)
+        db_StatSeek();
+}
+#endif
+
+/* Open a PDB file, counting its header, symbol table and structure
+   chart as metadata */
+PRIVATE PDBfile *
+db_pdb_open_file(char const *name, char *mode)
+{
+    PDBfile *pdb;
+
+#ifndef USING_PDB_PROPER
+    lite_PD_io_stats_hook = db_pdb_io_stats;
+#endif
+    DB_STATS_META_BEGIN();
+    pdb = lite_PD_open((char*)name, mode);
+    DB_STATS_META_END();
+    return pdb;
+}
+
 /*-------------------------------------------------------------------------
  * Function:    db_pdb_Open
  *
@@ -2092,6 +2429,12 @@ db_pdb_flush(DBfile *_dbfile)
  *
  *    Mark C. Miller, Wed Feb 25 09:37:48 PST 2009
  *    Changed error code for failure to open to E_DRVRCANTOPEN
+ *
+ *    Give the file an object cache sized by the file options set.
+ *
+ *    Memory map files opened DB_READ when DBOPT_PDB_MMAP is set.
+ *
+ *    Count the file's I/O in its statistics.
  *-------------------------------------------------------------------------*/
 INTERNAL DBfile *
 db_pdb_Open(char const *name, int mode, int opts_set_id)
@@ -2111,14 +2454,24 @@ db_pdb_Open(char const *name, int mode, int opts_set_id)
     }
     if (mode == DB_READ)
     {
-        if (NULL == (pdb = lite_PD_open((char*)name, "r")))
+#ifndef USING_PDB_PROPER
+        int use_mmap = lite_PD_use_mmap;
+
+        lite_PD_set_mmap(db_pdb_file_option(opts_set_id, DBOPT_PDB_MMAP,
+            use_mmap));
+        pdb = db_pdb_open_file(name, "r");
+        lite_PD_set_mmap(use_mmap);
+#else
+        pdb = db_pdb_open_file(name, "r");
+#endif
+        if (NULL == pdb)
         {
             db_perror(NULL, E_DRVRCANTOPEN, me);
             return NULL;
         }
     } else if (mode == DB_APPEND)
     {
-        if (NULL == (pdb = lite_PD_open((char*)name, "a")))
+        if (NULL == (pdb = db_pdb_open_file(name, "a")))
         {
             db_perror(NULL, E_DRVRCANTOPEN, me);
             return NULL;
@@ -2151,6 +2504,8 @@ db_pdb_Open(char const *name, int mode, int opts_set_id)
     dbfile->pub.type = DB_PDBP;
 #endif
     dbfile->pdb = pdb;
+    PJ_InitCache(pdb, db_pdb_file_option(opts_set_id, DBOPT_PDB_OBJ_CACHE_SIZE,
+        PJ_OBJ_CACHE_SIZE));
     db_pdb_InitCallbacks((DBfile *) dbfile);
     return (DBfile *) dbfile;
 }
@@ -2195,6 +2550,10 @@ db_pdb_Open(char const *name, int mode, int opts_set_id)
  *
  *    Thomas R. Treadway, Wed Feb 28 11:36:34 PST 2007
  *    Checked for compression option.
+ *
+ *    Give the file an object cache sized by the file options set.
+ *
+ *    Count the file's I/O in its statistics.
  *-------------------------------------------------------------------------*/
 /* ARGSUSED */
 INTERNAL DBfile *
@@ -2257,7 +2616,7 @@ db_pdb_Create (char const *name, int mode, int target, int opts_set_id, char con
 #endif
     db_pdb_InitCallbacks((DBfile *) dbfile);
 
-    if (NULL == (dbfile->pdb = lite_PD_open((char*)name, "w")))
+    if (NULL == (dbfile->pdb = db_pdb_open_file(name, "w")))
     {
         FREE(dbfile->pub.name);
         FREE(dbfile);
@@ -2267,6 +2626,8 @@ db_pdb_Create (char const *name, int mode, int target, int opts_set_id, char con
 #ifdef USING_PDB_PROPER
     PD_set_track_pointers(dbfile->pdb, FALSE);
 #endif
+    PJ_InitCache(dbfile->pdb, db_pdb_file_option(opts_set_id,
+        DBOPT_PDB_OBJ_CACHE_SIZE, PJ_OBJ_CACHE_SIZE));
     DBNewToc((DBfile *) dbfile);
     if (finfo)
     {
@@ -6894,6 +7255,9 @@ db_pdb_ReadVarVals(DBfile *_dbfile, char const *vname, int mode,
  *
  *    Sean Ahern, Mon Jul  1 14:06:08 PDT 1996
  *    Turned off the PJgroup cache when we change directories.
+ *
+ *    Leave the object cache alone.  It is keyed by absolute path so
+ *    changing directories cannot make it return the wrong object.
  *-------------------------------------------------------------------------*/
 SILO_CALLBACK int
 db_pdb_SetDir (DBfile *_dbfile, char const *path)
@@ -6905,9 +7269,6 @@ db_pdb_SetDir (DBfile *_dbfile, char const *path)
    if (1 == lite_PD_cd(dbfile->pdb, (char*) path)) {
       dbfile->pub.dirid = 0;
 
-      /* We've changed directories, so we can't cache PJgroups any more */
-      PJ_NoCache();
-
       /* Must make new table-of-contents since dir has changed */
       db_FreeToc(_dbfile);
    }
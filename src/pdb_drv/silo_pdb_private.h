@@ -352,7 +352,10 @@ PRIVATE int pdb_getvarinfo (PDBfile *, char *, char *, int *, int *, int);
 
 PRIVATE int PJ_ForceSingle (int);
 PRIVATE int PJ_GetObject (PDBfile *, char const *, PJcomplist *, int expected_dbtype);
-PRIVATE int PJ_ClearCache(void);
+PRIVATE int PJ_ClearCache(PDBfile *);
+PRIVATE int PJ_InitCache(PDBfile *, int);
+PRIVATE void PJ_FreeCache(PDBfile *);
+PRIVATE int PJ_GetCacheStats(PDBfile *, long *, long *);
 PRIVATE int PJ_InqForceSingle (void);
 PRIVATE void PJ_NoCache ( void );
 PRIVATE void *PJ_GetComponent (PDBfile *, char const *, char const *);
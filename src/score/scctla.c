@@ -535,6 +535,149 @@ lite_SC_ref_count (lite_SC_byte *p) {
 }
 
 
+/*
+ * Arena storage is carved out of large chunks which are chained
+ * together through their first header-sized slot.
+ */
+struct s_SC_arena {
+   char		*chunks;
+   char		*next;
+   long		avail;
+   long		chunk_size;
+};
+
+
+/*-------------------------------------------------------------------------
+ * Function:	lite_SC_make_arena
+ *
+ * Purpose:	Create an arena from which many small objects with a
+ *		common lifetime can be allocated without a trip to the
+ *		system allocator for each one. CHUNK is the size in bytes
+ *		of the blocks requested from the system (a default is used
+ *		if CHUNK is not positive).
+ *
+ * Return:	Success:	Ptr to a new arena
+ *
+ *		Failure:	NULL
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+SC_arena *
+lite_SC_make_arena (long chunk) {
+
+   SC_arena *arena;
+
+   arena = (SC_arena *) _SC_ALLOC(sizeof(SC_arena));
+   if (arena == NULL) return(NULL);
+
+   arena->chunks     = NULL;
+   arena->next       = NULL;
+   arena->avail      = 0L;
+   arena->chunk_size = (chunk > 0) ? chunk : 65536L;
+
+   return(arena);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	lite_SC_arena_alloc
+ *
+ * Purpose:	Allocate NITEMS*BYTEPITEM bytes from ARENA. The space is
+ *		preceded by a regular SCORE header so lite_SC_arrlen and
+ *		friends work on it, but the reference count is UNCOLLECT so
+ *		that lite_SC_free and lite_SC_mark leave it alone. The space
+ *		is reclaimed only by lite_SC_rl_arena and must never be
+ *		passed to lite_SC_realloc.
+ *
+ * Return:	Success:	Ptr to user memory
+ *
+ *		Failure:	NULL
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+lite_SC_byte *
+lite_SC_arena_alloc (SC_arena *arena, long nitems, long bytepitem,
+                     char *name) {
+
+   long nb, nbp, ncx;
+   char *chunk;
+   mem_header *space;
+   mem_descriptor *desc;
+
+   if (arena == NULL) return(NULL);
+
+   nb = nitems*bytepitem;
+   if ((nb <= 0) || (nb > Sz_max)) return(NULL);
+
+   /*
+    * Keep every header aligned like the one lite_SC_alloc returns.
+    */
+   nbp = Sz + ((nb + sizeof(double) - 1)/sizeof(double))*sizeof(double);
+
+   if (nbp > arena->avail) {
+      ncx   = MAX(arena->chunk_size, nbp + (long) Sz);
+      chunk = (char *) _SC_ALLOC((size_t) ncx);
+      if (chunk == NULL) return(NULL);
+
+      *(char **) chunk = arena->chunks;
+      arena->chunks    = chunk;
+      arena->next      = chunk + Sz;
+      arena->avail     = ncx - Sz;
+   }
+
+   space = (mem_header *) arena->next;
+   arena->next  += nbp;
+   arena->avail -= nbp;
+
+   desc = &space->block;
+#ifdef NEED_MEM_TRACE
+   desc->name      = name;
+   desc->id        = SC_MEM_ID;
+   desc->type      = 0;
+   desc->prev      = NULL;
+   desc->next      = NULL;
+#endif
+   desc->ref_count = UNCOLLECT;
+   desc->length    = nb;
+
+   space++;
+   if (_SC_zero_space) memset(space, 0, nb);
+
+   return((lite_SC_byte *) space);
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:	lite_SC_rl_arena
+ *
+ * Purpose:	Release ARENA and every object allocated from it.
+ *
+ * Return:	void
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+void
+lite_SC_rl_arena (SC_arena *arena) {
+
+   char *chunk, *nxt;
+
+   if (arena == NULL) return;
+
+   for (chunk = arena->chunks; chunk != NULL; chunk = nxt) {
+      nxt = *(char **) chunk;
+      _SC_FREE(chunk);
+   }
+
+   _SC_FREE(arena);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:	_SC_prim_alloc
  *
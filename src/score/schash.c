@@ -273,6 +273,7 @@ lite_SC_install (char *name, lite_SC_byte *obj, char *type, HASHTAB *tab) {
  *    Eric Brugger, Thu Sep 23 10:16:30 PDT 1999
  *    Remove the mark flag from the argument list.
  *
+ *    Grow the table when the average chain length exceeds HSZLOAD.
  *-------------------------------------------------------------------------
  */
 hashel *
@@ -299,6 +300,14 @@ _lite_SC_install (char *name, lite_SC_byte *obj, char *type, HASHTAB *tab) {
       np->next    = tb[hashval];
       tb[hashval] = np;
       (tab->nelements)++;
+
+      /*
+       * Grow the table once the chains get long. Single bucket tables
+       * (the structure charts) are walked in insertion order and are
+       * never resized.
+       */
+      if ((sz > 1) && (tab->nelements > HSZLOAD*sz) && (sz < INT_MAX/4))
+         lite_SC_resize_hash_table(tab, 2*sz+1);
    }
 
    np->type = type;
@@ -462,6 +471,59 @@ lite_SC_make_hash_table (int sz, int docflag) {
 }
 
 
+/*-------------------------------------------------------------------------
+ * Function:	lite_SC_resize_hash_table
+ *
+ * Purpose:	Rehash the entries of TAB into a new bucket array of
+ *		size SZ. The hashel structs themselves are relinked, not
+ *		copied, so pointers to them remain valid.
+ *
+ * Return:	Success:	TRUE
+ *
+ *		Failure:	FALSE
+ *
+ * Modifications:
+ *
+ *-------------------------------------------------------------------------
+ */
+int
+lite_SC_resize_hash_table (HASHTAB *tab, int sz) {
+
+   hashel **otb, **ntb, *np, *nxt;
+   int i, osz, hashval;
+
+   if ((tab == NULL) || (sz < 1)) return(FALSE);
+
+   osz = tab->size;
+   if (sz == osz) return(TRUE);
+
+   ntb = FMAKE_N(hashel *, sz, "SC_RESIZE_HASH_TABLE:tb");
+   if (ntb == NULL) return(FALSE);
+   for (i = 0; i < sz; i++) ntb[i] = NULL;
+
+   /*
+    * Walk each old chain from its head and push onto the new chains.
+    * This reverses the relative order of colliding entries which
+    * is of no consequence for tables with more than one bucket.
+    */
+   otb = tab->table;
+   for (i = 0; i < osz; i++) {
+      for (np = otb[i]; np != NULL; np = nxt) {
+         nxt          = np->next;
+         hashval      = lite_SC_hash(np->name, sz);
+         np->next     = ntb[hashval];
+         ntb[hashval] = np;
+      }
+   }
+
+   SFREE(otb);
+   tab->table = ntb;
+   tab->size  = sz;
+
+   return(TRUE);
+}
+
+
 /*-------------------------------------------------------------------------
  * Function:	lite_SC_rl_hash_table
  *
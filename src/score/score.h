@@ -138,6 +138,8 @@ extern "C" {
 #define HSZMEDIUM	 	5231
 #define HSZLARGE		52121
 #define HSZXLARGE		521021
+/* Tables with more than this many entries per bucket are grown */
+#define HSZLOAD			2
 #define SC_BITS_BYTE		8
 
 #define SC_CHAR_I        	1
@@ -305,6 +307,13 @@ typedef struct s_hashtab {
    hashel 	**table;
 } HASHTAB ;
 
+/*
+ * Arena for many small objects which all live until the arena is
+ * released.  Objects handed out carry an UNCOLLECT header so that
+ * SFREE on them is a harmless no-op.
+ */
+typedef struct s_SC_arena SC_arena ;
+
 typedef union u_SC_address {
    long		diskaddr;
    PFInt 	funcaddr;
@@ -351,6 +360,7 @@ extern PFfwrite lite_io_write_hook; /* NOT_LITE_API */
 /*--------------------------------------------------------------------------*/
 
 LITE_API extern lite_SC_byte *	lite_SC_alloc (long,long,char*);
+LITE_API extern lite_SC_byte *	lite_SC_arena_alloc (SC_arena*,long,long,char*);
 LITE_API extern long	lite_SC_arrlen (lite_SC_byte*);
 LITE_API extern char *	lite_SC_date (void);
 LITE_API extern lite_SC_byte *	lite_SC_def_lookup (char*,HASHTAB*);
@@ -364,11 +374,14 @@ LITE_API extern int	lite_SC_hash_rem (char*,HASHTAB*);
 LITE_API extern hashel *lite_SC_install (char*,lite_SC_byte*,char*,HASHTAB*);
 LITE_API extern char *	lite_SC_lasttok (char*,char*);
 LITE_API extern hashel *lite_SC_lookup (char*,HASHTAB*);
+LITE_API extern SC_arena *lite_SC_make_arena (long);
 LITE_API extern HASHTAB *lite_SC_make_hash_table (int,int);
 LITE_API extern int	lite_SC_mark (lite_SC_byte*,int);
 LITE_API extern lite_SC_byte *	lite_SC_realloc (lite_SC_byte*,long,long);
 LITE_API extern int	lite_SC_ref_count (lite_SC_byte*);
 LITE_API extern int	lite_SC_regx_match (char*,char*);
+LITE_API extern int	lite_SC_resize_hash_table (HASHTAB*,int);
+LITE_API extern void	lite_SC_rl_arena (SC_arena*);
 LITE_API extern void	lite_SC_rl_hash_table (HASHTAB*);
 LITE_API extern int	lite_SC_stoi (char*);
 LITE_API extern long	lite_SC_stol (char*);
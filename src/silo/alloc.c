@@ -81,6 +81,7 @@ be used for advertising or product endorsement purposes.
  *      flist   = DBAllocFacelist ()    << Facelist >>
  *      zlist   = DBAllocZonelist ()    << Zonelist >>
  *      mat     = DBAllocMaterial()     << Material >>
+ *      csr     = DBAllocMatcsr()       << CSR material >>
  *      species = DBAllocMatspecies()   << Matspecies >>
  *      array   = DBAllocCompoundarray()<< Compoundarray >>
  *
@@ -893,7 +894,7 @@ DBFreeQuadmesh(DBquadmesh *msh)
         return;
 
     for (i = 0; i < 3; i++) {
-        FREE(msh->coords[i]);
+        FREE_BULK(msh->coords[i]);
         FREE(msh->labels[i]);
         FREE(msh->units[i]);
     }
@@ -974,12 +975,12 @@ DBFreePointmesh(DBpointmesh *msh)
         return;
 
     for (i = 0; i < 3; i++) {
-        FREE(msh->coords[i]);
+        FREE_BULK(msh->coords[i]);
         FREE(msh->labels[i]);
         FREE(msh->units[i]);
     }
 
-    FREE(msh->gnodeno);
+    FREE_BULK(msh->gnodeno);
     FREE(msh->name);
     FREE(msh->title);
     FREE(msh->mrgtree_name);
@@ -1046,7 +1047,7 @@ DBFreeMeshvar(DBmeshvar *var)
     if (var->vals != NULL)
     {
         for (i = 0; i < var->nvals; i++) {
-            FREE(var->vals[i]);
+            FREE_BULK(var->vals[i]);
         }
     }
 
@@ -1153,7 +1154,7 @@ DBFreeUcdmesh(DBucdmesh *msh)
         return;
 
     for (i = 0; i < 3; i++) {
-        FREE(msh->coords[i]);
+        FREE_BULK(msh->coords[i]);
         FREE(msh->labels[i]);
         FREE(msh->units[i]);
     }
@@ -1164,7 +1165,7 @@ DBFreeUcdmesh(DBucdmesh *msh)
     DBFreePHZonelist(msh->phzones);
 
     FREE(msh->nodeno);
-    FREE(msh->gnodeno);
+    FREE_BULK(msh->gnodeno);
     FREE(msh->name);
     FREE(msh->mrgtree_name);
     FREE(msh);
@@ -1229,7 +1230,7 @@ DBFreeCsgvar(DBcsgvar *var)
 
     if (var->vals != NULL) {
         for (i = 0; i < var->nvals; i++) {
-            FREE(var->vals[i]);
+            FREE_BULK(var->vals[i]);
         }
     }
 
@@ -1326,9 +1327,9 @@ DBFreeQuadvar(DBquadvar *var)
 
     if (var->vals != NULL) {
         for (i = 0; i < var->nvals; i++) {
-            FREE(var->vals[i]);
+            FREE_BULK(var->vals[i]);
             if (var->mixvals != NULL)
-                FREE(var->mixvals[i]);
+                FREE_BULK(var->mixvals[i]);
         }
     }
 
@@ -1436,9 +1437,9 @@ DBFreeUcdvar(DBucdvar *var)
     if (var->vals != NULL)
     {
         for (i = 0; i < var->nvals; i++) {
-            FREE(var->vals[i]);
+            FREE_BULK(var->vals[i]);
             if (var->mixvals != NULL)
-                FREE(var->mixvals[i]);
+                FREE_BULK(var->mixvals[i]);
         }
     }
 
@@ -1586,9 +1587,9 @@ DBFreeZonelist(DBzonelist *list)
     FREE(list->shapecnt);
     FREE(list->shapesize);
     FREE(list->shapetype);
-    FREE(list->nodelist);
+    FREE_BULK(list->nodelist);
     FREE(list->zoneno);
-    FREE(list->gzoneno);
+    FREE_BULK(list->gzoneno);
     FREE(list);
 }
 
@@ -1606,13 +1607,13 @@ DBFreePHZonelist(DBphzonelist *list)
     if (list == NULL)
         return;
 
-    FREE(list->nodecnt);
-    FREE(list->nodelist);
+    FREE_BULK(list->nodecnt);
+    FREE_BULK(list->nodelist);
     FREE(list->extface);
-    FREE(list->facecnt);
-    FREE(list->facelist);
+    FREE_BULK(list->facecnt);
+    FREE_BULK(list->facelist);
     FREE(list->zoneno);
-    FREE(list->gzoneno);
+    FREE_BULK(list->gzoneno);
     FREE(list);
 }
 
@@ -1755,11 +1756,11 @@ DBFreeFacelist(DBfacelist *list)
 
     FREE(list->shapecnt);
     FREE(list->shapesize);
-    FREE(list->nodelist);
+    FREE_BULK(list->nodelist);
     FREE(list->types);
     FREE(list->typelist);
     FREE(list->nodeno);
-    FREE(list->zoneno);
+    FREE_BULK(list->zoneno);
     FREE(list);
 }
 
@@ -1822,15 +1823,56 @@ DBFreeMaterial(DBmaterial *mats)
 
     FREE(mats->name);
     FREE(mats->matnos);
-    FREE(mats->matlist);
-    FREE(mats->mix_vf);
-    FREE(mats->mix_next);
-    FREE(mats->mix_zone);
-    FREE(mats->mix_mat);
+    FREE_BULK(mats->matlist);
+    FREE_BULK(mats->mix_vf);
+    FREE_BULK(mats->mix_next);
+    FREE_BULK(mats->mix_zone);
+    FREE_BULK(mats->mix_mat);
     FREE(mats->meshname);
     FREE(mats);
 }
 
+/*----------------------------------------------------------------------
+ *  Function                                             DBAllocMatcsr
+ *
+ *  Purpose
+ *
+ *     Allocate and initialize a compressed sparse row material object.
+ *----------------------------------------------------------------------*/
+PUBLIC DBmatcsr *
+DBAllocMatcsr(void)
+{
+    DBmatcsr      *csr;
+
+    API_BEGIN("DBAllocMatcsr", DBmatcsr *, NULL) {
+        if (NULL == (csr = ALLOC(DBmatcsr)))
+            API_ERROR(NULL, E_NOMEM);
+    }
+    API_END;
+
+    return (csr);
+}
+
+/*----------------------------------------------------------------------
+ *  Function                                              DBFreeMatcsr
+ *
+ *  Purpose
+ *
+ *     Release all storage associated with the given CSR material object.
+ *----------------------------------------------------------------------*/
+PUBLIC void
+DBFreeMatcsr(DBmatcsr *csr)
+{
+    if (csr == NULL)
+        return;
+
+    FREE(csr->matnos);
+    FREE(csr->offsets);
+    FREE(csr->mats);
+    FREE(csr->vfracs);
+    FREE(csr);
+}
+
 PUBLIC int
 DBIsEmptyMaterial(DBmaterial const *mats)
 {
@@ -1919,9 +1961,9 @@ DBFreeMatspecies(DBmatspecies *species)
     FREE(species->name);
     FREE(species->matname);
     FREE(species->nmatspec);
-    FREE(species->species_mf);
-    FREE(species->speclist);
-    FREE(species->mix_speclist);
+    FREE_BULK(species->species_mf);
+    FREE_BULK(species->speclist);
+    FREE_BULK(species->mix_speclist);
     FREE(species);
 }
 
@@ -2070,8 +2112,8 @@ DBFreeCurve (DBcurve *cu)
       FREE (cu->ylabel) ;
       FREE (cu->xunits) ;
       FREE (cu->yunits) ;
-      FREE (cu->x) ;
-      FREE (cu->y) ;
+      FREE_BULK (cu->x) ;
+      FREE_BULK (cu->y) ;
       FREE (cu) ;
    }
 }
@@ -2172,7 +2214,8 @@ DBFreeNamescheme(DBnamescheme *ns)
         if (ns->embedns[i])
             DBFreeNamescheme(ns->embedns[i]);
     }
-    for (i = 0; i < ns->ncspecs; i++)
+    db_FreeNameschemeSpecs(ns);
+    for (i = 0; ns->exprstrs && i < ns->ncspecs; i++)
         FREE(ns->exprstrs[i]);
     FREE(ns->exprstrs);
     FREE(ns);
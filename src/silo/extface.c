@@ -58,24 +58,80 @@ be used for advertising or product endorsement purposes.
  * Maximum size of the hash table.  This should be a prime number.  This
  * was pulled off the web from
  *    http://www.utm.edu/research/primes/notes/10000.txti 
+ *
+ * The faces are no longer kept in a chained table of this size, but the
+ * resulting facelist is still ordered as that table would order it, by
+ * the lowest node number of each face modulo the table size.
  */
 #define HASH_MAX 100003
 
+/*
+ * Faces with at most this many nodes keep them in the Face itself.
+ */
+#define FACE_INLINE 4
+
+/*
+ * The hash of a face divided by FACE_SPREAD picks its bucket in the
+ * face table.  Each run of FACE_PAGE consecutive node numbers is
+ * scattered to a pseudo random page of buckets, and the faces whose
+ * lowest node is a given node share a bucket.  This keeps the faces
+ * of neighboring zones in nearby buckets when the nodes of the mesh
+ * are numbered coherently without crowding the table when they are
+ * not.  The remainder depends on the other nodes and lets most faces
+ * in a bucket be passed over without comparing their nodes.
+ */
+#define FACE_PAGE   64
+#define FACE_SPREAD 64
+
+/*
+ * When the faces are matched by several threads, the zones are made
+ * into faces this many at a time by each thread.
+ */
+#define FACE_PIECE  65536
+
 #define MALLOC_N(T,N)            ((T*)malloc((size_t)((N)*sizeof(T))))
+#define FACE_NODES(F)            ((F)->nNodes <= FACE_INLINE ? (F)->inl : (F)->u.big)
 
 typedef struct Face
 {
     int       nNodes;           /* The number of nodes in the face. */
-    int       *nodes;           /* The nodes making up the face. */
     int       zoneNo;           /* The zone number associated with the face. */
-    struct Face *next;          /* Pointer to another face. */
+    long long seq;              /* The order in which the face was made. */
+    unsigned int hash;          /* Hash of the face ignoring orientation. */
+    int       alive;            /* The face has not been matched. */
+    unsigned int next;          /* The next face in the bucket plus one. */
+    int       inl[FACE_INLINE]; /* The nodes of a small face. */
+    union {
+        int   *big;             /* The nodes of a large face. */
+        size_t next;            /* Next free face plus one. */
+    } u;
 } Face;
 
-typedef struct FaceHash
+typedef struct FaceBuild
+{
+    unsigned int *heads;        /* The newest face of each bucket plus one. */
+    size_t    mask;             /* The number of buckets less one. */
+    size_t    nLive;            /* The number of faces in the table. */
+    Face      *faces;           /* The faces. */
+    size_t    nFaces;           /* The number of faces used. */
+    size_t    maxFaces;         /* The allocated size of faces. */
+    size_t    freeList;         /* The first free face plus one. */
+} FaceBuild;
+
+typedef struct FaceQueue
 {
-    Face      **table;          /* The hash table. */
-    int       size;             /* The size of the hash table. */
-} FaceHash;
+    int       *data;            /* Per face: hash, seq, zone, size, iMin, nodes. */
+    size_t    n;                /* The number of ints used. */
+    size_t    max;              /* The allocated size of data. */
+} FaceQueue;
+
+typedef struct ZoneCursor
+{
+    int       shape;            /* The shape of the zone. */
+    int       shapeZone;        /* The zone number within the shape. */
+    int       zone;             /* The zone number. */
+    int       zoneListIdx;      /* The first entry of the zone in the zonelist. */
+} ZoneCursor;
 
 typedef struct CalcExternalFacesState
 {
@@ -90,17 +146,36 @@ typedef struct CalcExternalFacesState
     int       nShapes;
     int       *matList;
     int       bndMethod;
-    FaceHash  faceHash;
+    ZoneCursor first;           /* The first zone to make faces for. */
+    int       zoneEnd;          /* The zone after the last one. */
+    int       part;             /* The part of the faces this state keeps. */
+    int       nParts;           /* The number of parts. */
+    int       piece;            /* The piece of the zones being made. */
+    long long seq;              /* The number of faces made so far. */
+    FaceQueue *queues;          /* The faces made for each part. */
+    struct CalcExternalFacesState *makers; /* The states that made them. */
+    int       nMakers;          /* The number of makers. */
+    FaceBuild build;
 } CalcExternalFacesState;
 
-PRIVATE Face *AllocFace(void);
+PRIVATE size_t AllocFace(FaceBuild *build);
 PRIVATE DBfacelist *CalcExternalFaces(int *zoneList, int nNodes,
     int lowOffset, int highOffset, int origin, int *shapeType, int *shapeSize,
     int *shapeCnt, int nShapes, int *matList, int bndMethod);
-PRIVATE DBfacelist *FormFaceList(CalcExternalFacesState *st);
-PRIVATE void FreeFace(Face *face);
+PRIVATE DBfacelist *FormFaceList(CalcExternalFacesState *st, int nParts);
+PRIVATE void FreeFace(FaceBuild *build, size_t iFace);
+PRIVATE void GenerateFaces(CalcExternalFacesState *st);
+PRIVATE void GenerateFacesJob(void *st);
+PRIVATE void GrowFaces(FaceBuild *build);
 PRIVATE void InsertFace(CalcExternalFacesState *st, int *nodes, int nNodes,
     int zoneNo);
+PRIVATE int MatchFace(Face const *face, int const *nodes, int nNodes,
+    int iMin);
+PRIVATE void MatchQueuedFacesJob(void *st);
+PRIVATE void SkipZones(CalcExternalFacesState *st, ZoneCursor *cur,
+    int nZones);
+PRIVATE void StoreFace(CalcExternalFacesState *st, int const *nodes,
+    int nNodes, int zoneNo, unsigned int hash, int iMin, long long seq);
 
 /***********************************************************************
  *
@@ -262,6 +337,10 @@ DBCalcExternalFacelist2(int *nodeList, int nNodes, int lowOffset,
  *    Reverse hexahedrons faces, since we are now defining hexes to have
  *    the opposite orientations.
  *
+ *    Moved the loop over the shapes to GenerateFaces.  When threaded,
+ *    the threads make the faces of pieces of the zones and queue them
+ *    by hash, then each matches the faces queued for its part.
+ *
  **********************************************************************/
 
 PRIVATE DBfacelist *
@@ -269,170 +348,274 @@ CalcExternalFaces(int *zoneList, int nNodes, int lowOffset, int highOffset,
                   int origin, int *shapeType, int *shapeSize, int *shapeCnt,
                   int nShapes, int *matList, int bndMethod)
 {
-    int       i, j, k;
-    CalcExternalFacesState st;
-    int       nFaces;
-    int       nEdges;
-    int       iZone, iZoneList;
-    int       nodes[4];
+    int       i, p, piece, nParts, nZones, step, nMakers;
+    ZoneCursor cur;
+    CalcExternalFacesState *st=NULL, *makers=NULL;
     DBfacelist *faceList=NULL;
 
+    nZones = 0;
+    for (i = 0; i < nShapes; i++) nZones += shapeCnt[i];
+    nParts = DB_THREADS;
+
     /*
      * Copy relevant global information to a structure for easy
-     * passing among routines.
+     * passing among routines.  There is one per part.
      */
-    st.zoneList   = zoneList;
-    st.nNodes     = nNodes;
-    st.lowOffset  = lowOffset;
-    st.highOffset = highOffset;
-    st.origin     = origin;
-    st.shapeType  = shapeType;
-    st.shapeSize  = shapeSize;
-    st.shapeCnt   = shapeCnt;
-    st.nShapes    = nShapes;
-    st.matList    = matList;
-    st.bndMethod  = bndMethod;
-
-    st.faceHash.size  = MIN(nNodes, HASH_MAX);
-    st.faceHash.table = MALLOC_N(Face *, st.faceHash.size);
-    memset(st.faceHash.table, 0, st.faceHash.size * sizeof(Face *));
+    st = ALLOC_N(CalcExternalFacesState, nParts);
+    for (i = 0; i < nParts; i++)
+    {
+        st[i].zoneList   = zoneList;
+        st[i].nNodes     = nNodes;
+        st[i].lowOffset  = lowOffset;
+        st[i].highOffset = highOffset;
+        st[i].origin     = origin;
+        st[i].shapeType  = shapeType;
+        st[i].shapeSize  = shapeSize;
+        st[i].shapeCnt   = shapeCnt;
+        st[i].nShapes    = nShapes;
+        st[i].matList    = matList;
+        st[i].bndMethod  = bndMethod;
+        memset(&st[i].first, 0, sizeof(ZoneCursor));
+        st[i].zoneEnd    = nZones;
+        st[i].part       = i;
+        st[i].nParts     = nParts;
+        st[i].piece      = 0;
+        st[i].seq        = 0;
+        st[i].queues     = NULL;
+        st[i].makers     = NULL;
+        st[i].nMakers    = 0;
+        memset(&st[i].build, 0, sizeof(FaceBuild));
+    }
+
+    if (nParts == 1)
+    {
+        GenerateFaces(&st[0]);
+    }
+    else
+    {
+        /*
+         * Each round, the makers each make the faces of the next piece
+         * of the zones and queue them by part, then each part matches
+         * the faces queued for it in the order the pieces were made.
+         */
+        makers = ALLOC_N(CalcExternalFacesState, nParts);
+        for (i = 0; i < nParts; i++)
+        {
+            makers[i] = st[i];
+            makers[i].queues = ALLOC_N(FaceQueue, nParts);
+        }
+        step = MIN((nZones + nParts - 1) / nParts, FACE_PIECE);
+        memset(&cur, 0, sizeof(cur));
+        for (piece = 0; cur.zone < nZones; )
+        {
+            for (nMakers = 0; nMakers < nParts && cur.zone < nZones;
+                 nMakers++, piece++)
+            {
+                makers[nMakers].first   = cur;
+                makers[nMakers].zoneEnd = MIN(cur.zone + step, nZones);
+                makers[nMakers].piece   = piece;
+                makers[nMakers].seq     = (long long) piece << 32;
+                SkipZones(&st[0], &cur, step);
+            }
+            db_RunJobs(GenerateFacesJob, makers, sizeof(*makers), nMakers);
+            for (i = 0; i < nParts; i++)
+            {
+                st[i].makers  = makers;
+                st[i].nMakers = nMakers;
+            }
+            db_RunJobs(MatchQueuedFacesJob, st, sizeof(*st), nParts);
+        }
+        for (i = 0; i < nParts; i++)
+        {
+            for (p = 0; p < nParts; p++)
+                FREE(makers[i].queues[p].data);
+            FREE(makers[i].queues);
+        }
+        FREE(makers);
+    }
+
+    /*
+     * Form a DBfacelist structure from the remaining faces.
+     */
+    faceList = FormFaceList(st, nParts);
+    FREE(st);
+
+    return faceList;
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Make every face of the zones from st->first up to
+ *           st->zoneEnd, in zone order, and hand each to InsertFace.
+ *           Split out of CalcExternalFaces.
+ *
+ * Input arguments:
+ *    st       : The external facelist state.
+ *
+ * Output arguments:
+ *
+ * Input/Output arguments:
+ *
+ * Notes
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE void
+GenerateFaces(CalcExternalFacesState *st)
+{
+    int       i, j, k;
+    int       j0, jEnd;
+    int       nFaces;
+    int       nEdges;
+    int       iZone, iZoneList;
+    int       zoneEnd = st->zoneEnd;
+    int       nodes[4];
+    int       *zoneList = st->zoneList;
+    int       *shapeType = st->shapeType;
+    int       *shapeSize = st->shapeSize;
+    int       *shapeCnt = st->shapeCnt;
+    int       nShapes = st->nShapes;
 
     /*
      * Loop over all the shapes, adding the faces for each shape,
      * removing duplicates as they are encountered.
      */
-    iZone = 0;
-    iZoneList = 0;
-    for (i = 0; i < nShapes; i++)
+    iZone = st->first.zone;
+    iZoneList = st->first.zoneListIdx;
+    j0 = st->first.shapeZone;
+    for (i = st->first.shape; i < nShapes && iZone < zoneEnd; i++, j0 = 0)
     {
+        jEnd = MIN(shapeCnt[i], j0 + (zoneEnd - iZone));
         switch (shapeType[i])
         {
             case DB_ZONETYPE_TET:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+1];
                     nodes[2] = zoneList[iZoneList+2];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+2];
                     nodes[2] = zoneList[iZoneList+3];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+3];
                     nodes[2] = zoneList[iZoneList+1];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+1];
                     nodes[1] = zoneList[iZoneList+3];
                     nodes[2] = zoneList[iZoneList+2];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     iZone++;
                     iZoneList += 4;
                 }
                 break;
             case DB_ZONETYPE_PYRAMID:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+1];
                     nodes[2] = zoneList[iZoneList+2];
                     nodes[3] = zoneList[iZoneList+3];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+4];
                     nodes[2] = zoneList[iZoneList+1];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+1];
                     nodes[1] = zoneList[iZoneList+4];
                     nodes[2] = zoneList[iZoneList+2];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+2];
                     nodes[1] = zoneList[iZoneList+4];
                     nodes[2] = zoneList[iZoneList+3];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+3];
                     nodes[1] = zoneList[iZoneList+4];
                     nodes[2] = zoneList[iZoneList+0];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     iZone++;
                     iZoneList += 5;
                 }
                 break;
             case DB_ZONETYPE_PRISM:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+1];
                     nodes[2] = zoneList[iZoneList+2];
                     nodes[3] = zoneList[iZoneList+3];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+3];
                     nodes[1] = zoneList[iZoneList+2];
                     nodes[2] = zoneList[iZoneList+5];
                     nodes[3] = zoneList[iZoneList+4];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+4];
                     nodes[1] = zoneList[iZoneList+5];
                     nodes[2] = zoneList[iZoneList+1];
                     nodes[3] = zoneList[iZoneList+0];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+3];
                     nodes[1] = zoneList[iZoneList+4];
                     nodes[2] = zoneList[iZoneList+0];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     nodes[0] = zoneList[iZoneList+1];
                     nodes[1] = zoneList[iZoneList+5];
                     nodes[2] = zoneList[iZoneList+2];
-                    InsertFace(&st, nodes, 3, iZone);
+                    InsertFace(st, nodes, 3, iZone);
                     iZone++;
                     iZoneList += 6;
                 }
                 break;
             case DB_ZONETYPE_HEX:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+3];
                     nodes[2] = zoneList[iZoneList+2];
                     nodes[3] = zoneList[iZoneList+1];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+1];
                     nodes[1] = zoneList[iZoneList+2];
                     nodes[2] = zoneList[iZoneList+6];
                     nodes[3] = zoneList[iZoneList+5];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+5];
                     nodes[1] = zoneList[iZoneList+6];
                     nodes[2] = zoneList[iZoneList+7];
                     nodes[3] = zoneList[iZoneList+4];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+4];
                     nodes[1] = zoneList[iZoneList+7];
                     nodes[2] = zoneList[iZoneList+3];
                     nodes[3] = zoneList[iZoneList+0];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+0];
                     nodes[1] = zoneList[iZoneList+1];
                     nodes[2] = zoneList[iZoneList+5];
                     nodes[3] = zoneList[iZoneList+4];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     nodes[0] = zoneList[iZoneList+3];
                     nodes[1] = zoneList[iZoneList+7];
                     nodes[2] = zoneList[iZoneList+6];
                     nodes[3] = zoneList[iZoneList+2];
-                    InsertFace(&st, nodes, 4, iZone);
+                    InsertFace(st, nodes, 4, iZone);
                     iZone++;
                     iZoneList += 8;
                 }
                 break;
             case DB_ZONETYPE_POLYHEDRON:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
                     nFaces = zoneList[iZoneList++];
                     for (k = 0; k < nFaces; k++)
                     {
                         nEdges = zoneList[iZoneList++];
-                        InsertFace(&st, &zoneList[iZoneList], nEdges, iZone);
+                        InsertFace(st, &zoneList[iZoneList], nEdges, iZone);
                         iZoneList += nEdges;
                     }
                     iZone++;
@@ -442,38 +625,115 @@ CalcExternalFaces(int *zoneList, int nNodes, int lowOffset, int highOffset,
             case DB_ZONETYPE_TRIANGLE:
             case DB_ZONETYPE_QUAD:
             case DB_ZONETYPE_POLYGON:
-                for (j = 0; j < shapeCnt[i]; j++)
+                for (j = j0; j < jEnd; j++)
                 {
-                    InsertFace(&st, &zoneList[iZoneList], shapeSize[i], iZone);
+                    InsertFace(st, &zoneList[iZoneList], shapeSize[i], iZone);
                     iZoneList += shapeSize[i];
                     iZone++;
                 }
                 break;
             default:
-                iZone += shapeCnt[i];
-                iZoneList += shapeSize[i] * shapeCnt[i];
+                iZone += jEnd - j0;
+                iZoneList += shapeSize[i] * (jEnd - j0);
                 break;
         }
     }
+}
 
-    /*
-     * Form a DBfacelist structure from the remaining faces.
-     */
-    faceList = FormFaceList(&st);
+PRIVATE void
+GenerateFacesJob(void *st)
+{
+    GenerateFaces((CalcExternalFacesState *) st);
+}
 
-    return faceList;
+/***********************************************************************
+ *
+ * Purpose:  Move a zone cursor nZones zones ahead, or to the end of
+ *           the zonelist.
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE void
+SkipZones(CalcExternalFacesState *st, ZoneCursor *cur, int nZones)
+{
+    int       j, k, n;
+    int       nFaces;
+    int       *zoneList = st->zoneList;
+
+    while (nZones > 0 && cur->shape < st->nShapes)
+    {
+        n = MIN(st->shapeCnt[cur->shape] - cur->shapeZone, nZones);
+        if (st->shapeType[cur->shape] == DB_ZONETYPE_POLYHEDRON)
+        {
+            for (j = 0; j < n; j++)
+            {
+                nFaces = zoneList[cur->zoneListIdx++];
+                for (k = 0; k < nFaces; k++)
+                    cur->zoneListIdx += zoneList[cur->zoneListIdx] + 1;
+            }
+        }
+        else
+        {
+            cur->zoneListIdx += st->shapeSize[cur->shape] * n;
+        }
+        cur->zone      += n;
+        cur->shapeZone += n;
+        nZones         -= n;
+        if (cur->shapeZone == st->shapeCnt[cur->shape])
+        {
+            cur->shape++;
+            cur->shapeZone = 0;
+        }
+    }
 }
 
 /***********************************************************************
  *
- * Purpose:  Form a DBfacelist structure from the remaining faces in
- *           the face hash table.
+ * Purpose:  Match the faces the makers of a round queued for this
+ *           part, in the order in which they were made.
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE void
+MatchQueuedFacesJob(void *arg)
+{
+    CalcExternalFacesState *st = (CalcExternalFacesState *) arg;
+    CalcExternalFacesState *maker;
+    FaceQueue *queue;
+    int       *rec;
+    int       i;
+    size_t    k;
+
+    for (i = 0; i < st->nMakers; i++)
+    {
+        maker = &st->makers[i];
+        queue = &maker->queues[st->part];
+        for (k = 0; k < queue->n; k += 5 + rec[3])
+        {
+            rec = &queue->data[k];
+            StoreFace(st, &rec[5], rec[3], rec[2], (unsigned int) rec[0],
+                      rec[4], ((long long) maker->piece << 32) |
+                      (unsigned int) rec[1]);
+        }
+        queue->n = 0;
+    }
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Form a DBfacelist structure from the remaining faces of
+ *           all the parts.
  *
  * Programmer: Eric Brugger
  * Date:       March 12, 1999
  *
  * Input arguments:
- *    st       : The external facelist state.
+ *    st       : The external facelist states, one per part.
+ *    nParts   : The number of parts.
  *
  * Output arguments:
  *    fl       : The resulting facelist.
@@ -495,154 +755,161 @@ CalcExternalFaces(int *zoneList, int nNodes, int lowOffset, int highOffset,
  *    Replaced a comparison to NULL with a comparison to 0 since the
  *    value was an integer not a pointer.
  *
+ *    Gather the live faces of every part and sort them into the order
+ *    the chained hash table used to produce, then free all the faces.
+ *
  **********************************************************************/
 
 PRIVATE DBfacelist *
-FormFaceList(CalcExternalFacesState *st)
+FormFaceList(CalcExternalFacesState *st, int nParts)
 {
-    int       i, j;
-    FaceHash  *faceHash=NULL;
+    int       i, j, p;
+    size_t    k;
     int       origin;
+    int       hashSize;
     int       minIndex, maxIndex;
     int       nZones;
-    int       iFaceList;
     int       lFaceList;
-    int       iFace;
     int       nFaces;
-    Face      firstFace;
-    Face      *prevFace=NULL, *curFace=NULL, *tmpFace=NULL;
-    int       zoneNoNext;
+    size_t    maxOrder;
+    Face      **order=NULL, **found=NULL;
+    int       *bucketStart=NULL;
+    Face      *face=NULL;
     int       *faceList=NULL, *zoneNo=NULL;
-    int       curSize;
     int       nShapes;
-    int       lShapeList;
     int       *shapeCnt=NULL, *shapeSize=NULL;
+    int       *faceStart=NULL, *nodeStart=NULL;
     DBfacelist *fl=NULL;
 
-    faceHash = &(st->faceHash);
-    origin = st->origin;
+    origin   = st[0].origin;
+    hashSize = MAX(MIN(st[0].nNodes, HASH_MAX), 1);
 
     /*
      * Calculate the number of zones in the zonelist.
      */
     nZones = 0;
-    for (i = 0; i < st->nShapes; i++) nZones += st->shapeCnt[i];
+    for (i = 0; i < st[0].nShapes; i++) nZones += st[0].shapeCnt[i];
 
-    minIndex = st->lowOffset;
-    maxIndex = nZones - st->highOffset - 1;
+    minIndex = st[0].lowOffset;
+    maxIndex = nZones - st[0].highOffset - 1;
 
     /*
-     * Link all the faces into a list and determine the total number
-     * faces and the total number of nodes in the resulting facelist.
-     * Faces that are associated with ghost elements are eliminated
-     * during the chaining process.  The first element in the list is
-     * an extra face that is allocated from the stack.  This eliminates
-     * special cases in the coding.  Once the faces have been linked
-     * together the hash table is no longer needed so it is freed.
+     * Gather the live faces that came from real zones.  Faces that are
+     * associated with ghost elements are eliminated.
      */
-    firstFace.nNodes = 0;
-    firstFace.nodes  = NULL;
-    firstFace.zoneNo = 0;
-    firstFace.next   = NULL;
-    curFace = &firstFace;
+    maxOrder = 0;
+    for (p = 0; p < nParts; p++)
+        maxOrder += st[p].build.nFaces;
+    found = MALLOC_N(Face *, maxOrder > 0 ? maxOrder : 1);
+    bucketStart = ALLOC_N(int, hashSize + 1);
     nFaces = 0;
     lFaceList = 0;
-    for (i = 0; i < faceHash->size; i++)
+    for (p = 0; p < nParts; p++)
     {
-        if (faceHash->table[i] != NULL)
+        FaceBuild *build = &st[p].build;
+
+        for (k = 0; k < build->nFaces; k++)
         {
-            curFace->next = faceHash->table[i];
-            while (curFace->next != NULL)
-            {
-                /*
-                 * If the face came from a real zone, add it to
-                 * the list, otherwise delete it.
-                 */
-                zoneNoNext = curFace->next->zoneNo;
-                if (zoneNoNext >= minIndex && zoneNoNext <= maxIndex)
-                {
-                    nFaces++;
-                    lFaceList += curFace->nNodes;
-                    curFace = curFace->next;
-                }
-                else
-                {
-                    tmpFace = curFace->next;
-                    curFace->next = tmpFace->next;
-                    FreeFace(tmpFace);
-                }
-            }
+            face = &build->faces[k];
+            if (!face->alive ||
+                face->zoneNo < minIndex || face->zoneNo > maxIndex)
+                continue;
+            found[nFaces++] = face;
+            lFaceList += face->nNodes;
+            bucketStart[FACE_NODES(face)[0] % hashSize + 1]++;
+        }
+    }
+
+    /*
+     * Order the faces as the chained hash table used to list them, by
+     * the lowest node modulo the table size and then newest first.
+     */
+    for (i = 0; i < hashSize; i++)
+        bucketStart[i+1] += bucketStart[i];
+    order = MALLOC_N(Face *, nFaces > 0 ? nFaces : 1);
+    for (i = 0; i < nFaces; i++)
+        order[bucketStart[FACE_NODES(found[i])[0] % hashSize]++] = found[i];
+    for (i = 0, j = 0; j < hashSize; j++)
+    {
+        int begin = i, end = bucketStart[j], m;
+
+        for (; i < end; i++)
+        {
+            Face *cur = order[i];
+            for (m = i; m > begin && order[m-1]->seq < cur->seq; m--)
+                order[m] = order[m-1];
+            order[m] = cur;
         }
     }
-    lFaceList += curFace->nNodes;
-    FREE(faceHash->table);
-    faceHash->size = 0;
+    FREE(found);
+    FREE(bucketStart);
 
     /*
-     * Build the arrays necessary for the DBfacelist structure.  Loop
-     * over all the faces, extracting all the faces of a particular type
-     * each time until all the faces have been extracted.
+     * Build the arrays necessary for the DBfacelist structure.  The
+     * faces are grouped by size, with the sizes in the order in which
+     * they first appear.
      */
-    nShapes    = 0;
-    lShapeList = 10;
+    nShapes = 0;
     if (nFaces != 0)
     {
-        shapeSize  = MALLOC_N(int, lShapeList);
-        shapeCnt   = MALLOC_N(int, lShapeList);
+        shapeSize  = MALLOC_N(int, nFaces);
+        shapeCnt   = MALLOC_N(int, nFaces);
         faceList   = MALLOC_N(int, lFaceList);
         zoneNo     = MALLOC_N(int, nFaces);
     }
-    iFace      = 0;
-    iFaceList  = 0;
-
-    while (firstFace.next != NULL)
+    for (i = 0; i < nFaces; i++)
     {
-        /*
-         * Allocate more space for the shape structures if necessary.
-         */
-        if (nShapes >= lShapeList)
+        int curSize = order[i]->nNodes;
+        for (j = 0; j < nShapes && shapeSize[j] != curSize; j++)
+            /* empty */;
+        if (j == nShapes)
         {
-            lShapeList += 10;
-            shapeSize = REALLOC_N(shapeSize, int, lShapeList);
-            shapeCnt  = REALLOC_N(shapeCnt, int, lShapeList);
+            shapeSize[nShapes] = curSize;
+            shapeCnt[nShapes]  = 0;
+            nShapes++;
         }
-
-        /*
-         * Add an entry in the shape structure for the current shape
-         * type.
-         */
-        prevFace = &firstFace;
-        curFace  = firstFace.next;
-        curSize  = curFace->nNodes;
-        shapeSize[nShapes] = curSize;
-        shapeCnt[nShapes]  = 0;
-
-        /*
-         * Loop over all the faces, adding all the faces with the current
-         * size to the output face list and removing them from the input
-         * list of faces.
-         */
-        while (curFace != NULL)
+        shapeCnt[j]++;
+    }
+    if (nShapes != 0)
+    {
+        shapeSize = REALLOC_N(shapeSize, int, nShapes);
+        shapeCnt  = REALLOC_N(shapeCnt, int, nShapes);
+        faceStart = MALLOC_N(int, nShapes);
+        nodeStart = MALLOC_N(int, nShapes);
+        faceStart[0] = 0;
+        nodeStart[0] = 0;
+        for (j = 1; j < nShapes; j++)
         {
-            if (curFace->nNodes == curSize)
-            {
-                shapeCnt[nShapes] += 1;
-                zoneNo[iFace] = curFace->zoneNo + origin;
-                iFace++;
-                for (j = 0; j < curSize; j++)
-                {
-                    faceList[iFaceList+j] = curFace->nodes[j];
-                }
-                iFaceList += curSize;
-                prevFace->next = curFace->next;
-                FreeFace(curFace);
-                curFace = prevFace;
-            }
-            prevFace = curFace;
-            curFace = curFace->next;
+            faceStart[j] = faceStart[j-1] + shapeCnt[j-1];
+            nodeStart[j] = nodeStart[j-1] + shapeCnt[j-1] * shapeSize[j-1];
         }
+    }
+    for (i = 0; i < nFaces; i++)
+    {
+        face = order[i];
+        for (j = 0; shapeSize[j] != face->nNodes; j++)
+            /* empty */;
+        zoneNo[faceStart[j]++] = face->zoneNo + origin;
+        memcpy(&faceList[nodeStart[j]], FACE_NODES(face),
+               face->nNodes * sizeof(int));
+        nodeStart[j] += face->nNodes;
+    }
+    FREE(order);
+    FREE(faceStart);
+    FREE(nodeStart);
 
-        nShapes++;
+    /*
+     * Free the faces of all the parts.
+     */
+    for (p = 0; p < nParts; p++)
+    {
+        FaceBuild *build = &st[p].build;
+
+        for (k = 0; k < build->nFaces; k++)
+            if (build->faces[k].alive && build->faces[k].nNodes > FACE_INLINE)
+                FREE(build->faces[k].u.big);
+        FREE(build->faces);
+        FREE(build->heads);
     }
 
     /*
@@ -665,8 +932,79 @@ FormFaceList(CalcExternalFacesState *st)
 
 /***********************************************************************
  *
- * Purpose:  Insert a face into the face hash table.  If the face is
- *           not in the hash table it gets added.  If it already exists
+ * Purpose:  Determine if a stored face matches a new one.  The stored
+ *           face starts with its lowest node and the new one must
+ *           traverse the same nodes in the opposite direction.
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE int
+MatchFace(Face const *face, int const *nodes, int nNodes, int iMin)
+{
+    int       i, j;
+    int const *faceNodes;
+
+    if (face->nNodes != nNodes)
+        return 0;
+    faceNodes = FACE_NODES(face);
+    if (faceNodes[0] != nodes[iMin])
+        return 0;
+    j = iMin;
+    for (i = 1; i < nNodes; i++)
+    {
+        j = j == 0 ? nNodes - 1 : j - 1;
+        if (faceNodes[i] != nodes[j])
+            return 0;
+    }
+    return 1;
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Double the number of buckets in the face table.  The faces
+ *           of a bucket are split between two, keeping their order.
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE void
+GrowFaces(FaceBuild *build)
+{
+    size_t    i, k, size;
+    unsigned int *heads = build->heads;
+    size_t    oldSize = heads ? build->mask + 1 : 0;
+    unsigned int cur, next, tail[2];
+
+    size = oldSize ? 2 * oldSize : 1024;
+    build->heads = ALLOC_N(unsigned int, size);
+    build->mask  = size - 1;
+    for (i = 0; i < oldSize; i++)
+    {
+        tail[0] = tail[1] = 0;
+        for (cur = heads[i]; cur != 0; cur = next)
+        {
+            Face *face = &build->faces[cur - 1];
+
+            next = face->next;
+            face->next = 0;
+            k = (face->hash / FACE_SPREAD) & build->mask;
+            if (tail[k != i])
+                build->faces[tail[k != i] - 1].next = cur;
+            else
+                build->heads[k] = cur;
+            tail[k != i] = cur;
+        }
+    }
+    FREE(heads);
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Insert a face into the face table.  If the face is
+ *           not in the table it gets added.  If it already exists
  *           then the existing one is deleted.
  *
  * Programmer: Eric Brugger
@@ -686,130 +1024,162 @@ FormFaceList(CalcExternalFacesState *st)
  *
  * Modifications:
  *
+ *    The faces come from an arena and are chained by index in a table
+ *    that grows with the number of faces instead of being capped at
+ *    HASH_MAX buckets.  The search and the insertion were moved to
+ *    StoreFace.  When the faces are split among several parts, the face
+ *    is queued for its part instead.
+ *
  **********************************************************************/
 
 PRIVATE void
 InsertFace(CalcExternalFacesState *st, int *nodes, int nNodes, int zoneNo)
 {
-    int       i, j;
-    FaceHash  *faceHash=NULL;
-    int       bndMethod;
-    int       *matList;
+    int       i;
+    unsigned int hash, sum, page;
     int       iMin;
-    int       match;
-    int       deleteIt;
-    Face      *prevFace=NULL, *curFace=NULL;
-
-    faceHash  = &(st->faceHash);
-    bndMethod = st->bndMethod;
-    matList   = st->matList;
+    FaceQueue *queue;
 
     /*
      * Find index of the minimum node number in the node list
-     * for the face.  Since it is used to index into the hash
-     * table and as the starting point for performing a match.
+     * for the face.  It is the starting point for performing a match
+     * and for storing the face.  Sum the nodes on the way, so that
+     * the hash does not depend on their order and a face hashes the
+     * same from either of its zones.  See FACE_PAGE for how the bits
+     * of the hash are laid out.
      */
     iMin = 0;
+    sum = (unsigned int) nNodes + (unsigned int) nodes[0] * 0x9e3779b1U;
     for (i = 1; i < nNodes; i++)
     {
+        sum += (unsigned int) nodes[i] * 0x9e3779b1U;
         if (nodes[i] < nodes[iMin]) iMin = i;
     }
+    page = (unsigned int) nodes[iMin] / FACE_PAGE;
+    page ^= page >> 16; page *= 0x85ebca6bU;
+    page ^= page >> 13; page *= 0xc2b2ae35U;
+    page ^= page >> 16;
+    hash = page * (FACE_PAGE * FACE_SPREAD) +
+           ((unsigned int) nodes[iMin] % FACE_PAGE) * FACE_SPREAD +
+           (sum >> 16) % FACE_SPREAD;
+
+    if (st->queues == NULL)
+    {
+        StoreFace(st, nodes, nNodes, zoneNo, hash, iMin, st->seq++);
+        return;
+    }
 
     /*
-     * Search the list of faces in the linked list of possible
-     * matches for a match.
+     * Queue the face for its part, with the low bits of its sequence
+     * number.  The part knows the piece.
      */
-    curFace = faceHash->table[nodes[iMin] % faceHash->size];
-    match = 0;
-    while (match == 0 && curFace != NULL)
+    queue = &st->queues[((unsigned long long) hash * st->nParts) >> 32];
+    if (queue->n + 5 + nNodes > queue->max)
     {
-        if (curFace->nNodes == nNodes)
-        {
-            match = 1;
-            j = (iMin + nNodes - 1) % nNodes;
-            for (i = 1; i < nNodes && match == 1; i++)
-            {
-                match = (curFace->nodes[i] == nodes[j]);
-                j = (j + nNodes - 1) % nNodes;
-            }
-        }
-
-        if (match == 0)
-        {
-            prevFace = curFace;
-            curFace = curFace->next;
-        }
+        queue->max = MAX(2 * queue->max, queue->n + 5 + nNodes + 4096);
+        queue->data = REALLOC_N(queue->data, int, queue->max);
     }
+    queue->data[queue->n++] = (int) hash;
+    queue->data[queue->n++] = (int) (unsigned int) st->seq++;
+    queue->data[queue->n++] = zoneNo;
+    queue->data[queue->n++] = nNodes;
+    queue->data[queue->n++] = iMin;
+    memcpy(&queue->data[queue->n], nodes, nNodes * sizeof(int));
+    queue->n += nNodes;
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Search the face table for a face that matches a new one
+ *           and delete it, or else add the new face.  Split out of
+ *           InsertFace.
+ *
+ * Input arguments:
+ *    st       : The external facelist state.
+ *    nodes    : The nodes making up the face.
+ *    nNodes   : The number of nodes in the face.
+ *    zoneNo   : The zone number associated with the face.
+ *    hash     : The hash of the face.
+ *    iMin     : The index of the lowest node of the face.
+ *    seq      : The order in which the face was made.
+ *
+ * Modifications:
+ *
+ **********************************************************************/
+
+PRIVATE void
+StoreFace(CalcExternalFacesState *st, int const *nodes, int nNodes,
+          int zoneNo, unsigned int hash, int iMin, long long seq)
+{
+    int       i, j;
+    FaceBuild *build = &st->build;
+    size_t    bucket;
+    size_t    iFace;
+    unsigned int cur, prev;
+    Face      *face=NULL;
 
     /*
-     * Determine if the face should be deleted based on getting
-     * a match and the bndMethod.
+     * Search the bucket, newest face first, for a match.
      */
-    deleteIt = 0;
-    if (match == 1)
+    if (build->heads == NULL)
+        GrowFaces(build);
+    bucket = (hash / FACE_SPREAD) & build->mask;
+    for (prev = 0, cur = build->heads[bucket]; cur != 0;
+         prev = cur, cur = face->next)
     {
-        if (bndMethod == 0)
-        {
-            deleteIt = 1;
-        }
-        else if (matList[curFace->zoneNo] == matList[zoneNo])
-        {
-            deleteIt = 1;
-        }
+        face = &build->faces[cur - 1];
+        if (face->hash == hash && MatchFace(face, nodes, nNodes, iMin))
+            break;
     }
-        
+
     /*
-     * Either delete the matching face or add the new one based on
-     * the deleteIt flag.
+     * Delete the matching face based on the bndMethod.
      */
-    if (deleteIt == 1)
+    if (cur != 0 &&
+        (st->bndMethod == 0 || st->matList[face->zoneNo] == st->matList[zoneNo]))
     {
-        /*
-         * Delete the face.
-         */
-        if (prevFace == NULL)
-        {
-            /*
-             * The previous element is the beginning of the list.
-             */
-            faceHash->table[nodes[iMin] % faceHash->size] = curFace->next;
-        }
+        if (prev == 0)
+            build->heads[bucket] = face->next;
         else
-        {
-            /*
-             * The previous element is in the middle of the list.
-             */
-            prevFace->next = curFace->next;
-        } 
-        FreeFace(curFace);
+            build->faces[prev - 1].next = face->next;
+        build->nLive--;
+        FreeFace(build, cur - 1);
+        return;
     }
-    else
+
+    /*
+     * Add the face.
+     */
+    iFace = AllocFace(build);
+    face = &build->faces[iFace];
+    face->nNodes = nNodes;
+    face->zoneNo = zoneNo;
+    face->seq    = seq;
+    face->hash   = hash;
+    face->alive  = 1;
+    face->next   = build->heads[bucket];
+    if (nNodes > FACE_INLINE)
+        face->u.big = MALLOC_N(int, nNodes);
+    for (i = 0, j = iMin; i < nNodes; i++, j = (j + 1 == nNodes ? 0 : j + 1))
     {
-        /*
-         * Add the face.
-         */
-        curFace = AllocFace();
-        curFace->nNodes = nNodes;
-        curFace->nodes = MALLOC_N(int, nNodes);
-        for (i = 0, j = iMin; i < nNodes; i++, j = (j + 1) % nNodes)
-        {
-            curFace->nodes[i] = nodes[j];
-        }
-        curFace->zoneNo = zoneNo;
-        curFace->next = faceHash->table[nodes[iMin] % faceHash->size];
-        faceHash->table[nodes[iMin] % faceHash->size] = curFace;
+        FACE_NODES(face)[i] = nodes[j];
     }
+    build->heads[bucket] = (unsigned int) (iFace + 1);
+    build->nLive++;
+    if (build->nLive > build->mask + 1)
+        GrowFaces(build);
 }
 
 /***********************************************************************
  *
- * Purpose:  Free a Face structure.
+ * Purpose:  Return a Face structure to the arena.
  *
  * Programmer: Eric Brugger
  * Date:       March 12, 1999
  *
  * Input arguments:
- *    face     : The face to free.
+ *    build    : The faces.
+ *    iFace    : The face to free.
  *
  * Output arguments:
  *
@@ -819,14 +1189,20 @@ InsertFace(CalcExternalFacesState *st, int *nodes, int nNodes, int zoneNo)
  *
  * Modifications:
  *
+ *    The face goes on the free list of the arena instead of to free().
+ *
  **********************************************************************/
 
 PRIVATE void
-FreeFace(Face *face)
+FreeFace(FaceBuild *build, size_t iFace)
 {
+    Face      *face = &build->faces[iFace];
 
-    FREE(face->nodes);
-    FREE(face);
+    if (face->nNodes > FACE_INLINE)
+        FREE(face->u.big);
+    face->alive = 0;
+    face->u.next = build->freeList;
+    build->freeList = iFace + 1;
 }
 
 /***********************************************************************
@@ -837,9 +1213,10 @@ FreeFace(Face *face)
  * Date:       March 12, 1999
  *
  * Input arguments:
+ *    build    : The faces.
  *
  * Output arguments:
- *    face     : The newly allocated face.
+ *    iFace    : The index of the newly allocated face.
  *
  * Input/Output arguments:
  *
@@ -847,14 +1224,28 @@ FreeFace(Face *face)
  *
  * Modifications:
  *
+ *    Take the face from the arena's free list, or the end of the
+ *    arena.
+ *
  **********************************************************************/
 
-PRIVATE Face *
-AllocFace(void)
+PRIVATE size_t
+AllocFace(FaceBuild *build)
 {
-    Face      *face=NULL;
+    size_t    iFace;
 
-    face = MALLOC_N(Face, 1);
+    if (build->freeList != 0)
+    {
+        iFace = build->freeList - 1;
+        build->freeList = build->faces[iFace].u.next;
+        return iFace;
+    }
+    if (build->nFaces == build->maxFaces)
+    {
+        build->maxFaces = build->maxFaces ? 2 * build->maxFaces : 4096;
+        build->faces = REALLOC_N(build->faces, Face, build->maxFaces);
+    }
+    iFace = build->nFaces++;
 
-    return face;
+    return iFace;
 }
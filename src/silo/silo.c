@@ -78,6 +78,7 @@ be used for advertising or product endorsement purposes.
                        Also for SDX driver detection.  */
 #include <stdio.h>
 #include <float.h>
+#include <limits.h>
 #include <math.h>
 #if HAVE_STDLIB_H
 #include <stdlib.h>         /* For abort(). */
@@ -112,12 +113,20 @@ be used for advertising or product endorsement purposes.
 #include <windows.h>        /* for FileInfo funcs */
 #include <io.h>             /* for FileInfo funcs */
 #endif
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>       /* for gettimeofday */
+#endif
+#include <time.h>
+#include <signal.h>         /* for DBSetTraceSignal */
 
 #include <stdarg.h>
 
 /* DB_MAIN must be defined before including silo_private.h. */
 #define DB_MAIN
 #include "silo_private.h"
+#if SILO_THREADSAFE
+#include <pthread.h>
+#endif
 #include "silo_drivers.h"
 
 /* The Silo_version_* variable is used to guarantee that code can't include
@@ -138,8 +147,11 @@ int SILO_VERS_TAG = 0;
 
 /* Symbols for error handling */
 PUBLIC int     DBDebugAPI = 0;  /*file desc for API debug messages      */
-PUBLIC int     db_errno = 0;    /*last error number                     */
-PUBLIC char    db_errfunc[64];  /*name of erring function               */
+PUBLIC SILO_THREAD_LOCAL int  db_errno = 0;   /*last error number       */
+PUBLIC SILO_THREAD_LOCAL char db_errfunc[64]; /*name of erring function */
+SILO_THREAD_LOCAL int db_err_suspended = 0; /*DBShowErrors(DB_SUSPEND) depth */
+SILO_THREAD_LOCAL DBfilestats *db_stats_cur = 0; /*stats of the file in use */
+SILO_THREAD_LOCAL int db_stats_meta = 0;  /*DB_STATS_META_BEGIN depth */
 PUBLIC char   *_db_err_list[] =
 {
     "No error",                               /*00 */
@@ -193,37 +205,28 @@ PUBLIC char   *_db_err_list[] =
 /* Table of contents object count */
 static int _db_nobj_types = ((int)(sizeof(DBtoc)/sizeof(struct{char **p;int n;})));
 
-PRIVATE unsigned char _db_fstatus[DB_NFILES];  /*file status  */
+PRIVATE unsigned char *_db_fstatus = 0;  /*file status, by file id */
+PRIVATE int _db_nfstatus = 0;            /*file ids available so far */
+
+/*
+ * Registry of open files. Each is hashed both by DBfile pointer, for the
+ * check every API_BEGIN2 makes, and by device and inode, for the checks
+ * DBOpen and DBCreate make against concurrent opens. Both tables grow
+ * with the number of open files.
+ */
 typedef struct reg_status_t {
     DBfile *f;
-    unsigned int n;
-    int w;
+    unsigned long long dev, ino;        /*st_dev, st_ino or windows index */
+    int w;                              /*open for writing */
+    struct reg_status_t *fnext;         /*next in f's bucket */
+    struct reg_status_t *inext;         /*next in (dev,ino)'s bucket */
+    struct reg_status_t *prev, *next;   /*all registered files */
 } reg_status_t;
-PRIVATE reg_status_t _db_regstatus[DB_NFILES] = /* DB_NFILES triples of zeros */
-    {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+PRIVATE reg_status_t **_db_regbyfile = 0;
+PRIVATE reg_status_t **_db_regbyino = 0;
+PRIVATE unsigned int _db_regsize = 0;   /*buckets per table, a power of 2 */
+PRIVATE unsigned int _db_regcount = 0;
+PRIVATE reg_status_t *_db_reglist = 0;
 
 PRIVATE filter_t _db_filter[DB_NFILTERS];
 #warning REDUCE USE OF THIS CONSTRUCT
@@ -250,19 +253,19 @@ typedef struct db_silo_stat_t {
 PRIVATE int db_isregistered_file(DBfile *dbfile, const db_silo_stat_t *filestate);
 
 /* Global structures for option lists.  */
-struct _ma     _ma;
-struct _ms     _ms;
-struct _csgm   _csgm;
-struct _pm     _pm;
-struct _qm     _qm;
-struct _um     _um;
-struct _uzl    _uzl;
-struct _phzl   _phzl;
-struct _csgzl  _csgzl;
-struct _mm     _mm;
-struct _cu     _cu;
-struct _dv     _dv;
-struct _mrgt   _mrgt;
+SILO_THREAD_LOCAL struct _ma     _ma;
+SILO_THREAD_LOCAL struct _ms     _ms;
+SILO_THREAD_LOCAL struct _csgm   _csgm;
+SILO_THREAD_LOCAL struct _pm     _pm;
+SILO_THREAD_LOCAL struct _qm     _qm;
+SILO_THREAD_LOCAL struct _um     _um;
+SILO_THREAD_LOCAL struct _uzl    _uzl;
+SILO_THREAD_LOCAL struct _phzl   _phzl;
+SILO_THREAD_LOCAL struct _csgzl  _csgzl;
+SILO_THREAD_LOCAL struct _mm     _mm;
+SILO_THREAD_LOCAL struct _cu     _cu;
+SILO_THREAD_LOCAL struct _dv     _dv;
+SILO_THREAD_LOCAL struct _mrgt   _mrgt;
 
 static char const *db_static_char_ptr_not_set = "db_static_char_ptr_not_set";
 static void const *db_static_void_ptr_not_set = (void*) "db_static_void_ptr_not_set";
@@ -289,6 +292,7 @@ SILO_Globals_t SILO_Globals = {
     FALSE, /* allowLongStrComponents */
     3,     /* maxDeprecateWarnings */
     0,     /* compressionParams (null) */
+    0,     /* compressionPolicy (null) */
     2.0,   /* compressionMinratio */
     0,     /* compressionErrmode (fallback) */
     DB_MAX_COMPATABILITY, /* compatability mode */
@@ -302,9 +306,157 @@ SILO_Globals_t SILO_Globals = {
     0,     /* _db_err_func */
     DB_NONE,/* _db_err_level_drvr */
     0,     /* Jstk */
-    DEFAULT_DRIVER_PRIORITIES
+    DEFAULT_DRIVER_PRIORITIES,
+    0,     /* allocFunc (malloc) */
+    0,     /* freeFunc (free) */
+    0,     /* allocClientData */
+    1,     /* threads */
+    0      /* blockStats */
 };
 
+#if SILO_THREADSAFE
+/*
+ * Locks for the thread-safe build. See "Thread safety" in silo_private.h.
+ * File locks are indexed by fileid and driver locks by driver type so
+ * they never need to be stored in, or outlive, a DBfile. Each thread
+ * remembers which locks its outermost API call acquired so that the
+ * API_XXX macros can release them without any further bookkeeping.
+ */
+SILO_THREAD_LOCAL jstk_t *db_jstk = 0;
+static pthread_once_t db_locks_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t db_global_lock;
+static pthread_mutexattr_t db_lock_attr;
+static pthread_mutex_t *db_file_locks[DB_MAX_FILEIDS/DB_NFILES]; /*by DB_NFILES */
+static pthread_rwlock_t db_reg_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t db_driver_locks[DB_NFORMATS];
+static SILO_THREAD_LOCAL pthread_mutex_t *db_held_file_lock = 0;
+static SILO_THREAD_LOCAL unsigned int db_held_driver_locks = 0;
+
+static void
+db_init_locks(void)
+{
+    int i;
+
+    pthread_mutexattr_init(&db_lock_attr);
+    pthread_mutexattr_settype(&db_lock_attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&db_global_lock, &db_lock_attr);
+    for (i = 0; i < DB_NFORMATS; i++)
+        pthread_mutex_init(&db_driver_locks[i], &db_lock_attr);
+}
+
+/* Make locks for file ids up to N, a multiple of DB_NFILES. Called with
+   the global lock held; the locks are never moved or freed. */
+static int
+db_alloc_file_locks(int n)
+{
+    int i, k;
+
+    for (k = 0; k < n / DB_NFILES; k++)
+    {
+        if (db_file_locks[k])
+            continue;
+        db_file_locks[k] = (pthread_mutex_t *) malloc(DB_NFILES * sizeof(pthread_mutex_t));
+        if (!db_file_locks[k])
+            return -1;
+        for (i = 0; i < DB_NFILES; i++)
+            pthread_mutex_init(&db_file_locks[k][i], &db_lock_attr);
+    }
+    return 0;
+}
+
+static void
+db_lock_driver(int type)
+{
+    if (type < 0 || type >= DB_NFORMATS)
+        return;
+    if (db_held_driver_locks & (1u << type))
+        return;
+    pthread_mutex_lock(&db_driver_locks[type]);
+    db_held_driver_locks |= (1u << type);
+}
+
+INTERNAL void
+db_lock_global(void)
+{
+    pthread_once(&db_locks_once, db_init_locks);
+    pthread_mutex_lock(&db_global_lock);
+}
+
+INTERNAL void
+db_unlock_global(void)
+{
+    pthread_mutex_unlock(&db_global_lock);
+}
+
+/* Lock the driver(s) DBOpen/DBCreate may call. DB_UNKNOWN may try them
+   all; they are taken in ascending order of type. */
+INTERNAL void
+db_api_lock_drivers(int type)
+{
+    int i;
+
+    pthread_once(&db_locks_once, db_init_locks);
+    if (type != DB_UNKNOWN)
+    {
+        db_lock_driver(type);
+        return;
+    }
+    for (i = 0; i < DB_NFORMATS; i++)
+        db_lock_driver(i);
+}
+
+/* Take a driver lock only if no other thread holds it. For helper threads
+   a driver may run on its own; release with db_api_unlock. Returns 0 on
+   success. */
+INTERNAL int
+db_api_trylock_driver(int type)
+{
+    if (type < 0 || type >= DB_NFORMATS)
+        return -1;
+    pthread_once(&db_locks_once, db_init_locks);
+    if (db_held_driver_locks & (1u << type))
+        return 0;
+    if (pthread_mutex_trylock(&db_driver_locks[type]) != 0)
+        return -1;
+    db_held_driver_locks |= (1u << type);
+    return 0;
+}
+
+/* Lock a file and the driver that owns it for the current API call */
+INTERNAL void
+db_api_lock_file(DBfile *dbfile)
+{
+    if (!dbfile || dbfile->pub.fileid < 0 || dbfile->pub.fileid >= DB_MAX_FILEIDS)
+        return;
+    pthread_once(&db_locks_once, db_init_locks);
+    db_held_file_lock = &db_file_locks[dbfile->pub.fileid / DB_NFILES]
+                                      [dbfile->pub.fileid % DB_NFILES];
+    pthread_mutex_lock(db_held_file_lock);
+    db_lock_driver(dbfile->pub.type);
+}
+
+/* Release whatever the current thread's outermost API call locked */
+INTERNAL void
+db_api_unlock(void)
+{
+    int i;
+
+    for (i = DB_NFORMATS-1; db_held_driver_locks && i >= 0; i--)
+    {
+        if (db_held_driver_locks & (1u << i))
+        {
+            pthread_mutex_unlock(&db_driver_locks[i]);
+            db_held_driver_locks &= ~(1u << i);
+        }
+    }
+    if (db_held_file_lock)
+    {
+        pthread_mutex_unlock(db_held_file_lock);
+        db_held_file_lock = 0;
+    }
+}
+#endif
+
 INTERNAL int
 db_FullyDeprecatedConvention(const char *name)
 {
@@ -347,7 +499,7 @@ INTERNAL int
 db_perror(char const *s, int errorno, char const *fname)
 {
     int            call_abort = 0;
-    static char    old_s[256] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    static SILO_THREAD_LOCAL char old_s[256] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
                                  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
                                  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
                                  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
@@ -380,14 +532,14 @@ db_perror(char const *s, int errorno, char const *fname)
         old_s[0] = '\0';
     }
 
-    switch (SILO_Globals._db_err_level) {
+    switch (DB_ERR_LEVEL) {
         case DB_NONE:
-            if (SILO_Globals.Jstk)
-                longjmp(SILO_Globals.Jstk->jbuf, -1);
+            if (DB_JSTK)
+                longjmp(DB_JSTK->jbuf, -1);
             return -1;
         case DB_TOP:
-            if (SILO_Globals.Jstk)
-                longjmp(SILO_Globals.Jstk->jbuf, -1);
+            if (DB_JSTK)
+                longjmp(DB_JSTK->jbuf, -1);
             break;
         case DB_ALL:
             break;
@@ -463,7 +615,7 @@ db_perror(char const *s, int errorno, char const *fname)
 INTERNAL char *
 db_strerror(int errorno)
 {
-    static char    s[32];
+    static SILO_THREAD_LOCAL char s[32];
 
     if (errorno < 0 || errorno >= NELMTS(_db_err_list)) {
         sprintf(s, "Error %d", errorno);
@@ -579,7 +731,7 @@ DBVariableNameValid(const char *s)
 
         if (! okay)
         {
-            if (DB_NONE!=SILO_Globals._db_err_level)
+            if (DB_NONE!=DB_ERR_LEVEL)
             {
                 fprintf(stderr,"\"%s\" is an invalid name.  Silo variable\n"
                         "names may contain only alphanumeric characters\n"
@@ -1880,7 +2032,7 @@ context_restore(DBfile *dbfile, context_t *old)
  * Purpose:     Obtain a file ID number which is unique with respect to
  *              all other open files.
  *
- * Return:      Success:        ID number, [0..DB_NFILES-1]
+ * Return:      Success:        ID number, [0..DB_MAX_FILEIDS-1]
  *
  *              Failure:        -1, too many files are open.
  *
@@ -1888,22 +2040,59 @@ context_restore(DBfile *dbfile, context_t *old)
  *              Tue Feb 28 11:00:04 EST 1995
  *
  * Modifications:
+ *
+ *   The table of ids grows as files are opened, up to DB_MAX_FILEIDS.
  *-------------------------------------------------------------------------*/
 PRIVATE int
 db_get_fileid ( int flags )
 {
     static int     vhand = 0;
-    int            i;
+    int            i, retval = -1;
 
-    for (i = 0; i < DB_NFILES; i++) {
-        if (!_db_fstatus[(vhand + i) % DB_NFILES]) {
-            i = (vhand + i) % DB_NFILES;
+    DB_LOCK_GLOBAL();
+    for (i = 0; i < _db_nfstatus; i++) {
+        if (!_db_fstatus[(vhand + i) % _db_nfstatus]) {
+            i = (vhand + i) % _db_nfstatus;
             _db_fstatus[i] = flags | DB_ISOPEN;
-            vhand = (i + 1) % DB_NFILES;
-            return i;
+            vhand = (i + 1) % _db_nfstatus;
+            retval = i;
+            break;
         }
     }
-    return -1;
+    if (retval < 0 && _db_nfstatus < DB_MAX_FILEIDS)
+    {
+        int n = _db_nfstatus ? 2 * _db_nfstatus : DB_NFILES;
+        unsigned char *fstatus;
+
+        if (n > DB_MAX_FILEIDS) n = DB_MAX_FILEIDS;
+        fstatus = (unsigned char *) realloc(_db_fstatus, n);
+#if SILO_THREADSAFE
+        if (fstatus && db_alloc_file_locks(n) < 0)
+            n = _db_nfstatus;
+#endif
+        if (fstatus && n > _db_nfstatus)
+        {
+            memset(fstatus + _db_nfstatus, 0, n - _db_nfstatus);
+            retval = _db_nfstatus;
+            fstatus[retval] = flags | DB_ISOPEN;
+            vhand = (retval + 1) % n;
+            _db_nfstatus = n;
+        }
+        if (fstatus)
+            _db_fstatus = fstatus;
+    }
+    DB_UNLOCK_GLOBAL();
+    return retval;
+}
+
+/* Return a file id obtained from db_get_fileid to the pool */
+PRIVATE void
+db_release_fileid(int id)
+{
+    DB_LOCK_GLOBAL();
+    if (id >= 0 && id < _db_nfstatus)
+        _db_fstatus[id] = 0;
+    DB_UNLOCK_GLOBAL();
 }
 
 /*-------------------------------------------------------------------------
@@ -1979,8 +2168,10 @@ static unsigned int bjhash(register const unsigned char *k, register unsigned in
  *              as closed by DBClose in order to detect possible operation
  *              on closed files.
  *
- * Return:      -1 if file limit exceeded. Otherwise [0..DB_NFILES-1]
- *              representing position in fixed size list. 
+ * Return:      -1 if the file is not registered (or, for
+ *              db_register_file, could not be). db_isregistered_file
+ *              looking up FILESTATE returns 1 if the file is open for
+ *              writing, 0 if only for reading.
  *
  * Programmer:  Mark C. Miller, Wed Jul 23 00:14:00 PDT 2008
  *
@@ -1999,96 +2190,184 @@ static unsigned int bjhash(register const unsigned char *k, register unsigned in
  *
  *   Mark C. Miller, Wed May 19 17:07:05 PDT 2010
  *   Added logic for _WIN32 form of the db_silo_stat_struct.
+ *
+ *   Replaced the fixed list, scanned on every API call and shifted on
+ *   every close, with hash tables by DBfile pointer and by device and
+ *   inode. The bjhash of st_dev/st_ino now only picks a bucket; matches
+ *   compare the members themselves. In the thread-safe build lookups
+ *   share a read lock.
  *-------------------------------------------------------------------------*/
-PRIVATE int 
-db_register_file(DBfile *dbfile, const db_silo_stat_t *filestate, int writeable)
+#if SILO_THREADSAFE
+#define DB_REG_RDLOCK()     pthread_rwlock_rdlock(&db_reg_lock)
+#define DB_REG_WRLOCK()     pthread_rwlock_wrlock(&db_reg_lock)
+#define DB_REG_UNLOCK()     pthread_rwlock_unlock(&db_reg_lock)
+#else
+#define DB_REG_RDLOCK()
+#define DB_REG_WRLOCK()
+#define DB_REG_UNLOCK()
+#endif
+
+PRIVATE void
+db_reg_key(const db_silo_stat_t *filestate, unsigned long long *dev,
+    unsigned long long *ino)
 {
-    int i;
-    for (i = 0; i < DB_NFILES; i++)
-    {
-        if (_db_regstatus[i].f == 0)
-        {
-            unsigned int hval = 0;
 #ifndef _WIN32
-            hval = bjhash((unsigned char *) &(filestate->s.st_dev), sizeof(filestate->s.st_dev), hval);
-            hval = bjhash((unsigned char *) &(filestate->s.st_ino), sizeof(filestate->s.st_ino), hval);
+    *dev = (unsigned long long) filestate->s.st_dev;
+    *ino = (unsigned long long) filestate->s.st_ino;
 #else
-            hval = bjhash((unsigned char *) &(filestate->fileindexlo), sizeof(filestate->fileindexlo), hval);
-            hval = bjhash((unsigned char *) &(filestate->fileindexhi), sizeof(filestate->fileindexhi), hval);
+    *dev = (unsigned long long) filestate->fileindexhi;
+    *ino = (unsigned long long) filestate->fileindexlo;
 #endif
-            _db_regstatus[i].f = dbfile;
-            _db_regstatus[i].n = hval; 
-            _db_regstatus[i].w = writeable;
-            return i;
-        }
+}
+
+PRIVATE unsigned int
+db_reg_hashfile(DBfile const *dbfile)
+{
+    unsigned long long p = (unsigned long long) (size_t) dbfile;
+    return (unsigned int) ((p >> 4) ^ (p >> 20)) * 2654435761U;
+}
+
+PRIVATE unsigned int
+db_reg_hashino(unsigned long long dev, unsigned long long ino)
+{
+    unsigned int hval = 0;
+    hval = bjhash((unsigned char *) &dev, sizeof(dev), hval);
+    hval = bjhash((unsigned char *) &ino, sizeof(ino), hval);
+    return hval;
+}
+
+/* Rehash every registered file into tables of N buckets */
+PRIVATE int
+db_reg_resize(unsigned int n)
+{
+    reg_status_t **byfile = (reg_status_t **) calloc(n, sizeof(reg_status_t*));
+    reg_status_t **byino = (reg_status_t **) calloc(n, sizeof(reg_status_t*));
+    reg_status_t *r;
+
+    if (!byfile || !byino)
+    {
+        free(byfile);
+        free(byino);
+        return -1;
     }
-    return -1;
+    for (r = _db_reglist; r; r = r->next)
+    {
+        unsigned int i = db_reg_hashfile(r->f) & (n-1);
+        unsigned int j = db_reg_hashino(r->dev, r->ino) & (n-1);
+        r->fnext = byfile[i];
+        byfile[i] = r;
+        r->inext = byino[j];
+        byino[j] = r;
+    }
+    free(_db_regbyfile);
+    free(_db_regbyino);
+    _db_regbyfile = byfile;
+    _db_regbyino = byino;
+    _db_regsize = n;
+    return 0;
+}
+
+PRIVATE int 
+db_register_file(DBfile *dbfile, const db_silo_stat_t *filestate, int writeable)
+{
+    int retval = -1;
+    reg_status_t *r = (reg_status_t *) calloc(1, sizeof(reg_status_t));
+
+    if (!r)
+        return -1;
+    r->f = dbfile;
+    r->w = writeable;
+    db_reg_key(filestate, &r->dev, &r->ino);
+
+    DB_REG_WRLOCK();
+    if (_db_regcount < _db_regsize ||
+        db_reg_resize(_db_regsize ? 2*_db_regsize : DB_NFILES) == 0)
+    {
+        unsigned int i = db_reg_hashfile(dbfile) & (_db_regsize-1);
+        unsigned int j = db_reg_hashino(r->dev, r->ino) & (_db_regsize-1);
+        r->fnext = _db_regbyfile[i];
+        _db_regbyfile[i] = r;
+        r->inext = _db_regbyino[j];
+        _db_regbyino[j] = r;
+        r->next = _db_reglist;
+        if (_db_reglist) _db_reglist->prev = r;
+        _db_reglist = r;
+        _db_regcount++;
+        r = 0;
+        retval = 0;
+    }
+    DB_REG_UNLOCK();
+    free(r);
+    return retval;
 }
 
 PRIVATE int 
 db_unregister_file(DBfile *dbfile)
 {
-    int i;
-    for (i = 0; i < DB_NFILES; i++)
+    reg_status_t **pr, *r = 0;
+
+    DB_REG_WRLOCK();
+    if (_db_regsize)
     {
-        if (_db_regstatus[i].f == dbfile)
+        for (pr = &_db_regbyfile[db_reg_hashfile(dbfile) & (_db_regsize-1)];
+             *pr && (*pr)->f != dbfile; pr = &(*pr)->fnext)
+            /*void*/;
+        if ((r = *pr) != 0)
         {
-            int j;
-            _db_regstatus[i].f = 0;
-            for (j = i; (j < DB_NFILES-1) && (_db_regstatus[j+1].f != 0); j++)
-            {
-                _db_regstatus[j].f = _db_regstatus[j+1].f;
-                _db_regstatus[j].n = _db_regstatus[j+1].n;
-                _db_regstatus[j].w = _db_regstatus[j+1].w;
-            }
-            _db_regstatus[j].f = 0;
-            return i;
+            *pr = r->fnext;
+            for (pr = &_db_regbyino[db_reg_hashino(r->dev, r->ino) & (_db_regsize-1)];
+                 *pr != r; pr = &(*pr)->inext)
+                /*void*/;
+            *pr = r->inext;
+            if (r->prev) r->prev->next = r->next;
+            else _db_reglist = r->next;
+            if (r->next) r->next->prev = r->prev;
+            _db_regcount--;
         }
     }
-    return -1;
+    DB_REG_UNLOCK();
+    free(r);
+    return r ? 0 : -1;
 }
 
 PRIVATE int
 db_isregistered_file(DBfile *dbfile, const db_silo_stat_t *filestate)
 {
-    int i;
-    if (dbfile)
+    int retval = -1;
+    reg_status_t *r;
+
+    DB_REG_RDLOCK();
+    if (!_db_regsize)
+        /*nothing is open*/;
+    else if (dbfile)
     {
-        for (i = 0; i < DB_NFILES; i++)
-        {
-            if (_db_regstatus[i].f == dbfile)
-                return i;
-        }
+        for (r = _db_regbyfile[db_reg_hashfile(dbfile) & (_db_regsize-1)];
+             r && r->f != dbfile; r = r->fnext)
+            /*void*/;
+        if (r) retval = 0;
     }
     else if (filestate)
     {
-        unsigned int hval = 0;
-#ifndef _WIN32
-        hval = bjhash((unsigned char *) &(filestate->s.st_dev), sizeof(filestate->s.st_dev), hval);
-        hval = bjhash((unsigned char *) &(filestate->s.st_ino), sizeof(filestate->s.st_ino), hval);
-#else
-        hval = bjhash((unsigned char *) &(filestate->fileindexlo), sizeof(filestate->fileindexlo), hval);
-        hval = bjhash((unsigned char *) &(filestate->fileindexhi), sizeof(filestate->fileindexhi), hval);
-#endif
-        for (i = 0; i < DB_NFILES; i++)
+        unsigned long long dev, ino;
+        db_reg_key(filestate, &dev, &ino);
+        for (r = _db_regbyino[db_reg_hashino(dev, ino) & (_db_regsize-1)];
+             r; r = r->inext)
         {
-            if (_db_regstatus[i].f != 0 &&
-                _db_regstatus[i].n == hval)
-                return i;
+            if (r->dev == dev && r->ino == ino)
+                retval = retval == 1 || r->w ? 1 : 0;
         }
     }
-    return -1;
+    DB_REG_UNLOCK();
+    return retval;
 }
 
 INTERNAL int
 db_num_registered_files()
 {
-    int i;
-    int cnt = 0;
-    for (i = 0; i < DB_NFILES; i++)
-    {
-        if (_db_regstatus[i].f) cnt++;
-    }
+    int cnt;
+    DB_REG_RDLOCK();
+    cnt = (int) _db_regcount;
+    DB_REG_UNLOCK();
     return cnt;
 }
 
@@ -2534,4136 +2813,6537 @@ DB_SETGET(int, AllowLongStrComponents, allowLongStrComponents, DB_INTBOOL_NOT_SE
 DB_SETGET(unsigned long long, DataReadMask2, dataReadMask, DB_MASK_NOT_SET) 
 #warning WHAT ABOUT FORCESINGLE SHOWERRORS
 
-/* The compression stuff has some custom initialization */
-static void _db_set_compression_params(char **dst, char const *s)
-{
-    if (s && *s == '\0') {
-        if (*dst)
-            FREE(*dst);
-        *dst = ALLOC_N(char, 12);
-        strcpy(*dst, "METHOD=GZIP");
-    }   
-    else if (s) {
-        if (*dst)
-            FREE(*dst);
-        *dst = ALLOC_N(char,strlen(s)+1);
-        strcpy(*dst, s);
-    }
-    else {
-        if (*dst)
-            FREE(*dst);
-        *dst=0;
-    }
-}
-
 /*----------------------------------------------------------------------
- * Routine:  DBSetCompression
- *
- * Purpose:  Set and return the enable Compression flags 
- *
- * Programmer:  Thomas R. Treadway, Wed Feb 28 11:36:34 PST 2007
- *
- * Description:  This routine enters the compression method information.
+ * Compiled compression strings.
+ *
+ * A compression string is parsed once, when it is set, into a
+ * db_comppolicy_t so that the drivers don't search the string for each
+ * dataset they write. The string is a list of rules separated by `;'.
+ * Each rule is a list of KEY=VALUE settings separated by white space,
+ * as in "METHOD=GZIP LEVEL=5 MINSIZE=1024". A rule may also have any of
+ * the selectors
+ *
+ *     OBJTYPE=<type>   an object type name such as ucdvar or quadmesh,
+ *                      or variable for arrays written with DBWrite
+ *     NAME=<pattern>   an object name, where * and ? are wildcards
+ *     DATATYPE=<type>  one of char, short, int, long, long_long, float
+ *                      or double
+ *
+ * Rules without selectors together give the default settings. The other
+ * rules start from the defaults and the first one whose selectors all
+ * match an object decides how its arrays are compressed. MINSIZE=n
+ * stores arrays of fewer than n values uncompressed.
+ *
+ * METHOD=AUTO trial compresses SAMPLE=n values (65536) of each array
+ * with GZIP, with FPZIP for floating point data and with ZFP if the rule
+ * has ZFP settings. The array is compressed with whichever gives the
+ * best ratio among those faster than MINSPEED=x MB/s, or with the
+ * fastest if none is. If none reaches MINRATIO the array is stored
+ * uncompressed. DBGetCompressionStats reports the choices made.
  *--------------------------------------------------------------------*/
-PUBLIC void
-DBSetCompression(const char *s)
-{
-    return _db_set_compression_params(&SILO_Globals.compressionParams, s);
-}
 
-PUBLIC char const * 
-DBGetCompression()
+/* Match NAME against a pattern with * and ? wildcards */
+PRIVATE int
+db_comp_glob(char const *pat, char const *name)
 {
-    return SILO_Globals.compressionParams;
-}
+    char const *star = 0, *resume = 0;
 
-static char const *db_SetGetCompressionFile(DBfile *f, char const *val, int set)
-{
-    char const *retval;
-    API_BEGIN("DB(Set|Get)CompressionFile", char const *, 0) {
-        if (!f)
-            API_ERROR("DBfile*", E_BADARGS);
-        retval = f->pub.file_scope_globals->compressionParams;
-        if (set)
-            _db_set_compression_params(&(f->pub.file_scope_globals->compressionParams), val);
-        if (retval == DB_CHAR_PTR_NOT_SET)
-            retval = DBGetCompression();
-        API_RETURN(retval);
+    while (*name)
+    {
+        if (*pat == '*')
+        {
+            star = pat++;
+            resume = name;
+        }
+        else if (*pat == '?' || *pat == *name)
+        {
+            pat++;
+            name++;
+        }
+        else if (star)
+        {
+            pat = star + 1;
+            name = ++resume;
+        }
+        else
+            return 0;
     }
-    API_END_NOPOP;
+    while (*pat == '*')
+        pat++;
+    return *pat == '\0';
 }
 
-PUBLIC void
-DBSetCompressionFile(DBfile *f, char const *s)
+/* Split the next setting off a rule, returning its key and value. A
+   bare word has a null value. A comma followed by a letter also ends a
+   setting so that old strings like "METHOD=GZIP,LEVEL=5" still work. */
+PRIVATE char *
+db_comp_token(char **rule, char **val)
 {
-    db_SetGetCompressionFile(f, s, 1);
+    char *s = *rule, *e;
+
+    while (*s && (isspace((unsigned char) *s) || *s == ','))
+        s++;
+    if (!*s)
+        return 0;
+    for (e = s; *e && !isspace((unsigned char) *e); e++)
+        if (*e == ',' && isalpha((unsigned char) e[1]))
+            break;
+    *rule = *e ? e + 1 : e;
+    *e = '\0';
+    if ((*val = strchr(s, '=')) != 0)
+        *(*val)++ = '\0';
+    return s;
 }
 
-PUBLIC char const * 
-DBGetCompressionFile(DBfile *f)
+PRIVATE int
+db_comp_isselector(char const *key)
 {
-    return db_SetGetCompressionFile(f, 0, 0);
+    return !strcmp(key, "OBJTYPE") || !strcmp(key, "NAME") ||
+           !strcmp(key, "DATATYPE");
 }
 
-PUBLIC int
-DBFreeCompressionResources(DBfile *dbfile, const char *meshname)
+PRIVATE int
+db_comp_long(char const *val, long long lo, long long hi, long long *out)
 {
-    int retval = 0;
-
-    API_BEGIN2("DBFreeCompressionResources", int, -1, api_dummy) {
-
-        if (!dbfile->pub.free_z)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        retval = ((dbfile->pub.free_z) (dbfile, meshname));
+    char *end;
+    long long v;
 
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    if (!val || !*val)
+        return -1;
+    errno = 0;
+    v = strtoll(val, &end, 10);
+    if (*end || errno || v < lo || v > hi)
+        return -1;
+    *out = v;
+    return 0;
 }
 
-#define CHECK_FOR_FRIENDLY(ON,SU)					\
-    ntotal += toc->n ## ON;						\
-    for (i = 0; i < toc->n ## ON; i++)					\
-    {									\
-        char tmp[1024];							\
-        snprintf(tmp, sizeof(tmp), "%s_%s", toc->ON ## _names[i], SU);	\
-        if (DBInqVarExists(f, tmp))					\
-            nfriendly++;						\
-    }
-
-/*----------------------------------------------------------------------
- * Routine:  db_guess_has_friendly_HDF5_names_r 
- *
- * Purpose:  Recursive helper func for DBGuessHasFriendlyHDF5Names 
- *           names.
- *
- * Programmer: Mark C. Miller, Wed Sep  2 15:27:06 PDT 2009
- *
- *--------------------------------------------------------------------*/
 PRIVATE int
-db_guess_has_friendly_HDF5_names_r(DBfile *f)
+db_comp_double(char const *val, double lo, double *out)
 {
-    int i, ntotal = 0, nfriendly = 0;
-    int retval;
-    DBtoc *toc;
+    char *end;
+    double v;
 
-    toc = DBGetToc(f);
+    if (!val || !*val)
+        return -1;
+    errno = 0;
+    v = strtod(val, &end);
+    if (*end || errno || v <= lo)
+        return -1;
+    *out = v;
+    return 0;
+}
 
-    if (!toc) return 0;
+/* Apply one setting to a rule. Returns -1 if it is not understood. */
+PRIVATE int
+db_comp_setting(db_comprule_t *r, char const *key, char const *val)
+{
+    long long v;
+    double d;
 
-    CHECK_FOR_FRIENDLY(multimesh, "meshnames");
-    CHECK_FOR_FRIENDLY(multivar, "varnames");
-    CHECK_FOR_FRIENDLY(multimat, "matnames");
-    CHECK_FOR_FRIENDLY(qmesh, "coord0");
-    CHECK_FOR_FRIENDLY(qvar, "data");
-    CHECK_FOR_FRIENDLY(ucdmesh, "coord0");
-    CHECK_FOR_FRIENDLY(ucdvar, "data");
-    CHECK_FOR_FRIENDLY(ptmesh, "coord0");
-    CHECK_FOR_FRIENDLY(ptvar, "data");
-    CHECK_FOR_FRIENDLY(csgmesh, "_coeffs");
-    CHECK_FOR_FRIENDLY(csgvar, "data");
-    CHECK_FOR_FRIENDLY(mat, "_matlist");
-    CHECK_FOR_FRIENDLY(matspecies, "_speclist");
-    CHECK_FOR_FRIENDLY(curve, "_yvals");
-    CHECK_FOR_FRIENDLY(obj, "_nodelist");
-
-    if (ntotal >= 3) /* arb. min of 3 objects */
+    if (!val)
     {
-        if (nfriendly >= ntotal/2)
-            return 1;
+        if (strcmp(key, "REVERSIBLE"))
+            return -1;
+        r->zfpmode = DB_ZFPMODE_REVERSIBLE;
+    }
+    else if (!strcmp(key, "METHOD"))
+    {
+        if      (!strcmp(val, "NONE"))  r->method = DB_COMPMETHOD_NONE;
+        else if (!strcmp(val, "GZIP"))  r->method = DB_COMPMETHOD_GZIP;
+        else if (!strcmp(val, "SZIP"))  r->method = DB_COMPMETHOD_SZIP;
+        else if (!strcmp(val, "HZIP"))  r->method = DB_COMPMETHOD_HZIP;
+        else if (!strcmp(val, "FPZIP")) r->method = DB_COMPMETHOD_FPZIP;
+        else if (!strcmp(val, "ZFP"))   r->method = DB_COMPMETHOD_ZFP;
+        else if (!strcmp(val, "AUTO"))  r->method = DB_COMPMETHOD_AUTO;
+        else return -1;
+    }
+    else if (!strcmp(key, "ERRMODE"))
+    {
+        if (!strncmp(val, "FALL", 4))
+            r->errmode = COMPRESSION_ERRMODE_FALLBACK;
+        else if (!strncmp(val, "FAIL", 4))
+            r->errmode = COMPRESSION_ERRMODE_FAIL;
         else
-            return 0;
+            return -1;
     }
-
-    retval = -1;
-    for (i = 0; i < toc->ndir && retval == -1; i++)
+    else if (!strcmp(key, "MINRATIO"))
     {
-        DBSetDir(f, toc->dir_names[i]);
-        retval = db_guess_has_friendly_HDF5_names_r(f);
-        DBSetDir(f, "..");
+        if (db_comp_double(val, 1.0, &d) < 0)
+            return -1;
+        r->minratio = (float) d;
     }
-
-    return retval;
+    else if (!strcmp(key, "MINSIZE"))
+    {
+        if (db_comp_long(val, 1, LLONG_MAX, &r->minsize) < 0)
+            return -1;
+    }
+    else if (!strcmp(key, "CHUNK"))
+    {
+        if (db_comp_long(val, 1, LLONG_MAX, &r->chunk) < 0)
+            return -1;
+    }
+    else if (!strcmp(key, "SAMPLE"))
+    {
+        if (db_comp_long(val, 1, LLONG_MAX, &r->sample) < 0)
+            return -1;
+    }
+    else if (!strcmp(key, "MINSPEED"))
+    {
+        if (db_comp_double(val, 0.0, &r->minspeed) < 0)
+            return -1;
+    }
+    else if (!strcmp(key, "LEVEL"))
+    {
+        if (db_comp_long(val, 0, 9, &v) < 0)
+            return -1;
+        r->level = (int) v;
+    }
+    else if (!strcmp(key, "BLOCK"))
+    {
+        if (db_comp_long(val, 0, 32, &v) < 0)
+            return -1;
+        r->block = (int) v;
+    }
+    else if (!strcmp(key, "MASK"))
+    {
+        if (!strcmp(val, "EC"))
+            r->szipec = 1;
+        else if (!strcmp(val, "NN"))
+            r->szipec = 0;
+        else
+            return -1;
+    }
+    else if (!strcmp(key, "CODEC"))
+    {
+        if (!strcmp(val, "zlib"))
+            r->hzcodec = 1;
+        else if (!strcmp(val, "base"))
+            r->hzcodec = 0;
+        else
+            return -1;
+    }
+    else if (!strcmp(key, "BITS"))
+    {
+        if (db_comp_long(val, 0, 64, &v) < 0)
+            return -1;
+        r->hzbits = (int) v;
+    }
+    else if (!strcmp(key, "LOSS"))
+    {
+        if (db_comp_long(val, 0, 3, &v) < 0)
+            return -1;
+        r->loss = (int) v;
+    }
+    else if (!strcmp(key, "RATE") || !strcmp(key, "ACCURACY"))
+    {
+        if (db_comp_double(val, 0.0, &r->zfpparam) < 0)
+            return -1;
+        r->zfpmode = key[0] == 'R' ? DB_ZFPMODE_RATE : DB_ZFPMODE_ACCURACY;
+    }
+    else if (!strcmp(key, "PRECISION"))
+    {
+        if (db_comp_long(val, 1, UINT_MAX, &v) < 0)
+            return -1;
+        r->zfpprec = (unsigned) v;
+        r->zfpmode = DB_ZFPMODE_PRECISION;
+    }
+    else if (!strcmp(key, "EXPERT"))
+    {
+        if (sscanf(val, "%u,%u,%u,%d", &r->zfpexpert[0], &r->zfpexpert[1],
+                   &r->zfpexpert[2], &r->zfpminexp) != 4)
+            return -1;
+        r->zfpmode = DB_ZFPMODE_EXPERT;
+    }
+    else if (!strcmp(key, "OBJTYPE"))
+    {
+        if (!strcmp(val, "variable"))
+            r->objtype = DB_VARIABLE;
+        else if ((r->objtype = DBGetObjtypeTag(val)) == DB_USERDEF &&
+                 strcmp(val, "userdef"))
+            return -1;
+    }
+    else if (!strcmp(key, "DATATYPE"))
+    {
+        if      (!strcmp(val, "char"))      r->datatype = DB_CHAR;
+        else if (!strcmp(val, "short"))     r->datatype = DB_SHORT;
+        else if (!strcmp(val, "int"))       r->datatype = DB_INT;
+        else if (!strcmp(val, "long"))      r->datatype = DB_LONG;
+        else if (!strcmp(val, "long_long")) r->datatype = DB_LONG_LONG;
+        else if (!strcmp(val, "float"))     r->datatype = DB_FLOAT;
+        else if (!strcmp(val, "double"))    r->datatype = DB_DOUBLE;
+        else return -1;
+    }
+    else if (!strcmp(key, "NAME"))
+    {
+        FREE(r->name);
+        r->name = STRDUP(val);
+    }
+    else
+        return -1;
+    return 0;
 }
 
 /*----------------------------------------------------------------------
- * Routine:  DBGuessHasFriendlyHDF5Names
- *
- * Purpose:  Determine if it looks like a given file has HDF5 friendly 
- *           names.
+ * Routine:  db_CompileCompression
  *
- * Programmer: Mark C. Miller, Wed Sep  2 15:27:06 PDT 2009
+ * Purpose:  Compile a compression string into rules. Settings that are
+ *           not understood mark their rule bad rather than failing here
+ *           so that, as before, the error is reported when the string
+ *           is used to write something.
  *
+ * Return:   The compiled string or NULL if S is NULL.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBGuessHasFriendlyHDF5Names(DBfile *f)
+INTERNAL db_comppolicy_t *
+db_CompileCompression(char const *s)
 {
-    char cwd[1024];
-    int retval;
+    db_comppolicy_t *policy;
+    db_comprule_t *dflt;
+    char *buf, *p, **keys, **vals;
+    int *segs, *selected;
+    int ntoks = 0, nsegs = 1, pass, i, j;
 
-#ifdef DB_HDF5X
-    if (DBGetDriverType(f) != DB_HDF5X)
+    if (!s)
         return 0;
-#endif
 
-    DBGetDir(f, cwd);
-    retval = db_guess_has_friendly_HDF5_names_r(f);
-    DBSetDir(f, cwd);    
+    /* Split the string into settings, numbering the rule of each */
+    buf = STRDUP(s);
+    keys = ALLOC_N(char *, strlen(s) + 1);
+    vals = ALLOC_N(char *, strlen(s) + 1);
+    segs = ALLOC_N(int, strlen(s) + 1);
+    for (p = buf; *p; p++)
+        if (*p == ';')
+            nsegs++;
+    selected = ALLOC_N(int, nsegs);
+    for (i = 0, p = buf; p; i++)
+    {
+        char *rule = p;
+        if ((p = strchr(p, ';')) != 0)
+            *p++ = '\0';
+        while ((keys[ntoks] = db_comp_token(&rule, &vals[ntoks])) != 0)
+        {
+            selected[i] |= db_comp_isselector(keys[ntoks]);
+            segs[ntoks++] = i;
+        }
+    }
 
-    return retval;
+    policy = ALLOC(db_comppolicy_t);
+    policy->rules = ALLOC_N(db_comprule_t, nsegs + 1);
+    policy->nrules = 1;
+    dflt = &policy->rules[0];
+    dflt->objtype = -1;
+    dflt->datatype = -1;
+    dflt->method = -1;
+    dflt->errmode = COMPRESSION_ERRMODE_FALLBACK;
+    dflt->minratio = 2.0;
+    dflt->level = 1;
+    dflt->block = 4;
+    dflt->sample = 65536;
+    dflt->hzcodec = -1;
+    dflt->hzbits = -1;
+
+    /* The defaults come first, then the rules with selectors */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < ntoks; i = j)
+        {
+            db_comprule_t *r = dflt;
+
+            for (j = i; j < ntoks && segs[j] == segs[i]; j++)
+                ;
+            if (selected[segs[i]] != pass)
+                continue;
+            if (pass == 1)
+            {
+                r = &policy->rules[policy->nrules++];
+                *r = *dflt;
+                r->name = 0;
+            }
+            for (; i < j; i++)
+                if (db_comp_setting(r, keys[i], vals[i]) < 0)
+                    r->bad = 1;
+        }
+
+        /* A string with no METHOD anywhere is an error, otherwise
+           anything no rule selects is stored uncompressed */
+        if (pass == 0 && dflt->method < 0 && strstr(s, "METHOD="))
+            dflt->method = DB_COMPMETHOD_NONE;
+    }
+    for (i = 0; i < policy->nrules; i++)
+        if (policy->rules[i].method < 0)
+            policy->rules[i].bad = 1;
+
+    FREE(selected);
+    FREE(segs);
+    FREE(vals);
+    FREE(keys);
+    FREE(buf);
+    return policy;
+}
+
+INTERNAL void
+db_FreeCompression(db_comppolicy_t *policy)
+{
+    int i;
+
+    if (!policy)
+        return;
+    for (i = 0; i < policy->nrules; i++)
+        FREE(policy->rules[i].name);
+    FREE(policy->rules);
+    free(policy);
 }
 
 /*----------------------------------------------------------------------
- * Routine:  DBSetUnknownDriverPriority
- *
- * Purpose:  Set priority order of drivers used by unknown driver. 
+ * Routine:  db_SelectCompression
  *
- * Programmer:  Mark C. Miller, May 1, 2006 
+ * Purpose:  Find the rule of a compiled compression string that applies
+ *           to the arrays of an object of type OBJTYPE named NAME with
+ *           values of type DATATYPE. Pass -1 and NULL for an unknown
+ *           object type and name.
  *
- * Description:  This routine sets the flag that controls whether
- *               checksums are computed on client data.
+ * Return:   The rule or NULL if POLICY is NULL.
  *--------------------------------------------------------------------*/
-PUBLIC int const * 
-DBSetUnknownDriverPriorities(const int *priorities)
+INTERNAL db_comprule_t const *
+db_SelectCompression(db_comppolicy_t const *policy, int objtype,
+    char const *name, int datatype)
 {
-    int i = 0;
-    static int oldPriorities[MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1];
-    memcpy(oldPriorities, SILO_Globals.unknownDriverPriorities, sizeof(oldPriorities));
-    while (i < (MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1) && priorities[i] >= 0)
+    int i;
+
+    if (!policy)
+        return 0;
+    for (i = 1; i < policy->nrules; i++)
     {
-        SILO_Globals.unknownDriverPriorities[i] = priorities[i];
-        i++;
+        db_comprule_t const *r = &policy->rules[i];
+
+        if (r->objtype >= 0 && r->objtype != objtype &&
+            !(r->objtype == DB_QUADMESH &&
+              (objtype == DB_QUAD_RECT || objtype == DB_QUAD_CURV)))
+            continue;
+        if (r->datatype >= 0 && r->datatype != datatype)
+            continue;
+        if (r->name && (!name || !db_comp_glob(r->name, name)))
+            continue;
+        return r;
     }
-    if (i < (MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1))
-        SILO_Globals.unknownDriverPriorities[i] = -1;
-    return oldPriorities;
+    return &policy->rules[0];
 }
 
-PUBLIC int const *
-DBGetUnknownDriverPriorities()
+/*----------------------------------------------------------------------
+ * Routine:  db_GetCompressionPolicy
+ *
+ * Purpose:  Return the compiled form of DBGetCompressionFile(dbfile).
+ *--------------------------------------------------------------------*/
+INTERNAL db_comppolicy_t const *
+db_GetCompressionPolicy(DBfile *dbfile)
 {
-    static int priorities[MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1];
-    memcpy(priorities, SILO_Globals.unknownDriverPriorities, sizeof(priorities));
-    return priorities;
+    if (dbfile && dbfile->pub.file_scope_globals->compressionParams !=
+                  (char *) DB_CHAR_PTR_NOT_SET)
+        return dbfile->pub.file_scope_globals->compressionPolicy;
+    return SILO_Globals.compressionPolicy;
 }
 
-PUBLIC int
-DBRegisterFileOptionsSet(const DBoptlist *opts)
+/* The compression stuff has some custom initialization */
+static void _db_set_compression_params(char **dst, db_comppolicy_t **policy,
+    char const *s)
 {
-    int i;
+    if (*dst != (char *) DB_CHAR_PTR_NOT_SET)
+        FREE(*dst);
+    db_FreeCompression(*policy);
+    if (s && *s == '\0')
+        s = "METHOD=GZIP";
+    *dst = s ? STRDUP(s) : 0;
+    *policy = db_CompileCompression(*dst);
+}
 
-    API_BEGIN("DBRegisterFileOptionsSet", int, -1) {
-        for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
-        {
-            if (SILO_Globals.fileOptionsSets[i] == 0)
-            {
-                SILO_Globals.fileOptionsSets[i] = opts;
-                API_RETURN(i+NUM_DEFAULT_FILE_OPTIONS_SETS);
-            }
-        }
-        API_ERROR("Silo library", E_MAXFILEOPTSETS);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+/*----------------------------------------------------------------------
+ * Routine:  DBSetCompression
+ *
+ * Purpose:  Set and return the enable Compression flags 
+ *
+ * Programmer:  Thomas R. Treadway, Wed Feb 28 11:36:34 PST 2007
+ *
+ * Description:  This routine enters the compression method information.
+ *--------------------------------------------------------------------*/
+PUBLIC void
+DBSetCompression(const char *s)
+{
+    _db_set_compression_params(&SILO_Globals.compressionParams,
+        &SILO_Globals.compressionPolicy, s);
 }
 
-PUBLIC int
-DBUnregisterFileOptionsSet(int opts_set_id)
+PUBLIC char const * 
+DBGetCompression()
 {
-    int _opts_set_id = opts_set_id-NUM_DEFAULT_FILE_OPTIONS_SETS;
+    return SILO_Globals.compressionParams;
+}
 
-    API_BEGIN("DBUnregisterFileOptionsSet", int, -1) {
-        if (SILO_Globals.fileOptionsSets[_opts_set_id] == 0)
-            API_ERROR("opts_set_id", E_BADARGS);
-        SILO_Globals.fileOptionsSets[_opts_set_id] = 0;
-        API_RETURN(0);
+static char const *db_SetGetCompressionFile(DBfile *f, char const *val, int set)
+{
+    char const *retval;
+    API_BEGIN("DB(Set|Get)CompressionFile", char const *, 0) {
+        if (!f)
+            API_ERROR("DBfile*", E_BADARGS);
+        retval = f->pub.file_scope_globals->compressionParams;
+        if (set)
+            _db_set_compression_params(&(f->pub.file_scope_globals->compressionParams),
+                &(f->pub.file_scope_globals->compressionPolicy), val);
+        if (retval == DB_CHAR_PTR_NOT_SET)
+            retval = DBGetCompression();
+        API_RETURN(retval);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END_NOPOP;
 }
 
 PUBLIC void
-DBUnregisterAllFileOptionsSets()
+DBSetCompressionFile(DBfile *f, char const *s)
 {
-    int i;
+    db_SetGetCompressionFile(f, s, 1);
+}
 
-    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
-        SILO_Globals.fileOptionsSets[i] = 0;
+PUBLIC char const * 
+DBGetCompressionFile(DBfile *f)
+{
+    return db_SetGetCompressionFile(f, 0, 0);
 }
 
-const int* db_get_used_file_options_sets_ids()
+/*----------------------------------------------------------------------
+ * Routine:  DBSetThreads
+ *
+ * Purpose:  Set the most threads any one call may split its work
+ *           among. This covers coordinate extents, external facelists,
+ *           material conversions and tiled (de)compression. Builds
+ *           without thread safety accept the setting but always use
+ *           one thread. Returns the old number.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBSetThreads(int nthreads)
 {
-    int i,n;
-    static int used_slots[MAX_FILE_OPTIONS_SETS+NUM_DEFAULT_FILE_OPTIONS_SETS+1];
+    int oldThreads = SILO_Globals.threads;
 
-   
-    /* For the default cases, only return those that 'matter' in that
-       they could possibly have an impact on Silo's ability to actually
-       open the file. In addtion, put them in some kind of priority order */
-    n = 0;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_SILO;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_SPLIT;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_DIRECT;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_FAMILY;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_MPIO;
-    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_MPIP;
-    for (i = n; i < MAX_FILE_OPTIONS_SETS+NUM_DEFAULT_FILE_OPTIONS_SETS+1; i++)
-        used_slots[i] = -1;
+    if (nthreads < 1)
+        return db_perror("nthreads", E_BADARGS, "DBSetThreads");
+    SILO_Globals.threads = nthreads;
+    return oldThreads;
+}
 
-    /* fill in with used options set slots */
-    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
-    {
-        if (SILO_Globals.fileOptionsSets[i]==0)
-            continue;
-        used_slots[n++] = i+NUM_DEFAULT_FILE_OPTIONS_SETS;
-    }
+PUBLIC int
+DBGetThreads(void)
+{
+    return SILO_Globals.threads;
+}
 
-    return used_slots;
+/*
+ * A batch of jobs started by db_StartJobs. Jobs are SIZE bytes apart in
+ * JOBS; a SIZE of zero hands JOBS itself to every one of them.
+ */
+struct db_jobs_t {
+    db_job_func_t  func;
+    char          *jobs;
+    size_t         size;
+    int            njobs;
+#if SILO_THREADSAFE
+    struct db_jobthread_t {
+        struct db_jobs_t *batch;
+        int            j;
+        int            started;
+        pthread_t      thread;
+    }             *threads;
+#endif
+};
+
+#if SILO_THREADSAFE
+SILO_CALLBACK void *
+db_job_thread(void *arg)
+{
+    struct db_jobthread_t *t = (struct db_jobthread_t *) arg;
+    t->batch->func(t->batch->jobs + t->j * t->batch->size);
+    return 0;
 }
+#endif
 
 /*----------------------------------------------------------------------
- * Routine:  DBGrabDriver
+ * Function: db_StartJobs
  *
- * Purpose:  Set and return the low level driver file handle
+ * Purpose:  Start FUNC on each of the NJOBS jobs in JOBS on its own
+ *           thread. Jobs whose thread could not be started, which is
+ *           all of them in builds without thread safety, are run by
+ *           db_FinishJobs instead.
  *
- * Programmer:  Thomas R. Treadway, Tue May 29 15:52:19 PDT 2007
- *
- * Description:  This routine returns a ponter to the driver-native
- * file handle.
- *
- * Modifications
- *   Mark C. Miller, Thu Oct 11 15:36:10 PDT 2007
- *   Record fact file was grabbed by adding var at top-level
+ * Return:   The batch, with the number of threads started in
+ *           *NSTARTED, or NULL if out of memory, in which case no job
+ *           has run.
  *--------------------------------------------------------------------*/
-PUBLIC void * 
-DBGrabDriver(DBfile *file)
+INTERNAL db_jobs_t *
+db_StartJobs(db_job_func_t func, void *jobs, size_t size, int njobs,
+    int *nstarted)
 {
-    void *rtn = 0;
-    if (file) {
-       if (file->pub.GrabId > (void *) 0) {
-          int grab_val = 1;
-          DBWrite(file, "/_was_grabbed", &grab_val, &grab_val, 1, DB_INT);
-#warning FIX GLOBAL LOCK
-          SILO_Globals.enableGrabDriver = TRUE;
-          rtn = (void *) file->pub.GrabId;
-       }
+    db_jobs_t     *batch = ALLOC(db_jobs_t);
+
+    *nstarted = 0;
+    if (!batch)
+        return 0;
+    batch->func = func;
+    batch->jobs = (char *) jobs;
+    batch->size = size;
+    batch->njobs = njobs;
+#if SILO_THREADSAFE
+    if (njobs > 0)
+    {
+        int j;
+
+        if (NULL == (batch->threads = ALLOC_N(struct db_jobthread_t, njobs)))
+        {
+            FREE(batch);
+            return 0;
+        }
+        for (j = 0; j < njobs; j++)
+        {
+            batch->threads[j].batch = batch;
+            batch->threads[j].j = j;
+            batch->threads[j].started = pthread_create(
+                &batch->threads[j].thread, 0, db_job_thread,
+                &batch->threads[j]) == 0;
+            *nstarted += batch->threads[j].started;
+        }
     }
-    return rtn;
+    else
+        batch->threads = 0;
+#endif
+    return batch;
 }
+
 /*----------------------------------------------------------------------
- * Routine:  DBGetDriverType
- *
- * Purpose:  Return the drive type 
+ * Function: db_FinishJobs
  *
- * Programmer:  Thomas R. Treadway, Thu Jun  7 13:19:48 PDT 2007
- *
- * Description:  This routine returns a the driver type
+ * Purpose:  Wait for the threads of BATCH, run any job which did not
+ *           get a thread on this one and free BATCH.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBGetDriverType(const DBfile *file)
+INTERNAL void
+db_FinishJobs(db_jobs_t *batch)
 {
-    if (file) {
-       return file->pub.type;
+    int            j;
+
+    if (!batch)
+        return;
+    for (j = 0; j < batch->njobs; j++)
+    {
+#if SILO_THREADSAFE
+        if (batch->threads[j].started)
+        {
+            pthread_join(batch->threads[j].thread, 0);
+            continue;
+        }
+#endif
+        batch->func(batch->jobs + j * batch->size);
     }
-    return DB_UNKNOWN;
+#if SILO_THREADSAFE
+    FREE(batch->threads);
+#endif
+    FREE(batch);
 }
 
 /*----------------------------------------------------------------------
- * Routine:  DBGetDriverTypeFromPath
- *
- * Purpose:  Return the drive type 
- *
- * Programmer:  Thomas R. Treadway, Tue Jul  3 15:24:58 PDT 2007
- *
- * Description:  This routine returns a the driver type
- *
- * Modifications:
- *
- * Thomas R. Treadway, Thu Jul  5 11:57:03 PDT 2007
- * DB_HDR5 is conditional
- *
- * Mark C. Miller, Mon Nov 19 10:45:05 PST 2007
- * Removed conditional compilation on HDF5 driver
+ * Function: db_RunJobs
  *
- * Mark C. Miller, Mon Oct 25 16:12:49 PDT 2010
- * Initialize buf to ensure it will be null terminated no matter
- * what happens during open/read.
+ * Purpose:  Run FUNC on each of the NJOBS jobs in JOBS, the first on
+ *           this thread and the rest on threads of their own, and wait
+ *           for all of them. Jobs are SIZE bytes apart. A job which
+ *           cannot get a thread runs on this one.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBGetDriverTypeFromPath(const char *path)
+INTERNAL void
+db_RunJobs(db_job_func_t func, void *jobs, size_t size, int njobs)
 {
-   char buf[9] = {'\0','\0','\0','\0','\0','\0','\0','\0','\0'};
-   int fd;
-   int nbytes;
-   int flags = O_RDONLY;
-   if ((fd = open(path, flags)) < 0) {
-      printf("cannot open `%s'\n", path);
-      return -1;
-   }
-   if ((nbytes = read(fd, (char *)buf, 8)) == -1) {
-      printf("cannot read `%s'\n", path);
-      close(fd);
-      return -1;
-   }
-   if (nbytes <= 5) {
-      printf("cannot read `%s' buffer too small\n", path);
-      close(fd);
-      return -1;
-   }
-   (void) close(fd);
-   if (strstr(buf, "PDB"))
-      return DB_PDB;
-#ifdef DB_HDF5X
-   if (strstr(buf, "HDF"))
-      return DB_HDF5X;
-#endif
-   return DB_UNKNOWN;
+    db_jobs_t     *batch = 0;
+    int            j, nstarted;
+
+    if (njobs <= 0)
+        return;
+    if (njobs > 1)
+        batch = db_StartJobs(func, (char *) jobs + size, size, njobs - 1,
+                             &nstarted);
+    func(jobs);
+    if (batch)
+        db_FinishJobs(batch);
+    else
+        for (j = 1; j < njobs; j++)
+            func((char *) jobs + j * size);
 }
 
-/*----------------------------------------------------------------------
- * Routine:  DBJoinPath
- *
- * Purpose:  Given paths with possible relative naming, combine them
- *           into a single absolute path. 
- *
- * Programmer:  Mark C. Miller, July 20, 2008 
- *--------------------------------------------------------------------*/
-PUBLIC char * 
-DBJoinPath(const char *first, const char *second)
+static DBcompressionstats db_compression_stats;
+
+/* Count a choice made by METHOD=AUTO */
+INTERNAL void
+db_RecordCompression(int method, long long nbytes, long long nbytes_est,
+    long long nbytes_trial, double trial_time)
 {
-    API_BEGIN("DBJoinPath", char *, NULL) {
-        API_RETURN(db_join_path(first, second));
+    DBcompressionstats *s = &db_compression_stats;
+
+    DB_LOCK_GLOBAL();
+    s->narrays++;
+    switch (method)
+    {
+        case DB_COMPMETHOD_GZIP:  s->ngzip++;  break;
+        case DB_COMPMETHOD_FPZIP: s->nfpzip++; break;
+        case DB_COMPMETHOD_ZFP:   s->nzfp++;   break;
+        default:                  s->nnone++;  break;
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    s->nbytes += nbytes;
+    s->nbytes_est += nbytes_est;
+    s->nbytes_trial += nbytes_trial;
+    s->trial_time += trial_time;
+    DB_UNLOCK_GLOBAL();
 }
 
 /*----------------------------------------------------------------------
- * Routine:  DBUngrabDriver
- *
- * Purpose:  Return control of the low level driver
- *
- * Programmer:  Thomas R. Treadway, Thu Jun  7 13:19:48 PDT 2007
+ * Routine:  DBGetCompressionStats
  *
- * Description:  This routine returns a the driver-native type
+ * Purpose:  Return what METHOD=AUTO compression has chosen for the
+ *           arrays written since the last DBResetCompressionStats.
  *--------------------------------------------------------------------*/
 PUBLIC int
-DBUngrabDriver(DBfile *file, const void *driver_handle)
+DBGetCompressionStats(DBcompressionstats *stats)
 {
-    if (file) {
-       SILO_Globals.enableGrabDriver = FALSE;
-       return file->pub.type;
+    API_BEGIN("DBGetCompressionStats", int, -1) {
+        if (!stats)
+            API_ERROR("stats", E_BADARGS);
+        DB_LOCK_GLOBAL();
+        *stats = db_compression_stats;
+        DB_UNLOCK_GLOBAL();
+        API_RETURN(0);
     }
-    return DB_UNKNOWN;
+    API_END_NOPOP;
 }
 
-static int 
-db_IncObjectComponentCount(DBobject *obj)
+PUBLIC void
+DBResetCompressionStats(void)
 {
-    int new_maxcomps = 0;
-    char **new_comp_names = 0;
-    char **new_pdb_names = 0;
+    DB_LOCK_GLOBAL();
+    memset(&db_compression_stats, 0, sizeof db_compression_stats);
+    DB_UNLOCK_GLOBAL();
+}
 
-    obj->ncomponents++;
-    if (obj->ncomponents < obj->maxcomponents)
-        return 1;
+/* Everything counted while no file was current, and closed files */
+static DBfilestats db_global_stats;
 
-    new_maxcomps = obj->maxcomponents * 1.5 + 1; /* golden rule + 1 */
-    new_comp_names = REALLOC_N(obj->comp_names, char *, new_maxcomps);
-    if (!new_comp_names)
+/* Who wants statistics: DBSetFileStats, and tracing for its byte counts */
+#define DB_STATS_BY_USER        0x1
+#define DB_STATS_BY_TRACE       0x2
+int db_stats_on = 0;
+
+/* Wall clock seconds, for timing */
+INTERNAL double
+db_WallTime(void)
+{
+#if HAVE_SYS_TIME_H
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (double) tv.tv_sec + 1.0e-6 * (double) tv.tv_usec;
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* The object type an API call like "DBPutUcdvar" reads or writes */
+PRIVATE int
+db_stats_objtype(char const *name)
+{
+    char type_name[64];
+    int i, n, tag;
+
+    if (strncmp(name, "DBGet", 5) != 0 && strncmp(name, "DBPut", 5) != 0)
+        return DB_INVALID_OBJECT;
+    for (i = 0, n = 5; name[n] && i < (int) sizeof(type_name) - 1; i++, n++)
+        type_name[i] = (char) tolower(name[n]);
+    while (i > 0 && isdigit((unsigned char) type_name[i-1]))
+        i--;
+    type_name[i] = '\0';
+    if (!i)
+        return DB_INVALID_OBJECT;
+    if (STR_EQUAL(type_name, "phzonelist"))
+        return DB_PHZONELIST;
+    tag = DBGetObjtypeTag(type_name);
+    return tag == DB_USERDEF ? DB_INVALID_OBJECT : tag;
+}
+
+/*
+ * Every timed API call has the same slot in the calls[] of all stats.
+ * Slots are handed out once per call site, along with the object type.
+ */
+static char const *db_stats_names[DB_MAX_CALLSTATS];
+static int db_stats_objtypes[DB_MAX_CALLSTATS];
+static int db_stats_nnames = 0;
+
+/* Slot of the API call NAME, or -1 when all slots are taken */
+PRIVATE int
+db_stats_slot(char const *name)
+{
+    int i, slot = -1;
+
+    DB_LOCK_GLOBAL();
+    for (i = 0; i < db_stats_nnames && slot < 0; i++)
+        if (db_stats_names[i] == name || !strcmp(db_stats_names[i], name))
+            slot = i;
+    if (slot < 0 && db_stats_nnames < DB_MAX_CALLSTATS)
     {
-        db_perror(0, E_NOMEM, "db_IncObjectComponentCount");
-        return 0;
+        slot = db_stats_nnames++;
+        db_stats_names[slot] = name;
+        db_stats_objtypes[slot] = db_stats_objtype(name);
     }
-    new_pdb_names = REALLOC_N(obj->pdb_names, char *, new_maxcomps);
-    if (!new_pdb_names)
+    DB_UNLOCK_GLOBAL();
+    return slot;
+}
+
+/* Add NCALLS calls taking TIME seconds to SLOT */
+PRIVATE void
+db_stats_add_call(DBfilestats *s, int slot, long long ncalls, double time)
+{
+    if (slot < 0)
+        return;
+    if (!s->calls[slot].name)
     {
-        FREE(new_comp_names);
-        db_perror(0, E_NOMEM, "db_IncObjectComponentCount");
-        return 0;
+        s->calls[slot].name = db_stats_names[slot];
+        s->calls[slot].objtype = db_stats_objtypes[slot];
     }
+    s->calls[slot].ncalls += ncalls;
+    s->calls[slot].time += time;
+    if (slot >= s->ncalls)
+        s->ncalls = slot + 1;
+}
 
-    obj->maxcomponents = new_maxcomps;
-    obj->comp_names = new_comp_names;
-    obj->pdb_names = new_pdb_names;
+/* Add all of the counts in B to A */
+PRIVATE void
+db_stats_add(DBfilestats *a, DBfilestats const *b)
+{
+    int i;
 
-    return 1;
+    a->nreads += b->nreads;
+    a->nwrites += b->nwrites;
+    a->nseeks += b->nseeks;
+    a->nbytes_read += b->nbytes_read;
+    a->nbytes_written += b->nbytes_written;
+    a->nbytes_meta_read += b->nbytes_meta_read;
+    a->nbytes_meta_written += b->nbytes_meta_written;
+    a->ncache_hits += b->ncache_hits;
+    a->ncache_misses += b->ncache_misses;
+    a->compress_time += b->compress_time;
+    for (i = 0; i < b->ncalls; i++)
+        if (b->calls[i].ncalls)
+            db_stats_add_call(a, i, b->calls[i].ncalls, b->calls[i].time);
+}
+
+/* Copy SRC to DST, packing the calls made into the front of calls[] */
+PRIVATE void
+db_stats_copy(DBfilestats *dst, DBfilestats const *src)
+{
+    int i, n;
+
+    *dst = *src;
+    memset(dst->calls, 0, sizeof(dst->calls));
+    for (i = n = 0; i < src->ncalls; i++)
+        if (src->calls[i].ncalls)
+            dst->calls[n++] = src->calls[i];
+    dst->ncalls = n;
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                                 DBMakeObject
- *
- *  Purpose
- *
- *      Allocate an object of the requested length and initialize it.
- *
- *  Programmer
+ * Routine:  db_stats_begin, db_stats_end
  *
- *      Jeffery W. Long, NSSD-B
- *
- *  Modified
- *    Robb Matzke, Tue Nov 8 11:41:23 PST 1994
- *    Added error mechanism
- *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ * Purpose:  Bracket the outermost API call on a thread while statistics
+ *           are on. The call's file, if any, becomes the one the drivers
+ *           count I/O into, and the call is timed into it. SLOT caches
+ *           the call site's slot, see db_stats_slot.
  *--------------------------------------------------------------------*/
-PUBLIC DBobject *
-DBMakeObject(const char *name, int type, int maxcomps)
+INTERNAL double
+db_stats_begin(DBfile *dbfile, int *slot, char const *name)
 {
-    DBobject      *object = NULL;
+    if (*slot < 0)
+        *slot = db_stats_slot(name);
+    db_stats_cur = dbfile ? dbfile->pub.stats : 0;
+    db_stats_meta = 0;
+    return db_WallTime();
+}
 
-    API_BEGIN("DBMakeObject", DBobject *, NULL) {
+INTERNAL void
+db_stats_end(int slot, double t0)
+{
+    double t = db_WallTime() - t0;
 
-        if (!name || !*name)
-            API_ERROR("object name", E_BADARGS);
-        if (db_VariableNameValid(name) == 0)
-            API_ERROR("object name", E_INVALIDNAME);
-        if (NULL == (object = ALLOC(DBobject)))
-            API_ERROR(NULL, E_NOMEM);
+    if (db_stats_cur)
+        db_stats_add_call(db_stats_cur, slot, 1, t);
+    else
+    {
+        DB_LOCK_GLOBAL();
+        db_stats_add_call(&db_global_stats, slot, 1, t);
+        DB_UNLOCK_GLOBAL();
+    }
+    db_stats_cur = 0;
+    db_stats_meta = 0;
+}
 
-        if (maxcomps <= 0) maxcomps = 30;
-        object->name = STRDUP(name);
-        object->type = STRDUP(DBGetObjtypeName(type));
-        object->comp_names = ALLOC_N(char *, maxcomps);
-        object->pdb_names = ALLOC_N(char *, maxcomps);
+/*----------------------------------------------------------------------
+ * Routine:  db_StatRead, db_StatWrite, db_StatSeek, db_StatCache,
+ *           db_StatCompress
+ *
+ * Purpose:  Count I/O done by a driver into the current file's stats,
+ *           or into the global totals when there is no current file.
+ *           META says whether the bytes are metadata; most callers pass
+ *           DB_STATS_META. Nothing is counted unless DB_STATS_ON.
+ *--------------------------------------------------------------------*/
+#define DB_STAT_UPDATE(S)                                                     \
+    if (!db_stats_on) return;                                                 \
+    if (db_stats_cur) {DBfilestats *s = db_stats_cur; S;}                     \
+    else {DBfilestats *s = &db_global_stats;                                  \
+          DB_LOCK_GLOBAL(); S; DB_UNLOCK_GLOBAL();}
 
-        if (!object->name || !object->type ||
-            !object->comp_names || !object->pdb_names)
-        {
-            FREE(object->name);
-            FREE(object->type);
-            FREE(object->comp_names);
-            FREE(object->pdb_names);
-            API_ERROR(NULL, E_NOMEM);
-        }
+INTERNAL void
+db_StatRead(int meta, long long nbytes)
+{
+    DB_STAT_UPDATE(s->nreads++; s->nbytes_read += nbytes;
+                   if (meta) s->nbytes_meta_read += nbytes)
+}
 
-        object->ncomponents = 0;
-        object->maxcomponents = maxcomps;
+INTERNAL void
+db_StatWrite(int meta, long long nbytes)
+{
+    DB_STAT_UPDATE(s->nwrites++; s->nbytes_written += nbytes;
+                   if (meta) s->nbytes_meta_written += nbytes)
+}
 
-        API_RETURN(object);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+INTERNAL void
+db_StatSeek(void)
+{
+    DB_STAT_UPDATE(s->nseeks++)
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBFreeObject
- *
- *  Purpose
- *
- *      Release the storage associated with the given object list.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
+INTERNAL void
+db_StatCache(int hit)
+{
+    DB_STAT_UPDATE(if (hit) s->ncache_hits++; else s->ncache_misses++)
+}
+
+INTERNAL void
+db_StatCompress(double seconds)
+{
+    DB_STAT_UPDATE(s->compress_time += seconds)
+}
+
+/*
+ * Make stats for a file being opened or created. While statistics are on,
+ * count into them while the driver opens it, and time the call from here.
+ */
+PRIVATE DBfilestats *
+db_stats_open(int *slot, char const *name, double *t0)
+{
+    DBfilestats *stats = ALLOC(DBfilestats);
+    if (stats && DB_STATS_ON)
+    {
+        *t0 = db_stats_begin(0, slot, name);
+        db_stats_cur = stats;
+    }
+    return stats;
+}
+
+/* Fold a file's stats into the global totals and free them */
+PRIVATE void
+db_stats_close(DBfilestats *stats)
+{
+    if (db_stats_cur == stats)
+        db_stats_cur = 0;
+    if (!stats)
+        return;
+    DB_LOCK_GLOBAL();
+    db_stats_add(&db_global_stats, stats);
+    DB_UNLOCK_GLOBAL();
+    FREE(stats);
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBSetFileStats
  *
- *  Modified
- *    Robb Matzke, Thu Nov 10 17:28:39 EST 1994
- *    Added error mechanism.
+ * Purpose:  Turn the counting reported by DBGetFileStats and
+ *           DBGetGlobalFileStats on or off. It is off by default, which
+ *           costs each API call one test of a flag. Returns the old
+ *           setting.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBSetFileStats(int enable)
+{
+    int old;
+
+    DB_LOCK_GLOBAL();
+    old = (db_stats_on & DB_STATS_BY_USER) != 0;
+    if (enable)
+        db_stats_on |= DB_STATS_BY_USER;
+    else
+        db_stats_on &= ~DB_STATS_BY_USER;
+    DB_UNLOCK_GLOBAL();
+    return old;
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBGetFileStats
  *
- *    Robb Matzke, Fri Dec 2 13:14:18 PST 1994
- *    Removed all references to SCORE memory management.
+ * Purpose:  Return the I/O counts and timings of a file since it was
+ *           opened or created, made while DBSetFileStats was on.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBGetFileStats(DBfile *dbfile, DBfilestats *stats)
+{
+    API_BEGIN2("DBGetFileStats", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!stats)
+            API_ERROR("stats", E_BADARGS);
+        if (dbfile->pub.stats)
+            db_stats_copy(stats, dbfile->pub.stats);
+        else
+            memset(stats, 0, sizeof(*stats));
+        API_RETURN(0);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBGetGlobalFileStats
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ * Purpose:  Return the I/O counts and timings of all files, open and
+ *           closed, since the library was loaded. Counts for files
+ *           other threads are using at the time may be slightly stale.
  *--------------------------------------------------------------------*/
 PUBLIC int
-DBFreeObject(DBobject *object)
+DBGetGlobalFileStats(DBfilestats *stats)
 {
-    int            i;
+    reg_status_t *r;
+    DBfilestats sum;
+
+    API_BEGIN("DBGetGlobalFileStats", int, -1) {
+        if (!stats)
+            API_ERROR("stats", E_BADARGS);
+        DB_REG_RDLOCK();
+        DB_LOCK_GLOBAL();
+        sum = db_global_stats;
+        for (r = _db_reglist; r; r = r->next)
+        {
+            if (r->f->pub.stats)
+                db_stats_add(&sum, r->f->pub.stats);
+        }
+        DB_UNLOCK_GLOBAL();
+        DB_REG_UNLOCK();
+        db_stats_copy(stats, &sum);
+        API_RETURN(0);
+    }
+    API_END_NOPOP;
+}
 
-    API_BEGIN("DBFreeObject", int, -1) {
+/*
+ * API tracing. Each thread records events into its own ring, which only
+ * that thread writes, so recording takes no lock. DBDumpTrace appends the
+ * events not yet in the trace file using nothing but write() and a static
+ * buffer, so that it can be called from a signal handler. See silo.h for
+ * the file format.
+ */
+typedef struct db_trace_ring_t
+{
+    DBtraceevent *ev;
+    unsigned long long volatile head;   /* events recorded */
+    unsigned long long tail;            /* events written to the file */
+    unsigned int thread;
+    struct db_trace_ring_t *next;
+} db_trace_ring_t;
+
+#ifdef __GNUC__
+#define DB_TRACE_FENCE()        __sync_synchronize()
+#define DB_TRACE_TRYLOCK(L)     (__sync_lock_test_and_set(&(L), 1) == 0)
+#define DB_TRACE_UNLOCK(L)      __sync_lock_release(&(L))
+#else
+#define DB_TRACE_FENCE()
+#define DB_TRACE_TRYLOCK(L)     ((L) ? 0 : ((L) = 1))
+#define DB_TRACE_UNLOCK(L)      ((L) = 0)
+#endif
 
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (object->ncomponents < 0) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
+#define DB_TRACE_MAX_NAMES      1024
+#define DB_TRACE_CHUNK          256
+
+int db_trace_on = 0;
+static int db_trace_fd = -1;
+static unsigned int db_trace_nevents = 0;        /*ring size, fixed once set */
+static unsigned long long db_trace_t0 = 0;
+static db_trace_ring_t * volatile db_trace_rings = 0;
+static unsigned int db_trace_nthreads = 0;
+static char const *db_trace_names[DB_TRACE_MAX_NAMES];
+static unsigned int volatile db_trace_nnames = 0;
+static unsigned int db_trace_names_dumped = 0;
+static int volatile db_trace_dumping = 0;
+static DBtraceevent db_trace_chunk[DB_TRACE_CHUNK];
+static SILO_THREAD_LOCAL db_trace_ring_t *db_trace_ring = 0;
+static SILO_THREAD_LOCAL int db_trace_id = -1;   /*id of the open call */
+static SILO_THREAD_LOCAL long long db_trace_bytes0 = 0;
+static SILO_THREAD_LOCAL short db_trace_driver = -1;
+
+PRIVATE unsigned long long
+db_trace_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (unsigned long long) ts.tv_sec * 1000000000ULL +
+               (unsigned long long) ts.tv_nsec;
+#endif
+    return (unsigned long long) (db_WallTime() * 1e9);
+}
 
-        for (i = 0; i < object->ncomponents; i++) {
-            FREE(object->comp_names[i]);
-            FREE(object->pdb_names[i]);
-        }
-        for (i = 0; i < DB_MAX_H5_OBJ_VALS; i++) {
-            FREE(object->h5_names[i]);
-        }
+/* Id of an API call name; ids are handed out once per call site */
+PRIVATE int
+db_trace_name(char const *name)
+{
+    unsigned int i;
+    int id = -1;
+
+    DB_LOCK_GLOBAL();
+    for (i = 0; i < db_trace_nnames && id < 0; i++)
+        if (db_trace_names[i] == name || !strcmp(db_trace_names[i], name))
+            id = (int) i;
+    if (id < 0 && db_trace_nnames < DB_TRACE_MAX_NAMES)
+    {
+        id = (int) db_trace_nnames;
+        db_trace_names[id] = name;
+        DB_TRACE_FENCE();
+        db_trace_nnames++;
+    }
+    DB_UNLOCK_GLOBAL();
+    return id;
+}
 
-        FREE(object->comp_names);
-        FREE(object->pdb_names);
-        FREE(object->name);
-        FREE(object->type);
-        FREE(object);
+/* The calling thread's ring, created on its first event */
+PRIVATE db_trace_ring_t *
+db_trace_get_ring(void)
+{
+    db_trace_ring_t *r;
+
+    if (db_trace_ring)
+        return db_trace_ring;
+    if ((r = (db_trace_ring_t *) calloc(1, sizeof(db_trace_ring_t))) == 0)
+        return 0;
+    if ((r->ev = (DBtraceevent *) calloc(db_trace_nevents, sizeof(DBtraceevent))) == 0)
+    {
+        free(r);
+        return 0;
     }
-    API_END;
+    DB_LOCK_GLOBAL();
+    r->thread = db_trace_nthreads++;
+    r->next = db_trace_rings;
+    DB_TRACE_FENCE();
+    db_trace_rings = r;
+    DB_UNLOCK_GLOBAL();
+    db_trace_ring = r;
+    return r;
+}
 
-    return(0);  /* Always succeeds by the time we get here */
+PRIVATE void
+db_trace_record(int kind, int id, unsigned int objhash, long long nbytes)
+{
+    db_trace_ring_t *r = db_trace_get_ring();
+    DBtraceevent *e;
+
+    if (!r) return;
+    e = &r->ev[r->head % db_trace_nevents];
+    e->time = db_trace_now() - db_trace_t0;
+    e->nbytes = nbytes;
+    e->name = (unsigned int) id;
+    e->objhash = objhash;
+    e->kind = (unsigned short) kind;
+    e->driver = db_trace_driver;
+    e->thread = r->thread;
+    DB_TRACE_FENCE();
+    r->head++;
+}
+
+PRIVATE long long
+db_trace_bytes(DBfilestats const *stats)
+{
+    return stats ? stats->nbytes_read + stats->nbytes_written : 0;
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                                DBClearObject
- *
- *  Purpose
- *
- *      Remove all components from the given object and reset counters.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
- *
- *  Modified
- *    Robb Matzke, Tue Nov 8 07:46:29 PST 1994
- *    Added error mechanism
+ * Routine:  db_trace_enter, db_trace_exit
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ * Purpose:  Record the entry and exit of the outermost API call. ID
+ *           caches the id of NAME for the call site. The exit event
+ *           carries the bytes the call moved through DBFILE's driver.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBClearObject(DBobject *object)
+INTERNAL void
+db_trace_enter(int *id, char const *name, DBfile *dbfile, char const *objname)
 {
-    int            i;
+    unsigned int h = 0;
 
-    API_BEGIN("DBClearObject", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (object->ncomponents < 0) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
+    if (DBDebugAPI > 0)
+    {
+        write(DBDebugAPI, name, strlen(name));
+        write(DBDebugAPI, "\n", 1);
+    }
+    if (!db_trace_on || DB_JSTK)
+        return;
+    db_trace_id = -1;
+    if (*id < 0)
+        *id = db_trace_name(name);
+    if (*id < 0)
+        return;
 
-        /* Reset values, but do not free */
-        for (i = 0; i < object->maxcomponents; i++) {
-            object->comp_names[i] = NULL;
-            object->pdb_names[i] = NULL;
-        }
+    /* FNV-1a */
+    if (objname)
+        for (h = 2166136261U; *objname; objname++)
+            h = (h ^ (unsigned char) *objname) * 16777619U;
+    db_trace_id = *id;
+    db_trace_driver = dbfile ? (short) dbfile->pub.type : -1;
+    db_trace_bytes0 = dbfile ? db_trace_bytes(dbfile->pub.stats) : 0;
+    db_trace_record(DB_TRACE_ENTER, *id, h, 0);
+}
 
-        object->name = NULL;
-        object->type = NULL;
-        object->ncomponents = 0;
+INTERNAL void
+db_trace_exit(void)
+{
+    if (db_trace_id < 0)
+        return;
+    db_trace_record(DB_TRACE_EXIT, db_trace_id, 0,
+        db_stats_cur ? db_trace_bytes(db_stats_cur) - db_trace_bytes0 : 0);
+    db_trace_id = -1;
+}
+
+PRIVATE int
+db_trace_write(void const *buf, size_t n)
+{
+    char const *p = (char const *) buf;
+    while (n > 0)
+    {
+        ssize_t m = write(db_trace_fd, p, n);
+        if (m < 0 && errno == EINTR) continue;
+        if (m <= 0) return -1;
+        p += m;
+        n -= (size_t) m;
     }
-    API_END;
+    return 0;
+}
 
-    return(0);
+PRIVATE int
+db_trace_block(unsigned int tag, unsigned int a, unsigned int b, unsigned int c)
+{
+    unsigned int hdr[4];
+    hdr[0] = tag; hdr[1] = a; hdr[2] = b; hdr[3] = c;
+    return db_trace_write(hdr, sizeof(hdr));
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                            DBAddVarComponent
- *
- *  Purpose
- *
- *      Add a variable component to the given object structure.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
- *
- *  Modified
- *    Robb Matzke, Tue Nov 8 07:43:38 PST 1994
- *    Added error mechanism
- *
- *    Robb Matzke, Fri Dec 2 13:14:46 PST 1994
- *    Removed all references to SCORE memory management.
+ * Routine:  DBDumpTrace
  *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ * Purpose:  Append the events recorded since the last dump to the trace
+ *           file. This only calls write(), so it may be called from a
+ *           signal handler. Events a thread records while they are being
+ *           copied out are counted as dropped.
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.  Correct spelling.
+ * Return:   0 on success, -1 if tracing is off or a dump is in progress.
  *--------------------------------------------------------------------*/
 PUBLIC int
-DBAddVarComponent(DBobject *object, const char *compname, const char *pdbname)
+DBDumpTrace(void)
 {
-    API_BEGIN("DBAddVarComponent", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (db_VariableNameValid(compname) == 0)
-            API_ERROR("component name", E_INVALIDNAME);
-        if (!pdbname || !*pdbname)
-            API_ERROR("pdb name", E_BADARGS);
-        if (object->ncomponents >= object->maxcomponents) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
+    db_trace_ring_t *r;
+    unsigned int i, n, nbytes;
+    int err = 0;
 
-        if (NULL == (object->comp_names[object->ncomponents] =
-                     STRDUP(compname)) ||
-            NULL == (object->pdb_names[object->ncomponents] =
-                     STRDUP(pdbname))) {
-            FREE(object->comp_names[object->ncomponents]);
-            API_ERROR(NULL, E_NOMEM);
-        }
+    if (db_trace_fd < 0 || !DB_TRACE_TRYLOCK(db_trace_dumping))
+        return -1;
 
-        if (!db_IncObjectComponentCount(object))
-            API_ERROR(NULL, E_NOMEM);
+    /* Names first, so that every event's name is known when it is read */
+    n = db_trace_nnames;
+    DB_TRACE_FENCE();
+    if (n > db_trace_names_dumped)
+    {
+        for (i = db_trace_names_dumped, nbytes = 0; i < n; i++)
+            nbytes += (unsigned int) strlen(db_trace_names[i]) + 1;
+        err |= db_trace_block(DB_TRACE_BLOCK_NAMES, db_trace_names_dumped,
+                              n - db_trace_names_dumped, nbytes);
+        for (i = db_trace_names_dumped; i < n; i++)
+            err |= db_trace_write(db_trace_names[i], strlen(db_trace_names[i]) + 1);
+        db_trace_names_dumped = n;
+    }
+
+    for (r = db_trace_rings; r; r = r->next)
+    {
+        unsigned long long head = r->head, tail = r->tail, dropped = 0, k;
+
+        DB_TRACE_FENCE();
+        if (head == tail)
+            continue;
+        /* The oldest slot of a full ring may be half overwritten by an
+           event the dump interrupted */
+        if (head - tail >= db_trace_nevents)
+        {
+            dropped = head - tail - db_trace_nevents + 1;
+            tail = head - db_trace_nevents + 1;
+        }
 
+        /* Copy a chunk at a time and keep it only if the thread did not
+           wrap around onto it meanwhile */
+        for (k = tail; k < head; k += n)
+        {
+            n = (unsigned int) (head - k < DB_TRACE_CHUNK ? head - k : DB_TRACE_CHUNK);
+            for (i = 0; i < n; i++)
+                db_trace_chunk[i] = r->ev[(k + i) % db_trace_nevents];
+            DB_TRACE_FENCE();
+            if (r->head - k >= db_trace_nevents)
+            {
+                dropped += n;
+                continue;
+            }
+            err |= db_trace_block(DB_TRACE_BLOCK_EVENTS, r->thread, n,
+                                  (unsigned int) dropped);
+            err |= db_trace_write(db_trace_chunk, n * sizeof(DBtraceevent));
+            dropped = 0;
+        }
+        if (dropped)
+            err |= db_trace_block(DB_TRACE_BLOCK_EVENTS, r->thread, 0,
+                                  (unsigned int) dropped);
+        r->tail = head;
     }
-    API_END;
 
-    return(0);
+    DB_TRACE_UNLOCK(db_trace_dumping);
+    return err ? -1 : 0;
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                            DBAddIntComponent
- *
- *  Purpose
- *
- *      Add an integer literal component to the given object structure.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
- *
- *  Modifications
- *    Robb Matzke, Tue Nov 8 07:06:11 PST 1994
- *    Added error mechanism. Returns 0 on success, -1 on failure.
- *
- *    Robb Matzke, Fri Dec 2 13:15:06 PST 1994
- *    Removed all references to SCORE memory management.
+ * Routine:  DBSetTrace
  *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ * Purpose:  Start tracing API calls into FILENAME, which is truncated,
+ *           keeping up to NEVENTS events per thread between dumps.
+ *           NEVENTS of zero dumps what remains and stops tracing. The
+ *           ring size is fixed by the first call that starts tracing.
+ *           Traces are dumped at each DBClose, by DBDumpTrace and on the
+ *           signal given to DBSetTraceSignal; tools/silotrace converts
+ *           them to Chrome trace JSON.
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ *           Only the outermost API call of a thread is traced.
  *--------------------------------------------------------------------*/
 PUBLIC int
-DBAddIntComponent(DBobject *object, const char *compname, int ii)
+DBSetTrace(int nevents, char const *filename)
 {
-    return DBAddIntNComponent(object, compname, 1, &ii);
-}
+    db_trace_ring_t *r;
+    unsigned int hdr[3];
 
-PUBLIC int
-DBAddIntNComponent(DBobject *object, const char *compname, int n, int const *ii)
-{
-    int            i;
-    char           tmp[256];
+    API_BEGIN("DBSetTrace", int, -1) {
+        if (nevents < 0)
+            API_ERROR("nevents", E_BADARGS);
+        if (nevents > 0 && !filename)
+            API_ERROR("filename", E_BADARGS);
 
-    API_BEGIN("DBAddIntComponent", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (db_VariableNameValid(compname) == 0)
-            API_ERROR("component name", E_INVALIDNAME);
-        if (n < 1)
-            API_ERROR("n", E_BADARGS);
-        if (!ii)
-            API_ERROR("ii array", E_BADARGS);
-        if (object->ncomponents >= object->maxcomponents)
-            API_ERROR("object ncomponents", E_BADARGS);
-
-        sprintf(tmp, "'<i>%d", ii[0]);
-        for (i = 1; i < n; i++)
+        /* Finish the current trace, this call included */
+        if (db_trace_on)
+            db_trace_exit();
+        db_trace_on = 0;
+        db_stats_on &= ~DB_STATS_BY_TRACE;
+        if (db_trace_fd >= 0)
         {
-            char tmp2[32];
-            snprintf(tmp2, sizeof(tmp2), ",%d", ii[i]);
-            strcat(tmp, tmp2);
+            DBDumpTrace();
+            close(db_trace_fd);
+            db_trace_fd = -1;
         }
-        strcat(tmp, "'");
+        if (nevents == 0)
+            API_RETURN(0);
 
-        if (NULL == (object->comp_names[object->ncomponents] =
-                     STRDUP(compname)) ||
-            NULL == (object->pdb_names[object->ncomponents] =
-                     STRDUP(tmp))) {
-            FREE(object->comp_names[object->ncomponents]);
-            API_ERROR(NULL, E_NOMEM);
+        if ((db_trace_fd = open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0)
+            API_ERROR(filename, E_NOFILE);
+        hdr[0] = (unsigned int) sizeof(DBtraceevent);
+        hdr[1] = (unsigned int) getpid();
+        hdr[2] = 0;
+        if (db_trace_write("SILOTRC1", 8) < 0 || db_trace_write(hdr, sizeof(hdr)) < 0)
+        {
+            close(db_trace_fd);
+            db_trace_fd = -1;
+            API_ERROR(filename, E_CALLFAIL);
         }
 
-        if (!db_IncObjectComponentCount(object))
-            API_ERROR(NULL, E_NOMEM);
-
+        /* Events left from an earlier trace are not wanted in this one */
+        if (db_trace_nevents == 0)
+            db_trace_nevents = (unsigned int) nevents;
+        for (r = db_trace_rings; r; r = r->next)
+            r->tail = r->head;
+        db_trace_names_dumped = 0;
+        db_trace_t0 = db_trace_now();
+        db_stats_on |= DB_STATS_BY_TRACE;
+        db_trace_on = 1;
+        API_RETURN(0);
     }
-    API_END;
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
 
-    return(0);
+SILO_CALLBACK void
+db_trace_signal_handler(int signo)
+{
+    DBDumpTrace();
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                            DBAddFltComponent
- *
- *  Purpose
- *
- *      Add a floating point literal component to the given object
- *      structure.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
+ * Routine:  DBSetTraceSignal
  *
- *      Returns OKAY on success, OOPS on failure.
- *
- *  Modified:
- *    Robb Matzke, Tue Nov 8 07:04:15 PST 1994
- *    Added error mechanism.  Return -1 on failure, 0 on success.
- *
- *    Robb Matzke, Fri Dec 2 13:15:28 PST 1994
- *    Removed all references to SCORE memory management.
- *
- *    Eric Brugger, Tue Feb  7 09:06:58 PST 1995
- *    I modified the argument declarations to reflect argument promotions.
- *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ * Purpose:  Dump the trace whenever the process receives SIGNO.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBSetTraceSignal(int signo)
+{
+    API_BEGIN("DBSetTraceSignal", int, -1) {
+        if (signal(signo, db_trace_signal_handler) == SIG_ERR)
+            API_ERROR("signo", E_BADARGS);
+        API_RETURN(0);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/* Set once any alloc hook has ever been installed */
+static int db_bulk_hooks_used = 0;
+
+/*----------------------------------------------------------------------
+ * Routine:  DBSetAllocator
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ * Purpose:  Install alloc/free hooks used for the problem-sized arrays
+ *           of objects returned by DBGetXxx() methods. Passing a NULL
+ *           alloc_func restores Silo's default use of malloc/free.
+ *           A NULL free_func means the memory is owned by the caller
+ *           and DBFreeXxx() methods will not release it.
  *--------------------------------------------------------------------*/
 PUBLIC int
-DBAddFltComponent(DBobject *object, const char *compname, double ff)
+DBSetAllocator(DBAllocFunc_t alloc_func, DBFreeFunc_t free_func,
+    void *client_data)
 {
-    return DBAddFltNComponent(object, compname, 1, &ff);
+    SILO_Globals.allocFunc = alloc_func;
+    SILO_Globals.freeFunc = alloc_func ? free_func : 0;
+    SILO_Globals.allocClientData = alloc_func ? client_data : 0;
+    if (alloc_func)
+        db_bulk_hooks_used = 1;
+    return 0;
 }
 
 PUBLIC int
-DBAddFltNComponent(DBobject *object, const char *compname, int n, double const *ff)
+DBSetAllocatorFile(DBfile *f, DBAllocFunc_t alloc_func, DBFreeFunc_t free_func,
+    void *client_data)
 {
-    int            i;
-    char           tmp[256];
+    API_BEGIN("DBSetAllocatorFile", int, -1) {
+        if (!f)
+            API_ERROR("DBfile*", E_BADARGS);
+        f->pub.file_scope_globals->allocFunc = alloc_func;
+        f->pub.file_scope_globals->freeFunc = alloc_func ? free_func : 0;
+        f->pub.file_scope_globals->allocClientData = alloc_func ? client_data : 0;
+        if (alloc_func)
+            db_bulk_hooks_used = 1;
+        API_RETURN(0);
+    }
+    API_END_NOPOP;
+}
 
-    API_BEGIN("DBAddFltComponent", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (n < 1)
-            API_ERROR("n", E_BADARGS);
-        if (!ff)
-            API_ERROR("ff array", E_BADARGS);
-        if (db_VariableNameValid(compname) == 0)
-            API_ERROR("component name", E_INVALIDNAME);
-        if (object->ncomponents >= object->maxcomponents) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
+/*----------------------------------------------------------------------
+ * Bulk allocation registry
+ *
+ * Every buffer handed out by a caller's alloc hook is remembered here,
+ * along with the free hook and client data in effect when it was
+ * allocated, so that DBFreeXxx() can return it to the right owner even
+ * after the hooks are changed or the file is closed. Buffers that are
+ * not in the registry came from malloc. The table is open-addressed
+ * with linear probing and tombstones and is never touched until some
+ * caller installs an alloc hook.
+ *--------------------------------------------------------------------*/
+typedef struct db_bulk_ent_t {
+    void         *ptr;
+    DBFreeFunc_t  free_func;
+    void         *client_data;
+} db_bulk_ent_t;
 
-        sprintf(tmp, "'<f>%g", ff[0]);
-        for (i = 1; i < n; i++)
-        {
-            char tmp2[32];
-            snprintf(tmp2, sizeof(tmp2), ",%g", ff[i]);
-        }
-        strcat(tmp, "'");
+#define DB_BULK_TOMBSTONE ((void *) &db_bulk_tab)
 
-        if (NULL == (object->comp_names[object->ncomponents] =
-                     STRDUP(compname)) ||
-            NULL == (object->pdb_names[object->ncomponents] =
-                     STRDUP(tmp))) {
-            FREE(object->comp_names[object->ncomponents]);
-            API_ERROR(NULL, E_NOMEM);
-        }
-        if (!db_IncObjectComponentCount(object))
-            API_ERROR(NULL, E_NOMEM);
+static db_bulk_ent_t *db_bulk_tab = 0;
+static size_t db_bulk_cap = 0;   /* power of 2 */
+static size_t db_bulk_used = 0;  /* live entries plus tombstones */
+
+static size_t
+db_bulk_slot(void const *p)
+{
+    size_t h = (size_t) p;
+    h ^= h >> 17;
+    h *= (size_t) 0x9E3779B97F4A7C15ULL;
+    return (h ^ (h >> 29)) & (db_bulk_cap - 1);
+}
+
+static int
+db_bulk_grow(void)
+{
+    db_bulk_ent_t *old = db_bulk_tab;
+    size_t i, oldcap = db_bulk_cap;
+    size_t newcap = oldcap ? 2 * oldcap : 64;
+    db_bulk_ent_t *tab = ALLOC_N(db_bulk_ent_t, newcap);
+
+    if (!tab)
+        return -1;
+    db_bulk_tab = tab;
+    db_bulk_cap = newcap;
+    db_bulk_used = 0;
+    for (i = 0; i < oldcap; i++)
+    {
+        size_t j;
+        if (!old[i].ptr || old[i].ptr == DB_BULK_TOMBSTONE)
+            continue;
+        for (j = db_bulk_slot(old[i].ptr); tab[j].ptr; j = (j + 1) & (newcap - 1))
+            ;
+        tab[j] = old[i];
+        db_bulk_used++;
     }
-    API_END;
+    FREE(old);
+    return 0;
+}
 
-    return(0);
+static int
+db_bulk_insert(void *p, DBFreeFunc_t free_func, void *client_data)
+{
+    size_t j;
+
+    if (2 * (db_bulk_used + 1) > db_bulk_cap && db_bulk_grow() < 0)
+        return -1;
+    for (j = db_bulk_slot(p); db_bulk_tab[j].ptr &&
+         db_bulk_tab[j].ptr != DB_BULK_TOMBSTONE; j = (j + 1) & (db_bulk_cap - 1))
+        ;
+    if (!db_bulk_tab[j].ptr)
+        db_bulk_used++;
+    db_bulk_tab[j].ptr = p;
+    db_bulk_tab[j].free_func = free_func;
+    db_bulk_tab[j].client_data = client_data;
+    return 0;
+}
+
+static db_bulk_ent_t *
+db_bulk_find(void const *p)
+{
+    size_t j;
+
+    if (!db_bulk_cap)
+        return 0;
+    for (j = db_bulk_slot(p); db_bulk_tab[j].ptr; j = (j + 1) & (db_bulk_cap - 1))
+        if (db_bulk_tab[j].ptr == p)
+            return &db_bulk_tab[j];
+    return 0;
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                            DBAddDblComponent
- *
- *  Purpose
- *
- *      Add a double precision floating point literal component to 
- *      the given object structure.
- *
- *  Programmer
+ * Routine:  db_alloc_bulk
  *
- *      Brad Whitlock, Thu Jan 20 09:43:13 PDT 2000
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
- *
- *  Modified:
+ * Purpose:  Allocate a problem-sized array that will be returned to
+ *           the caller as part of a DBGetXxx() object. Uses the file's
+ *           alloc hook if one was set with DBSetAllocatorFile(), else
+ *           the library-wide hook, else malloc. Memory obtained here
+ *           must be released with db_free_bulk() (or FREE_BULK).
+ *--------------------------------------------------------------------*/
+INTERNAL void *
+db_alloc_bulk(DBfile *dbfile, size_t nbytes)
+{
+    DBAllocFunc_t alloc_func = SILO_Globals.allocFunc;
+    DBFreeFunc_t free_func = SILO_Globals.freeFunc;
+    void *client_data = SILO_Globals.allocClientData;
+    void *p;
+    int status;
+
+    if (!db_bulk_hooks_used && !alloc_func)
+        return malloc(nbytes);
+
+    if (dbfile && dbfile->pub.file_scope_globals &&
+        dbfile->pub.file_scope_globals->allocFunc != (DBAllocFunc_t) DB_VOID_PTR_NOT_SET)
+    {
+        alloc_func = dbfile->pub.file_scope_globals->allocFunc;
+        free_func = dbfile->pub.file_scope_globals->freeFunc;
+        client_data = dbfile->pub.file_scope_globals->allocClientData;
+    }
+
+    if (!alloc_func)
+        return malloc(nbytes);
+
+    if (NULL == (p = alloc_func(nbytes, client_data)))
+        return 0;
+    db_bulk_hooks_used = 1;
+    DB_LOCK_GLOBAL();
+    status = db_bulk_insert(p, free_func, client_data);
+    DB_UNLOCK_GLOBAL();
+    if (status < 0)
+    {
+        if (free_func)
+            free_func(p, client_data);
+        return 0;
+    }
+    return p;
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  db_free_bulk
  *
+ * Purpose:  Release memory obtained from db_alloc_bulk(). Memory that
+ *           came from a caller's alloc hook goes back through the
+ *           matching free hook; if that hook is NULL the caller owns
+ *           the memory and it is left alone.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBAddDblComponent(DBobject *object, const char *compname, double dd)
+INTERNAL void
+db_free_bulk(void *p)
 {
-    return DBAddDblNComponent(object, compname, 1, &dd);
+    db_bulk_ent_t *ent, e;
+
+    if (!p)
+        return;
+    if (!db_bulk_hooks_used)
+    {
+        free(p);
+        return;
+    }
+    DB_LOCK_GLOBAL();
+    if (NULL != (ent = db_bulk_find(p)))
+    {
+        e = *ent;
+        ent->ptr = DB_BULK_TOMBSTONE;
+    }
+    DB_UNLOCK_GLOBAL();
+    if (!ent)
+        free(p);
+    else if (e.free_func)
+        e.free_func(p, e.client_data);
 }
 
 PUBLIC int
-DBAddDblNComponent(DBobject *object, const char *compname, int n, double const *dd)
+DBFreeCompressionResources(DBfile *dbfile, const char *meshname)
 {
-    int            i;
-    char           tmp[256];
+    int retval = 0;
 
-    API_BEGIN("DBAddDblComponent", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (n < 1)
-            API_ERROR("n", E_BADARGS);
-        if (!dd)
-            API_ERROR("dd array", E_BADARGS);
-        if (db_VariableNameValid(compname) == 0)
-            API_ERROR("component name", E_INVALIDNAME);
-        if (object->ncomponents >= object->maxcomponents) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
+    API_BEGIN2("DBFreeCompressionResources", int, -1, api_dummy) {
 
-        sprintf(tmp, "'<d>%.30g", dd[0]);
-        for (i = 1; i < n; i++)
-        {
-            char tmp2[64];
-            snprintf(tmp2, sizeof(tmp2), ",%.30g", dd[i]);
-        }
-        strcat(tmp, "'");
+        if (!dbfile->pub.free_z)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+        retval = ((dbfile->pub.free_z) (dbfile, meshname));
 
-        if (NULL == (object->comp_names[object->ncomponents] =
-                     STRDUP(compname)) ||
-            NULL == (object->pdb_names[object->ncomponents] =
-                     STRDUP(tmp))) {
-            FREE(object->comp_names[object->ncomponents]);
-            API_ERROR(NULL, E_NOMEM);
-        }
-        if (!db_IncObjectComponentCount(object))
-            API_ERROR(NULL, E_NOMEM);
+        API_RETURN(retval);
     }
-    API_END;
-
-    return(0);
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
+#define CHECK_FOR_FRIENDLY(ON,SU)					\
+    ntotal += toc->n ## ON;						\
+    for (i = 0; i < toc->n ## ON; i++)					\
+    {									\
+        char tmp[1024];							\
+        snprintf(tmp, sizeof(tmp), "%s_%s", toc->ON ## _names[i], SU);	\
+        if (DBInqVarExists(f, tmp))					\
+            nfriendly++;						\
+    }
+
 /*----------------------------------------------------------------------
- *  Routine                                            DBAddStrComponent
- *
- *  Purpose
- *
- *      Add a string literal component to the given object structure.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
+ * Routine:  db_guess_has_friendly_HDF5_names_r 
  *
- *  Returns
+ * Purpose:  Recursive helper func for DBGuessHasFriendlyHDF5Names 
+ *           names.
  *
- *      Returns OKAY on success, OOPS on failure.
+ * Programmer: Mark C. Miller, Wed Sep  2 15:27:06 PDT 2009
  *
- *  Modified
- *    Robb Matzke, Tue Nov 8 07:08:33 PST 1994
- *    Added error mechanism.  Return 0 on success, -1 on failure.
- *
- *    Robb Matzke, Fri Dec 2 13:15:49 PST 1994
- *    Removed all references to SCORE memory management.
- *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
- *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
- *
- *    Mark C. Miller, Thu Apr  2 09:48:57 PDT 2015
- *    Added Al Nichols' enhancement for arb. length str components.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBAddStrComponent(DBobject *object, const char *compname, const char *ss)
+PRIVATE int
+db_guess_has_friendly_HDF5_names_r(DBfile *f)
 {
-    char *tmp = 0;
-
-    API_BEGIN("DBAddStrComponent", int, -1) {
-        if (!object)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (db_VariableNameValid(compname) == 0)
-            API_ERROR("component name", E_INVALIDNAME);
-        if (object->ncomponents >= object->maxcomponents) {
-            API_ERROR("object ncomponents", E_BADARGS);
-        }
-        if (!ss)
-        {
-            if (!DBGetAllowEmptyObjects())
-                API_ERROR("string literal component", E_BADARGS);
-            tmp = malloc(10);
-            sprintf(tmp, "'<s>null'");
-        }
-        else
-        {
-            tmp = malloc(strlen(ss)+6);
-            sprintf(tmp, "'<s>%s'", ss);
-        }
+    int i, ntotal = 0, nfriendly = 0;
+    int retval;
+    DBtoc *toc;
 
-        if (NULL == (object->comp_names[object->ncomponents] =
-                     STRDUP(compname)) ||
-            NULL == (object->pdb_names[object->ncomponents] =
-                     STRDUP(tmp))) {
-            FREE(tmp);
-            FREE(object->comp_names[object->ncomponents]);
-            API_ERROR(NULL, E_NOMEM);
-        }
-        if (!db_IncObjectComponentCount(object))
-        {
-            FREE(tmp);
-            API_ERROR(NULL, E_NOMEM);
-        }
-        FREE(tmp);
-    }
-    API_END;
+    toc = DBGetToc(f);
 
-    return(0);
-}
+    if (!toc) return 0;
 
-/*-------------------------------------------------------------------------
- * Function:    DBShowErrors
- *
- * Purpose:     Set the method by which errors are displayed.  The
- *              `level' parameter is one of the following:
- *
- *                 DB_ALL       -- Show all errors, beginning with the
- *                                 routine that first detected the error
- *                                 and continuing up the call stack to
- *                                 the application.
- *
- *                 DB_ABORT     -- Same as DB_ALL except abort() is called
- *                                 after the error message is printed.
- *
- *                 DB_TOP       -- (default) Only the top-level API functions
- *                                 issue error messages.
- *
- *                 DB_NONE      -- The library does not handle error messages.
- *                                 The application is responsible for
- *                                 checking the API return values and
- *                                 handling the error.
- *
- *                 DB_SUSPEND   -- This is used internally to temporarily
- *                                 suspend the issuance of error messages
- *                                 by changing the error level to DB_NONE.
- *
- *                 DB_RESTORE   -- This is used internally to restore the
- *                                 previous error level after a DB_SUSPEND.
- *
- *              The `func' parameter can point to an application-level
- *              error handling function that will be passed a string that
- *              is part of the error message (similar to the argument for
- *              perror()).  If the function pointer is null, then
- *              the library will issue error messages to the standard
- *              error stream.
- *
- *              The error text and erring function name can
- *              be obtained by calling DBErrString() or DBErrFunc().
- *
- * Return:      void
- *
- * Programmer:  matzke@viper
- *              Mon Nov  7 09:58:43 PST 1994
- *
- * Modifications:
- *    Robb Matzke, Mon Dec 12 14:25:04 EST 1994
- *    Added DB_SUSPEND and DB_RESUME in order to get
- *    db_unk_Open to work properly [the Open callback for
- *    the SILO-Unknown driver].
- *
- *    Eric Brugger, Tue Feb  7 09:06:58 PST 1995
- *    I modified the function declaration and changed the default error
- *    reporting level to DB_NONE.
- *
- *    Eric Brugger, Wed Mar  1 17:07:39 PST 1995
- *    I shrouded the prototypes for non-ansi compilers.
- * 
- *    Hank Childs, Thu Mar  2 13:34:35 PST 2000
- *    Add check to ensure that nested DBShowErrors to suspend error 
- *    messages would work correctly.
- *
- *-------------------------------------------------------------------------*/
-#warning ADD DBSHOWERRORSFILE
-PUBLIC void
-DBShowErrors(int level, void(*func)(char*))
-{
-    static int     old_level = DB_NONE;
-    static int     old_level_drvr = DB_NONE;
-    static int     nested_suspend = 0;
+    CHECK_FOR_FRIENDLY(multimesh, "meshnames");
+    CHECK_FOR_FRIENDLY(multivar, "varnames");
+    CHECK_FOR_FRIENDLY(multimat, "matnames");
+    CHECK_FOR_FRIENDLY(qmesh, "coord0");
+    CHECK_FOR_FRIENDLY(qvar, "data");
+    CHECK_FOR_FRIENDLY(ucdmesh, "coord0");
+    CHECK_FOR_FRIENDLY(ucdvar, "data");
+    CHECK_FOR_FRIENDLY(ptmesh, "coord0");
+    CHECK_FOR_FRIENDLY(ptvar, "data");
+    CHECK_FOR_FRIENDLY(csgmesh, "_coeffs");
+    CHECK_FOR_FRIENDLY(csgvar, "data");
+    CHECK_FOR_FRIENDLY(mat, "_matlist");
+    CHECK_FOR_FRIENDLY(matspecies, "_speclist");
+    CHECK_FOR_FRIENDLY(curve, "_yvals");
+    CHECK_FOR_FRIENDLY(obj, "_nodelist");
 
-    SILO_Globals._db_err_level_drvr = DB_NONE;
-    if (level == DB_ALL_AND_DRVR)
+    if (ntotal >= 3) /* arb. min of 3 objects */
     {
-        level = DB_ALL;
-	SILO_Globals._db_err_level_drvr = DB_ALL;
+        if (nfriendly >= ntotal/2)
+            return 1;
+        else
+            return 0;
     }
 
-#warning GET RID OF SUSPEND/RESUME STUFF
-    switch (level) {
-        case DB_SUSPEND:
-            if (nested_suspend++ == 0)
-            {
-                old_level = SILO_Globals._db_err_level;
-                old_level_drvr = SILO_Globals._db_err_level_drvr;
-            }
-            SILO_Globals._db_err_level = DB_NONE;
-	    SILO_Globals._db_err_level_drvr = DB_NONE;
-            break;
-        case DB_RESUME:
-            if (--nested_suspend == 0)
-            {
-                SILO_Globals._db_err_level = old_level;
-	        SILO_Globals._db_err_level_drvr = old_level_drvr;
-            }
-            break;
-        default:
-            SILO_Globals._db_err_level = level;
-            SILO_Globals._db_err_func = func;
-            break;
+    retval = -1;
+    for (i = 0; i < toc->ndir && retval == -1; i++)
+    {
+        DBSetDir(f, toc->dir_names[i]);
+        retval = db_guess_has_friendly_HDF5_names_r(f);
+        DBSetDir(f, "..");
     }
+
+    return retval;
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBErrString
- *
- * Purpose:     Return the error message of the last error.
- *
- * Return:      Success:        ptr to static error message
+/*----------------------------------------------------------------------
+ * Routine:  DBGuessHasFriendlyHDF5Names
  *
- *              Failure:        ptr to static message for db_errno=0
+ * Purpose:  Determine if it looks like a given file has HDF5 friendly 
+ *           names.
  *
- * Programmer:  robb@cloud
- *              Tue Feb 21 08:23:48 EST 1995
+ * Programmer: Mark C. Miller, Wed Sep  2 15:27:06 PDT 2009
  *
- * Modifications:
- *-------------------------------------------------------------------------*/
-PUBLIC char const *
-DBErrString(void)
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBGuessHasFriendlyHDF5Names(DBfile *f)
 {
-    static char    s[128];
+    char cwd[1024];
+    int retval;
 
-    if (db_errno < 0 || db_errno >= NELMTS(_db_err_list)) {
-        sprintf(s, "Error %d", db_errno);
-        return s;
-    }
+#ifdef DB_HDF5X
+    if (DBGetDriverType(f) != DB_HDF5X)
+        return 0;
+#endif
 
-    return _db_err_list[db_errno];
-}
+    DBGetDir(f, cwd);
+    retval = db_guess_has_friendly_HDF5_names_r(f);
+    DBSetDir(f, cwd);    
 
-PUBLIC int
-DBErrno(void)
-{
-    return db_errno;
+    return retval;
 }
 
-PUBLIC char const *
-DBErrFuncname(void)
+/*----------------------------------------------------------------------
+ * Routine:  DBSetUnknownDriverPriority
+ *
+ * Purpose:  Set priority order of drivers used by unknown driver. 
+ *
+ * Programmer:  Mark C. Miller, May 1, 2006 
+ *
+ * Description:  This routine sets the flag that controls whether
+ *               checksums are computed on client data.
+ *--------------------------------------------------------------------*/
+PUBLIC int const * 
+DBSetUnknownDriverPriorities(const int *priorities)
 {
-    return db_errfunc;
+    int i = 0;
+    static int oldPriorities[MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1];
+    memcpy(oldPriorities, SILO_Globals.unknownDriverPriorities, sizeof(oldPriorities));
+    while (i < (MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1) && priorities[i] >= 0)
+    {
+        SILO_Globals.unknownDriverPriorities[i] = priorities[i];
+        i++;
+    }
+    if (i < (MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1))
+        SILO_Globals.unknownDriverPriorities[i] = -1;
+    return oldPriorities;
 }
 
-PUBLIC DBErrFunc_t
-DBErrfunc(void)
+PUBLIC int const *
+DBGetUnknownDriverPriorities()
 {
-    return SILO_Globals._db_err_func;
+    static int priorities[MAX_FILE_OPTIONS_SETS+DB_NFORMATS+1];
+    memcpy(priorities, SILO_Globals.unknownDriverPriorities, sizeof(priorities));
+    return priorities;
 }
 
 PUBLIC int
-DBErrlvl(void)
+DBRegisterFileOptionsSet(const DBoptlist *opts)
 {
-    return SILO_Globals._db_err_level;
-}
+    int i;
 
-/*-------------------------------------------------------------------------
- * Function: db_parse_version_digits_from_string
- *
- * str: version string
- * sep: separator character (typically '.')
- * digits: array of digits to return
- * ndigits: size of digits array
- *
- * returns 0 on successful conversion, non-zero on failure
- *-----------------------------------------------------------------------*/
-static int
-db_parse_version_digits_from_string(char const *str, char sep, int *digits, int ndigits)
-{
-    int i, nseps, non_digits, retval = 0;
-    char *p, *ostr;
-    
-    if (!str || !*str)
-        return 1;
-
-    ostr = strdup(str);
-    p = ostr;
-
-    /* Examine string for seperator chars and non-digits */
-    nseps = 0;
-    non_digits = 0;
-    while (*p)
-    {
-        if (*p == sep)
-        {
-            *p = '\0';
-            nseps++;
-        }
-        else if (!strncmp(p, "-pre", 4) ||
-                 !strncmp(p, "-pos", 4))
-        {
-            *(p+0) = '\0';
-            *(p+1) = '0';
-            *(p+2) = '0';
-            *(p+3) = '0';
-            nseps++;
-            p += 3;
-        }
-        else if (*p < '0' || *p > '9')
-        {
-            non_digits = 1;
-        }
-        p++;
-    }
-    nseps++;
-
-    /* Make a second pass over string converting all the digits */
-    if (!non_digits)
-    {
-        p = ostr;
-        errno = 0;
-        for (i = 0; i < ndigits; i++)
-            digits[i] = 0;
-        for (i = 0; i < nseps && ndigits && errno == 0; i++, ndigits--)
+    API_BEGIN("DBRegisterFileOptionsSet", int, -1) {
+        for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
         {
-            digits[i] = strtol(p, 0, 10);
-            while (*p != '\0') p++;
-            p++;
+            if (SILO_Globals.fileOptionsSets[i] == 0)
+            {
+                SILO_Globals.fileOptionsSets[i] = opts;
+                API_RETURN(i+NUM_DEFAULT_FILE_OPTIONS_SETS);
+            }
         }
-        if (errno)
-            retval = 1;
-    }
-    else
-    {
-        retval = 1;
+        API_ERROR("Silo library", E_MAXFILEOPTSETS);
     }
-
-    free(ostr);
-
-    return retval;
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-static int
-db_compare_version_digits(int const *a_digits, int const *b_digits, int ndigits)
+PUBLIC int
+DBUnregisterFileOptionsSet(int opts_set_id)
 {
-    int i;
-    for (i = 0; i < ndigits; i++)
-    {
-        if (a_digits[i] < b_digits[i])
-            return -1;
-        else if (a_digits[i] > b_digits[i])
-            return 1;
+    int _opts_set_id = opts_set_id-NUM_DEFAULT_FILE_OPTIONS_SETS;
+
+    API_BEGIN("DBUnregisterFileOptionsSet", int, -1) {
+        if (SILO_Globals.fileOptionsSets[_opts_set_id] == 0)
+            API_ERROR("opts_set_id", E_BADARGS);
+        SILO_Globals.fileOptionsSets[_opts_set_id] = 0;
+        API_RETURN(0);
     }
-    return 0;
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBVersion
- *
- * Purpose:     Return the version number of the library as a string.
- *
- * Returns:     ptr to version number
- *
- * Programmer:  Hank Childs
- *              Tue Oct 17 14:08:45 PDT 2000
- *
- * Modifications:
- *
- *   Mark C. Miller, Tue Oct 24 12:39:31 PDT 2006
- *   Changed to use SILO_VSTRING
- *-------------------------------------------------------------------------*/
-PUBLIC char const *
-DBVersion(void)
+PUBLIC void
+DBUnregisterAllFileOptionsSets()
 {
-    static char version[256];
-    strcpy(version, SILO_VSTRING);
+    int i;
 
-    return version;
+    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
+        SILO_Globals.fileOptionsSets[i] = 0;
 }
 
-PUBLIC int
-DBVersionDigits(int *maj, int *min, int *pat, int *pre)
+const int* db_get_used_file_options_sets_ids()
 {
-    int digits[4] = {0,0,0,0};
+    int i,n;
+    static int used_slots[MAX_FILE_OPTIONS_SETS+NUM_DEFAULT_FILE_OPTIONS_SETS+1];
 
-    if (!db_parse_version_digits_from_string(DBVersion(), '.',
-             digits, sizeof(digits)/sizeof(digits[0])))
+   
+    /* For the default cases, only return those that 'matter' in that
+       they could possibly have an impact on Silo's ability to actually
+       open the file. In addtion, put them in some kind of priority order */
+    n = 0;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_SILO;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_SPLIT;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_DIRECT;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_FAMILY;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_MPIO;
+    used_slots[n++] = DB_FILE_OPTS_H5_DEFAULT_MPIP;
+    for (i = n; i < MAX_FILE_OPTIONS_SETS+NUM_DEFAULT_FILE_OPTIONS_SETS+1; i++)
+        used_slots[i] = -1;
+
+    /* fill in with used options set slots */
+    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
     {
-        if (maj) *maj = digits[0];
-        if (min) *min = digits[1];
-        if (pat) *pat = digits[2];
-        if (pre) *pre = digits[3];
-        return 0;
+        if (SILO_Globals.fileOptionsSets[i]==0)
+            continue;
+        used_slots[n++] = i+NUM_DEFAULT_FILE_OPTIONS_SETS;
     }
-    return -1;
+
+    return used_slots;
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBVersionGE
+/*----------------------------------------------------------------------
+ * Routine:  DBGrabDriver
  *
- * Purpose:     Return whether or not the version of the library is greater
- *              than or equal to the version specified by Maj, Min, Pat.
- *              This is a run-time equiv. of the SILO_VERSION_GE macro.
+ * Purpose:  Set and return the low level driver file handle
  *
- * Returns:     integer indicating if true (1) or false (0) 
+ * Programmer:  Thomas R. Treadway, Tue May 29 15:52:19 PDT 2007
  *
- * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
- *-------------------------------------------------------------------------*/
-PUBLIC int 
-DBVersionGE(int Maj, int Min, int Pat)
-{
-    int a_digits[3] = {SILO_VERS_MAJ, SILO_VERS_MIN, SILO_VERS_PAT};
-    int b_digits[3] = {Maj<0?0:Maj, Min<0?0:Min, Pat<0?0:Pat};
-    return db_compare_version_digits(a_digits, b_digits, 3) >= 0;
-}
-
-PUBLIC int
-DBVersionGEFileVersion(const DBfile *dbfile)
+ * Description:  This routine returns a ponter to the driver-native
+ * file handle.
+ *
+ * Modifications
+ *   Mark C. Miller, Thu Oct 11 15:36:10 PDT 2007
+ *   Record fact file was grabbed by adding var at top-level
+ *--------------------------------------------------------------------*/
+PUBLIC void * 
+DBGrabDriver(DBfile *file)
 {
-    int a_digits[3];
-    int b_digits[3] = {4, 5, 0}; /* earliest version we have version info in file */
-    DBVersionDigits(&a_digits[0], &a_digits[1], &a_digits[2], 0);
-    DBFileVersionDigits(dbfile, &b_digits[0], &b_digits[1], &b_digits[2], 0);
-    return db_compare_version_digits(a_digits, b_digits, 3) >= 0;
+    void *rtn = 0;
+    if (file) {
+       if (file->pub.GrabId > (void *) 0) {
+          int grab_val = 1;
+          DBWrite(file, "/_was_grabbed", &grab_val, &grab_val, 1, DB_INT);
+#warning FIX GLOBAL LOCK
+          SILO_Globals.enableGrabDriver = TRUE;
+          rtn = (void *) file->pub.GrabId;
+       }
+    }
+    return rtn;
 }
-
-/*-------------------------------------------------------------------------
- * Function:    DBFileVersion
+/*----------------------------------------------------------------------
+ * Routine:  DBGetDriverType
  *
- * Purpose:     Return the version number of the library that created the
- *              given file as a string.
+ * Purpose:  Return the drive type 
  *
- * Returns:     ptr to version number
+ * Programmer:  Thomas R. Treadway, Thu Jun  7 13:19:48 PDT 2007
  *
- * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
- *-------------------------------------------------------------------------*/
-PUBLIC char const *
-DBFileVersion(const DBfile *dbfile)
-{
-    static char version[256];
-    if (dbfile->pub.file_lib_version)
-        strcpy(version, dbfile->pub.file_lib_version);
-    else
-        strcpy(version, "unknown; 4.5 or older");
-    return version;
-}
-
+ * Description:  This routine returns a the driver type
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBFileVersionDigits(const DBfile *dbfile, int *maj, int *min, int *pat, int *pre)
+DBGetDriverType(const DBfile *file)
 {
-    int digits[4] = {0,0,0,0};
-    if (!db_parse_version_digits_from_string(DBFileVersion(dbfile), '.',
-             digits, sizeof(digits)/sizeof(digits[0])))
-    {
-        if (maj) *maj = digits[0];
-        if (min) *min = digits[1];
-        if (pat) *pat = digits[2];
-        if (pre) *pre = digits[3];
-        return 0;
+    if (file) {
+       return file->pub.type;
     }
-    return -1;
+    return DB_UNKNOWN;
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBFileVersionGE
+/*----------------------------------------------------------------------
+ * Routine:  DBGetDriverTypeFromPath
  *
- * Purpose:     Return whether or not the given file was created with a 
- *              version of the library greater than or equal to the
- *              version specified by Maj, Min, Pat 
+ * Purpose:  Return the drive type 
  *
- * Returns:     1 if file version is greather than or equal to Maj/Min/Pat
- *              0 if file version is less than Maj/Min/Pat
- *             -1 if unable to determine.
+ * Programmer:  Thomas R. Treadway, Tue Jul  3 15:24:58 PDT 2007
  *
- * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
- *-------------------------------------------------------------------------*/
+ * Description:  This routine returns a the driver type
+ *
+ * Modifications:
+ *
+ * Thomas R. Treadway, Thu Jul  5 11:57:03 PDT 2007
+ * DB_HDR5 is conditional
+ *
+ * Mark C. Miller, Mon Nov 19 10:45:05 PST 2007
+ * Removed conditional compilation on HDF5 driver
+ *
+ * Mark C. Miller, Mon Oct 25 16:12:49 PDT 2010
+ * Initialize buf to ensure it will be null terminated no matter
+ * what happens during open/read.
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBFileVersionGE(const DBfile *dbfile, int Maj, int Min, int Pat)
+DBGetDriverTypeFromPath(const char *path)
 {
-    int retval = -1;
-    int unknown = 0;
-    int a_digits[3];
-    int b_digits[3] = {Maj<0?0:Maj, Min<0?0:Min, Pat<0?0:Pat};
-    char *version = STRDUP(DBFileVersion(dbfile));
+   char buf[9] = {'\0','\0','\0','\0','\0','\0','\0','\0','\0'};
+   int fd;
+   int nbytes;
+   int flags = O_RDONLY;
+   if ((fd = open(path, flags)) < 0) {
+      printf("cannot open `%s'\n", path);
+      return -1;
+   }
+   if ((nbytes = read(fd, (char *)buf, 8)) == -1) {
+      printf("cannot read `%s'\n", path);
+      close(fd);
+      return -1;
+   }
+   if (nbytes <= 5) {
+      printf("cannot read `%s' buffer too small\n", path);
+      close(fd);
+      return -1;
+   }
+   (void) close(fd);
+   if (strstr(buf, "PDB"))
+      return DB_PDB;
+#ifdef DB_HDF5X
+   if (strstr(buf, "HDF"))
+      return DB_HDF5X;
+#endif
+   return DB_UNKNOWN;
+}
 
-    if (strncmp(version, "unknown", 7) == 0)
-    {
-        /* We started maintaining library version information in the file
-           in version 4.5.1. So, if it is 'unknown', we can return something
-           useful ONLY if the version we're comparing against is 4.5.1 or
-           greater. */
-        a_digits[0] = 4;
-        a_digits[1] = 5;
-        a_digits[2] = 0;
-        unknown = 1;
+/*----------------------------------------------------------------------
+ * Routine:  DBJoinPath
+ *
+ * Purpose:  Given paths with possible relative naming, combine them
+ *           into a single absolute path. 
+ *
+ * Programmer:  Mark C. Miller, July 20, 2008 
+ *--------------------------------------------------------------------*/
+PUBLIC char * 
+DBJoinPath(const char *first, const char *second)
+{
+    API_BEGIN("DBJoinPath", char *, NULL) {
+        API_RETURN(db_join_path(first, second));
     }
-    else
-    {
-        if (db_parse_version_digits_from_string(version, '.',
-                 a_digits, sizeof(a_digits)/sizeof(a_digits[0])))
-        {
-            free(version);
-            return -1;
-        }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBUngrabDriver
+ *
+ * Purpose:  Return control of the low level driver
+ *
+ * Programmer:  Thomas R. Treadway, Thu Jun  7 13:19:48 PDT 2007
+ *
+ * Description:  This routine returns a the driver-native type
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBUngrabDriver(DBfile *file, const void *driver_handle)
+{
+    if (file) {
+       SILO_Globals.enableGrabDriver = FALSE;
+       return file->pub.type;
     }
+    return DB_UNKNOWN;
+}
 
-    free(version);
+static int 
+db_IncObjectComponentCount(DBobject *obj)
+{
+    int new_maxcomps = 0;
+    char **new_comp_names = 0;
+    char **new_pdb_names = 0;
 
-    retval = db_compare_version_digits(a_digits, b_digits, 3) >= 0; 
+    obj->ncomponents++;
+    if (obj->ncomponents < obj->maxcomponents)
+        return 1;
 
-    if (unknown)
+    new_maxcomps = obj->maxcomponents * 1.5 + 1; /* golden rule + 1 */
+    new_comp_names = REALLOC_N(obj->comp_names, char *, new_maxcomps);
+    if (!new_comp_names)
     {
-        if (retval)
-            retval = -1;
+        db_perror(0, E_NOMEM, "db_IncObjectComponentCount");
+        return 0;
+    }
+    new_pdb_names = REALLOC_N(obj->pdb_names, char *, new_maxcomps);
+    if (!new_pdb_names)
+    {
+        FREE(new_comp_names);
+        db_perror(0, E_NOMEM, "db_IncObjectComponentCount");
+        return 0;
     }
 
-    return retval;
+    obj->maxcomponents = new_maxcomps;
+    obj->comp_names = new_comp_names;
+    obj->pdb_names = new_pdb_names;
+
+    return 1;
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBFileName
+/*----------------------------------------------------------------------
+ *  Routine                                                 DBMakeObject
  *
- * Purpose:     Return the name of the associated file.
+ *  Purpose
  *
- * Returns:     ptr to string holding the name of the file or "unknown".
+ *      Allocate an object of the requested length and initialize it.
  *
- * Programmer:  Mark C. Miller, Tue May 24 12:45:53 PDT 2016
- *-------------------------------------------------------------------------*/
-PUBLIC char const *
-DBFileName(const DBfile *dbfile)
+ *  Programmer
+ *
+ *      Jeffery W. Long, NSSD-B
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 11:41:23 PST 1994
+ *    Added error mechanism
+ *
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *--------------------------------------------------------------------*/
+PUBLIC DBobject *
+DBMakeObject(const char *name, int type, int maxcomps)
 {
-    static char name[256];
-    if (dbfile->pub.name)
-        strcpy(name, dbfile->pub.name);
-    else
-        strcpy(name, "unknown");
-    return name;
-}
+    DBobject      *object = NULL;
 
-static void
-db_InitFileGlobals(DBfile *dbfile)
-{
-    int i;
+    API_BEGIN("DBMakeObject", DBobject *, NULL) {
 
-    dbfile->pub.file_scope_globals = (SILO_Globals_t*) malloc(sizeof(SILO_Globals_t));
-    /* since most entries are ints and we want to init them to the NOT-SET value
-       this call averts *some* mistakes where SILO_Globals_t might get updated with
-       new int members but failed to be explicitly initialize here. Setting to all
-       0xFF has effect of setting all ints to -1, the DB_INTBOOL_NOT_SET value. */
-    memset(dbfile->pub.file_scope_globals, 0xFF, sizeof(SILO_Globals_t));
+        if (!name || !*name)
+            API_ERROR("object name", E_BADARGS);
+        if (db_VariableNameValid(name) == 0)
+            API_ERROR("object name", E_INVALIDNAME);
+        if (NULL == (object = ALLOC(DBobject)))
+            API_ERROR(NULL, E_NOMEM);
 
-    /* Initialize to NOT-SET values so that, initially, a file is set to
-       inheret *and* track all behaviors from Silo's globals. The first time
-       any of these values are changed to a NOT_SET value, then forevermore, 
-       that particular behavior for the file */
-    dbfile->pub.file_scope_globals->dataReadMask            = DB_MASK_NOT_SET;
-    dbfile->pub.file_scope_globals->allowOverwrites         = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->allowEmptyObjects       = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->enableChecksums         = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->enableFriendlyHDF5Names = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->enableGrabDriver        = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->darshanEnabled          = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->allowLongStrComponents  = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->maxDeprecateWarnings    = DB_INTBOOL_NOT_SET;
-#warning ADD compressionMinSize
-    dbfile->pub.file_scope_globals->compressionMinratio     = DB_FLOAT_NOT_SET;
-#warning CORRECT INITIALIZATION OF compressionErrmode
-    dbfile->pub.file_scope_globals->compressionErrmode      = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->compatabilityMode       = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->compressionParams       = DB_CHAR_PTR_NOT_SET;
-    dbfile->pub.file_scope_globals->_db_err_level           = DB_INTBOOL_NOT_SET;
-    dbfile->pub.file_scope_globals->_db_err_func            = DB_VOID_PTR_NOT_SET;
-    dbfile->pub.file_scope_globals->_db_err_level_drvr      = DB_INTBOOL_NOT_SET;
+        if (maxcomps <= 0) maxcomps = 30;
+        object->name = STRDUP(name);
+        object->type = STRDUP(DBGetObjtypeName(type));
+        object->comp_names = ALLOC_N(char *, maxcomps);
+        object->pdb_names = ALLOC_N(char *, maxcomps);
 
-    /* Jstk only relevant for lib as a whole, not specific to a file */
-    dbfile->pub.file_scope_globals->Jstk = 0;
+        if (!object->name || !object->type ||
+            !object->comp_names || !object->pdb_names)
+        {
+            FREE(object->name);
+            FREE(object->type);
+            FREE(object->comp_names);
+            FREE(object->pdb_names);
+            API_ERROR(NULL, E_NOMEM);
+        }
 
-    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
-        dbfile->pub.file_scope_globals->fileOptionsSets[i] = 0;
+        object->ncomponents = 0;
+        object->maxcomponents = maxcomps;
+
+        API_RETURN(object);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBOpen
+/*----------------------------------------------------------------------
+ *  Routine                                                DBFreeObject
  *
- * Purpose:     Open a data file.
+ *  Purpose
  *
- * Return:      Success:        pointer to new file descriptor
+ *      Release the storage associated with the given object list.
  *
- *              Failure:        NULL
+ *  Programmer
  *
- * Programmer:  matzke@viper
- *              Mon Nov  7 10:25:08 PST 1994
+ *      Jeffery W. Long, NSSD-B
  *
- * Modifications:
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *  Returns
  *
- *    Robb Matzke, Tue Feb 28 10:51:19 EST 1995
- *    When a file is opened, it is given a unique ID number wrt all other
- *    open files.  The ID is a small integer [0..DB_NFILES-1].
+ *      Returns OKAY on success, OOPS on failure.
  *
- *    Robb Matzke, Tue Feb 28 11:38:08 EST 1995
- *    For each registered filter, call the non-null `init' functions for
- *    every file that is opened.
+ *  Modified
+ *    Robb Matzke, Thu Nov 10 17:28:39 EST 1994
+ *    Added error mechanism.
  *
- *    Sean Ahern, Mon Jan  8 17:38:18 PST 1996
- *    Added the mode parameter.
- *
- *    Lisa J. Nafziger, Wed Mar  6 10:20:48 PST 1996
- *    Added code to check for file existence, to check if it is a
- *    directory and to check for read permission.  This allows more
- *    specific error messages to be returned.
- *
- *    Lisa J. Nafziger, Tue Mar 12 14:15:06 PST 1996
- *    Modified code to check file attributes so that stat() rather
- *    than access() is used.  The former is POSIX compliant.
- *
- *    Eric Brugger, Tue Jun 17 10:25:57 PDT 1997
- *    I modified the routine to only check file validity if the type
- *    is not an SDX connection.
- *
- *    Jeremy Meredith, Fri Jul 23 09:31:14 PDT 1999
- *    I added error reporting to the result of stat().
- *
- *    Jeremy Meredith, Mon Jul 26 10:39:49 PDT 1999
- *    Made stat() error reporting POSIX.1 compliant.
- *
- *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
- *    Renamed the function to DBOpenReal.  Client code now calls a macro
- *    called DBOpen.
- *
- *    Mark C. Miller, Wed Feb  2 07:59:53 PST 2005
- *    Added printing of error message from stat() with strerror
- *
- *    Mark C. Miller, Wed Feb 23 08:51:35 PST 2005
- *    Added code to reset _db_fstatus slot to 0 if open fails
- *
- *    Thomas R. Treadway, Tue Jun 27 13:59:21 PDT 2006
- *    Added HAVE_STRERROR wrappers
- *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Added code to register the returned file pointer
- *
- *    Mark C. Miller, Mon Jan 12 20:50:41 PST 2009
- *    Removed DB_SDX conditionally compiled code blocks.
- *
- *    Mark C. Miller, Wed Feb 25 23:50:06 PST 2009
- *    Moved call to db_isregistered_file to AFTER calls to stat the file
- *    add changed db_isregistered_file to accept stat struct instead of name.
- *    Changed call to db_register_file to accpet stat struct.
+ *    Robb Matzke, Fri Dec 2 13:14:18 PST 1994
+ *    Removed all references to SCORE memory management.
  *
- *    Mark C. Miller, Fri Feb 12 08:22:41 PST 2010
- *    Replaced stat/stat64 calls with db_silo_stat. Replaced conditional
- *    compilation logic for SIZEOF_OFF64_T with db_silo_stat_struct.
- *------------------------------------------------------------------------- */
-PUBLIC DBfile *
-DBOpenReal(const char *name, int type, int mode)
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBFreeObject(DBobject *object)
 {
-    char           ascii[16];
-    DBfile        *dbfile;
-    int            fileid, i;
-    int            origtype = type;
-    int            opts_set_id;
-    db_silo_stat_t filestate;
-
-    API_BEGIN("DBOpen", DBfile *, NULL) {
-        if (DB_NOBJ_TYPES != _db_nobj_types)
-            API_ERROR("Silo TOC not configured corretly", E_INTERNAL);
-
-        if (!name)
-            API_ERROR(NULL, E_NOFILE);
+    int            i;
 
-        /* deal with extended driver type specifications */
-        db_DriverTypeAndFileOptionsSetId(origtype, &type, &opts_set_id);
+    API_BEGIN("DBFreeObject", int, -1) {
 
-        if (type < 0 || type >= DB_NFORMATS) {
-            sprintf(ascii, "%d", type);
-            API_ERROR(ascii, E_BADFTYPE);
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (object->ncomponents < 0) {
+            API_ERROR("object ncomponents", E_BADARGS);
         }
-        if ((mode != DB_READ) && (mode != DB_APPEND))
-        {
-            sprintf(ascii, "%d", mode);
-            API_ERROR(ascii, E_BADARGS);
+
+        for (i = 0; i < object->ncomponents; i++) {
+            FREE(object->comp_names[i]);
+            FREE(object->pdb_names[i]);
         }
-        if (!DBOpenCB[type]) {
-            sprintf(ascii, "%d", type);
-            API_ERROR(ascii, E_NOTIMP);
+        for (i = 0; i < DB_MAX_H5_OBJ_VALS; i++) {
+            FREE(object->h5_names[i]);
         }
 
-        /****************************************************/
-        /* Check to make sure the file exists and has the   */
-        /* correct permissions.                             */
-        /****************************************************/
-        if (db_silo_stat(name, &filestate, type==DB_UNKNOWN?-1:opts_set_id) != 0)
-        {
-            if( errno == ENOENT )
-            {
-                /********************************/
-                /* File doesn't exist.          */
-                /********************************/
-                API_ERROR((char *)name, E_NOFILE);
-            }
-            else
-            {
-                /********************************/
-                /* System level error occured.  */
-                /********************************/
-#if SIZEOF_OFF64_T > 4
-                printf("stat64() failed with error: ");
-#else
-                printf("stat() failed with error: ");
-#endif
-                switch (errno)
-                {
-                  case EACCES:       printf("EACCES\n");       break;
-                  case EBADF:        printf("EBADF\n");        break;
-                  case ENAMETOOLONG: printf("ENAMETOOLONG\n"); break;
-                  case ENOTDIR:      printf("ENOTDIR\n");      break;
-#ifdef EOVERFLOW
-                  case EOVERFLOW:    
-#ifdef HAVE_STRERROR
-                                     printf("EOVERFLOW: \"%s\"\n", 
-                                        strerror(errno));
-#else
-                                     printf("EOVERFLOW: errno=%d\n", errno);
-#endif
-                                     printf("Silo may need to be re-compiled with "
-                                            "Large File Support (LFS)\n");
-                                     break;
-#endif
-                  default:           
-#ifdef HAVE_STRERROR
-                                     printf("\"%s\"\n",
-                                        strerror(errno));
-#else
-                                     printf("errno=%d\n", errno);
-#endif
-                                     break;
-                }
-                API_ERROR((char *)name, E_SYSTEMERR);
-            }
-        }
+        FREE(object->comp_names);
+        FREE(object->pdb_names);
+        FREE(object->name);
+        FREE(object->type);
+        FREE(object);
+    }
+    API_END;
 
-        /* Check if file is already opened. If so, none can
-           have it opened for write, including this new one */ 
-        i = db_isregistered_file(0, &filestate);
-        if (i != -1)
-        {
-            if (_db_regstatus[i].w != 0 || mode != DB_READ)
-                API_ERROR(name, E_CONCURRENT);
-        }
+    return(0);  /* Always succeeds by the time we get here */
+}
 
-        if( ( filestate.s.st_mode & S_IFDIR ) != 0 )
-        {
-            /************************************/
-            /* File is actually a directory.    */
-            /************************************/
-            API_ERROR((char *)name, E_FILEISDIR);
-        }
-        if( ( filestate.s.st_mode & S_IREAD ) == 0 )
-        {
-            /****************************************/
-            /* File is missing read permissions.    */
-            /****************************************/
-            API_ERROR((char *)name, E_FILENOREAD);
-        }
-        if (DB_READ!=mode && (filestate.s.st_mode & S_IWUSR) == 0)
-        {
-            /****************************************/
-            /* File is open for write and missing write permission. */
-            /****************************************/
-            API_ERROR((char *)name, E_FILENOWRITE);
-        }
+/*----------------------------------------------------------------------
+ *  Routine                                                DBClearObject
+ *
+ *  Purpose
+ *
+ *      Remove all components from the given object and reset counters.
+ *
+ *  Programmer
+ *
+ *      Jeffery W. Long, NSSD-B
+ *
+ *  Returns
+ *
+ *      Returns OKAY on success, OOPS on failure.
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 07:46:29 PST 1994
+ *    Added error mechanism
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBClearObject(DBobject *object)
+{
+    int            i;
 
-        if ((fileid = db_get_fileid(DB_ISOPEN)) < 0)
-            API_ERROR((char *)name, E_MAXOPEN);
-        if (NULL == (dbfile = (DBOpenCB[type]) (name, mode, opts_set_id)))
-        {
-            _db_fstatus[fileid] = 0;
-            API_RETURN(NULL);
+    API_BEGIN("DBClearObject", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (object->ncomponents < 0) {
+            API_ERROR("object ncomponents", E_BADARGS);
         }
-        dbfile->pub.fileid = fileid;
-        db_InitFileGlobals(dbfile);
-        db_register_file(dbfile, &filestate, mode!=DB_READ);
 
-        /*
-         * Install filters.  First, all `init' filters, then the
-         * specified filters.
-         */
-        for (i = 0; i < DB_NFILTERS; i++) {
-            if (_db_filter[i].name && _db_filter[i].init) {
-                (void)(_db_filter[i].init) (dbfile, _db_filter[i].name);
-            }
+        /* Reset values, but do not free */
+        for (i = 0; i < object->maxcomponents; i++) {
+            object->comp_names[i] = NULL;
+            object->pdb_names[i] = NULL;
         }
-        db_filter_install(dbfile);
-        if (DBInqVarExists(dbfile, SILO_VSTRING_NAME))
-            dbfile->pub.file_lib_version = (char*)DBGetVar(dbfile, SILO_VSTRING_NAME);
 
-        API_RETURN(dbfile);
+        object->name = NULL;
+        object->type = NULL;
+        object->ncomponents = 0;
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END;
+
+    return(0);
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBCreateReal
+/*----------------------------------------------------------------------
+ *  Routine                                            DBAddVarComponent
  *
- * Purpose:     Create a data file
+ *  Purpose
  *
- * Return:      Success:        pointer to file descriptor
+ *      Add a variable component to the given object structure.
  *
- *              Failure:        NULL
+ *  Programmer
  *
- * Programmer:  matzke@viper
- *              Mon Nov  7 10:29:23 PST 1994
+ *      Jeffery W. Long, NSSD-B
  *
- * Modifications:
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *  Returns
  *
- *    Robb Matzke, Tue Feb 28 10:57:06 EST 1995
- *    A file ID is assigned to the new file.
+ *      Returns OKAY on success, OOPS on failure.
  *
- *    Robb Matzke, 15 May 1996
- *    Removed the unused `statue' auto variable.
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 07:43:38 PST 1994
+ *    Added error mechanism
  *
- *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
- *    Renamed the function to DBCreateReal.  Client code now calls a macro
- *    called DBCreate.
+ *    Robb Matzke, Fri Dec 2 13:14:46 PST 1994
+ *    Removed all references to SCORE memory management.
  *
- *    Mark C. Miller, Wed Feb 23 08:51:35 PST 2005
- *    Added code to reset _db_fstatus slot to 0 if create fails
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
  *
- *    Mark C. Miller, Wed Apr  5 10:17:31 PDT 2006
- *    Added code to output silo library version string to the file
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.  Correct spelling.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBAddVarComponent(DBobject *object, const char *compname, const char *pdbname)
+{
+    API_BEGIN("DBAddVarComponent", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (db_VariableNameValid(compname) == 0)
+            API_ERROR("component name", E_INVALIDNAME);
+        if (!pdbname || !*pdbname)
+            API_ERROR("pdb name", E_BADARGS);
+        if (object->ncomponents >= object->maxcomponents) {
+            API_ERROR("object ncomponents", E_BADARGS);
+        }
+
+        if (NULL == (object->comp_names[object->ncomponents] =
+                     STRDUP(compname)) ||
+            NULL == (object->pdb_names[object->ncomponents] =
+                     STRDUP(pdbname))) {
+            FREE(object->comp_names[object->ncomponents]);
+            API_ERROR(NULL, E_NOMEM);
+        }
+
+        if (!db_IncObjectComponentCount(object))
+            API_ERROR(NULL, E_NOMEM);
+
+    }
+    API_END;
+
+    return(0);
+}
+
+/*----------------------------------------------------------------------
+ *  Routine                                            DBAddIntComponent
  *
- *    Mark C. Miller, Mon Nov 19 10:45:05 PST 2007
- *    Added hdf5 driver warning.
+ *  Purpose
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Added code to register the returned file pointer
+ *      Add an integer literal component to the given object structure.
  *
- *    Mark C. Miller, Mon Nov 17 19:04:39 PST 2008
- *    Added code to check to see if name is a directory.
+ *  Programmer
  *
- *    Mark C. Miller, Wed Feb 25 23:52:05 PST 2009
- *    Moved call to db_isregistered_file to after stat calls. Stat the
- *    file after its created so we can get information to register it.
+ *      Jeffery W. Long, NSSD-B
  *
- *    Mark C. Miller, Fri Feb 12 08:22:41 PST 2010
- *    Replaced stat/stat64 calls with db_silo_stat. Replaced conditional
- *    compilation logic for SIZEOF_OFF64_T with db_silo_stat_struct.
+ *  Returns
  *
- *    Mark C. Miller, Thu Aug 30 17:41:24 PDT 2012
- *    Added logic to temporarily disable any compression settings prior
- *    to writing silo library info and then re-enabling it.
- *-------------------------------------------------------------------------*/
-PUBLIC DBfile *
-DBCreateReal(const char *name, int mode, int target, const char *info, int type)
+ *      Returns OKAY on success, OOPS on failure.
+ *
+ *  Modifications
+ *    Robb Matzke, Tue Nov 8 07:06:11 PST 1994
+ *    Added error mechanism. Returns 0 on success, -1 on failure.
+ *
+ *    Robb Matzke, Fri Dec 2 13:15:06 PST 1994
+ *    Removed all references to SCORE memory management.
+ *
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBAddIntComponent(DBobject *object, const char *compname, int ii)
 {
-    char           ascii[16];
-    char           *tmpcs = 0;
-    DBfile        *dbfile;
-    int            fileid, i, n;
-    int            origtype = type;
-    int            opts_set_id = 0;
-    db_silo_stat_t filestate;
-
-    API_BEGIN("DBCreate", DBfile *, NULL) {
-        if (DB_NOBJ_TYPES != _db_nobj_types)
-            API_ERROR("Silo TOC not configured corretly", E_INTERNAL);
-
-        if (!name)
-            API_ERROR(NULL, E_NOFILE);
-
-        /* deal with extended driver type specifications */
-        db_DriverTypeAndFileOptionsSetId(origtype, &type, &opts_set_id);
-
-        if (type < 0 || type >= DB_NFORMATS) {
-            sprintf(ascii, "%d", type);
-            API_ERROR(ascii, E_BADFTYPE);
-        }
-
-        if (db_silo_stat(name, &filestate, opts_set_id) == 0)  /* Success - File exists */
-        {
-            if (mode == DB_NOCLOBBER)
-            {
-                API_ERROR((char *)name, E_FEXIST);
-            }
-            if ((filestate.s.st_mode & S_IFDIR) != 0)
-            {
-                API_ERROR((char *)name, E_FILEISDIR);
-            }
+    return DBAddIntNComponent(object, compname, 1, &ii);
+}
 
-            /* Check if file is already opened. If so, none can
-               have it opened for write, including this new one */
-            i = db_isregistered_file(0, &filestate);
-            if (i != -1)
-            {
-                API_ERROR(name, E_CONCURRENT);
-            }
-        }
+PUBLIC int
+DBAddIntNComponent(DBobject *object, const char *compname, int n, int const *ii)
+{
+    int            i;
+    char           tmp[256];
 
-        if (!DBCreateCB[type]) {
-            sprintf(ascii, "%d", type);
-            if (type == 7)
-            {
-                API_ERROR(ascii, E_NOHDF5);
-            }
-            else
-            {
-                API_ERROR(ascii, E_NOTIMP);
-            }
-        }
+    API_BEGIN("DBAddIntComponent", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (db_VariableNameValid(compname) == 0)
+            API_ERROR("component name", E_INVALIDNAME);
+        if (n < 1)
+            API_ERROR("n", E_BADARGS);
+        if (!ii)
+            API_ERROR("ii array", E_BADARGS);
+        if (object->ncomponents >= object->maxcomponents)
+            API_ERROR("object ncomponents", E_BADARGS);
 
-        if ((fileid = db_get_fileid(DB_ISOPEN)) < 0)
-            API_ERROR((char *)name, E_MAXOPEN);
-        dbfile = ((DBCreateCB[type]) (name, mode, target, opts_set_id,
-                                      info));
-        if (!dbfile)
+        sprintf(tmp, "'<i>%d", ii[0]);
+        for (i = 1; i < n; i++)
         {
-            _db_fstatus[fileid] = 0;
-            API_RETURN(NULL);
+            char tmp2[32];
+            snprintf(tmp2, sizeof(tmp2), ",%d", ii[i]);
+            strcat(tmp, tmp2);
         }
-        dbfile->pub.fileid = fileid;
-        db_InitFileGlobals(dbfile);
-        db_silo_stat(name, &filestate, opts_set_id);
-        db_register_file(dbfile, &filestate, 1);
+        strcat(tmp, "'");
 
-        /*
-         * Install filters.  First all `init' routines, then the specified
-         * `open' routines.
-         */
-        for (i = 0; i < DB_NFILTERS; i++) {
-            if (_db_filter[i].name && _db_filter[i].init) {
-                (void)(_db_filter[i].init) (dbfile, _db_filter[i].name);
-            }
+        if (NULL == (object->comp_names[object->ncomponents] =
+                     STRDUP(compname)) ||
+            NULL == (object->pdb_names[object->ncomponents] =
+                     STRDUP(tmp))) {
+            FREE(object->comp_names[object->ncomponents]);
+            API_ERROR(NULL, E_NOMEM);
         }
-        db_filter_install(dbfile);
 
-        /* write silo library version information to the file */
-        /* Temporarily turn off any compression settings and then re-enable */
-        if (DBGetCompression())
-        {
-    
-            n = strlen(DBGetCompression());
-            tmpcs = ALLOC_N(char,n+1);
-            strncpy(tmpcs, DBGetCompression(), n);
-            tmpcs[n] = '\0';
-            DBSetCompression(0);
-        }
-        n = strlen(SILO_VSTRING)+1;
-        DBWrite(dbfile, SILO_VSTRING_NAME, SILO_VSTRING, &n, 1, DB_CHAR);
-        dbfile->pub.file_lib_version = STRDUP(SILO_VSTRING);
-        if (tmpcs)
-        {
-            DBSetCompression(tmpcs);
-            FREE(tmpcs);
-        }
+        if (!db_IncObjectComponentCount(object))
+            API_ERROR(NULL, E_NOMEM);
 
-        API_RETURN(dbfile);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END;
+
+    return(0);
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBClose
+/*----------------------------------------------------------------------
+ *  Routine                                            DBAddFltComponent
  *
- * Purpose:     Close the specified data file and return NULL.
+ *  Purpose
  *
- * Return:      Success:        NULL
+ *      Add a floating point literal component to the given object
+ *      structure.
  *
- *              Failure:        NULL
+ *  Programmer
  *
- * Programmer:  matzke@viper
- *              Mon Nov  7 10:31:41 PST 1994
+ *      Jeffery W. Long, NSSD-B
  *
- * Modifications:
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *  Returns
  *
- *    Eric Brugger, Mon Feb 27 15:03:01 PST 1995
- *    I changed the return value to be an integer instead of a pointer
- *    to a DBfile.
+ *      Returns OKAY on success, OOPS on failure.
  *
- *    Robb Matzke, Tue Feb 28 10:57:57 EST 1995
- *    The file status slot is cleared so it can be reused.
+ *  Modified:
+ *    Robb Matzke, Tue Nov 8 07:04:15 PST 1994
+ *    Added error mechanism.  Return -1 on failure, 0 on success.
  *
- *    Eric Brugger, Mon Jul 10 07:42:24 PDT 1995
- *    I moved the reseting of _db_fstatus to before the return statement,
- *    so that the instruction would get executed.
+ *    Robb Matzke, Fri Dec 2 13:15:28 PST 1994
+ *    Removed all references to SCORE memory management.
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *    Added code to UNregister the given file pointer.
- *-------------------------------------------------------------------------*/
+ *    Eric Brugger, Tue Feb  7 09:06:58 PST 1995
+ *    I modified the argument declarations to reflect argument promotions.
+ *
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBClose(DBfile *dbfile)
+DBAddFltComponent(DBobject *object, const char *compname, double ff)
 {
-    int            id;
-    int            retval;
+    return DBAddFltNComponent(object, compname, 1, &ff);
+}
 
-    API_BEGIN2("DBClose", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (NULL == dbfile->pub.close)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-#warning IS ORDER OF OPS CORRECT HERE
-        id = dbfile->pub.fileid;
-        if (id >= 0 && id < DB_NFILES)
-            _db_fstatus[id] = 0;
+PUBLIC int
+DBAddFltNComponent(DBobject *object, const char *compname, int n, double const *ff)
+{
+    int            i;
+    char           tmp[256];
 
-        if (dbfile->pub.file_lib_version)
-            free(dbfile->pub.file_lib_version);
-        db_unregister_file(dbfile);
+    API_BEGIN("DBAddFltComponent", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (n < 1)
+            API_ERROR("n", E_BADARGS);
+        if (!ff)
+            API_ERROR("ff array", E_BADARGS);
+        if (db_VariableNameValid(compname) == 0)
+            API_ERROR("component name", E_INVALIDNAME);
+        if (object->ncomponents >= object->maxcomponents) {
+            API_ERROR("object ncomponents", E_BADARGS);
+        }
 
-        retval = (dbfile->pub.close) (dbfile);
-        free(dbfile->pub.file_scope_globals);
-        API_RETURN(retval);
+        sprintf(tmp, "'<f>%g", ff[0]);
+        for (i = 1; i < n; i++)
+        {
+            char tmp2[32];
+            snprintf(tmp2, sizeof(tmp2), ",%g", ff[i]);
+        }
+        strcat(tmp, "'");
+
+        if (NULL == (object->comp_names[object->ncomponents] =
+                     STRDUP(compname)) ||
+            NULL == (object->pdb_names[object->ncomponents] =
+                     STRDUP(tmp))) {
+            FREE(object->comp_names[object->ncomponents]);
+            API_ERROR(NULL, E_NOMEM);
+        }
+        if (!db_IncObjectComponentCount(object))
+            API_ERROR(NULL, E_NOMEM);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
-}
+    API_END;
 
+    return(0);
+}
 
-/*-------------------------------------------------------------------------
- * Function:    DBFlush
+/*----------------------------------------------------------------------
+ *  Routine                                            DBAddDblComponent
  *
- * Purpose:     Flush the specified file contents to disk.
+ *  Purpose
  *
- * Return:      Success:        NULL
+ *      Add a double precision floating point literal component to 
+ *      the given object structure.
  *
- *              Failure:        NULL
+ *  Programmer
  *
- * Programmer:  Mark C. Miller, Fri Nov  6 09:38:05 PST 2015
+ *      Brad Whitlock, Thu Jan 20 09:43:13 PDT 2000
  *
- * Modifications:
- *-------------------------------------------------------------------------*/
-PUBLIC int
-DBFlush(DBfile *dbfile)
-{
-    int            id;
-    int            retval;
-
-    API_BEGIN2("DBFlush", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (NULL == dbfile->pub.flush)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        retval = (dbfile->pub.flush) (dbfile);
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
-}
-
-/*----------------------------------------------------------------------
- * Routine:  db_inq_file_has_silo_objects_r
+ *  Returns
  *
- * Purpose:  Recursive helper func for DBInqFileHasObjects 
+ *      Returns OKAY on success, OOPS on failure.
  *
- * Programmer: Mark C. Miller, Wed Sep 23 11:34:01 PDT 2009
+ *  Modified:
  *
- * Modifications:
- *   Mark C. Miller, Mon Nov 16 10:28:41 PST 2009
- *   Fixed dir recursion by copying dir-related toc entries. Removed
- *   misc. vars from count of silo objects.
  *--------------------------------------------------------------------*/
+PUBLIC int
+DBAddDblComponent(DBobject *object, const char *compname, double dd)
+{
+    return DBAddDblNComponent(object, compname, 1, &dd);
+}
 
-PRIVATE int
-db_inq_file_has_silo_objects_r(DBfile *f)
+PUBLIC int
+DBAddDblNComponent(DBobject *object, const char *compname, int n, double const *dd)
 {
-    int i, ndir, retval = 0;
-    char **dirnames;
-    DBtoc *toc = DBGetToc(f);
+    int            i;
+    char           tmp[256];
 
-    if (!toc)
-        return -1;
+    API_BEGIN("DBAddDblComponent", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (n < 1)
+            API_ERROR("n", E_BADARGS);
+        if (!dd)
+            API_ERROR("dd array", E_BADARGS);
+        if (db_VariableNameValid(compname) == 0)
+            API_ERROR("component name", E_INVALIDNAME);
+        if (object->ncomponents >= object->maxcomponents) {
+            API_ERROR("object ncomponents", E_BADARGS);
+        }
 
-    /* save dirnames so we don't loose 'em as we get new tocs */
-    ndir = toc->ndir;
-    dirnames = (char **) malloc(ndir * sizeof(char*));
-    for (i = 0; i < ndir; i++)
-        dirnames[i] = STRDUP(toc->dir_names[i]);
-     
-    /* We exclude dirs and misc. vars because a non-Silo file may
-     * contain them. */
-    retval = toc->ncurve + toc->ncsgmesh + toc->ncsgvar + toc->ndefvars +
-        toc->nmultimesh + toc->nmultimeshadj + toc->nmultivar +
-        toc->nmultimat + toc->nmultimatspecies + toc->nqmesh +
-        toc->nqvar + toc->nucdmesh + toc->nucdvar + toc->nptmesh +
-        toc->nptvar + toc->nmat + toc->nmatspecies +
-        toc->nobj + toc->nmrgtree + toc->ngroupelmap +
-        toc->nmrgvar + toc->narray;
+        sprintf(tmp, "'<d>%.30g", dd[0]);
+        for (i = 1; i < n; i++)
+        {
+            char tmp2[64];
+            snprintf(tmp2, sizeof(tmp2), ",%.30g", dd[i]);
+        }
+        strcat(tmp, "'");
 
-    /* Recurse on directories. */
-    for (i = 0; i < ndir && retval == 0; i++)
-    {
-        DBSetDir(f, dirnames[i]);
-        retval += db_inq_file_has_silo_objects_r(f);
-        DBSetDir(f, "..");
+        if (NULL == (object->comp_names[object->ncomponents] =
+                     STRDUP(compname)) ||
+            NULL == (object->pdb_names[object->ncomponents] =
+                     STRDUP(tmp))) {
+            FREE(object->comp_names[object->ncomponents]);
+            API_ERROR(NULL, E_NOMEM);
+        }
+        if (!db_IncObjectComponentCount(object))
+            API_ERROR(NULL, E_NOMEM);
     }
+    API_END;
 
-    /* free the dirnames */
-    for (i = 0; i < ndir; i++)
-        free(dirnames[i]);
-    free(dirnames);
-
-    return retval;
+    return(0);
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBInqFileHasObjects
+/*----------------------------------------------------------------------
+ *  Routine                                            DBAddStrComponent
  *
- * Purpose:     See if the file contains any silo objects, excluding
- *              directories in the search.
+ *  Purpose
  *
- * Return:      Success:         >0 ==> yes, the file has silo objects.
- *                              ==0 ==> no, the file has no silo objects.
+ *      Add a string literal component to the given object structure.
  *
- *              Failure:        -1 
+ *  Programmer
  *
- * Programmer:  Mark C. Miller, Wed Sep 23 09:42:27 PDT 2009
+ *      Jeffery W. Long, NSSD-B
  *
- * Modifications:
- *   Mark C. Miller, Mon Nov 16 10:29:36 PST 2009
- *   Added logic to test from some well known, tell-tale silo variables.
- *-------------------------------------------------------------------------*/
-
-PUBLIC int
-DBInqFileHasObjects(DBfile *f)
-{
-    char cwd[4096];
-    int retval;
-
-    if (f == 0)
-        return -1;
-
-    if (DBInqVarExists(f, "_silolibinfo"))
-        return 1;
-    if (DBInqVarExists(f, "_hdf5libinfo"))
-        return 1;
-
-    DBGetDir(f, cwd);
-    retval = db_inq_file_has_silo_objects_r(f);
-    DBSetDir(f, cwd);    
-
-    return retval;
-}
-
-/*-------------------------------------------------------------------------
- * Function:    DBInqFileReal
+ *  Returns
  *
- * Purpose:     Determines if the filename is a Silo file.
+ *      Returns OKAY on success, OOPS on failure.
  *
- * Return:      0  if filename is not a Silo file, 
- *              >0 if filename is a Silo file,
- *              <0 if an error occurred.
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 07:08:33 PST 1994
+ *    Added error mechanism.  Return 0 on success, -1 on failure.
  *
- * Programmer:  Hank Childs
- *              Tue Feb 29 16:24:01 PST 2000
+ *    Robb Matzke, Fri Dec 2 13:15:49 PST 1994
+ *    Removed all references to SCORE memory management.
  *
- * Modifications:
- *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
- *    Renamed the function to DBInqFileReal.  Client code now calls a macro
- *    called DBInqFile.
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
  *
- *    Mark C. Miller, Wed Sep 23 11:48:19 PDT 2009
- *    Added logic to confirm that indeed the successfully opened file has
- *    some silo objects in it.
- *-------------------------------------------------------------------------*/
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *
+ *    Mark C. Miller, Thu Apr  2 09:48:57 PDT 2015
+ *    Added Al Nichols' enhancement for arb. length str components.
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBInqFileReal(const char *filename)
+DBAddStrComponent(DBobject *object, const char *compname, const char *ss)
 {
-    DBfile *dbfile = NULL;
-    int hasobjects = -1;
-
-    API_BEGIN("DBInqFile", int, -1) {
-        if (!filename || ! *filename)
-            API_ERROR("filename", E_BADARGS);
-
-        /* 
-         * Turn the error handling off so user won't see errors, 
-         * won't abort, etc.
-         */
-        DBShowErrors(DB_SUSPEND, NULL);
-
-        /*
-         * Must protect this code so that the error handling can be
-         * restored afterwards.
-         */
-        PROTECT {
-            dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
-            if (dbfile)
-                hasobjects = DBInqFileHasObjects(dbfile);
-        } CLEANUP {
-            CANCEL_UNWIND;
-        } END_PROTECT;
+    char *tmp = 0;
 
-        /* 
-         * Turn the error handling back on. 
-         */
-        DBShowErrors(DB_RESUME, NULL);
+    API_BEGIN("DBAddStrComponent", int, -1) {
+        if (!object)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (db_VariableNameValid(compname) == 0)
+            API_ERROR("component name", E_INVALIDNAME);
+        if (object->ncomponents >= object->maxcomponents) {
+            API_ERROR("object ncomponents", E_BADARGS);
+        }
+        if (!ss)
+        {
+            if (!DBGetAllowEmptyObjects())
+                API_ERROR("string literal component", E_BADARGS);
+            tmp = malloc(10);
+            sprintf(tmp, "'<s>null'");
+        }
+        else
+        {
+            tmp = malloc(strlen(ss)+6);
+            sprintf(tmp, "'<s>%s'", ss);
+        }
 
-        if (dbfile != NULL)
+        if (NULL == (object->comp_names[object->ncomponents] =
+                     STRDUP(compname)) ||
+            NULL == (object->pdb_names[object->ncomponents] =
+                     STRDUP(tmp))) {
+            FREE(tmp);
+            FREE(object->comp_names[object->ncomponents]);
+            API_ERROR(NULL, E_NOMEM);
+        }
+        if (!db_IncObjectComponentCount(object))
         {
-            DBClose(dbfile);
-            API_RETURN(hasobjects);
+            FREE(tmp);
+            API_ERROR(NULL, E_NOMEM);
         }
- 
-        API_RETURN(0);
+        FREE(tmp);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END;
+
+    return(0);
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                               DBInqVarExists
+/*-------------------------------------------------------------------------
+ * Function:    DBShowErrors
  *
- *  Purpose
+ * Purpose:     Set the method by which errors are displayed.  The
+ *              `level' parameter is one of the following:
  *
- *      Determine if the given variable object exists in the SILO file.
- *      Return non-zero if it does and 0 if it doesn't.
+ *                 DB_ALL       -- Show all errors, beginning with the
+ *                                 routine that first detected the error
+ *                                 and continuing up the call stack to
+ *                                 the application.
  *
- *  Programmer
+ *                 DB_ABORT     -- Same as DB_ALL except abort() is called
+ *                                 after the error message is printed.
  *
- *      Sean Ahern, Thu Jul 20 11:53:40 PDT 1995
+ *                 DB_TOP       -- (default) Only the top-level API functions
+ *                                 issue error messages.
  *
- *  Modifications
- *    Mon Aug 28 11:15:21 PDT 1995
- *    (ahern) Changed the API_BEGIN to API_BEGIN2.
+ *                 DB_NONE      -- The library does not handle error messages.
+ *                                 The application is responsible for
+ *                                 checking the API return values and
+ *                                 handling the error.
  *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
- *--------------------------------------------------------------------*/
-PUBLIC int
-DBInqVarExists(DBfile *dbfile, const char *varname)
-{
-    int retval;
-
-    API_BEGIN2("DBInqVarExists", int, 0, varname) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (!varname || !*varname)
-            API_ERROR("variable name", E_BADARGS);
-        if (dbfile->pub.exist == NULL)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        retval = (dbfile->pub.exist) (dbfile, varname);
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /* BEWARE: If API_RETURN above is removed use API_END */
-}
-
-/*-------------------------------------------------------------------------
- * Function:    DBForceSingle
+ *                 DB_SUSPEND   -- This is used internally to temporarily
+ *                                 suspend the issuance of error messages
+ *                                 by the calling thread, as though the
+ *                                 error level were DB_NONE.
  *
- * Purpose:     If 'status' is non-zero, then any 'datatype'd arrays are
- *              converted on read from whatever their native datatype is to
- *              float. A 'datatype'd array is an array that is part of some
- *              Silo object containing a 'datatype' member which indicates
- *              the type of data in the array. So, for example, a DBucdvar
- *              has a 'datatype' member to indicate the type of data in the
- *              var and mixvar arrays. Such arrays will be converted on read
- *              if 'status' here is non-zero. However, a DBmaterial object 
- *              is ALWAYS integer data. There is no 'datatype' member for
- *              such an object and so its data will NEVER be converted to
- *              float on read regardless of force single status set here.
+ *                 DB_RESTORE   -- This is used internally to restore the
+ *                                 previous error level after a DB_SUSPEND.
  *
- *              I believe this function's original intention was to convert
- *              only double precision arrays to single precision. However,
- *              the PDB driver was apparently never designed that way and
- *              the PDB driver's behavior sort of established the defacto
- *              meaning of force single. So, now, as of Silo version 4.8
- *              the HDF5 driver obeys it as well. Though, in fact the HDF5
- *              driver was originally written to support the original
- *              intention of force single status and it worked in this
- *              ('buggy') fashion for many years before we started
- *              encountering real problems with it in VisIt.
+ *              The `func' parameter can point to an application-level
+ *              error handling function that will be passed a string that
+ *              is part of the error message (similar to the argument for
+ *              perror()).  If the function pointer is null, then
+ *              the library will issue error messages to the standard
+ *              error stream.
  *
- * Return:      Success:        0 if all drivers succeeded or did not
- *                              implement this function.
+ *              The error text and erring function name can
+ *              be obtained by calling DBErrString() or DBErrFunc().
  *
- *              Failure:        -1 if any driver returned failure.
+ * Return:      void
  *
  * Programmer:  matzke@viper
- *              Tue Jan 10 11:01:24 PST 1995
+ *              Mon Nov  7 09:58:43 PST 1994
  *
  * Modifications:
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *    Robb Matzke, Mon Dec 12 14:25:04 EST 1994
+ *    Added DB_SUSPEND and DB_RESUME in order to get
+ *    db_unk_Open to work properly [the Open callback for
+ *    the SILO-Unknown driver].
+ *
+ *    Eric Brugger, Tue Feb  7 09:06:58 PST 1995
+ *    I modified the function declaration and changed the default error
+ *    reporting level to DB_NONE.
+ *
+ *    Eric Brugger, Wed Mar  1 17:07:39 PST 1995
+ *    I shrouded the prototypes for non-ansi compilers.
+ * 
+ *    Hank Childs, Thu Mar  2 13:34:35 PST 2000
+ *    Add check to ensure that nested DBShowErrors to suspend error 
+ *    messages would work correctly.
+ *
+ *    DB_SUSPEND/DB_RESUME now keep a per-thread nesting count instead of
+ *    overwriting the library-wide levels. DB_ERR_LEVEL reports DB_NONE
+ *    while the calling thread is suspended. This also stops a suspend
+ *    from losing the driver error level.
  *
- *    Mark C. Miller, Fri Jul 16 19:28:23 PDT 2010
- *    Updated 'Purpose' above to reflect current understanding of the
- *    meaning of force single.
  *-------------------------------------------------------------------------*/
-PUBLIC int
-DBForceSingle(int status)
+#warning ADD DBSHOWERRORSFILE
+PUBLIC void
+DBShowErrors(int level, void(*func)(char*))
 {
-    int            i;
-
-    API_BEGIN("DBForceSingle", int, -1) {
-        for (i = 0; i < DB_NFORMATS; i++) {
-            if (DBFSingleCB[i]) {
-                if (((DBFSingleCB[i]) (status)) < 0) {
-                    char           dname[32];
+#warning GET RID OF SUSPEND/RESUME STUFF
+    switch (level) {
+        case DB_SUSPEND:
+            db_err_suspended++;
+            return;
+        case DB_RESUME:
+            if (db_err_suspended > 0)
+                db_err_suspended--;
+            return;
+    }
 
-                    sprintf(dname, "driver-%d", i);
-                    API_ERROR(dname, E_CALLFAIL);
-                }
-            }
-        }
+    SILO_Globals._db_err_level_drvr = DB_NONE;
+    if (level == DB_ALL_AND_DRVR)
+    {
+        level = DB_ALL;
+	SILO_Globals._db_err_level_drvr = DB_ALL;
     }
-    API_END;
 
-    return(0);
+    switch (level) {
+        default:
+            SILO_Globals._db_err_level = level;
+            SILO_Globals._db_err_func = func;
+            break;
+    }
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBMakeOptlist
+/*-------------------------------------------------------------------------
+ * Function:    DBErrString
  *
- *  Purpose
+ * Purpose:     Return the error message of the last error.
  *
- *      Allocate an option list of the requested length and initialize it.
+ * Return:      Success:        ptr to static error message
  *
- *  Programmer
+ *              Failure:        ptr to static message for db_errno=0
  *
- *      Jeffery W. Long, NSSD-B
+ * Programmer:  robb@cloud
+ *              Tue Feb 21 08:23:48 EST 1995
  *
- *  Modified
- *    Robb Matzke, Tue Nov 8 06:58:04 PST 1994
- *    Added error mechanism
- *--------------------------------------------------------------------*/
-PUBLIC DBoptlist *
-DBMakeOptlist(int maxopts)
+ * Modifications:
+ *-------------------------------------------------------------------------*/
+PUBLIC char const *
+DBErrString(void)
 {
-    DBoptlist     *optlist = NULL;
+    static SILO_THREAD_LOCAL char s[128];
 
-    API_BEGIN("DBMakeOptlist", DBoptlist *, NULL) {
-        if (maxopts <= 0)
-            API_ERROR("maxopts", E_BADARGS);
-        optlist = ALLOC(DBoptlist);
-        if (!optlist) API_ERROR(NULL, E_NOMEM);
-        optlist->options = ALLOC_N(int, maxopts);
-        optlist->values = ALLOC_N(void *, maxopts);
+    if (db_errno < 0 || db_errno >= NELMTS(_db_err_list)) {
+        sprintf(s, "Error %d", db_errno);
+        return s;
+    }
 
-        if (!optlist->options || !optlist->values)
-        {
-            FREE(optlist->values);
-            FREE(optlist->options);
-            FREE(optlist);
-            API_ERROR(NULL, E_NOMEM);
-        }
+    return _db_err_list[db_errno];
+}
 
-        optlist->numopts = 0;
-        optlist->maxopts = maxopts;
+PUBLIC int
+DBErrno(void)
+{
+    return db_errno;
+}
 
-        API_RETURN(optlist);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+PUBLIC char const *
+DBErrFuncname(void)
+{
+    return db_errfunc;
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBFreeOptlist
- *
- *  Purpose
- *
- *      Release the storage associated with the given optlist list.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns 0 on success, -1 on failure.
- *
- *  Modified
- *    Robb Matzke, Tue Nov 8 07:56:34 PST 1994
- *    Added error mechanism.
- *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
- *--------------------------------------------------------------------*/
-PUBLIC int
-DBFreeOptlist(DBoptlist *optlist)
+PUBLIC DBErrFunc_t
+DBErrfunc(void)
 {
-    API_BEGIN("DBFreeOptlist", int, -1) {
-        if (!optlist || optlist->numopts < 0) {
-            API_ERROR("optlist pointer", E_BADARGS);
-        }
-        FREE(optlist->options);
-        FREE(optlist->values);
-        FREE(optlist);
-    }
-    API_END;
+    return SILO_Globals._db_err_func;
+}
 
-    return(0);
+PUBLIC int
+DBErrlvl(void)
+{
+    return DB_ERR_LEVEL;
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBClearOptlist
- *
- *  Purpose
- *
- *      Remove all options from the given optlist and reset counters.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
- *
- *  Returns
- *
- *      Returns OKAY on success, OOPS on failure.
+/*-------------------------------------------------------------------------
+ * Function: db_parse_version_digits_from_string
  *
- *  Modified
- *    Robb Matzke, Tue Nov 8 07:48:52 PST 1994
- *    Added error mechanism.
+ * str: version string
+ * sep: separator character (typically '.')
+ * digits: array of digits to return
+ * ndigits: size of digits array
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
- *--------------------------------------------------------------------*/
-PUBLIC int
-DBClearOptlist(DBoptlist *optlist)
+ * returns 0 on successful conversion, non-zero on failure
+ *-----------------------------------------------------------------------*/
+static int
+db_parse_version_digits_from_string(char const *str, char sep, int *digits, int ndigits)
 {
-    int            i;
+    int i, nseps, non_digits, retval = 0;
+    char *p, *ostr;
+    
+    if (!str || !*str)
+        return 1;
 
-    API_BEGIN("DBClearOptlist", int, -1) {
-        if (!optlist || optlist->numopts < 0) {
-            API_ERROR("optlist pointer", E_BADARGS);
-        }
+    ostr = strdup(str);
+    p = ostr;
 
-        /* Reset values, but do not free */
-        for (i = 0; i < optlist->maxopts; i++) {
-            optlist->options[i] = 0;
-            optlist->values[i] = (void *)NULL;
+    /* Examine string for seperator chars and non-digits */
+    nseps = 0;
+    non_digits = 0;
+    while (*p)
+    {
+        if (*p == sep)
+        {
+            *p = '\0';
+            nseps++;
+        }
+        else if (!strncmp(p, "-pre", 4) ||
+                 !strncmp(p, "-pos", 4))
+        {
+            *(p+0) = '\0';
+            *(p+1) = '0';
+            *(p+2) = '0';
+            *(p+3) = '0';
+            nseps++;
+            p += 3;
+        }
+        else if (*p < '0' || *p > '9')
+        {
+            non_digits = 1;
         }
+        p++;
+    }
+    nseps++;
 
-        optlist->numopts = 0;
+    /* Make a second pass over string converting all the digits */
+    if (!non_digits)
+    {
+        p = ostr;
+        errno = 0;
+        for (i = 0; i < ndigits; i++)
+            digits[i] = 0;
+        for (i = 0; i < nseps && ndigits && errno == 0; i++, ndigits--)
+        {
+            digits[i] = strtol(p, 0, 10);
+            while (*p != '\0') p++;
+            p++;
+        }
+        if (errno)
+            retval = 1;
+    }
+    else
+    {
+        retval = 1;
     }
-    API_END;
 
-    return(0);
+    free(ostr);
+
+    return retval;
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                  DBAddOption
+static int
+db_compare_version_digits(int const *a_digits, int const *b_digits, int ndigits)
+{
+    int i;
+    for (i = 0; i < ndigits; i++)
+    {
+        if (a_digits[i] < b_digits[i])
+            return -1;
+        else if (a_digits[i] > b_digits[i])
+            return 1;
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBVersion
  *
- *  Purpose
+ * Purpose:     Return the version number of the library as a string.
  *
- *      Add an option to the given option list structure.
+ * Returns:     ptr to version number
  *
- *  Programmer
+ * Programmer:  Hank Childs
+ *              Tue Oct 17 14:08:45 PDT 2000
  *
- *      Jeffery W. Long, NSSD-B
+ * Modifications:
  *
- *  Returns
+ *   Mark C. Miller, Tue Oct 24 12:39:31 PDT 2006
+ *   Changed to use SILO_VSTRING
+ *-------------------------------------------------------------------------*/
+PUBLIC char const *
+DBVersion(void)
+{
+    static char version[256];
+    strcpy(version, SILO_VSTRING);
+
+    return version;
+}
+
+PUBLIC int
+DBVersionDigits(int *maj, int *min, int *pat, int *pre)
+{
+    int digits[4] = {0,0,0,0};
+
+    if (!db_parse_version_digits_from_string(DBVersion(), '.',
+             digits, sizeof(digits)/sizeof(digits[0])))
+    {
+        if (maj) *maj = digits[0];
+        if (min) *min = digits[1];
+        if (pat) *pat = digits[2];
+        if (pre) *pre = digits[3];
+        return 0;
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBVersionGE
  *
- *      Returns OKAY on success, OOPS on failure.
+ * Purpose:     Return whether or not the version of the library is greater
+ *              than or equal to the version specified by Maj, Min, Pat.
+ *              This is a run-time equiv. of the SILO_VERSION_GE macro.
  *
- *  Modified:
- *    Robb Matzke, Tue Nov 8 07:00:55 PST 1994
- *    Added error mechanism.  Returns -1 on failure, 0 on success.
+ * Returns:     integer indicating if true (1) or false (0) 
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
- *--------------------------------------------------------------------*/
+ * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
+ *-------------------------------------------------------------------------*/
+PUBLIC int 
+DBVersionGE(int Maj, int Min, int Pat)
+{
+    int a_digits[3] = {SILO_VERS_MAJ, SILO_VERS_MIN, SILO_VERS_PAT};
+    int b_digits[3] = {Maj<0?0:Maj, Min<0?0:Min, Pat<0?0:Pat};
+    return db_compare_version_digits(a_digits, b_digits, 3) >= 0;
+}
+
 PUBLIC int
-DBAddOption(DBoptlist *optlist, int option, void *value)
+DBVersionGEFileVersion(const DBfile *dbfile)
 {
-    API_BEGIN("DBAddOption", int, -1) {
-        if (!optlist)
-            API_ERROR("optlist pointer", E_BADARGS);
-        if (optlist->numopts >= optlist->maxopts)
-            API_ERROR("optlist nopts", E_BADARGS);
-
-        optlist->options[optlist->numopts] = option;
-        optlist->values[optlist->numopts] = value;
-        optlist->numopts++;
-
-        if (optlist->numopts >= optlist->maxopts)
-        {
-            int new_maxopts = optlist->maxopts * 1.5 + 1; /* golden rule + 1 */
-            int *new_options = REALLOC_N(optlist->options, int, new_maxopts);
-            void **new_values = REALLOC_N(optlist->values, void*, new_maxopts);
-
-            if (!new_options || !new_values)
-            {
-                FREE(new_options);
-                FREE(new_values);
-                API_ERROR(0, E_NOMEM);
-            }
+    int a_digits[3];
+    int b_digits[3] = {4, 5, 0}; /* earliest version we have version info in file */
+    DBVersionDigits(&a_digits[0], &a_digits[1], &a_digits[2], 0);
+    DBFileVersionDigits(dbfile, &b_digits[0], &b_digits[1], &b_digits[2], 0);
+    return db_compare_version_digits(a_digits, b_digits, 3) >= 0;
+}
 
-            optlist->maxopts = new_maxopts;
-            optlist->options = new_options;
-            optlist->values  = new_values;
-        }
+/*-------------------------------------------------------------------------
+ * Function:    DBFileVersion
+ *
+ * Purpose:     Return the version number of the library that created the
+ *              given file as a string.
+ *
+ * Returns:     ptr to version number
+ *
+ * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
+ *-------------------------------------------------------------------------*/
+PUBLIC char const *
+DBFileVersion(const DBfile *dbfile)
+{
+    static char version[256];
+    if (dbfile->pub.file_lib_version)
+        strcpy(version, dbfile->pub.file_lib_version);
+    else
+        strcpy(version, "unknown; 4.5 or older");
+    return version;
+}
 
+PUBLIC int
+DBFileVersionDigits(const DBfile *dbfile, int *maj, int *min, int *pat, int *pre)
+{
+    int digits[4] = {0,0,0,0};
+    if (!db_parse_version_digits_from_string(DBFileVersion(dbfile), '.',
+             digits, sizeof(digits)/sizeof(digits[0])))
+    {
+        if (maj) *maj = digits[0];
+        if (min) *min = digits[1];
+        if (pat) *pat = digits[2];
+        if (pre) *pre = digits[3];
+        return 0;
     }
-    API_END;
-
-    return(0);
+    return -1;
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBClearOption
- *
- *  Purpose
- *
- *      Remove a given option from the given optlist and re-order
- *      the remaining options.
+/*-------------------------------------------------------------------------
+ * Function:    DBFileVersionGE
  *
- *  Programmer
+ * Purpose:     Return whether or not the given file was created with a 
+ *              version of the library greater than or equal to the
+ *              version specified by Maj, Min, Pat 
  *
- *      Mark C. Miller, August 18, 2005 
+ * Returns:     1 if file version is greather than or equal to Maj/Min/Pat
+ *              0 if file version is less than Maj/Min/Pat
+ *             -1 if unable to determine.
  *
- *--------------------------------------------------------------------*/
+ * Programmer:  Mark C. Miller, Mon Jan 12 20:59:30 PST 2009
+ *-------------------------------------------------------------------------*/
 PUBLIC int
-DBClearOption(DBoptlist *optlist, int option)
+DBFileVersionGE(const DBfile *dbfile, int Maj, int Min, int Pat)
 {
-    int            i, j, foundit=0;
+    int retval = -1;
+    int unknown = 0;
+    int a_digits[3];
+    int b_digits[3] = {Maj<0?0:Maj, Min<0?0:Min, Pat<0?0:Pat};
+    char *version = STRDUP(DBFileVersion(dbfile));
 
-    API_BEGIN("DBClearOption", int, -1) {
-        if (!optlist || optlist->numopts < 0) {
-            API_ERROR("optlist pointer", E_BADARGS);
+    if (strncmp(version, "unknown", 7) == 0)
+    {
+        /* We started maintaining library version information in the file
+           in version 4.5.1. So, if it is 'unknown', we can return something
+           useful ONLY if the version we're comparing against is 4.5.1 or
+           greater. */
+        a_digits[0] = 4;
+        a_digits[1] = 5;
+        a_digits[2] = 0;
+        unknown = 1;
+    }
+    else
+    {
+        if (db_parse_version_digits_from_string(version, '.',
+                 a_digits, sizeof(a_digits)/sizeof(a_digits[0])))
+        {
+            free(version);
+            return -1;
         }
+    }
 
-        /* Shift values down in list by one entry */
-        for (i = 0; i < optlist->numopts; i++) {
-            if (optlist->options[i] == option) {
-                foundit = 1;
-                for (j = i; j < optlist->numopts-1; j++) {
-                    optlist->options[j] = optlist->options[j+1];
-                    optlist->values[j]  = optlist->values[j+1];
-                }
-                break;
-            }
-        }
+    free(version);
 
-        if (foundit) {
-            optlist->numopts--;
-            optlist->options[optlist->numopts] = 0;
-            optlist->values[optlist->numopts]  = 0;
-        }
+    retval = db_compare_version_digits(a_digits, b_digits, 3) >= 0; 
+
+    if (unknown)
+    {
+        if (retval)
+            retval = -1;
     }
-    API_END;
 
-    return(0);
+    return retval;
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBGetOption
- *
- *  Purpose
- *
- *      Return value set for a given option from the given optlist.
- *
- *  Programmer
- *
- *      Mark C. Miller, August 18, 2005 
+/*-------------------------------------------------------------------------
+ * Function:    DBFileName
  *
- *  Modifications:
+ * Purpose:     Return the name of the associated file.
  *
- *      Mark C. Miller, Wed Jul 14 20:35:50 PDT 2010
- *      Replaced 'return' with 'API_RETURN'
+ * Returns:     ptr to string holding the name of the file or "unknown".
  *
- *      Mark C. Miller, Tue Aug 10 23:49:51 PDT 2010
- *      Removed API_BEGIN/END stuff so that function can be handed
- *      a null optlist and it will behave well.
- *--------------------------------------------------------------------*/
-PUBLIC void * 
-DBGetOption(const DBoptlist *optlist, int option)
+ * Programmer:  Mark C. Miller, Tue May 24 12:45:53 PDT 2016
+ *-------------------------------------------------------------------------*/
+PUBLIC char const *
+DBFileName(const DBfile *dbfile)
 {
-    int            i;
+    static SILO_THREAD_LOCAL char name[256];
+    if (dbfile->pub.name)
+        strcpy(name, dbfile->pub.name);
+    else
+        strcpy(name, "unknown");
+    return name;
+}
 
-    if (!optlist) return 0;
+static void
+db_InitFileGlobals(DBfile *dbfile)
+{
+    int i;
 
-    /* find the given option in the optlist and return its value */
-    for (i = 0; i < optlist->numopts; i++)
-        if (optlist->options[i] == option)
-            return optlist->values[i];
+    dbfile->pub.file_scope_globals = (SILO_Globals_t*) malloc(sizeof(SILO_Globals_t));
+    /* since most entries are ints and we want to init them to the NOT-SET value
+       this call averts *some* mistakes where SILO_Globals_t might get updated with
+       new int members but failed to be explicitly initialize here. Setting to all
+       0xFF has effect of setting all ints to -1, the DB_INTBOOL_NOT_SET value. */
+    memset(dbfile->pub.file_scope_globals, 0xFF, sizeof(SILO_Globals_t));
 
-    return 0;
+    /* Initialize to NOT-SET values so that, initially, a file is set to
+       inheret *and* track all behaviors from Silo's globals. The first time
+       any of these values are changed to a NOT_SET value, then forevermore, 
+       that particular behavior for the file */
+    dbfile->pub.file_scope_globals->dataReadMask            = DB_MASK_NOT_SET;
+    dbfile->pub.file_scope_globals->allowOverwrites         = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->allowEmptyObjects       = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->enableChecksums         = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->enableFriendlyHDF5Names = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->enableGrabDriver        = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->darshanEnabled          = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->allowLongStrComponents  = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->maxDeprecateWarnings    = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->compressionMinratio     = DB_FLOAT_NOT_SET;
+#warning CORRECT INITIALIZATION OF compressionErrmode
+    dbfile->pub.file_scope_globals->compressionErrmode      = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->compatabilityMode       = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->compressionParams       = DB_CHAR_PTR_NOT_SET;
+    dbfile->pub.file_scope_globals->compressionPolicy       = 0;
+    dbfile->pub.file_scope_globals->_db_err_level           = DB_INTBOOL_NOT_SET;
+    dbfile->pub.file_scope_globals->_db_err_func            = DB_VOID_PTR_NOT_SET;
+    dbfile->pub.file_scope_globals->_db_err_level_drvr      = DB_INTBOOL_NOT_SET;
+
+    dbfile->pub.file_scope_globals->allocFunc               = (DBAllocFunc_t) DB_VOID_PTR_NOT_SET;
+    dbfile->pub.file_scope_globals->freeFunc                = (DBFreeFunc_t) DB_VOID_PTR_NOT_SET;
+    dbfile->pub.file_scope_globals->allocClientData         = 0;
+
+    /* Jstk only relevant for lib as a whole, not specific to a file */
+    dbfile->pub.file_scope_globals->Jstk = 0;
+
+    for (i = 0; i < MAX_FILE_OPTIONS_SETS; i++)
+        dbfile->pub.file_scope_globals->fileOptionsSets[i] = 0;
 }
 
 /*-------------------------------------------------------------------------
- * Function:    DBGetToc
+ * Function:    DBOpen
  *
- * Purpose:     Return a pointer to table of contents of the file.  Note
- *              that the pointer is the same as the one in the DBfile
- *              so it should not be modified and may become invalid after
- *              calling the next silo routine.
+ * Purpose:     Open a data file.
  *
- * Return:      Success:        Pointer to the table of contents structure.
+ * Return:      Success:        pointer to new file descriptor
  *
  *              Failure:        NULL
  *
  * Programmer:  matzke@viper
- *              Mon Nov  7 10:35:47 PST 1994
+ *              Mon Nov  7 10:25:08 PST 1994
  *
  * Modifications:
- *    Eric Brugger, Fri Jan 27 08:23:43 PST 1995
- *    I changed the interface and function of the routine.
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *-------------------------------------------------------------------------*/
-PUBLIC DBtoc  *
-DBGetToc(DBfile *dbfile)
-{
-    API_BEGIN2("DBGetToc", DBtoc *, NULL, api_dummy) {
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("", E_GRABBED) ; 
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-
-        DBNewToc(dbfile);
-        API_RETURN(dbfile->pub.toc);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
-}
-
-/*-------------------------------------------------------------------------
- * Function:    DBInqVarType
+ *    Robb Matzke, Tue Feb 28 10:51:19 EST 1995
+ *    When a file is opened, it is given a unique ID number wrt all other
+ *    open files.  The ID is a small integer [0..DB_NFILES-1].
  *
- * Purpose:     Return the DBObjectType for a given object name
+ *    Robb Matzke, Tue Feb 28 11:38:08 EST 1995
+ *    For each registered filter, call the non-null `init' functions for
+ *    every file that is opened.
  *
- * Return:      Success:        the ObjectType for the given object
+ *    Sean Ahern, Mon Jan  8 17:38:18 PST 1996
+ *    Added the mode parameter.
  *
- *              Failure:        DB_INVALID_OBJECT
+ *    Lisa J. Nafziger, Wed Mar  6 10:20:48 PST 1996
+ *    Added code to check for file existence, to check if it is a
+ *    directory and to check for read permission.  This allows more
+ *    specific error messages to be returned.
  *
- * Programmer:  Sean Ahern,
- *              Wed Oct 28 14:46:53 PST 1998
+ *    Lisa J. Nafziger, Tue Mar 12 14:15:06 PST 1996
+ *    Modified code to check file attributes so that stat() rather
+ *    than access() is used.  The former is POSIX compliant.
  *
- * Modifications:
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ *    Eric Brugger, Tue Jun 17 10:25:57 PDT 1997
+ *    I modified the routine to only check file validity if the type
+ *    is not an SDX connection.
+ *
+ *    Jeremy Meredith, Fri Jul 23 09:31:14 PDT 1999
+ *    I added error reporting to the result of stat().
+ *
+ *    Jeremy Meredith, Mon Jul 26 10:39:49 PDT 1999
+ *    Made stat() error reporting POSIX.1 compliant.
+ *
+ *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
+ *    Renamed the function to DBOpenReal.  Client code now calls a macro
+ *    called DBOpen.
+ *
+ *    Mark C. Miller, Wed Feb  2 07:59:53 PST 2005
+ *    Added printing of error message from stat() with strerror
+ *
+ *    Mark C. Miller, Wed Feb 23 08:51:35 PST 2005
+ *    Added code to reset _db_fstatus slot to 0 if open fails
+ *
+ *    Thomas R. Treadway, Tue Jun 27 13:59:21 PDT 2006
+ *    Added HAVE_STRERROR wrappers
  *
  *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *-------------------------------------------------------------------------*/
-PUBLIC DBObjectType
-DBInqVarType(DBfile *dbfile, char const *varname)
+ *    Added code to register the returned file pointer
+ *
+ *    Mark C. Miller, Mon Jan 12 20:50:41 PST 2009
+ *    Removed DB_SDX conditionally compiled code blocks.
+ *
+ *    Mark C. Miller, Wed Feb 25 23:50:06 PST 2009
+ *    Moved call to db_isregistered_file to AFTER calls to stat the file
+ *    add changed db_isregistered_file to accept stat struct instead of name.
+ *    Changed call to db_register_file to accpet stat struct.
+ *
+ *    Mark C. Miller, Fri Feb 12 08:22:41 PST 2010
+ *    Replaced stat/stat64 calls with db_silo_stat. Replaced conditional
+ *    compilation logic for SIZEOF_OFF64_T with db_silo_stat_struct.
+ *
+ *    Count the file's I/O from the start of the open in its statistics.
+ *------------------------------------------------------------------------- */
+PUBLIC DBfile *
+DBOpenReal(const char *name, int type, int mode)
 {
-    DBObjectType retval;
+    char           ascii[16];
+    DBfile        *dbfile;
+    int            fileid, i;
+    int            origtype = type;
+    int            opts_set_id;
+    db_silo_stat_t filestate;
+    DBfilestats   *stats;
 
-    API_BEGIN2("DBInqVarType", DBObjectType, DB_INVALID_OBJECT, api_dummy) {
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("", E_GRABBED) ; 
-        if (!dbfile)
+    API_BEGIN("DBOpen", DBfile *, NULL) {
+        if (DB_NOBJ_TYPES != _db_nobj_types)
+            API_ERROR("Silo TOC not configured corretly", E_INTERNAL);
+
+        if (!name)
             API_ERROR(NULL, E_NOFILE);
-        if (!varname || !*varname)
-            API_ERROR("variable name", E_BADARGS);
-        if (!dbfile->pub.inqvartype)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
 
-        retval = (dbfile->pub.inqvartype) (dbfile, varname);
-        API_RETURN(retval);
+        /* deal with extended driver type specifications */
+        db_DriverTypeAndFileOptionsSetId(origtype, &type, &opts_set_id);
+
+        if (type < 0 || type >= DB_NFORMATS) {
+            sprintf(ascii, "%d", type);
+            API_ERROR(ascii, E_BADFTYPE);
+        }
+        if ((mode != DB_READ) && (mode != DB_APPEND))
+        {
+            sprintf(ascii, "%d", mode);
+            API_ERROR(ascii, E_BADARGS);
+        }
+        if (!DBOpenCB[type]) {
+            sprintf(ascii, "%d", type);
+            API_ERROR(ascii, E_NOTIMP);
+        }
+        DB_API_LOCK_DRIVERS(type);
+
+        /****************************************************/
+        /* Check to make sure the file exists and has the   */
+        /* correct permissions.                             */
+        /****************************************************/
+        if (db_silo_stat(name, &filestate, type==DB_UNKNOWN?-1:opts_set_id) != 0)
+        {
+            if( errno == ENOENT )
+            {
+                /********************************/
+                /* File doesn't exist.          */
+                /********************************/
+                API_ERROR((char *)name, E_NOFILE);
+            }
+            else
+            {
+                /********************************/
+                /* System level error occured.  */
+                /********************************/
+#if SIZEOF_OFF64_T > 4
+                printf("stat64() failed with error: ");
+#else
+                printf("stat() failed with error: ");
+#endif
+                switch (errno)
+                {
+                  case EACCES:       printf("EACCES\n");       break;
+                  case EBADF:        printf("EBADF\n");        break;
+                  case ENAMETOOLONG: printf("ENAMETOOLONG\n"); break;
+                  case ENOTDIR:      printf("ENOTDIR\n");      break;
+#ifdef EOVERFLOW
+                  case EOVERFLOW:    
+#ifdef HAVE_STRERROR
+                                     printf("EOVERFLOW: \"%s\"\n", 
+                                        strerror(errno));
+#else
+                                     printf("EOVERFLOW: errno=%d\n", errno);
+#endif
+                                     printf("Silo may need to be re-compiled with "
+                                            "Large File Support (LFS)\n");
+                                     break;
+#endif
+                  default:           
+#ifdef HAVE_STRERROR
+                                     printf("\"%s\"\n",
+                                        strerror(errno));
+#else
+                                     printf("errno=%d\n", errno);
+#endif
+                                     break;
+                }
+                API_ERROR((char *)name, E_SYSTEMERR);
+            }
+        }
+
+        /* Check if file is already opened. If so, none can
+           have it opened for write, including this new one */ 
+        i = db_isregistered_file(0, &filestate);
+        if (i != -1)
+        {
+            if (i != 0 || mode != DB_READ)
+                API_ERROR(name, E_CONCURRENT);
+        }
+
+        if( ( filestate.s.st_mode & S_IFDIR ) != 0 )
+        {
+            /************************************/
+            /* File is actually a directory.    */
+            /************************************/
+            API_ERROR((char *)name, E_FILEISDIR);
+        }
+        if( ( filestate.s.st_mode & S_IREAD ) == 0 )
+        {
+            /****************************************/
+            /* File is missing read permissions.    */
+            /****************************************/
+            API_ERROR((char *)name, E_FILENOREAD);
+        }
+        if (DB_READ!=mode && (filestate.s.st_mode & S_IWUSR) == 0)
+        {
+            /****************************************/
+            /* File is open for write and missing write permission. */
+            /****************************************/
+            API_ERROR((char *)name, E_FILENOWRITE);
+        }
+
+        if ((fileid = db_get_fileid(DB_ISOPEN)) < 0)
+            API_ERROR((char *)name, E_MAXOPEN);
+        stats = db_stats_open(&jsid, me, &jt0);
+        if (NULL == (dbfile = (DBOpenCB[type]) (name, mode, opts_set_id)))
+        {
+            db_stats_close(stats);
+            db_release_fileid(fileid);
+            API_RETURN(NULL);
+        }
+        dbfile->pub.stats = stats;
+        dbfile->pub.fileid = fileid;
+        db_InitFileGlobals(dbfile);
+        db_register_file(dbfile, &filestate, mode!=DB_READ);
+
+        /*
+         * Install filters.  First, all `init' filters, then the
+         * specified filters.
+         */
+        for (i = 0; i < DB_NFILTERS; i++) {
+            if (_db_filter[i].name && _db_filter[i].init) {
+                (void)(_db_filter[i].init) (dbfile, _db_filter[i].name);
+            }
+        }
+        db_filter_install(dbfile);
+        if (DBInqVarExists(dbfile, SILO_VSTRING_NAME))
+            dbfile->pub.file_lib_version = (char*)DBGetVar(dbfile, SILO_VSTRING_NAME);
+        API_RETURN(dbfile);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
 /*-------------------------------------------------------------------------
- * Function:    DBNewToc
+ * Function:    DBCreateReal
  *
- * Purpose:     Used to be called `DBGetToc', this function installs a
- *              new table of contents in the specified file from that
- *              file's current working directory.  The old table of contents
- *              is destroyed.
+ * Purpose:     Create a data file
  *
- * Return:      Success:        0
+ * Return:      Success:        pointer to file descriptor
  *
- *              Failure:        -1
+ *              Failure:        NULL
  *
- * Programmer:  robb@cloud
- *              Tue Mar  7 10:26:23 EST 1995
+ * Programmer:  matzke@viper
+ *              Mon Nov  7 10:29:23 PST 1994
  *
  * Modifications:
- *              Robb Matzke, 2000-05-23
- *              If nothing has changed then this function just returns
- *              success, leaving the original table of contents in place.
- *              Any function that potentially changes the table of
- *              contents should call db_FreeToc() on the file handle.
- *-------------------------------------------------------------------------*/
-PUBLIC int
-DBNewToc(DBfile *dbfile)
-{
-    int retval;
-
-    API_BEGIN("DBNewToc", int, -1) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("", E_GRABBED) ; 
-        if (!dbfile->pub.newtoc)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        if (dbfile->pub.toc)
-            API_RETURN(0);
-        retval = (dbfile->pub.newtoc) (dbfile);
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
-}
-
-/*
-This logic is necessary to support callers accessing standard (e.g. non-DB_USERDEF)
-objects via the generic interface to ensure logic for specially handled component
-values is consistent with the standard object's DBGetXXX methods.
-To ensure a zero for the component in the file means either not-present or
-not-set, certain components, especially those for which a zero value is a valid
-value for the data producer to use, special handling is required and that logic
-is sprinkled about in the DBPutXXX and DBGetXXX methods of the drivers and so
-to is it required here. Its a nasty maintenance issue.
-*/
-
-static int
-db_IsComponentNameStandardWithSpecialHandling(char const *compname)
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Robb Matzke, Tue Feb 28 10:57:06 EST 1995
+ *    A file ID is assigned to the new file.
+ *
+ *    Robb Matzke, 15 May 1996
+ *    Removed the unused `statue' auto variable.
+ *
+ *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
+ *    Renamed the function to DBCreateReal.  Client code now calls a macro
+ *    called DBCreate.
+ *
+ *    Mark C. Miller, Wed Feb 23 08:51:35 PST 2005
+ *    Added code to reset _db_fstatus slot to 0 if create fails
+ *
+ *    Mark C. Miller, Wed Apr  5 10:17:31 PDT 2006
+ *    Added code to output silo library version string to the file
+ *
+ *    Mark C. Miller, Mon Nov 19 10:45:05 PST 2007
+ *    Added hdf5 driver warning.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Added code to register the returned file pointer
+ *
+ *    Mark C. Miller, Mon Nov 17 19:04:39 PST 2008
+ *    Added code to check to see if name is a directory.
+ *
+ *    Mark C. Miller, Wed Feb 25 23:52:05 PST 2009
+ *    Moved call to db_isregistered_file to after stat calls. Stat the
+ *    file after its created so we can get information to register it.
+ *
+ *    Mark C. Miller, Fri Feb 12 08:22:41 PST 2010
+ *    Replaced stat/stat64 calls with db_silo_stat. Replaced conditional
+ *    compilation logic for SIZEOF_OFF64_T with db_silo_stat_struct.
+ *
+ *    Mark C. Miller, Thu Aug 30 17:41:24 PDT 2012
+ *    Added logic to temporarily disable any compression settings prior
+ *    to writing silo library info and then re-enabling it.
+ *
+ *    Count the file's I/O from the start of the create in its statistics.
+ *-------------------------------------------------------------------------*/
+PUBLIC DBfile *
+DBCreateReal(const char *name, int mode, int target, const char *info, int type)
 {
-    if (!strcmp(compname, "missing_value")) return 1;
-    if (!strcmp(compname, "topo_dim")) return 1;
-    if (!strcmp(compname, "repr_block_idx")) return 1;
-    return 0;
-}
+    char           ascii[16];
+    char           *tmpcs = 0;
+    DBfile        *dbfile;
+    int            fileid, i, n;
+    int            origtype = type;
+    int            opts_set_id = 0;
+    db_silo_stat_t filestate;
+    DBfilestats   *stats;
 
-/* For use in the DBGetComponent call */
-static void
-db_AdjustSpeciallyHandledStandardObjectComponentValue(
-    void *val_ptr, int obj_type, char const *comp_name)
-{
-    if (!val_ptr || !comp_name) return;
+    API_BEGIN("DBCreate", DBfile *, NULL) {
+        if (DB_NOBJ_TYPES != _db_nobj_types)
+            API_ERROR("Silo TOC not configured corretly", E_INTERNAL);
 
-    if (!strcmp(comp_name, "missing_value") &&
-        (obj_type == DB_UCDVAR || obj_type == DB_QUADVAR || obj_type == DB_CURVE ||
-         obj_type == DB_POINTVAR || obj_type == DB_MULTIVAR))
-    {
-        double val_for_mem, val_from_file = *((double*)val_ptr);
-        db_SetMissingValueForGet(val_for_mem, val_from_file);
-        *((double*)val_ptr) = val_for_mem;
-    }
-    else if (!strcmp(comp_name, "repr_block_idx") &&
-        (obj_type == DB_MULTIMESH || obj_type == DB_MULTIVAR ||
-         obj_type == DB_MULTIMAT || obj_type == DB_MULTIMATSPECIES))
-    {
-        int val_for_mem, val_from_file = *((int*)val_ptr);
-        val_for_mem = val_from_file - 1;
-        *((int*)val_ptr) = val_for_mem;
-    }
-    else if (!strcmp(comp_name, "topo_dim") &&
-        (obj_type == DB_MULTIMESH || obj_type == DB_UCDMESH))
-    {
-        int val_for_mem, val_from_file = *((int*)val_ptr);
-        val_for_mem = val_from_file - 1;
-        *((int*)val_ptr) = val_for_mem;
-    }
-}
+        if (!name)
+            API_ERROR(NULL, E_NOFILE);
 
-/* For use in the DBGetObject call */
-static void
-db_AdjustSpeciallyHandledStandardObjectComponentValues(DBobject *obj)
-{
-    int i, obj_type;
+        /* deal with extended driver type specifications */
+        db_DriverTypeAndFileOptionsSetId(origtype, &type, &opts_set_id);
 
-    if (!obj) return;
+        if (type < 0 || type >= DB_NFORMATS) {
+            sprintf(ascii, "%d", type);
+            API_ERROR(ascii, E_BADFTYPE);
+        }
+        DB_API_LOCK_DRIVERS(type);
 
-    obj_type = DBGetObjtypeTag(obj->type);
-    if (obj_type == DB_USERDEF) return;
+        if (db_silo_stat(name, &filestate, opts_set_id) == 0)  /* Success - File exists */
+        {
+            if (mode == DB_NOCLOBBER)
+            {
+                API_ERROR((char *)name, E_FEXIST);
+            }
+            if ((filestate.s.st_mode & S_IFDIR) != 0)
+            {
+                API_ERROR((char *)name, E_FILEISDIR);
+            }
 
-    for (i = 0; i < obj->ncomponents; i++)
-    {
-        char tmp[256];
+            /* Check if file is already opened. If so, none can
+               have it opened for write, including this new one */
+            i = db_isregistered_file(0, &filestate);
+            if (i != -1)
+            {
+                API_ERROR(name, E_CONCURRENT);
+            }
+        }
 
-        if (!strcmp(obj->comp_names[i], "missing_value") &&
-            (obj_type == DB_UCDVAR || obj_type == DB_QUADVAR || obj_type == DB_CURVE ||
-             obj_type == DB_POINTVAR || obj_type == DB_MULTIVAR))
-        {
-            double val_for_mem, val_from_file = strtod(obj->pdb_names[i]+4,0);
-            db_SetMissingValueForGet(val_for_mem, val_from_file);
-            sprintf(tmp, "'<d>%.30g'", val_for_mem);
+        if (!DBCreateCB[type]) {
+            sprintf(ascii, "%d", type);
+            if (type == 7)
+            {
+                API_ERROR(ascii, E_NOHDF5);
+            }
+            else
+            {
+                API_ERROR(ascii, E_NOTIMP);
+            }
         }
-        else if (!strcmp(obj->comp_names[i], "repr_block_idx") &&
-            (obj_type == DB_MULTIMESH || obj_type == DB_MULTIVAR ||
-             obj_type == DB_MULTIMAT || obj_type == DB_MULTIMATSPECIES))
+
+        if ((fileid = db_get_fileid(DB_ISOPEN)) < 0)
+            API_ERROR((char *)name, E_MAXOPEN);
+        stats = db_stats_open(&jsid, me, &jt0);
+        dbfile = ((DBCreateCB[type]) (name, mode, target, opts_set_id,
+                                      info));
+        if (!dbfile)
         {
-            int val_for_mem, val_from_file = (int) strtol(obj->pdb_names[i]+4,0,10);
-            val_for_mem = val_from_file - 1;
-            sprintf(tmp, "'<i>%d'", val_for_mem);
+            db_stats_close(stats);
+            db_release_fileid(fileid);
+            API_RETURN(NULL);
         }
-        else if (!strcmp(obj->comp_names[i], "topo_dim") &&
-            (obj_type == DB_MULTIMESH || obj_type == DB_UCDMESH))
+        dbfile->pub.stats = stats;
+        dbfile->pub.fileid = fileid;
+        db_InitFileGlobals(dbfile);
+        db_silo_stat(name, &filestate, opts_set_id);
+        db_register_file(dbfile, &filestate, 1);
+
+        /*
+         * Install filters.  First all `init' routines, then the specified
+         * `open' routines.
+         */
+        for (i = 0; i < DB_NFILTERS; i++) {
+            if (_db_filter[i].name && _db_filter[i].init) {
+                (void)(_db_filter[i].init) (dbfile, _db_filter[i].name);
+            }
+        }
+        db_filter_install(dbfile);
+
+        /* write silo library version information to the file */
+        /* Temporarily turn off any compression settings and then re-enable */
+        if (DBGetCompression())
         {
-            int val_for_mem, val_from_file = (int) strtol(obj->pdb_names[i]+4,0,10);
-            val_for_mem = val_from_file - 1;
-            sprintf(tmp, "'<i>%d'", val_for_mem);
+    
+            n = strlen(DBGetCompression());
+            tmpcs = ALLOC_N(char,n+1);
+            strncpy(tmpcs, DBGetCompression(), n);
+            tmpcs[n] = '\0';
+            DBSetCompression(0);
         }
-        else
+        n = strlen(SILO_VSTRING)+1;
+        DBWrite(dbfile, SILO_VSTRING_NAME, SILO_VSTRING, &n, 1, DB_CHAR);
+        dbfile->pub.file_lib_version = STRDUP(SILO_VSTRING);
+        if (tmpcs)
         {
-            continue;
+            DBSetCompression(tmpcs);
+            FREE(tmpcs);
         }
-
-        FREE(obj->pdb_names[i]);
-        obj->pdb_names[i] = STRDUP(tmp);
+        API_RETURN(dbfile);
     }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                                DBGetComponent
- *
- *  Purpose
- *
- *      Return the requested component value for the given object.
- *
- *  Programmer
- *
- *      Jeffery W. Long, NSSD-B
+/*-------------------------------------------------------------------------
+ * Function:    DBClose
  *
- *  Parameters
+ * Purpose:     Close the specified data file and return NULL.
  *
- *      dbfile           {In}    {Pointer to current file}
- *      objname          {In}    {Name of object to inquire about}
- *      compname         {In}    {Name of component to return}
+ * Return:      Success:        NULL
  *
- *  Notes
+ *              Failure:        NULL
  *
- *  Modified
- *    Robb Matzke, Tue Nov 8 08:22:42 PST 1994
- *    Added error mechanism
+ * Programmer:  matzke@viper
+ *              Mon Nov  7 10:31:41 PST 1994
  *
+ * Modifications:
  *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
  *    I replaced API_END with API_END_NOPOP.
  *
- *    Eric Brugger, Wed Mar 10 16:59:34 PST 1999
- *    Changed API_BEGIN2 to API_BEGIN so that Silo directory information
- *    would be processed at the driver level, since the pdb driver
- *    version of this routine handles silo directory paths as well as
- *    file system directory paths, which API_BEGIN2 does not.
- *
- *    Eric Brugger, Thu Mar 11 12:33:15 PST 1999
- *    I forgot to remove the fourth argument when I changed API_BEGIN2
- *    to API_BEGIN.  I did so now.
+ *    Eric Brugger, Mon Feb 27 15:03:01 PST 1995
+ *    I changed the return value to be an integer instead of a pointer
+ *    to a DBfile.
  *
- *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
- *    Added a check for variable name validity.
+ *    Robb Matzke, Tue Feb 28 10:57:57 EST 1995
+ *    The file status slot is cleared so it can be reused.
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ *    Eric Brugger, Mon Jul 10 07:42:24 PDT 1995
+ *    I moved the reseting of _db_fstatus to before the return statement,
+ *    so that the instruction would get executed.
  *
  *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
  *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *--------------------------------------------------------------------*/
-PUBLIC void   *
-DBGetComponent(DBfile *dbfile, char const *objname, char const *compname)
+ *    Added code to UNregister the given file pointer.
+ *
+ *    Free the file's compression string and its compiled rules.
+ *
+ *    Fold the file's statistics into the global totals.
+ *
+ *    Dump the API trace, if tracing.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBClose(DBfile *dbfile)
 {
-    void *retval = NULL;
+    int            id;
+    int            retval;
+    void          *fsg;
+    DBfilestats   *stats;
 
-    API_BEGIN2("DBGetComponent", void *, NULL, api_dummy) {
+    API_BEGIN2("DBClose", int, -1, api_dummy) {
         if (!dbfile)
             API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBGetComponent", E_GRABBED) ; 
-        if (!objname || !*objname)
-            API_ERROR("object name", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (!dbfile->pub.g_comp)
+        if (NULL == dbfile->pub.close)
             API_ERROR(dbfile->pub.name, E_NOTIMP);
+#warning IS ORDER OF OPS CORRECT HERE
+        id = dbfile->pub.fileid;
+        fsg = dbfile->pub.file_scope_globals;
+        stats = dbfile->pub.stats;
 
-        retval = (dbfile->pub.g_comp) (dbfile, objname, compname);
-
-        if (db_IsComponentNameStandardWithSpecialHandling(compname))
-            db_AdjustSpeciallyHandledStandardObjectComponentValue(retval,
-                DBInqVarType(dbfile, objname), compname);
+        if (dbfile->pub.file_lib_version)
+            free(dbfile->pub.file_lib_version);
+        db_unregister_file(dbfile);
 
+        /* The driver's close frees dbfile, so don't touch it afterwards.
+           The slot is released last so another thread can't reuse it
+           while this file is still being closed. */
+        retval = (dbfile->pub.close) (dbfile);
+        db_stats_close(stats);
+        if (((SILO_Globals_t*)fsg)->compressionParams != (char *) DB_CHAR_PTR_NOT_SET)
+            FREE(((SILO_Globals_t*)fsg)->compressionParams);
+        db_FreeCompression(((SILO_Globals_t*)fsg)->compressionPolicy);
+        free(fsg);
+        db_release_fileid(id);
+        if (db_trace_on)
+            DBDumpTrace();
         API_RETURN(retval);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-/*----------------------------------------------------------------------
- *  Routine                                           DBGetComponentType
- *
- *  Purpose
- *
- *      Return the type of a component for the given object.
- *
- *  Programmer
+
+/*-------------------------------------------------------------------------
+ * Function:    DBFlush
  *
- *      Brad Whitlock, Thu Jan 20 11:54:54 PDT 2000
+ * Purpose:     Flush the specified file contents to disk.
  *
- *  Parameters
+ * Return:      Success:        NULL
  *
- *      dbfile           {In}    {Pointer to current file}
- *      objname          {In}    {Name of object to inquire about}
- *      compname         {In}    {Name of component to return}
+ *              Failure:        NULL
  *
- *  Modified
+ * Programmer:  Mark C. Miller, Fri Nov  6 09:38:05 PST 2015
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *--------------------------------------------------------------------*/
-
+ * Modifications:
+ *-------------------------------------------------------------------------*/
 PUBLIC int
-DBGetComponentType(DBfile *dbfile, char const *objname, char const *compname)
+DBFlush(DBfile *dbfile)
 {
-    int retval = DB_NOTYPE;
+    int            id;
+    int            retval;
 
-    API_BEGIN2("DBGetComponentType", int, DB_NOTYPE, api_dummy) {
+    API_BEGIN2("DBFlush", int, -1, api_dummy) {
         if (!dbfile)
             API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("", E_GRABBED) ; 
-        if (!objname || !*objname)
-            API_ERROR("object name", E_BADARGS);
-        if (!compname || !*compname)
-            API_ERROR("component name", E_BADARGS);
-        if (!dbfile->pub.g_comptyp)
+        if (NULL == dbfile->pub.flush)
             API_ERROR(dbfile->pub.name, E_NOTIMP);
-
-        retval = (dbfile->pub.g_comptyp) (dbfile, objname, compname);
+        retval = (dbfile->pub.flush) (dbfile);
         API_RETURN(retval);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
 /*----------------------------------------------------------------------
- *  Routine                                                     DBGetDir
- *
- *  Purpose
- *
- *      Get the name of the current directory, return in space provided.
+ * Routine:  db_inq_file_has_silo_objects_r
  *
- *  Modified
- *    Robb Matzke, Tue Nov 8 08:48:12 PST 1994
- *    Added error mechanism
+ * Purpose:  Recursive helper func for DBInqFileHasObjects 
  *
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ * Programmer: Mark C. Miller, Wed Sep 23 11:34:01 PDT 2009
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ * Modifications:
+ *   Mark C. Miller, Mon Nov 16 10:28:41 PST 2009
+ *   Fixed dir recursion by copying dir-related toc entries. Removed
+ *   misc. vars from count of silo objects.
  *--------------------------------------------------------------------*/
-PUBLIC int
-DBGetDir(DBfile *dbfile, char *path)
+
+PRIVATE int
+db_inq_file_has_silo_objects_r(DBfile *f)
 {
-    int retval;
+    int i, ndir, retval = 0;
+    char **dirnames;
+    DBtoc *toc = DBGetToc(f);
 
-    API_BEGIN2("DBGetDir", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBGetDir", E_GRABBED) ; 
-        if (!path)
-            API_ERROR("path", E_BADARGS);
-        if (!dbfile->pub.g_dir)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
+    if (!toc)
+        return -1;
 
-        retval = (dbfile->pub.g_dir) (dbfile, path);
-        API_RETURN(retval);
+    /* save dirnames so we don't loose 'em as we get new tocs */
+    ndir = toc->ndir;
+    dirnames = (char **) malloc(ndir * sizeof(char*));
+    for (i = 0; i < ndir; i++)
+        dirnames[i] = STRDUP(toc->dir_names[i]);
+     
+    /* We exclude dirs and misc. vars because a non-Silo file may
+     * contain them. */
+    retval = toc->ncurve + toc->ncsgmesh + toc->ncsgvar + toc->ndefvars +
+        toc->nmultimesh + toc->nmultimeshadj + toc->nmultivar +
+        toc->nmultimat + toc->nmultimatspecies + toc->nqmesh +
+        toc->nqvar + toc->nucdmesh + toc->nucdvar + toc->nptmesh +
+        toc->nptvar + toc->nmat + toc->nmatspecies +
+        toc->nobj + toc->nmrgtree + toc->ngroupelmap +
+        toc->nmrgvar + toc->narray;
+
+    /* Recurse on directories. */
+    for (i = 0; i < ndir && retval == 0; i++)
+    {
+        DBSetDir(f, dirnames[i]);
+        retval += db_inq_file_has_silo_objects_r(f);
+        DBSetDir(f, "..");
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+
+    /* free the dirnames */
+    for (i = 0; i < ndir; i++)
+        free(dirnames[i]);
+    free(dirnames);
+
+    return retval;
 }
 
 /*-------------------------------------------------------------------------
- * Function:    DBSetDir
+ * Function:    DBInqFileHasObjects
  *
- * Purpose:     Sets the current directory within the database.
+ * Purpose:     See if the file contains any silo objects, excluding
+ *              directories in the search.
  *
- * Return:      Success:        0
+ * Return:      Success:         >0 ==> yes, the file has silo objects.
+ *                              ==0 ==> no, the file has no silo objects.
  *
- *              Failure:        -1
+ *              Failure:        -1 
  *
- * Programmer:  robb@cloud
- *              Wed Nov  9 13:09:23 EST 1994
+ * Programmer:  Mark C. Miller, Wed Sep 23 09:42:27 PDT 2009
  *
  * Modifications:
- *    Robb Matzke, Mon Nov 21 21:31:17 EST 1994
- *    Added error mechanism.
- *
- *    Robb Matzke, Fri Jan 6 07:34:29 PST 1995
- *    Checkes for changing to `.' since that is a no-op.
- *
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
- *
- *    Robb Matzke, 2000-05-23
- *    The old table of contents is discarded if the directory changes.
- *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *   Mark C. Miller, Mon Nov 16 10:29:36 PST 2009
+ *   Added logic to test from some well known, tell-tale silo variables.
  *-------------------------------------------------------------------------*/
+
 PUBLIC int
-DBSetDir(DBfile *dbfile, const char *path)
+DBInqFileHasObjects(DBfile *f)
 {
-    char           tmp[256];
+    char cwd[4096];
     int retval;
 
-    API_BEGIN2("DBSetDir", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBSetDir", E_GRABBED) ; 
-        if (!path || !*path)
-            API_ERROR("path", E_BADARGS);
-        if (STR_EQUAL(path, "."))
-        {
-            API_RETURN(0);
-        }
-        if (DBGetDir(dbfile, tmp) < 0)
-            API_ERROR("DBGetDir", E_CALLFAIL);
-        if (STR_EQUAL(tmp, path))
-        {
-            API_RETURN(0);
-        }
-        if (!dbfile->pub.cd)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
+    if (f == 0)
+        return -1;
 
-        retval = (dbfile->pub.cd) (dbfile, path);
-        db_FreeToc(dbfile);
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    if (DBInqVarExists(f, "_silolibinfo"))
+        return 1;
+    if (DBInqVarExists(f, "_hdf5libinfo"))
+        return 1;
+
+    DBGetDir(f, cwd);
+    retval = db_inq_file_has_silo_objects_r(f);
+    DBSetDir(f, cwd);    
+
+    return retval;
 }
 
 /*-------------------------------------------------------------------------
- * Function:    DBFilters
- *
- * Purpose:     List the names of filters installed for the specified
- *              file.  The list is sent to the specified stream.
+ * Function:    DBInqFileReal
  *
- * Return:      Success:        0
+ * Purpose:     Determines if the filename is a Silo file.
  *
- *              Failure:        -1
+ * Return:      0  if filename is not a Silo file, 
+ *              >0 if filename is a Silo file,
+ *              <0 if an error occurred.
  *
- * Programmer:  robb@cloud
- *              Tue Mar  7 10:51:58 EST 1995
+ * Programmer:  Hank Childs
+ *              Tue Feb 29 16:24:01 PST 2000
  *
  * Modifications:
+ *    Sean Ahern, Wed Jul  5 15:35:48 PDT 2000
+ *    Renamed the function to DBInqFileReal.  Client code now calls a macro
+ *    called DBInqFile.
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *    Mark C. Miller, Wed Sep 23 11:48:19 PDT 2009
+ *    Added logic to confirm that indeed the successfully opened file has
+ *    some silo objects in it.
  *-------------------------------------------------------------------------*/
 PUBLIC int
-DBFilters(DBfile *dbfile, FILE *stream)
+DBInqFileReal(const char *filename)
 {
-    int retval;
+    DBfile *dbfile = NULL;
+    int hasobjects = -1;
 
-    API_BEGIN2("DBFilters", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBFilters", E_GRABBED) ; 
-        if (!stream)
-            stream = stdout;
-        if (!dbfile->pub.module)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
+    API_BEGIN("DBInqFile", int, -1) {
+        if (!filename || ! *filename)
+            API_ERROR("filename", E_BADARGS);
 
-        retval = (dbfile->pub.module) (dbfile, stream);
-        API_RETURN(retval);
+        /* 
+         * Turn the error handling off so user won't see errors, 
+         * won't abort, etc.
+         */
+        DBShowErrors(DB_SUSPEND, NULL);
+
+        /*
+         * Must protect this code so that the error handling can be
+         * restored afterwards.
+         */
+        PROTECT {
+            dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+            if (dbfile)
+                hasobjects = DBInqFileHasObjects(dbfile);
+        } CLEANUP {
+            CANCEL_UNWIND;
+        } END_PROTECT;
+
+        /* 
+         * Turn the error handling back on. 
+         */
+        DBShowErrors(DB_RESUME, NULL);
+
+        if (dbfile != NULL)
+        {
+            DBClose(dbfile);
+            API_RETURN(hasobjects);
+        }
+ 
+        API_RETURN(0);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBMkDir & DBMkDirP
- *
- * Purpose:     Creates a new directory in the database. The P variant
- *              obeys unix `mkdir -p` semantics making parent directories
- *              as necessary as does so *above* any specific driver using
- *              calls to DBGetDir(), DBSetDir() and DBMkDir().
+/*----------------------------------------------------------------------
+ *  Routine                                               DBInqVarExists
  *
- * Return:      Success:        directory ID
+ *  Purpose
  *
- *              Failure:        -1
+ *      Determine if the given variable object exists in the SILO file.
+ *      Return non-zero if it does and 0 if it doesn't.
  *
- * Programmer:  matzke@viper
- *              Tue Nov  8 11:46:21 PST 1994
+ *  Programmer
  *
- * Modifications:
- *    Robb Matzke, Mon Nov 21 21:36:44 EST 1994
- *    Added error mechanism.
+ *      Sean Ahern, Thu Jul 20 11:53:40 PDT 1995
  *
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *  Modifications
+ *    Mon Aug 28 11:15:21 PDT 1995
+ *    (ahern) Changed the API_BEGIN to API_BEGIN2.
  *
  *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
  *    Added a check for variable name validity.
- *
- *    Robb Matzke, 2000-05-23
- *    The old table of contents is discarded if the directory changes.
- *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
- *-------------------------------------------------------------------------*/
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBMkDir(DBfile *dbfile, const char *name)
+DBInqVarExists(DBfile *dbfile, const char *varname)
 {
     int retval;
 
-    API_BEGIN2("DBMkDir", int, -1, api_dummy) {
+    API_BEGIN2("DBInqVarExists", int, 0, varname) {
         if (!dbfile)
             API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBMkDir", E_GRABBED) ; 
-        if (!name || !*name)
-            API_ERROR("directory name", E_BADARGS);
-        if (db_VariableNameValid(name) == 0)
-            API_ERROR("directory name", E_INVALIDNAME);
-        if (!dbfile->pub.mkdir)
+        if (!varname || !*varname)
+            API_ERROR("variable name", E_BADARGS);
+        if (dbfile->pub.exist == NULL)
             API_ERROR(dbfile->pub.name, E_NOTIMP);
-
-        retval = (dbfile->pub.mkdir) (dbfile, name);
-        db_FreeToc(dbfile);
+        retval = (dbfile->pub.exist) (dbfile, varname);
         API_RETURN(retval);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END_NOPOP; /* BEWARE: If API_RETURN above is removed use API_END */
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    DBForceSingle
+ *
+ * Purpose:     If 'status' is non-zero, then any 'datatype'd arrays are
+ *              converted on read from whatever their native datatype is to
+ *              float. A 'datatype'd array is an array that is part of some
+ *              Silo object containing a 'datatype' member which indicates
+ *              the type of data in the array. So, for example, a DBucdvar
+ *              has a 'datatype' member to indicate the type of data in the
+ *              var and mixvar arrays. Such arrays will be converted on read
+ *              if 'status' here is non-zero. However, a DBmaterial object 
+ *              is ALWAYS integer data. There is no 'datatype' member for
+ *              such an object and so its data will NEVER be converted to
+ *              float on read regardless of force single status set here.
+ *
+ *              I believe this function's original intention was to convert
+ *              only double precision arrays to single precision. However,
+ *              the PDB driver was apparently never designed that way and
+ *              the PDB driver's behavior sort of established the defacto
+ *              meaning of force single. So, now, as of Silo version 4.8
+ *              the HDF5 driver obeys it as well. Though, in fact the HDF5
+ *              driver was originally written to support the original
+ *              intention of force single status and it worked in this
+ *              ('buggy') fashion for many years before we started
+ *              encountering real problems with it in VisIt.
+ *
+ * Return:      Success:        0 if all drivers succeeded or did not
+ *                              implement this function.
+ *
+ *              Failure:        -1 if any driver returned failure.
+ *
+ * Programmer:  matzke@viper
+ *              Tue Jan 10 11:01:24 PST 1995
+ *
+ * Modifications:
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Mark C. Miller, Fri Jul 16 19:28:23 PDT 2010
+ *    Updated 'Purpose' above to reflect current understanding of the
+ *    meaning of force single.
+ *-------------------------------------------------------------------------*/
 PUBLIC int
-DBMkDirP(DBfile *dbfile, const char *name)
+DBForceSingle(int status)
 {
-    char        cwg[1024], *p;
-    char       *abspath = 0;
-    int         abslen = 0;
-    int         retval = 0;
+    int            i;
 
-    API_BEGIN2("DBMkDirP", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBMkDir", E_GRABBED) ; 
-        if (!name || !*name)
-            API_ERROR("directory name", E_BADARGS);
-        if (db_VariableNameValid(name) == 0)
-            API_ERROR("directory name", E_INVALIDNAME);
+    API_BEGIN("DBForceSingle", int, -1) {
+        for (i = 0; i < DB_NFORMATS; i++) {
+            if (DBFSingleCB[i]) {
+                if (((DBFSingleCB[i]) (status)) < 0) {
+                    char           dname[32];
 
-        /* Save cwg */
-        cwg[0] = '\0';
-        DBGetDir(dbfile, cwg);
-        abspath = db_absoluteOf_path(cwg,name);
-        abslen = strlen(abspath);
+                    sprintf(dname, "driver-%d", i);
+                    API_ERROR(dname, E_CALLFAIL);
+                }
+            }
+        }
+    }
+    API_END;
 
-        /* iterate setting and making one dir */
-        p = abspath+abslen;
+    return(0);
+}
 
-        /* Walk up path finding nearest existing parent */
-        while (p > abspath)
-        {
-            if (DBInqVarType(dbfile, abspath[0]=='\0'?"/":abspath) == DB_DIR) break;
-            while (p>abspath && '/'!=*p) p--;
-            *p = '\0';
-        }
+/*----------------------------------------------------------------------
+ *  Routine                                                DBMakeOptlist
+ *
+ *  Purpose
+ *
+ *      Allocate an option list of the requested length and initialize it.
+ *
+ *  Programmer
+ *
+ *      Jeffery W. Long, NSSD-B
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 06:58:04 PST 1994
+ *    Added error mechanism
+ *--------------------------------------------------------------------*/
+PUBLIC DBoptlist *
+DBMakeOptlist(int maxopts)
+{
+    DBoptlist     *optlist = NULL;
 
-        /* Walk down path creating missing parents */
-        while (!retval && p < abspath+abslen)
+    API_BEGIN("DBMakeOptlist", DBoptlist *, NULL) {
+        if (maxopts <= 0)
+            API_ERROR("maxopts", E_BADARGS);
+        optlist = ALLOC(DBoptlist);
+        if (!optlist) API_ERROR(NULL, E_NOMEM);
+        optlist->options = ALLOC_N(int, maxopts);
+        optlist->values = ALLOC_N(void *, maxopts);
+
+        if (!optlist->options || !optlist->values)
         {
-            DBSetDir(dbfile, abspath[0]=='\0'?"/":abspath);
-            retval = DBMkDir(dbfile, p+1);
-            *p = '/';
-            while (p<abspath+abslen && '\0'!=*p) p++;
+            FREE(optlist->values);
+            FREE(optlist->options);
+            FREE(optlist);
+            API_ERROR(NULL, E_NOMEM);
         }
 
-        /* restore cwg */
-        DBSetDir(dbfile, cwg);
-        free(abspath);
+        optlist->numopts = 0;
+        optlist->maxopts = maxopts;
 
-        API_RETURN(retval);
+        API_RETURN(optlist);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-
-/*-------------------------------------------------------------------------
- * Function:    DBCpDir
+/*----------------------------------------------------------------------
+ *  Routine                                                DBFreeOptlist
  *
- * Purpose:     Copies a directory tree from one file to another
+ *  Purpose
  *
- * Return:      Success:        directory ID
+ *      Release the storage associated with the given optlist list.
  *
- *              Failure:        -1
+ *  Programmer
  *
- * Programmer:  Mark C. Miller, Wed Aug  6 15:14:33 PDT 2008
+ *      Jeffery W. Long, NSSD-B
  *
- *-------------------------------------------------------------------------*/
+ *  Returns
+ *
+ *      Returns 0 on success, -1 on failure.
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 07:56:34 PST 1994
+ *    Added error mechanism.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBCpDir(DBfile *dbfile, char const *srcDir,
-        DBfile *dstFile, char const *dstDir)
+DBFreeOptlist(DBoptlist *optlist)
 {
-    int retval;
-
-    API_DEPRECATE2("DBCpDir", int, -1, api_dummy, 4, 11, "DBCp") {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (!dstFile)
-            API_ERROR(NULL, E_NOFILE);
-        if (db_isregistered_file(dstFile,0)==-1)
-            API_ERROR(NULL, E_NOTREG);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR(NULL, E_GRABBED) ; 
-        if (!srcDir || !*srcDir)
-            API_ERROR("source directory name", E_BADARGS);
-        if (!dstDir || !*dstDir)
-            API_ERROR("destination directory name", E_BADARGS);
-        if (db_VariableNameValid(dstDir) == 0)
-            API_ERROR("destination directory name", E_INVALIDNAME);
-        if (!dbfile->pub.cpdir)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-
-        retval = (dbfile->pub.cpdir) (dbfile, srcDir, dstFile, dstDir);
-        db_FreeToc(dbfile);
-        API_RETURN(retval);
+    API_BEGIN("DBFreeOptlist", int, -1) {
+        if (!optlist || optlist->numopts < 0) {
+            API_ERROR("optlist pointer", E_BADARGS);
+        }
+        FREE(optlist->options);
+        FREE(optlist->values);
+        FREE(optlist);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END;
+
+    return(0);
 }
 
-/*-------------------------------------------------------------------------
- * Function:    DBMkSymlink
+/*----------------------------------------------------------------------
+ *  Routine                                                DBClearOptlist
  *
- * Purpose:     Create symbolic link in silo file's CWD with name link and 
- *              referencing target. If target string contains ':', then
- *              chars before ':' are interpreted as another silo file
- *              and chars after ':' are interpreted as object within that
- *              file. If file part specifies a relative path, then path is
- *              relative to directory in which dbfile exists in
- *              file system.
+ *  Purpose
  *
- * Return:      Success:        directory ID
+ *      Remove all options from the given optlist and reset counters.
  *
- *              Failure:        -1
+ *  Programmer
  *
- * Programmer:  Mark C. Miller, Mon Apr 16 14:52:05 PDT 2018
+ *      Jeffery W. Long, NSSD-B
  *
- *-------------------------------------------------------------------------*/
+ *  Returns
+ *
+ *      Returns OKAY on success, OOPS on failure.
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 07:48:52 PST 1994
+ *    Added error mechanism.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBMkSymlink(DBfile *dbfile, char const *target, char const *link)
+DBClearOptlist(DBoptlist *optlist)
 {
-    int retval;
+    int            i;
 
-    API_BEGIN2("DBMkSymlink", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBMkDir", E_GRABBED) ; 
-        if (!target || !*target)
-            API_ERROR("target", E_BADARGS);
-        if (db_VariableNameValid(target) == 0)
-            API_ERROR("target", E_INVALIDNAME);
-        if (!link || !*link)
-            API_ERROR("link", E_BADARGS);
-        if (db_VariableNameValid(link) == 0)
-            API_ERROR("link", E_INVALIDNAME);
-        if (!dbfile->pub.mksymlink)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
+    API_BEGIN("DBClearOptlist", int, -1) {
+        if (!optlist || optlist->numopts < 0) {
+            API_ERROR("optlist pointer", E_BADARGS);
+        }
 
-        retval = (dbfile->pub.mksymlink) (dbfile, target, link);
-        db_FreeToc(dbfile);
-        API_RETURN(retval);
+        /* Reset values, but do not free */
+        for (i = 0; i < optlist->maxopts; i++) {
+            optlist->options[i] = 0;
+            optlist->values[i] = (void *)NULL;
+        }
+
+        optlist->numopts = 0;
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    API_END;
+
+    return(0);
 }
 
-/* return 0 if the toc_entry is not a symlink or the target of the
- * symlink if it is */
-PUBLIC char const *
-DBIsSymlink(DBtoc const *toc, char const *toc_entry)
+/*----------------------------------------------------------------------
+ *  Routine                                                  DBAddOption
+ *
+ *  Purpose
+ *
+ *      Add an option to the given option list structure.
+ *
+ *  Programmer
+ *
+ *      Jeffery W. Long, NSSD-B
+ *
+ *  Returns
+ *
+ *      Returns OKAY on success, OOPS on failure.
+ *
+ *  Modified:
+ *    Robb Matzke, Tue Nov 8 07:00:55 PST 1994
+ *    Added error mechanism.  Returns -1 on failure, 0 on success.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBAddOption(DBoptlist *optlist, int option, void *value)
 {
-    int i;
+    API_BEGIN("DBAddOption", int, -1) {
+        if (!optlist)
+            API_ERROR("optlist pointer", E_BADARGS);
+        if (optlist->numopts >= optlist->maxopts)
+            API_ERROR("optlist nopts", E_BADARGS);
 
-    if (!toc) return 0;
-    if (!toc_entry || !*toc_entry) return 0;
+        optlist->options[optlist->numopts] = option;
+        optlist->values[optlist->numopts] = value;
+        optlist->numopts++;
 
-    /* note: could use pointer compare instead of string
-       compare if could guarantee the toc_entry is one of
-       the members from this toc because symlink_name entry
-       is really just a copy of other toc entry's name
-       pointers */
+        if (optlist->numopts >= optlist->maxopts)
+        {
+            int new_maxopts = optlist->maxopts * 1.5 + 1; /* golden rule + 1 */
+            int *new_options = REALLOC_N(optlist->options, int, new_maxopts);
+            void **new_values = REALLOC_N(optlist->values, void*, new_maxopts);
+
+            if (!new_options || !new_values)
+            {
+                FREE(new_options);
+                FREE(new_values);
+                API_ERROR(0, E_NOMEM);
+            }
+
+            optlist->maxopts = new_maxopts;
+            optlist->options = new_options;
+            optlist->values  = new_values;
+        }
 
-    for (i = 0; i < toc->nsymlink; i++)
-    {
-        if (!strcmp(toc->symlink_names[i], toc_entry))
-            return toc->symlink_target_names[i];
     }
+    API_END;
 
-    return 0;
+    return(0);
 }
 
+/*----------------------------------------------------------------------
+ *  Routine                                                DBClearOption
+ *
+ *  Purpose
+ *
+ *      Remove a given option from the given optlist and re-order
+ *      the remaining options.
+ *
+ *  Programmer
+ *
+ *      Mark C. Miller, August 18, 2005 
+ *
+ *--------------------------------------------------------------------*/
 PUBLIC int
-DBGetSymlink(DBfile *dbfile, char const *in_candidate_link, char *out_target)
+DBClearOption(DBoptlist *optlist, int option)
 {
-    int retval;
-    API_BEGIN2("DBGetSymlink", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBGetSymlink", E_GRABBED);
-        if (!in_candidate_link || !*in_candidate_link)
-            API_ERROR("in_candidate_link", E_BADARGS);
-        if (!dbfile->pub.g_symlink)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-
-        retval = (dbfile->pub.g_symlink) (dbfile, in_candidate_link, out_target);
-        db_FreeToc(dbfile);
-        API_RETURN(retval);
-    }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
-}
+    int            i, j, foundit=0;
 
-PRIVATE void
-CheckForComponentSeries(DBobject const *srcObj, int i,
-    int *isser, int *nser, char **sernm, char **sertstr, void **serd)
-{
-    char *p = 0;
-    int pass = 0;
-    int dtyp = DB_NOTYPE;
-    int i0 = i;
-    int nd = (int) strcspn(srcObj->comp_names[i0], "0123456789");
+    API_BEGIN("DBClearOption", int, -1) {
+        if (!optlist || optlist->numopts < 0) {
+            API_ERROR("optlist pointer", E_BADARGS);
+        }
 
-    /* advance while component names match in first nd chars */
-    i++;
-    while (i < srcObj->ncomponents)
-    {
-        if (strncmp(srcObj->comp_names[i], srcObj->comp_names[i0], nd) ||
-            strncmp(srcObj->pdb_names[i], "'<", 2) ||
-           !strncmp(srcObj->pdb_names[i], "'<s>/.silo/#", 12))
-            break;
-        i++;
-    }
+        /* Shift values down in list by one entry */
+        for (i = 0; i < optlist->numopts; i++) {
+            if (optlist->options[i] == option) {
+                foundit = 1;
+                for (j = i; j < optlist->numopts-1; j++) {
+                    optlist->options[j] = optlist->options[j+1];
+                    optlist->values[j]  = optlist->values[j+1];
+                }
+                break;
+            }
+        }
 
-    /* If the series is of length one (or less) its not a series */
-    if ((i-i0) <= 1)
-    {
-        *isser = 0;
-        return;
+        if (foundit) {
+            optlist->numopts--;
+            optlist->options[optlist->numopts] = 0;
+            optlist->values[optlist->numopts]  = 0;
+        }
     }
+    API_END;
 
-    *isser = 1;
-    *nser = i-i0;
-    *sernm = db_strndup(srcObj->comp_names[i0], nd);
-
-    /* first pass get size, second pass fill buffer */
-    for (pass = 0; pass < 2; pass++)
-    {
-        int j;
-
-        if (pass == 1)
-        {
-            p = (char *) malloc((size_t)p);
-            *serd = p;
-        }
+    return(0);
+}
+
+/*----------------------------------------------------------------------
+ *  Routine                                                DBGetOption
+ *
+ *  Purpose
+ *
+ *      Return value set for a given option from the given optlist.
+ *
+ *  Programmer
+ *
+ *      Mark C. Miller, August 18, 2005 
+ *
+ *  Modifications:
+ *
+ *      Mark C. Miller, Wed Jul 14 20:35:50 PDT 2010
+ *      Replaced 'return' with 'API_RETURN'
+ *
+ *      Mark C. Miller, Tue Aug 10 23:49:51 PDT 2010
+ *      Removed API_BEGIN/END stuff so that function can be handed
+ *      a null optlist and it will behave well.
+ *--------------------------------------------------------------------*/
+PUBLIC void * 
+DBGetOption(const DBoptlist *optlist, int option)
+{
+    int            i;
+
+    if (!optlist) return 0;
+
+    /* find the given option in the optlist and return its value */
+    for (i = 0; i < optlist->numopts; i++)
+        if (optlist->options[i] == option)
+            return optlist->values[i];
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBGetToc
+ *
+ * Purpose:     Return a pointer to table of contents of the file.  Note
+ *              that the pointer is the same as the one in the DBfile
+ *              so it should not be modified and may become invalid after
+ *              calling the next silo routine.
+ *
+ * Return:      Success:        Pointer to the table of contents structure.
+ *
+ *              Failure:        NULL
+ *
+ * Programmer:  matzke@viper
+ *              Mon Nov  7 10:35:47 PST 1994
+ *
+ * Modifications:
+ *    Eric Brugger, Fri Jan 27 08:23:43 PST 1995
+ *    I changed the interface and function of the routine.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC DBtoc  *
+DBGetToc(DBfile *dbfile)
+{
+    API_BEGIN2("DBGetToc", DBtoc *, NULL, api_dummy) {
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("", E_GRABBED) ; 
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+
+        DBNewToc(dbfile);
+        API_RETURN(dbfile->pub.toc);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBInqVarType
+ *
+ * Purpose:     Return the DBObjectType for a given object name
+ *
+ * Return:      Success:        the ObjectType for the given object
+ *
+ *              Failure:        DB_INVALID_OBJECT
+ *
+ * Programmer:  Sean Ahern,
+ *              Wed Oct 28 14:46:53 PST 1998
+ *
+ * Modifications:
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC DBObjectType
+DBInqVarType(DBfile *dbfile, char const *varname)
+{
+    DBObjectType retval;
+
+    API_BEGIN2("DBInqVarType", DBObjectType, DB_INVALID_OBJECT, api_dummy) {
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("", E_GRABBED) ; 
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!varname || !*varname)
+            API_ERROR("variable name", E_BADARGS);
+        if (!dbfile->pub.inqvartype)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.inqvartype) (dbfile, varname);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBNewToc
+ *
+ * Purpose:     Used to be called `DBGetToc', this function installs a
+ *              new table of contents in the specified file from that
+ *              file's current working directory.  The old table of contents
+ *              is destroyed.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  robb@cloud
+ *              Tue Mar  7 10:26:23 EST 1995
+ *
+ * Modifications:
+ *              Robb Matzke, 2000-05-23
+ *              If nothing has changed then this function just returns
+ *              success, leaving the original table of contents in place.
+ *              Any function that potentially changes the table of
+ *              contents should call db_FreeToc() on the file handle.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBNewToc(DBfile *dbfile)
+{
+    int retval;
+
+    API_BEGIN("DBNewToc", int, -1) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("", E_GRABBED) ; 
+        if (!dbfile->pub.newtoc)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+        if (dbfile->pub.toc)
+            API_RETURN(0);
+        retval = (dbfile->pub.newtoc) (dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*
+This logic is necessary to support callers accessing standard (e.g. non-DB_USERDEF)
+objects via the generic interface to ensure logic for specially handled component
+values is consistent with the standard object's DBGetXXX methods.
+To ensure a zero for the component in the file means either not-present or
+not-set, certain components, especially those for which a zero value is a valid
+value for the data producer to use, special handling is required and that logic
+is sprinkled about in the DBPutXXX and DBGetXXX methods of the drivers and so
+to is it required here. Its a nasty maintenance issue.
+*/
+
+static int
+db_IsComponentNameStandardWithSpecialHandling(char const *compname)
+{
+    if (!strcmp(compname, "missing_value")) return 1;
+    if (!strcmp(compname, "topo_dim")) return 1;
+    if (!strcmp(compname, "repr_block_idx")) return 1;
+    return 0;
+}
+
+/* For use in the DBGetComponent call */
+static void
+db_AdjustSpeciallyHandledStandardObjectComponentValue(
+    void *val_ptr, int obj_type, char const *comp_name)
+{
+    if (!val_ptr || !comp_name) return;
+
+    if (!strcmp(comp_name, "missing_value") &&
+        (obj_type == DB_UCDVAR || obj_type == DB_QUADVAR || obj_type == DB_CURVE ||
+         obj_type == DB_POINTVAR || obj_type == DB_MULTIVAR))
+    {
+        double val_for_mem, val_from_file = *((double*)val_ptr);
+        db_SetMissingValueForGet(val_for_mem, val_from_file);
+        *((double*)val_ptr) = val_for_mem;
+    }
+    else if (!strcmp(comp_name, "repr_block_idx") &&
+        (obj_type == DB_MULTIMESH || obj_type == DB_MULTIVAR ||
+         obj_type == DB_MULTIMAT || obj_type == DB_MULTIMATSPECIES))
+    {
+        int val_for_mem, val_from_file = *((int*)val_ptr);
+        val_for_mem = val_from_file - 1;
+        *((int*)val_ptr) = val_for_mem;
+    }
+    else if (!strcmp(comp_name, "topo_dim") &&
+        (obj_type == DB_MULTIMESH || obj_type == DB_UCDMESH))
+    {
+        int val_for_mem, val_from_file = *((int*)val_ptr);
+        val_for_mem = val_from_file - 1;
+        *((int*)val_ptr) = val_for_mem;
+    }
+}
+
+/* For use in the DBGetObject call */
+static void
+db_AdjustSpeciallyHandledStandardObjectComponentValues(DBobject *obj)
+{
+    int i, obj_type;
+
+    if (!obj) return;
+
+    obj_type = DBGetObjtypeTag(obj->type);
+    if (obj_type == DB_USERDEF) return;
+
+    for (i = 0; i < obj->ncomponents; i++)
+    {
+        char tmp[256];
+
+        if (!strcmp(obj->comp_names[i], "missing_value") &&
+            (obj_type == DB_UCDVAR || obj_type == DB_QUADVAR || obj_type == DB_CURVE ||
+             obj_type == DB_POINTVAR || obj_type == DB_MULTIVAR))
+        {
+            double val_for_mem, val_from_file = strtod(obj->pdb_names[i]+4,0);
+            db_SetMissingValueForGet(val_for_mem, val_from_file);
+            sprintf(tmp, "'<d>%.30g'", val_for_mem);
+        }
+        else if (!strcmp(obj->comp_names[i], "repr_block_idx") &&
+            (obj_type == DB_MULTIMESH || obj_type == DB_MULTIVAR ||
+             obj_type == DB_MULTIMAT || obj_type == DB_MULTIMATSPECIES))
+        {
+            int val_for_mem, val_from_file = (int) strtol(obj->pdb_names[i]+4,0,10);
+            val_for_mem = val_from_file - 1;
+            sprintf(tmp, "'<i>%d'", val_for_mem);
+        }
+        else if (!strcmp(obj->comp_names[i], "topo_dim") &&
+            (obj_type == DB_MULTIMESH || obj_type == DB_UCDMESH))
+        {
+            int val_for_mem, val_from_file = (int) strtol(obj->pdb_names[i]+4,0,10);
+            val_for_mem = val_from_file - 1;
+            sprintf(tmp, "'<i>%d'", val_for_mem);
+        }
+        else
+        {
+            continue;
+        }
+
+        FREE(obj->pdb_names[i]);
+        obj->pdb_names[i] = STRDUP(tmp);
+    }
+}
+
+/*----------------------------------------------------------------------
+ *  Routine                                                DBGetComponent
+ *
+ *  Purpose
+ *
+ *      Return the requested component value for the given object.
+ *
+ *  Programmer
+ *
+ *      Jeffery W. Long, NSSD-B
+ *
+ *  Parameters
+ *
+ *      dbfile           {In}    {Pointer to current file}
+ *      objname          {In}    {Name of object to inquire about}
+ *      compname         {In}    {Name of component to return}
+ *
+ *  Notes
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 08:22:42 PST 1994
+ *    Added error mechanism
+ *
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Eric Brugger, Wed Mar 10 16:59:34 PST 1999
+ *    Changed API_BEGIN2 to API_BEGIN so that Silo directory information
+ *    would be processed at the driver level, since the pdb driver
+ *    version of this routine handles silo directory paths as well as
+ *    file system directory paths, which API_BEGIN2 does not.
+ *
+ *    Eric Brugger, Thu Mar 11 12:33:15 PST 1999
+ *    I forgot to remove the fourth argument when I changed API_BEGIN2
+ *    to API_BEGIN.  I did so now.
+ *
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *--------------------------------------------------------------------*/
+PUBLIC void   *
+DBGetComponent(DBfile *dbfile, char const *objname, char const *compname)
+{
+    void *retval = NULL;
+
+    API_BEGIN2("DBGetComponent", void *, NULL, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBGetComponent", E_GRABBED) ; 
+        if (!objname || !*objname)
+            API_ERROR("object name", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (!dbfile->pub.g_comp)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.g_comp) (dbfile, objname, compname);
+
+        if (db_IsComponentNameStandardWithSpecialHandling(compname))
+            db_AdjustSpeciallyHandledStandardObjectComponentValue(retval,
+                DBInqVarType(dbfile, objname), compname);
+
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*----------------------------------------------------------------------
+ *  Routine                                           DBGetComponentType
+ *
+ *  Purpose
+ *
+ *      Return the type of a component for the given object.
+ *
+ *  Programmer
+ *
+ *      Brad Whitlock, Thu Jan 20 11:54:54 PDT 2000
+ *
+ *  Parameters
+ *
+ *      dbfile           {In}    {Pointer to current file}
+ *      objname          {In}    {Name of object to inquire about}
+ *      compname         {In}    {Name of component to return}
+ *
+ *  Modified
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *--------------------------------------------------------------------*/
+
+PUBLIC int
+DBGetComponentType(DBfile *dbfile, char const *objname, char const *compname)
+{
+    int retval = DB_NOTYPE;
+
+    API_BEGIN2("DBGetComponentType", int, DB_NOTYPE, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("", E_GRABBED) ; 
+        if (!objname || !*objname)
+            API_ERROR("object name", E_BADARGS);
+        if (!compname || !*compname)
+            API_ERROR("component name", E_BADARGS);
+        if (!dbfile->pub.g_comptyp)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.g_comptyp) (dbfile, objname, compname);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*----------------------------------------------------------------------
+ *  Routine                                                     DBGetDir
+ *
+ *  Purpose
+ *
+ *      Get the name of the current directory, return in space provided.
+ *
+ *  Modified
+ *    Robb Matzke, Tue Nov 8 08:48:12 PST 1994
+ *    Added error mechanism
+ *
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBGetDir(DBfile *dbfile, char *path)
+{
+    int retval;
+
+    API_BEGIN2("DBGetDir", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBGetDir", E_GRABBED) ; 
+        if (!path)
+            API_ERROR("path", E_BADARGS);
+        if (!dbfile->pub.g_dir)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.g_dir) (dbfile, path);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBSetDir
+ *
+ * Purpose:     Sets the current directory within the database.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  robb@cloud
+ *              Wed Nov  9 13:09:23 EST 1994
+ *
+ * Modifications:
+ *    Robb Matzke, Mon Nov 21 21:31:17 EST 1994
+ *    Added error mechanism.
+ *
+ *    Robb Matzke, Fri Jan 6 07:34:29 PST 1995
+ *    Checkes for changing to `.' since that is a no-op.
+ *
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Robb Matzke, 2000-05-23
+ *    The old table of contents is discarded if the directory changes.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBSetDir(DBfile *dbfile, const char *path)
+{
+    char           tmp[256];
+    int retval;
+
+    API_BEGIN2("DBSetDir", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBSetDir", E_GRABBED) ; 
+        if (!path || !*path)
+            API_ERROR("path", E_BADARGS);
+        if (STR_EQUAL(path, "."))
+        {
+            API_RETURN(0);
+        }
+        if (DBGetDir(dbfile, tmp) < 0)
+            API_ERROR("DBGetDir", E_CALLFAIL);
+        if (STR_EQUAL(tmp, path))
+        {
+            API_RETURN(0);
+        }
+        if (!dbfile->pub.cd)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.cd) (dbfile, path);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBFilters
+ *
+ * Purpose:     List the names of filters installed for the specified
+ *              file.  The list is sent to the specified stream.
+ *
+ * Return:      Success:        0
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  robb@cloud
+ *              Tue Mar  7 10:51:58 EST 1995
+ *
+ * Modifications:
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBFilters(DBfile *dbfile, FILE *stream)
+{
+    int retval;
+
+    API_BEGIN2("DBFilters", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBFilters", E_GRABBED) ; 
+        if (!stream)
+            stream = stdout;
+        if (!dbfile->pub.module)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.module) (dbfile, stream);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBMkDir & DBMkDirP
+ *
+ * Purpose:     Creates a new directory in the database. The P variant
+ *              obeys unix `mkdir -p` semantics making parent directories
+ *              as necessary as does so *above* any specific driver using
+ *              calls to DBGetDir(), DBSetDir() and DBMkDir().
+ *
+ * Return:      Success:        directory ID
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  matzke@viper
+ *              Tue Nov  8 11:46:21 PST 1994
+ *
+ * Modifications:
+ *    Robb Matzke, Mon Nov 21 21:36:44 EST 1994
+ *    Added error mechanism.
+ *
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Sean Ahern, Tue Sep 28 10:48:06 PDT 1999
+ *    Added a check for variable name validity.
+ *
+ *    Robb Matzke, 2000-05-23
+ *    The old table of contents is discarded if the directory changes.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBMkDir(DBfile *dbfile, const char *name)
+{
+    int retval;
+
+    API_BEGIN2("DBMkDir", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBMkDir", E_GRABBED) ; 
+        if (!name || !*name)
+            API_ERROR("directory name", E_BADARGS);
+        if (db_VariableNameValid(name) == 0)
+            API_ERROR("directory name", E_INVALIDNAME);
+        if (!dbfile->pub.mkdir)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.mkdir) (dbfile, name);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+PUBLIC int
+DBMkDirP(DBfile *dbfile, const char *name)
+{
+    char        cwg[1024], *p;
+    char       *abspath = 0;
+    int         abslen = 0;
+    int         retval = 0;
+
+    API_BEGIN2("DBMkDirP", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBMkDir", E_GRABBED) ; 
+        if (!name || !*name)
+            API_ERROR("directory name", E_BADARGS);
+        if (db_VariableNameValid(name) == 0)
+            API_ERROR("directory name", E_INVALIDNAME);
+
+        /* Save cwg */
+        cwg[0] = '\0';
+        DBGetDir(dbfile, cwg);
+        abspath = db_absoluteOf_path(cwg,name);
+        abslen = strlen(abspath);
+
+        /* iterate setting and making one dir */
+        p = abspath+abslen;
+
+        /* Walk up path finding nearest existing parent */
+        while (p > abspath)
+        {
+            if (DBInqVarType(dbfile, abspath[0]=='\0'?"/":abspath) == DB_DIR) break;
+            while (p>abspath && '/'!=*p) p--;
+            *p = '\0';
+        }
+
+        /* Walk down path creating missing parents */
+        while (!retval && p < abspath+abslen)
+        {
+            DBSetDir(dbfile, abspath[0]=='\0'?"/":abspath);
+            retval = DBMkDir(dbfile, p+1);
+            *p = '/';
+            while (p<abspath+abslen && '\0'!=*p) p++;
+        }
+
+        /* restore cwg */
+        DBSetDir(dbfile, cwg);
+        free(abspath);
+
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:    DBCpDir
+ *
+ * Purpose:     Copies a directory tree from one file to another
+ *
+ * Return:      Success:        directory ID
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  Mark C. Miller, Wed Aug  6 15:14:33 PDT 2008
+ *
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBCpDir(DBfile *dbfile, char const *srcDir,
+        DBfile *dstFile, char const *dstDir)
+{
+    int retval;
+
+    API_DEPRECATE2("DBCpDir", int, -1, api_dummy, 4, 11, "DBCp") {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!dstFile)
+            API_ERROR(NULL, E_NOFILE);
+        if (db_isregistered_file(dstFile,0)==-1)
+            API_ERROR(NULL, E_NOTREG);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR(NULL, E_GRABBED) ; 
+        if (!srcDir || !*srcDir)
+            API_ERROR("source directory name", E_BADARGS);
+        if (!dstDir || !*dstDir)
+            API_ERROR("destination directory name", E_BADARGS);
+        if (db_VariableNameValid(dstDir) == 0)
+            API_ERROR("destination directory name", E_INVALIDNAME);
+        if (!dbfile->pub.cpdir)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.cpdir) (dbfile, srcDir, dstFile, dstDir);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBMkSymlink
+ *
+ * Purpose:     Create symbolic link in silo file's CWD with name link and 
+ *              referencing target. If target string contains ':', then
+ *              chars before ':' are interpreted as another silo file
+ *              and chars after ':' are interpreted as object within that
+ *              file. If file part specifies a relative path, then path is
+ *              relative to directory in which dbfile exists in
+ *              file system.
+ *
+ * Return:      Success:        directory ID
+ *
+ *              Failure:        -1
+ *
+ * Programmer:  Mark C. Miller, Mon Apr 16 14:52:05 PDT 2018
+ *
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBMkSymlink(DBfile *dbfile, char const *target, char const *link)
+{
+    int retval;
+
+    API_BEGIN2("DBMkSymlink", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBMkDir", E_GRABBED) ; 
+        if (!target || !*target)
+            API_ERROR("target", E_BADARGS);
+        if (db_VariableNameValid(target) == 0)
+            API_ERROR("target", E_INVALIDNAME);
+        if (!link || !*link)
+            API_ERROR("link", E_BADARGS);
+        if (db_VariableNameValid(link) == 0)
+            API_ERROR("link", E_INVALIDNAME);
+        if (!dbfile->pub.mksymlink)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.mksymlink) (dbfile, target, link);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/* return 0 if the toc_entry is not a symlink or the target of the
+ * symlink if it is */
+PUBLIC char const *
+DBIsSymlink(DBtoc const *toc, char const *toc_entry)
+{
+    int i;
+
+    if (!toc) return 0;
+    if (!toc_entry || !*toc_entry) return 0;
+
+    /* note: could use pointer compare instead of string
+       compare if could guarantee the toc_entry is one of
+       the members from this toc because symlink_name entry
+       is really just a copy of other toc entry's name
+       pointers */
+
+    for (i = 0; i < toc->nsymlink; i++)
+    {
+        if (!strcmp(toc->symlink_names[i], toc_entry))
+            return toc->symlink_target_names[i];
+    }
+
+    return 0;
+}
+
+PUBLIC int
+DBGetSymlink(DBfile *dbfile, char const *in_candidate_link, char *out_target)
+{
+    int retval;
+    API_BEGIN2("DBGetSymlink", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBGetSymlink", E_GRABBED);
+        if (!in_candidate_link || !*in_candidate_link)
+            API_ERROR("in_candidate_link", E_BADARGS);
+        if (!dbfile->pub.g_symlink)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.g_symlink) (dbfile, in_candidate_link, out_target);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+PRIVATE void
+CheckForComponentSeries(DBobject const *srcObj, int i,
+    int *isser, int *nser, char **sernm, char **sertstr, void **serd)
+{
+    char *p = 0;
+    int pass = 0;
+    int dtyp = DB_NOTYPE;
+    int i0 = i;
+    int nd = (int) strcspn(srcObj->comp_names[i0], "0123456789");
+
+    /* advance while component names match in first nd chars */
+    i++;
+    while (i < srcObj->ncomponents)
+    {
+        if (strncmp(srcObj->comp_names[i], srcObj->comp_names[i0], nd) ||
+            strncmp(srcObj->pdb_names[i], "'<", 2) ||
+           !strncmp(srcObj->pdb_names[i], "'<s>/.silo/#", 12))
+            break;
+        i++;
+    }
+
+    /* If the series is of length one (or less) its not a series */
+    if ((i-i0) <= 1)
+    {
+        *isser = 0;
+        return;
+    }
+
+    *isser = 1;
+    *nser = i-i0;
+    *sernm = db_strndup(srcObj->comp_names[i0], nd);
+
+    /* first pass get size, second pass fill buffer */
+    for (pass = 0; pass < 2; pass++)
+    {
+        int j;
+
+        if (pass == 1)
+        {
+            p = (char *) malloc((size_t)p);
+            *serd = p;
+        }
 
         for (j = i0; j < i; j++)
         {
-            if      (!strncmp(srcObj->pdb_names[j], "'<i>", 4))
-            {
-                if (pass == 1)
-                    *((int*)p) = (int) strtol(srcObj->pdb_names[j]+4, NULL, 0);
-                p += sizeof(int);
-                if (dtyp == DB_NOTYPE) dtyp = DB_INT;
-            }
-            else if (!strncmp(srcObj->pdb_names[j], "'<f>", 4))
-            {
-                if (pass == 1)
-                     *((float*)p) = (float) strtod(srcObj->pdb_names[j]+4, NULL);
-                p += sizeof(float);
-                if (dtyp == DB_NOTYPE) dtyp = DB_FLOAT;
-            }
-            else if (!strncmp(srcObj->pdb_names[j], "'<d>", 4))
+            if      (!strncmp(srcObj->pdb_names[j], "'<i>", 4))
+            {
+                if (pass == 1)
+                    *((int*)p) = (int) strtol(srcObj->pdb_names[j]+4, NULL, 0);
+                p += sizeof(int);
+                if (dtyp == DB_NOTYPE) dtyp = DB_INT;
+            }
+            else if (!strncmp(srcObj->pdb_names[j], "'<f>", 4))
+            {
+                if (pass == 1)
+                     *((float*)p) = (float) strtod(srcObj->pdb_names[j]+4, NULL);
+                p += sizeof(float);
+                if (dtyp == DB_NOTYPE) dtyp = DB_FLOAT;
+            }
+            else if (!strncmp(srcObj->pdb_names[j], "'<d>", 4))
+            {
+                if (pass == 1)
+                    *((double*)p) = strtod(srcObj->pdb_names[j]+4, NULL);
+                p += sizeof(double);
+                if (dtyp == DB_NOTYPE) dtyp = DB_DOUBLE;
+            }
+            else if (!strncmp(srcObj->pdb_names[j], "'<s>", 4))
+            {
+                int len = (int) strlen(srcObj->pdb_names[j])-5;
+                if (pass == 1)
+                {
+                     strcpy(p, srcObj->pdb_names[j]+4);
+                     p[len] = '\0';
+                }
+                p += (len+1);
+                if (dtyp == DB_NOTYPE) dtyp = DB_CHAR;
+            }
+            else
+            {
+                int len = (int) strlen(srcObj->pdb_names[j]);
+                if (pass == 1)
+                     strcpy(p, srcObj->pdb_names[j]);
+                p += (len+1);
+            }
+        }
+    }
+
+    *sertstr = db_GetDatatypeString(dtyp);
+}
+
+static int
+db_validate_copy_step(int pass, int recurse,
+    char const *srcName, char const *srcAbsName, int srcType,
+    char const *dstName, char const *dstAbsName, int dstType)
+{
+    /* We validate everything 1rst pass so on 2nd, just ignore */
+    if (pass == 1) return 1;
+
+    /* Validate source object first */
+    if (srcType == DB_INVALID_OBJECT)
+    {
+        db_perror("src object does not exist", E_BADARGS, srcName);
+        return 0;
+    }
+
+    if (srcType == DB_DIR && !recurse)
+    {
+        db_perror("src is a directory (not copied)", E_BADARGS, srcName);
+        return 0;
+    }
+
+    /* If destination does not exist, that is fine */
+    if (dstType == DB_INVALID_OBJECT)
+        return 1;
+
+    /* If pre-existing destination type isn't same as src, that is a problem */
+    if (dstType != srcType)
+    {
+        db_perror("pre-existing dst object type mismatch with src", E_BADARGS,
+            dstName?dstName:srcName);
+        return 0;
+    }
+
+    /* If we get here, we're overwriting the destination object and that
+       is ok only if AllowOverwrites is enabled *and* the src object
+       can fit within the space used by the dst object, the latter piece
+       of logic we cannot currently check. */
+    if (!DBGetAllowOverwrites())
+    {
+#warning ONLY IF SRC SIZE SMALLER THAN DST SIZE
+        db_perror("overwrite of pre-existing dst prevented due "
+            "to DBSetAllowOverwrites(0)", E_BADARGS, dstName?dstName:srcName);
+        return 0;
+    }
+
+    return 1;
+}
+
+#define COPY_TOC_ENTRY(TOC, NM, NUM, NAM)                        \
+    NUM = TOC->n ## NM;                                          \
+    NAM = (char **) malloc(NUM * sizeof(char*));                 \
+    for (int q = 0 ; q < NUM; q++)                               \
+    {                                                            \
+        int len = strlen(TOC->NM ## _names[q]);                  \
+        NAM[q] = (char*) calloc(len+1,1);                        \
+        strncpy(NAM[q], TOC->NM ## _names[q],len);               \
+    }
+
+#define FREE_COPIED_TOC_ENTRY(NUM, NAM)                          \
+    for (int q = 0; q < NUM; q++)                                \
+        FREE(NAM[q]);                                            \
+    FREE(NAM);
+
+/*-------------------------------------------------------------------------
+ * Function: db_can_overwrite_dstobj_with_srcobj
+ *
+ * Purpose: Compare two objects, member-by-member, to ensure the source
+ * object is smaller than (e.g. will fit into the same file space as) the
+ * destination object. There is possible recursion if the object contains
+ * sub-objects (e.g. a zonelist object within an ucd mesh object).
+ *
+ * Returns: 1 if source object matches destination object *and* fits in
+ *            in same space destination object occupies.
+ *          0 otherwise.
+ *
+ * Programmer:  Mark C. Miller, Wed Apr 18 09:23:55  PDT 2018
+ *
+ *-------------------------------------------------------------------------*/
+static int
+db_can_overwrite_dstobj_with_srcobj(
+    DBfile *srcFile, char const *srcAbsName,
+    DBfile *dstFile, char const *dstAbsName)
+{
+    int q;
+    int retval = 0; /* assume it won't work */
+    DBobject *srcObj = 0;
+    DBobject *dstObj = 0;
+
+    srcObj = DBGetObject(srcFile, srcAbsName);
+    if (!srcObj) goto done;
+
+    dstObj = DBGetObject(dstFile, dstAbsName);
+    if (!dstObj) goto done;
+
+    for (q = 0; q < srcObj->ncomponents; q++)
+    {
+        int r, dstr = -1;;
+        char const *curr_compname = srcObj->comp_names[q];
+
+        for (r = 0; r < dstObj->ncomponents && dstr==-1; r++)
+            if (!strcmp(curr_compname, dstObj->comp_names[r]))
+                dstr = r;
+
+        if (dstr == -1) goto done; /* no matching comp in dst */
+
+        if (!strncmp(srcObj->pdb_names[q], "'<i>", 4))
+            continue;
+        else if (!strncmp(srcObj->pdb_names[q], "'<f>", 4))
+            continue;
+        else if (!strncmp(srcObj->pdb_names[q], "'<d>", 4))
+            continue;
+        else /* possible sub-object */
+        {
+            int srcLen, dstLen, can_overwrite;
+            DBObjectType srcSubObjType, dstSubObjType;
+            char *srcSubObjName, *srcSubObjDirName, *srcSubObjAbsName;
+            char *dstSubObjName, *dstSubObjDirName, *dstSubObjAbsName;
+
+            if (!strncmp(srcObj->pdb_names[q], "'<s>", 4))
+                srcSubObjName = db_strndup(srcObj->pdb_names[q]+4, strlen(srcObj->pdb_names[q])-5);
+            else
+                srcSubObjName = db_strndup(srcObj->pdb_names[q], strlen(srcObj->pdb_names[q]));
+            srcSubObjDirName = db_dirname(srcAbsName);
+            srcSubObjAbsName = db_join_path(srcSubObjDirName, srcSubObjName);
+
+            if (!strncmp(dstObj->pdb_names[dstr], "'<s>", 4))
+                dstSubObjName = db_strndup(dstObj->pdb_names[dstr]+4, strlen(dstObj->pdb_names[dstr])-5);
+            else
+                dstSubObjName = db_strndup(dstObj->pdb_names[dstr], strlen(dstObj->pdb_names[dstr]));
+            dstSubObjDirName = db_dirname(dstAbsName);
+            dstSubObjAbsName = db_join_path(dstSubObjDirName, dstSubObjName);
+
+            /* To make exiting and cleanup logic here a tad simpler, we do all
+               the work we *might* need to with the strings and then free them. */
+#warning SHOULDNT WE USE FILE LENGTH FUNCTIONS HERE
+            srcSubObjType = DBInqVarType(srcFile, srcSubObjAbsName);
+            srcLen = DBGetVarByteLength(srcFile, srcSubObjAbsName);
+            dstSubObjType = DBInqVarType(dstFile, dstSubObjAbsName);
+            dstLen = DBGetVarByteLength(dstFile, dstSubObjAbsName);
+
+            if (dstSubObjType == DB_VARIABLE)
+                can_overwrite = 1;
+            else if (dstSubObjType == DB_DIR)
+                can_overwrite = 0;
+#warning DISALLOW SIMLINKS FOR NOW
+            else if (dstSubObjType == DB_SYMLINK)
+                can_overwrite = 0;
+            else
+                can_overwrite = db_can_overwrite_dstobj_with_srcobj(
+                    srcFile, srcSubObjAbsName, dstFile, dstSubObjAbsName); /* recursive call */
+
+            FREE(srcSubObjName);
+            FREE(srcSubObjDirName);
+            FREE(srcSubObjAbsName);
+            FREE(dstSubObjName);
+            FREE(dstSubObjDirName);
+            FREE(dstSubObjAbsName);
+
+            /* decide if its ok to proceed or not */
+            if (srcSubObjType == DB_VARIABLE && dstSubObjType == DB_VARIABLE)
             {
-                if (pass == 1)
-                    *((double*)p) = strtod(srcObj->pdb_names[j]+4, NULL);
-                p += sizeof(double);
-                if (dtyp == DB_NOTYPE) dtyp = DB_DOUBLE;
+                if (srcLen > dstLen) goto done; /* simple src var doesn't fit in dst */
             }
-            else if (!strncmp(srcObj->pdb_names[j], "'<s>", 4))
+            else if (srcSubObjType == dstSubObjType)
             {
-                int len = (int) strlen(srcObj->pdb_names[j])-5;
-                if (pass == 1)
-                {
-                     strcpy(p, srcObj->pdb_names[j]+4);
-                     p[len] = '\0';
-                }
-                p += (len+1);
-                if (dtyp == DB_NOTYPE) dtyp = DB_CHAR;
+                if (!can_overwrite) goto done; /* src object doesn't fit in dst */
             }
             else
             {
-                int len = (int) strlen(srcObj->pdb_names[j]);
-                if (pass == 1)
-                     strcpy(p, srcObj->pdb_names[j]);
-                p += (len+1);
+                goto done; /* src & dst disagree on subobject's type */
             }
         }
     }
 
-    *sertstr = db_GetDatatypeString(dtyp);
+    /* indicate it will work */
+    retval = 1;
+
+done:
+
+    if (srcObj) DBFreeObject(srcObj);
+    if (dstObj) DBFreeObject(dstObj);
+
+    return retval;
 }
 
+/*-------------------------------------------------------------------------
+ * Function:   db_copy_single_object_abspath
+ *
+ * Purpose: Copy a single source *object* to a destination object or
+ * directory using the generic object routines. The source cannot be a
+ * directory. If destination does not exist, ensure its parent is an
+ * existing directory. If destination is a pre-existing object, overwrite
+ * that object as per options and as long as it fits. If destination is a
+ * pre-existing directory, copy the source object *into* that directory.
+ *
+ * Returns: 1 If the copy succeeds.
+ *          0 Otherwise.
+ *
+ * Programmer:  Mark C. Miller, Wed Apr 18 09:23:55  PDT 2018
+ *
+ *-------------------------------------------------------------------------*/
 static int
-db_validate_copy_step(int pass, int recurse,
-    char const *srcName, char const *srcAbsName, int srcType,
-    char const *dstName, char const *dstAbsName, int dstType)
+db_copy_single_object_abspath(char const *opts,
+    DBfile *srcFile, char const *srcObjAbsName, DBObjectType srcType,
+    DBfile *dstFile, char const *dstObjAbsName, DBObjectType dstType)
 {
-    /* We validate everything 1rst pass so on 2nd, just ignore */
-    if (pass == 1) return 1;
+    int q;
+    char *_dstObjAbsName;
+    DBobject *dstObj, *srcObj;
 
-    /* Validate source object first */
+#warning CHECK ARGS HERE. ALLOW FOR NULL dstFile AND dstObjAbsName
+#warning WHY CHECK dstType HERE
+
+    /* Query type information if not already known */
     if (srcType == DB_INVALID_OBJECT)
-    {
-        db_perror("src object does not exist", E_BADARGS, srcName);
+        srcType = DBInqVarType(srcFile, srcObjAbsName);
+    if (dstType == DB_INVALID_OBJECT)
+        dstType = DBInqVarType(dstFile, dstObjAbsName);
+
+    /* Source object cannot be a directory */
+    if (srcType == DB_INVALID_OBJECT || srcType == DB_DIR)
         return 0;
+
+    /* If destination is a directory, dstObjAbsName needs to be adjusted
+       to append last component of srcObjAbsName */
+    if (dstType == DB_DIR)
+    {
+        char *bname = db_basename(srcObjAbsName);
+        _dstObjAbsName = db_join_path(dstObjAbsName, bname);
+        FREE(bname);
+    }
+    /* If destination is a pre-existing non-directory object, this implies
+       it will be overwritten by source. But, in that case, dstFile needs
+       to allow overwrites and the source needs to be small enough to fit
+       into the space the destination object occupies. */
+    else if (dstType != DB_INVALID_OBJECT)
+    {
+        int srcSize, dstSize;
+#warning USE FILE-BASED FUNCTION WHEN AVAILABLE
+        if (!DBGetAllowOverwrites())
+        {
+            db_perror("overwrite of pre-existing dst prevented due "
+                "to DBSetAllowOverwrites(0)", E_BADARGS, dstObjAbsName);
+            return 0;
+        }
+        if (!db_can_overwrite_dstobj_with_srcobj(
+             srcFile, srcObjAbsName, dstFile, dstObjAbsName))
+        {
+            db_perror("overwrite of pre-existing dst prevented due "
+                "to insufficient space for src object", E_BADARGS, dstObjAbsName);
+            return 0;
+        }
+        _dstObjAbsName = STRDUP(dstObjAbsName);
+    }
+    else
+    {
+        _dstObjAbsName = STRDUP(dstObjAbsName);
     }
 
-    if (srcType == DB_DIR && !recurse)
+    /* Access the source object using generic interface */
+    srcObj = DBGetObject(srcFile, srcObjAbsName);
+    if (!srcObj)
     {
-        db_perror("src is a directory (not copied)", E_BADARGS, srcName);
+        db_perror("Unable to access source object for copy operation",
+            E_NOTFOUND, srcObjAbsName);
         return 0;
     }
 
-    /* If destination does not exist, that is fine */
-    if (dstType == DB_INVALID_OBJECT)
-        return 1;
+    /* Handle funniness with quadmesh type strings */
+    if (srcType == DB_QUADMESH)
+    {
+        if (strstr(srcObj->type, "rect"))
+            srcType = DB_QUAD_RECT;
+        else if (strstr(srcObj->type, "curv"))
+            srcType = DB_QUAD_CURV;
+    }
+
+    /* Ok, lets do what we came here to do...create the dst object and
+       start populating it */
+    dstObj = DBMakeObject(_dstObjAbsName, srcType, srcObj->ncomponents);
+    for (q = 0; q < srcObj->ncomponents; q++)
+    {
+        int isser = 0, nser = 0;
+        char *sernm = 0, *sertstr = 0;
+        void *serd = 0;
+        CheckForComponentSeries(srcObj, q, &isser, &nser, &sernm, &sertstr, &serd);
+        if (isser)
+        {
+            long tmpn = (long) nser;
+            DBWriteComponent(dstFile, dstObj, sernm,
+                dstObj->name, sertstr, serd, 1, &tmpn);
+            free(sernm);
+            free(sertstr);
+            free(serd);
+            q += (nser-1);
+        }
+        else if (!strncmp(srcObj->pdb_names[q], "'<i>", 4))
+            DBAddIntComponent(dstObj, srcObj->comp_names[q],
+                (int) strtol(srcObj->pdb_names[q]+4, NULL, 0));
+        else if (!strncmp(srcObj->pdb_names[q], "'<f>", 4))
+            DBAddFltComponent(dstObj, srcObj->comp_names[q],
+                (float) strtod(srcObj->pdb_names[q]+4, NULL));
+        else if (!strncmp(srcObj->pdb_names[q], "'<d>", 4))
+            DBAddDblComponent(dstObj, srcObj->comp_names[q],
+                strtod(srcObj->pdb_names[q]+4, NULL));
+        else
+        {
+            DBObjectType subObjType;
+            char *subObjName;
+            char *srcObjDirName, *srcSubObjAbsName;
+             
+            if (!strncmp(srcObj->pdb_names[q], "'<s>", 4))
+                subObjName = db_strndup(srcObj->pdb_names[q]+4, strlen(srcObj->pdb_names[q])-5);
+            else
+                subObjName = db_strndup(srcObj->pdb_names[q], strlen(srcObj->pdb_names[q]));
+
+            srcObjDirName = db_dirname(srcObjAbsName);
+            srcSubObjAbsName = db_join_path(srcObjDirName, subObjName);
+
+            subObjType = DBInqVarType(srcFile, srcSubObjAbsName);
+            if (subObjType == DB_VARIABLE) /* raw data copy */
+            {
+                int j, dims[32];
+                long ldims[32];
+                int idtype = DBGetVarType(srcFile, srcSubObjAbsName);
+                int ndims = DBGetVarDims(srcFile, srcSubObjAbsName, 32, dims);
+                void *data = DBGetVar(srcFile, srcSubObjAbsName);
+                char *dtype = db_GetDatatypeString(idtype);
+                for (j = 0; j < ndims; ldims[j] = (long) dims[j], j++);
+                DBWriteComponent(dstFile, dstObj, srcObj->comp_names[q],
+                    dstObj->name, dtype, data, ndims, ldims);
+                FREE(dtype);
+                FREE(data);
+            }
+            else if (((srcType == DB_UCDMESH) && /* possible recurse on sub-object */
+                      (subObjType == DB_FACELIST || subObjType == DB_EDGELIST ||
+                       subObjType == DB_ZONELIST || subObjType == DB_PHZONELIST)) ||
+                     (srcType == DB_CSGMESH && subObjType == DB_CSGZONELIST)) 
+            {
+                char *dstObjDirName = db_dirname(dstObjAbsName);
+                char *dstSubObjAbsName = db_join_path(dstObjDirName, subObjName);
+
+                db_copy_single_object_abspath(opts, /* recursive call */
+                   srcFile, srcSubObjAbsName, subObjType,
+                   dstFile, dstSubObjAbsName, DB_INVALID_OBJECT);
+
+                DBAddStrComponent(dstObj, srcObj->comp_names[q], subObjName);
 
-    /* If pre-existing destination type isn't same as src, that is a problem */
-    if (dstType != srcType)
-    {
-        db_perror("pre-existing dst object type mismatch with src", E_BADARGS,
-            dstName?dstName:srcName);
-        return 0;
+                FREE(dstObjDirName);
+                FREE(dstSubObjAbsName);
+            }
+            free(subObjName);
+            free(srcObjDirName);
+            free(srcSubObjAbsName);
+        }
     }
 
-    /* If we get here, we're overwriting the destination object and that
-       is ok only if AllowOverwrites is enabled *and* the src object
-       can fit within the space used by the dst object, the latter piece
-       of logic we cannot currently check. */
-    if (!DBGetAllowOverwrites())
-    {
-#warning ONLY IF SRC SIZE SMALLER THAN DST SIZE
-        db_perror("overwrite of pre-existing dst prevented due "
-            "to DBSetAllowOverwrites(0)", E_BADARGS, dstName?dstName:srcName);
-        return 0;
-    }
+    DBWriteObject(dstFile, dstObj, SILO_Globals.allowOverwrites);
+    DBFreeObject(srcObj);
+    DBFreeObject(dstObj);
+    FREE(_dstObjAbsName);
 
     return 1;
 }
 
-#define COPY_TOC_ENTRY(TOC, NM, NUM, NAM)                        \
-    NUM = TOC->n ## NM;                                          \
-    NAM = (char **) malloc(NUM * sizeof(char*));                 \
-    for (int q = 0 ; q < NUM; q++)                               \
-    {                                                            \
-        int len = strlen(TOC->NM ## _names[q]);                  \
-        NAM[q] = (char*) calloc(len+1,1);                        \
-        strncpy(NAM[q], TOC->NM ## _names[q],len);               \
-    }
-
-#define FREE_COPIED_TOC_ENTRY(NUM, NAM)                          \
-    for (int q = 0; q < NUM; q++)                                \
-        FREE(NAM[q]);                                            \
-    FREE(NAM);
-
 /*-------------------------------------------------------------------------
- * Function: db_can_overwrite_dstobj_with_srcobj
+ * Function:    DBCp
  *
- * Purpose: Compare two objects, member-by-member, to ensure the source
- * object is smaller than (e.g. will fit into the same file space as) the
- * destination object. There is possible recursion if the object contains
- * sub-objects (e.g. a zonelist object within an ucd mesh object).
+ * Purpose:     The Silo equivalent of a unix `cp` command obeying all unix
+ *              semantics and applicable flags. In particular...
  *
- * Returns: 1 if source object matches destination object *and* fits in
- *            in same space destination object occupies.
- *          0 otherwise.
+ *    Single src object to single dst object
+ *        DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile,
+ *            char const *srcPATH, char const *dstPATH, DB_EOA);
+ *
+ *    Multiple src objects to single dst (dir) object
+ *        DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile,
+ *            char const *srcPATH1, char const *srcPATH2, ...,
+ *            char const *dstDIR, DB_EOA);
+ *
+ *    Multiple src objects to multiple dst objects
+ *        DBCp("-2...", DBfile *srcFile, DBfile *dstFile,
+ *            char const *srcPATH1, char const *dstPATH1,
+ *            char const *srcPATH2, char const *dstPATH2,
+ *            char const *srcPATH3, char const *dstPATH3, ..., DB_EOA);
+ *
+ *    srcFile and dstFile may be the same Silo file. srcFile cannot be null.
+ *    dstFile may be null in which case it is assumed same as srcFile.
+ *    The argument list *must* be terminated by the DB_EOA sentinel. Just as
+ *    for unix `cp`, the options and their meanings are...
+ *
+ *      -R/-r recurse on any directory objects
+ *      -L/-P dereference links / never dereference links
+ *      -d    preserve links
+ *      -s/-l don't actually copy, just sym/hard link
+ *            (only possible when srcFile==dstFile)
+ *
+ *    Other rules:
+ *       * If any src is a dir, then it is an error without -R/-r.
+ *       * If cooresponding dst exists and is a dir, src is copied
+ *         into (e.g. becomes a child of) dst.
+ *       * If cooresponding dst exists and is not a dir (e.g. is just a
+ *         normal Silo object), then it is an error if src is not also the 
+ *         same kind of Silo object. The copy overwrites (destructive) dst.
+ *         However, if the file space dst object occupies is smaller than
+ *         that needed to copy src, behavior is indeterminate but most 
+ *         likely will result the dst file (not just the dst object) being
+ *         corrupted.
+ *
+ *    The following options are specific to Silo's DBCp method and are
+ *    mutually exclusive...
+ *
+ *      -2 treat varargs list of args as src/dst path pairs and where any
+ *         null dst is inferred to have same path as associated src except
+           that relative paths are interpreted relative to dst files cwg.
+ *      -1 like -2 except caller passes only src paths. All dst paths are
+ *         inferred to be same as associated src path. The dst file's cwg
+ *         will then determine how any relative src paths are interpreted.
+ *      -3 only 3 args follow the dstFile arg...
+ *         int N                number of objects in the following lists
+ *         DBCAS_t srcPathNames list of N source path names
+ *         DBCAS_t dstPathNames list of N destination path names
+ *      -4 Like -3, except 3rd arg is treated as a single dest. dir name
+ *         int N                number of paths in srcPathNames
+ *         DBCAS_t srcPathNames list of N source path names
+ *         char const *dstDIR   pre-existing destination dir path name.
+ *      -5 Internal use only...like -4 except used only internally when
+ *         DBCp recursively calls itself.
+ *
+ *      If none of the preceding numeric arguments are specified, then
+ *      the varags list of args is treated as (default) where the last
+ *      is a pre-existing destination directory and all the others are
+ *      the paths of source objects to be copied into that directory.
+ *
+ *      Relative path names are interpreted relative to the current working
+ *      directory of the associated (src or dst) file when DBCp is invoked.
+ *
+ *      In all the different ways this function can be invoked, there are
+ *      really just two fundamentally different interpretations of the list(s)
+ *      of names. Either each source path is paired also with a destination
+ *      path or all source paths go into a single destination path which, just
+ *      as for linux cp, must then also be a directory already present in the
+ *      destination.
+ *
+ * Return:      Success:        0
+ *              Failure:       -1
  *
  * Programmer:  Mark C. Miller, Wed Apr 18 09:23:55  PDT 2018
  *
  *-------------------------------------------------------------------------*/
-static int
-db_can_overwrite_dstobj_with_srcobj(
-    DBfile *srcFile, char const *srcAbsName,
-    DBfile *dstFile, char const *dstAbsName)
+PUBLIC int
+DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile, ...)
 {
-    int q;
-    int retval = 0; /* assume it won't work */
-    DBobject *srcObj = 0;
-    DBobject *dstObj = 0;
-
-    srcObj = DBGetObject(srcFile, srcAbsName);
-    if (!srcObj) goto done;
-
-    dstObj = DBGetObject(dstFile, dstAbsName);
-    if (!dstObj) goto done;
+#warning WHAT ABOUT API MACROS. MAYBE NOT NEEDED SINCE NOT CALLING DOWN INTO DRIVERS
+#warning WHAT ABOUT -f (force) OPTION
+    char const *me = "DBCp";
+    int i, j, pass, all_ok;
+    int recurse_on_dirs = 0;
+    int preserve_links = 0;
+    int deref_links = 0;
+    int never_deref_links = 0;
+    int dont_copy_just_symlink = 0;
+    int dont_copy_just_hardlink = 0;
+    int src_dst_pairs = 0;
+    int srcs_only = 0;
+    int n_src_dst_triple = 0;
+    int n_src_dir_triple = 0;
+    int recursive_call = 0;
+    char const *many_to_one_dir = 0;
+    int N = 0;
+    char const **srcPathNames = 0, **dstPathNames = 0;
+    char srcStartCwg[1024], dstStartCwg[1024];
 
-    for (q = 0; q < srcObj->ncomponents; q++)
+#warning WARN ABOUT CERTAIN OPTIONS NOT YET SUPPORTED
+    /* process any options in the opts string */
+    for (i = 0; opts && opts[i]; i++)
     {
-        int r, dstr = -1;;
-        char const *curr_compname = srcObj->comp_names[q];
-
-        for (r = 0; r < dstObj->ncomponents && dstr==-1; r++)
-            if (!strcmp(curr_compname, dstObj->comp_names[r]))
-                dstr = r;
-
-        if (dstr == -1) goto done; /* no matching comp in dst */
-
-        if (!strncmp(srcObj->pdb_names[q], "'<i>", 4))
-            continue;
-        else if (!strncmp(srcObj->pdb_names[q], "'<f>", 4))
-            continue;
-        else if (!strncmp(srcObj->pdb_names[q], "'<d>", 4))
-            continue;
-        else /* possible sub-object */
+        switch (opts[i])
         {
-            int srcLen, dstLen, can_overwrite;
-            DBObjectType srcSubObjType, dstSubObjType;
-            char *srcSubObjName, *srcSubObjDirName, *srcSubObjAbsName;
-            char *dstSubObjName, *dstSubObjDirName, *dstSubObjAbsName;
-
-            if (!strncmp(srcObj->pdb_names[q], "'<s>", 4))
-                srcSubObjName = db_strndup(srcObj->pdb_names[q]+4, strlen(srcObj->pdb_names[q])-5);
-            else
-                srcSubObjName = db_strndup(srcObj->pdb_names[q], strlen(srcObj->pdb_names[q]));
-            srcSubObjDirName = db_dirname(srcAbsName);
-            srcSubObjAbsName = db_join_path(srcSubObjDirName, srcSubObjName);
-
-            if (!strncmp(dstObj->pdb_names[dstr], "'<s>", 4))
-                dstSubObjName = db_strndup(dstObj->pdb_names[dstr]+4, strlen(dstObj->pdb_names[dstr])-5);
-            else
-                dstSubObjName = db_strndup(dstObj->pdb_names[dstr], strlen(dstObj->pdb_names[dstr]));
-            dstSubObjDirName = db_dirname(dstAbsName);
-            dstSubObjAbsName = db_join_path(dstSubObjDirName, dstSubObjName);
-
-            /* To make exiting and cleanup logic here a tad simpler, we do all
-               the work we *might* need to with the strings and then free them. */
-#warning SHOULDNT WE USE FILE LENGTH FUNCTIONS HERE
-            srcSubObjType = DBInqVarType(srcFile, srcSubObjAbsName);
-            srcLen = DBGetVarByteLength(srcFile, srcSubObjAbsName);
-            dstSubObjType = DBInqVarType(dstFile, dstSubObjAbsName);
-            dstLen = DBGetVarByteLength(dstFile, dstSubObjAbsName);
+            case ' ':
+            case '-': continue;
+            case 'R':
+            case 'r': recurse_on_dirs = 1; break;
+            case 'd': preserve_links = 1; break;
+            case 'L': deref_links = 1; break;
+            case 'P': never_deref_links = 1; break;
+            case 's': dont_copy_just_symlink = 1; break;
+            case 'l': dont_copy_just_hardlink = 1; break;
+            case '2': src_dst_pairs = 1; break;
+            case '1': srcs_only = 1; break;
+            case '3': n_src_dst_triple = 1; break;
+            case '4': n_src_dir_triple = 1; break;
+            case '5': n_src_dir_triple = 1; recursive_call = 1; break;
+            default: return db_perror(&opts[i], E_BADARGS, me);
+        }
+    }
 
-            if (dstSubObjType == DB_VARIABLE)
-                can_overwrite = 1;
-            else if (dstSubObjType == DB_DIR)
-                can_overwrite = 0;
-#warning DISALLOW SIMLINKS FOR NOW
-            else if (dstSubObjType == DB_SYMLINK)
-                can_overwrite = 0;
-            else
-                can_overwrite = db_can_overwrite_dstobj_with_srcobj(
-                    srcFile, srcSubObjAbsName, dstFile, dstSubObjAbsName); /* recursive call */
+    /* Sanity checks */
+    if (!dstFile)
+        dstFile = srcFile;
 
-            FREE(srcSubObjName);
-            FREE(srcSubObjDirName);
-            FREE(srcSubObjAbsName);
-            FREE(dstSubObjName);
-            FREE(dstSubObjDirName);
-            FREE(dstSubObjAbsName);
+    if (!srcFile)
+        return db_perror("srcFile cannot be null", E_BADARGS, me);
 
-            /* decide if its ok to proceed or not */
-            if (srcSubObjType == DB_VARIABLE && dstSubObjType == DB_VARIABLE)
-            {
-                if (srcLen > dstLen) goto done; /* simple src var doesn't fit in dst */
-            }
-            else if (srcSubObjType == dstSubObjType)
+    if ((dont_copy_just_symlink || dont_copy_just_hardlink) && srcFile != dstFile)
+        return db_perror("srcFile and dstFile must be same for -s or -l", E_BADARGS, me);
+
+
+    if (n_src_dst_triple || n_src_dir_triple) // -3 or -4
+    {
+        va_list ap;
+        va_start(ap, dstFile);
+        N = va_arg(ap, int);
+        srcPathNames = va_arg(ap, char const **);
+        if (n_src_dst_triple)
+            dstPathNames = va_arg(ap, char const **);
+        else
+            many_to_one_dir = va_arg(ap, char const *);
+        va_end(ap);
+    }
+    else
+    {
+        /* Process varargs in two passes. Pass 1, count them. Pass 2
+           allocate space and capture them. */
+        int pass;
+
+        for (pass = 0; pass < 2; pass++)
+        {
+            int n = 0;
+            char const *arg;
+            va_list ap;
+            va_start(ap, dstFile);
+            if (pass == 1)
             {
-                if (!can_overwrite) goto done; /* src object doesn't fit in dst */
+                srcPathNames = (char const **) malloc(N * sizeof(char const *));
+                if (src_dst_pairs)
+                    dstPathNames = (char const **) malloc(N * sizeof(char const *));
             }
-            else
+            while ((arg = va_arg(ap, char const *)) != DB_EOA)
             {
-                goto done; /* src & dst disagree on subobject's type */
+                if (pass == 1)
+                {
+                    if (src_dst_pairs)
+                    {
+                        if (n%2) dstPathNames[n/2] = arg;
+                        else     srcPathNames[n/2] = arg;
+                    }
+                    else
+                    {
+                        srcPathNames[n] = arg;
+                    }
+                }
+                n++;
             }
+            va_end(ap);
+            N = src_dst_pairs?n/2:n;
         }
     }
 
-    /* indicate it will work */
-    retval = 1;
+#warning FIX LEAKS WITH EARLY RETURN HERE
 
-done:
+    if (n_src_dir_triple && N == 0)
+        return 0;
+    if (!n_src_dir_triple && N < 2)
+        return db_perror("src or dst unspecified", E_BADARGS, me);
+    if (src_dst_pairs && N%2)
+        return db_perror("non-even arg count for -2 option", E_BADARGS, me);
 
-    if (srcObj) DBFreeObject(srcObj);
-    if (dstObj) DBFreeObject(dstObj);
+    /* target dir is at end of list of sources */
+    if (!many_to_one_dir && !src_dst_pairs && !n_src_dst_triple && !n_src_dir_triple)
+    {
+        many_to_one_dir = srcPathNames[N-1];
+        N--;
+    }
 
-    return retval;
-}
+    if (many_to_one_dir)
+    {
+        int q;
+        dstPathNames = (char const **) malloc(N * sizeof(char const *));
+        for (q = 0; q < N; q++)
+            dstPathNames[q] = many_to_one_dir; /* all point to same char* */
+    }
 
-/*-------------------------------------------------------------------------
- * Function:   db_copy_single_object_abspath
- *
- * Purpose: Copy a single source *object* to a destination object or
- * directory using the generic object routines. The source cannot be a
- * directory. If destination does not exist, ensure its parent is an
- * existing directory. If destination is a pre-existing object, overwrite
- * that object as per options and as long as it fits. If destination is a
- * pre-existing directory, copy the source object *into* that directory.
- *
- * Returns: 1 If the copy succeeds.
- *          0 Otherwise.
- *
- * Programmer:  Mark C. Miller, Wed Apr 18 09:23:55  PDT 2018
- *
- *-------------------------------------------------------------------------*/
-static int
-db_copy_single_object_abspath(char const *opts,
-    DBfile *srcFile, char const *srcObjAbsName, DBObjectType srcType,
-    DBfile *dstFile, char const *dstObjAbsName, DBObjectType dstType)
-{
-    int q;
-    char *_dstObjAbsName;
-    DBobject *dstObj, *srcObj;
+    DBGetDir(srcFile, srcStartCwg);
+    DBGetDir(dstFile, dstStartCwg);
 
-#warning CHECK ARGS HERE. ALLOW FOR NULL dstFile AND dstObjAbsName
-#warning WHY CHECK dstType HERE
+    for (i = 0; i < N; i++)
+    {
+        DBObjectType srcType, dstType;
+        char *srcObjAbsName, *dstObjAbsName;
+        char savcwg[1024], srccwg[1024], dstcwg[1024];
+        char opts2[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+        char **dirItems, **otherItems;
+        int  dirItemCount, otherItemCount;
 
-    /* Query type information if not already known */
-    if (srcType == DB_INVALID_OBJECT)
+        if (i == 0)
+        {
+            DBGetDir(srcFile, srccwg);
+            DBGetDir(dstFile, dstcwg);
+        }
+
+        srcObjAbsName = db_join_path(srccwg, srcPathNames[i]);
         srcType = DBInqVarType(srcFile, srcObjAbsName);
-    if (dstType == DB_INVALID_OBJECT)
+
+        dstObjAbsName = db_join_path(dstcwg, dstPathNames[i]?dstPathNames[i]:srcPathNames[i]);
         dstType = DBInqVarType(dstFile, dstObjAbsName);
 
-    /* Source object cannot be a directory */
-    if (srcType == DB_INVALID_OBJECT || srcType == DB_DIR)
-        return 0;
+        if (srcType == DB_INVALID_OBJECT)
+        {
+            db_perror(DBSPrintf("\"%s\" invalid object", srcObjAbsName), E_BADARGS, me);
+            goto endLoop;
+        }
 
-    /* If destination is a directory, dstObjAbsName needs to be adjusted
-       to append last component of srcObjAbsName */
-    if (dstType == DB_DIR)
-    {
-        char *bname = db_basename(srcObjAbsName);
-        _dstObjAbsName = db_join_path(dstObjAbsName, bname);
-        FREE(bname);
-    }
-    /* If destination is a pre-existing non-directory object, this implies
-       it will be overwritten by source. But, in that case, dstFile needs
-       to allow overwrites and the source needs to be small enough to fit
-       into the space the destination object occupies. */
-    else if (dstType != DB_INVALID_OBJECT)
-    {
-        int srcSize, dstSize;
-#warning USE FILE-BASED FUNCTION WHEN AVAILABLE
-        if (!DBGetAllowOverwrites())
+        if (srcType != DB_DIR)
         {
-            db_perror("overwrite of pre-existing dst prevented due "
-                "to DBSetAllowOverwrites(0)", E_BADARGS, dstObjAbsName);
-            return 0;
+            if (!db_copy_single_object_abspath(opts, 
+                    srcFile, srcObjAbsName, srcType,
+                    dstFile, dstObjAbsName, dstType))
+            {
+                db_perror("Object copy failed", E_CALLFAIL, me);
+                goto endLoop;
+            }
+            continue;
         }
-        if (!db_can_overwrite_dstobj_with_srcobj(
-             srcFile, srcObjAbsName, dstFile, dstObjAbsName))
+
+        /* If we get this far into the loop body here, then src is a dir */
+        if (!recurse_on_dirs)
         {
-            db_perror("overwrite of pre-existing dst prevented due "
-                "to insufficient space for src object", E_BADARGS, dstObjAbsName);
-            return 0;
+            db_perror(DBSPrintf("Cannot copy dir \"%s\" without -r flag",
+                srcObjAbsName), E_BADARGS, me);
+            goto endLoop;
         }
-        _dstObjAbsName = STRDUP(dstObjAbsName);
-    }
-    else
-    {
-        _dstObjAbsName = STRDUP(dstObjAbsName);
-    }
 
-    /* Access the source object using generic interface */
-    srcObj = DBGetObject(srcFile, srcObjAbsName);
-    if (!srcObj)
-    {
-        db_perror("Unable to access source object for copy operation",
-            E_NOTFOUND, srcObjAbsName);
-        return 0;
-    }
+        if (dstType != DB_INVALID_OBJECT && dstType != DB_DIR)
+        {
+            db_perror(DBSPrintf("Cannot copy dir \"%s\" onto pre-existing non-dir \"%s\"",
+                srcObjAbsName, dstObjAbsName), E_BADARGS, me);
+            goto endLoop;
+        }
 
-    /* Handle funniness with quadmesh type strings */
-    if (srcType == DB_QUADMESH)
-    {
-        if (strstr(srcObj->type, "rect"))
-            srcType = DB_QUAD_RECT;
-        else if (strstr(srcObj->type, "curv"))
-            srcType = DB_QUAD_CURV;
-    }
+#if 0
+        /* get the contents of this dir in two lists; all the dirs, everything else */
+        DBLs(srcFile, DBSPrintf("-d %s", srcObjAbsName), 0, &dirItemCount); /* just count it first */
+        dirItems = ALLOC_N(char*, ++dirItemCount);
+        DBLs(srcFile, DBSPrintf("-d %s", srcObjAbsName), dirItems, &dirItemCount);
 
-    /* Ok, lets do what we came here to do...create the dst object and
-       start populating it */
-    dstObj = DBMakeObject(_dstObjAbsName, srcType, srcObj->ncomponents);
-    for (q = 0; q < srcObj->ncomponents; q++)
-    {
-        int isser = 0, nser = 0;
-        char *sernm = 0, *sertstr = 0;
-        void *serd = 0;
-        CheckForComponentSeries(srcObj, q, &isser, &nser, &sernm, &sertstr, &serd);
-        if (isser)
+        DBLs(srcFile, DBSPrintf("-a -d %s", srcObjAbsName), 0, &otherItemCount); /* just count it first */
+        otherItems = ALLOC_N(char*, ++otherItemCount);
+        DBLs(srcFile, DBSPrintf("-a -d %s", srcObjAbsName), otherItems, &otherItemCount);
+#endif
+        /* get the contents of this dir */
+        DBSetDir(srcFile, srcObjAbsName);
+        DBLs(srcFile, "-a -x", 0, &dirItemCount); /* just count it first */
+        dirItems = ALLOC_N(char*, dirItemCount);
+        DBLs(srcFile, "-a -x", dirItems, &dirItemCount);
+
+        if (dstType == DB_INVALID_OBJECT)
         {
-            long tmpn = (long) nser;
-            DBWriteComponent(dstFile, dstObj, sernm,
-                dstObj->name, sertstr, serd, 1, &tmpn);
-            free(sernm);
-            free(sertstr);
-            free(serd);
-            q += (nser-1);
+            DBMkDir(dstFile, dstObjAbsName);
+            DBSetDir(dstFile, dstObjAbsName);
         }
-        else if (!strncmp(srcObj->pdb_names[q], "'<i>", 4))
-            DBAddIntComponent(dstObj, srcObj->comp_names[q],
-                (int) strtol(srcObj->pdb_names[q]+4, NULL, 0));
-        else if (!strncmp(srcObj->pdb_names[q], "'<f>", 4))
-            DBAddFltComponent(dstObj, srcObj->comp_names[q],
-                (float) strtod(srcObj->pdb_names[q]+4, NULL));
-        else if (!strncmp(srcObj->pdb_names[q], "'<d>", 4))
-            DBAddDblComponent(dstObj, srcObj->comp_names[q],
-                strtod(srcObj->pdb_names[q]+4, NULL));
+        else if (dstType == DB_DIR)
+        {
+            char const *srcDirBaseName = db_basename(srcObjAbsName);
+            DBMkDir(dstFile, srcDirBaseName);
+            DBSetDir(dstFile, srcDirBaseName);
+            free(srcDirBaseName);
+        }
+
+        if (n_src_dir_triple)
+            DBCp(opts, srcFile, dstFile, dirItemCount, dirItems, ".");
         else
-        {
-            DBObjectType subObjType;
-            char *subObjName;
-            char *srcObjDirName, *srcSubObjAbsName;
-             
-            if (!strncmp(srcObj->pdb_names[q], "'<s>", 4))
-                subObjName = db_strndup(srcObj->pdb_names[q]+4, strlen(srcObj->pdb_names[q])-5);
-            else
-                subObjName = db_strndup(srcObj->pdb_names[q], strlen(srcObj->pdb_names[q]));
+            DBCp(DBSPrintf("%s -4", opts), srcFile, dstFile, dirItemCount, dirItems, ".");
 
-            srcObjDirName = db_dirname(srcObjAbsName);
-            srcSubObjAbsName = db_join_path(srcObjDirName, subObjName);
+        DBSetDir(srcFile, "..");
+        DBSetDir(dstFile, "..");
 
-            subObjType = DBInqVarType(srcFile, srcSubObjAbsName);
-            if (subObjType == DB_VARIABLE) /* raw data copy */
-            {
-                int j, dims[32];
-                long ldims[32];
-                int idtype = DBGetVarType(srcFile, srcSubObjAbsName);
-                int ndims = DBGetVarDims(srcFile, srcSubObjAbsName, 32, dims);
-                void *data = DBGetVar(srcFile, srcSubObjAbsName);
-                char *dtype = db_GetDatatypeString(idtype);
-                for (j = 0; j < ndims; ldims[j] = (long) dims[j], j++);
-                DBWriteComponent(dstFile, dstObj, srcObj->comp_names[q],
-                    dstObj->name, dtype, data, ndims, ldims);
-                FREE(dtype);
-                FREE(data);
-            }
-            else if (((srcType == DB_UCDMESH) && /* possible recurse on sub-object */
-                      (subObjType == DB_FACELIST || subObjType == DB_EDGELIST ||
-                       subObjType == DB_ZONELIST || subObjType == DB_PHZONELIST)) ||
-                     (srcType == DB_CSGMESH && subObjType == DB_CSGZONELIST)) 
-            {
-                char *dstObjDirName = db_dirname(dstObjAbsName);
-                char *dstSubObjAbsName = db_join_path(dstObjDirName, subObjName);
+endLoop:
+        FREE(srcObjAbsName);
+        FREE(dstObjAbsName);
+    }
 
-                db_copy_single_object_abspath(opts, /* recursive call */
-                   srcFile, srcSubObjAbsName, subObjType,
-                   dstFile, dstSubObjAbsName, DB_INVALID_OBJECT);
+    DBSetDir(srcFile, srcStartCwg);
+    DBSetDir(dstFile, dstStartCwg);
+}
 
-                DBAddStrComponent(dstObj, srcObj->comp_names[q], subObjName);
+#if 1
+PUBLIC int
+DBCpListedObjects(int nobjs,
+    DBfile *dbfile, char const * const *srcObjs,
+    DBfile *dstFile, char const * const *dstObjs)
+{
+    int retval;
 
-                FREE(dstObjDirName);
-                FREE(dstSubObjAbsName);
+    API_BEGIN2("DBCpListedObjects", int, -1, api_dummy) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!dstFile)
+            API_ERROR(NULL, E_NOFILE);
+        if (db_isregistered_file(dstFile,0)==-1)
+            API_ERROR(NULL, E_NOTREG);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR(NULL, E_GRABBED); 
+        if (nobjs > 0)
+        {
+            if (!srcObjs)
+                API_ERROR("source object names list", E_BADARGS);
+            if (dstObjs)
+            {
+                int i;
+                for (i = 0; i < nobjs; i++)
+                {
+                    if (dstObjs[i] == 0 || dstObjs[i][0] == '\0')
+                        continue;
+                    if (db_VariableNameValid(dstObjs[i]) == 0)
+                        API_ERROR(dstObjs[i], E_INVALIDNAME);
+                }
             }
-            free(subObjName);
-            free(srcObjDirName);
-            free(srcSubObjAbsName);
         }
+        if (!dbfile->pub.cpnobjs)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+        retval = (dbfile->pub.cpnobjs) (nobjs, dbfile, srcObjs, dstFile, dstObjs);
+        db_FreeToc(dbfile);
+        API_RETURN(retval);
     }
-
-    DBWriteObject(dstFile, dstObj, SILO_Globals.allowOverwrites);
-    DBFreeObject(srcObj);
-    DBFreeObject(dstObj);
-    FREE(_dstObjAbsName);
-
-    return 1;
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+#else
+#warning REMOVE ABOVE IF STATEMENT
+PUBLIC int
+DBCpListedObjects(int nobjs,
+    DBfile *dbfile, char const * const *srcObjs,
+    DBfile *dstFile, char const * const *dstObjs)
+{
 }
+#endif
 
 /*-------------------------------------------------------------------------
- * Function:    DBCp
+ * Function:    DBChangeObject
  *
- * Purpose:     The Silo equivalent of a unix `cp` command obeying all unix
- *              semantics and applicable flags. In particular...
+ * Purpose:     Overwrites an object with a new object.  This is usually
+ *              the same function as called by DBWriteObject but with
+ *              OVER_WRITE as the flag.  However, we keep it as a separate
+ *              callback so existing drivers that don't support overwriting
+ *              don't need to be changed and so that the silo API doesn't
+ *              change by changing the meaning of the `freemem' argument
+ *              to DBWriteObject.
  *
- *    Single src object to single dst object
- *        DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile,
- *            char const *srcPATH, char const *dstPATH, DB_EOA);
+ * Return:      Success:        0
  *
- *    Multiple src objects to single dst (dir) object
- *        DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile,
- *            char const *srcPATH1, char const *srcPATH2, ...,
- *            char const *dstDIR, DB_EOA);
+ *              Failure:        -1
  *
- *    Multiple src objects to multiple dst objects
- *        DBCp("-2...", DBfile *srcFile, DBfile *dstFile,
- *            char const *srcPATH1, char const *dstPATH1,
- *            char const *srcPATH2, char const *dstPATH2,
- *            char const *srcPATH3, char const *dstPATH3, ..., DB_EOA);
+ * Programmer:  Robb Matzke
+ *              robb@maya.nuance.mdn.com
+ *              Mar  7 1997
  *
- *    srcFile and dstFile may be the same Silo file. srcFile cannot be null.
- *    dstFile may be null in which case it is assumed same as srcFile.
- *    The argument list *must* be terminated by the DB_EOA sentinel. Just as
- *    for unix `cp`, the options and their meanings are...
+ * Modifications:
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Completely reformatted the code so a human can read it.  Made the error
+ *    messages a little better.
  *
- *      -R/-r recurse on any directory objects
- *      -L/-P dereference links / never dereference links
- *      -d    preserve links
- *      -s/-l don't actually copy, just sym/hard link
- *            (only possible when srcFile==dstFile)
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBChangeObject (DBfile *dbfile, DBobject const *obj)
+{
+    int             retval;
+
+    API_BEGIN2("DBChangeObject", int, -1, api_dummy)
+    {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBChangeObject", E_GRABBED) ; 
+        if (!obj)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!dbfile->pub.c_obj)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+        retval = (dbfile->pub.c_obj) (dbfile, obj, OVER_WRITE);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;                     /* BEWARE: If API_RETURN is removed 
+                                        * use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBWriteObject
  *
- *    Other rules:
- *       * If any src is a dir, then it is an error without -R/-r.
- *       * If cooresponding dst exists and is a dir, src is copied
- *         into (e.g. becomes a child of) dst.
- *       * If cooresponding dst exists and is not a dir (e.g. is just a
- *         normal Silo object), then it is an error if src is not also the 
- *         same kind of Silo object. The copy overwrites (destructive) dst.
- *         However, if the file space dst object occupies is smaller than
- *         that needed to copy src, behavior is indeterminate but most 
- *         likely will result the dst file (not just the dst object) being
- *         corrupted.
+ * Purpose:     Write an object into the data file.
  *
- *    The following options are specific to Silo's DBCp method and are
- *    mutually exclusive...
+ * Return:      Success:        0
  *
- *      -2 treat varargs list of args as src/dst path pairs and where any
- *         null dst is inferred to have same path as associated src except
-           that relative paths are interpreted relative to dst files cwg.
- *      -1 like -2 except caller passes only src paths. All dst paths are
- *         inferred to be same as associated src path. The dst file's cwg
- *         will then determine how any relative src paths are interpreted.
- *      -3 only 3 args follow the dstFile arg...
- *         int N                number of objects in the following lists
- *         DBCAS_t srcPathNames list of N source path names
- *         DBCAS_t dstPathNames list of N destination path names
- *      -4 Like -3, except 3rd arg is treated as a single dest. dir name
- *         int N                number of paths in srcPathNames
- *         DBCAS_t srcPathNames list of N source path names
- *         char const *dstDIR   pre-existing destination dir path name.
- *      -5 Internal use only...like -4 except used only internally when
- *         DBCp recursively calls itself.
+ *              Failure:        -1
  *
- *      If none of the preceding numeric arguments are specified, then
- *      the varags list of args is treated as (default) where the last
- *      is a pre-existing destination directory and all the others are
- *      the paths of source objects to be copied into that directory.
+ * Programmer:  matzke@viper
+ *              Mon Nov  7 10:45:14 PST 1994
  *
- *      Relative path names are interpreted relative to the current working
- *      directory of the associated (src or dst) file when DBCp is invoked.
+ * Modifications:
+ *    Robb Matzke, Mon Nov 21 21:37:54 EST 1994
+ *    Added error mechanism.
  *
- *      In all the different ways this function can be invoked, there are
- *      really just two fundamentally different interpretations of the list(s)
- *      of names. Either each source path is paired also with a destination
- *      path or all source paths go into a single destination path which, just
- *      as for linux cp, must then also be a directory already present in the
- *      destination.
+ *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
+ *    I replaced API_END with API_END_NOPOP.
+ *
+ *    Robb Matzke, 7 Mar 1997
+ *    The freemem value passed to the driver is either FREE_MEM or zero
+ *    so that drivers that overload this function with DBChangeObject
+ *    are guaranteed to be able to tell the difference.
+ *
+ *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
+ *    Made the error messages a little better.
+ *
+ *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
+ *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBWriteObject(DBfile *dbfile, DBobject const *obj, int freemem)
+{
+    int retval;
+
+    API_BEGIN2("DBWriteObject", int, -1, api_dummy)
+    {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (SILO_Globals.enableGrabDriver == TRUE)
+            API_ERROR("DBWriteObject", E_GRABBED) ; 
+        if (!obj)
+            API_ERROR("object pointer", E_BADARGS);
+        if (!DBGetAllowOverwritesFile(dbfile) && DBInqVarExists(dbfile, obj->name))
+            API_ERROR("overwrite not allowed", E_NOOVERWRITE);
+        if (!dbfile->pub.w_obj)
+            API_ERROR(dbfile->pub.name, E_NOTIMP);
+
+        retval = (dbfile->pub.w_obj) (dbfile, obj, freemem?FREE_MEM:0);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_comp
  *
- * Return:      Success:        0
- *              Failure:       -1
+ * Purpose:     Return the absolute name of the dataset or sub-object
+ *              stored as component COMP of the object OBJ, whose own
+ *              absolute name is ABSNAME.
  *
- * Programmer:  Mark C. Miller, Wed Apr 18 09:23:55  PDT 2018
+ * Return:      Success:        malloc'd name
  *
+ *              Failure:        NULL, if there is no such component
  *-------------------------------------------------------------------------*/
-PUBLIC int
-DBCp(char const *opts, DBfile *srcFile, DBfile *dstFile, ...)
+PRIVATE char *
+db_partial_comp(DBobject const *obj, char const *absname, char const *comp)
 {
-#warning WHAT ABOUT API MACROS. MAYBE NOT NEEDED SINCE NOT CALLING DOWN INTO DRIVERS
-#warning WHAT ABOUT -f (force) OPTION
-    char const *me = "DBCp";
-    int i, j, pass, all_ok;
-    int recurse_on_dirs = 0;
-    int preserve_links = 0;
-    int deref_links = 0;
-    int never_deref_links = 0;
-    int dont_copy_just_symlink = 0;
-    int dont_copy_just_hardlink = 0;
-    int src_dst_pairs = 0;
-    int srcs_only = 0;
-    int n_src_dst_triple = 0;
-    int n_src_dir_triple = 0;
-    int recursive_call = 0;
-    char const *many_to_one_dir = 0;
-    int N = 0;
-    char const **srcPathNames = 0, **dstPathNames = 0;
-    char srcStartCwg[1024], dstStartCwg[1024];
+    int i;
 
-#warning WARN ABOUT CERTAIN OPTIONS NOT YET SUPPORTED
-    /* process any options in the opts string */
-    for (i = 0; opts && opts[i]; i++)
+    for (i = 0; i < obj->ncomponents; i++)
     {
-        switch (opts[i])
-        {
-            case ' ':
-            case '-': continue;
-            case 'R':
-            case 'r': recurse_on_dirs = 1; break;
-            case 'd': preserve_links = 1; break;
-            case 'L': deref_links = 1; break;
-            case 'P': never_deref_links = 1; break;
-            case 's': dont_copy_just_symlink = 1; break;
-            case 'l': dont_copy_just_hardlink = 1; break;
-            case '2': src_dst_pairs = 1; break;
-            case '1': srcs_only = 1; break;
-            case '3': n_src_dst_triple = 1; break;
-            case '4': n_src_dir_triple = 1; break;
-            case '5': n_src_dir_triple = 1; recursive_call = 1; break;
-            default: return db_perror(&opts[i], E_BADARGS, me);
-        }
-    }
-
-    /* Sanity checks */
-    if (!dstFile)
-        dstFile = srcFile;
-
-    if (!srcFile)
-        return db_perror("srcFile cannot be null", E_BADARGS, me);
+        char const *p = obj->pdb_names[i];
+        char *cname, *dname, *retval;
 
-    if ((dont_copy_just_symlink || dont_copy_just_hardlink) && srcFile != dstFile)
-        return db_perror("srcFile and dstFile must be same for -s or -l", E_BADARGS, me);
+        if (strcmp(obj->comp_names[i], comp))
+            continue;
+        if (!strncmp(p, "'<s>", 4))
+            cname = db_strndup(p+4, strlen(p)-5);
+        else if (p[0] == '\'')
+            return NULL;
+        else
+            cname = STRDUP(p);
+        dname = db_dirname(absname);
+        retval = db_join_path(dname, cname);
+        FREE(dname);
+        FREE(cname);
+        return retval;
+    }
+    return NULL;
+}
 
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_index_list
+ *
+ * Purpose:     Turn the indices passed to DBGetPartialObject into a list
+ *              of linear indices into an object with logical dims ODIMS.
+ *
+ *              With ndims==1 indices are linear. Otherwise ndims must
+ *              match ondims and indices are logical tuples in the
+ *              object's major order. Hyperslabs are <start,count,stride>
+ *              per dimension and are walked with the first dimension
+ *              varying fastest. The shape of the result is returned in
+ *              RNDIMS and RDIMS: the counts of a single hyperslab, or a
+ *              1D list otherwise.
+ *
+ * Return:      Success:        malloc'd list of *N indices
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE int *
+db_partial_index_list(int mode, int nvals, int ndims, int const *indices,
+    int ondims, int const *odims, int major_order, int *n, int *rndims,
+    int *rdims)
+{
+    static char const *me = "db_partial_index_list";
+    int i, j, k, nels = 1, dims[3], stride[3], *lin;
 
-    if (n_src_dst_triple || n_src_dir_triple) // -3 or -4
+    for (i = 0; i < ondims; i++)
+        nels *= odims[i];
+    if (ndims == 1)
     {
-        va_list ap;
-        va_start(ap, dstFile);
-        N = va_arg(ap, int);
-        srcPathNames = va_arg(ap, char const **);
-        if (n_src_dst_triple)
-            dstPathNames = va_arg(ap, char const **);
-        else
-            many_to_one_dir = va_arg(ap, char const *);
-        va_end(ap);
+        dims[0] = nels;
+        stride[0] = 1;
+    }
+    else if (ndims == ondims)
+    {
+        for (i = 0; i < ndims; i++)
+            dims[i] = odims[i];
+        _DBQQCalcStride(stride, dims, ndims, major_order);
     }
     else
     {
-        /* Process varargs in two passes. Pass 1, count them. Pass 2
-           allocate space and capture them. */
-        int pass;
+        db_perror("ndims", E_BADARGS, me);
+        return NULL;
+    }
 
-        for (pass = 0; pass < 2; pass++)
+    if (mode == DB_PARTIO_POINTS)
+    {
+        if ((lin = ALLOC_N(int, nvals)) == NULL)
         {
-            int n = 0;
-            char const *arg;
-            va_list ap;
-            va_start(ap, dstFile);
-            if (pass == 1)
-            {
-                srcPathNames = (char const **) malloc(N * sizeof(char const *));
-                if (src_dst_pairs)
-                    dstPathNames = (char const **) malloc(N * sizeof(char const *));
-            }
-            while ((arg = va_arg(ap, char const *)) != DB_EOA)
+            db_perror(NULL, E_NOMEM, me);
+            return NULL;
+        }
+        for (i = 0; i < nvals; i++)
+        {
+            lin[i] = 0;
+            for (j = 0; j < ndims; j++)
             {
-                if (pass == 1)
+                int c = indices[i*ndims+j];
+                if (c < 0 || c >= dims[j])
                 {
-                    if (src_dst_pairs)
-                    {
-                        if (n%2) dstPathNames[n/2] = arg;
-                        else     srcPathNames[n/2] = arg;
-                    }
-                    else
-                    {
-                        srcPathNames[n] = arg;
-                    }
+                    FREE(lin);
+                    db_perror("index out of range", E_BADARGS, me);
+                    return NULL;
                 }
-                n++;
+                lin[i] += c * stride[j];
             }
-            va_end(ap);
-            N = src_dst_pairs?n/2:n;
         }
+        *n = nvals;
+        *rndims = 1;
+        rdims[0] = nvals;
+        return lin;
     }
 
-#warning FIX LEAKS WITH EARLY RETURN HERE
-
-    if (n_src_dir_triple && N == 0)
-        return 0;
-    if (!n_src_dir_triple && N < 2)
-        return db_perror("src or dst unspecified", E_BADARGS, me);
-    if (src_dst_pairs && N%2)
-        return db_perror("non-even arg count for -2 option", E_BADARGS, me);
-
-    /* target dir is at end of list of sources */
-    if (!many_to_one_dir && !src_dst_pairs && !n_src_dst_triple && !n_src_dir_triple)
+    /* Hyperslabs; check them and count their elements first */
+    *n = 0;
+    for (i = 0; i < nvals; i++)
     {
-        many_to_one_dir = srcPathNames[N-1];
-        N--;
+        int const *slab = indices + i*ndims*3;
+        int cnt = 1;
+        for (j = 0; j < ndims; j++)
+        {
+            if (slab[3*j] < 0 || slab[3*j+1] < 1 || slab[3*j+2] < 1 ||
+                slab[3*j] + (slab[3*j+1]-1) * slab[3*j+2] >= dims[j])
+            {
+                db_perror("hyperslab out of range", E_BADARGS, me);
+                return NULL;
+            }
+            cnt *= slab[3*j+1];
+        }
+        *n += cnt;
     }
-
-    if (many_to_one_dir)
+    if ((lin = ALLOC_N(int, *n)) == NULL)
     {
-        int q;
-        dstPathNames = (char const **) malloc(N * sizeof(char const *));
-        for (q = 0; q < N; q++)
-            dstPathNames[q] = many_to_one_dir; /* all point to same char* */
+        db_perror(NULL, E_NOMEM, me);
+        return NULL;
     }
-
-    DBGetDir(srcFile, srcStartCwg);
-    DBGetDir(dstFile, dstStartCwg);
-
-    for (i = 0; i < N; i++)
+    for (i = 0, k = 0; i < nvals; i++)
     {
-        DBObjectType srcType, dstType;
-        char *srcObjAbsName, *dstObjAbsName;
-        char savcwg[1024], srccwg[1024], dstcwg[1024];
-        char opts2[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-        char **dirItems, **otherItems;
-        int  dirItemCount, otherItemCount;
-
-        if (i == 0)
-        {
-            DBGetDir(srcFile, srccwg);
-            DBGetDir(dstFile, dstcwg);
-        }
-
-        srcObjAbsName = db_join_path(srccwg, srcPathNames[i]);
-        srcType = DBInqVarType(srcFile, srcObjAbsName);
-
-        dstObjAbsName = db_join_path(dstcwg, dstPathNames[i]?dstPathNames[i]:srcPathNames[i]);
-        dstType = DBInqVarType(dstFile, dstObjAbsName);
-
-        if (srcType == DB_INVALID_OBJECT)
-        {
-            db_perror(DBSPrintf("\"%s\" invalid object", srcObjAbsName), E_BADARGS, me);
-            goto endLoop;
-        }
-
-        if (srcType != DB_DIR)
+        int const *slab = indices + i*ndims*3;
+        int c[3] = {0, 0, 0};
+        while (c[ndims-1] < slab[3*(ndims-1)+1])
         {
-            if (!db_copy_single_object_abspath(opts, 
-                    srcFile, srcObjAbsName, srcType,
-                    dstFile, dstObjAbsName, dstType))
-            {
-                db_perror("Object copy failed", E_CALLFAIL, me);
-                goto endLoop;
-            }
-            continue;
+            lin[k] = 0;
+            for (j = 0; j < ndims; j++)
+                lin[k] += (slab[3*j] + c[j] * slab[3*j+2]) * stride[j];
+            k++;
+            for (j = 0; j < ndims-1 && ++c[j] == slab[3*j+1]; j++)
+                c[j] = 0;
+            if (j == ndims-1)
+                c[j]++;
         }
+    }
+    if (nvals == 1 && ndims > 1)
+    {
+        *rndims = ndims;
+        for (j = 0; j < ndims; j++)
+            rdims[j] = indices[3*j+1];
+    }
+    else
+    {
+        *rndims = 1;
+        rdims[0] = *n;
+    }
+    return lin;
+}
 
-        /* If we get this far into the loop body here, then src is a dir */
-        if (!recurse_on_dirs)
-        {
-            db_perror(DBSPrintf("Cannot copy dir \"%s\" without -r flag",
-                srcObjAbsName), E_BADARGS, me);
-            goto endLoop;
-        }
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_vals
+ *
+ * Purpose:     Read the N elements of dataset DSNAME at the linear
+ *              indices LIN with the driver's r_varvals callback. The
+ *              data is treated as a flat array whatever shape the file
+ *              gives the dataset.
+ *
+ * Return:      Success:        malloc'd array of *DATATYPE values
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE void *
+db_partial_vals(DBfile *dbfile, char const *dsname, int n, int const *lin,
+    int *datatype)
+{
+    static char const *me = "db_partial_vals";
+    int i, j, ndims, dims[MAXDIMS_VARWRITE], ncomps, nitems, *idx;
+    void *vals = NULL;
 
-        if (dstType != DB_INVALID_OBJECT && dstType != DB_DIR)
+    if (!dsname)
+    {
+        db_perror("missing dataset", E_NOTFOUND, me);
+        return NULL;
+    }
+    if ((ndims = DBGetVarDims(dbfile, dsname, MAXDIMS_VARWRITE, dims)) <= 0 ||
+        (*datatype = DBGetVarType(dbfile, dsname)) < 0)
+    {
+        db_perror(dsname, E_CALLFAIL, me);
+        return NULL;
+    }
+    if ((idx = ALLOC_N(int, n*ndims)) == NULL)
+    {
+        db_perror(NULL, E_NOMEM, me);
+        return NULL;
+    }
+    for (i = 0; i < n; i++)
+    {
+        int L = lin[i];
+        for (j = ndims-1; j >= 0; j--)
         {
-            db_perror(DBSPrintf("Cannot copy dir \"%s\" onto pre-existing non-dir \"%s\"",
-                srcObjAbsName, dstObjAbsName), E_BADARGS, me);
-            goto endLoop;
+            idx[i*ndims+j] = L % dims[j];
+            L /= dims[j];
         }
+    }
+    if (DBReadVarVals(dbfile, dsname, DB_PARTIO_POINTS, n, ndims, idx,
+            &vals, &ncomps, &nitems) < 0)
+    {
+        FREE(vals);
+        vals = NULL;
+    }
+    FREE(idx);
+    return vals;
+}
 
-#if 0
-        /* get the contents of this dir in two lists; all the dirs, everything else */
-        DBLs(srcFile, DBSPrintf("-d %s", srcObjAbsName), 0, &dirItemCount); /* just count it first */
-        dirItems = ALLOC_N(char*, ++dirItemCount);
-        DBLs(srcFile, DBSPrintf("-d %s", srcObjAbsName), dirItems, &dirItemCount);
+/* Ascending order of node numbers */
+PRIVATE int
+db_partial_intcmp(void const *a, void const *b)
+{
+    int ia = *((int const *) a), ib = *((int const *) b);
+    return ia < ib ? -1 : ia > ib;
+}
 
-        DBLs(srcFile, DBSPrintf("-a -d %s", srcObjAbsName), 0, &otherItemCount); /* just count it first */
-        otherItems = ALLOC_N(char*, ++otherItemCount);
-        DBLs(srcFile, DBSPrintf("-a -d %s", srcObjAbsName), otherItems, &otherItemCount);
-#endif
-        /* get the contents of this dir */
-        DBSetDir(srcFile, srcObjAbsName);
-        DBLs(srcFile, "-a -x", 0, &dirItemCount); /* just count it first */
-        dirItems = ALLOC_N(char*, dirItemCount);
-        DBLs(srcFile, "-a -x", dirItems, &dirItemCount);
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_material
+ *
+ * Purpose:     Read the material at ABSNAME for a subset of its zones.
+ *              Mixed zones are followed down their mix_next chains with
+ *              one read per link, for all of the chains at once, and the
+ *              mix arrays are rebuilt to hold just those entries, with
+ *              mix_next and mix_zone remapped to the subset. If OMIX is
+ *              non-null the index in the file of each entry is returned
+ *              there so variables can read matching mixed values.
+ *
+ * Return:      Success:        material
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE DBmaterial *
+db_partial_material(DBfile *dbfile, char const *absname, int mode, int nvals,
+    int ndims, int const *indices, int **omix)
+{
+    static char const *me = "db_partial_material";
+    DBmaterial *mat = NULL;
+    DBobject *obj = NULL;
+    char *ds[4] = {NULL, NULL, NULL, NULL};
+    int i, k, n, dt, nmix = 0, nf, nround = 0, rndims, rdims[3];
+    int *lin = NULL, *matlist = NULL, *next = NULL;
+    int *mix = NULL, *mixzone = NULL, *mixnext = NULL;
+    int *fcur = NULL, *fprev = NULL, *fzone = NULL;
+    int *ncur = NULL, *nprev = NULL, *nzone = NULL, *tmp;
+
+    DBSetDataReadMask2File(dbfile, DBMatMatnos|DBMatMatnames|DBMatMatcolors);
+    mat = DBGetMaterial(dbfile, absname);
+    DBSetDataReadMask2File(dbfile, DBNone);
+    if (!mat || (obj = DBGetObject(dbfile, absname)) == NULL)
+        goto fail;
+    ds[0] = db_partial_comp(obj, absname, "matlist");
+    ds[1] = db_partial_comp(obj, absname, "mix_next");
+    ds[2] = db_partial_comp(obj, absname, "mix_mat");
+    ds[3] = db_partial_comp(obj, absname, "mix_vf");
+
+    if ((lin = db_partial_index_list(mode, nvals, ndims, indices, mat->ndims,
+             mat->dims, mat->major_order, &n, &rndims, rdims)) == NULL ||
+        (matlist = (int *) db_partial_vals(dbfile, ds[0], n, lin, &dt)) == NULL)
+        goto fail;
+
+    fcur = ALLOC_N(int, n); fprev = ALLOC_N(int, n); fzone = ALLOC_N(int, n);
+    ncur = ALLOC_N(int, n); nprev = ALLOC_N(int, n); nzone = ALLOC_N(int, n);
+    if (!fcur || !fprev || !fzone || !ncur || !nprev || !nzone)
+    {
+        db_perror(NULL, E_NOMEM, me);
+        goto fail;
+    }
+    for (i = 0, nf = 0; i < n; i++)
+    {
+        if (matlist[i] >= 0) continue;
+        fcur[nf] = -matlist[i] - 1;
+        fprev[nf] = -1;
+        fzone[nf++] = i;
+    }
 
-        if (dstType == DB_INVALID_OBJECT)
+    /* Walk one link of every chain per pass */
+    while (nf > 0)
+    {
+        int nn = 0;
+
+        if (nround++ > mat->mixlen)
         {
-            DBMkDir(dstFile, dstObjAbsName);
-            DBSetDir(dstFile, dstObjAbsName);
+            db_perror("mix_next cycle", E_BADARGS, me);
+            goto fail;
         }
-        else if (dstType == DB_DIR)
+        for (k = 0; k < nf; k++)
         {
-            char const *srcDirBaseName = db_basename(srcObjAbsName);
-            DBMkDir(dstFile, srcDirBaseName);
-            DBSetDir(dstFile, srcDirBaseName);
-            free(srcDirBaseName);
+            if (fcur[k] < 0 || fcur[k] >= mat->mixlen)
+            {
+                db_perror("mix index out of range", E_BADARGS, me);
+                goto fail;
+            }
+        }
+        if ((tmp = (int *) realloc(mix, (nmix+nf)*sizeof(int))) == NULL)
+            goto nomem;
+        mix = tmp;
+        if ((tmp = (int *) realloc(mixzone, (nmix+nf)*sizeof(int))) == NULL)
+            goto nomem;
+        mixzone = tmp;
+        if ((tmp = (int *) realloc(mixnext, (nmix+nf)*sizeof(int))) == NULL)
+            goto nomem;
+        mixnext = tmp;
+        for (k = 0; k < nf; k++)
+        {
+            int e = nmix + k;
+            mix[e] = fcur[k];
+            mixzone[e] = fzone[k];
+            mixnext[e] = 0;
+            if (fprev[k] < 0)
+                matlist[fzone[k]] = -(e+1);
+            else
+                mixnext[fprev[k]] = e+1;
+        }
+        if ((next = (int *) db_partial_vals(dbfile, ds[1], nf, fcur, &dt)) == NULL)
+            goto fail;
+        for (k = 0; k < nf; k++)
+        {
+            if (next[k] == 0) continue;
+            ncur[nn] = next[k] - 1;
+            nprev[nn] = nmix + k;
+            nzone[nn++] = fzone[k];
         }
+        FREE(next);
+        nmix += nf;
+        nf = nn;
+        tmp = fcur; fcur = ncur; ncur = tmp;
+        tmp = fprev; fprev = nprev; nprev = tmp;
+        tmp = fzone; fzone = nzone; nzone = tmp;
+    }
+
+    FREE(mat->matlist);
+    mat->matlist = matlist;
+    matlist = NULL;
+    mat->ndims = rndims;
+    for (i = 0; i < 3; i++)
+        mat->dims[i] = i < rndims ? rdims[i] : 0;
+    mat->major_order = DB_ROWMAJOR;
+    _DBQQCalcStride(mat->stride, mat->dims, mat->ndims, mat->major_order);
+    mat->mixlen = nmix;
+    if (nmix > 0)
+    {
+        if ((mat->mix_mat = (int *) db_partial_vals(dbfile, ds[2], nmix, mix, &dt)) == NULL ||
+            (mat->mix_vf = db_partial_vals(dbfile, ds[3], nmix, mix, &mat->datatype)) == NULL)
+            goto fail;
+        for (i = 0; i < nmix; i++)
+            mixzone[i] += mat->origin;
+        mat->mix_next = mixnext;
+        mat->mix_zone = mixzone;
+        mixnext = mixzone = NULL;
+    }
 
-        if (n_src_dir_triple)
-            DBCp(opts, srcFile, dstFile, dirItemCount, dirItems, ".");
-        else
-            DBCp(DBSPrintf("%s -4", opts), srcFile, dstFile, dirItemCount, dirItems, ".");
+    if (omix)
+    {
+        *omix = mix;
+        mix = NULL;
+    }
+    FREE(mix); FREE(mixzone); FREE(mixnext); FREE(lin);
+    FREE(fcur); FREE(fprev); FREE(fzone); FREE(ncur); FREE(nprev); FREE(nzone);
+    for (i = 0; i < 4; i++) FREE(ds[i]);
+    DBFreeObject(obj);
+    return mat;
+
+nomem:
+    db_perror(NULL, E_NOMEM, me);
+fail:
+    FREE(mix); FREE(mixzone); FREE(mixnext); FREE(lin); FREE(matlist);
+    FREE(fcur); FREE(fprev); FREE(fzone); FREE(ncur); FREE(nprev); FREE(nzone);
+    for (i = 0; i < 4; i++) FREE(ds[i]);
+    if (obj) DBFreeObject(obj);
+    if (mat) DBFreeMaterial(mat);
+    return NULL;
+}
 
-        DBSetDir(srcFile, "..");
-        DBSetDir(dstFile, "..");
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_mixvals
+ *
+ * Purpose:     Read the mixed values of a variable for a subset of its
+ *              zones. Which entries belong to those zones is only known
+ *              from the material, so this needs DBOPT_MATNAME in OPTIONS
+ *              (relative to the variable's directory). Without it no
+ *              mixed values are read.
+ *
+ * Return:      Success:        number of mixed values, stored in MIXVALS
+ *
+ *              Failure:        -1
+ *-------------------------------------------------------------------------*/
+PRIVATE int
+db_partial_mixvals(DBfile *dbfile, char const *absname, DBobject const *obj,
+    int ncomps, int mode, int nvals, int ndims, int const *indices,
+    DBoptlist const *options, void ***mixvals, int *datatype)
+{
+    static char const *me = "db_partial_mixvals";
+    char const *matname = (char const *) DBGetOption(options, DBOPT_MATNAME);
+    char *dname, *matabs, tmp[64];
+    DBmaterial *mat;
+    int i, mixlen, *omix = NULL;
+
+    *mixvals = NULL;
+    if (!matname)
+        return 0;
+    dname = db_dirname(absname);
+    matabs = db_join_path(dname, matname);
+    mat = db_partial_material(dbfile, matabs, mode, nvals, ndims, indices, &omix);
+    FREE(dname);
+    FREE(matabs);
+    if (!mat)
+        return -1;
+    mixlen = mat->mixlen;
+    DBFreeMaterial(mat);
+    if (mixlen == 0)
+        return 0;
 
-endLoop:
-        FREE(srcObjAbsName);
-        FREE(dstObjAbsName);
+    if ((*mixvals = ALLOC_N(void *, ncomps)) == NULL)
+    {
+        FREE(omix);
+        return db_perror(NULL, E_NOMEM, me);
     }
-
-    DBSetDir(srcFile, srcStartCwg);
-    DBSetDir(dstFile, dstStartCwg);
+    for (i = 0; i < ncomps; i++)
+    {
+        char *ds;
+        sprintf(tmp, "mixed_value%d", i);
+        ds = db_partial_comp(obj, absname, tmp);
+        (*mixvals)[i] = db_partial_vals(dbfile, ds, mixlen, omix, datatype);
+        FREE(ds);
+        if (!(*mixvals)[i])
+        {
+            FREE(omix);
+            return -1;
+        }
+    }
+    FREE(omix);
+    return mixlen;
 }
 
-#if 1
-PUBLIC int
-DBCpListedObjects(int nobjs,
-    DBfile *dbfile, char const * const *srcObjs,
-    DBfile *dstFile, char const * const *dstObjs)
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_vars
+ *
+ * Purpose:     Read components value0..value<ncomps-1> of the variable
+ *              at ABSNAME at the linear indices LIN.
+ *
+ * Return:      Success:        malloc'd array of NCOMPS value arrays
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE void **
+db_partial_vars(DBfile *dbfile, char const *absname, DBobject const *obj,
+    int ncomps, int n, int const *lin, int *datatype)
 {
-    int retval;
+    void **vals;
+    char tmp[64];
+    int i;
 
-    API_BEGIN2("DBCpListedObjects", int, -1, api_dummy) {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (!dstFile)
-            API_ERROR(NULL, E_NOFILE);
-        if (db_isregistered_file(dstFile,0)==-1)
-            API_ERROR(NULL, E_NOTREG);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR(NULL, E_GRABBED); 
-        if (nobjs > 0)
+    if ((vals = ALLOC_N(void *, ncomps)) == NULL)
+    {
+        db_perror(NULL, E_NOMEM, "db_partial_vars");
+        return NULL;
+    }
+    for (i = 0; i < ncomps; i++)
+    {
+        char *ds;
+        sprintf(tmp, "value%d", i);
+        ds = db_partial_comp(obj, absname, tmp);
+        vals[i] = db_partial_vals(dbfile, ds, n, lin, datatype);
+        FREE(ds);
+        if (!vals[i])
         {
-            if (!srcObjs)
-                API_ERROR("source object names list", E_BADARGS);
-            if (dstObjs)
-            {
-                int i;
-                for (i = 0; i < nobjs; i++)
-                {
-                    if (dstObjs[i] == 0 || dstObjs[i][0] == '\0')
-                        continue;
-                    if (db_VariableNameValid(dstObjs[i]) == 0)
-                        API_ERROR(dstObjs[i], E_INVALIDNAME);
-                }
-            }
+            while (i > 0) FREE(vals[--i]);
+            FREE(vals);
+            return NULL;
         }
-        if (!dbfile->pub.cpnobjs)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        retval = (dbfile->pub.cpnobjs) (nobjs, dbfile, srcObjs, dstFile, dstObjs);
-        db_FreeToc(dbfile);
-        API_RETURN(retval);
     }
-    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
+    return vals;
 }
-#else
-#warning REMOVE ABOVE IF STATEMENT
-PUBLIC int
-DBCpListedObjects(int nobjs,
-    DBfile *dbfile, char const * const *srcObjs,
-    DBfile *dstFile, char const * const *dstObjs)
+
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_ucdvar
+ *
+ * Purpose:     Read a ucd variable for a subset of its elements.
+ *
+ * Return:      Success:        variable
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE DBucdvar *
+db_partial_ucdvar(DBfile *dbfile, char const *absname, int mode, int nvals,
+    int ndims, int const *indices, DBoptlist const *options)
 {
+    DBucdvar *uv;
+    DBobject *obj = NULL;
+    int n, rndims, rdims[3], mixlen = 0, *lin = NULL;
+
+    if ((uv = DBGetUcdvar(dbfile, absname)) == NULL ||
+        (obj = DBGetObject(dbfile, absname)) == NULL ||
+        (lin = db_partial_index_list(mode, nvals, ndims, indices, 1, &uv->nels,
+             DB_ROWMAJOR, &n, &rndims, rdims)) == NULL ||
+        (uv->vals = db_partial_vars(dbfile, absname, obj, uv->nvals, n, lin,
+             &uv->datatype)) == NULL)
+        goto fail;
+    uv->nels = n;
+    if (uv->mixlen > 0 && uv->centering == DB_ZONECENT &&
+        (mixlen = db_partial_mixvals(dbfile, absname, obj, uv->nvals, mode,
+             nvals, ndims, indices, options, &uv->mixvals, &uv->datatype)) < 0)
+        goto fail;
+    uv->mixlen = mixlen;
+    FREE(lin);
+    DBFreeObject(obj);
+    return uv;
+
+fail:
+    FREE(lin);
+    if (obj) DBFreeObject(obj);
+    if (uv) DBFreeUcdvar(uv);
+    return NULL;
 }
-#endif
 
 /*-------------------------------------------------------------------------
- * Function:    DBChangeObject
+ * Function:    db_partial_quadvar
  *
- * Purpose:     Overwrites an object with a new object.  This is usually
- *              the same function as called by DBWriteObject but with
- *              OVER_WRITE as the flag.  However, we keep it as a separate
- *              callback so existing drivers that don't support overwriting
- *              don't need to be changed and so that the silo API doesn't
- *              change by changing the meaning of the `freemem' argument
- *              to DBWriteObject.
+ * Purpose:     Read a quad variable for a subset of its elements. A
+ *              single hyperslab keeps its logical shape; anything else
+ *              comes back as a 1D list.
  *
- * Return:      Success:        0
+ * Return:      Success:        variable
  *
- *              Failure:        -1
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE DBquadvar *
+db_partial_quadvar(DBfile *dbfile, char const *absname, int mode, int nvals,
+    int ndims, int const *indices, DBoptlist const *options)
+{
+    DBquadvar *qv;
+    DBobject *obj = NULL;
+    int i, n, rndims, rdims[3], mixlen = 0, *lin = NULL;
+
+    if ((qv = DBGetQuadvar(dbfile, absname)) == NULL ||
+        (obj = DBGetObject(dbfile, absname)) == NULL ||
+        (lin = db_partial_index_list(mode, nvals, ndims, indices, qv->ndims,
+             qv->dims, qv->major_order, &n, &rndims, rdims)) == NULL ||
+        (qv->vals = db_partial_vars(dbfile, absname, obj, qv->nvals, n, lin,
+             &qv->datatype)) == NULL)
+        goto fail;
+    qv->nels = n;
+    qv->ndims = rndims;
+    for (i = 0; i < 3; i++)
+    {
+        qv->dims[i] = i < rndims ? rdims[i] : 0;
+        qv->min_index[i] = 0;
+        qv->max_index[i] = i < rndims ? rdims[i] - 1 : 0;
+    }
+    qv->major_order = DB_ROWMAJOR;
+    _DBQQCalcStride(qv->stride, qv->dims, qv->ndims, qv->major_order);
+    if (qv->mixlen > 0 && qv->centering == DB_ZONECENT &&
+        (mixlen = db_partial_mixvals(dbfile, absname, obj, qv->nvals, mode,
+             nvals, ndims, indices, options, &qv->mixvals, &qv->datatype)) < 0)
+        goto fail;
+    qv->mixlen = mixlen;
+    FREE(lin);
+    DBFreeObject(obj);
+    return qv;
+
+fail:
+    FREE(lin);
+    if (obj) DBFreeObject(obj);
+    if (qv) DBFreeQuadvar(qv);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    db_partial_ucdmesh
  *
- * Programmer:  Robb Matzke
- *              robb@maya.nuance.mdn.com
- *              Mar  7 1997
+ * Purpose:     Read a ucd mesh for a subset of its zones. Only the
+ *              nodelist entries of those zones and the coordinates of
+ *              the nodes they use are read. Zones keep the order they
+ *              were asked for, nodes are renumbered from 0 in ascending
+ *              order, and gzoneno and gnodeno hold their indices in the
+ *              whole mesh. Extents are those of the whole mesh.
  *
- * Modifications:
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Completely reformatted the code so a human can read it.  Made the error
- *    messages a little better.
+ * Return:      Success:        mesh
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *              Failure:        NULL
  *-------------------------------------------------------------------------*/
-PUBLIC int
-DBChangeObject (DBfile *dbfile, DBobject const *obj)
+PRIVATE DBucdmesh *
+db_partial_ucdmesh(DBfile *dbfile, char const *absname, int mode, int nvals,
+    int ndims, int const *indices)
 {
-    int             retval;
+    static char const *me = "db_partial_ucdmesh";
+    DBucdmesh *um = NULL;
+    DBzonelist *zl = NULL, *nzl = NULL;
+    DBobject *obj = NULL, *zlobj = NULL;
+    char *zlname = NULL, *ds = NULL, tmp[64];
+    int i, j, n, dt, nl, nnodes, rndims, rdims[3];
+    int *lin = NULL, *shapecnt = NULL, *shapesize = NULL, *shapetype = NULL;
+    int *zstart = NULL, *nlstart = NULL, *zgroup = NULL, *nllin = NULL;
+    int *nodelist = NULL, *nodes = NULL;
+
+    if ((um = DBGetUcdmesh(dbfile, absname)) == NULL ||
+        (obj = DBGetObject(dbfile, absname)) == NULL)
+        goto fail;
+    if ((zlname = db_partial_comp(obj, absname, "zonelist")) == NULL)
+    {
+        db_perror("mesh has no zonelist", E_NOTIMP, me);
+        goto fail;
+    }
+    if ((zl = DBGetZonelist(dbfile, zlname)) == NULL ||
+        (zlobj = DBGetObject(dbfile, zlname)) == NULL ||
+        (lin = db_partial_index_list(mode, nvals, ndims, indices, 1,
+             &zl->nzones, DB_ROWMAJOR, &n, &rndims, rdims)) == NULL)
+        goto fail;
+
+    /* The shape arrays are small; read them whole */
+    shapecnt = ALLOC_N(int, zl->nshapes);
+    shapesize = ALLOC_N(int, zl->nshapes);
+    shapetype = ALLOC_N(int, zl->nshapes);
+    zstart = ALLOC_N(int, zl->nshapes+1);
+    nlstart = ALLOC_N(int, zl->nshapes+1);
+    zgroup = ALLOC_N(int, n);
+    if (!shapecnt || !shapesize || !shapetype || !zstart || !nlstart || !zgroup)
+        goto nomem;
+    if ((ds = db_partial_comp(zlobj, zlname, "shapecnt")) == NULL ||
+        DBReadVar(dbfile, ds, shapecnt) < 0)
+        goto fail;
+    FREE(ds);
+    if ((ds = db_partial_comp(zlobj, zlname, "shapesize")) == NULL ||
+        DBReadVar(dbfile, ds, shapesize) < 0)
+        goto fail;
+    FREE(ds);
+    if ((ds = db_partial_comp(zlobj, zlname, "shapetype")) != NULL &&
+        DBReadVar(dbfile, ds, shapetype) < 0)
+        goto fail;
+    FREE(ds);
+    for (i = 0; i < zl->nshapes; i++)
+    {
+        if (shapetype[i] == DB_ZONETYPE_POLYHEDRON)
+        {
+            db_perror("polyhedral zones", E_NOTIMP, me);
+            goto fail;
+        }
+        zstart[i+1] = zstart[i] + shapecnt[i];
+        nlstart[i+1] = nlstart[i] + shapecnt[i] * shapesize[i];
+    }
 
-    API_BEGIN2("DBChangeObject", int, -1, api_dummy)
+    /* Find each zone's shape group and its slice of the nodelist */
+    for (i = 0, nl = 0; i < n; i++)
     {
-        if (!dbfile)
-            API_ERROR(NULL, E_NOFILE);
-        if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBChangeObject", E_GRABBED) ; 
-        if (!obj)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!dbfile->pub.c_obj)
-            API_ERROR(dbfile->pub.name, E_NOTIMP);
-        retval = (dbfile->pub.c_obj) (dbfile, obj, OVER_WRITE);
-        API_RETURN(retval);
+        int lo = 0, hi = zl->nshapes - 1;
+        while (lo < hi)
+        {
+            int mid = (lo + hi + 1) / 2;
+            if (zstart[mid] <= lin[i]) lo = mid;
+            else hi = mid - 1;
+        }
+        zgroup[i] = lo;
+        nl += shapesize[lo];
     }
-    API_END_NOPOP;                     /* BEWARE: If API_RETURN is removed 
-                                        * use API_END */
+    if ((nllin = ALLOC_N(int, nl)) == NULL)
+        goto nomem;
+    for (i = 0, nl = 0; i < n; i++)
+    {
+        int g = zgroup[i];
+        int off = nlstart[g] + (lin[i] - zstart[g]) * shapesize[g];
+        for (j = 0; j < shapesize[g]; j++)
+            nllin[nl++] = off + j;
+    }
+    ds = db_partial_comp(zlobj, zlname, "nodelist");
+    if ((nodelist = (int *) db_partial_vals(dbfile, ds, nl, nllin, &dt)) == NULL)
+        goto fail;
+    FREE(ds);
+
+    /* Renumber the nodes these zones use */
+    if ((nodes = ALLOC_N(int, nl)) == NULL)
+        goto nomem;
+    for (i = 0; i < nl; i++)
+        nodes[i] = nodelist[i] -= zl->origin;
+    qsort(nodes, nl, sizeof(int), db_partial_intcmp);
+    for (i = 0, nnodes = 0; i < nl; i++)
+        if (i == 0 || nodes[i] != nodes[nnodes-1])
+            nodes[nnodes++] = nodes[i];
+    for (i = 0; i < nl; i++)
+        nodelist[i] = (int) ((int *) bsearch(&nodelist[i], nodes, nnodes,
+                          sizeof(int), db_partial_intcmp) - nodes);
+
+    for (i = 0; i < um->ndims; i++)
+    {
+        sprintf(tmp, "coord%d", i);
+        ds = db_partial_comp(obj, absname, tmp);
+        if ((um->coords[i] = db_partial_vals(dbfile, ds, nnodes, nodes,
+                 &um->datatype)) == NULL)
+            goto fail;
+        FREE(ds);
+    }
+
+    /* New zonelist, with a shape entry per run of like zones */
+    if ((nzl = DBAllocZonelist()) == NULL ||
+        (nzl->shapecnt = ALLOC_N(int, n)) == NULL ||
+        (nzl->shapesize = ALLOC_N(int, n)) == NULL ||
+        (nzl->shapetype = ALLOC_N(int, n)) == NULL)
+        goto nomem;
+    for (i = 0; i < n; i++)
+    {
+        int g = zgroup[i];
+        if (nzl->nshapes > 0 &&
+            nzl->shapesize[nzl->nshapes-1] == shapesize[g] &&
+            nzl->shapetype[nzl->nshapes-1] == shapetype[g])
+        {
+            nzl->shapecnt[nzl->nshapes-1]++;
+            continue;
+        }
+        nzl->shapecnt[nzl->nshapes] = 1;
+        nzl->shapesize[nzl->nshapes] = shapesize[g];
+        nzl->shapetype[nzl->nshapes++] = shapetype[g];
+    }
+    nzl->ndims = zl->ndims;
+    nzl->nzones = n;
+    nzl->nodelist = nodelist;
+    nzl->lnodelist = nl;
+    nzl->origin = 0;
+    nzl->min_index = 0;
+    nzl->max_index = n - 1;
+    nzl->gzoneno = lin;
+    nzl->gnznodtype = DB_INT;
+    nodelist = lin = NULL;
+
+    um->nnodes = nnodes;
+    um->zones = nzl;
+    um->gnodeno = nodes;
+    um->gnznodtype = DB_INT;
+    nodes = NULL;
+
+    FREE(shapecnt); FREE(shapesize); FREE(shapetype);
+    FREE(zstart); FREE(nlstart); FREE(zgroup); FREE(nllin);
+    FREE(zlname);
+    DBFreeZonelist(zl);
+    DBFreeObject(zlobj);
+    DBFreeObject(obj);
+    return um;
+
+nomem:
+    db_perror(NULL, E_NOMEM, me);
+fail:
+    FREE(lin); FREE(shapecnt); FREE(shapesize); FREE(shapetype);
+    FREE(zstart); FREE(nlstart); FREE(zgroup); FREE(nllin);
+    FREE(nodelist); FREE(nodes); FREE(ds); FREE(zlname);
+    if (nzl) DBFreeZonelist(nzl);
+    if (zl) DBFreeZonelist(zl);
+    if (zlobj) DBFreeObject(zlobj);
+    if (obj) DBFreeObject(obj);
+    if (um) DBFreeUcdmesh(um);
+    return NULL;
 }
 
 /*-------------------------------------------------------------------------
- * Function:    DBWriteObject
- *
- * Purpose:     Write an object into the data file.
- *
- * Return:      Success:        0
- *
- *              Failure:        -1
+ * Function:    DBGetPartialObject
  *
- * Programmer:  matzke@viper
- *              Mon Nov  7 10:45:14 PST 1994
- *
- * Modifications:
- *    Robb Matzke, Mon Nov 21 21:37:54 EST 1994
- *    Added error mechanism.
+ * Purpose:     Read a ucd mesh, ucd variable, quad variable or material
+ *              for a subset of its zones (or nodes, for node centered
+ *              variables) without reading the whole object.
  *
- *    Eric Brugger, Tue Feb  7 08:09:26 PST 1995
- *    I replaced API_END with API_END_NOPOP.
+ *              MODE, NVALS, NDIMS and INDICES are as for DBReadVarVals.
+ *              Points are either linear indices (NDIMS 1) or logical
+ *              tuples of the object's rank. Hyperslabs are
+ *              <start,count,stride> per dimension.
  *
- *    Robb Matzke, 7 Mar 1997
- *    The freemem value passed to the driver is either FREE_MEM or zero
- *    so that drivers that overload this function with DBChangeObject
- *    are guaranteed to be able to tell the difference.
+ *              The object's header is read with the data read mask off.
+ *              Only the requested elements of its datasets are read,
+ *              using the driver's r_varvals callback. For a material,
+ *              only the mix entries of the selected zones are read, with
+ *              mix_next and mix_zone remapped to the subset. Variables
+ *              read their mixed values when OPTIONS gives the material
+ *              with DBOPT_MATNAME.
  *
- *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
- *    Made the error messages a little better.
+ * Return:      Success:        Pointer to the object, to be freed with
+ *                              the object's DBFree function.
  *
- *    Mark C. Miller, Wed Jul 23 00:15:15 PDT 2008
- *    Changed to API_BEGIN2 to help detect attempted ops on closed files.
+ *              Failure:        NULL
  *-------------------------------------------------------------------------*/
-PUBLIC int
-DBWriteObject(DBfile *dbfile, DBobject const *obj, int freemem)
+PUBLIC void *
+DBGetPartialObject(DBfile *dbfile, char const *name, int mode, int nvals,
+    int ndims, void const *indices, DBoptlist const *options)
 {
-    int retval;
+    void *retval = NULL;
 
-    API_BEGIN2("DBWriteObject", int, -1, api_dummy)
+    API_BEGIN2("DBGetPartialObject", void *, NULL, name)
     {
+        char cwg[1024], *absname;
+        unsigned long long oldmask;
+        DBObjectType otype;
+        int const *ind = (int const *) indices;
+
         if (!dbfile)
             API_ERROR(NULL, E_NOFILE);
         if (SILO_Globals.enableGrabDriver == TRUE)
-            API_ERROR("DBWriteObject", E_GRABBED) ; 
-        if (!obj)
-            API_ERROR("object pointer", E_BADARGS);
-        if (!DBGetAllowOverwritesFile(dbfile) && DBInqVarExists(dbfile, obj->name))
-            API_ERROR("overwrite not allowed", E_NOOVERWRITE);
-        if (!dbfile->pub.w_obj)
+            API_ERROR("DBGetPartialObject", E_GRABBED);
+        if (!name || !*name)
+            API_ERROR("object name", E_BADARGS);
+        if (mode != DB_PARTIO_POINTS && mode != DB_PARTIO_HSLABS)
+            API_ERROR("mode", E_BADARGS);
+        if (nvals <= 0)
+            API_ERROR("nvals", E_BADARGS);
+        if (ndims <= 0 || ndims > 3)
+            API_ERROR("ndims", E_BADARGS);
+        if (!indices)
+            API_ERROR("indices", E_BADARGS);
+        if (!dbfile->pub.r_varvals)
             API_ERROR(dbfile->pub.name, E_NOTIMP);
-
-        retval = (dbfile->pub.w_obj) (dbfile, obj, freemem?FREE_MEM:0);
+        otype = DBInqVarType(dbfile, name);
+        if (otype != DB_UCDMESH && otype != DB_UCDVAR &&
+            otype != DB_QUADVAR && otype != DB_MATERIAL)
+            API_ERROR(name, E_NOTIMP);
+        if (DBGetDir(dbfile, cwg) < 0)
+            API_ERROR(NULL, E_CALLFAIL);
+
+        absname = db_join_path(cwg, name);
+        oldmask = DBSetDataReadMask2File(dbfile, DBNone);
+        switch (otype)
+        {
+            case DB_UCDMESH:
+                retval = db_partial_ucdmesh(dbfile, absname, mode, nvals, ndims, ind);
+                break;
+            case DB_UCDVAR:
+                retval = db_partial_ucdvar(dbfile, absname, mode, nvals, ndims, ind, options);
+                break;
+            case DB_QUADVAR:
+                retval = db_partial_quadvar(dbfile, absname, mode, nvals, ndims, ind, options);
+                break;
+            default:
+                retval = db_partial_material(dbfile, absname, mode, nvals, ndims, ind, NULL);
+                break;
+        }
+        DBSetDataReadMask2File(dbfile, oldmask);
+        FREE(absname);
         API_RETURN(retval);
     }
     API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
-PUBLIC void *
-DBGetPartialObject(DBfile *dbfile, char const *name, int nvals, int ndims,
-    int index_mode, void const *indices, DBoptlist *options)
-{
-#warning FIX THIS METHOD
-
-
-
-    /* call directly down into driver */
-
-    /* get type */
-    DBObjectType otype = DBInqVarType(dbfile, name);
-
-    /* set mask and read object header */
-
-    /* get list of datasets */
-
-    /* If dense, do partial I/O on the datasets */
-    /* Else... do object specific partial I/O */
-    /* Handle mixed values on variables */
-}
-
+/*-------------------------------------------------------------------------
+ * Function:    DBGetPartialMaterial
+ *
+ * Purpose:     DBGetPartialObject for a material.
+ *
+ * Return:      Success:        Pointer to the material
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
 PUBLIC DBmaterial *
 DBGetPartialMaterial(DBfile *dbfile, char const *name, int mode, int nvals,
-    int ndims, void const *indices, DBoptlist *options)
+    int ndims, void const *indices, DBoptlist const *options)
 {
-    return (DBmaterial *) DBGetPartialObject(dbfile, name, mode, nvals, ndims, indices, options);
+    DBmaterial *retval = NULL;
+
+    API_BEGIN2("DBGetPartialMaterial", DBmaterial *, NULL, name)
+    {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!name || !*name)
+            API_ERROR("material name", E_BADARGS);
+        if (DBInqVarType(dbfile, name) != DB_MATERIAL)
+            API_ERROR(name, E_BADARGS);
+        retval = (DBmaterial *) DBGetPartialObject(dbfile, name, mode, nvals,
+                                     ndims, indices, options);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP; /*BEWARE: If API_RETURN above is removed use API_END */
 }
 
 /*-------------------------------------------------------------------------
@@ -9227,12 +11907,18 @@ DBPutMultimeshadj(DBfile *dbfile, char const *name, int nmesh,
  *    Mark C. Miller, Wed Jul 14 20:36:23 PDT 2010
  *    Added support for nameschemes on multi-block objects. This meant
  *    adjusting sanity checks for args as some can be null now.
+ *
+ *    Store a block index of the blocks' statistics, and their extents if
+ *    none are given, when DBSetBlockStats is on.
  *-------------------------------------------------------------------------*/
 PUBLIC int
 DBPutMultivar(DBfile *dbfile, const char *name, int nvar,
               char const * const *varnames, int const *vartypes, DBoptlist const *optlist)
 {
     int retval;
+    int extsize = 0;
+    double *index = 0, *extents = 0;
+    DBoptlist *idxopts = 0;
 
     API_BEGIN2("DBPutMultivar", int, -1, name) {
         if (!dbfile)
@@ -9265,8 +11951,21 @@ DBPutMultivar(DBfile *dbfile, const char *name, int nvar,
         if (!dbfile->pub.p_mv)
             API_ERROR(dbfile->pub.name, E_NOTIMP);
 
+        if (NULL != (index = db_MakeBlockIndex(dbfile, nvar, varnames)))
+        {
+            if (NULL != (idxopts = db_BlockIndexOptlist(optlist, index,
+                                                        &extents, &extsize)))
+                optlist = idxopts;
+        }
+
         retval = (dbfile->pub.p_mv) (dbfile, name, nvar, varnames,
                                      vartypes, optlist);
+        if (index && retval >= 0)
+            db_PutBlockIndex(dbfile, name, index);
+        FREE(index);
+        FREE(extents);
+        if (idxopts)
+            DBFreeOptlist(idxopts);
         db_FreeToc(dbfile);
         API_RETURN(retval);
     }
@@ -9725,6 +12424,8 @@ DBPutQuadmesh(DBfile *dbfile, const char *name, char const * const *coordnames,
  *
  *    Mark C. Miller, Thu Feb  4 11:29:35 PST 2010
  *    Removed upper bound restriction for nvars.
+ *
+ *    Store the variable's statistics when DBSetBlockStats is on.
  *-------------------------------------------------------------------------*/
 PUBLIC int
 DBPutQuadvar(DBfile *dbfile, const char *vname, const char *mname, int nvars,
@@ -9804,6 +12505,13 @@ DBPutQuadvar(DBfile *dbfile, const char *vname, const char *mname, int nvars,
                                      nvars, varnames, vars, dims, ndims,
                                      mixvars, mixlen, datatype, centering,
                                      optlist);
+        if (retval >= 0 && !is_empty)
+        {
+            long long nels = 1;
+            for (i = 0; i < ndims; i++)
+                nels *= dims[i];
+            db_PutBlockStats(dbfile, vname, nvars, vars, nels, datatype);
+        }
         db_FreeToc(dbfile);
         API_RETURN(retval);
     }
@@ -10058,6 +12766,8 @@ DBPutUcdsubmesh(DBfile *dbfile, const char *name, const char *parentmesh,
  *
  *    Mark C. Miller, Thu Feb  4 11:28:55 PST 2010
  *    Removed upper bound restriction on nvars.
+ *
+ *    Store the variable's statistics when DBSetBlockStats is on.
  *-------------------------------------------------------------------------*/
 PUBLIC int
 DBPutUcdvar(DBfile *dbfile, const char *vname, const char *mname, int nvars,
@@ -10123,6 +12833,8 @@ DBPutUcdvar(DBfile *dbfile, const char *vname, const char *mname, int nvars,
         retval = (dbfile->pub.p_uv) (dbfile, vname, mname,
                                      nvars, varnames, vars, nels, mixvars,
                                      mixlen, datatype, centering, optlist);
+        if (retval >= 0)
+            db_PutBlockStats(dbfile, vname, nvars, vars, nels, datatype);
         db_FreeToc(dbfile);
         API_RETURN(retval);
     }
@@ -10851,77 +13563,882 @@ _DBstrprint(FILE *fp, char *strs[], int nstrs, int order, int left_margin,
          *  Print by column
          *-----------------------------*/
 
-        for (i = 0; i < nrows; i++) {
-            index = i;
+        for (i = 0; i < nrows; i++) {
+            index = i;
+
+            fprintf(fp, "%*s", left_margin, " ");
+
+            for (j = 0; j < ncols; j++) {
+
+                fprintf(fp, "%-*s%*s", maxwidth, sorted_strs[index],
+                        col_margin, " ");
+
+                index += nrows;
+                if (index >= nstrs)
+                    break;
+            }
+            fprintf(fp, "\n");
+        }
+
+    }
+    else {
+        /*------------------------------
+         *  Print by row
+         *-----------------------------*/
+
+        for (i = 0; i < nrows; i++) {
+            index = i * ncols;
+
+            fprintf(fp, "%*s", left_margin, " ");
+
+            for (j = 0; j < ncols; j++) {
+
+                fprintf(fp, "%-*s%*s", maxwidth, sorted_strs[index],
+                        col_margin, " ");
+
+                index++;
+                if (index >= nstrs)
+                    break;
+            }
+            fprintf(fp, "\n");
+        }
+
+    }
+
+    FREE(sorted_strs);
+    return 0;
+}
+
+static int
+qsort_strcmp(const void *str1, const void *str2)
+{
+   return(strcmp(*((const char **)str1), *((const char **)str2)));
+}
+
+/*----------------------------------------------------------------------
+ *  Function                                                _DBsort_list
+ *
+ *  Purpose
+ *
+ *      Sort a list of character strings. Algorithm taken from
+ *      _SX_sort_lists() -- courtesy of Stewart Brown.
+ *
+ * Modified
+ *    Robb Matzke, Wed Jan 11 06:39:16 PST 1995
+ *    Changed name from sort_list because it conflicts with MeshTV.
+ *
+ *    Sean Ahern, Fri Mar  2 09:45:05 PST 2001
+ *    Changed this sort to a qsort, as suggested by Dan Schikore.
+ *---------------------------------------------------------------------*/
+INTERNAL void
+_DBsort_list(char **ss, int n)
+{
+    qsort(ss, n, sizeof(char *), qsort_strcmp);
+}
+
+/*---------------------------------------------------------------------------
+ * Extents kernels. Each finds the min and max of an array of one type in
+ * a single pass, keeping DB_MINMAX_LANES independent running values so
+ * that the compiler can hold them in vector registers. A NaN never
+ * replaces a running value, so it is only returned when it is the first
+ * value of the array.
+ *---------------------------------------------------------------------------*/
+#define DB_MINMAX_LANES 8
+
+/* Values per thread below which db_CalcExtentsN does not bother */
+#define DB_MINMAX_THREAD_MIN (1<<20)
+
+typedef void (*db_minmax_func_t)(void const *, size_t, void *, void *);
+
+#define DB_MINMAX_KERNEL(NAME, T)                                       \
+PRIVATE void                                                            \
+NAME(void const *varr, size_t n, void *vmin, void *vmax)                \
+{                                                                       \
+    T const *arr = (T const *) varr;                                    \
+    T mn[DB_MINMAX_LANES], mx[DB_MINMAX_LANES];                         \
+    size_t i;                                                           \
+    int k;                                                              \
+                                                                        \
+    for (k = 0; k < DB_MINMAX_LANES; k++)                               \
+        mn[k] = mx[k] = arr[0];                                         \
+    for (i = 0; i + DB_MINMAX_LANES <= n; i += DB_MINMAX_LANES)         \
+    {                                                                   \
+        for (k = 0; k < DB_MINMAX_LANES; k++)                           \
+        {                                                               \
+            T v = arr[i+k];                                             \
+            mn[k] = v < mn[k] ? v : mn[k];                              \
+            mx[k] = v > mx[k] ? v : mx[k];                              \
+        }                                                               \
+    }                                                                   \
+    for (; i < n; i++)                                                  \
+    {                                                                   \
+        mn[0] = arr[i] < mn[0] ? arr[i] : mn[0];                        \
+        mx[0] = arr[i] > mx[0] ? arr[i] : mx[0];                        \
+    }                                                                   \
+    for (k = 1; k < DB_MINMAX_LANES; k++)                               \
+    {                                                                   \
+        mn[0] = mn[k] < mn[0] ? mn[k] : mn[0];                          \
+        mx[0] = mx[k] > mx[0] ? mx[k] : mx[0];                          \
+    }                                                                   \
+    *((T *) vmin) = mn[0];                                              \
+    *((T *) vmax) = mx[0];                                              \
+}
+
+DB_MINMAX_KERNEL(db_minmax_char, char)
+DB_MINMAX_KERNEL(db_minmax_short, short)
+DB_MINMAX_KERNEL(db_minmax_int, int)
+DB_MINMAX_KERNEL(db_minmax_long, long)
+DB_MINMAX_KERNEL(db_minmax_longlong, long long)
+DB_MINMAX_KERNEL(db_minmax_float, float)
+DB_MINMAX_KERNEL(db_minmax_double, double)
+
+PRIVATE db_minmax_func_t
+db_minmax_func(int datatype)
+{
+    switch (datatype)
+    {
+        case DB_CHAR:      return db_minmax_char;
+        case DB_SHORT:     return db_minmax_short;
+        case DB_INT:       return db_minmax_int;
+        case DB_LONG:      return db_minmax_long;
+        case DB_LONG_LONG: return db_minmax_longlong;
+        case DB_FLOAT:     return db_minmax_float;
+        case DB_DOUBLE:    return db_minmax_double;
+        default:           return 0;
+    }
+}
+
+typedef union db_minmax_val_t {
+    long long      ll;
+    double         d;
+} db_minmax_val_t;
+
+typedef struct db_minmax_job_t {
+    db_minmax_func_t func;
+    void const    *arr;
+    size_t         n;
+    db_minmax_val_t mn, mx;
+} db_minmax_job_t;
+
+SILO_CALLBACK void
+db_minmax_job(void *arg)
+{
+    db_minmax_job_t *job = (db_minmax_job_t *) arg;
+    if (job->n > 0)
+        job->func(job->arr, job->n, &job->mn, &job->mx);
+}
+
+/*---------------------------------------------------------------------------
+ * db_CalcExtentsN - Find the min and max of each of NARRS arrays of N
+ * values of DATATYPE, storing them as DATATYPE in MINS[i] and MAXS[i].
+ * Very large arrays are split among up to DB_THREADS threads.
+ *---------------------------------------------------------------------------*/
+INTERNAL int
+db_CalcExtentsN(void const * const *arrs, int narrs, int datatype, size_t n,
+    void *mins, void *maxs)
+{
+    db_minmax_func_t func = db_minmax_func(datatype);
+    size_t         size;
+    size_t         nchunks = 1, chunk;
+    int            a;
+    db_minmax_job_t *jobs;
+    db_minmax_val_t tmin;
+    char          *tmp;
+    char          *me = "db_CalcExtentsN";
+
+    if (!func)
+        return db_perror("datatype", E_BADARGS, me);
+    if (n == 0 || narrs <= 0)
+        return 0;
+    size = (size_t) db_GetMachDataSize(datatype);
+
+    if (DB_THREADS > 1 && n >= 2 * DB_MINMAX_THREAD_MIN)
+    {
+        nchunks = (DB_THREADS + narrs - 1) / narrs;
+        nchunks = MIN(nchunks, n / DB_MINMAX_THREAD_MIN);
+    }
+
+    if (nchunks <= 1)
+    {
+        for (a = 0; a < narrs; a++)
+            func(arrs[a], n, (char *) mins + a * size, (char *) maxs + a * size);
+        return 0;
+    }
+
+    /*
+     * Split each array into nchunks jobs, run all but the first on
+     * their own threads and combine the results.
+     */
+    chunk = (n / nchunks + DB_MINMAX_LANES - 1) / DB_MINMAX_LANES * DB_MINMAX_LANES;
+    jobs = ALLOC_N(db_minmax_job_t, narrs * nchunks);
+    tmp = ALLOC_N(char, 2 * nchunks * size);
+    if (!jobs || !tmp)
+    {
+        FREE(jobs);
+        FREE(tmp);
+        return db_perror(NULL, E_NOMEM, me);
+    }
+    for (a = 0; a < narrs; a++)
+    {
+        size_t c;
+        for (c = 0; c < nchunks; c++)
+        {
+            db_minmax_job_t *job = &jobs[a * nchunks + c];
+            size_t first = MIN(c * chunk, n);
+            job->func = func;
+            job->arr = (char const *) arrs[a] + first * size;
+            job->n = c == nchunks - 1 ? n - first : MIN(chunk, n - first);
+        }
+    }
+    db_RunJobs(db_minmax_job, jobs, sizeof(*jobs), (int) (narrs * nchunks));
+    for (a = 0; a < narrs; a++)
+    {
+        size_t c, m = 0;
+        for (c = 0; c < nchunks; c++)
+        {
+            db_minmax_job_t *job = &jobs[a * nchunks + c];
+            if (job->n == 0) continue;
+            memcpy(tmp + m * size, &job->mn, size);
+            memcpy(tmp + (nchunks + m) * size, &job->mx, size);
+            m++;
+        }
+        func(tmp, m, (char *) mins + a * size, &tmin);
+        func(tmp + nchunks * size, m, &tmin, (char *) maxs + a * size);
+    }
+    FREE(jobs);
+    FREE(tmp);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------
+ * db_SubsetMinMax - Find the min and max of the [ixmin,ixmax] x
+ * [iymin,iymax] x [izmin,izmax] subset of an nx by ny by nz array. The
+ * kernel is run over each contiguous run of the subset, so rows and
+ * planes which span the whole array are done in one go. Pass ny of zero
+ * when the array is 2d.
+ *---------------------------------------------------------------------------*/
+PRIVATE int
+db_SubsetMinMax(void const *arr, int datatype, void *amin, void *amax,
+    int nx, int ny, int ixmin, int ixmax, int iymin, int iymax, int izmin,
+    int izmax)
+{
+    db_minmax_func_t func = db_minmax_func(datatype);
+    size_t         size, nxy = (size_t) nx * ny;
+    size_t         run = (size_t) (ixmax - ixmin + 1);
+    int            j, k, jmax = iymax, kmax = izmax;
+    db_minmax_val_t pair[2], rmn, rmx, tmp;
+    char const    *carr = (char const *) arr;
+
+    if (!func)
+        return 0;
+    size = (size_t) db_GetMachDataSize(datatype);
+
+    func(carr + (izmin * nxy + (size_t) iymin * nx + ixmin) * size, 1,
+         amin, amax);
+    if (ixmax < ixmin || iymax < iymin || izmax < izmin)
+        return 0;
+
+    /* Coalesce whole rows, then whole planes, into single runs */
+    if (ixmin == 0 && ixmax == nx - 1)
+    {
+        run *= (size_t) (iymax - iymin + 1);
+        jmax = iymin;
+        if (iymin == 0 && iymax == ny - 1)
+        {
+            run = nxy * (size_t) (izmax - izmin + 1);
+            kmax = izmin;
+        }
+    }
+
+    for (k = izmin; k <= kmax; k++)
+    {
+        for (j = iymin; j <= jmax; j++)
+        {
+            char const *p = carr + (k * nxy + (size_t) j * nx + ixmin) * size;
+            func(p, run, &rmn, &rmx);
+            memcpy(pair, amin, size);
+            memcpy((char *) pair + size, &rmn, size);
+            func(pair, 2, amin, &tmp);
+            memcpy(pair, amax, size);
+            memcpy((char *) pair + size, &rmx, size);
+            func(pair, 2, &tmp, amax);
+        }
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------
+ * DBCalcExtents - Return in MIN_VAL and MAX_VAL, which point to values of
+ * DATATYPE, the min and max of the NVALS values of DATATYPE in ARR.
+ *---------------------------------------------------------------------------*/
+PUBLIC int
+DBCalcExtents(void const *arr, int datatype, long long nvals, void *min_val,
+    void *max_val)
+{
+    char          *me = "DBCalcExtents";
+
+    if (!arr)
+        return db_perror("arr pointer", E_BADARGS, me);
+    if (nvals <= 0)
+        return db_perror("nvals", E_BADARGS, me);
+    if (!min_val || !max_val)
+        return db_perror("min/max pointer", E_BADARGS, me);
+    return db_CalcExtentsN(&arr, 1, datatype, (size_t) nvals, min_val, max_val);
+}
+
+/*---------------------------------------------------------------------------
+ * Block statistics. With DBSetBlockStats(1), DBPutQuadvar and DBPutUcdvar
+ * store a summary of each component of a variable as a double array named
+ * _blockstats_<name> beside it, and DBPutMultivar gathers the summaries
+ * of its blocks into a block index named _blockindex_<name> beside the
+ * multivar. DBQueryBlocks reads only the index to find the blocks a
+ * value query may match.
+ *
+ * A summary is DB_BLOCKSTATS_RECLEN doubles: the number of non-NaN
+ * values, their min, max and mean, and a histogram of them in
+ * DB_BLOCKSTATS_NBINS equal bins over [min,max]. An index has a
+ * DB_BLOCKINDEX_HDR header of the number of bins, components and blocks
+ * followed by the summary of every component of every block. A block
+ * whose summary could not be read has a count of -1.
+ *---------------------------------------------------------------------------*/
+#define DB_BLOCKSTATS_RECLEN (4 + DB_BLOCKSTATS_NBINS)
+#define DB_BLOCKSTATS_HIST   4
+#define DB_BLOCKINDEX_HDR    3
+
+/* Histogram bins per unit value over [MN,MX], or 0 when the range is
+   empty or too narrow or wide to bin, in which case every value is in
+   the first bin */
+PRIVATE double
+db_blockstats_scale(double mn, double mx)
+{
+    double scale;
+
+    if (!(mx > mn))
+        return 0;
+    scale = DB_BLOCKSTATS_NBINS / (mx - mn);
+    return scale > 0 && scale < DBL_MAX ? scale : 0;
+}
+
+/* The min and max come from the extents kernels, after any leading NaNs,
+   and then a second pass bins, counts and sums the values */
+#define DB_BLOCKSTATS_KERNEL(NAME, T, MINMAX)                           \
+PRIVATE void                                                            \
+NAME(void const *varr, size_t n, double *rec)                           \
+{                                                                       \
+    T const *arr = (T const *) varr;                                    \
+    T tmn, tmx;                                                         \
+    double *hist = rec + DB_BLOCKSTATS_HIST;                            \
+    double mn, mx, scale, t, v, sum = 0;                                \
+    size_t i, first = 0, count = 0;                                     \
+                                                                        \
+    for (; first < n; first++)                                          \
+        if ((v = (double) arr[first]) == v)                             \
+            break;                                                      \
+    if (first == n)                                                     \
+        return;                                                         \
+    MINMAX(arr + first, n - first, &tmn, &tmx);                         \
+    mn = (double) tmn;                                                  \
+    mx = (double) tmx;                                                  \
+    scale = db_blockstats_scale(mn, mx);                                \
+    for (i = first; i < n; i++)                                         \
+    {                                                                   \
+        v = (double) arr[i];                                            \
+        if (v != v)                                                     \
+            continue;                                                   \
+        t = (v - mn) * scale;                                           \
+        hist[t < DB_BLOCKSTATS_NBINS ? (int) t : DB_BLOCKSTATS_NBINS-1] += 1; \
+        sum += v;                                                       \
+        count++;                                                        \
+    }                                                                   \
+    rec[0] = (double) count;                                            \
+    rec[1] = mn;                                                        \
+    rec[2] = mx;                                                        \
+    rec[3] = sum / count;                                               \
+}
+
+DB_BLOCKSTATS_KERNEL(db_blockstats_char, char, db_minmax_char)
+DB_BLOCKSTATS_KERNEL(db_blockstats_short, short, db_minmax_short)
+DB_BLOCKSTATS_KERNEL(db_blockstats_int, int, db_minmax_int)
+DB_BLOCKSTATS_KERNEL(db_blockstats_long, long, db_minmax_long)
+DB_BLOCKSTATS_KERNEL(db_blockstats_longlong, long long, db_minmax_longlong)
+DB_BLOCKSTATS_KERNEL(db_blockstats_float, float, db_minmax_float)
+DB_BLOCKSTATS_KERNEL(db_blockstats_double, double, db_minmax_double)
+
+/* Put the summary of the N values of DATATYPE in ARR in REC, which must
+   be zeroed. Returns -1 if DATATYPE cannot be summarized. */
+PRIVATE int
+db_CalcBlockStats(void const *arr, int datatype, size_t n, double *rec)
+{
+    switch (datatype)
+    {
+        case DB_CHAR:      db_blockstats_char(arr, n, rec);     return 0;
+        case DB_SHORT:     db_blockstats_short(arr, n, rec);    return 0;
+        case DB_INT:       db_blockstats_int(arr, n, rec);      return 0;
+        case DB_LONG:      db_blockstats_long(arr, n, rec);     return 0;
+        case DB_LONG_LONG: db_blockstats_longlong(arr, n, rec); return 0;
+        case DB_FLOAT:     db_blockstats_float(arr, n, rec);    return 0;
+        case DB_DOUBLE:    db_blockstats_double(arr, n, rec);   return 0;
+        default:           return -1;
+    }
+}
+
+/* NAME, which may have a directory part, with PREFIX put before its last
+   component */
+PRIVATE char *
+db_BlockStatsName(char const *name, char const *prefix)
+{
+    char const    *base = strrchr(name, '/');
+    size_t         dirlen = base ? (size_t) (base - name + 1) : 0;
+    char          *result = ALLOC_N(char, strlen(name) + strlen(prefix) + 1);
+
+    if (!result)
+        return 0;
+    memcpy(result, name, dirlen);
+    strcpy(result + dirlen, prefix);
+    strcat(result, name + dirlen);
+    return result;
+}
+
+/*---------------------------------------------------------------------------
+ * db_PutBlockStats - Store the summary of each of the NVARS components of
+ * NELS values of variable VNAME, when DBSetBlockStats is on. The variable
+ * has been written already, so a failure here is not reported.
+ *---------------------------------------------------------------------------*/
+INTERNAL void
+db_PutBlockStats(DBfile *dbfile, char const *vname, int nvars, DBVCP2_t vars,
+    long long nels, int datatype)
+{
+    void const * const *comps = (void const * const *) vars;
+    char          *statsname;
+    double        *recs;
+    int            i, len = nvars * DB_BLOCKSTATS_RECLEN;
+
+    if (!SILO_Globals.blockStats || nvars <= 0 || nels <= 0 || !vars)
+        return;
+    if (NULL == (recs = ALLOC_N(double, len)))
+        return;
+    for (i = 0; i < nvars; i++)
+    {
+        if (db_CalcBlockStats(comps[i], datatype, (size_t) nels,
+                              recs + i * DB_BLOCKSTATS_RECLEN) < 0)
+        {
+            free(recs);
+            return;
+        }
+    }
+    if (NULL != (statsname = db_BlockStatsName(vname, "_blockstats_")))
+    {
+        DBShowErrors(DB_SUSPEND, 0);
+        DBWrite(dbfile, statsname, recs, &len, 1, DB_DOUBLE);
+        DBShowErrors(DB_RESUME, 0);
+        free(statsname);
+    }
+    free(recs);
+}
+
+/* Read the double array NAME, returning its length in *LEN, or NULL */
+PRIVATE double *
+db_ReadDoubles(DBfile *dbfile, char const *name, int *len)
+{
+    double        *vals;
+
+    if (DBInqVarExists(dbfile, name) == 0 ||
+        DBGetVarType(dbfile, name) != DB_DOUBLE ||
+        (*len = DBGetVarLength(dbfile, name)) <= 0)
+        return 0;
+    if (NULL == (vals = ALLOC_N(double, *len)))
+        return 0;
+    if (DBReadVar(dbfile, name, vals) < 0)
+    {
+        free(vals);
+        return 0;
+    }
+    return vals;
+}
+
+/* The file other than the multivar's which holds the last block read */
+typedef struct db_blockfile_t {
+    char          *name;
+    DBfile        *file;
+} db_blockfile_t;
+
+/*---------------------------------------------------------------------------
+ * db_ReadBlockStats - Read the summaries of block NAME, a "[file:]path"
+ * block name of a multivar being written to DBFILE. A file is taken
+ * relative to the directory of DBFILE's file. Returns the summaries and
+ * their number of components in *NCOMPS, or NULL.
+ *---------------------------------------------------------------------------*/
+PRIVATE double *
+db_ReadBlockStats(DBfile *dbfile, char const *name, db_blockfile_t *other,
+    int *ncomps)
+{
+    char const    *colon = strchr(name, ':');
+    char const    *slash;
+    char          *fname = 0, *statsname;
+    DBfile        *file = dbfile;
+    double        *recs = 0;
+    int            len = 0;
+
+    if (colon)
+    {
+        slash = strrchr(dbfile->pub.name, '/');
+        if (name[0] == '/' || !slash)
+            fname = db_strndup(name, (int) (colon - name));
+        else
+        {
+            size_t dirlen = (size_t) (slash - dbfile->pub.name + 1);
+            fname = ALLOC_N(char, dirlen + (colon - name) + 1);
+            if (fname)
+            {
+                memcpy(fname, dbfile->pub.name, dirlen);
+                memcpy(fname + dirlen, name, colon - name);
+            }
+        }
+        if (!fname)
+            return 0;
+        if (strcmp(fname, dbfile->pub.name) != 0)
+        {
+            if (!other->name || strcmp(other->name, fname) != 0)
+            {
+                if (other->file)
+                    DBClose(other->file);
+                FREE(other->name);
+                other->file = DBOpen(fname, DB_UNKNOWN, DB_READ);
+                other->name = fname;
+                fname = 0;
+            }
+            file = other->file;
+        }
+        FREE(fname);
+        name = colon + 1;
+    }
+    if (!file || !strcmp(name, "EMPTY"))
+        return 0;
+
+    if (NULL != (statsname = db_BlockStatsName(name, "_blockstats_")))
+    {
+        recs = db_ReadDoubles(file, statsname, &len);
+        free(statsname);
+    }
+    if (recs && len % DB_BLOCKSTATS_RECLEN != 0)
+        FREE(recs);
+    *ncomps = len / DB_BLOCKSTATS_RECLEN;
+    return recs;
+}
+
+/*---------------------------------------------------------------------------
+ * db_MakeBlockIndex - Gather the summaries of the NBLOCKS blocks of a
+ * multivar being written to DBFILE into a block index. Returns NULL if
+ * no block has a summary.
+ *---------------------------------------------------------------------------*/
+INTERNAL double *
+db_MakeBlockIndex(DBfile *dbfile, int nblocks, char const * const *varnames)
+{
+    db_blockfile_t other;
+    double       **recs;
+    double        *index = 0;
+    int           *ncomps;
+    int            i, c, maxcomps = 0;
+
+    if (!SILO_Globals.blockStats || nblocks <= 0 || !varnames)
+        return 0;
+    recs = ALLOC_N(double *, nblocks);
+    ncomps = ALLOC_N(int, nblocks);
+    if (!recs || !ncomps)
+    {
+        FREE(recs);
+        FREE(ncomps);
+        return 0;
+    }
+
+    memset(&other, 0, sizeof(other));
+    DBShowErrors(DB_SUSPEND, 0);
+    for (i = 0; i < nblocks; i++)
+    {
+        if (varnames[i])
+            recs[i] = db_ReadBlockStats(dbfile, varnames[i], &other, &ncomps[i]);
+        if (recs[i])
+            maxcomps = MAX(maxcomps, ncomps[i]);
+    }
+    if (other.file)
+        DBClose(other.file);
+    DBShowErrors(DB_RESUME, 0);
+    FREE(other.name);
+
+    if (maxcomps > 0 &&
+        NULL != (index = ALLOC_N(double, DB_BLOCKINDEX_HDR +
+                     (size_t) nblocks * maxcomps * DB_BLOCKSTATS_RECLEN)))
+    {
+        index[0] = DB_BLOCKSTATS_NBINS;
+        index[1] = maxcomps;
+        index[2] = nblocks;
+        for (i = 0; i < nblocks; i++)
+        {
+            for (c = 0; c < maxcomps; c++)
+            {
+                double *rec = index + DB_BLOCKINDEX_HDR +
+                              ((size_t) i * maxcomps + c) * DB_BLOCKSTATS_RECLEN;
+                if (recs[i] && c < ncomps[i])
+                    memcpy(rec, recs[i] + c * DB_BLOCKSTATS_RECLEN,
+                           DB_BLOCKSTATS_RECLEN * sizeof(double));
+                else
+                    rec[0] = -1;
+            }
+        }
+    }
+    for (i = 0; i < nblocks; i++)
+        FREE(recs[i]);
+    free(recs);
+    free(ncomps);
+    return index;
+}
+
+/*---------------------------------------------------------------------------
+ * db_BlockIndexOptlist - When every block in INDEX has a summary and
+ * OPTLIST has no extents, return a copy of OPTLIST with the extents of
+ * the blocks added, their values in *EXTENTS. Otherwise return NULL.
+ *---------------------------------------------------------------------------*/
+INTERNAL DBoptlist *
+db_BlockIndexOptlist(DBoptlist const *optlist, double const *index,
+    double **extents, int *extsize)
+{
+    int            ncomps = (int) index[1], nblocks = (int) index[2];
+    int            i, c;
+    DBoptlist     *copy;
+
+    *extents = 0;
+    if (optlist && (DBGetOption(optlist, DBOPT_EXTENTS) ||
+                    DBGetOption(optlist, DBOPT_EXTENTS_SIZE)))
+        return 0;
+    for (i = 0; i < nblocks * ncomps; i++)
+        if (index[DB_BLOCKINDEX_HDR + i * DB_BLOCKSTATS_RECLEN] < 0)
+            return 0;
+    if (NULL == (*extents = ALLOC_N(double, 2 * nblocks * ncomps)))
+        return 0;
+    if (NULL == (copy = DBMakeOptlist((optlist ? optlist->numopts : 0) + 2)))
+    {
+        FREE(*extents);
+        return 0;
+    }
+    for (i = 0; optlist && i < optlist->numopts; i++)
+        DBAddOption(copy, optlist->options[i], optlist->values[i]);
+
+    /* Each block's extents are the mins of its components, then the maxs */
+    for (i = 0; i < nblocks; i++)
+    {
+        for (c = 0; c < ncomps; c++)
+        {
+            double const *rec = index + DB_BLOCKINDEX_HDR +
+                                (i * ncomps + c) * DB_BLOCKSTATS_RECLEN;
+            (*extents)[2 * i * ncomps + c] = rec[1];
+            (*extents)[(2 * i + 1) * ncomps + c] = rec[2];
+        }
+    }
+    *extsize = 2 * ncomps;
+    DBAddOption(copy, DBOPT_EXTENTS_SIZE, extsize);
+    DBAddOption(copy, DBOPT_EXTENTS, *extents);
+    return copy;
+}
+
+/* Store block INDEX of multivar NAME. Failures are not reported. */
+INTERNAL void
+db_PutBlockIndex(DBfile *dbfile, char const *name, double const *index)
+{
+    char          *idxname = db_BlockStatsName(name, "_blockindex_");
+    int            len = DB_BLOCKINDEX_HDR +
+                         (int) index[1] * (int) index[2] * DB_BLOCKSTATS_RECLEN;
+
+    if (!idxname)
+        return;
+    DBShowErrors(DB_SUSPEND, 0);
+    DBWrite(dbfile, idxname, index, &len, 1, DB_DOUBLE);
+    DBShowErrors(DB_RESUME, 0);
+    free(idxname);
+}
+
+/*---------------------------------------------------------------------------
+ * DBSetBlockStats - Turn on or off storing block statistics with quad and
+ * ucd variables and a block index with multivars. Returns the old
+ * setting.
+ *---------------------------------------------------------------------------*/
+PUBLIC int
+DBSetBlockStats(int enable)
+{
+    int old = SILO_Globals.blockStats;
+    SILO_Globals.blockStats = enable ? 1 : 0;
+    return old;
+}
+
+PUBLIC int
+DBGetBlockStats(void)
+{
+    return SILO_Globals.blockStats;
+}
 
-            fprintf(fp, "%*s", left_margin, " ");
+/* Read and check the block index of multivar NAME, or return NULL */
+PRIVATE double *
+db_ReadBlockIndex(DBfile *dbfile, char const *name)
+{
+    char          *idxname = db_BlockStatsName(name, "_blockindex_");
+    double        *index = 0;
+    int            len = 0;
 
-            for (j = 0; j < ncols; j++) {
+    if (!idxname)
+        return 0;
+    DBShowErrors(DB_SUSPEND, 0);
+    index = db_ReadDoubles(dbfile, idxname, &len);
+    DBShowErrors(DB_RESUME, 0);
+    free(idxname);
+    if (index && (len < DB_BLOCKINDEX_HDR ||
+                  index[0] != DB_BLOCKSTATS_NBINS || index[1] < 1 || index[2] < 1 ||
+                  len != DB_BLOCKINDEX_HDR + index[1] * index[2] * DB_BLOCKSTATS_RECLEN))
+        FREE(index);
+    return index;
+}
 
-                fprintf(fp, "%-*s%*s", maxwidth, sorted_strs[index],
-                        col_margin, " ");
+/*---------------------------------------------------------------------------
+ * DBGetBlockIndex - Return the block statistics stored for multivar
+ * NAME, NBLOCKS times NCOMPS of them ordered by block, then component.
+ * A block with unknown statistics has a count of -1. The caller frees
+ * the result with free().
+ *---------------------------------------------------------------------------*/
+PUBLIC DBblockstats *
+DBGetBlockIndex(DBfile *dbfile, char const *name, int *nblocks, int *ncomps)
+{
+    DBblockstats  *retval = 0;
+    double        *index = 0;
+    int            i, b, n;
 
-                index += nrows;
-                if (index >= nstrs)
-                    break;
-            }
-            fprintf(fp, "\n");
+    API_BEGIN2("DBGetBlockIndex", DBblockstats *, NULL, name) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!name || !*name)
+            API_ERROR("multivar name", E_BADARGS);
+        if (!nblocks || !ncomps)
+            API_ERROR("nblocks or ncomps pointer", E_BADARGS);
+        if (NULL == (index = db_ReadBlockIndex(dbfile, name)))
+            API_ERROR(name, E_NOTFOUND);
+        n = (int) index[1] * (int) index[2];
+        if (NULL == (retval = ALLOC_N(DBblockstats, n)))
+        {
+            free(index);
+            API_ERROR(NULL, E_NOMEM);
         }
-
+        for (i = 0; i < n; i++)
+        {
+            double const *rec = index + DB_BLOCKINDEX_HDR + i * DB_BLOCKSTATS_RECLEN;
+            retval[i].count = (long long) rec[0];
+            retval[i].min = rec[1];
+            retval[i].max = rec[2];
+            retval[i].mean = rec[3];
+            for (b = 0; b < DB_BLOCKSTATS_NBINS; b++)
+                retval[i].hist[b] = (long long) rec[DB_BLOCKSTATS_HIST + b];
+        }
+        *ncomps = (int) index[1];
+        *nblocks = (int) index[2];
+        free(index);
+        API_RETURN(retval);
     }
-    else {
-        /*------------------------------
-         *  Print by row
-         *-----------------------------*/
-
-        for (i = 0; i < nrows; i++) {
-            index = i * ncols;
-
-            fprintf(fp, "%*s", left_margin, " ");
-
-            for (j = 0; j < ncols; j++) {
+    API_END_NOPOP;
+}
 
-                fprintf(fp, "%-*s%*s", maxwidth, sorted_strs[index],
-                        col_margin, " ");
+/* Whether a block with summary REC may hold values which satisfy PRED */
+PRIVATE int
+db_BlockMayMatch(double const *rec, DBblockpredicate const *pred)
+{
+    double         mn = rec[1], mx = rec[2], scale, slack;
+    int            b;
 
-                index++;
-                if (index >= nstrs)
-                    break;
-            }
-            fprintf(fp, "\n");
-        }
+    if (rec[0] < 0)
+        return 1;
+    if (rec[0] == 0)
+        return 0;
+    if (pred->op == DB_BLOCKQUERY_ISO)
+        return mn <= pred->lo && pred->lo <= mx;
+    if (mx < pred->lo || mn > pred->hi)
+        return 0;
+    if ((scale = db_blockstats_scale(mn, mx)) == 0)
+        return 1;
 
+    /* Some non-empty bin must overlap [lo,hi]. Bins are widened a little
+       for the rounding in placing values in them. */
+    slack = 1e-6 / scale;
+    for (b = 0; b < DB_BLOCKSTATS_NBINS; b++)
+    {
+        if (rec[DB_BLOCKSTATS_HIST + b] > 0 &&
+            mn + b / scale - slack <= pred->hi &&
+            (b == DB_BLOCKSTATS_NBINS - 1 ? mx : mn + (b + 1) / scale + slack) >= pred->lo)
+            return 1;
     }
-
-    FREE(sorted_strs);
     return 0;
 }
 
-static int
-qsort_strcmp(const void *str1, const void *str2)
+/*---------------------------------------------------------------------------
+ * DBQueryBlocks - Find the blocks of multivar NAME which may hold values
+ * satisfying PRED, using only its block index. Returns their number and
+ * their 0-origin indices in *BLOCKS, which the caller frees with free().
+ * A block never matches wrongly, but may match without holding such
+ * values. Without an index, every block matches.
+ *---------------------------------------------------------------------------*/
+PUBLIC int
+DBQueryBlocks(DBfile *dbfile, char const *name, DBblockpredicate const *pred,
+    int **blocks)
 {
-   return(strcmp(*((const char **)str1), *((const char **)str2)));
-}
+    int            retval = 0;
+    int            i, nblocks, ncomps;
+    double        *index = 0;
+    DBmultivar    *mv;
 
-/*----------------------------------------------------------------------
- *  Function                                                _DBsort_list
- *
- *  Purpose
- *
- *      Sort a list of character strings. Algorithm taken from
- *      _SX_sort_lists() -- courtesy of Stewart Brown.
- *
- * Modified
- *    Robb Matzke, Wed Jan 11 06:39:16 PST 1995
- *    Changed name from sort_list because it conflicts with MeshTV.
- *
- *    Sean Ahern, Fri Mar  2 09:45:05 PST 2001
- *    Changed this sort to a qsort, as suggested by Dan Schikore.
- *---------------------------------------------------------------------*/
-INTERNAL void
-_DBsort_list(char **ss, int n)
-{
-    qsort(ss, n, sizeof(char *), qsort_strcmp);
+    API_BEGIN2("DBQueryBlocks", int, -1, name) {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (!name || !*name)
+            API_ERROR("multivar name", E_BADARGS);
+        if (!pred || !blocks)
+            API_ERROR("pred or blocks pointer", E_BADARGS);
+        if (pred->op != DB_BLOCKQUERY_RANGE && pred->op != DB_BLOCKQUERY_ISO)
+            API_ERROR("pred->op", E_BADARGS);
+        if (pred->op == DB_BLOCKQUERY_RANGE && !(pred->lo <= pred->hi))
+            API_ERROR("pred->lo > pred->hi", E_BADARGS);
+        if (pred->comp < 0)
+            API_ERROR("pred->comp", E_BADARGS);
+
+        *blocks = 0;
+        if (NULL == (index = db_ReadBlockIndex(dbfile, name)))
+        {
+            if (NULL == (mv = DBGetMultivar(dbfile, name)))
+                API_ERROR(name, E_NOTFOUND);
+            nblocks = mv->nvars;
+            DBFreeMultivar(mv);
+            if (nblocks > 0 && NULL == (*blocks = ALLOC_N(int, nblocks)))
+                API_ERROR(NULL, E_NOMEM);
+            for (i = 0; i < nblocks; i++)
+                (*blocks)[i] = i;
+            API_RETURN(nblocks);
+        }
+
+        ncomps = (int) index[1];
+        nblocks = (int) index[2];
+        if (pred->comp >= ncomps)
+        {
+            free(index);
+            API_ERROR("pred->comp", E_BADARGS);
+        }
+        if (NULL == (*blocks = ALLOC_N(int, nblocks)))
+        {
+            free(index);
+            API_ERROR(NULL, E_NOMEM);
+        }
+        for (i = 0; i < nblocks; i++)
+            if (db_BlockMayMatch(index + DB_BLOCKINDEX_HDR +
+                    (i * ncomps + pred->comp) * DB_BLOCKSTATS_RECLEN, pred))
+                (*blocks)[retval++] = i;
+        free(index);
+        if (retval == 0)
+            FREE(*blocks);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
 }
 
 /*---------------------------------------------------------------------------
@@ -10933,11 +14450,12 @@ _DBsort_list(char **ss, int n)
  *
  *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
  *    Made the error messages a little better.
+ *
+ *    Use the single pass extents kernel.
  *---------------------------------------------------------------------------*/
 INTERNAL int
 _DBarrminmax(float arr[], int len, float *arr_min, float *arr_max)
 {
-    int             i;
     char           *me = "_DBarrminmax";
 
     if (!arr)
@@ -10945,16 +14463,7 @@ _DBarrminmax(float arr[], int len, float *arr_min, float *arr_max)
     if (len <= 0)
         return db_perror("len", E_BADARGS, me);
 
-    *arr_min = arr[0];
-    *arr_max = arr[0];
-
-    for (i = 1; i < len; i++)
-    {
-        *arr_min = MIN(*arr_min, arr[i]);
-        *arr_max = MAX(*arr_max, arr[i]);
-    }
-
-    return 0;
+    return DBCalcExtents(arr, DB_FLOAT, len, arr_min, arr_max);
 }
 
 /*---------------------------------------------------------------------------
@@ -10966,11 +14475,12 @@ _DBarrminmax(float arr[], int len, float *arr_min, float *arr_max)
  *
  *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
  *    Made the error messages a little better.
+ *
+ *    Use the single pass extents kernel.
  *---------------------------------------------------------------------------*/
 INTERNAL int
 _DBiarrminmax(int arr[], int len, int *arr_min, int *arr_max)
 {
-    int             i;
     char           *me = "_DBiarrminmax";
 
     if (!arr)
@@ -10978,16 +14488,7 @@ _DBiarrminmax(int arr[], int len, int *arr_min, int *arr_max)
     if (len <= 0)
         return db_perror("len", E_BADARGS, me);
 
-    *arr_min = arr[0];
-    *arr_max = arr[0];
-
-    for (i = 1; i < len; i++)
-    {
-        *arr_min = MIN(*arr_min, arr[i]);
-        *arr_max = MAX(*arr_max, arr[i]);
-    }
-
-    return 0;
+    return DBCalcExtents(arr, DB_INT, len, arr_min, arr_max);
 }
 
 /*---------------------------------------------------------------------------
@@ -10999,11 +14500,12 @@ _DBiarrminmax(int arr[], int len, int *arr_min, int *arr_max)
  *
  *    Sean Ahern, Tue Sep 28 11:00:13 PDT 1999
  *    Made the error messages a little better.
+ *
+ *    Use the single pass extents kernel.
  *---------------------------------------------------------------------------*/
 INTERNAL int
 _DBdarrminmax(double arr[], int len, double *arr_min, double *arr_max)
 {
-    int             i;
     char           *me = "_DBdarrminmax";
 
     if (!arr)
@@ -11011,16 +14513,7 @@ _DBdarrminmax(double arr[], int len, double *arr_min, double *arr_max)
     if (len <= 0)
         return db_perror("len", E_BADARGS, me);
 
-    *arr_min = arr[0];
-    *arr_max = arr[0];
-
-    for (i = 1; i < len; i++)
-    {
-        *arr_min = MIN(*arr_min, arr[i]);
-        *arr_max = MAX(*arr_max, arr[i]);
-    }
-
-    return 0;
+    return DBCalcExtents(arr, DB_DOUBLE, len, arr_min, arr_max);
 }
 
 /***********************************************************************
@@ -11062,6 +14555,8 @@ _DBdarrminmax(double arr[], int len, double *arr_min, double *arr_max)
  *
  *    Eric Brugger, Thu Sep 23 15:05:18 PDT 1999
  *    I removed the unused argument nz.
+ *
+ *    Run the extents kernel over contiguous runs of the subset.
  ***********************************************************************/
 
 INTERNAL int
@@ -11069,72 +14564,8 @@ _DBSubsetMinMax3(float arr[], int datatype, float *amin, float *amax , int nx,
                  int ny, int ixmin, int ixmax, int iymin , int iymax,
                  int izmin, int izmax)
 {
-    int             i, j, k, index, nxy;
-    float           tmin, tmax;
-    double          dtmin, dtmax;
-    double         *darr, *damin, *damax;
-
-    switch (datatype)
-    {
-    case DB_FLOAT:
-
-        nxy = nx * ny;
-
-        index = INDEX3(ixmin, iymin, izmin, nx, nxy);
-        tmin = arr[index];
-        tmax = arr[index];
-
-        for (k = izmin; k <= izmax; k++)
-        {
-            for (j = iymin; j <= iymax; j++)
-            {
-                for (i = ixmin; i <= ixmax; i++)
-                {
-                    index = INDEX3(i, j, k, nx, nxy);
-                    tmin = MIN(tmin, arr[index]);
-                    tmax = MAX(tmax, arr[index]);
-                }
-            }
-        }
-
-        *amin = tmin;
-        *amax = tmax;
-        break;
-
-    case DB_DOUBLE:
-
-        darr = (double *)arr;
-
-        nxy = nx * ny;
-
-        index = INDEX3(ixmin, iymin, izmin, nx, nxy);
-        dtmin = darr[index];
-        dtmax = darr[index];
-
-        for (k = izmin; k <= izmax; k++)
-        {
-            for (j = iymin; j <= iymax; j++)
-            {
-                for (i = ixmin; i <= ixmax; i++)
-                {
-                    index = INDEX3(i, j, k, nx, nxy);
-                    dtmin = MIN(dtmin, darr[index]);
-                    dtmax = MAX(dtmax, darr[index]);
-                }
-            }
-        }
-
-        damin = (double *)amin;
-        damax = (double *)amax;
-        *damin = dtmin;
-        *damax = dtmax;
-        break;
-
-    default:
-        break;
-    }
-
-    return 0;
+    return db_SubsetMinMax(arr, datatype, amin, amax, nx, ny, ixmin, ixmax,
+               iymin, iymax, izmin, izmax);
 }
 
 /*----------------------------------------------------------------------
@@ -11406,63 +14837,15 @@ _DBQMCalcExtents(DBVCP2_t coord_arrays, int datatype, int const *min_index,
  *
  *    Eric Brugger, Thu Sep 23 15:05:18 PDT 1999
  *    I removed the unused argument ny.
+ *
+ *    Run the extents kernel over contiguous runs of the subset.
  *--------------------------------------------------------------------------*/
 INTERNAL int
 _DBSubsetMinMax2(void const *arr, int datatype, float *amin, float *amax, int nx,
                  int ixmin, int ixmax, int iymin, int iymax)
 {
-    int            k, j, index;
-    float          tmin, tmax;
-    double         dtmin, dtmax;
-    double        *darr = NULL, *damin = NULL, *damax = NULL;
-    float         *farr = NULL;
-
-    switch (datatype) {
-        case DB_FLOAT:
-
-            farr = (float *)arr;
-
-            index = INDEX (ixmin, iymin, nx);
-            tmin = farr[index];
-            tmax = farr[index];
-
-            for (j = iymin; j <= iymax; j++) {
-                for (k = ixmin; k <= ixmax; k++) {
-                    index = INDEX (k, j, nx);
-                    tmin = MIN (tmin, farr[index]);
-                    tmax = MAX (tmax, farr[index]);
-                }
-            }
-            *amin = tmin;
-            *amax = tmax;
-            break;
-
-        case DB_DOUBLE:
-
-            darr = (double *)arr;
-
-            index = INDEX (ixmin, iymin, nx);
-            dtmin = darr[index];
-            dtmax = darr[index];
-
-            for (j = iymin; j <= iymax; j++) {
-                for (k = ixmin; k <= ixmax; k++) {
-                    index = INDEX (k, j, nx);
-                    dtmin = MIN (dtmin, darr[index]);
-                    dtmax = MAX (dtmax, darr[index]);
-                }
-            }
-
-            damin = (double *)amin;
-            damax = (double *)amax;
-            *damin = dtmin;
-            *damax = dtmax;
-            break;
-
-        default:
-            break;
-    }
-    return 0;
+    return db_SubsetMinMax(arr, datatype, amin, amax, nx, 0, ixmin, ixmax,
+               iymin, iymax, 0, 0);
 }
 
 /*----------------------------------------------------------------------
@@ -11476,60 +14859,18 @@ _DBSubsetMinMax2(void const *arr, int datatype, float *amin, float *amax, int nx
  *      Sean Ahern, Wed Oct 21 10:55:21 PDT 1998
  *      Changed the function so that the min_extents and max_extents are 
  *      passed in as void* variables.
+ *
+ *      Compute all the coordinates' extents with db_CalcExtentsN.
  *--------------------------------------------------------------------*/
 INTERNAL int
 UM_CalcExtents(DBVCP2_t coord_arrays, int datatype, int ndims, int nnodes,
                void *min_extents, void *max_extents)
 {
-    int            i, j;
-    double       **dcoord_arrays = NULL;
-    double        *dmin_extents = NULL, *dmax_extents = NULL;
-    float         *fmin_extents = NULL, *fmax_extents = NULL;
-    float        **fcoord_arrays = NULL;
-
     if (nnodes <= 0) return 0;
 
-    if (datatype == DB_DOUBLE) {
-
-        dmin_extents = (double *)min_extents;
-        dmax_extents = (double *)max_extents;
-        dcoord_arrays = (double **)coord_arrays;
-
-        /* Initialize extent arrays */
-        for (i = 0; i < ndims; i++) {
-            dmin_extents[i] = dcoord_arrays[i][0];
-            dmax_extents[i] = dcoord_arrays[i][0];
-        }
-
-        for (i = 0; i < ndims; i++) {
-            for (j = 0; j < nnodes; j++) {
-                dmin_extents[i] = MIN(dmin_extents[i], dcoord_arrays[i][j]);
-                dmax_extents[i] = MAX(dmax_extents[i], dcoord_arrays[i][j]);
-            }
-        }
-
-    }
-    else {
-        fmin_extents = (float *)min_extents;
-        fmax_extents = (float *)max_extents;
-        fcoord_arrays = (float **)coord_arrays;
-
-        /* Initialize extent arrays */
-        for (i = 0; i < ndims; i++) {
-            fmin_extents[i] = fcoord_arrays[i][0];
-            fmax_extents[i] = fcoord_arrays[i][0];
-        }
-
-        for (i = 0; i < ndims; i++) {
-            for (j = 0; j < nnodes; j++) {
-                fmin_extents[i] = MIN(fmin_extents[i], fcoord_arrays[i][j]);
-                fmax_extents[i] = MAX(fmax_extents[i], fcoord_arrays[i][j]);
-            }
-        }
-
-    }
-
-    return 0;
+    return db_CalcExtentsN((void const * const *) coord_arrays, ndims,
+               datatype == DB_DOUBLE ? DB_DOUBLE : DB_FLOAT, (size_t) nnodes,
+               min_extents, max_extents);
 }
 
 /*-------------------------------------------------------------------------
@@ -13579,6 +16920,167 @@ DBSortObjectsByOffset(DBfile *dbfile, int nobjs,
     API_END_NOPOP;  /* If API_RETURN above is removed, use API_END instead */
 }
 
+/*-------------------------------------------------------------------------
+ * Function:    db_get_object_by_type
+ *
+ * Purpose:     Read an object of known type, as the DBGetXxx() call for
+ *              that type would.
+ *
+ * Return:      Success:        ptr to the object
+ *
+ *              Failure:        NULL
+ *-------------------------------------------------------------------------*/
+PRIVATE void *
+db_get_object_by_type(DBfile *dbfile, int type, char const *name)
+{
+    switch (type)
+    {
+        case DB_QUADMESH:
+        case DB_QUAD_RECT:
+        case DB_QUAD_CURV:      return DBGetQuadmesh(dbfile, name);
+        case DB_QUADVAR:        return DBGetQuadvar(dbfile, name);
+        case DB_UCDMESH:        return DBGetUcdmesh(dbfile, name);
+        case DB_UCDVAR:         return DBGetUcdvar(dbfile, name);
+        case DB_POINTMESH:      return DBGetPointmesh(dbfile, name);
+        case DB_POINTVAR:       return DBGetPointvar(dbfile, name);
+        case DB_CSGMESH:        return DBGetCsgmesh(dbfile, name);
+        case DB_CSGVAR:         return DBGetCsgvar(dbfile, name);
+        case DB_CSGZONELIST:    return DBGetCSGZonelist(dbfile, name);
+        case DB_MULTIMESH:      return DBGetMultimesh(dbfile, name);
+        case DB_MULTIMESHADJ:   return DBGetMultimeshadj(dbfile, name, 0, 0);
+        case DB_MULTIVAR:       return DBGetMultivar(dbfile, name);
+        case DB_MULTIMAT:       return DBGetMultimat(dbfile, name);
+        case DB_MULTIMATSPECIES: return DBGetMultimatspecies(dbfile, name);
+        case DB_MATERIAL:       return DBGetMaterial(dbfile, name);
+        case DB_MATSPECIES:     return DBGetMatspecies(dbfile, name);
+        case DB_FACELIST:       return DBGetFacelist(dbfile, name);
+        case DB_ZONELIST:       return DBGetZonelist(dbfile, name);
+        case DB_PHZONELIST:     return DBGetPHZonelist(dbfile, name);
+        case DB_CURVE:          return DBGetCurve(dbfile, name);
+        case DB_DEFVARS:        return DBGetDefvars(dbfile, name);
+        case DB_ARRAY:          return DBGetCompoundarray(dbfile, name);
+        case DB_MRGTREE:        return DBGetMrgtree(dbfile, name);
+        case DB_GROUPELMAP:     return DBGetGroupelmap(dbfile, name);
+        case DB_MRGVAR:         return DBGetMrgvar(dbfile, name);
+        case DB_VARIABLE:       return DBGetVar(dbfile, name);
+        case DB_USERDEF:        return DBGetObject(dbfile, name);
+    }
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    DBGetObjects
+ *
+ * Purpose:     Read a batch of objects from one file. On return,
+ *              results[i] holds what the DBGetXxx() call for types[i]
+ *              returns for names[i] (a DBquadmesh* for a DB_QUADMESH
+ *              and so on; DBGetVar() for DB_VARIABLE and DBGetObject()
+ *              for DB_USERDEF), or NULL if it could not be read. If
+ *              `types' is NULL, or an entry is DB_INVALID_OBJECT, the
+ *              type is obtained with DBInqVarType(). The caller frees
+ *              each result with the matching DBFreeXxx().
+ *
+ *              Objects are read in order of their offset in the file,
+ *              as given by DBSortObjectsByOffset, so the driver's I/O
+ *              moves forward through the file instead of seeking back
+ *              and forth between objects. Drivers that can (HDF5 files
+ *              on the default sec2 driver) first read the raw data of
+ *              all the objects in a few large reads, merging datasets
+ *              that are close in the file, and fill in the objects from
+ *              that data. This holds the raw data of the whole batch in
+ *              memory until the objects are filled in.
+ *
+ * Return:      Success:        number of objects read
+ *
+ *              Failure:        -1
+ *
+ *-------------------------------------------------------------------------*/
+PUBLIC int
+DBGetObjects(DBfile *dbfile, int nobjs, char const *const *names,
+    int const *types, void **results)
+{
+    int *ordering = NULL;
+    int  i, nread = 0;
+
+    API_BEGIN2("DBGetObjects", int, -1, api_dummy)
+    {
+        if (!dbfile)
+            API_ERROR(NULL, E_NOFILE);
+        if (nobjs < 0)
+            API_ERROR("nobjs", E_BADARGS);
+        if (nobjs && !names)
+            API_ERROR("names", E_BADARGS);
+        if (nobjs && !results)
+            API_ERROR("results", E_BADARGS);
+        for (i = 0; i < nobjs; i++)
+        {
+            if (!names[i] || !*names[i])
+                API_ERROR("names", E_BADARGS);
+            results[i] = NULL;
+        }
+        if (nobjs == 0)
+            API_RETURN(0);
+
+        if (NULL == (ordering = ALLOC_N(int, nobjs)))
+            API_ERROR(NULL, E_NOMEM);
+        if (!dbfile->pub.sort_obo ||
+            (dbfile->pub.sort_obo)(dbfile, nobjs, names, ordering) != 0)
+        {
+            for (i = 0; i < nobjs; i++)
+                ordering[i] = i;
+        }
+
+        /* The objects are still read if the driver can't read ahead */
+        if (dbfile->pub.prefetch)
+            (dbfile->pub.prefetch)(dbfile, nobjs, names);
+
+        for (i = 0; i < nobjs; i++)
+        {
+            int k = ordering[i];
+            char const *name = names[k];
+            context_t *old = NULL;
+            int type;
+
+            /* Nested API calls don't change directory for drivers that
+               can't take a path, so do it here */
+            if (!dbfile->pub.pathok && strchr(name, '/'))
+            {
+                char const *base = name;
+                PROTECT {
+                    old = context_switch(dbfile, name, &base);
+                } CLEANUP {
+                    CANCEL_UNWIND;
+                } END_PROTECT;
+                if (!old)
+                    continue;
+                name = base;
+            }
+
+            /* A failure reading one object must not stop the others */
+            type = types ? types[k] : DB_INVALID_OBJECT;
+            PROTECT {
+                if (type == DB_INVALID_OBJECT)
+                    type = DBInqVarType(dbfile, name);
+                results[k] = db_get_object_by_type(dbfile, type, name);
+            } CLEANUP {
+                results[k] = NULL;
+                CANCEL_UNWIND;
+            } END_PROTECT;
+
+            if (old)
+                context_restore(dbfile, old);
+            if (results[k])
+                nread++;
+        }
+
+        if (dbfile->pub.prefetch)
+            (dbfile->pub.prefetch)(dbfile, 0, NULL);
+        FREE(ordering);
+        API_RETURN(nread);
+    }
+    API_END_NOPOP; /* If API_RETURN above is removed, use API_END instead */
+}
+
 /*----------------------------------------------------------------------
  * Purpose
  *
@@ -14254,7 +17756,7 @@ char *db_unsplit_path ( const db_Pathname *p )
    {  db_PathnameComponent *c;
       int          first;
       int          slashed;
-      static char  tmp[4096];
+      static SILO_THREAD_LOCAL char tmp[4096];
 
       tmp[0] = '\0';
       first   = TRUE;
@@ -58,12 +58,28 @@ product endorsement purposes.
 
 typedef struct _DBexprnode {
     char type;
-    int val;
+    int val;                    /* constant, or array index for '$' and '#' */
     char sval[128];
+    DBnamescheme *embed;        /* namescheme made from a string constant */
     struct _DBexprnode *left;
     struct _DBexprnode *right;
 } DBexprnode;
 
+/* A conversion spec. compiled by DBMakeNamescheme */
+typedef struct _DBnscspec {
+    DBexprnode *tree;           /* expression tree */
+    char *fmt;                  /* the spec. and the literal text after it */
+    int isstr;                  /* the spec. converts a string */
+} DBnscspec;
+
+/* The value of an expression, either an int or a string */
+typedef struct _DBexprval {
+    int ival;
+    int isstr;
+    DBnamescheme const *ns;     /* string to be evaluated as a namescheme */
+    char const *str;            /* string from an external array */
+} DBexprval;
+
 static void
 FreeTree(DBexprnode *tree)
 {
@@ -71,6 +87,8 @@ FreeTree(DBexprnode *tree)
         return;
     FreeTree(tree->left);
     FreeTree(tree->right);
+    if (tree->embed)
+        DBFreeNamescheme(tree->embed);
     free(tree);
 }
 
@@ -247,25 +265,12 @@ BuildExprTree(const char **porig)
     return tree;
 }
 
-/* very simple circular cache for a handful of embedded strings */
-static int SaveInternalString(DBnamescheme const *ns, const char *sval)
-{
-    /* The modn/embedns portion of a namescheme is 'internal' state
-       allowed to disobey const rules */
-    DBnamescheme *non_const_ns = (DBnamescheme*) ns;
-    int modn = non_const_ns->nembed++ % DB_MAX_EXPNS;
-    if (non_const_ns->embedns[modn])
-        DBFreeNamescheme(non_const_ns->embedns[modn]);
-    non_const_ns->embedns[modn] = DBMakeNamescheme(sval);
-    return modn;
-}
-
 /* very simple circular cache for strings returned from DBGetName */
 #define DB_MAX_RETSTRS 32
-static char * retstrbuf[DB_MAX_RETSTRS];
+static SILO_THREAD_LOCAL char * retstrbuf[DB_MAX_RETSTRS];
 static char * SaveReturnedString(char const * retstr)
 {
-    static size_t n = 0;
+    static SILO_THREAD_LOCAL size_t n = 0;
     size_t modn;
 
     /* Hack to cleanup when really needed */
@@ -284,65 +289,137 @@ static char * SaveReturnedString(char const * retstr)
     return retstrbuf[modn];
 }
 
-static int
-EvalExprTree(DBnamescheme const *ns, DBexprnode *tree, int n)
+/* Resolve what can be resolved once, when the namescheme is made: the
+   external array each array ref. uses and the namescheme each string
+   constant stands for. */
+static void
+CompileExprTree(DBnamescheme const *ns, DBexprnode *tree)
 {
+    int i;
+
     if (tree == 0)
-        return 0;
-    else if ((tree->type == '$' || tree->type == '#') && tree->left != 0)
+        return;
+    if (tree->type == '$' || tree->type == '#')
     {
-        int i, q = EvalExprTree(ns, tree->left, n);
+        tree->val = -1;
         for (i = 0; i < ns->narrefs; i++)
         {
             if (strcmp(tree->sval, ns->arrnames[i]) == 0)
             {
-                if (tree->type == '$')
-                    return SaveInternalString(ns,  ((char**)ns->arrvals[i])[q]);
-                else
-                    return ((int*)ns->arrvals[i])[q];
+                tree->val = i;
+                break;
+            }
+        }
+    }
+    else if (tree->type == 's' && tree->left == 0 && tree->right == 0)
+    {
+        tree->embed = DBMakeNamescheme(tree->sval);
+    }
+    CompileExprTree(ns, tree->left);
+    CompileExprTree(ns, tree->right);
+}
+
+static DBexprval
+EvalExprTree(DBnamescheme const *ns, DBexprnode const *tree, int n)
+{
+    DBexprval rv = {0, 0, 0, 0};
+
+    if (tree == 0)
+        return rv;
+    else if ((tree->type == '$' || tree->type == '#') && tree->left != 0)
+    {
+        int q = EvalExprTree(ns, tree->left, n).ival;
+        if (tree->val >= 0)
+        {
+            if (tree->type == '$')
+            {
+                rv.isstr = 1;
+                rv.str = ((char**)ns->arrvals[tree->val])[q];
+            }
+            else
+            {
+                rv.ival = ((int*)ns->arrvals[tree->val])[q];
             }
         }
     }
     else if (tree->left == 0 && tree->right == 0)
     {
         if (tree->type == 'c')
-            return tree->val;
+            rv.ival = tree->val;
         else if (tree->type == 'n')
-            return n;
+            rv.ival = n;
         else if (tree->type == 's')
-            return SaveInternalString(ns, tree->sval);
+        {
+            rv.isstr = 1;
+            rv.ns = tree->embed;
+        }
     }
     else if (tree->left != 0 && tree->right != 0)
     {
-        int vc = 0, vl = 0, vr = 0;
+        int vl, vr;
         if (tree->type == '?')
         {
-            vc = EvalExprTree(ns, tree->left, n);
+            int vc = EvalExprTree(ns, tree->left, n).ival;
             tree = tree->right;
-            if (vc) 
-                vl = EvalExprTree(ns, tree->left, n);
-            else
-                vr = EvalExprTree(ns, tree->right, n);
-        }
-        else
-        {
-            vl = EvalExprTree(ns, tree->left, n);
-            vr = EvalExprTree(ns, tree->right, n);
+            return EvalExprTree(ns, vc ? tree->left : tree->right, n);
         }
+        vl = EvalExprTree(ns, tree->left, n).ival;
+        vr = EvalExprTree(ns, tree->right, n).ival;
         switch (tree->type)
         {
-            case '+': return vl + vr;
-            case '-': return vl - vr;
-            case '*': return vl * vr;
-            case '/': return (vr != 0 ? vl / vr : 1);
-            case '%': return (vr != 0 ? vl % vr : 1);
-            case '|': return vl | vr;
-            case '&': return vl & vr;
-            case '^': return vl ^ vr;
-            case ':': return vc ? vl : vr; 
+            case '+': rv.ival = vl + vr; break;
+            case '-': rv.ival = vl - vr; break;
+            case '*': rv.ival = vl * vr; break;
+            case '/': rv.ival = (vr != 0 ? vl / vr : 1); break;
+            case '%': rv.ival = (vr != 0 ? vl % vr : 1); break;
+            case '|': rv.ival = vl | vr; break;
+            case '&': rv.ival = vl & vr; break;
+            case '^': rv.ival = vl ^ vr; break;
         }
     }
-    return 0;
+    return rv;
+}
+
+/* Build the expression tree and the printf format of each conversion
+   spec. of a namescheme */
+static DBnscspec *
+CompileNamescheme(DBnamescheme const *ns)
+{
+    DBnscspec *cspecs = (DBnscspec *) calloc(ns->ncspecs, sizeof(DBnscspec));
+    int i;
+
+    for (i = 0; cspecs && i < ns->ncspecs; i++)
+    {
+        char const *expr = ns->exprstrs[i];
+        char const *p = ns->fmtptrs[i] + 1;
+
+        cspecs[i].tree = BuildExprTree(&expr);
+        CompileExprTree(ns, cspecs[i].tree);
+        cspecs[i].fmt = STRNDUP(ns->fmtptrs[i], (int) (ns->fmtptrs[i+1] - ns->fmtptrs[i]));
+
+        /* skip flags, width and precision to the conversion character */
+        while (*p && strchr("-+ #0123456789.", *p))
+            p++;
+        cspecs[i].isstr = *p == 's';
+    }
+    return cspecs;
+}
+
+INTERNAL void
+db_FreeNameschemeSpecs(DBnamescheme *ns)
+{
+    DBnscspec *cspecs = (DBnscspec *) ns->cspecs;
+    int i;
+
+    if (!cspecs)
+        return;
+    for (i = 0; i < ns->ncspecs; i++)
+    {
+        FreeTree(cspecs[i].tree);
+        FREE(cspecs[i].fmt);
+    }
+    FREE(cspecs);
+    ns->cspecs = 0;
 }
 
 PUBLIC DBnamescheme *
@@ -408,7 +485,7 @@ DBMakeNamescheme(char const *fmt, ...)
             }
         }
     }
-    rv->fmtptrs[rv->ncspecs] = &(rv->fmt[n+1]);
+    rv->fmtptrs[rv->ncspecs] = &(rv->fmt[rv->fmtlen]);
 
     /* If there are no conversion specs., we have nothing to do */
     /* However, in this case, assume the first char is a real char. */
@@ -417,6 +494,7 @@ DBMakeNamescheme(char const *fmt, ...)
         free(rv->fmt);
         rv->fmt = STRNDUP(&fmt[0],n);
         rv->fmtlen = n;
+        rv->fmtptrs[0] = &(rv->fmt[rv->fmtlen]);
         return rv;
     }
 
@@ -559,15 +637,99 @@ DBMakeNamescheme(char const *fmt, ...)
         }
     }
 
+    /* Parse the expressions once, here, rather than on every DBGetName */
+    if (rv && (rv->cspecs = CompileNamescheme(rv)) == 0)
+    {
+        DBFreeNamescheme(rv);
+        rv = 0;
+    }
+
     return rv;
 }
 
+/* Append the result of a printf style conversion to BUF */
+static void
+AppendToBuf(char *buf, int len, int *pos, char const *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if (*pos >= len - 1)
+        return;
+    va_start(ap, fmt);
+    n = vsnprintf(buf + *pos, (size_t) (len - *pos), fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        *pos += n < len - *pos ? n : len - *pos - 1;
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBGetNameBuf
+ *
+ * Purpose:  Reentrant form of DBGetName. The name of entry NATNUM of
+ *           NS is written into the caller's BUF of LEN bytes and is
+ *           truncated if it does not fit.
+ *
+ * Returns:  BUF, or NULL if BUF is NULL or LEN is not positive.
+ *--------------------------------------------------------------------*/
+PUBLIC char *
+DBGetNameBuf(DBnamescheme const *ns, int natnum, char *buf, int len)
+{
+    DBnscspec const *cspecs;
+    int i, pos = 0;
+
+    if (!buf || len <= 0)
+        return 0;
+    buf[0] = '\0';
+    if (!ns || !ns->fmt)
+        return buf;
+
+    if (ns->ncspecs == 0 || !ns->cspecs)
+    {
+        AppendToBuf(buf, len, &pos, "%s", ns->fmt);
+        return buf;
+    }
+
+    cspecs = (DBnscspec const *) ns->cspecs;
+    AppendToBuf(buf, len, &pos, "%.*s", (int) (ns->fmtptrs[0] - ns->fmt), ns->fmt);
+    for (i = 0; i < ns->ncspecs; i++)
+    {
+        DBexprval val = EvalExprTree(ns, cspecs[i].tree, natnum);
+
+        if (!cspecs[i].isstr)
+        {
+            AppendToBuf(buf, len, &pos, cspecs[i].fmt, val.ival);
+        }
+        else
+        {
+            char tmp[1024];
+
+            tmp[0] = '\0';
+            if (val.ns)
+            {
+                DBGetNameBuf(val.ns, natnum, tmp, sizeof(tmp));
+            }
+            else if (val.str && strchr(val.str, '%'))
+            {
+                /* strings from external arrays may be nameschemes too */
+                DBnamescheme *embed = DBMakeNamescheme(val.str);
+                DBGetNameBuf(embed, natnum, tmp, sizeof(tmp));
+                if (embed) DBFreeNamescheme(embed);
+            }
+            else if (val.str)
+            {
+                strncat(tmp, val.str, sizeof(tmp)-1);
+            }
+            AppendToBuf(buf, len, &pos, cspecs[i].fmt, tmp);
+        }
+    }
+    return buf;
+}
+
 PUBLIC const char *
 DBGetName(DBnamescheme const *ns, int natnum)
 {
-    char *currentExpr, *tmpExpr;
     char retval[1024];
-    int i;
 
     /* a hackish way to cleanup the saved returned string buffer */
     if (ns == 0 && natnum == -1) return SaveReturnedString(0);
@@ -575,45 +737,48 @@ DBGetName(DBnamescheme const *ns, int natnum)
 
     if (!ns->fmt) return "";
 
-    retval[0] = '\0';
-    strncat(retval, ns->fmt, ns->fmtptrs[0] - ns->fmt);
-    for (i = 0; i < ns->ncspecs; i++)
+    return SaveReturnedString(DBGetNameBuf(ns, natnum, retval, sizeof(retval)));
+}
+
+/*----------------------------------------------------------------------
+ * Routine:  DBGetNames
+ *
+ * Purpose:  Evaluate NS for the COUNT consecutive entries starting at
+ *           FIRST. OUT must have room for COUNT pointers and receives
+ *           allocated strings the caller frees with free(), or all at
+ *           once along with OUT with DBFreeStringArray if OUT was
+ *           itself allocated with malloc().
+ *
+ * Returns:  0 on success, -1 on failure
+ *--------------------------------------------------------------------*/
+PUBLIC int
+DBGetNames(DBnamescheme const *ns, int first, int count, char **out)
+{
+    char name[1024];
+    int i;
+
+    if (!out || count < 0)
+        return -1;
+    for (i = 0; i < count; i++)
     {
-        char tmp[256];
-        char tmpfmt[256] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-                            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-        DBexprnode *exprtree;
-        int theVal;
-
-        currentExpr = STRDUP(ns->exprstrs[i]);
-        tmpExpr = currentExpr;
-        exprtree = BuildExprTree((const char **)&currentExpr);
-        theVal = EvalExprTree(ns, exprtree, natnum);
-        FreeTree(exprtree);
-        strncpy(tmpfmt, ns->fmtptrs[i], ns->fmtptrs[i+1] - ns->fmtptrs[i]);
-        if (strncmp(tmpfmt, "%s", 2) == 0 && 0 <= theVal && theVal < DB_MAX_EXPNS)
-            sprintf(tmp, tmpfmt, DBGetName(ns->embedns[theVal],natnum));
-        else
-            sprintf(tmp, tmpfmt, theVal);
-        strcat(retval, tmp);
-        FREE(tmpExpr);
+        if ((out[i] = STRDUP(DBGetNameBuf(ns, first + i, name, sizeof(name)))) == 0)
+        {
+            while (i--)
+                FREE(out[i]);
+            return -1;
+        }
     }
-    return SaveReturnedString(retval);
+    return 0;
 }
 
 PUBLIC int
 DBGetIndex(DBnamescheme const *ns, int natnum)
 {
-    char const *name_str = DBGetName(ns, natnum);
+    char name_str[1024];
     int i = 0;
 
-    if (!name_str) return -1;
+    if (!ns) return -1;
+    DBGetNameBuf(ns, natnum, name_str, sizeof(name_str));
 
     while (name_str[i] && !(strchr("0123456789+-",      name_str[i  ]) &&
                             strchr("0123456789.aAbBcCdDeEfFxX+-", name_str[i+1])))
@@ -627,7 +792,7 @@ DBGetIndex(DBnamescheme const *ns, int natnum)
 PUBLIC char const *
 DBSPrintf(char const *fmt, ...)
 {
-    static char strbuf[2048];
+    static SILO_THREAD_LOCAL char strbuf[2048];
     static size_t const nmax = sizeof(strbuf);
     va_list ap;
     int n, en;
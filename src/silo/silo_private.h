@@ -93,7 +93,10 @@ be used for advertising or product endorsement purposes.
  * the failure value as registered with API_BEGIN may be done by calling
  * API_ERROR().  API_BEGIN and API_BEGIN2 cannot be used in routines that
  * are recursive.  This is because there are two local variables that are
- * declared static so that setjmp and longjmp work properly.
+ * declared static so that setjmp and longjmp work properly. In a thread-safe
+ * build (SILO_THREADSAFE) those variables and the jump stack itself are
+ * thread-local, and the outermost API call on a thread holds the locks
+ * described below until it returns.
  *
  * Synopsis:
  *
@@ -234,8 +237,97 @@ typedef struct context_t {
     char          *name;
 } context_t;
 
-#define jstk_push()     {jstk_t*jt=ALLOC(jstk_t);jt->prev=SILO_Globals.Jstk;SILO_Globals.Jstk=jt;}
-#define jstk_pop()      if(SILO_Globals.Jstk){jstk_t*jt=SILO_Globals.Jstk;SILO_Globals.Jstk=SILO_Globals.Jstk->prev;FREE(jt);}
+/*
+ * Thread safety.
+ *
+ * In a thread-safe build each thread has its own jump stack, DB_JSTK, and
+ * its own error state. The outermost API call on a thread that names a
+ * DBfile (API_BEGIN2) locks that file and the driver that owns it until
+ * the call returns. Nested API calls take no further locks. The driver
+ * lock is needed because none of the drivers (nor PDB-lite and, in most
+ * installations, HDF5 beneath them) are reentrant; it is what serializes
+ * access to driver-level static state. DBOpen and DBCreate take the
+ * driver lock(s) themselves. A library-wide lock, always taken last and
+ * never held while acquiring another, protects file ids and other shared
+ * state. The open file registry, which every API_BEGIN2 consults, has a
+ * reader/writer lock of its own so that those lookups run concurrently;
+ * it is taken before the library-wide lock when both are needed.
+ *
+ * Settings made with DBSetXxx() calls on the library as a whole are not
+ * locked and should be made before threads are started. The exception is
+ * DBShowErrors(DB_SUSPEND/DB_RESUME), used internally, which silences
+ * only the calling thread; DB_ERR_LEVEL is the level in effect for it.
+ */
+#define DB_MAX_FILEIDS          (1024*DB_NFILES) /*open files, at most */
+
+#if SILO_THREADSAFE
+extern SILO_THREAD_LOCAL jstk_t *db_jstk;
+#define DB_JSTK                 db_jstk
+#define DB_API_LOCK_FILE(F)     db_api_lock_file(F)
+#define DB_API_LOCK_DRIVERS(T)  db_api_lock_drivers(T)
+#define DB_API_UNLOCK()         db_api_unlock()
+#define DB_LOCK_GLOBAL()        db_lock_global()
+#define DB_UNLOCK_GLOBAL()      db_unlock_global()
+#else
+#define DB_JSTK                 SILO_Globals.Jstk
+#define DB_API_LOCK_FILE(F)
+#define DB_API_LOCK_DRIVERS(T)
+#define DB_API_UNLOCK()
+#define DB_LOCK_GLOBAL()
+#define DB_UNLOCK_GLOBAL()
+#endif
+
+extern SILO_THREAD_LOCAL int db_err_suspended;
+
+/*
+ * File statistics, see DBSetFileStats.
+ *
+ * While DB_STATS_ON, the outermost API call on a file makes that file's
+ * DBfilestats the thread's current one (DB_STATS) and times itself into
+ * the entry for its call site, which is looked up once. Drivers count
+ * their I/O into it with db_StatRead() etc.; I/O done outside any file's
+ * API call goes straight to the global totals. A driver brackets reads and
+ * writes of metadata with DB_STATS_META_BEGIN/END so that they are counted
+ * as metadata rather than raw data.
+ */
+extern int db_stats_on;
+extern SILO_THREAD_LOCAL DBfilestats *db_stats_cur;
+extern SILO_THREAD_LOCAL int db_stats_meta;
+#define DB_STATS_ON             (db_stats_on)
+#define DB_STATS                db_stats_cur
+#define DB_STATS_META           (db_stats_meta > 0)
+#define DB_STATS_META_BEGIN()   (db_stats_meta++)
+#define DB_STATS_META_END()     (db_stats_meta--)
+
+/*
+ * Threaded work, see DBSetThreads. DB_THREADS is the most threads any one
+ * call may split its work among, which is always one in builds without
+ * thread safety. db_RunJobs runs a function on each of an array of jobs,
+ * the first on the calling thread and the rest on their own threads.
+ * Code that must keep working on the calling thread while the jobs run
+ * brackets that work with db_StartJobs and db_FinishJobs instead.
+ */
+#if SILO_THREADSAFE
+#define DB_THREADS              (SILO_Globals.threads)
+#else
+#define DB_THREADS              1
+#endif
+typedef void (*db_job_func_t)(void *);
+typedef struct db_jobs_t db_jobs_t;
+
+/*
+ * API tracing, see DBSetTrace. db_trace_enter records the entry of the
+ * outermost API call into the calling thread's ring and echoes the name
+ * of every call to DBDebugAPI when that is set. The exit is recorded
+ * where the call's statistics are.
+ */
+extern int db_trace_on;
+#define DB_TRACING              (db_trace_on || DBDebugAPI > 0)
+#define DB_ERR_LEVEL      (db_err_suspended ? DB_NONE : SILO_Globals._db_err_level)
+#define DB_ERR_LEVEL_DRVR (db_err_suspended ? DB_NONE : SILO_Globals._db_err_level_drvr)
+
+#define jstk_push()     {jstk_t*jt=ALLOC(jstk_t);jt->prev=DB_JSTK;DB_JSTK=jt;}
+#define jstk_pop()      if(DB_JSTK){jstk_t*jt=DB_JSTK;DB_JSTK=DB_JSTK->prev;FREE(jt);}
 
 #define DEPRECATE_MSG(M,Maj,Min,Alt)                                          \
 {                                                                             \
@@ -257,20 +349,25 @@ typedef struct context_t {
 
 #define API_BEGIN(M,T,R) {                                                    \
                         char    *me = M ;                                     \
-                        static int     jstat ;                                \
-                        static context_t *jold ;                              \
+                        static SILO_THREAD_LOCAL int     jstat ;              \
+                        static SILO_THREAD_LOCAL context_t *jold ;            \
+                        static SILO_THREAD_LOCAL double  jt0 ;                \
+                        static int      jtid = -1 ;                           \
+                        static int      jsid = -1 ;                           \
                         DBfile  *jdbfile = NULL ;                             \
                         T jrv = R ;                                           \
                         jstat = 0 ;                                           \
                         jold = NULL ;                                         \
-                        if (DBDebugAPI>0) {                                   \
-                           write (DBDebugAPI, M, strlen(M));                  \
-                           write (DBDebugAPI, "\n", 1);                       \
-                        }                                                     \
-                        if (!SILO_Globals.Jstk){                              \
+                        jt0 = -1 ;                                            \
+                        if (DB_TRACING)                                       \
+                           db_trace_enter (&jtid, M, NULL, NULL) ;            \
+                        if (!DB_JSTK){                                        \
                            jstk_push() ;                                      \
-                           if (setjmp(SILO_Globals.Jstk->jbuf)) {             \
-                              while (SILO_Globals.Jstk) jstk_pop () ;         \
+                           if (setjmp(DB_JSTK->jbuf)) {                       \
+                              while (DB_JSTK) jstk_pop () ;                   \
+                              if (db_trace_on) db_trace_exit () ;             \
+                              if (jt0 >= 0) db_stats_end (jsid, jt0) ;        \
+                              DB_API_UNLOCK() ;                               \
                               db_perror ("", db_errno, me) ;                  \
                               return R ;                                      \
                            }                                                  \
@@ -283,42 +380,52 @@ typedef struct context_t {
 
 #define API_BEGIN2(M,T,R,NM) {                                                \
                         char    *me = M ;                                     \
-                        static int     jstat ;                                \
-                        static context_t *jold ;                              \
+                        static SILO_THREAD_LOCAL int     jstat ;              \
+                        static SILO_THREAD_LOCAL context_t *jold ;            \
+                        static SILO_THREAD_LOCAL double  jt0 ;                \
+                        static int      jtid = -1 ;                           \
+                        static int      jsid = -1 ;                           \
                         DBfile  *jdbfile = dbfile ;                           \
                         T jrv = R ;                                           \
                         jstat = 0 ;                                           \
                         jold = NULL ;                                         \
+                        jt0 = -1 ;                                            \
                         if (db_isregistered_file(dbfile,0) == -1)             \
                         {                                                     \
                             db_perror("", E_NOTREG, me);                      \
                             return R;                                         \
                         }                                                     \
-                        if (DBDebugAPI>0) {                                   \
-                           write (DBDebugAPI, M, strlen(M));                  \
-                           write (DBDebugAPI, "\n", 1);                       \
-                        }                                                     \
-                        if (!SILO_Globals.Jstk){                              \
+                        if (DB_TRACING)                                       \
+                           db_trace_enter (&jtid, M, jdbfile, NM) ;           \
+                        if (!DB_JSTK){                                        \
                            jstk_push() ;                                      \
-                           if (setjmp(SILO_Globals.Jstk->jbuf)) {             \
+                           if (setjmp(DB_JSTK->jbuf)) {                       \
                               if (jold) {                                     \
                                  context_restore (jdbfile, jold) ;            \
                               }                                               \
-                              while (SILO_Globals.Jstk) jstk_pop () ;         \
+                              while (DB_JSTK) jstk_pop () ;                   \
+                              if (db_trace_on) db_trace_exit () ;             \
+                              if (jt0 >= 0) db_stats_end (jsid, jt0) ;        \
+                              DB_API_UNLOCK() ;                               \
                               db_perror ("", db_errno, me) ;                  \
                               return R ;                                      \
                            }                                                  \
                            jstat = 1 ;                                        \
+                           DB_API_LOCK_FILE(jdbfile) ;                        \
+                           if (DB_STATS_ON)                                   \
+                              jt0 = db_stats_begin (jdbfile, &jsid, M) ;      \
                            if (NM && jdbfile && !jdbfile->pub.pathok) {       \
                               char const *jr ;                                \
                               jold = context_switch (jdbfile,NM,&jr) ;        \
-                              if (!jold) longjmp (SILO_Globals.Jstk->jbuf, -1) ;\
+                              if (!jold) longjmp (DB_JSTK->jbuf, -1) ;        \
                               NM = jr ;                                       \
                            }                                                  \
                         }
 
 #define API_END         if (jold) context_restore (jdbfile, jold) ;     \
-                        if (jstat) jstk_pop() ;                         \
+                        if (jstat) {if (db_trace_on) db_trace_exit();   \
+                                    if (jt0>=0) db_stats_end(jsid,jt0); \
+                                    DB_API_UNLOCK(); jstk_pop();}       \
                      }                        /*API_BEGIN or API_BEGIN2 */
 
 #define API_END_NOPOP   }         /*API_BEGIN or API_BEGIN2 */
@@ -326,21 +433,27 @@ typedef struct context_t {
 #define API_ERROR(S,N)  {                                               \
                            db_perror (S,N,me) ; /*might never return*/  \
                            if (jold) context_restore (jdbfile, jold) ;  \
-                           if (jstat) jstk_pop() ;                      \
+                           if (jstat) {if (db_trace_on) db_trace_exit();\
+                                       if (jt0 >= 0)                    \
+                                          db_stats_end(jsid, jt0);      \
+                                       DB_API_UNLOCK(); jstk_pop();}    \
                            return jrv ;                                 \
                         }
 
 #define API_RETURN(R)   {                                               \
                            jrv = R ; /*might be a calculation*/         \
                            if (jold) context_restore (jdbfile, jold) ;  \
-                           if (jstat) jstk_pop() ;                      \
+                           if (jstat) {if (db_trace_on) db_trace_exit();\
+                                       if (jt0 >= 0)                    \
+                                          db_stats_end(jsid, jt0);      \
+                                       DB_API_UNLOCK(); jstk_pop();}    \
                            return jrv ;                                 \
                         }
 
-#define PROTECT         {jstk_push();if(!setjmp(SILO_Globals.Jstk->jbuf)){
-#define UNWIND()        longjmp(SILO_Globals.Jstk->jbuf,-1)
+#define PROTECT         {jstk_push();if(!setjmp(DB_JSTK->jbuf)){
+#define UNWIND()        longjmp(DB_JSTK->jbuf,-1)
 #define CLEANUP         jstk_pop();}else{int jcan=0;
-#define END_PROTECT     jstk_pop();if(!jcan&&SILO_Globals.Jstk)longjmp(SILO_Globals.Jstk->jbuf,-1);}}
+#define END_PROTECT     jstk_pop();if(!jcan&&DB_JSTK)longjmp(DB_JSTK->jbuf,-1);}}
 #define CANCEL_UNWIND   jcan=1
 
 /*
@@ -384,6 +497,7 @@ typedef struct context_t {
 #define REALLOC(P,T,N)  REALLOC_N((P),(T),(N))
 #define REALLOC_N(P,T,N)        ((T*)((N)>0?realloc((P),(size_t)((N)*sizeof(T))):0))
 #define FREE(M)         if(M){free(M);(M)=NULL;}
+#define FREE_BULK(M)    if(M){db_free_bulk(M);(M)=NULL;}
 #define STRDUP(S)               _db_safe_strdup((S))
 #define STRNDUP(S,N)            db_strndup((S),(N))
 
@@ -788,19 +902,19 @@ struct _mrgt {
     char      **_mrgvar_rnames;
 };
 
-extern struct _ma _ma;
-extern struct _ms _ms;
-extern struct _csgm _csgm;
-extern struct _pm _pm;
-extern struct _qm _qm;
-extern struct _um _um;
-extern struct _uzl _uzl;
-extern struct _phzl _phzl;
-extern struct _csgzl _csgzl;
-extern struct _mm _mm;
-extern struct _cu _cu;
-extern struct _dv _dv;
-extern struct _mrgt _mrgt;
+extern SILO_THREAD_LOCAL struct _ma _ma;
+extern SILO_THREAD_LOCAL struct _ms _ms;
+extern SILO_THREAD_LOCAL struct _csgm _csgm;
+extern SILO_THREAD_LOCAL struct _pm _pm;
+extern SILO_THREAD_LOCAL struct _qm _qm;
+extern SILO_THREAD_LOCAL struct _um _um;
+extern SILO_THREAD_LOCAL struct _uzl _uzl;
+extern SILO_THREAD_LOCAL struct _phzl _phzl;
+extern SILO_THREAD_LOCAL struct _csgzl _csgzl;
+extern SILO_THREAD_LOCAL struct _mm _mm;
+extern SILO_THREAD_LOCAL struct _cu _cu;
+extern SILO_THREAD_LOCAL struct _dv _dv;
+extern SILO_THREAD_LOCAL struct _mrgt _mrgt;
 
 /*-------------------------------------------------------------------------
  * Filter Name Table.  Filters are modules inserted between the API and the
@@ -844,6 +958,7 @@ typedef struct SILO_Globals_t {
     int allowLongStrComponents;
     int maxDeprecateWarnings;
     char *compressionParams;
+    struct db_comppolicy_t *compressionPolicy; /* compressionParams compiled */
     float compressionMinratio;
     int compressionErrmode;
     int compatabilityMode;
@@ -853,9 +968,69 @@ typedef struct SILO_Globals_t {
     int _db_err_level_drvr;
     jstk_t *Jstk;   /*error jump stack  */
     int unknownDriverPriorities[MAX_FILE_OPTIONS_SETS+10+1];
+    DBAllocFunc_t allocFunc;  /* bulk data allocator hook */
+    DBFreeFunc_t freeFunc;    /* bulk data free hook */
+    void *allocClientData;    /* client data passed to alloc/free hooks */
+    int threads;              /* most threads any one call may use */
+    int blockStats;           /* store block statistics and indices */
 } SILO_Globals_t;
 extern SILO_Globals_t SILO_Globals;
 
+/*
+ * A compression string compiled by db_CompileCompression. The string is
+ * a list of rules separated by `;'. Each rule has KEY=VALUE settings and
+ * optionally OBJTYPE=, NAME= and DATATYPE= selectors. rules[0] merges
+ * the settings of every rule without selectors, in order, so a later
+ * setting of a key wins. The other rules start from it, and it applies
+ * to data no other rule selects.
+ */
+#define COMPRESSION_ERRMODE_FALLBACK 0
+#define COMPRESSION_ERRMODE_FAIL     1
+
+#define DB_COMPMETHOD_NONE      0
+#define DB_COMPMETHOD_GZIP      1
+#define DB_COMPMETHOD_SZIP      2
+#define DB_COMPMETHOD_HZIP      3
+#define DB_COMPMETHOD_FPZIP     4
+#define DB_COMPMETHOD_ZFP       5
+#define DB_COMPMETHOD_AUTO      6
+
+#define DB_ZFPMODE_RATE         1
+#define DB_ZFPMODE_PRECISION    2
+#define DB_ZFPMODE_ACCURACY     3
+#define DB_ZFPMODE_EXPERT       4
+#define DB_ZFPMODE_REVERSIBLE   5
+
+typedef struct db_comprule_t {
+    int         objtype;        /* DB_XXX object type or -1 for any     */
+    int         datatype;       /* DB_XXX data type or -1 for any       */
+    char       *name;           /* object name pattern or NULL for any  */
+    int         bad;            /* the rule could not be understood     */
+    int         method;         /* DB_COMPMETHOD_XXX                    */
+    int         errmode;        /* COMPRESSION_ERRMODE_XXX              */
+    float       minratio;
+    long long   minsize;        /* fewer values are stored raw          */
+    long long   chunk;          /* values per tile or 0 for one chunk   */
+    long long   sample;         /* AUTO SAMPLE= values trial compressed */
+    double      minspeed;       /* AUTO MINSPEED= in MB/s or 0          */
+    int         level;          /* GZIP LEVEL=                          */
+    int         block;          /* SZIP BLOCK=                          */
+    int         szipec;         /* SZIP MASK=EC                         */
+    int         hzcodec;        /* HZIP CODEC=: -1 unset, 0 base, 1 zlib*/
+    int         hzbits;         /* HZIP BITS= or -1                     */
+    int         loss;           /* FPZIP LOSS=                          */
+    int         zfpmode;        /* DB_ZFPMODE_XXX                       */
+    double      zfpparam;       /* ZFP RATE= or ACCURACY=               */
+    unsigned    zfpprec;        /* ZFP PRECISION=                       */
+    unsigned    zfpexpert[3];   /* ZFP EXPERT= minbits,maxbits,maxprec  */
+    int         zfpminexp;      /* ZFP EXPERT= minexp                   */
+} db_comprule_t;
+
+typedef struct db_comppolicy_t {
+    int             nrules;
+    db_comprule_t  *rules;
+} db_comppolicy_t;
+
 struct db_PathnameComponentTag
 {  char                            *name;
    struct db_PathnameComponentTag *prevComponent;
@@ -886,6 +1061,17 @@ INTERNAL char *db_strndup (const char *, int);
 INTERNAL char *db_GetDatatypeString (int);
 INTERNAL int db_GetDatatypeID (char const * const);
 INTERNAL int db_perror (char const *, int, char const *);
+INTERNAL void *db_alloc_bulk (DBfile *, size_t);
+INTERNAL void db_free_bulk (void *);
+INTERNAL void db_FreeNameschemeSpecs (DBnamescheme *);
+#if SILO_THREADSAFE
+INTERNAL void db_api_lock_file (DBfile *);
+INTERNAL void db_api_lock_drivers (int);
+INTERNAL int  db_api_trylock_driver (int);
+INTERNAL void db_api_unlock (void);
+INTERNAL void db_lock_global (void);
+INTERNAL void db_unlock_global (void);
+#endif
 INTERNAL void _DBQQCalcStride (int *, int *, int, int);
 INTERNAL void _DBQMSetStride (DBquadmesh *);
 INTERNAL int _DBstrprint (FILE *, char **, int, int, int, int, int);
@@ -900,6 +1086,31 @@ INTERNAL int CSGM_CalcExtents (int, int, int, const int*,
                                  const void *, double *, double *);
 INTERNAL int _DBQMCalcExtents (DBVCP2_t, int, int const *, int const *, int const *, int,
                                    int, void *, void *);
+INTERNAL db_comppolicy_t *db_CompileCompression (char const *);
+INTERNAL void db_FreeCompression (db_comppolicy_t *);
+INTERNAL db_comppolicy_t const *db_GetCompressionPolicy (DBfile *);
+INTERNAL db_comprule_t const *db_SelectCompression (db_comppolicy_t const *,
+                              int, char const *, int);
+INTERNAL void db_RecordCompression (int, long long, long long, long long,
+                              double);
+INTERNAL double db_WallTime (void);
+INTERNAL double db_stats_begin (DBfile *, int *, char const *);
+INTERNAL void db_stats_end (int, double);
+INTERNAL void db_StatRead (int, long long);
+INTERNAL void db_StatWrite (int, long long);
+INTERNAL void db_StatSeek (void);
+INTERNAL void db_StatCache (int);
+INTERNAL void db_StatCompress (double);
+INTERNAL void db_trace_enter (int *, char const *, DBfile *, char const *);
+INTERNAL void db_trace_exit (void);
+INTERNAL int db_CalcExtentsN (void const * const *, int, int, size_t,
+                              void *, void *);
+INTERNAL void db_PutBlockStats (DBfile *, char const *, int, DBVCP2_t,
+                                long long, int);
+INTERNAL double *db_MakeBlockIndex (DBfile *, int, char const * const *);
+INTERNAL DBoptlist *db_BlockIndexOptlist (DBoptlist const *, double const *,
+                                          double **, int *);
+INTERNAL void db_PutBlockIndex (DBfile *, char const *, double const *);
 INTERNAL int UM_CalcExtents (DBVCP2_t, int, int, int, void *,
                                  void *);
 INTERNAL int _DBSubsetMinMax2 (DBVCP1_t, int, float *, float *, int,
@@ -940,5 +1151,8 @@ INTERNAL const int *db_get_used_file_options_sets_ids();
 
 INTERNAL int db_StringListToStringArrayMBOpt(char *strList, char ***strArray, char **alloc_flag, int nblocks);
 INTERNAL int db_fix_obsolete_centering(int ndims, float const *align, int carfm);
+INTERNAL void db_RunJobs (db_job_func_t, void *, size_t, int);
+INTERNAL db_jobs_t *db_StartJobs (db_job_func_t, void *, size_t, int, int *);
+INTERNAL void db_FinishJobs (db_jobs_t *);
 
 #endif /* !SILO_PRIVATE_H */
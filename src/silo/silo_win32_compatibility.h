@@ -2,12 +2,14 @@
 #ifndef SILO_WIN32_COMPATIBILITY
 #define SILO_WIN32_COMPATIBILITY
 #include <io.h>  /* Include Windows IO */
+#include <process.h>  /* for _getpid */
 #include <errno.h>
 #include <sys\types.h>
 #include <sys\stat.h>
 
 
 #define access    _access
+#define getpid    _getpid
 #define isatty    _isatty
 #define pclose    _pclose
 #define popen     _popen
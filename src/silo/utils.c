@@ -51,383 +51,792 @@ herein do not necessarily state  or reflect those of the United States
 Government or Lawrence Livermore National Security, LLC, and shall not
 be used for advertising or product endorsement purposes.
 */
-
-#include <assert.h>
 #include <limits.h>
 
 #include "silo_private.h"
 
-static double get_frac(int m, int i, int dtype, DBVCP2_t const vfracs)
+/*
+ * Material conversions. Dense per-material volume fraction arrays, the
+ * classic DBmaterial with its mix_next chains and the compressed sparse
+ * row DBmatcsr are converted among one another by kernels typed on the
+ * volume fraction datatypes, each of which handles a contiguous range of
+ * zones. The zones are split into ranges of at least DB_MAT_THREAD_MIN
+ * zones among up to DB_THREADS threads. Ranges are counted, their counts turned into starting entries
+ * and then filled, so no pass ever depends on another range.
+ */
+#define DB_MAT_THREAD_MIN (1<<16)
+
+/* Zones per block of a dense scan. A block of every array stays in cache
+   between counting and copying out its nonzero fractions. */
+#define DB_MAT_BLOCK 512
+
+/* matlist value of a zone without any material */
+#define DB_MAT_NOTSET (-INT_MAX)
+
+PRIVATE
+int compar_ints(void const *ia, void const *ib)
 {
-    assert(dtype==DB_FLOAT || dtype==DB_DOUBLE);
-    if (dtype == DB_FLOAT)
+    if (*((int const *)ia) < *((int const *)ib)) return -1;
+    if (*((int const *)ia) > *((int const *)ib)) return  1;
+    return 0;
+}
+
+/*
+ * Map from material number to its index in a matnos array. Material
+ * numbers which span a small range are looked up in a table, others by a
+ * binary search of (number,index) pairs. Unlike a cached last lookup, the
+ * map is read only once built and so may be shared among threads.
+ */
+typedef struct db_matmap_t {
+    int            lo;          /* smallest material number */
+    int            n;           /* entries in table, or pairs */
+    int           *table;       /* [matno-lo] to index or -1, or NULL */
+    int           *pairs;       /* [2n] (matno,index) sorted on matno */
+} db_matmap_t;
+
+PRIVATE int
+db_matmap_init(db_matmap_t *map, int nmat, int const *matnos)
+{
+    int i, lo = INT_MAX, hi = INT_MIN;
+
+    memset(map, 0, sizeof(*map));
+    if (nmat <= 0)
+        return 0;
+    for (i = 0; i < nmat; i++)
+    {
+        lo = MIN(lo, matnos[i]);
+        hi = MAX(hi, matnos[i]);
+    }
+    map->lo = lo;
+    if ((double) hi - lo < 4.0 * nmat + 64)
     {
-        float const **ffracs = (float const **) vfracs;
-        if (!ffracs[m]) return 0;
-        return ffracs[m][i];
+        map->n = hi - lo + 1;
+        if (NULL == (map->table = ALLOC_N(int, map->n)))
+            return -1;
+        for (i = 0; i < map->n; i++)
+            map->table[i] = -1;
+        for (i = nmat - 1; i >= 0; i--)
+            map->table[matnos[i] - lo] = i;
+        return 0;
     }
-    else if (dtype == DB_DOUBLE)
+    map->n = nmat;
+    if (NULL == (map->pairs = ALLOC_N(int, 2 * nmat)))
+        return -1;
+    for (i = 0; i < nmat; i++)
     {
-        double const **dfracs = (double const **) vfracs;
-        if (!dfracs[m]) return 0;
-        return dfracs[m][i];
+        map->pairs[2*i] = matnos[i];
+        map->pairs[2*i+1] = i;
     }
+    qsort(map->pairs, nmat, 2 * sizeof(int), compar_ints);
     return 0;
 }
 
-static void put_frac(void *mix_vf, int mixlen, int dtype, double vf)
+/* Index of material number MATNO, or -1 if it is not in the map */
+PRIVATE int
+db_matmap_find(db_matmap_t const *map, int matno)
 {
-    assert(mix_vf);
-    assert(dtype==DB_FLOAT || dtype==DB_DOUBLE);
-    assert(0 <= vf && vf <= 1);
-    if (dtype == DB_FLOAT)
+    int bot = 0, top = map->n - 1, mid;
+
+    if (map->table)
     {
-        float *fmix_vf = (float *) mix_vf;
-        fmix_vf[mixlen] = (float) vf;
+        unsigned int i = (unsigned int) matno - (unsigned int) map->lo;
+        return i < (unsigned int) map->n ? map->table[i] : -1;
     }
-    else if (dtype == DB_DOUBLE)
+    while (bot <= top)
     {
-        double *dmix_vf = (double *) mix_vf;
-        dmix_vf[mixlen] = vf;
+        mid = (bot + top) >> 1;
+        if (matno > map->pairs[2*mid])
+            bot = mid + 1;
+        else if (matno < map->pairs[2*mid])
+            top = mid - 1;
+        else
+            return map->pairs[2*mid+1];
     }
+    return -1;
 }
 
-static
-DBmaterial *db_CalcMaterialFromDenseArrays(int narrs, int ndims, int const *dims,
-    int const *matnos, int dtype, DBVCP2_t const vfracs)
+PRIVATE void
+db_matmap_free(db_matmap_t *map)
 {
-    const int notSet = -INT_MAX;
-    int i,m,z,nzones = 1;
-    int *matlist = 0, mixlen = 0, *mix_mat = 0;
-    int *mix_zone = 0, *mix_next = 0;
-    int *matnos_copy = 0;
-    void *mix_vf = 0;
-    DBmaterial *mat = 0;
-
-    /* copy matnos (we'll need it for returned material object anyways) */
-    matnos_copy = (int *) malloc(narrs * sizeof(int));
-    if (!matnos_copy) goto cleanup;
-    memcpy(matnos_copy, matnos, narrs * sizeof(int));
-
-    /* compute number of zones (and array length) */
-    for (i = 0; i < ndims; i++)
-        nzones *= dims[i];
-
-    /* allocate and fill matlist array with the 'notSet' value */
-    matlist = (int *) malloc(nzones * sizeof(int)); 
-    if (!matlist) goto cleanup;
-
-    for (i = 0; i < nzones; i++)
-        matlist[i] = notSet;
+    FREE(map->table);
+    FREE(map->pairs);
+}
 
-    /* pre-compute size of mix arrays */
-    for (m = 0; m < narrs; m++)
-    {
-        for (z = 0; z < nzones; z++)
-        {
-            double vf = get_frac(m, z, dtype, vfracs);
-            if (0 < vf && vf < 1)
-                mixlen++;
-        }
-    }
+/* Arguments shared by all the jobs of one conversion */
+typedef struct db_matconv_t {
+    int            narrs;       /* number of dense arrays */
+    int const     *matnos;      /* [narrs] material numbers of the arrays */
+    void const * const *dense;  /* [narrs] dense input; NULL arrays are 0 */
+    void         **odense;      /* [nmat] dense output */
+    DBmaterial const *mat;      /* classic input */
+    DBmatcsr const *csr;        /* CSR input */
+    DBmaterial    *omat;        /* classic output */
+    DBmatcsr      *ocsr;        /* CSR output */
+    db_matmap_t    map;         /* material number to dense array index */
+} db_matconv_t;
+
+/* One range of zones of a conversion */
+typedef struct db_matjob_t {
+    void         (*func)(struct db_matjob_t *);
+    db_matconv_t  *conv;
+    int            zbeg, zend;  /* zones [zbeg,zend) of this job */
+    int            base;        /* first entry this job fills */
+    int            count;       /* entries this job counted */
+    int            err;         /* E_XXX if the job failed */
+    int            cap;         /* capacity of mats and vfracs */
+    int           *mats;        /* entries found by a dense scan */
+    void          *vfracs;
+} db_matjob_t;
+
+SILO_CALLBACK void
+db_mat_job(void *arg)
+{
+    db_matjob_t *job = (db_matjob_t *) arg;
+    job->func(job);
+}
 
-    /* allocate mix arrays */
-    mix_vf   = malloc(mixlen * (dtype==DB_FLOAT?sizeof(float):sizeof(double))); 
-    if (!mix_vf) goto cleanup;
-    mix_mat  = (int *) malloc(mixlen * sizeof(int));
-    if (!mix_mat) goto cleanup;
-    mix_zone = (int *) malloc(mixlen * sizeof(int));
-    if (!mix_zone) goto cleanup;
-    mix_next = (int *) malloc(mixlen * sizeof(int));
-    if (!mix_next) goto cleanup;
-
-    /* Loop over zones, then materials to ensure this operation
-       will faithfully invert the companion operation. */
-    mixlen = 0;
-    for (z = 0; z < nzones; z++)
+/* Split NZONES zones into jobs for CONV */
+PRIVATE db_matjob_t *
+db_mat_jobs(db_matconv_t *conv, int nzones, int *njobs)
+{
+    int            j, n = 1;
+    db_matjob_t   *jobs;
+
+    if (DB_THREADS > 1)
+        n = MAX(1, MIN(DB_THREADS, nzones / DB_MAT_THREAD_MIN));
+    if (NULL == (jobs = ALLOC_N(db_matjob_t, n)))
+        return 0;
+    for (j = 0; j < n; j++)
     {
-        int nmixing = 0;
-        for (m = 0; m < narrs; m++)
-        {
-            double vf = get_frac(m, z, dtype, vfracs);
-
-            if (vf >= 1.0)
-            {
-                assert(matlist[z] == notSet);
-                matlist[z] = matnos[m];
-            }
-            else if (vf > 0.0)
-            {
-                nmixing++;
-                if (matlist[z] == notSet)
-                {
-                    /* put the first entry in the list for this zone */
-                    matlist[z] = -(mixlen+1); 
-                    mix_mat [mixlen] = matnos[m];
-                    put_frac(mix_vf, mixlen, dtype, vf);
-                    mix_zone[mixlen] = z+1; /* one origin */
-                    mix_next[mixlen] = 0;
-                }
-                else if (matlist[z] < 0)
-                {
-                    /* walk forward through the list for this zone */
-                    int j = -(matlist[z]+1);
-                    while (mix_next[j]!=0)
-                        j = mix_next[j]-1;
-
-                    /* link up last entry in list with the new entry */
-                    mix_next[j] = mixlen+1;
-
-                    /* put in the new entry */
-                    mix_mat [mixlen] = matnos[m];
-                    put_frac(mix_vf, mixlen, dtype, vf);
-                    mix_zone[mixlen] = z+1; /* one origin */
-                    mix_next[mixlen] = 0;
-                }
-                else
-                {
-                    /* We've encountered a zone with a frac>=1 *AND* another
-                       frac > 0. We ignore the frac>0 since we already have
-                       marked the zone clean for the frac>=1. We effectively
-                       put a placeholder entry into the mix arrays here. */
-                    mix_mat [mixlen] = matnos[m];
-                    put_frac(mix_vf, mixlen, dtype, vf);
-                    mix_zone[mixlen] = z+1; /* one origin */
-                    mix_next[mixlen] = 0;
-                }
-                mixlen++;
-            }
-        }
-        assert(nmixing==0 || nmixing>=2);
+        jobs[j].conv = conv;
+        jobs[j].zbeg = (int) ((long long) nzones * j / n);
+        jobs[j].zend = (int) ((long long) nzones * (j + 1) / n);
     }
+    *njobs = n;
+    return jobs;
+}
 
-    /* create material object to return */
-    mat = DBAllocMaterial();
-    mat->origin = 0;
-    mat->ndims = ndims;
-    for (i = 0; i < ndims; i++)
-        mat->dims[i] = dims[i];
-    mat->nmat = narrs;
-    mat->matnos = matnos_copy;
-    mat->matlist = matlist;
-    mat->datatype = dtype;
-    mat->mix_vf = mix_vf;
-    mat->mix_next = mix_next;
-    mat->mix_mat = mix_mat;
-    mat->mix_zone = mix_zone;
-    mat->mixlen = mixlen;
-
-    return(mat);
-
-cleanup:
+/* Run FUNC on every job, all but the first on their own threads.
+   Returns the first job's error, if any. */
+PRIVATE int
+db_mat_run(db_matjob_t *jobs, int njobs, void (*func)(db_matjob_t *))
+{
+    int            j;
+
+    for (j = 0; j < njobs; j++)
+        jobs[j].func = func;
+    db_RunJobs(db_mat_job, jobs, sizeof(*jobs), njobs);
+    for (j = 0; j < njobs; j++)
+        if (jobs[j].err)
+            return jobs[j].err;
+    return 0;
+}
 
-    FREE(matnos_copy);
-    FREE(matlist); 
-    FREE(mix_vf);
-    FREE(mix_mat);
-    FREE(mix_zone);
-    FREE(mix_next);
+/* Give each job the first entry it fills and, if OFFSETS is not NULL,
+   shift the job relative offsets[zbeg+1..zend] it counted by that entry.
+   Returns the total count. */
+PRIVATE int
+db_mat_bases(db_matjob_t *jobs, int njobs, int *offsets)
+{
+    int            j, z, total = 0;
 
-    return 0;
+    for (j = 0; j < njobs; j++)
+    {
+        jobs[j].base = total;
+        if (offsets && total)
+            for (z = jobs[j].zbeg; z < jobs[j].zend; z++)
+                offsets[z+1] += total;
+        total += jobs[j].count;
+    }
+    return total;
 }
 
-PUBLIC
-DBmaterial *DBCalcMaterialFromDenseArrays(int narrs, int ndims, int const *dims,
-    int const *matnos, int dtype, DBVCP2_t const vfracs)
+PRIVATE void
+db_mat_free_jobs(db_matjob_t *jobs, int njobs)
 {
-    DBmaterial *retval = 0;
+    int            j;
 
-    API_BEGIN("DBCalcMaterialFromDenseArrays", DBmaterial*, 0) {
-        if (narrs<=0)
-            API_ERROR("narrs<=0", E_BADARGS);
-        if (ndims<=0)
-            API_ERROR("ndims<=0", E_BADARGS);
-        if (!dims)
-            API_ERROR("dims==0", E_BADARGS);
-        if (!matnos)
-            API_ERROR("matnos==0", E_BADARGS);
-        if (!vfracs)
-            API_ERROR("vfracs==0", E_BADARGS);
-        retval = db_CalcMaterialFromDenseArrays(narrs, ndims, dims, matnos, dtype, vfracs);
-        API_RETURN(retval);
+    for (j = 0; jobs && j < njobs; j++)
+    {
+        FREE(jobs[j].mats);
+        FREE(jobs[j].vfracs);
     }
-    API_END_NOPOP;
+    FREE(jobs);
 }
 
-PRIVATE
-int compar_ints(void const *ia, void const *ib)
+/* Make room for N entries of SIZE byte fractions in a dense scan job
+   which has scanned up to zone ZDONE. The room is grown to what the
+   whole range will need at the rate seen so far, and by half at least. */
+PRIVATE int
+db_matjob_reserve(db_matjob_t *job, int n, size_t size, int zdone)
 {
-    if (*((int const *)ia) < *((int const *)ib)) return -1;
-    if (*((int const *)ia) > *((int const *)ib)) return  1;
+    double         want;
+    int            cap;
+    int           *mats;
+    void          *vfracs;
+
+    if (n <= job->cap)
+        return 0;
+    want = (double) n * (job->zend - job->zbeg) / MAX(zdone - job->zbeg, 1);
+    cap = (int) MIN(want + want / 16 + 1024, (double) INT_MAX);
+    cap = MAX(cap, MIN(job->cap + job->cap / 2, INT_MAX - INT_MAX / 3));
+    cap = MAX(cap, n);
+    if (NULL == (mats = (int *) realloc(job->mats, (size_t) cap * sizeof(int))))
+        return -1;
+    job->mats = mats;
+    if (NULL == (vfracs = realloc(job->vfracs, (size_t) cap * size)))
+        return -1;
+    job->vfracs = vfracs;
+    job->cap = cap;
     return 0;
 }
 
-/* Binary search for a given material number in the sorted
-   list of material numbers. */
-PRIVATE
-int mat_index(int nmat_nums, int const *mat_nums, int mat_num)
+/*
+ * Dense scan: the positive fractions of each block of zones are counted
+ * over all the arrays, which sets the job relative offsets of the block,
+ * and then copied out in array order while the block is still in cache.
+ */
+#define DB_MAT_DENSE_SCAN(NAME, TYPE)                                       \
+PRIVATE void                                                                \
+NAME(db_matjob_t *job)                                                      \
+{                                                                           \
+    db_matconv_t const *c = job->conv;                                      \
+    TYPE const * const *arrs = (TYPE const * const *) c->dense;             \
+    int           *offsets = c->ocsr->offsets;                              \
+    int            cnt[DB_MAT_BLOCK];                                       \
+    int            z0, b, m, nb, k, n;                                      \
+                                                                            \
+    for (z0 = job->zbeg; z0 < job->zend; z0 += DB_MAT_BLOCK)               \
+    {                                                                       \
+        nb = MIN(DB_MAT_BLOCK, job->zend - z0);                             \
+        for (b = 0; b < nb; b++)                                            \
+            cnt[b] = 0;                                                     \
+        for (m = 0; m < c->narrs; m++)                                      \
+        {                                                                   \
+            TYPE const *v = arrs[m];                                        \
+            if (!v) continue;                                               \
+            v += z0;                                                        \
+            for (b = 0; b < nb; b++)                                        \
+                cnt[b] += v[b] > 0;                                         \
+        }                                                                   \
+        for (b = 0, k = job->count; b < nb; b++)                            \
+        {                                                                   \
+            n = cnt[b];                                                     \
+            cnt[b] = k;                                                     \
+            k += n;                                                         \
+            offsets[z0+b+1] = k;                                            \
+        }                                                                   \
+        if (db_matjob_reserve(job, k + 1, sizeof(TYPE), z0 + nb) < 0)        \
+        {                                                                   \
+            job->err = E_NOMEM;                                             \
+            return;                                                         \
+        }                                                                   \
+        for (m = 0; m < c->narrs; m++)                                      \
+        {                                                                   \
+            TYPE const *v = arrs[m];                                        \
+            TYPE *vfracs = (TYPE *) job->vfracs;                            \
+            int matno = c->matnos[m];                                       \
+            if (!v) continue;                                               \
+            v += z0;                                                        \
+            for (b = 0; b < nb; b++)                                        \
+            {                                                               \
+                /* zero fractions go to the spare entry k, not a branch */  \
+                n = v[b] > 0 ? cnt[b] : k;                                  \
+                job->mats[n] = matno;                                       \
+                vfracs[n] = v[b];                                           \
+                cnt[b] += v[b] > 0;                                         \
+            }                                                               \
+        }                                                                   \
+        job->count = k;                                                     \
+    }                                                                       \
+}
+
+DB_MAT_DENSE_SCAN(db_mat_dense_scan_f, float)
+DB_MAT_DENSE_SCAN(db_mat_dense_scan_d, double)
+
+/* Copy a dense scan job's entries to their place in the output */
+PRIVATE void
+db_mat_dense_gather(db_matjob_t *job)
 {
-    int bot = 0;
-    int top = nmat_nums - 1;
-    int mid;
-    static int last_mat_num = -1;
-    static int last_mat_idx = 0;
+    DBmatcsr      *csr = job->conv->ocsr;
+    size_t         size = csr->datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+
+    if (job->count == 0)
+        return;
+    memcpy(csr->mats + job->base, job->mats, (size_t) job->count * sizeof(int));
+    memcpy((char *) csr->vfracs + job->base * size, job->vfracs,
+        (size_t) job->count * size);
+}
 
-    /* quick acclerator (see below for reset logic) */
-    if (mat_num == last_mat_num)
-        return last_mat_idx;
+/*
+ * Scatter of a CSR or classic material into dense arrays, which start
+ * out zeroed. Entries whose material number is not in the map are
+ * dropped.
+ */
+#define DB_MAT_SCATTER(NAME, STYPE, DTYPE)                                  \
+PRIVATE void                                                                \
+NAME(db_matjob_t *job)                                                      \
+{                                                                           \
+    db_matconv_t const *c = job->conv;                                      \
+    DTYPE        **out = (DTYPE **) c->odense;                              \
+    int            z, k, n, idx;                                            \
+                                                                            \
+    if (c->csr)                                                             \
+    {                                                                       \
+        STYPE const *vf = (STYPE const *) c->csr->vfracs;                   \
+        int const *offsets = c->csr->offsets, *mats = c->csr->mats;         \
+        for (z = job->zbeg; z < job->zend; z++)                             \
+            for (k = offsets[z]; k < offsets[z+1]; k++)                     \
+                if ((idx = db_matmap_find(&c->map, mats[k])) >= 0)          \
+                    out[idx][z] = (DTYPE) vf[k];                            \
+    }                                                                       \
+    else                                                                    \
+    {                                                                       \
+        DBmaterial const *mat = c->mat;                                     \
+        STYPE const *vf = (STYPE const *) mat->mix_vf;                      \
+        for (z = job->zbeg; z < job->zend; z++)                             \
+        {                                                                   \
+            if (mat->matlist[z] >= 0)                                       \
+            {                                                               \
+                if ((idx = db_matmap_find(&c->map, mat->matlist[z])) >= 0)  \
+                    out[idx][z] = 1;                                        \
+                continue;                                                   \
+            }                                                               \
+            for (k = -(mat->matlist[z]+1), n = 0;                           \
+                 k < mat->mixlen && n < mat->mixlen;                        \
+                 k = mat->mix_next[k] - 1, n++)                             \
+            {                                                               \
+                if (k < 0) break;                                           \
+                if ((idx = db_matmap_find(&c->map, mat->mix_mat[k])) >= 0)  \
+                    out[idx][z] = (DTYPE) vf[k];                            \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+}
 
-    while (bot <= top)
-    {
-        mid = (bot + top) >> 1;
+DB_MAT_SCATTER(db_mat_scatter_ff, float, float)
+DB_MAT_SCATTER(db_mat_scatter_fd, float, double)
+DB_MAT_SCATTER(db_mat_scatter_df, double, float)
+DB_MAT_SCATTER(db_mat_scatter_dd, double, double)
 
-        if (mat_num > mat_nums[mid])
-            bot = mid + 1;
-        else if (mat_num < mat_nums[mid])
-            top = mid - 1;
+/* Count the entries of each zone of a classic material */
+PRIVATE void
+db_mat_chain_count(db_matjob_t *job)
+{
+    DBmaterial const *mat = job->conv->mat;
+    int           *offsets = job->conv->ocsr->offsets;
+    int            z, k, n, count = 0;
+
+    for (z = job->zbeg; z < job->zend; z++)
+    {
+        if (mat->matlist[z] >= 0)
+            count++;
         else
         {
-            last_mat_num = mat_num;
-            last_mat_idx = mid;
-            return mid;
+            for (k = -(mat->matlist[z]+1), n = 0;
+                 k >= 0 && k < mat->mixlen && n < mat->mixlen;
+                 k = mat->mix_next[k] - 1, n++)
+                count++;
         }
+        offsets[z+1] = count;
     }
+    job->count = count;
+}
 
-    /* Any real inputs should never get here. But,
-       an input to force reset of last num/idx will.
-       We want this logic here instead of at top to
-       avoid having to test whether to execut it *every*
-       lookup. A call of mat_index(0,0,-1) is sufficient
-       to cause this reset code to execute. */
-    assert(nmat_nums==0 && mat_nums==0 && mat_num==-1);
-    last_mat_num = -1;
-    last_mat_idx = 0;
-    return -1;
+/* Fill the CSR entries of each zone of a classic material */
+#define DB_MAT_CHAIN_FILL(NAME, TYPE)                                       \
+PRIVATE void                                                                \
+NAME(db_matjob_t *job)                                                      \
+{                                                                           \
+    DBmaterial const *mat = job->conv->mat;                                 \
+    DBmatcsr      *csr = job->conv->ocsr;                                   \
+    TYPE const    *mix_vf = (TYPE const *) mat->mix_vf;                     \
+    TYPE          *vfracs = (TYPE *) csr->vfracs;                           \
+    int            z, k, n, e;                                              \
+                                                                            \
+    for (z = job->zbeg; z < job->zend; z++)                                 \
+    {                                                                       \
+        e = csr->offsets[z];                                                \
+        if (mat->matlist[z] >= 0)                                           \
+        {                                                                   \
+            csr->mats[e] = mat->matlist[z];                                 \
+            vfracs[e] = 1;                                                  \
+            continue;                                                       \
+        }                                                                   \
+        for (k = -(mat->matlist[z]+1), n = 0;                               \
+             k >= 0 && k < mat->mixlen && n < mat->mixlen;                  \
+             k = mat->mix_next[k] - 1, n++, e++)                            \
+        {                                                                   \
+            csr->mats[e] = mat->mix_mat[k];                                 \
+            vfracs[e] = mix_vf[k];                                          \
+        }                                                                   \
+    }                                                                       \
 }
 
+DB_MAT_CHAIN_FILL(db_mat_chain_fill_f, float)
+DB_MAT_CHAIN_FILL(db_mat_chain_fill_d, double)
+
+/* Count the mixed entries, those with fractions in (0,1), of a CSR */
+#define DB_MAT_CSR_COUNT(NAME, TYPE)                                        \
+PRIVATE void                                                                \
+NAME(db_matjob_t *job)                                                      \
+{                                                                           \
+    DBmatcsr const *csr = job->conv->csr;                                   \
+    TYPE const    *vf = (TYPE const *) csr->vfracs;                         \
+    int            k, count = 0;                                            \
+                                                                            \
+    for (k = csr->offsets[job->zbeg]; k < csr->offsets[job->zend]; k++)     \
+        count += 0 < vf[k] && vf[k] < 1;                                    \
+    job->count = count;                                                     \
+}
 
-PRIVATE
-int db_CalcDenseArraysFromMaterial(DBmaterial const *mat, int datatype, int *narrs, void ***vfracs)
+DB_MAT_CSR_COUNT(db_mat_csr_count_f, float)
+DB_MAT_CSR_COUNT(db_mat_csr_count_d, double)
+
+/*
+ * Fill the matlist and mix arrays of each zone of a CSR. A zone with a
+ * fraction of 1 or more is clean with the first such material. Its
+ * mixed entries are kept as placeholders which no zone links to, as
+ * DBCalcMaterialFromDenseArrays has always done.
+ */
+#define DB_MAT_CSR_FILL(NAME, TYPE)                                         \
+PRIVATE void                                                                \
+NAME(db_matjob_t *job)                                                      \
+{                                                                           \
+    DBmatcsr const *csr = job->conv->csr;                                   \
+    DBmaterial    *mat = job->conv->omat;                                   \
+    TYPE const    *vf = (TYPE const *) csr->vfracs;                         \
+    TYPE          *mix_vf = (TYPE *) mat->mix_vf;                           \
+    int            z, k, first, clean, mix = job->base;                     \
+                                                                            \
+    for (z = job->zbeg; z < job->zend; z++)                                 \
+    {                                                                       \
+        first = mix;                                                        \
+        clean = 0;                                                          \
+        mat->matlist[z] = DB_MAT_NOTSET;                                    \
+        for (k = csr->offsets[z]; k < csr->offsets[z+1]; k++)               \
+        {                                                                   \
+            if (vf[k] >= 1)                                                 \
+            {                                                               \
+                if (!clean)                                                 \
+                    mat->matlist[z] = csr->mats[k];                         \
+                clean = 1;                                                  \
+            }                                                               \
+            else if (vf[k] > 0)                                             \
+            {                                                               \
+                mat->mix_mat[mix] = csr->mats[k];                           \
+                mix_vf[mix] = vf[k];                                        \
+                mat->mix_zone[mix] = z+1; /* one origin */                  \
+                mat->mix_next[mix] = mix+2; /* one origin */              \
+                mix++;                                                      \
+            }                                                               \
+        }                                                                   \
+        if (mix == first)                                                   \
+            continue;                                                       \
+        mat->mix_next[mix-1] = 0;                                           \
+        if (clean)                                                          \
+            for (k = first; k < mix; k++)                                   \
+                mat->mix_next[k] = 0;                                       \
+        else                                                                \
+            mat->matlist[z] = -(first+1);                                   \
+    }                                                                       \
+}
+
+DB_MAT_CSR_FILL(db_mat_csr_fill_f, float)
+DB_MAT_CSR_FILL(db_mat_csr_fill_d, double)
+
+PRIVATE int
+db_mat_nzones(int ndims, int const *dims)
 {
-    static char const *me = "db_CalcDenseArraysFromMaterial";
-    int i;
-    int nzones = 1;
-    int etag = E_NOMEM;
-    int typesz = (int) sizeof(float);
-    int *matnos_sorted=0;
-    void **matarrs=0, **matarrs_fixed=0;
-    float *pflt;
-    double *pdbl;
-#ifndef NDEBUG
-    float *check_fracs;
-#endif
-
-    if (datatype == DB_DOUBLE)
-        typesz = (int) sizeof(double);
-
-    matarrs = (void **) calloc(mat->nmat,sizeof(void *));
-    if (!matarrs) goto cleanup;
-    matarrs_fixed = (void **) calloc(mat->nmat,sizeof(void *));
-    if (!matarrs_fixed) goto cleanup;
-
-    for (i = 0; i < mat->ndims; i++)
-        nzones *= mat->dims[i];
+    int i, nzones = 1;
 
-    /* use calloc so vfrac arrays are initialized with zeros */
-    for (i = 0; i < mat->nmat; i++)
+    for (i = 0; i < ndims; i++)
+        nzones *= dims[i];
+    return nzones;
+}
+
+/* Allocate a CSR material of NZONES zones and copy in its matnos */
+PRIVATE DBmatcsr *
+db_mat_new_csr(int ndims, int const *dims, int nmat, int const *matnos,
+    int datatype)
+{
+    DBmatcsr      *csr;
+    int            i;
+
+    if (NULL == (csr = DBAllocMatcsr()))
+        return 0;
+    csr->ndims = ndims;
+    for (i = 0; i < ndims && i < 3; i++)
+        csr->dims[i] = dims[i];
+    csr->nzones = db_mat_nzones(ndims, dims);
+    csr->nmat = nmat;
+    csr->datatype = datatype;
+    csr->matnos = ALLOC_N(int, nmat);
+    csr->offsets = ALLOC_N(int, csr->nzones + 1);
+    if (!csr->matnos || !csr->offsets)
     {
-        matarrs[i] = (void *) calloc(nzones, typesz);
-        if (!matarrs[i]) goto cleanup;
+        DBFreeMatcsr(csr);
+        return 0;
     }
-#ifndef NDEBUG
-    check_fracs = (float *) calloc(nzones, sizeof(float));
-#endif
+    memcpy(csr->matnos, matnos, nmat * sizeof(int));
+    return csr;
+}
 
-    /* make a copy of matnos and sort it for binary search */
-    matnos_sorted = (int *) malloc(mat->nmat * sizeof(int));
-    memcpy(matnos_sorted, mat->matnos, mat->nmat * sizeof(int));
-    qsort(matnos_sorted, mat->nmat, sizeof(int), compar_ints);
+PRIVATE
+DBmatcsr *db_CalcMatcsrFromDenseArrays(int narrs, int ndims, int const *dims,
+    int const *matnos, int dtype, DBVCP2_t const vfracs)
+{
+    static char const *me = "db_CalcMatcsrFromDenseArrays";
+    size_t         size = dtype == DB_FLOAT ? sizeof(float) : sizeof(double);
+    int            etag = E_NOMEM;
+    int            njobs = 0, nnz;
+    db_matconv_t   conv;
+    db_matjob_t   *jobs = 0;
+    DBmatcsr      *csr;
+
+    if (NULL == (csr = db_mat_new_csr(ndims, dims, narrs, matnos, dtype)))
+        goto cleanup;
+    memset(&conv, 0, sizeof(conv));
+    conv.narrs = narrs;
+    conv.matnos = matnos;
+    conv.dense = (void const * const *) vfracs;
+    conv.ocsr = csr;
+    if (NULL == (jobs = db_mat_jobs(&conv, csr->nzones, &njobs)))
+        goto cleanup;
+    if ((etag = db_mat_run(jobs, njobs, dtype == DB_FLOAT ?
+            db_mat_dense_scan_f : db_mat_dense_scan_d)) != 0)
+        goto cleanup;
+    nnz = db_mat_bases(jobs, njobs, csr->offsets);
+
+    /* A single job's entries are already in order; take them over */
+    etag = E_NOMEM;
+    if (njobs == 1 && jobs[0].mats)
+    {
+        csr->mats = jobs[0].mats;
+        csr->vfracs = jobs[0].vfracs;
+        jobs[0].mats = 0;
+        jobs[0].vfracs = 0;
+    }
+    else if (nnz > 0)
+    {
+        csr->mats = ALLOC_N(int, nnz);
+        csr->vfracs = malloc((size_t) nnz * size);
+        if (!csr->mats || !csr->vfracs)
+            goto cleanup;
+        db_mat_run(jobs, njobs, db_mat_dense_gather);
+    }
+    db_mat_free_jobs(jobs, njobs);
+    return csr;
 
-    /* reset binary searcher last num/idx state */
-    mat_index(0,0,-1);
+cleanup:
 
-    for (i = 0; i < nzones; i++)
+    db_mat_free_jobs(jobs, njobs);
+    DBFreeMatcsr(csr);
+    db_perror(NULL, etag, me);
+    return 0;
+}
+
+PRIVATE
+DBmatcsr *db_CalcMatcsrFromMaterial(DBmaterial const *mat)
+{
+    static char const *me = "db_CalcMatcsrFromMaterial";
+    size_t         size = mat->datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+    int            njobs = 0, nnz;
+    db_matconv_t   conv;
+    db_matjob_t   *jobs = 0;
+    DBmatcsr      *csr;
+
+    if (NULL == (csr = db_mat_new_csr(mat->ndims, mat->dims, mat->nmat,
+                                      mat->matnos, mat->datatype)))
+        goto cleanup;
+    memset(&conv, 0, sizeof(conv));
+    conv.mat = mat;
+    conv.ocsr = csr;
+    if (NULL == (jobs = db_mat_jobs(&conv, csr->nzones, &njobs)))
+        goto cleanup;
+    db_mat_run(jobs, njobs, db_mat_chain_count);
+    nnz = db_mat_bases(jobs, njobs, csr->offsets);
+    if (nnz > 0)
     {
-        if (mat->matlist[i] >= 0) /* clean case */
-        {
-            int idx = mat_index(mat->nmat, matnos_sorted, mat->matlist[i]);
-            switch (datatype)
-            {
-                case DB_FLOAT: ((float*)(matarrs[idx]))[i] = 1.0; break;
-                case DB_DOUBLE: ((double*)(matarrs[idx]))[i] = 1.0; break;
-            }
-#ifndef NDEBUG
-            check_fracs[i] += 1.0;
-#endif
-        }
-        else /* mixing case */
-        {
-            int mix_idx = -mat->matlist[i] - 1;
-            while(mix_idx >= 0)
-            {
-                int matno = mat->mix_mat[mix_idx];
-                int idx = mat_index(mat->nmat, matnos_sorted, matno);
-                switch (datatype)
-                {
-                    case DB_FLOAT:
-                        ((float*)matarrs[idx])[i] = ((float*)mat->mix_vf)[mix_idx];
-#ifndef NDEBUG
-                        check_fracs[i] += ((float*)matarrs[idx])[i];
-#endif
-                        break;
-                    case DB_DOUBLE:
-                        ((double*)matarrs[idx])[i] = ((double*)mat->mix_vf)[mix_idx];
-#ifndef NDEBUG
-                        check_fracs[i] += ((double*)matarrs[idx])[i];
-#endif
-                        break;
-                }
-                mix_idx = mat->mix_next[mix_idx] - 1;
-            }
-        }
+        csr->mats = ALLOC_N(int, nnz);
+        csr->vfracs = malloc((size_t) nnz * size);
+        if (!csr->mats || !csr->vfracs)
+            goto cleanup;
+        db_mat_run(jobs, njobs, mat->datatype == DB_FLOAT ?
+            db_mat_chain_fill_f : db_mat_chain_fill_d);
     }
+    db_mat_free_jobs(jobs, njobs);
+    return csr;
 
-#ifndef NDEBUG
-    /* sanity check */
-    for (i = 0; i < nzones; i++)
-        assert(0.999 <= check_fracs[i] && check_fracs[i] < 1.001);
-    free(check_fracs);
-#endif
+cleanup:
 
-    /* The matarr arrays are in the wrong order because
-       we pre-sorted matnos. We need to undue that now. */
-    mat_index(0,0,-1);
-    for (i = 0; i < mat->nmat; i++)
-        matarrs_fixed[i] = matarrs[mat_index(mat->nmat, matnos_sorted, mat->matnos[i])];
+    db_mat_free_jobs(jobs, njobs);
+    DBFreeMatcsr(csr);
+    db_perror(NULL, E_NOMEM, me);
+    return 0;
+}
 
-    free(matarrs);
-    free(matnos_sorted);
+PRIVATE
+DBmaterial *db_CalcMaterialFromMatcsr(DBmatcsr const *csr)
+{
+    static char const *me = "db_CalcMaterialFromMatcsr";
+    size_t         size = csr->datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+    int            i, njobs = 0, mixlen;
+    db_matconv_t   conv;
+    db_matjob_t   *jobs = 0;
+    DBmaterial    *mat;
+
+    if (NULL == (mat = DBAllocMaterial()))
+        goto cleanup;
+    mat->origin = 0;
+    mat->ndims = csr->ndims;
+    for (i = 0; i < csr->ndims && i < 3; i++)
+        mat->dims[i] = csr->dims[i];
+    mat->nmat = csr->nmat;
+    mat->datatype = csr->datatype;
+    mat->matnos = ALLOC_N(int, csr->nmat);
+    mat->matlist = ALLOC_N(int, csr->nzones);
+    if (!mat->matnos || (csr->nzones > 0 && !mat->matlist))
+        goto cleanup;
+    memcpy(mat->matnos, csr->matnos, csr->nmat * sizeof(int));
+
+    memset(&conv, 0, sizeof(conv));
+    conv.csr = csr;
+    conv.omat = mat;
+    if (NULL == (jobs = db_mat_jobs(&conv, csr->nzones, &njobs)))
+        goto cleanup;
+    db_mat_run(jobs, njobs, csr->datatype == DB_FLOAT ?
+        db_mat_csr_count_f : db_mat_csr_count_d);
+    mixlen = db_mat_bases(jobs, njobs, 0);
+    if (mixlen > 0)
+    {
+        mat->mix_vf = malloc((size_t) mixlen * size);
+        mat->mix_mat = ALLOC_N(int, mixlen);
+        mat->mix_zone = ALLOC_N(int, mixlen);
+        mat->mix_next = ALLOC_N(int, mixlen);
+        if (!mat->mix_vf || !mat->mix_mat || !mat->mix_zone || !mat->mix_next)
+            goto cleanup;
+    }
+    mat->mixlen = mixlen;
+    db_mat_run(jobs, njobs, csr->datatype == DB_FLOAT ?
+        db_mat_csr_fill_f : db_mat_csr_fill_d);
+    db_mat_free_jobs(jobs, njobs);
+    return mat;
+
+cleanup:
+
+    db_mat_free_jobs(jobs, njobs);
+    DBFreeMaterial(mat);
+    db_perror(NULL, E_NOMEM, me);
+    return 0;
+}
 
-    *narrs = mat->nmat;
-    *vfracs = matarrs_fixed; 
+/*
+ * Scatter the CSR or classic material of CONV, whose fractions are of
+ * SDTYPE, into NMAT dense arrays of DATATYPE in the order of MATNOS.
+ */
+PRIVATE int
+db_mat_dense_arrays(db_matconv_t *conv, int nzones, int nmat,
+    int const *matnos, int sdtype, int datatype, int *narrs, void ***vfracs)
+{
+    static char const *me = "db_mat_dense_arrays";
+    size_t         typesz = datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+    int            i, njobs = 0;
+    void         **arrs;
+    db_matjob_t   *jobs = 0;
+    void         (*func)(db_matjob_t *);
+
+    if (sdtype == DB_FLOAT)
+        func = datatype == DB_FLOAT ? db_mat_scatter_ff : db_mat_scatter_fd;
+    else
+        func = datatype == DB_FLOAT ? db_mat_scatter_df : db_mat_scatter_dd;
 
+    /* use calloc so vfrac arrays are initialized with zeros */
+    if (NULL == (arrs = ALLOC_N(void *, nmat)))
+        goto cleanup;
+    for (i = 0; i < nmat; i++)
+        if (NULL == (arrs[i] = calloc(MAX(nzones, 1), typesz)))
+            goto cleanup;
+    conv->odense = arrs;
+    if (db_matmap_init(&conv->map, nmat, matnos) < 0)
+        goto cleanup;
+    if (NULL == (jobs = db_mat_jobs(conv, nzones, &njobs)))
+        goto cleanup;
+    db_mat_run(jobs, njobs, func);
+    db_mat_free_jobs(jobs, njobs);
+    db_matmap_free(&conv->map);
+
+    *narrs = nmat;
+    *vfracs = arrs;
     return 0;
 
 cleanup:
 
-    if (matarrs)
+    if (arrs)
     {
-        for (i = 0; i < mat->nmat; i++)
-            FREE(matarrs[i]);
-        FREE(matarrs);
+        for (i = 0; i < nmat; i++)
+            FREE(arrs[i]);
+        FREE(arrs);
     }
-    FREE(matarrs_fixed);
-    FREE(matnos_sorted);
-    db_perror(NULL, etag, me);
-
+    db_mat_free_jobs(jobs, njobs);
+    db_matmap_free(&conv->map);
+    db_perror(NULL, E_NOMEM, me);
     return -1;
 }
 
+PRIVATE
+int db_CalcDenseArraysFromMaterial(DBmaterial const *mat, int datatype, int *narrs, void ***vfracs)
+{
+    db_matconv_t   conv;
+
+    memset(&conv, 0, sizeof(conv));
+    conv.mat = mat;
+    return db_mat_dense_arrays(&conv, db_mat_nzones(mat->ndims, mat->dims),
+        mat->nmat, mat->matnos, mat->datatype, datatype, narrs, vfracs);
+}
+
+PRIVATE
+int db_CalcDenseArraysFromMatcsr(DBmatcsr const *csr, int datatype, int *narrs, void ***vfracs)
+{
+    db_matconv_t   conv;
+
+    memset(&conv, 0, sizeof(conv));
+    conv.csr = csr;
+    return db_mat_dense_arrays(&conv, csr->nzones, csr->nmat, csr->matnos,
+        csr->datatype, datatype, narrs, vfracs);
+}
+
+PUBLIC
+DBmaterial *DBCalcMaterialFromDenseArrays(int narrs, int ndims, int const *dims,
+    int const *matnos, int dtype, DBVCP2_t const vfracs)
+{
+    DBmaterial *retval = 0;
+    DBmatcsr *csr;
+
+    API_BEGIN("DBCalcMaterialFromDenseArrays", DBmaterial*, 0) {
+        if (narrs<=0)
+            API_ERROR("narrs<=0", E_BADARGS);
+        if (ndims<=0)
+            API_ERROR("ndims<=0", E_BADARGS);
+        if (!dims)
+            API_ERROR("dims==0", E_BADARGS);
+        if (!matnos)
+            API_ERROR("matnos==0", E_BADARGS);
+        if (!vfracs)
+            API_ERROR("vfracs==0", E_BADARGS);
+        if (!((dtype == DB_FLOAT) || (dtype == DB_DOUBLE)))
+            API_ERROR("dtype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        csr = db_CalcMatcsrFromDenseArrays(narrs, ndims, dims, matnos, dtype, vfracs);
+        if (csr)
+        {
+            retval = db_CalcMaterialFromMatcsr(csr);
+            DBFreeMatcsr(csr);
+        }
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
+}
+
 PUBLIC
 int DBCalcDenseArraysFromMaterial(DBmaterial const *mat, int datatype, int *narrs, void ***vfracs)
 {
@@ -440,6 +849,8 @@ int DBCalcDenseArraysFromMaterial(DBmaterial const *mat, int datatype, int *narr
             API_ERROR("Empty DBmaterial object", E_BADARGS);
         if (!((datatype == DB_FLOAT) || (datatype == DB_DOUBLE)))
             API_ERROR("datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        if (!((mat->datatype == DB_FLOAT) || (mat->datatype == DB_DOUBLE)))
+            API_ERROR("mat datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
         if (!narrs)
             API_ERROR("narrs pointer", E_BADARGS);
         if (!vfracs)
@@ -449,3 +860,88 @@ int DBCalcDenseArraysFromMaterial(DBmaterial const *mat, int datatype, int *narr
     }
     API_END_NOPOP;
 }
+
+PUBLIC
+DBmatcsr *DBCalcMatcsrFromDenseArrays(int narrs, int ndims, int const *dims,
+    int const *matnos, int dtype, DBVCP2_t const vfracs)
+{
+    DBmatcsr *retval = 0;
+
+    API_BEGIN("DBCalcMatcsrFromDenseArrays", DBmatcsr*, 0) {
+        if (narrs<=0)
+            API_ERROR("narrs<=0", E_BADARGS);
+        if (ndims<=0 || ndims>3)
+            API_ERROR("ndims", E_BADARGS);
+        if (!dims)
+            API_ERROR("dims==0", E_BADARGS);
+        if (!matnos)
+            API_ERROR("matnos==0", E_BADARGS);
+        if (!vfracs)
+            API_ERROR("vfracs==0", E_BADARGS);
+        if (!((dtype == DB_FLOAT) || (dtype == DB_DOUBLE)))
+            API_ERROR("dtype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        retval = db_CalcMatcsrFromDenseArrays(narrs, ndims, dims, matnos, dtype, vfracs);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
+}
+
+PUBLIC
+int DBCalcDenseArraysFromMatcsr(DBmatcsr const *csr, int datatype, int *narrs, void ***vfracs)
+{
+    int retval;
+
+    API_BEGIN("DBCalcDenseArraysFromMatcsr", int, -1) {
+        if (!csr)
+            API_ERROR("csr pointer", E_BADARGS);
+        if (!csr->offsets || csr->nzones <= 0)
+            API_ERROR("Empty DBmatcsr object", E_BADARGS);
+        if (!((datatype == DB_FLOAT) || (datatype == DB_DOUBLE)))
+            API_ERROR("datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        if (!((csr->datatype == DB_FLOAT) || (csr->datatype == DB_DOUBLE)))
+            API_ERROR("csr datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        if (!narrs)
+            API_ERROR("narrs pointer", E_BADARGS);
+        if (!vfracs)
+            API_ERROR("vfracs pointer", E_BADARGS);
+        retval = db_CalcDenseArraysFromMatcsr(csr, datatype, narrs, vfracs);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
+}
+
+PUBLIC
+DBmatcsr *DBCalcMatcsrFromMaterial(DBmaterial const *mat)
+{
+    DBmatcsr *retval = 0;
+
+    API_BEGIN("DBCalcMatcsrFromMaterial", DBmatcsr*, 0) {
+        if (!mat)
+            API_ERROR("mat pointer", E_BADARGS);
+        if (DBIsEmptyMaterial(mat))
+            API_ERROR("Empty DBmaterial object", E_BADARGS);
+        if (!((mat->datatype == DB_FLOAT) || (mat->datatype == DB_DOUBLE)))
+            API_ERROR("mat datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        retval = db_CalcMatcsrFromMaterial(mat);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
+}
+
+PUBLIC
+DBmaterial *DBCalcMaterialFromMatcsr(DBmatcsr const *csr)
+{
+    DBmaterial *retval = 0;
+
+    API_BEGIN("DBCalcMaterialFromMatcsr", DBmaterial*, 0) {
+        if (!csr)
+            API_ERROR("csr pointer", E_BADARGS);
+        if (!csr->offsets || csr->nzones <= 0)
+            API_ERROR("Empty DBmatcsr object", E_BADARGS);
+        if (!((csr->datatype == DB_FLOAT) || (csr->datatype == DB_DOUBLE)))
+            API_ERROR("csr datatype must be DB_FLOAT or DB_DOUBLE", E_BADARGS);
+        retval = db_CalcMaterialFromMatcsr(csr);
+        API_RETURN(retval);
+    }
+    API_END_NOPOP;
+}
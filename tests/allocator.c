@@ -0,0 +1,216 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Counts calls into the caller-supplied allocator hooks */
+typedef struct count_t {
+    int nalloc;
+    int nfree;
+} count_t;
+
+static void *
+count_alloc(size_t n, void *client_data)
+{
+    count_t *c = (count_t *) client_data;
+    c->nalloc++;
+    return malloc(n);
+}
+
+static void
+count_free(void *p, void *client_data)
+{
+    count_t *c = (count_t *) client_data;
+    c->nfree++;
+    free(p);
+}
+
+/* A single caller-owned pool. DBFreeXxx() must leave it alone */
+static char pool[1<<16];
+static size_t pool_used = 0;
+
+static void *
+pool_alloc(size_t n, void *client_data)
+{
+    void *p;
+    (void) client_data;
+    n = (n + 15) & ~((size_t) 15);
+    if (pool_used + n > sizeof(pool))
+        return 0;
+    p = &pool[pool_used];
+    pool_used += n;
+    return p;
+}
+
+static void
+write_file(char const *filename, int driver)
+{
+    DBfile *dbfile;
+    float x[] = {0, 1, 2, 3}, y[] = {0, 1, 2};
+    float *coords[2];
+    int dims[] = {4, 3}, zdims[] = {3, 2};
+    float zvals[] = {1, 2, 3, 4, 5, 6};
+    int matnos[] = {1, 2}, matlist[] = {1, 2, 1, 2, 1, -1};
+    float mix_vf[] = {0.25, 0.75};
+    int mix_next[] = {2, 0}, mix_mat[] = {1, 2}, mix_zone[] = {6, 6};
+
+    coords[0] = x; coords[1] = y;
+
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "allocator hooks test", driver);
+    DBPutQuadmesh(dbfile, "qmesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "zvar", "qmesh", zvals, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBPutMaterial(dbfile, "mat", "qmesh", 2, matnos, matlist, zdims, 2,
+        mix_next, mix_mat, mix_zone, mix_vf, 2, DB_FLOAT, 0);
+    DBClose(dbfile);
+}
+
+static int
+read_objects(DBfile *dbfile)
+{
+    int err = 0;
+    DBquadmesh *qm = DBGetQuadmesh(dbfile, "qmesh");
+    DBquadvar *qv = DBGetQuadvar(dbfile, "zvar");
+    DBmaterial *mat = DBGetMaterial(dbfile, "mat");
+
+    if (!qm || !qv || !mat)
+        err = 1;
+    else if (((float*)qm->coords[0])[3] != 3 || ((float*)qv->vals[0])[5] != 6 ||
+             mat->matlist[5] != -1 || ((float*)mat->mix_vf)[1] != 0.75)
+        err = 1;
+
+    DBFreeQuadmesh(qm);
+    DBFreeQuadvar(qv);
+    DBFreeMaterial(mat);
+    return err;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, driver = DB_PDB, err = 0;
+    int show_all_errors = FALSE;
+    char const *filename = "allocator.pdb";
+    count_t gcnt = {0, 0}, fcnt = {0, 0};
+    DBfile *dbfile;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "allocator.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "allocator.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    write_file(filename, driver);
+
+    /* Library-wide hooks */
+    DBSetAllocator(count_alloc, count_free, &gcnt);
+    dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+    err |= read_objects(dbfile);
+    DBClose(dbfile);
+    if (gcnt.nalloc != gcnt.nfree)
+    {
+        fprintf(stderr, "global hooks: %d allocs but %d frees\n", gcnt.nalloc, gcnt.nfree);
+        err = 1;
+    }
+
+    /* File-level hooks take precedence over library-wide hooks */
+    dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+    DBSetAllocatorFile(dbfile, count_alloc, count_free, &fcnt);
+    gcnt.nalloc = gcnt.nfree = 0;
+    err |= read_objects(dbfile);
+    DBClose(dbfile);
+    if (gcnt.nalloc != 0 || fcnt.nalloc != fcnt.nfree)
+    {
+        fprintf(stderr, "file hooks: %d/%d global, %d/%d file allocs/frees\n",
+            gcnt.nalloc, gcnt.nfree, fcnt.nalloc, fcnt.nfree);
+        err = 1;
+    }
+
+    /* HDF5 driver routes bulk arrays through the hooks */
+    if ((driver&0xF) == DB_HDF5 && fcnt.nalloc == 0)
+    {
+        fprintf(stderr, "HDF5 driver did not use the allocator hooks\n");
+        err = 1;
+    }
+
+    /* Caller-owned memory; no free hook so DBFreeXxx() must not free it */
+    DBSetAllocator(pool_alloc, 0, 0);
+    dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+    err |= read_objects(dbfile);
+    DBClose(dbfile);
+    if ((driver&0xF) == DB_HDF5 && pool_used == 0)
+    {
+        fprintf(stderr, "HDF5 driver did not use the caller-owned pool\n");
+        err = 1;
+    }
+
+    /* Back to malloc/free */
+    DBSetAllocator(0, 0, 0);
+    dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+    err |= read_objects(dbfile);
+    DBClose(dbfile);
+
+    CleanupDriverStuff();
+    return err;
+}
@@ -0,0 +1,187 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <std.c>
+
+#define NX 33
+#define NY 17
+#define NCYCLES 10
+
+static float
+val(int cycle, int i)
+{
+    return (float) (cycle * 1000 + i);
+}
+
+/* Write one cycle's mesh and variable, then scribble over the caller's
+   buffers as a simulation would on its next cycle. Queued writes must
+   not see that. */
+static void
+write_cycle(DBfile *dbfile, int cycle, float *x, float *y, float *v)
+{
+    char dirname[32];
+    float *coords[2];
+    int dims[2] = {NX, NY}, zdims[2] = {NX-1, NY-1};
+    int i;
+
+    for (i = 0; i < NX; i++) x[i] = (float) (i + cycle);
+    for (i = 0; i < NY; i++) y[i] = (float) i;
+    for (i = 0; i < (NX-1)*(NY-1); i++) v[i] = val(cycle, i);
+    coords[0] = x; coords[1] = y;
+
+    sprintf(dirname, "cycle_%d", cycle);
+    DBMkDir(dbfile, dirname);
+    DBSetDir(dbfile, dirname);
+    DBPutQuadmesh(dbfile, "qmesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "zvar", "qmesh", v, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBSetDir(dbfile, "..");
+
+    for (i = 0; i < NX; i++) x[i] = -1;
+    for (i = 0; i < (NX-1)*(NY-1); i++) v[i] = -1;
+}
+
+static int
+check_cycle(DBfile *dbfile, int cycle)
+{
+    char dirname[32];
+    DBquadmesh *qm;
+    DBquadvar *qv;
+    int i, err = 0;
+
+    sprintf(dirname, "cycle_%d", cycle);
+    DBSetDir(dbfile, dirname);
+    qm = DBGetQuadmesh(dbfile, "qmesh");
+    qv = DBGetQuadvar(dbfile, "zvar");
+    DBSetDir(dbfile, "..");
+
+    if (!qm || ((float*)qm->coords[0])[NX-1] != (float) (NX-1+cycle))
+        err = 1;
+    for (i = 0; qv && !err && i < (NX-1)*(NY-1); i++)
+        if (((float*)qv->vals[0])[i] != val(cycle, i)) err = 1;
+    if (!qv || err)
+    {
+        fprintf(stderr, "cycle %d read back wrong\n", cycle);
+        err = 1;
+    }
+
+    DBFreeQuadmesh(qm);
+    DBFreeQuadvar(qv);
+    return err;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0;
+    int show_all_errors = FALSE;
+    int async = 1, optset;
+    char const *filename = "async_write.h5";
+    float x[NX], y[NY], v[(NX-1)*(NY-1)];
+    DBoptlist *opts;
+    DBfile *dbfile;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            fprintf(stderr, "DBOPT_H5_ASYNC applies only to the HDF5 driver; skipping\n");
+            return 77;
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            continue; /* uses its own options set */
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    opts = DBMakeOptlist(1);
+    DBAddOption(opts, DBOPT_H5_ASYNC, &async);
+    optset = DBRegisterFileOptionsSet(opts);
+
+    /* Read some cycles back while others may still be queued */
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "write-behind test",
+        DB_HDF5_OPTS(optset));
+    for (i = 0; i < NCYCLES; i++)
+    {
+        write_cycle(dbfile, i, x, y, v);
+        usleep(10000); /* "compute" while the worker writes */
+        if (i % 3 == 2)
+            err |= check_cycle(dbfile, i-1);
+    }
+    if (DBFlush(dbfile) != 0)
+    {
+        fprintf(stderr, "DBFlush failed\n");
+        err = 1;
+    }
+    write_cycle(dbfile, NCYCLES, x, y, v);
+    if (DBClose(dbfile) != 0)
+    {
+        fprintf(stderr, "DBClose failed\n");
+        err = 1;
+    }
+
+    /* Everything is in the file after DBClose */
+    dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ);
+    for (i = 0; i <= NCYCLES; i++)
+        err |= check_cycle(dbfile, i);
+    DBClose(dbfile);
+
+    DBUnregisterFileOptionsSet(optset);
+    DBFreeOptlist(opts);
+    CleanupDriverStuff();
+    return err;
+}
@@ -0,0 +1,288 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Exercises DBSetBlockStats and DBQueryBlocks: quad and ucd variables
+   written with block statistics on, in this file and another, must give
+   their multivars a block index whose queries never miss a matching
+   block and skip blocks that cannot match, and extents derived from it. */
+
+#define NX 5
+#define NVALS ((NX-1)*(NX-1))
+
+static int
+check_blocks(DBfile *dbfile, char const *mvname, int op, int comp,
+    double lo, double hi, int nexpect, int const *expect)
+{
+    DBblockpredicate pred;
+    int i, n, *blocks = 0;
+
+    pred.op = op;
+    pred.comp = comp;
+    pred.lo = lo;
+    pred.hi = hi;
+    n = DBQueryBlocks(dbfile, mvname, &pred, &blocks);
+    for (i = 0; i < n && i < nexpect; i++)
+        if (blocks[i] != expect[i])
+            break;
+    if (n != nexpect || i != n)
+    {
+        fprintf(stderr, "%s %s [%g,%g]: %d blocks, expected %d\n", mvname,
+            op == DB_BLOCKQUERY_ISO ? "iso" : "range", lo, hi, n, nexpect);
+        free(blocks);
+        return 1;
+    }
+    free(blocks);
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, j, b, n, err = 0, driver = DB_PDB;
+    int nblocks, ncomps;
+    int show_all_errors = FALSE;
+    char const *filename = "blockstats.pdb";
+    char const *filename2 = "blockstats_b.pdb";
+    float x[NX], y[NX], v[NVALS], w[NVALS];
+    double u[NVALS], nan = 0;
+    float *coords[2] = {x, y};
+    void *vars[2];
+    char const *compnames[2] = {"v", "w"};
+    int dims[2] = {NX, NX}, zdims[2] = {NX-1, NX-1};
+    int shapetype = DB_ZONETYPE_QUAD, shapesize = 4, shapecnt = NVALS, nl[4*NVALS];
+    char blockname[64];
+    char const *varnames[5];
+    char names[5][64];
+    int vartypes[5];
+    DBblockstats *stats;
+    DBmultivar *mv;
+    DBfile *dbfile, *dbfile2;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "blockstats.pdb";
+            filename2 = "blockstats_b.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "blockstats.h5";
+            filename2 = "blockstats_b.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    for (i = 0; i < NX; i++) x[i] = y[i] = (float) i;
+    for (i = 0; i < NVALS; i++) nl[4*i] = nl[4*i+1] = nl[4*i+2] = nl[4*i+3] = i % NX;
+    nan = nan / nan;
+
+    if (DBSetBlockStats(1) != 0 || DBGetBlockStats() != 1)
+    {
+        fprintf(stderr, "DBSetBlockStats did not take\n");
+        err = 1;
+    }
+
+    /* Blocks 0 to 2 are two-component quad variables in this file. Block
+       b of v spans [10b,10b+9], but block 1 has nothing in (12,18). w is
+       the negative of v. */
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "block stats test", driver);
+    for (b = 0; b < 3; b++)
+    {
+        sprintf(blockname, "block%d", b);
+        DBMkDir(dbfile, blockname);
+        DBSetDir(dbfile, blockname);
+        for (i = 0; i < NVALS; i++)
+        {
+            v[i] = (float) (10 * b) + (float) (9 * i) / (NVALS - 1);
+            if (b == 1)
+                v[i] = i < NVALS / 2 ? 10 + (float) i / NVALS : 19 - (float) (NVALS-1-i) / NVALS;
+            w[i] = -v[i];
+        }
+        vars[0] = v;
+        vars[1] = w;
+        DBPutQuadmesh(dbfile, "mesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+        DBPutQuadvar(dbfile, "q", "mesh", 2, compnames, vars, zdims, 2, 0, 0,
+            DB_FLOAT, DB_ZONECENT, 0);
+        DBSetDir(dbfile, "..");
+        sprintf(names[b], "/block%d/q", b);
+    }
+
+    /* Block 3 is a ucd variable of doubles in [30,39] in the other file,
+       with a NaN that must not count */
+    dbfile2 = DBCreate(filename2, DB_CLOBBER, DB_LOCAL, "block stats test", driver);
+    for (i = 0; i < NVALS; i++)
+        u[i] = 30 + (double) (9 * i) / (NVALS - 1);
+    u[3] = nan;
+    DBPutZonelist2(dbfile2, "zl", NVALS, 2, nl, 4*NVALS, 0, 0, 0, &shapetype,
+        &shapesize, &shapecnt, 1, 0);
+    DBPutUcdmesh(dbfile2, "mesh", 2, 0, coords, NX, NVALS, "zl", 0, DB_FLOAT, 0);
+    DBPutUcdvar1(dbfile2, "u", "mesh", u, NVALS, 0, 0, DB_DOUBLE, DB_ZONECENT, 0);
+    DBClose(dbfile2);
+    sprintf(names[3], "%s:/u", filename2);
+
+    /* Block 4 is empty, so its statistics are unknown */
+    strcpy(names[4], "EMPTY");
+
+    for (b = 0; b < 5; b++)
+    {
+        varnames[b] = names[b];
+        vartypes[b] = b < 3 ? DB_QUADVAR : DB_UCDVAR;
+    }
+    DBPutMultivar(dbfile, "mv", 5, varnames, vartypes, 0);
+    DBPutMultivar(dbfile, "mvq", 3, varnames, vartypes, 0);
+
+    /* A multivar written with statistics off has no index */
+    DBSetBlockStats(0);
+    DBPutMultivar(dbfile, "mvoff", 3, varnames, vartypes, 0);
+    DBClose(dbfile);
+
+    dbfile = DBOpen(filename, driver, DB_READ);
+
+    /* The index of mv has the statistics of every component of every block */
+    stats = DBGetBlockIndex(dbfile, "mv", &nblocks, &ncomps);
+    if (!stats || nblocks != 5 || ncomps != 2)
+    {
+        fprintf(stderr, "mv index: %d blocks of %d components\n", nblocks, ncomps);
+        return 1;
+    }
+    for (b = 0; b < 3; b++)
+    {
+        DBblockstats const *s = &stats[2*b];
+        long long hsum = 0;
+        for (j = 0; j < DB_BLOCKSTATS_NBINS; j++)
+            hsum += s->hist[j];
+        if (s->count != NVALS || s->min != 10*b || s->max != 10*b+9 ||
+            hsum != NVALS || stats[2*b+1].min != -s->max ||
+            stats[2*b+1].max != -s->min ||
+            (b != 1 && (s->mean < 10*b+4.49 || s->mean > 10*b+4.51)))
+        {
+            fprintf(stderr, "block %d: %lld values in [%g,%g], mean %g\n", b,
+                s->count, s->min, s->max, s->mean);
+            err = 1;
+        }
+    }
+    if (stats[6].count != NVALS-1 || stats[6].min != 30 || stats[6].max != 39 ||
+        stats[7].count != -1 || stats[8].count != -1 || stats[9].count != -1)
+    {
+        fprintf(stderr, "block 3: %lld values in [%g,%g]\n", stats[6].count,
+            stats[6].min, stats[6].max);
+        err = 1;
+    }
+    free(stats);
+
+    /* The histogram rules out block 1 for (12,18); unknown blocks always
+       match */
+    {
+        int e1[] = {1, 4}, e2[] = {0, 4}, e3[] = {3, 4}, e4[] = {2, 3, 4};
+        int e5[] = {0, 1, 2, 3, 4}, e6[] = {2, 4}, e7[] = {1}, e8[] = {0, 1, 2};
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, 10.5, 11, 2, e1);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, 13, 17, 1, e1+1);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, 9, 9, 2, e2);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, -5, 0, 2, e2);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, 35, 35.2, 2, e3);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_ISO, 1, -25, 0, 3, e4);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_RANGE, 0, -100, 100, 5, e5);
+        err |= check_blocks(dbfile, "mv", DB_BLOCKQUERY_ISO, 0, 29, 0, 2, e6);
+        err |= check_blocks(dbfile, "mvq", DB_BLOCKQUERY_ISO, 0, 15, 0, 1, e7);
+        err |= check_blocks(dbfile, "mvq", DB_BLOCKQUERY_RANGE, 1, -1000, 1000, 3, e8);
+        err |= check_blocks(dbfile, "mvoff", DB_BLOCKQUERY_RANGE, 0, 1000, 2000, 3, e8);
+    }
+
+    /* Extents are added only when every block's statistics are known */
+    mv = DBGetMultivar(dbfile, "mvq");
+    if (!mv || mv->extentssize != 4 || !mv->extents ||
+        mv->extents[0] != 0 || mv->extents[1] != -9 ||
+        mv->extents[2] != 9 || mv->extents[3] != 0 ||
+        mv->extents[8] != 20 || mv->extents[11] != -20)
+    {
+        fprintf(stderr, "mvq extents missing or wrong\n");
+        err = 1;
+    }
+    DBFreeMultivar(mv);
+    mv = DBGetMultivar(dbfile, "mv");
+    if (!mv || mv->extents)
+    {
+        fprintf(stderr, "mv has extents\n");
+        err = 1;
+    }
+    DBFreeMultivar(mv);
+
+    /* Bad arguments */
+    DBShowErrors(DB_NONE, 0);
+    {
+        DBblockpredicate pred = {DB_BLOCKQUERY_RANGE, 2, 0, 1};
+        int *blocks = 0;
+        n = DBQueryBlocks(dbfile, "mv", &pred, &blocks);
+        pred.comp = 0;
+        pred.lo = 2;
+        n |= DBQueryBlocks(dbfile, "mv", &pred, &blocks);
+        n |= DBQueryBlocks(dbfile, "nosuchmv", &pred, &blocks);
+        if (n != -1 || DBGetBlockIndex(dbfile, "mvoff", &nblocks, &ncomps))
+        {
+            fprintf(stderr, "bad arguments accepted\n");
+            err = 1;
+        }
+    }
+    DBClose(dbfile);
+
+    CleanupDriverStuff();
+    return err;
+}
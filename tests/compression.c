@@ -65,12 +65,497 @@ be used for advertising or product endorsement purposes.
 #endif
 #include <stdlib.h>
 
+#include "config.h"
+#ifdef HAVE_HDF5_H
+#define H5_USE_16_API
+#include "hdf5.h"
+#endif
+
 #define GNU_AUTOTEST_SKIP_CODE 77
 #define ONE_MEG 1048576
 #define ITERATE 50
 
 #include <std.c>
 
+/*-------------------------------------------------------------------------
+ * Tiled (CHUNK=) compression. Write a 3d array with DBWrite and a ucd
+ * variable with each combination of 1 and 4 compression threads for
+ * writing and reading, so that tiles compressed by the threads are read
+ * back by HDF5 and the other way around. Check whole reads and slices
+ * that fall in one tile or cross many.
+ *-------------------------------------------------------------------------
+ */
+#define TNX 37
+#define TNY 29
+#define TNZ 23
+#define TNVALS (TNX*TNY*TNZ)
+
+static int
+check_tiled_file(char const *filename, int driver, int nthreads)
+{
+    static int const slices[][6] = {
+        {0, 0, 0, TNZ, TNY, TNX},      /* everything */
+        {2, 3, 4, 1, 2, 5},            /* within one tile */
+        {5, 1, 0, 13, 27, TNX},        /* across many tiles */
+        {TNZ-1, TNY-1, TNX-3, 1, 1, 3} /* the last edge tile */
+    };
+    double *vals = (double *) malloc(TNVALS * sizeof(double));
+    double *rvals = (double *) malloc(TNVALS * sizeof(double));
+    DBfile *dbfile;
+    DBucdvar *uv;
+    int i, s, nerrors = 0;
+
+    DBSetThreads(nthreads);
+    if ((dbfile = DBOpen(filename, driver, DB_READ)) == 0)
+    {
+        printf("Unable to open \"%s\"\n", filename);
+        return 1;
+    }
+
+    for (i = 0; i < TNVALS; i++)
+        vals[i] = sin(i * 0.01) * (1 + i % 7);
+
+    for (s = 0; s < (int) (sizeof(slices)/sizeof(slices[0])); s++)
+    {
+        int const *off = slices[s], *len = slices[s] + 3;
+        int stride[3] = {1, 1, 1};
+        int x, y, z, n = 0, bad = 0;
+
+        memset(rvals, 0, TNVALS * sizeof(double));
+        if (DBReadVarSlice(dbfile, "tiled", (int *) off, (int *) len, stride,
+                           3, rvals) < 0)
+        {
+            printf("DBReadVarSlice %d with %d threads failed\n", s, nthreads);
+            nerrors++;
+            continue;
+        }
+        for (z = off[0]; z < off[0] + len[0]; z++)
+            for (y = off[1]; y < off[1] + len[1]; y++)
+                for (x = off[2]; x < off[2] + len[2]; x++, n++)
+                    bad += rvals[n] != vals[(z * TNY + y) * TNX + x];
+        if (bad)
+        {
+            printf("slice %d read with %d threads is wrong\n", s, nthreads);
+            nerrors++;
+        }
+    }
+
+    memset(rvals, 0, TNVALS * sizeof(double));
+    if (DBReadVar(dbfile, "tiled", rvals) < 0 ||
+        memcmp(vals, rvals, TNVALS * sizeof(double)))
+    {
+        printf("DBReadVar with %d threads is wrong\n", nthreads);
+        nerrors++;
+    }
+
+    if ((uv = DBGetUcdvar(dbfile, "uv")) == 0 || uv->nels != TNVALS ||
+        memcmp(vals, uv->vals[0], TNVALS * sizeof(double)))
+    {
+        printf("DBGetUcdvar with %d threads is wrong\n", nthreads);
+        nerrors++;
+    }
+    DBFreeUcdvar(uv);
+
+    DBClose(dbfile);
+
+#ifdef HAVE_HDF5_H
+    /* Make sure the data really is tiled */
+    {
+        hid_t fid, dset, dcpl;
+        hsize_t chunk[3] = {0, 0, 0};
+        fid = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+        dset = H5Dopen(fid, "tiled");
+        dcpl = H5Dget_create_plist(dset);
+        H5Pget_chunk(dcpl, 3, chunk);
+        H5Pclose(dcpl);
+        H5Dclose(dset);
+        H5Fclose(fid);
+        if (chunk[0] * chunk[1] * chunk[2] > 1000 || chunk[2] != TNX)
+        {
+            printf("\"tiled\" is not tiled\n");
+            nerrors++;
+        }
+    }
+#endif
+    free(vals);
+    free(rvals);
+    return nerrors;
+}
+
+static int
+check_tiled(int driver)
+{
+    static char const *methods[] = {"METHOD=GZIP CHUNK=1000",
+                                    "METHOD=GZIP LEVEL=6 CHUNK=1000"};
+    double *vals = (double *) malloc(TNVALS * sizeof(double));
+    int dims[3] = {TNZ, TNY, TNX};
+    int i, m, wt, rt, nerrors = 0;
+    char filename[64];
+
+    for (i = 0; i < TNVALS; i++)
+        vals[i] = sin(i * 0.01) * (1 + i % 7);
+
+    for (m = 0; m < (int) (sizeof(methods)/sizeof(methods[0])); m++)
+    {
+        for (wt = 1; wt <= 4; wt *= 4)
+        {
+            DBfile *dbfile;
+            void *vars[1];
+            vars[0] = vals;
+
+            sprintf(filename, "compression_tiled_%d_%d.h5", m, wt);
+            DBSetCompression(methods[m]);
+            DBSetThreads(wt);
+            dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "Tiled compression", driver);
+            if (DBWrite(dbfile, "tiled", vals, dims, 3, DB_DOUBLE) < 0 ||
+                DBPutUcdvar1(dbfile, "uv", "mesh", vals, TNVALS, 0, 0,
+                             DB_DOUBLE, DB_NODECENT, 0) < 0)
+            {
+                printf("Writing with \"%s\" and %d threads failed\n", methods[m], wt);
+                nerrors++;
+            }
+            DBClose(dbfile);
+            DBSetCompression(0);
+
+            for (rt = 1; rt <= 4; rt *= 4)
+                nerrors += check_tiled_file(filename, driver, rt);
+        }
+    }
+
+    /* Bad settings */
+    DBShowErrors(DB_NONE, 0);
+    if (DBSetThreads(0) != -1 || DBGetThreads() != 4)
+    {
+        printf("DBSetThreads accepted 0\n");
+        nerrors++;
+    }
+    DBSetCompression("METHOD=GZIP CHUNK=0");
+    {
+        DBfile *dbfile = DBCreate("compression_tiled_bad.h5", DB_CLOBBER, DB_LOCAL, 0, driver);
+        if (DBWrite(dbfile, "tiled", vals, dims, 3, DB_DOUBLE) != -1)
+        {
+            printf("CHUNK=0 was accepted\n");
+            nerrors++;
+        }
+        DBClose(dbfile);
+    }
+    DBSetCompression(0);
+    DBSetThreads(1);
+
+    free(vals);
+    return nerrors;
+}
+
+/*-------------------------------------------------------------------------
+ * Compression rules. Write arrays that different rules of one compression
+ * string select and check the filters HDF5 stored them with. The ucd
+ * variable is written first so that its LEVEL=9 must not stick to the
+ * arrays written after it.
+ *-------------------------------------------------------------------------
+ */
+#define PNVALS 1000
+
+#ifdef HAVE_HDF5_H
+typedef struct filters_t {
+    int     nfilters;
+    int     level;      /* deflate level or -1 */
+    hsize_t chunkvals;  /* values per chunk or 0 if contiguous */
+} filters_t;
+
+static void
+get_filters(hid_t loc, char const *name, filters_t *f)
+{
+    hid_t dset = H5Dopen(loc, name);
+    hid_t dcpl = H5Dget_create_plist(dset);
+    hsize_t chunk[8];
+    int i, rank;
+
+    f->level = -1;
+    f->chunkvals = 0;
+    f->nfilters = H5Pget_nfilters(dcpl);
+    for (i = 0; i < f->nfilters; i++)
+    {
+        unsigned flags, cd_values[8];
+        size_t cd_nelmts = 8;
+        if (H5Pget_filter(dcpl, (unsigned) i, &flags, &cd_nelmts, cd_values,
+                          0, 0) == H5Z_FILTER_DEFLATE)
+            f->level = (int) cd_values[0];
+    }
+    if (H5Pget_layout(dcpl) == H5D_CHUNKED &&
+        (rank = H5Pget_chunk(dcpl, 8, chunk)) > 0)
+        for (f->chunkvals = 1, i = 0; i < rank; i++)
+            f->chunkvals *= chunk[i];
+    H5Pclose(dcpl);
+    H5Dclose(dset);
+}
+
+/* Find the one level 9 dataset in the link group */
+static herr_t
+find_level9(hid_t group, char const *name, void *op_data)
+{
+    filters_t f;
+    H5G_stat_t sb;
+
+    if (H5Gget_objinfo(group, name, 0, &sb) < 0 || sb.type != H5G_DATASET)
+        return 0;
+    get_filters(group, name, &f);
+    if (f.level == 9)
+    {
+        ((filters_t *) op_data)->nfilters++;
+        ((filters_t *) op_data)->chunkvals = f.chunkvals;
+    }
+    return 0;
+}
+#endif
+
+static int
+check_policy(int driver)
+{
+    static char const *policy =
+        "METHOD=GZIP LEVEL=1 MINSIZE=100;"
+        "NAME=fp* METHOD=FPZIP;"
+        "DATATYPE=int METHOD=NONE;"
+        "OBJTYPE=ucdvar LEVEL=9 CHUNK=500";
+    char const *filename = "compression_policy.h5";
+    double *dvals = (double *) malloc(PNVALS * sizeof(double));
+    float *fvals = (float *) malloc(PNVALS * sizeof(float));
+    int *ivals = (int *) malloc(PNVALS * sizeof(int));
+    int i, n = PNVALS, small = 50, nerrors = 0;
+    DBfile *dbfile;
+
+    for (i = 0; i < PNVALS; i++)
+    {
+        dvals[i] = sin(i * 0.01);
+        fvals[i] = (float) dvals[i];
+        ivals[i] = i % 17;
+    }
+
+    DBSetCompression(policy);
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "Compression rules", driver);
+    if (DBPutUcdvar1(dbfile, "uv", "mesh", dvals, n, 0, 0, DB_DOUBLE,
+                     DB_NODECENT, 0) < 0 ||
+        DBWrite(dbfile, "big", dvals, &n, 1, DB_DOUBLE) < 0 ||
+        DBWrite(dbfile, "small", dvals, &small, 1, DB_DOUBLE) < 0 ||
+        DBWrite(dbfile, "fpvar", fvals, &n, 1, DB_FLOAT) < 0 ||
+        DBWrite(dbfile, "ints", ivals, &n, 1, DB_INT) < 0)
+    {
+        printf("Writing with \"%s\" failed\n", policy);
+        nerrors++;
+    }
+    DBClose(dbfile);
+    DBSetCompression(0);
+
+    /* Everything reads back */
+    dbfile = DBOpen(filename, driver, DB_READ);
+    {
+        double *rd = (double *) calloc(PNVALS, sizeof(double));
+        float *rf = (float *) calloc(PNVALS, sizeof(float));
+        int *ri = (int *) calloc(PNVALS, sizeof(int));
+        DBucdvar *uv = DBGetUcdvar(dbfile, "uv");
+
+        if (!uv || memcmp(uv->vals[0], dvals, PNVALS * sizeof(double)) ||
+            DBReadVar(dbfile, "big", rd) < 0 ||
+            memcmp(rd, dvals, PNVALS * sizeof(double)) ||
+            DBReadVar(dbfile, "small", rd) < 0 ||
+            memcmp(rd, dvals, small * sizeof(double)) ||
+            DBReadVar(dbfile, "fpvar", rf) < 0 ||
+            memcmp(rf, fvals, PNVALS * sizeof(float)) ||
+            DBReadVar(dbfile, "ints", ri) < 0 ||
+            memcmp(ri, ivals, PNVALS * sizeof(int)))
+        {
+            printf("Arrays written with \"%s\" read back wrong\n", policy);
+            nerrors++;
+        }
+        DBFreeUcdvar(uv);
+        free(rd);
+        free(rf);
+        free(ri);
+    }
+    DBClose(dbfile);
+
+#ifdef HAVE_HDF5_H
+    {
+        hid_t fid = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+        filters_t f, uv = {0, 0, 0};
+
+        get_filters(fid, "big", &f);
+        if (f.level != 1 || f.nfilters != 2)
+        {
+            printf("\"big\" has %d filters and level %d\n", f.nfilters, f.level);
+            nerrors++;
+        }
+        get_filters(fid, "small", &f);
+        if (f.nfilters != 0 || f.chunkvals != 0)
+        {
+            printf("\"small\" is below MINSIZE but was compressed\n");
+            nerrors++;
+        }
+        get_filters(fid, "fpvar", &f);
+        if (f.nfilters != 1 || f.level != -1)
+        {
+            printf("\"fpvar\" is not compressed with FPZIP\n");
+            nerrors++;
+        }
+        get_filters(fid, "ints", &f);
+        if (f.nfilters != 0)
+        {
+            printf("\"ints\" was compressed\n");
+            nerrors++;
+        }
+        H5Giterate(fid, "/.silo", 0, find_level9, &uv);
+        if (uv.nfilters != 1 || uv.chunkvals != 500)
+        {
+            printf("\"uv\" is not compressed with its own rule\n");
+            nerrors++;
+        }
+        H5Fclose(fid);
+    }
+#endif
+
+    /* A bad rule fails only the writes it selects */
+    DBShowErrors(DB_NONE, 0);
+    DBSetCompression("METHOD=GZIP; NAME=bad LEVEL=12");
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, 0, driver);
+    if (DBWrite(dbfile, "good", dvals, &n, 1, DB_DOUBLE) < 0 ||
+        DBWrite(dbfile, "bad", dvals, &n, 1, DB_DOUBLE) != -1)
+    {
+        printf("LEVEL=12 was not confined to its rule\n");
+        nerrors++;
+    }
+    DBClose(dbfile);
+    DBSetCompression("LEVEL=5");
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, 0, driver);
+    if (DBWrite(dbfile, "nomethod", dvals, &n, 1, DB_DOUBLE) != -1)
+    {
+        printf("A compression string without METHOD was accepted\n");
+        nerrors++;
+    }
+    DBClose(dbfile);
+    DBSetCompression(0);
+
+    free(dvals);
+    free(fvals);
+    free(ivals);
+    return nerrors;
+}
+
+/*-------------------------------------------------------------------------
+ * METHOD=AUTO. Noise isn't worth compressing, integers can only be
+ * GZIP'd and smooth floating point data with a ZFP tolerance goes to ZFP.
+ * Check the choices with DBGetCompressionStats and the stored filters.
+ *-------------------------------------------------------------------------
+ */
+static int
+check_auto(int driver)
+{
+    char const *filename = "compression_auto.h5";
+    int dims[3] = {TNZ, TNY, TNX}, n = TNVALS;
+    double *smooth = (double *) malloc(TNVALS * sizeof(double));
+    double *noise = (double *) malloc(TNVALS * sizeof(double));
+    double *rd = (double *) malloc(TNVALS * sizeof(double));
+    int *ivals = (int *) malloc(TNVALS * sizeof(int));
+    unsigned long long r = 12345;
+    DBcompressionstats stats;
+    DBfile *dbfile;
+    int i, nerrors = 0;
+
+    for (i = 0; i < TNVALS; i++)
+    {
+        smooth[i] = sin(i * 0.001);
+        r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+        noise[i] = (double) (r >> 11) / 9007199254740992.0;
+        ivals[i] = i / 100;
+    }
+
+    DBResetCompressionStats();
+    DBSetCompression("METHOD=AUTO SAMPLE=4096; NAME=smooth ACCURACY=0.0001");
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "METHOD=AUTO", driver);
+    if (DBWrite(dbfile, "noise", noise, dims, 3, DB_DOUBLE) < 0 ||
+        DBWrite(dbfile, "ints", ivals, &n, 1, DB_INT) < 0 ||
+        DBWrite(dbfile, "smooth", smooth, dims, 3, DB_DOUBLE) < 0)
+    {
+        printf("Writing with METHOD=AUTO failed\n");
+        nerrors++;
+    }
+    DBClose(dbfile);
+    DBSetCompression(0);
+
+    if (DBGetCompressionStats(&stats) < 0 || stats.narrays != 3 ||
+        stats.nnone != 1 || stats.ngzip != 1 || stats.nzfp != 1 ||
+        stats.nbytes != TNVALS * (2 * sizeof(double) + sizeof(int)) ||
+        stats.nbytes_est >= stats.nbytes || stats.nbytes_trial <= 0)
+    {
+        printf("METHOD=AUTO chose %lld none, %lld gzip, %lld fpzip, %lld zfp\n",
+            stats.narrays ? stats.nnone : -1, stats.ngzip, stats.nfpzip,
+            stats.nzfp);
+        nerrors++;
+    }
+
+    dbfile = DBOpen(filename, driver, DB_READ);
+    if (DBReadVar(dbfile, "noise", rd) < 0 ||
+        memcmp(rd, noise, TNVALS * sizeof(double)))
+    {
+        printf("\"noise\" reads back wrong\n");
+        nerrors++;
+    }
+    if (DBReadVar(dbfile, "smooth", rd) < 0)
+    {
+        printf("\"smooth\" can't be read\n");
+        nerrors++;
+    }
+    for (i = 0; i < TNVALS; i++)
+    {
+        if (fabs(rd[i] - smooth[i]) > 0.0001)
+        {
+            printf("\"smooth\" is off by %g at %d\n", rd[i] - smooth[i], i);
+            nerrors++;
+            break;
+        }
+    }
+    DBClose(dbfile);
+
+#ifdef HAVE_HDF5_H
+    {
+        hid_t fid = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+        filters_t f;
+
+        get_filters(fid, "noise", &f);
+        if (f.nfilters != 0)
+        {
+            printf("\"noise\" was compressed\n");
+            nerrors++;
+        }
+        get_filters(fid, "ints", &f);
+        if (f.level != 1)
+        {
+            printf("\"ints\" was not compressed with GZIP\n");
+            nerrors++;
+        }
+        H5Fclose(fid);
+    }
+#endif
+
+    DBShowErrors(DB_NONE, 0);
+    if (DBGetCompressionStats(0) != -1)
+    {
+        printf("DBGetCompressionStats accepted NULL\n");
+        nerrors++;
+    }
+    DBResetCompressionStats();
+    DBGetCompressionStats(&stats);
+    if (stats.narrays != 0)
+    {
+        printf("DBResetCompressionStats didn't\n");
+        nerrors++;
+    }
+
+    free(smooth);
+    free(noise);
+    free(rd);
+    free(ivals);
+    return nerrors;
+}
+
 /*-------------------------------------------------------------------------
  * Function:        main
  *
@@ -94,6 +579,9 @@ main(int argc, char *argv[])
     int            verbose = 0;
     int            usefloat = 0;
     int            readonly = 0;
+    int            tiled = 0;
+    int            policy = 0;
+    int            autosel = 0;
     int            i, j, ndims=1;
     int            fdims[]={ONE_MEG/sizeof(float)};
     int            ddims[]={ONE_MEG/sizeof(double)};
@@ -162,6 +650,12 @@ main(int argc, char *argv[])
           DBSetCompression("ERRMODE=FALLBACK MINRATIO=1000 METHOD=FPZIP");
        } else if (!strcmp(argv[i], "readonly")) {
           readonly = 1;
+       } else if (!strcmp(argv[i], "tiled")) {
+          tiled = 1;
+       } else if (!strcmp(argv[i], "policy")) {
+          policy = 1;
+       } else if (!strcmp(argv[i], "auto")) {
+          autosel = 1;
        } else if (!strcmp(argv[i], "help")) {
           printf("Usage: %s [compress [\"METHOD=...\"]|single|verbose|readonly]\n",argv[0]);
           printf("Where: compress - enables compression, followed by compression information string\n");
@@ -169,6 +663,9 @@ main(int argc, char *argv[])
           printf("       single   - writes data as floats not doubles\n");
           printf("       verbose  - displays more feedback\n");
           printf("       readonly - checks an existing file (used for cross platform test)\n");
+          printf("       tiled    - checks CHUNK= tiling with and without threads\n");
+          printf("       policy   - checks per object rules and MINSIZE\n");
+          printf("       auto     - checks METHOD=AUTO and its statistics\n");
           printf("       DB_HDF5  - enable HDF5 driver, the default\n");
           return (0);
        } else if (!strcmp(argv[i], "show-all-errors")) {
@@ -178,6 +675,30 @@ main(int argc, char *argv[])
        }
     }
 
+    if (tiled)
+    {
+       DBShowErrors(show_errors, 0);
+       nerrors = check_tiled(driver);
+       CleanupDriverStuff();
+       return nerrors;
+    }
+
+    if (policy)
+    {
+       DBShowErrors(show_errors, 0);
+       nerrors = check_policy(driver);
+       CleanupDriverStuff();
+       return nerrors;
+    }
+
+    if (autosel)
+    {
+       DBShowErrors(show_errors, 0);
+       nerrors = check_auto(driver);
+       CleanupDriverStuff();
+       return nerrors;
+    }
+
     /* get some temporary memory */
     fval = (float*) malloc(ONE_MEG);
     frval = (float*) malloc(ONE_MEG);
@@ -0,0 +1,357 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <std.c>
+
+/*
+ * Check DBCalcExtents, the kernel behind the extents of DBPut*mesh,
+ * against a plain loop for every type it takes, then check the extents
+ * of point, ucd and quad meshes written with it. The `bench' argument
+ * times the plain loop against the kernel.
+ */
+
+#define NLENS 6
+static long long const lens[NLENS] = {1, 7, 8, 9, 1001, (3<<20) + 5};
+
+#define REFERENCE(NAME, T)                                              \
+static void                                                             \
+NAME(T const *arr, long long n, T *mn, T *mx)                           \
+{                                                                       \
+    long long i;                                                        \
+    *mn = *mx = arr[0];                                                 \
+    for (i = 1; i < n; i++)                                             \
+    {                                                                   \
+        if (arr[i] < *mn) *mn = arr[i];                                 \
+        if (arr[i] > *mx) *mx = arr[i];                                 \
+    }                                                                   \
+}
+
+REFERENCE(ref_char, char)
+REFERENCE(ref_short, short)
+REFERENCE(ref_int, int)
+REFERENCE(ref_long, long)
+REFERENCE(ref_longlong, long long)
+REFERENCE(ref_float, float)
+REFERENCE(ref_double, double)
+
+#define CHECK_TYPE(DT, T, REF, VAL)                                     \
+{                                                                       \
+    T *arr = (T *) malloc((size_t) n * sizeof(T));                      \
+    T mn, mx, rmn, rmx;                                                 \
+    long long i;                                                        \
+    for (i = 0; i < n; i++)                                             \
+        arr[i] = (T) (VAL);                                             \
+    if (nan_at >= 0 && nan_at < n)                                      \
+        arr[nan_at] = (T) nan_val;                                      \
+    REF(arr, n, &rmn, &rmx);                                            \
+    if (DBCalcExtents(arr, DT, n, &mn, &mx) != 0 || mn != rmn || mx != rmx) \
+    {                                                                   \
+        fprintf(stderr, "%s extents of %lld values are wrong\n", #T, n); \
+        err = 1;                                                        \
+    }                                                                   \
+    free(arr);                                                          \
+}
+
+static int
+check_calc(void)
+{
+    int err = 0, t, l;
+    double nan_val = sqrt(-1.0);
+    long long nan_at;
+
+    for (t = 1; t <= 4; t *= 4)
+    {
+        DBSetThreads(t);
+        for (l = 0; l < NLENS; l++)
+        {
+            long long n = lens[l];
+
+            /* Values wander up and down so the extents are not at the ends */
+            nan_at = -1;
+            CHECK_TYPE(DB_CHAR, char, ref_char, (i * 37) % 101 - 50)
+            CHECK_TYPE(DB_SHORT, short, ref_short, (i * 7919) % 20011 - 10000)
+            CHECK_TYPE(DB_INT, int, ref_int, (i * 7919) % 1000003 - 500000)
+            CHECK_TYPE(DB_LONG, long, ref_long, (i * 7919) % 1000003 - 500000)
+            CHECK_TYPE(DB_LONG_LONG, long long, ref_longlong,
+                       ((i * 7919) % 1000003 - 500000) * 4000000000LL)
+            CHECK_TYPE(DB_FLOAT, float, ref_float, sin(i * 0.001) * (1 + i % 13))
+            CHECK_TYPE(DB_DOUBLE, double, ref_double, cos(i * 0.001) * (1 + i % 13))
+
+            /* A NaN past the first value is ignored, as by the plain loop */
+            nan_at = n / 2 ? n / 2 : -1;
+            CHECK_TYPE(DB_FLOAT, float, ref_float, sin(i * 0.001) * (1 + i % 13))
+            CHECK_TYPE(DB_DOUBLE, double, ref_double, cos(i * 0.001) * (1 + i % 13))
+        }
+    }
+    DBSetThreads(1);
+
+    /* Bad arguments */
+    {
+        float f[2] = {1, 2}, mn, mx;
+        if (DBCalcExtents(0, DB_FLOAT, 2, &mn, &mx) != -1 ||
+            DBCalcExtents(f, DB_FLOAT, 0, &mn, &mx) != -1 ||
+            DBCalcExtents(f, DB_NOTYPE, 2, &mn, &mx) != -1 ||
+            DBSetThreads(0) != -1 || DBGetThreads() != 1)
+        {
+            fprintf(stderr, "bad arguments are not caught\n");
+            err = 1;
+        }
+    }
+    return err;
+}
+
+static int
+check_extent(char const *what, int dim, double got, double want)
+{
+    if (got == want) return 0;
+    fprintf(stderr, "%s extent %d is %g, not %g\n", what, dim, got, want);
+    return 1;
+}
+
+#define NX 6
+#define NY 5
+#define NZ 4
+#define NNODES (NX*NY*NZ)
+
+static int
+check_meshes(DBfile *dbfile, int datatype)
+{
+    float fx[NNODES], fy[NNODES], fz[NNODES];
+    double dx[NNODES], dy[NNODES], dz[NNODES];
+    void *coords[3];
+    int dims[3] = {NX, NY, NZ}, lo[3] = {1, 0, 1}, hi[3] = {1, 0, 2};
+    int hex[8] = {0, 1, NX+1, NX, NX*NY, NX*NY+1, NX*NY+NX+1, NX*NY+NX};
+    int shapetype = DB_ZONETYPE_HEX, shapesize = 8, shapecnt = 1;
+    double rmin[3], rmax[3], qmin[3], qmax[3];
+    int i, j, k, d, n, err = 0;
+    DBoptlist *opts;
+    DBpointmesh *pm;
+    DBucdmesh *um;
+    DBquadmesh *qm;
+
+    /* A warped block whose extremes are scattered about the interior */
+    for (n = 0, k = 0; k < NZ; k++)
+        for (j = 0; j < NY; j++)
+            for (i = 0; i < NX; i++, n++)
+            {
+                dx[n] = i + 0.3 * sin(n * 1.7);
+                dy[n] = j + 0.3 * cos(n * 2.3);
+                dz[n] = k * 1.5 + 0.2 * sin(n * 0.7);
+                fx[n] = (float) dx[n];
+                fy[n] = (float) dy[n];
+                fz[n] = (float) dz[n];
+                if (datatype == DB_FLOAT)
+                {
+                    dx[n] = fx[n];
+                    dy[n] = fy[n];
+                    dz[n] = fz[n];
+                }
+            }
+    if (datatype == DB_FLOAT)
+    {
+        coords[0] = fx; coords[1] = fy; coords[2] = fz;
+    }
+    else
+    {
+        coords[0] = dx; coords[1] = dy; coords[2] = dz;
+    }
+
+    for (d = 0; d < 3; d++)
+    {
+        double *c = d == 0 ? dx : d == 1 ? dy : dz;
+        rmin[d] = rmax[d] = c[0];
+        qmin[d] = qmax[d] = c[(lo[2] * NY + lo[1]) * NX + lo[0]];
+        for (n = 0, k = 0; k < NZ; k++)
+            for (j = 0; j < NY; j++)
+                for (i = 0; i < NX; i++, n++)
+                {
+                    rmin[d] = c[n] < rmin[d] ? c[n] : rmin[d];
+                    rmax[d] = c[n] > rmax[d] ? c[n] : rmax[d];
+                    if (i < lo[0] || i >= NX - hi[0] || j < lo[1] ||
+                        j >= NY - hi[1] || k < lo[2] || k >= NZ - hi[2])
+                        continue;
+                    qmin[d] = c[n] < qmin[d] ? c[n] : qmin[d];
+                    qmax[d] = c[n] > qmax[d] ? c[n] : qmax[d];
+                }
+    }
+
+    DBPutPointmesh(dbfile, "pm", 3, coords, NNODES, datatype, 0);
+    DBPutZonelist2(dbfile, "zl", 1, 3, hex, 8, 0, 0, 0, &shapetype, &shapesize,
+                   &shapecnt, 1, 0);
+    DBPutUcdmesh(dbfile, "um", 3, 0, coords, NNODES, 1, "zl", 0, datatype, 0);
+    opts = DBMakeOptlist(2);
+    DBAddOption(opts, DBOPT_LO_OFFSET, lo);
+    DBAddOption(opts, DBOPT_HI_OFFSET, hi);
+    DBPutQuadmesh(dbfile, "qm", 0, coords, dims, 3, datatype, DB_NONCOLLINEAR, opts);
+    DBFreeOptlist(opts);
+
+    pm = DBGetPointmesh(dbfile, "pm");
+    um = DBGetUcdmesh(dbfile, "um");
+    qm = DBGetQuadmesh(dbfile, "qm");
+    if (!pm || !um || !qm)
+    {
+        fprintf(stderr, "can't read the meshes back\n");
+        return 1;
+    }
+
+#define EXTENT(M, A, D) (datatype == DB_DOUBLE ? ((double *) (M)->A)[D] : \
+                         (double) (M)->A[D])
+    for (d = 0; d < 3; d++)
+    {
+        err |= check_extent("point mesh min", d, EXTENT(pm, min_extents, d), rmin[d]);
+        err |= check_extent("point mesh max", d, EXTENT(pm, max_extents, d), rmax[d]);
+        err |= check_extent("ucd mesh min", d, EXTENT(um, min_extents, d), rmin[d]);
+        err |= check_extent("ucd mesh max", d, EXTENT(um, max_extents, d), rmax[d]);
+        err |= check_extent("quad mesh min", d, EXTENT(qm, min_extents, d), qmin[d]);
+        err |= check_extent("quad mesh max", d, EXTENT(qm, max_extents, d), qmax[d]);
+    }
+#undef EXTENT
+
+    DBFreePointmesh(pm);
+    DBFreeUcdmesh(um);
+    DBFreeQuadmesh(qm);
+    return err;
+}
+
+static double
+now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* Time the plain loop against the kernel, best of 5 */
+static void
+bench(void)
+{
+    long long i, n = 1<<24;
+    float *f = (float *) malloc((size_t) n * sizeof(float));
+    double *d = (double *) malloc((size_t) n * sizeof(double));
+    double t, tref[2] = {1e9, 1e9}, tker[2] = {1e9, 1e9};
+    float fmn, fmx;
+    double dmn, dmx;
+    int r;
+
+    for (i = 0; i < n; i++)
+        d[i] = f[i] = (float) (sin(i * 0.001) * (1 + i % 13));
+    for (r = 0; r < 5; r++)
+    {
+        t = now(); ref_float(f, n, &fmn, &fmx); t = now() - t;
+        tref[0] = t < tref[0] ? t : tref[0];
+        t = now(); DBCalcExtents(f, DB_FLOAT, n, &fmn, &fmx); t = now() - t;
+        tker[0] = t < tker[0] ? t : tker[0];
+        t = now(); ref_double(d, n, &dmn, &dmx); t = now() - t;
+        tref[1] = t < tref[1] ? t : tref[1];
+        t = now(); DBCalcExtents(d, DB_DOUBLE, n, &dmn, &dmx); t = now() - t;
+        tker[1] = t < tker[1] ? t : tker[1];
+    }
+    printf("%lld floats:  loop %.4f s, DBCalcExtents %.4f s\n", n, tref[0], tker[0]);
+    printf("%lld doubles: loop %.4f s, DBCalcExtents %.4f s\n", n, tref[1], tker[1]);
+    free(f);
+    free(d);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0;
+    int driver = DB_PDB;
+    int show_all_errors = FALSE;
+    int do_bench = FALSE;
+    char const *filename = "extents.silo";
+    DBfile *dbfile;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (!strcmp(argv[i], "bench")) {
+            do_bench = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (do_bench)
+    {
+        bench();
+        return 0;
+    }
+
+    /* The bad argument checks expect errors */
+    DBShowErrors(DB_NONE, 0);
+    err |= check_calc();
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_TOP, 0);
+
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "extents test", driver);
+    DBMkDir(dbfile, "float");
+    DBSetDir(dbfile, "float");
+    err |= check_meshes(dbfile, DB_FLOAT);
+    DBSetDir(dbfile, "/");
+    DBMkDir(dbfile, "double");
+    DBSetDir(dbfile, "double");
+    err |= check_meshes(dbfile, DB_DOUBLE);
+    DBClose(dbfile);
+
+    CleanupDriverStuff();
+    return err;
+}
@@ -1766,6 +1766,243 @@ double    v[1093];
 double    w[1093];
 double    t[1200];      /* Zone-centered */
 
+/***********************************************************************
+ *
+ * Purpose:  Calculate an external facelist with several thread
+ *           counts and check that they all produce the same facelist.
+ *
+ * Returns:  The number of external faces, or -1 if they differ.
+ *
+ **********************************************************************/
+static int
+check_threads(int *zonelist, int nnodes, int lo_off, int hi_off,
+    int *shapetype, int *shapesize, int *shapecnt, int nshapes,
+    int *matlist, int bnd_method)
+{
+    int             threads[3] = {2, 3, 5};
+    int             j, k, nfaces;
+    int             old_threads = DBGetThreads();
+    DBfacelist     *ref, *fl;
+
+    DBSetThreads(1);
+    ref = DBCalcExternalFacelist2(zonelist, nnodes, lo_off, hi_off, 0,
+              shapetype, shapesize, shapecnt, nshapes, matlist, bnd_method);
+    nfaces = ref->nfaces;
+
+    for (j = 0; j < 3; j++)
+    {
+        DBSetThreads(threads[j]);
+        fl = DBCalcExternalFacelist2(zonelist, nnodes, lo_off, hi_off, 0,
+                 shapetype, shapesize, shapecnt, nshapes, matlist,
+                 bnd_method);
+        if (fl->nfaces != ref->nfaces || fl->lnodelist != ref->lnodelist ||
+            fl->nshapes != ref->nshapes)
+            nfaces = -1;
+        for (k = 0; nfaces >= 0 && k < fl->nshapes; k++)
+            if (fl->shapesize[k] != ref->shapesize[k] ||
+                fl->shapecnt[k] != ref->shapecnt[k])
+                nfaces = -1;
+        if (nfaces > 0 &&
+            (memcmp(fl->nodelist, ref->nodelist, fl->lnodelist * sizeof(int)) ||
+             memcmp(fl->zoneno, ref->zoneno, fl->nfaces * sizeof(int))))
+            nfaces = -1;
+        if (nfaces < 0)
+            fprintf(stderr, "%d threads gave a different facelist\n",
+                threads[j]);
+        DBFreeFacelist(fl);
+    }
+
+    DBFreeFacelist(ref);
+    DBSetThreads(old_threads);
+    return nfaces;
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Make the zonelist of an n*n*n cube of hexes, with its
+ *           nodes numbered in order or, if shuffle is set, at random.
+ *           The bottom half of the zones is material 1 and the top
+ *           half material 2.
+ *
+ **********************************************************************/
+static void
+make_hexes(int n, int shuffle, int *zl, int *mat)
+{
+    int             N = n + 1;
+    int             i, j, k, z, t;
+    int            *perm = (int *) malloc(N * N * N * sizeof(int));
+
+    for (i = 0; i < N * N * N; i++)
+        perm[i] = i;
+    if (shuffle)
+    {
+        srand(1);
+        for (i = N * N * N - 1; i > 0; i--)
+        {
+            j = rand() % (i + 1);
+            t = perm[i]; perm[i] = perm[j]; perm[j] = t;
+        }
+    }
+
+#define NODE(I,J,K) perm[((K)*N+(J))*N+(I)]
+    for (k = 0, z = 0; k < n; k++)
+    for (j = 0; j < n; j++)
+    for (i = 0; i < n; i++, z += 8)
+    {
+        zl[z+0] = NODE(i,j,k);     zl[z+1] = NODE(i+1,j,k);
+        zl[z+2] = NODE(i+1,j+1,k); zl[z+3] = NODE(i,j+1,k);
+        zl[z+4] = NODE(i,j,k+1);   zl[z+5] = NODE(i+1,j,k+1);
+        zl[z+6] = NODE(i+1,j+1,k+1); zl[z+7] = NODE(i,j+1,k+1);
+        mat[z/8] = k < n / 2 ? 1 : 2;
+    }
+#undef NODE
+    free(perm);
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Check the external facelists of an n*n*n cube of hexes,
+ *           of the same cube made of polyhedra, each two hexes long,
+ *           whose sides have six nodes, and of three copies of the
+ *           hexes, the second with the materials swapped, whose faces
+ *           are matched in the order they are made.
+ *
+ * Returns:  0 on success, 1 on failure.
+ *
+ **********************************************************************/
+static int
+check_cube(int n)
+{
+    int             N = n + 1;
+    int             nzones = n * n * n;
+    int             i, j, k, z, err = 0;
+    int            *zl, *pzl, *mat, *zl3, *mat3, nfaces;
+    int             nzones3 = 3 * nzones;
+    int             hextype = DB_ZONETYPE_HEX, hexsize = 8;
+    int             phtype = DB_ZONETYPE_POLYHEDRON, phsize, phcnt = nzones / 2;
+
+    zl = (int *) malloc(8 * nzones * sizeof(int));
+    mat = (int *) malloc(nzones * sizeof(int));
+    make_hexes(n, 0, zl, mat);
+
+    /* no ghosts, then a layer of ghost zones at each end */
+    if (check_threads(zl, N*N*N, 0, 0, &hextype, &hexsize, &nzones, 1,
+                      mat, 0) != 6 * n * n)
+        err = 1;
+    if (check_threads(zl, N*N*N, n*n, n*n, &hextype, &hexsize, &nzones, 1,
+                      mat, 0) != 4 * n * n - 8 * n)
+        err = 1;
+    if (check_threads(zl, N*N*N, 0, 0, &hextype, &hexsize, &nzones, 1,
+                      mat, 1) != 6 * n * n + 2 * n * n)
+        err = 1;
+
+    /* three copies of the hexes */
+    zl3 = (int *) malloc(3 * 8 * nzones * sizeof(int));
+    mat3 = (int *) malloc(3 * nzones * sizeof(int));
+    for (i = 0; i < 3; i++)
+    {
+        memcpy(&zl3[i * 8 * nzones], zl, 8 * nzones * sizeof(int));
+        for (z = 0; z < nzones; z++)
+            mat3[i * nzones + z] = i == 1 ? 3 - mat[z] : mat[z];
+    }
+    if (check_threads(zl3, N*N*N, 0, 0, &hextype, &hexsize, &nzones3, 1,
+                      mat3, 0) < 0 ||
+        check_threads(zl3, N*N*N, 0, 0, &hextype, &hexsize, &nzones3, 1,
+                      mat3, 1) < 0)
+        err = 1;
+    free(zl3);
+    free(mat3);
+
+    /* polyhedra two hexes long in i, n must be even */
+#define NODE(I,J,K) (((K)*N+(J))*N+(I))
+    phsize = 1 + 2 * 5 + 4 * 7;
+    pzl = (int *) malloc(phsize * phcnt * sizeof(int));
+    for (k = 0, z = 0; k < n; k++)
+    for (j = 0; j < n; j++)
+    for (i = 0; i < n; i += 2)
+    {
+        pzl[z++] = 6;
+        pzl[z++] = 4; /* low i */
+        pzl[z++] = NODE(i,j,k);   pzl[z++] = NODE(i,j,k+1);
+        pzl[z++] = NODE(i,j+1,k+1); pzl[z++] = NODE(i,j+1,k);
+        pzl[z++] = 4; /* high i */
+        pzl[z++] = NODE(i+2,j,k); pzl[z++] = NODE(i+2,j+1,k);
+        pzl[z++] = NODE(i+2,j+1,k+1); pzl[z++] = NODE(i+2,j,k+1);
+        pzl[z++] = 6; /* low j */
+        pzl[z++] = NODE(i,j,k);   pzl[z++] = NODE(i+1,j,k);
+        pzl[z++] = NODE(i+2,j,k); pzl[z++] = NODE(i+2,j,k+1);
+        pzl[z++] = NODE(i+1,j,k+1); pzl[z++] = NODE(i,j,k+1);
+        pzl[z++] = 6; /* high j */
+        pzl[z++] = NODE(i,j+1,k); pzl[z++] = NODE(i,j+1,k+1);
+        pzl[z++] = NODE(i+1,j+1,k+1); pzl[z++] = NODE(i+2,j+1,k+1);
+        pzl[z++] = NODE(i+2,j+1,k); pzl[z++] = NODE(i+1,j+1,k);
+        pzl[z++] = 6; /* low k */
+        pzl[z++] = NODE(i,j,k);   pzl[z++] = NODE(i,j+1,k);
+        pzl[z++] = NODE(i+1,j+1,k); pzl[z++] = NODE(i+2,j+1,k);
+        pzl[z++] = NODE(i+2,j,k); pzl[z++] = NODE(i+1,j,k);
+        pzl[z++] = 6; /* high k */
+        pzl[z++] = NODE(i,j,k+1); pzl[z++] = NODE(i+1,j,k+1);
+        pzl[z++] = NODE(i+2,j,k+1); pzl[z++] = NODE(i+2,j+1,k+1);
+        pzl[z++] = NODE(i+1,j+1,k+1); pzl[z++] = NODE(i,j+1,k+1);
+    }
+#undef NODE
+    nfaces = check_threads(pzl, N*N*N, 0, 0, &phtype, &phsize, &phcnt, 1,
+                           NULL, 0);
+    if (nfaces != 2 * n * n + 4 * n * n / 2)
+        err = 1;
+
+    free(zl);
+    free(pzl);
+    free(mat);
+    return err;
+}
+
+/***********************************************************************
+ *
+ * Purpose:  Time DBCalcExternalFacelist2 on a 120*120*120 cube of hexes
+ *           for each node numbering, boundary method and thread count,
+ *           best of 3.
+ *
+ **********************************************************************/
+static void
+bench(void)
+{
+    int             n = 120, N = n + 1, nzones = n * n * n;
+    int             hextype = DB_ZONETYPE_HEX, hexsize = 8;
+    int             threads[2] = {1, 4};
+    int             shuffle, bnd, m, r;
+    int            *zl = (int *) malloc(8 * nzones * sizeof(int));
+    int            *mat = (int *) malloc(nzones * sizeof(int));
+    double          t, best;
+    DBfacelist     *fl;
+
+    for (shuffle = 0; shuffle < 2; shuffle++)
+    {
+        make_hexes(n, shuffle, zl, mat);
+        for (bnd = 0; bnd < 2; bnd++)
+        {
+            for (m = 0; m < 2; m++)
+            {
+                DBSetThreads(threads[m]);
+                for (r = 0, best = 1e9; r < 3; r++)
+                {
+                    t = GetTime();
+                    fl = DBCalcExternalFacelist2(zl, N*N*N, 0, 0, 0,
+                             &hextype, &hexsize, &nzones, 1, mat, bnd);
+                    t = (GetTime() - t) * 1e-6;
+                    best = t < best ? t : best;
+                    DBFreeFacelist(fl);
+                }
+                printf("%s nodes, bnd %d, %d threads: %.3f s\n",
+                    shuffle ? "shuffled" : "sequential", bnd, threads[m],
+                    best);
+            }
+        }
+    }
+    free(zl);
+    free(mat);
+}
+
 /***********************************************************************
  *
  * Purpose:  Test the DBCalcExternalFacelist routine with all the
@@ -1798,6 +2035,9 @@ double    t[1200];      /* Zone-centered */
  *    Jeremy Meredith, Thu Mar 23 13:25:12 PST 2000
  *    The prisms were backwards.  I flipped them (above in the nodelist).
  *
+ *    The `bench' argument times DBCalcExternalFacelist2 on a large
+ *    cube of hexes instead of running the test.
+ *
  **********************************************************************/
 int
 main(int argc, char *argv[])
@@ -1825,6 +2065,7 @@ main(int argc, char *argv[])
     char	   *filename = "globe.pdb";
     int		    driver = DB_PDB;
     int             show_all_errors = FALSE;
+    int             do_bench = FALSE;
     char **matnames;
 
     /* Parse command-line */
@@ -1837,6 +2078,8 @@ main(int argc, char *argv[])
 	    filename = "globe.h5";
         } else if (!strcmp(argv[i], "show-all-errors")) {
             show_all_errors = 1;
+        } else if (!strcmp(argv[i], "bench")) {
+            do_bench = 1;
 	} else if (argv[i][0] != '\0') {
 	    fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
 	}
@@ -1844,6 +2087,12 @@ main(int argc, char *argv[])
     
     if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
 
+    if (do_bench)
+    {
+        bench();
+        return 0;
+    }
+
     DBSetDeprecateWarnings(0);
     printf("Creating test file \"%s\".\n", filename);
     dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL,
@@ -1918,6 +2167,25 @@ main(int argc, char *argv[])
 
     DBFreeFacelist(fl);
 
+    /*
+     * Check that every thread count gives the same facelist.
+     */
+    {
+        int zshapetype[4] = {DB_ZONETYPE_TET, DB_ZONETYPE_PRISM,
+                             DB_ZONETYPE_PYRAMID, DB_ZONETYPE_HEX};
+        if (check_threads(znodelist, nnodes, 0, 0, zshapetype, zshapesize,
+                          zshapecnt, nzshapes, matlist, 0) < 0 ||
+            check_threads(znodelist, nnodes, 0, 0, zshapetype, zshapesize,
+                          zshapecnt, nzshapes, matlist, 1) < 0 ||
+            check_threads(znodelist, nnodes, 40, 100, zshapetype, zshapesize,
+                          zshapecnt, nzshapes, matlist, 1) < 0 ||
+            check_cube(42))
+        {
+            fprintf(stderr, "external facelists differ with the thread count\n");
+            exit(1);
+        }
+    }
+
     coords[0] = coord0;
     coords[1] = coord1;
     coords[2] = coord2;
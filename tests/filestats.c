@@ -0,0 +1,216 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Exercises DBSetFileStats, DBGetFileStats and DBGetGlobalFileStats: bytes
+   written and read through the driver, per-call timings keyed by object
+   type and the totals that survive DBClose. */
+
+#define NX 10
+
+static DBcallstats const *
+find_call(DBfilestats const *stats, char const *name)
+{
+    int i;
+    for (i = 0; i < stats->ncalls; i++)
+        if (!strcmp(stats->calls[i].name, name))
+            return &stats->calls[i];
+    return 0;
+}
+
+static int
+check_call(DBfilestats const *stats, char const *name, int objtype,
+    long long ncalls)
+{
+    DBcallstats const *c = find_call(stats, name);
+    if (!c)
+    {
+        fprintf(stderr, "no stats for %s\n", name);
+        return 1;
+    }
+    if (c->objtype != objtype || c->ncalls != ncalls || c->time < 0)
+    {
+        fprintf(stderr, "%s: objtype %d, %lld calls, %g seconds\n", name,
+            c->objtype, c->ncalls, c->time);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0, driver = DB_PDB;
+    int show_all_errors = FALSE;
+    char const *filename = "filestats.pdb";
+    float x[NX], y[NX], v[(NX-1)*(NX-1)];
+    float *coords[2] = {x, y};
+    int dims[2] = {NX, NX}, zdims[2] = {NX-1, NX-1}, one = NX;
+    long long written;
+    DBfilestats stats, global;
+    DBquadvar *qv;
+    DBfile *dbfile;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "filestats.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "filestats.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    for (i = 0; i < NX; i++) x[i] = y[i] = (float) i;
+    for (i = 0; i < (NX-1)*(NX-1); i++) v[i] = (float) i;
+
+    /* Nothing is counted until statistics are turned on */
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "file stats test", driver);
+    DBWrite(dbfile, "raw", x, &one, 1, DB_FLOAT);
+    DBGetFileStats(dbfile, &stats);
+    if (stats.nwrites != 0 || stats.ncalls != 0)
+    {
+        fprintf(stderr, "counted %lld writes and %d calls while off\n",
+            stats.nwrites, stats.ncalls);
+        err = 1;
+    }
+    DBClose(dbfile);
+    if (DBSetFileStats(1) != 0)
+    {
+        fprintf(stderr, "file stats were on by default\n");
+        err = 1;
+    }
+
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "file stats test", driver);
+    DBPutQuadmesh(dbfile, "mesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "pressure", "mesh", v, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBWrite(dbfile, "raw", x, &one, 1, DB_FLOAT);
+    DBWrite(dbfile, "raw2", y, &one, 1, DB_FLOAT);
+
+    if (DBGetFileStats(dbfile, &stats) != 0)
+    {
+        fprintf(stderr, "DBGetFileStats failed\n");
+        return 1;
+    }
+    if (stats.nwrites <= 0 || stats.nbytes_written < (long long) sizeof(v))
+    {
+        fprintf(stderr, "%lld writes of %lld bytes\n", stats.nwrites,
+            stats.nbytes_written);
+        err = 1;
+    }
+    err |= check_call(&stats, "DBCreate", DB_INVALID_OBJECT, 1);
+    err |= check_call(&stats, "DBPutQuadmesh", DB_QUADMESH, 1);
+    err |= check_call(&stats, "DBPutQuadvar1", DB_QUADVAR, 1);
+    err |= check_call(&stats, "DBWrite", DB_INVALID_OBJECT, 2);
+    DBClose(dbfile);
+
+    /* The closed file's counts are kept in the global totals */
+    DBGetGlobalFileStats(&global);
+    written = global.nbytes_written;
+    if (written < stats.nbytes_written || !find_call(&global, "DBPutQuadvar1"))
+    {
+        fprintf(stderr, "global stats lost %s\n", filename);
+        err = 1;
+    }
+
+    dbfile = DBOpen(filename, driver, DB_READ);
+    for (i = 0; i < 2; i++)
+    {
+        qv = DBGetQuadvar(dbfile, "pressure");
+        if (!qv || qv->nels != (NX-1)*(NX-1) || ((float*)qv->vals[0])[5] != 5)
+        {
+            fprintf(stderr, "bad quadvar\n");
+            err = 1;
+        }
+        DBFreeQuadvar(qv);
+    }
+    DBGetFileStats(dbfile, &stats);
+    if (stats.nreads <= 0 || stats.nbytes_read < (long long) sizeof(v) ||
+        stats.nbytes_meta_read <= 0 || stats.nbytes_written != 0)
+    {
+        fprintf(stderr, "%lld reads of %lld bytes (%lld meta), %lld written\n",
+            stats.nreads, stats.nbytes_read, stats.nbytes_meta_read,
+            stats.nbytes_written);
+        err = 1;
+    }
+    err |= check_call(&stats, "DBGetQuadvar", DB_QUADVAR, 2);
+
+    /* PDB answers the second read of the header from its object cache */
+    if ((driver&0xF) == DB_PDB && stats.ncache_hits <= 0)
+    {
+        fprintf(stderr, "%lld cache hits\n", stats.ncache_hits);
+        err = 1;
+    }
+    DBClose(dbfile);
+
+    DBGetGlobalFileStats(&global);
+    if (global.nbytes_written != written ||
+        global.nbytes_read < stats.nbytes_read)
+    {
+        fprintf(stderr, "global stats: %lld bytes written, %lld read\n",
+            global.nbytes_written, global.nbytes_read);
+        err = 1;
+    }
+
+    CleanupDriverStuff();
+    return err;
+}
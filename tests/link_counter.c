@@ -0,0 +1,243 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#ifdef HAVE_HDF5_H
+#define H5_USE_16_API
+#include "hdf5.h"
+#endif
+
+#include <std.c>
+
+/*
+ * Datasets that HDF5 files keep in the /.silo link group are named from
+ * a counter saved in its `nlinks' attribute. Check that the counter is
+ * saved at flush and close, that it carries across appends and that
+ * names keep working past 999999 and past the range of an int.
+ */
+
+#define NCURVES 10
+#define NPTS 7
+
+static void
+put_curves(DBfile *dbfile, int first)
+{
+    float x[NPTS], y[NPTS];
+    char name[32];
+    int i, j;
+
+    for (i = first; i < first + NCURVES; i++)
+    {
+        for (j = 0; j < NPTS; j++)
+        {
+            x[j] = (float) j;
+            y[j] = (float) (i * 100 + j);
+        }
+        sprintf(name, "curve_%d", i);
+        DBPutCurve(dbfile, name, x, y, DB_FLOAT, NPTS, 0);
+    }
+}
+
+static int
+check_curves(DBfile *dbfile, int ncurves)
+{
+    int i, j, err = 0;
+
+    for (i = 0; i < ncurves && !err; i++)
+    {
+        char name[32];
+        DBcurve *c;
+
+        sprintf(name, "curve_%d", i);
+        if ((c = DBGetCurve(dbfile, name)) == 0 || c->npts != NPTS)
+        {
+            fprintf(stderr, "can't read %s\n", name);
+            err = 1;
+        }
+        for (j = 0; !err && j < NPTS; j++)
+        {
+            if (((float*)c->y)[j] != (float) (i * 100 + j))
+            {
+                fprintf(stderr, "%s has wrong values\n", name);
+                err = 1;
+            }
+        }
+        DBFreeCurve(c);
+    }
+    return err;
+}
+
+#ifdef HAVE_HDF5_H
+/* Read, and optionally replace, the counter with HDF5 directly */
+static long long
+counter_attr(hid_t fid, long long newval, size_t *attr_size)
+{
+    long long val = -1;
+    hid_t grp, attr, atype;
+
+    if ((grp = H5Gopen(fid, "/.silo")) >= 0)
+    {
+        if ((attr = H5Aopen_name(grp, "nlinks")) >= 0)
+        {
+            atype = H5Aget_type(attr);
+            if (attr_size) *attr_size = H5Tget_size(atype);
+            H5Tclose(atype);
+            if (H5Aread(attr, H5T_NATIVE_LLONG, &val) < 0)
+                val = -1;
+            if (newval >= 0 && H5Awrite(attr, H5T_NATIVE_LLONG, &newval) < 0)
+                val = -1;
+            H5Aclose(attr);
+        }
+        H5Gclose(grp);
+    }
+    return val;
+}
+
+static long long
+link_counter(char const *filename, long long newval, size_t *attr_size)
+{
+    long long val = -1;
+    hid_t fid;
+
+    if ((fid = H5Fopen(filename, newval < 0 ? H5F_ACC_RDONLY : H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
+        return -1;
+    val = counter_attr(fid, newval, attr_size);
+    H5Fclose(fid);
+    return val;
+}
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0;
+    int show_all_errors = FALSE;
+    char const *filename = "link_counter.h5";
+    DBfile *dbfile;
+#ifdef HAVE_HDF5_H
+    long long val;
+    size_t attr_size = 0;
+#endif
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            fprintf(stderr, "The link counter applies only to the HDF5 driver; skipping\n");
+            return 77;
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            continue;
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+#ifndef HAVE_HDF5_H
+    return 77;
+#else
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    /* Each curve uses two names. The counter is saved by DBFlush. */
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "link counter test", DB_HDF5);
+    put_curves(dbfile, 0);
+    DBFlush(dbfile);
+    val = counter_attr(*((hid_t*)DBGrabDriver(dbfile)), -1, 0);
+    DBUngrabDriver(dbfile, 0);
+    if (val != 2 * NCURVES)
+    {
+        fprintf(stderr, "counter is %lld after flush, expected %d\n", val, 2 * NCURVES);
+        err = 1;
+    }
+    put_curves(dbfile, NCURVES);
+    DBClose(dbfile);
+    if ((val = link_counter(filename, -1, 0)) != 4 * NCURVES)
+    {
+        fprintf(stderr, "counter is %lld after close, expected %d\n", val, 4 * NCURVES);
+        err = 1;
+    }
+
+    /* Names past six digits */
+    link_counter(filename, 999995, 0);
+    dbfile = DBOpen(filename, DB_HDF5, DB_APPEND);
+    put_curves(dbfile, 2 * NCURVES);
+    DBClose(dbfile);
+    if ((val = link_counter(filename, -1, 0)) != 999995 + 2 * NCURVES)
+    {
+        fprintf(stderr, "counter is %lld, expected %d\n", val, 999995 + 2 * NCURVES);
+        err = 1;
+    }
+
+    /* Counters that do not fit in the original int attribute */
+    link_counter(filename, 2147483640, 0);
+    dbfile = DBOpen(filename, DB_HDF5, DB_APPEND);
+    put_curves(dbfile, 3 * NCURVES);
+    DBClose(dbfile);
+    if ((val = link_counter(filename, -1, &attr_size)) != 2147483640LL + 2 * NCURVES ||
+        attr_size != sizeof(long long))
+    {
+        fprintf(stderr, "counter is %lld in %d bytes, expected %lld in %d\n", val,
+            (int) attr_size, 2147483640LL + 2 * NCURVES, (int) sizeof(long long));
+        err = 1;
+    }
+
+    dbfile = DBOpen(filename, DB_HDF5, DB_READ);
+    err |= check_curves(dbfile, 4 * NCURVES);
+    DBClose(dbfile);
+
+    CleanupDriverStuff();
+    return err;
+#endif
+}
@@ -0,0 +1,163 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <std.c>
+
+/* Holds more than DB_NFILES files open at once and checks that the
+   registry still finds every one of them: concurrent reads of the same
+   file are allowed while a write open of a file already open fails. */
+
+#define NF (DB_NFILES+44)
+
+int
+main(int argc, char *argv[])
+{
+    int i, n, one = 1, err = 0, driver = DB_PDB;
+    int show_all_errors = FALSE;
+    char const *ext = "pdb";
+    char filename[64];
+    DBfile **dbfiles = (DBfile **) calloc(NF, sizeof(DBfile *));
+    DBfile *dbfile, *dbfile2;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            ext = "pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            ext = "h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    /* Create all the files, holding each of them open */
+    for (i = 0; i < NF; i++)
+    {
+        sprintf(filename, "manyfiles%03d.%s", i, ext);
+        dbfiles[i] = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "manyfiles test", driver);
+        if (!dbfiles[i])
+        {
+            fprintf(stderr, "DBCreate failed for file %d\n", i);
+            return 1;
+        }
+        DBWrite(dbfiles[i], "n", &i, &one, 1, DB_INT);
+    }
+
+    /* Each open file is already registered for writing */
+    DBShowErrors(DB_NONE, 0);
+    for (i = 0; i < NF; i += 37)
+    {
+        sprintf(filename, "manyfiles%03d.%s", i, ext);
+        if ((dbfile = DBOpen(filename, driver, DB_READ)) != 0)
+        {
+            fprintf(stderr, "opened file %d while it was open for writing\n", i);
+            DBClose(dbfile);
+            err = 1;
+        }
+    }
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_TOP, 0);
+
+    for (i = 0; i < NF; i++)
+        DBClose(dbfiles[i]);
+
+    /* Reopen them all for reading, one file twice */
+    for (i = 0; i < NF; i++)
+    {
+        sprintf(filename, "manyfiles%03d.%s", i, ext);
+        dbfiles[i] = DBOpen(filename, driver, DB_READ);
+        n = -1;
+        if (!dbfiles[i] || DBReadVar(dbfiles[i], "n", &n) != 0 || n != i)
+        {
+            fprintf(stderr, "reading file %d failed\n", i);
+            err = 1;
+        }
+    }
+    sprintf(filename, "manyfiles%03d.%s", NF-1, ext);
+    if ((dbfile = DBOpen(filename, driver, DB_READ)) == 0)
+    {
+        fprintf(stderr, "second read open failed\n");
+        err = 1;
+    }
+
+    /* A write open of a file open for reading must fail */
+    DBShowErrors(DB_NONE, 0);
+    if ((dbfile2 = DBOpen(filename, driver, DB_APPEND)) != 0)
+    {
+        fprintf(stderr, "opened a file for append while it was open for reading\n");
+        DBClose(dbfile2);
+        err = 1;
+    }
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_TOP, 0);
+
+    if (dbfile) DBClose(dbfile);
+    for (i = 0; i < NF; i++)
+    {
+        if (dbfiles[i]) DBClose(dbfiles[i]);
+        sprintf(filename, "manyfiles%03d.%s", i, ext);
+        unlink(filename);
+    }
+
+    free(dbfiles);
+    CleanupDriverStuff();
+    return err;
+}
@@ -0,0 +1,504 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <std.c>
+
+/*
+ * Check the conversions among dense volume fraction arrays, DBmaterial
+ * and DBmatcsr against the dense arrays they start from, with float and
+ * double fractions, with material numbers in a small and a large range
+ * and with 1 and 4 threads. Then check a material written to and read
+ * back from a file converts to the same DBmatcsr. The `bench' argument
+ * times the conversions on a larger mesh.
+ */
+
+#define NX 50
+#define NY 60
+#define NZ 50
+#define NMAT 7
+#define EMPTY 4   /* material index with no zones, whose array is NULL */
+
+static int const small_matnos[NMAT] = {3, 11, 5, 100, 2, 7, 9};
+static int const large_matnos[NMAT] = {3, 1100000, 5, 70000, 2, 7, 9};
+
+/* Fill NMAT dense arrays of NZONES fractions. A quarter of the zones
+   hold three materials, a quarter two and half are clean. */
+static void
+make_dense(int nzones, double **vf)
+{
+    static int const avail[NMAT-1] = {0, 1, 2, 3, 5, 6};
+    unsigned int r = 12345;
+    int z, m, a;
+
+    for (m = 0; m < NMAT; m++)
+        vf[m] = m == EMPTY ? 0 : (double *) calloc(nzones, sizeof(double));
+    for (z = 0; z < nzones; z++)
+    {
+        r = r * 1103515245 + 12345;
+        a = (r >> 8) % (NMAT-1);
+        switch ((r >> 20) % 4)
+        {
+            case 0:
+            case 1:
+                vf[avail[a]][z] = 1;
+                break;
+            case 2:
+                vf[avail[a]][z] = 0.25;
+                vf[avail[(a+3)%(NMAT-1)]][z] = 0.75;
+                break;
+            case 3:
+                vf[avail[a]][z] = 0.5;
+                vf[avail[(a+1)%(NMAT-1)]][z] = 0.25;
+                vf[avail[(a+5)%(NMAT-1)]][z] = 0.25;
+                break;
+        }
+    }
+}
+
+static double
+frac(void const *vfracs, int dtype, int i)
+{
+    if (dtype == DB_FLOAT)
+        return ((float const *) vfracs)[i];
+    return ((double const *) vfracs)[i];
+}
+
+/* The entries of each zone are its nonzero fractions in array order */
+static int
+check_csr(DBmatcsr const *csr, int nzones, double **vf, int const *matnos)
+{
+    int z, m, k;
+
+    if (!csr || csr->nzones != nzones || csr->nmat != NMAT || csr->offsets[0] != 0)
+        return 1;
+    for (z = 0; z < nzones; z++)
+    {
+        k = csr->offsets[z];
+        for (m = 0; m < NMAT; m++)
+        {
+            if (!vf[m] || vf[m][z] == 0)
+                continue;
+            if (k >= csr->offsets[z+1] || csr->mats[k] != matnos[m] ||
+                frac(csr->vfracs, csr->datatype, k) != vf[m][z])
+            {
+                fprintf(stderr, "csr zone %d is wrong\n", z);
+                return 1;
+            }
+            k++;
+        }
+        if (k != csr->offsets[z+1])
+        {
+            fprintf(stderr, "csr zone %d has extra entries\n", z);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Clean zones of MAT are single entries of CSR with a fraction of 1 and
+   the mix_next chains of mixed zones hold the entries of CSR in order */
+static int
+check_mat(DBmaterial const *mat, DBmatcsr const *csr)
+{
+    int z, k, mix, nmix = 0;
+
+    if (!mat)
+        return 1;
+    for (z = 0; z < csr->nzones; z++)
+    {
+        k = csr->offsets[z];
+        if (mat->matlist[z] >= 0)
+        {
+            if (csr->offsets[z+1] != k + 1 || csr->mats[k] != mat->matlist[z] ||
+                frac(csr->vfracs, csr->datatype, k) != 1)
+            {
+                fprintf(stderr, "material zone %d is wrong\n", z);
+                return 1;
+            }
+            continue;
+        }
+        for (mix = -mat->matlist[z] - 1; mix >= 0; mix = mat->mix_next[mix] - 1, k++)
+        {
+            if (k >= csr->offsets[z+1] || mat->mix_mat[mix] != csr->mats[k] ||
+                mat->mix_zone[mix] != z + 1 ||
+                frac(mat->mix_vf, mat->datatype, mix) != frac(csr->vfracs, csr->datatype, k))
+            {
+                fprintf(stderr, "material mixed zone %d is wrong\n", z);
+                return 1;
+            }
+            nmix++;
+        }
+        if (k != csr->offsets[z+1])
+        {
+            fprintf(stderr, "material mixed zone %d is short\n", z);
+            return 1;
+        }
+    }
+    if (nmix != mat->mixlen)
+    {
+        fprintf(stderr, "mixlen %d, expected %d\n", mat->mixlen, nmix);
+        return 1;
+    }
+    return 0;
+}
+
+static int
+check_dense(int status, int narrs, void **arrs, int dtype, int nzones, double **vf)
+{
+    int z, m, err = 0;
+
+    if (status != 0 || narrs != NMAT)
+        return 1;
+    for (m = 0; m < NMAT; m++)
+    {
+        for (z = 0; z < nzones && !err; z++)
+        {
+            if (frac(arrs[m], dtype, z) != (vf[m] ? vf[m][z] : 0))
+            {
+                fprintf(stderr, "dense array %d zone %d is wrong\n", m, z);
+                err = 1;
+            }
+        }
+        free(arrs[m]);
+    }
+    free(arrs);
+    return err;
+}
+
+static int
+same_csr(DBmatcsr const *a, DBmatcsr const *b)
+{
+    size_t size = a->datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+    int nnz = a->offsets[a->nzones];
+
+    return b && a->nzones == b->nzones && a->datatype == b->datatype &&
+        !memcmp(a->offsets, b->offsets, (a->nzones + 1) * sizeof(int)) &&
+        !memcmp(a->mats, b->mats, nnz * sizeof(int)) &&
+        !memcmp(a->vfracs, b->vfracs, nnz * size);
+}
+
+static int
+same_mat(DBmaterial const *a, DBmaterial const *b, int nzones)
+{
+    size_t size = a->datatype == DB_FLOAT ? sizeof(float) : sizeof(double);
+
+    return b && a->mixlen == b->mixlen && a->datatype == b->datatype &&
+        !memcmp(a->matlist, b->matlist, nzones * sizeof(int)) &&
+        !memcmp(a->mix_mat, b->mix_mat, a->mixlen * sizeof(int)) &&
+        !memcmp(a->mix_next, b->mix_next, a->mixlen * sizeof(int)) &&
+        !memcmp(a->mix_zone, b->mix_zone, a->mixlen * sizeof(int)) &&
+        !memcmp(a->mix_vf, b->mix_vf, a->mixlen * size);
+}
+
+/* Make the dense arrays of DTYPE from the doubles in VF */
+static void **
+typed_dense(double **vf, int nzones, int dtype)
+{
+    void **arrs = (void **) calloc(NMAT, sizeof(void *));
+    int m, z;
+
+    for (m = 0; m < NMAT; m++)
+    {
+        if (!vf[m] || dtype == DB_DOUBLE)
+        {
+            arrs[m] = vf[m];
+            continue;
+        }
+        arrs[m] = malloc(nzones * sizeof(float));
+        for (z = 0; z < nzones; z++)
+            ((float *) arrs[m])[z] = (float) vf[m][z];
+    }
+    return arrs;
+}
+
+static void
+free_typed_dense(void **arrs, int dtype)
+{
+    int m;
+
+    for (m = 0; m < NMAT && dtype == DB_FLOAT; m++)
+        free(arrs[m]);
+    free(arrs);
+}
+
+static int
+check_conversions(double **vf, int const *dims, int const *matnos)
+{
+    int nzones = dims[0] * dims[1] * dims[2];
+    int err = 0, d, t, narrs, status;
+    void **arrs, **dense;
+    DBmatcsr *csr, *csr1 = 0, *csr2;
+    DBmaterial *mat, *mat2;
+
+    for (d = 0; d < 2; d++)
+    {
+        int dtype = d ? DB_DOUBLE : DB_FLOAT;
+        int otype = d ? DB_FLOAT : DB_DOUBLE;
+
+        arrs = typed_dense(vf, nzones, dtype);
+        for (t = 1; t <= 4; t *= 4)
+        {
+            DBSetThreads(t);
+            csr = DBCalcMatcsrFromDenseArrays(NMAT, 3, dims, matnos, dtype, (DBVCP2_t) arrs);
+            if (check_csr(csr, nzones, vf, matnos))
+            {
+                fprintf(stderr, "DBCalcMatcsrFromDenseArrays failed, %d threads\n", t);
+                err = 1;
+                continue;
+            }
+            if (csr1 && !same_csr(csr1, csr))
+            {
+                fprintf(stderr, "csr differs with %d threads\n", t);
+                err = 1;
+            }
+
+            mat = DBCalcMaterialFromDenseArrays(NMAT, 3, dims, matnos, dtype, (DBVCP2_t) arrs);
+            mat2 = DBCalcMaterialFromMatcsr(csr);
+            if (check_mat(mat, csr) || !same_mat(mat, mat2, nzones))
+            {
+                fprintf(stderr, "material conversions failed, %d threads\n", t);
+                err = 1;
+            }
+
+            csr2 = DBCalcMatcsrFromMaterial(mat);
+            if (!same_csr(csr, csr2))
+            {
+                fprintf(stderr, "DBCalcMatcsrFromMaterial failed, %d threads\n", t);
+                err = 1;
+            }
+
+            status = DBCalcDenseArraysFromMaterial(mat, otype, &narrs, &dense);
+            err |= check_dense(status, narrs, dense, otype, nzones, vf);
+            status = DBCalcDenseArraysFromMatcsr(csr, dtype, &narrs, &dense);
+            err |= check_dense(status, narrs, dense, dtype, nzones, vf);
+
+            DBFreeMatcsr(csr2);
+            DBFreeMaterial(mat);
+            DBFreeMaterial(mat2);
+            if (csr1)
+                DBFreeMatcsr(csr);
+            else
+                csr1 = csr;
+        }
+        DBFreeMatcsr(csr1);
+        csr1 = 0;
+        free_typed_dense(arrs, dtype);
+    }
+    DBSetThreads(1);
+    return err;
+}
+
+static int
+check_bad_args(double **vf, int const *dims)
+{
+    int narrs;
+    void **dense;
+    DBmaterial mat;
+
+    memset(&mat, 0, sizeof(mat));
+    if (DBCalcMatcsrFromDenseArrays(NMAT, 3, dims, small_matnos, DB_INT, (DBVCP2_t) vf) ||
+        DBCalcMaterialFromDenseArrays(NMAT, 3, dims, small_matnos, DB_INT, (DBVCP2_t) vf) ||
+        DBCalcMatcsrFromDenseArrays(0, 3, dims, small_matnos, DB_DOUBLE, (DBVCP2_t) vf) ||
+        DBCalcMatcsrFromMaterial(&mat) || DBCalcMaterialFromMatcsr(0) ||
+        DBCalcDenseArraysFromMatcsr(0, DB_FLOAT, &narrs, &dense) != -1 ||
+        DBSetThreads(0) != -1 || DBGetThreads() != 1)
+    {
+        fprintf(stderr, "bad arguments are not caught\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* A material written and read back converts to the same CSR */
+static int
+check_file(double **vf, int const *dims, char const *filename, int driver)
+{
+    int err = 0;
+    DBfile *dbfile;
+    DBmaterial *mat, *rmat;
+    DBmatcsr *csr, *rcsr;
+
+    mat = DBCalcMaterialFromDenseArrays(NMAT, 3, dims, small_matnos, DB_DOUBLE, (DBVCP2_t) vf);
+    csr = DBCalcMatcsrFromMaterial(mat);
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "matcsr test", driver);
+    DBPutMaterial(dbfile, "mat", "mesh", mat->nmat, mat->matnos, mat->matlist,
+        mat->dims, mat->ndims, mat->mix_next, mat->mix_mat, mat->mix_zone,
+        mat->mix_vf, mat->mixlen, mat->datatype, 0);
+    DBClose(dbfile);
+
+    dbfile = DBOpen(filename, driver, DB_READ);
+    rmat = DBGetMaterial(dbfile, "mat");
+    rcsr = rmat ? DBCalcMatcsrFromMaterial(rmat) : 0;
+    if (!rcsr || !same_csr(csr, rcsr))
+    {
+        fprintf(stderr, "material read back from file converts differently\n");
+        err = 1;
+    }
+    DBClose(dbfile);
+
+    DBFreeMaterial(mat);
+    DBFreeMaterial(rmat);
+    DBFreeMatcsr(csr);
+    DBFreeMatcsr(rcsr);
+    return err;
+}
+
+static double
+seconds(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void
+bench(void)
+{
+    int dims[3] = {200, 200, 200}, nzones = 200 * 200 * 200;
+    int m, t, narrs;
+    double *vf[NMAT], t0;
+    void **dense;
+    DBmatcsr *csr;
+    DBmaterial *mat;
+
+    make_dense(nzones, vf);
+    for (t = 1; t <= 4; t *= 4)
+    {
+        DBSetThreads(t);
+        printf("%d zones, %d thread(s)\n", nzones, t);
+        t0 = seconds();
+        mat = DBCalcMaterialFromDenseArrays(NMAT, 3, dims, small_matnos, DB_DOUBLE, (DBVCP2_t) vf);
+        printf("  DBCalcMaterialFromDenseArrays %.4f s\n", seconds() - t0);
+        t0 = seconds();
+        DBCalcDenseArraysFromMaterial(mat, DB_DOUBLE, &narrs, &dense);
+        printf("  DBCalcDenseArraysFromMaterial %.4f s\n", seconds() - t0);
+        for (m = 0; m < narrs; m++)
+            free(dense[m]);
+        free(dense);
+        t0 = seconds();
+        csr = DBCalcMatcsrFromDenseArrays(NMAT, 3, dims, small_matnos, DB_DOUBLE, (DBVCP2_t) vf);
+        printf("  DBCalcMatcsrFromDenseArrays   %.4f s\n", seconds() - t0);
+        DBFreeMatcsr(csr);
+        t0 = seconds();
+        csr = DBCalcMatcsrFromMaterial(mat);
+        printf("  DBCalcMatcsrFromMaterial      %.4f s\n", seconds() - t0);
+        DBFreeMaterial(mat);
+        t0 = seconds();
+        mat = DBCalcMaterialFromMatcsr(csr);
+        printf("  DBCalcMaterialFromMatcsr      %.4f s\n", seconds() - t0);
+        DBFreeMaterial(mat);
+        t0 = seconds();
+        DBCalcDenseArraysFromMatcsr(csr, DB_DOUBLE, &narrs, &dense);
+        printf("  DBCalcDenseArraysFromMatcsr   %.4f s\n", seconds() - t0);
+        for (m = 0; m < narrs; m++)
+            free(dense[m]);
+        free(dense);
+        DBFreeMatcsr(csr);
+    }
+    for (m = 0; m < NMAT; m++)
+        free(vf[m]);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0;
+    int driver = DB_PDB;
+    int show_all_errors = FALSE;
+    int do_bench = FALSE;
+    int dims[3] = {NX, NY, NZ};
+    char const *filename = "matcsr.pdb";
+    double *vf[NMAT];
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "matcsr.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "matcsr.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (!strcmp(argv[i], "bench")) {
+            do_bench = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (do_bench)
+    {
+        bench();
+        return 0;
+    }
+
+    make_dense(NX * NY * NZ, vf);
+    err |= check_conversions(vf, dims, small_matnos);
+    err |= check_conversions(vf, dims, large_matnos);
+
+    /* The bad argument checks expect errors */
+    DBShowErrors(DB_NONE, 0);
+    err |= check_bad_args(vf, dims);
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_TOP, 0);
+
+    err |= check_file(vf, dims, filename, driver);
+
+    for (i = 0; i < NMAT; i++)
+        free(vf[i]);
+    CleanupDriverStuff();
+    return err;
+}
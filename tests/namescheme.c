@@ -59,6 +59,8 @@ be used for advertising or product endorsement purposes.
     I changed '$' external arrays to '#' (int valued) extern and added a new
     test for '$' (string valued) external arrays. I also added an example
     for the kinds of nameschemes as might be used for mult-block objects. 
+
+    Added tests of DBGetNameBuf and DBGetNames.
 */
 
 #include <silo.h>
@@ -439,6 +441,32 @@ int main(int argc, char **argv)
     ns = DBMakeNamescheme("|/domain_%03d/laser_beam_power_%d|n/1|");
     if (ns) return 1;
 
+    /* Test the reentrant and bulk forms, DBGetNameBuf and DBGetNames */
+    {
+        char buf[16], *names[6];
+
+        ns = DBMakeNamescheme("@%s_%05d@n%2?'&odd_%d&n':'even':@n*10");
+        TEST_STR("even_00000", DBGetNameBuf(ns, 0, blockName, sizeof(blockName)))
+        TEST_STR("odd_7_00070", DBGetNameBuf(ns, 7, blockName, sizeof(blockName)))
+        TEST_STR("odd_123_0", DBGetNameBuf(ns, 123, buf, 10))
+        if (DBGetNames(ns, 1000, 6, names) != 0) return 1;
+        for (i = 0; i < 6; i++)
+        {
+            TEST_STR(DBGetName(ns, 1000+i), names[i])
+            free(names[i]);
+        }
+        DBFreeNamescheme(ns);
+
+        ns = DBMakeNamescheme("Hfoo_%-6s|H$Noodle[n%3]", N);
+        TEST_STR("foo_green |", DBGetNameBuf(ns, 4, blockName, sizeof(blockName)))
+        DBFreeNamescheme(ns);
+
+        ns = DBMakeNamescheme("foo/bar/gorfo_0");
+        TEST_STR("foo/bar/gorfo_0", DBGetNameBuf(ns, 3, blockName, sizeof(blockName)))
+        DBFreeNamescheme(ns);
+        TEST_STR("", DBGetNameBuf(0, 3, blockName, sizeof(blockName)))
+    }
+
     /* hackish way to cleanup the circular cache used internally */
     DBSPrintf(0);
     DBGetName(0,-1);
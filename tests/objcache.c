@@ -0,0 +1,257 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Exercises the PDB driver's object cache: reads that alternate between a
+   mesh, its zonelist and several variables in more directories than the
+   cache holds, then an overwrite that must not be answered from the cache. */
+
+#define NDIRS 4
+#define NVARS 3
+#define NX 4
+
+static void
+write_dir(DBfile *dbfile, int d)
+{
+    char dirname[32], vname[32];
+    float x[NX*NX], y[NX*NX], v[(NX-1)*(NX-1)];
+    float *coords[2] = {x, y};
+    int nl[4*(NX-1)*(NX-1)], shapesize = 4, shapecnt = (NX-1)*(NX-1);
+    int i, j, k;
+
+    for (j = 0, k = 0; j < NX; j++)
+        for (i = 0; i < NX; i++, k++)
+        {
+            x[k] = (float) (i + d);
+            y[k] = (float) j;
+        }
+    for (j = 0, k = 0; j < NX-1; j++)
+        for (i = 0; i < NX-1; i++)
+        {
+            nl[k++] = j*NX + i;
+            nl[k++] = j*NX + i + 1;
+            nl[k++] = (j+1)*NX + i + 1;
+            nl[k++] = (j+1)*NX + i;
+        }
+
+    sprintf(dirname, "dir_%d", d);
+    DBMkDir(dbfile, dirname);
+    DBSetDir(dbfile, dirname);
+    DBPutZonelist2(dbfile, "zl", shapecnt, 2, nl, 4*shapecnt, 0, 0, 0,
+        &shapesize, &shapecnt, &shapecnt, 1, 0);
+    DBPutUcdmesh(dbfile, "mesh", 2, 0, coords, NX*NX, shapecnt, "zl", 0,
+        DB_FLOAT, 0);
+    for (k = 0; k < NVARS; k++)
+    {
+        for (i = 0; i < shapecnt; i++)
+            v[i] = (float) (100*d + 10*k + i);
+        sprintf(vname, "var_%d", k);
+        DBPutUcdvar1(dbfile, vname, "mesh", v, shapecnt, 0, 0, DB_FLOAT,
+            DB_ZONECENT, 0);
+    }
+    DBSetDir(dbfile, "..");
+}
+
+static int
+check_dir(DBfile *dbfile, int d, int absolute, float bump)
+{
+    char name[64];
+    int i, k, err = 0;
+    DBucdmesh *um;
+    DBzonelist *zl;
+    DBucdvar *uv;
+
+    if (absolute)
+    {
+        DBSetDir(dbfile, "/");
+        sprintf(name, "/dir_%d/mesh", d);
+    }
+    else
+    {
+        sprintf(name, "/dir_%d", d);
+        DBSetDir(dbfile, name);
+        strcpy(name, "mesh");
+    }
+
+    um = DBGetUcdmesh(dbfile, name);
+    if (!um || um->nnodes != NX*NX || ((float*)um->coords[0])[1] != (float) (d + 1))
+    {
+        fprintf(stderr, "bad mesh in dir_%d\n", d);
+        err = 1;
+    }
+    DBFreeUcdmesh(um);
+
+    if (absolute) sprintf(name, "/dir_%d/zl", d);
+    else strcpy(name, "zl");
+    zl = DBGetZonelist(dbfile, name);
+    if (!zl || zl->nzones != (NX-1)*(NX-1) || zl->nodelist[2] != NX + 1)
+    {
+        fprintf(stderr, "bad zonelist in dir_%d\n", d);
+        err = 1;
+    }
+    DBFreeZonelist(zl);
+
+    for (k = 0; k < NVARS; k++)
+    {
+        if (absolute) sprintf(name, "/dir_%d/var_%d", d, k);
+        else sprintf(name, "var_%d", k);
+        uv = DBGetUcdvar(dbfile, name);
+        if (!uv || uv->nels != (NX-1)*(NX-1))
+        {
+            fprintf(stderr, "bad var_%d in dir_%d\n", k, d);
+            err = 1;
+        }
+        else
+        {
+            for (i = 0; i < uv->nels; i++)
+            {
+                float expect = (float) (100*d + 10*k + i);
+                if (k == 0 && d == 0) expect += bump;
+                if (((float*)uv->vals[0])[i] != expect)
+                {
+                    fprintf(stderr, "bad value %d of var_%d in dir_%d\n", i, k, d);
+                    err = 1;
+                    break;
+                }
+            }
+        }
+        DBFreeUcdvar(uv);
+    }
+
+    return err;
+}
+
+static int
+check_file(char const *filename, int optset)
+{
+    int d, pass, err = 0;
+    DBfile *dbfile = DBOpen(filename, DB_PDB_OPTS(optset), DB_READ);
+
+    if (!dbfile)
+        return 1;
+    for (pass = 0; pass < 3; pass++)
+        for (d = 0; d < NDIRS; d++)
+            err |= check_dir(dbfile, d, (pass+d)%2, 0);
+    DBClose(dbfile);
+    return err;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, d, err = 0;
+    int show_all_errors = FALSE;
+    int optset, optset0, size = 3, zero = 0;
+    char const *filename = "objcache.pdb";
+    float v[(NX-1)*(NX-1)];
+    DBoptlist *opts, *opts0;
+    DBfile *dbfile;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            fprintf(stderr, "DBOPT_PDB_OBJ_CACHE_SIZE applies only to the PDB driver; skipping\n");
+            return 77;
+        } else if (!strncmp(argv[i], "DB_PDB", 6)) {
+            continue; /* uses its own options set */
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    opts = DBMakeOptlist(1);
+    DBAddOption(opts, DBOPT_PDB_OBJ_CACHE_SIZE, &size);
+    optset = DBRegisterFileOptionsSet(opts);
+    opts0 = DBMakeOptlist(1);
+    DBAddOption(opts0, DBOPT_PDB_OBJ_CACHE_SIZE, &zero);
+    optset0 = DBRegisterFileOptionsSet(opts0);
+
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "object cache test",
+        DB_PDB_OPTS(optset));
+    for (d = 0; d < NDIRS; d++)
+        write_dir(dbfile, d);
+    DBClose(dbfile);
+
+    /* A small cache, the cache turned off and the default cache */
+    err |= check_file(filename, optset);
+    err |= check_file(filename, optset0);
+    err |= check_file(filename, DB_FILE_OPTS_H5_DEFAULT_DEFAULT);
+
+    /* Overwriting an object that was just read must not leave the old
+       description in the cache */
+    dbfile = DBOpen(filename, DB_PDB_OPTS(optset), DB_APPEND);
+    err |= check_dir(dbfile, 0, 1, 0);
+    for (i = 0; i < (NX-1)*(NX-1); i++)
+        v[i] = (float) (i + 1000);
+    DBSetDir(dbfile, "/dir_0");
+    DBSetAllowOverwrites(1);
+    DBPutUcdvar1(dbfile, "var_0", "mesh", v, (NX-1)*(NX-1), 0, 0, DB_FLOAT,
+        DB_ZONECENT, 0);
+    DBSetAllowOverwrites(0);
+    err |= check_dir(dbfile, 0, 1, 1000);
+    DBClose(dbfile);
+
+    DBUnregisterFileOptionsSet(optset);
+    DBUnregisterFileOptionsSet(optset0);
+    DBFreeOptlist(opts);
+    DBFreeOptlist(opts0);
+    CleanupDriverStuff();
+    return err;
+}
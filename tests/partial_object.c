@@ -0,0 +1,381 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Exercises DBGetPartialObject: subsets of a ucd mesh with two shape
+   groups, a two component ucd variable with mixed values, a material
+   whose mix chains are interleaved in the file and a quad variable are
+   compared against the same elements of the objects read whole. */
+
+#define NX 20
+#define NY 10
+#define NZONES (NX*NY/2 + NX*NY)
+#define QX 8
+#define QY 6
+
+static int nerrs = 0;
+
+#define CHECK(C, MSG) if (!(C)) { fprintf(stderr, "%s\n", MSG); nerrs++; }
+
+/* Number of materials in zone z */
+static int
+nmats(int z)
+{
+    return z % 11 == 0 ? 3 : (z % 7 == 0 ? 2 : 1);
+}
+
+static void
+write_file(char const *filename, int driver)
+{
+    DBfile *dbfile;
+    float x[(NX+1)*(NY+1)], y[(NX+1)*(NY+1)], *coords[2];
+    float v0[NZONES], v1[NZONES], *vars[2], *mixvars[2];
+    float mixv0[3*NZONES], mixv1[3*NZONES], mix_vf[3*NZONES];
+    float qv[QX*QY];
+    int nodelist[4*NX*NY/2 + 3*NX*NY], shapetype[2], shapesize[2], shapecnt[2];
+    int matnos[3] = {1, 2, 3}, matlist[NZONES], mix_next[3*NZONES];
+    int mix_mat[3*NZONES], mix_zone[3*NZONES], first[NZONES], last[NZONES];
+    int qdims[2] = {QX, QY};
+    char const *varnames[2] = {"v0", "v1"};
+    int i, j, k, z, nl = 0, mixlen = 0, pass;
+    DBoptlist *opts = DBMakeOptlist(1);
+    int major_order = DB_ROWMAJOR;
+
+    for (j = 0; j <= NY; j++)
+    {
+        for (i = 0; i <= NX; i++)
+        {
+            x[j*(NX+1)+i] = (float) i;
+            y[j*(NX+1)+i] = (float) (j*j);
+        }
+    }
+    coords[0] = x; coords[1] = y;
+
+    /* Quads in the bottom half, two triangles per cell in the top half */
+    for (j = 0; j < NY; j++)
+    {
+        for (i = 0; i < NX; i++)
+        {
+            int n0 = j*(NX+1)+i, n1 = n0+1, n2 = n1+NX+1, n3 = n0+NX+1;
+            if (j < NY/2)
+            {
+                nodelist[nl++] = n0; nodelist[nl++] = n1;
+                nodelist[nl++] = n2; nodelist[nl++] = n3;
+            }
+            else
+            {
+                nodelist[nl++] = n0; nodelist[nl++] = n1; nodelist[nl++] = n2;
+                nodelist[nl++] = n0; nodelist[nl++] = n2; nodelist[nl++] = n3;
+            }
+        }
+    }
+    shapetype[0] = DB_ZONETYPE_QUAD; shapesize[0] = 4; shapecnt[0] = NX*NY/2;
+    shapetype[1] = DB_ZONETYPE_TRIANGLE; shapesize[1] = 3; shapecnt[1] = NX*NY;
+
+    /* Lay the mix entries out one link of every chain at a time so the
+       chains interleave in the file */
+    for (z = 0; z < NZONES; z++)
+    {
+        matlist[z] = 1 + z % 3;
+        first[z] = last[z] = -1;
+    }
+    for (pass = 0; pass < 3; pass++)
+    {
+        for (z = 0; z < NZONES; z++)
+        {
+            if (nmats(z) < 2 || pass >= nmats(z)) continue;
+            mix_mat[mixlen] = 1 + (z + pass) % 3;
+            mix_vf[mixlen] = 1.0f / nmats(z);
+            mix_zone[mixlen] = z;
+            mix_next[mixlen] = 0;
+            mixv0[mixlen] = 1000.0f + mixlen;
+            mixv1[mixlen] = -1000.0f - mixlen;
+            if (last[z] < 0)
+                matlist[z] = -(mixlen+1);
+            else
+                mix_next[last[z]] = mixlen+1;
+            last[z] = mixlen++;
+        }
+    }
+
+    for (z = 0; z < NZONES; z++)
+    {
+        v0[z] = 1.5f * z;
+        v1[z] = -1.0f * z;
+    }
+    vars[0] = v0; vars[1] = v1;
+    mixvars[0] = mixv0; mixvars[1] = mixv1;
+    for (k = 0; k < QX*QY; k++)
+        qv[k] = 0.25f * k;
+
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "partial object test", driver);
+    DBMkDir(dbfile, "block");
+    DBSetDir(dbfile, "block");
+    DBPutZonelist2(dbfile, "zl", NZONES, 2, nodelist, nl, 0, 0, 0,
+        shapetype, shapesize, shapecnt, 2, 0);
+    DBPutUcdmesh(dbfile, "mesh", 2, 0, (void**) coords, (NX+1)*(NY+1), NZONES,
+        "zl", 0, DB_FLOAT, 0);
+    DBPutUcdvar(dbfile, "v", "mesh", 2, varnames, (void**) vars, NZONES,
+        (void**) mixvars, mixlen, DB_FLOAT, DB_ZONECENT, 0);
+    i = NZONES;
+    DBPutMaterial(dbfile, "mat", "mesh", 3, matnos, matlist, &i, 1, mix_next,
+        mix_mat, mix_zone, mix_vf, mixlen, DB_FLOAT, 0);
+    DBAddOption(opts, DBOPT_MAJORORDER, &major_order);
+    DBPutQuadvar1(dbfile, "qv", "qmesh", qv, qdims, 2, 0, 0, DB_FLOAT,
+        DB_ZONECENT, opts);
+    DBFreeOptlist(opts);
+    DBClose(dbfile);
+}
+
+static void
+check_mesh(DBfile *dbfile, int n, int const *zones)
+{
+    DBucdmesh *full = DBGetUcdmesh(dbfile, "block/mesh");
+    DBucdmesh *part = (DBucdmesh *) DBGetPartialObject(dbfile, "block/mesh",
+                          DB_PARTIO_POINTS, n, 1, zones, 0);
+    int i, j, k, z, nl = 0, *gnodeno, *fstart;
+
+    CHECK(part, "partial mesh read failed");
+    if (!part) return;
+    CHECK(part->zones->nzones == n, "wrong number of zones");
+    CHECK(part->nnodes < full->nnodes, "read every node");
+
+    fstart = (int *) malloc((NZONES+1) * sizeof(int));
+    for (z = 0, k = 0; k < full->zones->nshapes; k++)
+        for (i = 0; i < full->zones->shapecnt[k]; i++, z++)
+            fstart[z+1] = (z ? fstart[z] : 0) + full->zones->shapesize[k];
+    fstart[0] = 0;
+
+    gnodeno = (int *) part->gnodeno;
+    for (k = 0, z = 0; k < part->zones->nshapes; k++)
+    {
+        for (j = 0; j < part->zones->shapecnt[k]; j++, z++)
+        {
+            int fz = zones[z];
+            CHECK(((int *) part->zones->gzoneno)[z] == fz, "wrong gzoneno");
+            CHECK(part->zones->shapesize[k] == fstart[fz+1] - fstart[fz],
+                "wrong shape size");
+            for (i = 0; i < part->zones->shapesize[k]; i++, nl++)
+            {
+                int pn = part->zones->nodelist[nl];
+                int fn = full->zones->nodelist[fstart[fz]+i];
+                CHECK(gnodeno[pn] == fn, "wrong node");
+                CHECK(((float *) part->coords[0])[pn] == ((float *) full->coords[0])[fn] &&
+                      ((float *) part->coords[1])[pn] == ((float *) full->coords[1])[fn],
+                      "wrong coordinates");
+            }
+        }
+    }
+    CHECK(z == n && nl == part->zones->lnodelist, "zonelist sizes disagree");
+
+    free(fstart);
+    DBFreeUcdmesh(part);
+    DBFreeUcdmesh(full);
+}
+
+static void
+check_mat(DBmaterial const *full, DBmaterial const *part, int n,
+    int const *zones)
+{
+    int i;
+
+    CHECK(part->dims[0] == n && part->ndims == 1, "wrong material dims");
+    for (i = 0; i < n; i++)
+    {
+        int fm = full->matlist[zones[i]], pm = part->matlist[i];
+
+        CHECK((fm < 0) == (pm < 0), "mixed zone mismatch");
+        if (fm >= 0 || pm >= 0)
+        {
+            CHECK(fm == pm, "wrong clean material");
+            continue;
+        }
+        fm = -fm; pm = -pm;
+        while (fm && pm)
+        {
+            CHECK(pm <= part->mixlen, "mix index past mixlen");
+            if (pm > part->mixlen) break;
+            CHECK(full->mix_mat[fm-1] == part->mix_mat[pm-1], "wrong mix_mat");
+            CHECK(((float *) full->mix_vf)[fm-1] == ((float *) part->mix_vf)[pm-1],
+                "wrong mix_vf");
+            CHECK(part->mix_zone[pm-1] == i, "wrong mix_zone");
+            fm = full->mix_next[fm-1];
+            pm = part->mix_next[pm-1];
+        }
+        CHECK(fm == 0 && pm == 0, "mix chains differ in length");
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, j, driver = DB_PDB;
+    int show_all_errors = FALSE;
+    char const *filename = "partial_object.pdb";
+    int zones[] = {299, 0, 77, 154, 150, 14, 121, 49, 11, 280, 5};
+    int nz = sizeof(zones) / sizeof(zones[0]);
+    int slab[3] = {10, 5, 3}, qpts[6] = {0, 0, 7, 5, 3, 2};
+    int qslab[6] = {1, 3, 2, 2, 2, 1}, bad = NZONES;
+    DBfile *dbfile;
+    DBucdvar *fuv, *puv;
+    DBmaterial *fmat, *pmat;
+    DBquadvar *fqv, *pqv;
+    DBoptlist *opts;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "partial_object.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "partial_object.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    write_file(filename, driver);
+    dbfile = DBOpen(filename, driver, DB_READ);
+
+    check_mesh(dbfile, nz, zones);
+
+    /* Material, chasing interleaved chains */
+    fmat = DBGetMaterial(dbfile, "block/mat");
+    pmat = DBGetPartialMaterial(dbfile, "block/mat", DB_PARTIO_POINTS, nz, 1, zones, 0);
+    CHECK(pmat, "partial material read failed");
+    if (pmat)
+    {
+        check_mat(fmat, pmat, nz, zones);
+        DBFreeMaterial(pmat);
+    }
+
+    /* Variable, with its mixed values matched up through the material */
+    fuv = DBGetUcdvar(dbfile, "block/v");
+    DBSetDir(dbfile, "block");
+    opts = DBMakeOptlist(1);
+    DBAddOption(opts, DBOPT_MATNAME, "mat");
+    puv = (DBucdvar *) DBGetPartialObject(dbfile, "v", DB_PARTIO_POINTS, nz, 1, zones, opts);
+    DBFreeOptlist(opts);
+    DBSetDir(dbfile, "/");
+    CHECK(puv && puv->nels == nz && puv->nvals == 2, "partial ucdvar read failed");
+    pmat = DBGetPartialMaterial(dbfile, "block/mat", DB_PARTIO_POINTS, nz, 1, zones, 0);
+    if (puv && pmat)
+    {
+        CHECK(puv->mixlen == pmat->mixlen, "mixlen differs from material's");
+        for (i = 0; i < nz; i++)
+        {
+            int fm = fmat->matlist[zones[i]], pm = pmat->matlist[i];
+            for (j = 0; j < 2; j++)
+                CHECK(((float *) puv->vals[j])[i] == ((float *) fuv->vals[j])[zones[i]],
+                    "wrong ucdvar value");
+            for (fm = -fm, pm = -pm; fm > 0 && pm > 0;
+                 fm = fmat->mix_next[fm-1], pm = pmat->mix_next[pm-1])
+                for (j = 0; j < 2; j++)
+                    CHECK(((float *) puv->mixvals[j])[pm-1] == ((float *) fuv->mixvals[j])[fm-1],
+                        "wrong ucdvar mixed value");
+        }
+    }
+    if (puv) DBFreeUcdvar(puv);
+    if (pmat) DBFreeMaterial(pmat);
+
+    /* A hyperslab of the variable, without mixed values */
+    puv = (DBucdvar *) DBGetPartialObject(dbfile, "block/v", DB_PARTIO_HSLABS, 1, 1, slab, 0);
+    CHECK(puv && puv->nels == slab[1] && puv->mixlen == 0 && !puv->mixvals,
+        "ucdvar hyperslab read failed");
+    for (i = 0; puv && i < slab[1]; i++)
+        CHECK(((float *) puv->vals[1])[i] == ((float *) fuv->vals[1])[slab[0]+i*slab[2]],
+            "wrong ucdvar hyperslab value");
+    if (puv) DBFreeUcdvar(puv);
+
+    /* Quad variable by logical points and by a single hyperslab */
+    fqv = DBGetQuadvar(dbfile, "block/qv");
+    pqv = (DBquadvar *) DBGetPartialObject(dbfile, "block/qv", DB_PARTIO_POINTS, 3, 2, qpts, 0);
+    CHECK(pqv && pqv->nels == 3 && pqv->ndims == 1, "partial quadvar read failed");
+    for (i = 0; pqv && i < 3; i++)
+        CHECK(((float *) pqv->vals[0])[i] ==
+              ((float *) fqv->vals[0])[qpts[2*i] + QX*qpts[2*i+1]],
+            "wrong quadvar value");
+    if (pqv) DBFreeQuadvar(pqv);
+    pqv = (DBquadvar *) DBGetPartialObject(dbfile, "block/qv", DB_PARTIO_HSLABS, 1, 2, qslab, 0);
+    CHECK(pqv && pqv->ndims == 2 && pqv->dims[0] == 3 && pqv->dims[1] == 2,
+        "quadvar hyperslab read failed");
+    for (j = 0; pqv && j < 2; j++)
+        for (i = 0; i < 3; i++)
+            CHECK(((float *) pqv->vals[0])[i + 3*j] ==
+                  ((float *) fqv->vals[0])[(1+2*i) + QX*(2+j)],
+                "wrong quadvar hyperslab value");
+    if (pqv) DBFreeQuadvar(pqv);
+
+    /* Indices out of range fail */
+    DBShowErrors(DB_NONE, 0);
+    CHECK(!DBGetPartialObject(dbfile, "block/v", DB_PARTIO_POINTS, 1, 1, &bad, 0),
+        "out of range index accepted");
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_TOP, 0);
+
+    DBFreeQuadvar(fqv);
+    DBFreeUcdvar(fuv);
+    DBFreeMaterial(fmat);
+    DBClose(dbfile);
+
+    CleanupDriverStuff();
+    return nerrs != 0;
+}
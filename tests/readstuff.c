@@ -75,6 +75,11 @@ main(int argc, char *argv[])
     char           filename[256];
     char          *obj_names[13];
     int            ordering[13];
+    char           blk_names[12][32];
+    char const    *batch_names[12];
+    void          *results[12];
+    int            nread;
+    DBfilestats    st0, st1, st2;
 
     /* Parse command-line */
     for (i=1; i<argc; i++) {
@@ -120,6 +125,55 @@ main(int argc, char *argv[])
     for (i = 0; i < 13; i++)
         printf("\t\"%s\"\n", obj_names[ordering[i]]);
 
+    /* Batch read of one variable across many blocks, in reverse order.
+       Types are inquired by the library. The results must match what
+       individual DBGetQuadvar calls return. */
+    for (i = 0; i < 12; i++)
+    {
+        sprintf(blk_names[i], "../block%d/d", 11-i);
+        batch_names[i] = blk_names[i];
+    }
+    DBSetFileStats(1);
+    DBGetFileStats(dbfile, &st0);
+    nread = DBGetObjects(dbfile, 12, batch_names, NULL, results);
+    DBGetFileStats(dbfile, &st1);
+    if (nread != 12)
+    {
+        fprintf(stderr, "DBGetObjects read %d of 12 objects\n", nread);
+        err = 1;
+    }
+    for (i = 0; i < 12; i++)
+        DBFreeQuadvar(DBGetQuadvar(dbfile, batch_names[i]));
+    DBGetFileStats(dbfile, &st2);
+    DBSetFileStats(0);
+
+    /* HDF5 reads the raw data of the batch ahead in fewer reads than
+       the objects have datasets, and fills each object in from it */
+    printf("DBGetObjects: %lld reads, %lld cache hits; "
+           "DBGetQuadvar: %lld reads\n", st1.nreads - st0.nreads,
+           st1.ncache_hits - st0.ncache_hits, st2.nreads - st1.nreads);
+    if (driverType == DB_HDF5 &&
+        (st1.ncache_hits - st0.ncache_hits < 12 ||
+         st1.nreads - st0.nreads >= st2.nreads - st1.nreads))
+    {
+        fprintf(stderr, "DBGetObjects did not read ahead\n");
+        err = 1;
+    }
+
+    for (i = 0; i < 12; i++)
+    {
+        DBquadvar *qv = (DBquadvar *) results[i];
+        DBquadvar *qv2 = DBGetQuadvar(dbfile, batch_names[i]);
+        if (!qv || !qv2 || qv->nels != qv2->nels ||
+            memcmp(qv->vals[0], qv2->vals[0], qv->nels * sizeof(float)))
+        {
+            fprintf(stderr, "DBGetObjects result for \"%s\" is wrong\n", batch_names[i]);
+            err = 1;
+        }
+        DBFreeQuadvar(qv);
+        DBFreeQuadvar(qv2);
+    }
+
     DBClose(dbfile);
 
     return err;
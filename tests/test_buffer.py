@@ -0,0 +1,72 @@
+# Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+# LLNL-CODE-425250.
+# All rights reserved.
+# 
+# This file is part of Silo. For details, see silo.llnl.gov.
+# 
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 
+#    * Redistributions of source code must retain the above copyright
+#      notice, this list of conditions and the disclaimer below.
+#    * Redistributions in binary form must reproduce the above copyright
+#      notice, this list of conditions and the disclaimer (as noted
+#      below) in the documentation and/or other materials provided with
+#      the distribution.
+#    * Neither the name of the LLNS/LLNL nor the names of its
+#      contributors may be used to endorse or promote products derived
+#      from this software without specific prior written permission.
+# 
+# THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+# "AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+# LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+# LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+# CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+# PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+# NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# 
+# This work was produced at Lawrence Livermore National Laboratory under
+# Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+# States Government  nor Lawrence  Livermore National Security,  LLC nor
+# any of  their employees,  makes any warranty,  express or  implied, or
+# assumes   any   liability   or   responsibility  for   the   accuracy,
+# completeness, or usefulness of any information, apparatus, product, or
+# process  disclosed, or  represents  that its  use  would not  infringe
+# privately-owned   rights.  Any  reference   herein  to   any  specific
+# commercial products,  process, or  services by trade  name, trademark,
+# manufacturer or otherwise does not necessarily constitute or imply its
+# endorsement,  recommendation,   or  favoring  by   the  United  States
+# Government or Lawrence Livermore National Security, LLC. The views and
+# opinions  of authors  expressed  herein do  not  necessarily state  or
+# reflect those  of the United  States Government or  Lawrence Livermore
+# National  Security, LLC,  and shall  not  be used  for advertising  or
+# product endorsement purposes.
+import Silo
+import array
+
+# Arrays go in and out of the module through the buffer protocol, as
+# NumPy arrays when NumPy is available and as DBbuffer objects otherwise
+db = Silo.Create("buffer.silo", "buffer test")
+a = array.array('d', [0.5 * i for i in range(24)])
+db.Write("a", a)
+db.Write("a2", memoryview(a).cast('B').cast('d', (4, 6)))
+db.Write("i", array.array('i', range(10)))
+db.Close()
+
+db2 = Silo.Open("buffer.silo")
+x = db2.GetVarArray("a")
+print("a=%d %.1f %.1f" % (len(x), x[3], x[23]))
+m = memoryview(db2.GetVarArray("a2"))
+print("a2=%s %s" % (m.format, m.shape))
+print("a2[2,3]=%.1f" % m[2, 3])
+print("slice=%s" % memoryview(db2.ReadVarSlice("a", 2, 10, 3)).tolist())
+print("slice2=%s" % memoryview(db2.ReadVarSlice("a2", (1, 1), (2, 4), (1, 2))).tolist())
+print("vals=%s" % memoryview(db2.ReadVarVals("i", (9, 0, 4))).tolist())
+print("vals2=%s" % memoryview(db2.ReadVarVals("a2", [(0, 0), (3, 5)])).tolist())
+db2.Close()
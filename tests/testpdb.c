@@ -72,6 +72,9 @@ typedef struct {
 void CreateFile (char *filename, char *name, char *type, int num,
      char **comp_names, char **pdb_names);
 void ReadFile (char *filename, char *name);
+void ManyEntries (void);
+void MappedReads (void);
+void ForeignTypes (void);
 
 char *comp_names[] = {"coord0",
                       "coord1",
@@ -119,6 +122,12 @@ int main ()
 
     ReadFile("abc.pdb", "mesh");
 
+    ManyEntries();
+
+    MappedReads();
+
+    ForeignTypes();
+
     return 0;
 }
 
@@ -320,3 +329,403 @@ CreateFile (char *filename, char *name, char *type, int num,
 
     return;
 }
+
+
+/*
+ * Write the same large symbol table with and without the binary copy,
+ * check both read back identically (and that the hash table grew from
+ * its small starting size), then append to the binary one.
+ */
+#define NMANY 3000
+
+static int
+HasBinarySymtab (char *filename)
+{
+    FILE *fp;
+    char *buf;
+    long n, i;
+    int found = 0;
+    char const *key = "Binary-Symbol-Table:";
+
+    if ((fp = fopen(filename, "rb")) == NULL) return 0;
+    fseek(fp, 0, SEEK_END);
+    n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *) malloc(n);
+    if (fread(buf, 1, n, fp) != (size_t) n) n = 0;
+    fclose(fp);
+    for (i = 0; !found && i + (long) strlen(key) <= n; i++)
+        found = memcmp(buf + i, key, strlen(key)) == 0;
+    free(buf);
+    return found;
+}
+
+static void
+WriteMany (char *filename, int binmin)
+{
+    int i, data[6];
+    float fdata[6];
+    long ind[6];
+    char name[64];
+    PDBfile *file;
+
+    PD_set_symt_binary_min(binmin);
+    if ((file = PD_create(filename)) == NULL)
+    {
+        printf("Error creating %s.\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < NMANY; i++)
+    {
+        data[0] = i; data[1] = -i; data[2] = 2*i;
+        data[3] = 3*i; data[4] = 4*i; data[5] = 5*i;
+        fdata[0] = i; fdata[2] = 2*i;
+        ind[0] = 0; ind[1] = i%2; ind[2] = 1;
+        ind[3] = -1; ind[4] = 1; ind[5] = 1;
+        sprintf(name, "var%d%s", i, (i%3) ? "" : "_f");
+        if (PD_write_alt(file, name, (i%3) ? "integer" : "float",
+                         (i%3) ? (void *) data : (void *) fdata, 2, ind) == 0)
+        {
+            printf("Error writing %s.\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    PD_close(file);
+    PD_set_symt_binary_min(1024);
+}
+
+static void
+CompareMany (PDBfile *a, PDBfile *b, int n)
+{
+    int i;
+    char name[64];
+    syment *ea, *eb;
+    dimdes *da, *db;
+
+    if (a->symtab->size <= HSZSMALL || b->symtab->size <= HSZSMALL)
+    {
+        printf("Symbol tables did not grow: %d/%d buckets.\n",
+            a->symtab->size, b->symtab->size);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < n; i++)
+    {
+        sprintf(name, "var%d%s", i, (i%3) ? "" : "_f");
+        ea = PD_inquire_entry(a, name, 0, NULL);
+        eb = PD_inquire_entry(b, name, 0, NULL);
+        if (!ea || !eb || strcmp(PD_entry_type(ea), PD_entry_type(eb)) ||
+            PD_entry_number(ea) != PD_entry_number(eb) ||
+            PD_entry_address(ea) != PD_entry_address(eb))
+        {
+            printf("Entry %s differs.\n", name);
+            exit(EXIT_FAILURE);
+        }
+        for (da = PD_entry_dimensions(ea), db = PD_entry_dimensions(eb);
+             da && db; da = da->next, db = db->next)
+        {
+            if (da->index_min != db->index_min || da->number != db->number)
+                break;
+        }
+        if (da || db)
+        {
+            printf("Dimensions of %s differ.\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void
+CheckValue (PDBfile *file, int i)
+{
+    int data[6];
+    float fdata[6];
+    char name[64];
+
+    sprintf(name, "var%d%s", i, (i%3) ? "" : "_f");
+    if ((i%3) ? (!PD_read(file, name, data) || data[0] != i ||
+                 data[2] != 2*i)
+              : (!PD_read(file, name, fdata) || fdata[0] != i ||
+                 fdata[2] != 2*i))
+    {
+        printf("Wrong data for %s.\n", name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+ManyEntries (void)
+{
+    int i, data[6] = {0,0,0,0,0,0};
+    PDBfile *txt, *bin;
+
+    WriteMany("many_txt.pdb", 0);
+    WriteMany("many_bin.pdb", 100);
+    if (HasBinarySymtab("many_txt.pdb") || !HasBinarySymtab("many_bin.pdb"))
+    {
+        printf("Binary symbol table written when it should not be or vice versa.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    txt = PD_open("many_txt.pdb", "rs");
+    bin = PD_open("many_bin.pdb", "rs");
+    if (!txt || !bin)
+    {
+        printf("Error opening many_*.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (txt->symtab->nelements != bin->symtab->nelements)
+    {
+        printf("Symbol tables differ: %d/%d entries.\n",
+            txt->symtab->nelements, bin->symtab->nelements);
+        exit(EXIT_FAILURE);
+    }
+    CompareMany(txt, bin, NMANY);
+    for (i = 0; i < NMANY; i += 97)
+    {
+        CheckValue(txt, i);
+        CheckValue(bin, i);
+    }
+    PD_close(bin);
+
+    /*
+     * Appending overwrites the old binary symbol table and chart and
+     * the close writes fresh ones.
+     */
+    PD_set_symt_binary_min(100);
+    if ((bin = PD_open("many_bin.pdb", "a")) == NULL ||
+        PD_write(bin, "var_extra", "integer", data) == 0)
+    {
+        printf("Error appending to many_bin.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    PD_close(bin);
+    PD_set_symt_binary_min(1024);
+
+    bin = PD_open("many_bin.pdb", "rs");
+    if (!bin || bin->symtab->nelements != txt->symtab->nelements + 1 ||
+        !PD_inquire_entry(bin, "var_extra", 0, NULL))
+    {
+        printf("Append to many_bin.pdb lost entries.\n");
+        exit(EXIT_FAILURE);
+    }
+    CompareMany(txt, bin, NMANY);
+    CheckValue(bin, NMANY-1);
+
+    PD_close(bin);
+    PD_close(txt);
+}
+
+/*
+ * Read files through a memory mapping.  The big-endian file makes every
+ * read convert its data, which is done straight from the mapped pages.
+ */
+#define NFOREIGN 5000
+
+static void
+CheckForeign (PDBfile *file)
+{
+    int i, *idata;
+    double *ddata;
+    long ind[3];
+
+    idata = (int *) malloc(NFOREIGN*sizeof(int));
+    ddata = (double *) malloc(NFOREIGN*sizeof(double));
+    if (!PD_read(file, "ints", idata) || !PD_read(file, "doubles", ddata))
+    {
+        printf("Error reading big-endian.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < NFOREIGN; i++)
+    {
+        if (idata[i] != 3*i-7 || ddata[i] != 0.5*i)
+        {
+            printf("Wrong value %d in big-endian.pdb.\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Every 7th double from 10 through 4000 */
+    ind[0] = 10; ind[1] = 4000; ind[2] = 7;
+    if (!PD_read_alt(file, "doubles", ddata, ind))
+    {
+        printf("Error reading part of doubles.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; 10+7*i <= 4000; i++)
+    {
+        if (ddata[i] != 0.5*(10+7*i))
+        {
+            printf("Wrong value %d in part of doubles.\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    free(idata);
+    free(ddata);
+}
+
+void
+MappedReads (void)
+{
+    int i, *idata;
+    double *ddata;
+    long ind[3];
+    PDBfile *file, *txt, *bin;
+
+    idata = (int *) malloc(NFOREIGN*sizeof(int));
+    ddata = (double *) malloc(NFOREIGN*sizeof(double));
+    for (i = 0; i < NFOREIGN; i++)
+    {
+        idata[i] = 3*i-7;
+        ddata[i] = 0.5*i;
+    }
+    PD_target(&IEEEA_STD, &SPARC_ALIGNMENT);
+    if ((file = PD_open("big-endian.pdb", "w")) == NULL)
+    {
+        printf("Error creating big-endian.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    ind[0] = 0; ind[1] = NFOREIGN-1; ind[2] = 1;
+    if (!PD_write_alt(file, "ints", "integer", idata, 1, ind) ||
+        !PD_write_alt(file, "doubles", "double", ddata, 1, ind))
+    {
+        printf("Error writing big-endian.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    PD_close(file);
+    free(idata);
+    free(ddata);
+
+    if ((file = PD_open("big-endian.pdb", "r")) == NULL)
+    {
+        printf("Error opening big-endian.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    CheckForeign(file);
+    PD_close(file);
+
+    PD_set_mmap(1);
+    file = PD_open("big-endian.pdb", "r");
+    txt = PD_open("many_txt.pdb", "r");
+    bin = PD_open("many_bin.pdb", "r");
+    PD_set_mmap(0);
+    if (!file || !txt || !bin)
+    {
+        printf("Error opening mapped files.\n");
+        exit(EXIT_FAILURE);
+    }
+    CheckForeign(file);
+    CompareMany(txt, bin, NMANY);
+    for (i = 0; i < NMANY; i += 31)
+    {
+        CheckValue(txt, i);
+        CheckValue(bin, i);
+    }
+
+    /* Mapped files are read-only */
+    if (PD_write(bin, "var_mapped", "integer", &i) != 0)
+    {
+        printf("Wrote to a mapped file.\n");
+        exit(EXIT_FAILURE);
+    }
+    PD_close(file);
+    PD_close(txt);
+    PD_close(bin);
+}
+
+/*
+ * Read each IEEE type back from a big-endian file, including reads that
+ * widen floats to doubles and narrow doubles to floats.  The odd count
+ * leaves a tail after the byte swaps that work a vector at a time.
+ */
+#define NTYPES 1001
+
+static void
+CheckTypes (int ok, char *what, int i)
+{
+    if (!ok)
+    {
+        printf("Wrong %s %d in swaps.pdb.\n", what, i);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+ForeignTypes (void)
+{
+    int i;
+    short *sdata;
+    long long *ldata;
+    float *fdata;
+    double *ddata;
+    long ind[3];
+    PDBfile *file;
+
+    sdata = (short *) malloc(NTYPES*sizeof(short));
+    ldata = (long long *) malloc(NTYPES*sizeof(long long));
+    fdata = (float *) malloc(NTYPES*sizeof(float));
+    ddata = (double *) malloc(NTYPES*sizeof(double));
+    for (i = 0; i < NTYPES; i++)
+    {
+        sdata[i] = (short) (37*i-18000);
+        ldata[i] = 123456789012LL*i - 987654321LL;
+        fdata[i] = 0.25f*i - 100;
+        ddata[i] = 0.25*i - 100;
+    }
+    PD_target(&IEEEA_STD, &SPARC_ALIGNMENT);
+    if ((file = PD_open("swaps.pdb", "w")) == NULL)
+    {
+        printf("Error creating swaps.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    ind[0] = 0; ind[1] = NTYPES-1; ind[2] = 1;
+    if (!PD_write_alt(file, "shorts", "short", sdata, 1, ind) ||
+        !PD_write_alt(file, "longlongs", "long_long", ldata, 1, ind) ||
+        !PD_write_alt(file, "floats", "float", fdata, 1, ind) ||
+        !PD_write_alt(file, "doubles", "double", ddata, 1, ind))
+    {
+        printf("Error writing swaps.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    PD_close(file);
+
+    memset(sdata, 0, NTYPES*sizeof(short));
+    memset(ldata, 0, NTYPES*sizeof(long long));
+    memset(fdata, 0, NTYPES*sizeof(float));
+    memset(ddata, 0, NTYPES*sizeof(double));
+    if ((file = PD_open("swaps.pdb", "r")) == NULL ||
+        !PD_read(file, "shorts", sdata) ||
+        !PD_read(file, "longlongs", ldata) ||
+        !PD_read(file, "floats", fdata) ||
+        !PD_read(file, "doubles", ddata))
+    {
+        printf("Error reading swaps.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < NTYPES; i++)
+    {
+        CheckTypes(sdata[i] == (short) (37*i-18000), "short", i);
+        CheckTypes(ldata[i] == 123456789012LL*i - 987654321LL, "long long", i);
+        CheckTypes(fdata[i] == 0.25f*i - 100, "float", i);
+        CheckTypes(ddata[i] == 0.25*i - 100, "double", i);
+    }
+
+    memset(fdata, 0, NTYPES*sizeof(float));
+    memset(ddata, 0, NTYPES*sizeof(double));
+    if (!PD_read_as(file, "floats", "double", ddata) ||
+        !PD_read_as(file, "doubles", "float", fdata))
+    {
+        printf("Error converting swaps.pdb.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < NTYPES; i++)
+    {
+        CheckTypes(ddata[i] == 0.25*i - 100, "widened float", i);
+        CheckTypes(fdata[i] == 0.25f*i - 100, "narrowed double", i);
+    }
+    PD_close(file);
+
+    free(sdata);
+    free(ldata);
+    free(fdata);
+    free(ddata);
+}
@@ -0,0 +1,226 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+#if SILO_THREADSAFE
+#include <pthread.h>
+#endif
+
+/*
+ * Multithreaded stress test for the thread-safe (--enable-threadsafe)
+ * library. Each thread writes its own set of domain files and then all
+ * threads read all the domains, many times over and in different orders,
+ * verifying the data. Each thread also provokes errors on purpose to
+ * confirm the error state it sees is its own.
+ */
+
+#define NDOMS    24
+#define NTHREADS 8
+#define NITERS   20
+#define NX       20
+#define NY       15
+
+static int driver = DB_PDB;
+static char const *ext = "pdb";
+static int nerrors = 0;
+
+static float
+domval(int dom, int i)
+{
+    return (float) (dom * 1000 + i);
+}
+
+static int
+write_domain(int dom)
+{
+    char filename[64];
+    DBfile *dbfile;
+    float x[NX], y[NY], *coords[2];
+    float zvals[(NX-1)*(NY-1)];
+    int dims[2], zdims[2], i;
+    int nodelist[4] = {0, 1, NX+1, NX};
+    int shapesize = 4, shapecnt = 1;
+    float ux[NX+1], uy[NX+1], *ucoords[2];
+
+    for (i = 0; i < NX; i++) x[i] = (float) i + dom;
+    for (i = 0; i < NY; i++) y[i] = (float) i;
+    for (i = 0; i < (NX-1)*(NY-1); i++) zvals[i] = domval(dom, i);
+    for (i = 0; i < NX+1; i++) ux[i] = uy[i] = (float) i;
+    coords[0] = x; coords[1] = y;
+    ucoords[0] = ux; ucoords[1] = uy;
+    dims[0] = NX; dims[1] = NY;
+    zdims[0] = NX-1; zdims[1] = NY-1;
+
+    sprintf(filename, "threads_%03d.%s", dom, ext);
+    if (NULL == (dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "threads test", driver)))
+        return 1;
+    DBPutQuadmesh(dbfile, "qmesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "zvar", "qmesh", zvals, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBPutZonelist2(dbfile, "zl", 1, 2, nodelist, 4, 0, 0, 0, &shapesize, &shapesize,
+        &shapecnt, 1, 0);
+    DBPutUcdmesh(dbfile, "umesh", 2, 0, ucoords, NX+1, 1, "zl", 0, DB_FLOAT, 0);
+    DBClose(dbfile);
+    return 0;
+}
+
+static int
+read_domain(int dom)
+{
+    char filename[64];
+    DBfile *dbfile;
+    DBquadmesh *qm;
+    DBquadvar *qv;
+    DBucdmesh *um;
+    int i, err = 0;
+
+    sprintf(filename, "threads_%03d.%s", dom, ext);
+    if (NULL == (dbfile = DBOpen(filename, DB_UNKNOWN, DB_READ)))
+        return 1;
+
+    qm = DBGetQuadmesh(dbfile, "qmesh");
+    qv = DBGetQuadvar(dbfile, "zvar");
+    um = DBGetUcdmesh(dbfile, "umesh");
+
+    if (!qm || ((float*)qm->coords[0])[NX-1] != (float) (NX-1+dom))
+        err = 1;
+    for (i = 0; qv && !err && i < (NX-1)*(NY-1); i++)
+        if (((float*)qv->vals[0])[i] != domval(dom, i)) err = 1;
+    if (!qv || !um || !um->zones || um->zones->nodelist[2] != NX+1)
+        err = 1;
+
+    /* Errors seen by this thread must be this thread's errors */
+    if (DBGetQuadvar(dbfile, "no_such_var") != NULL || DBErrno() == E_NOERROR)
+        err = 1;
+
+    DBFreeQuadmesh(qm);
+    DBFreeQuadvar(qv);
+    DBFreeUcdmesh(um);
+    DBClose(dbfile);
+    return err;
+}
+
+#if SILO_THREADSAFE
+static pthread_mutex_t err_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_barrier_t barrier;
+
+static void *
+thread_main(void *arg)
+{
+    int tid = (int) (long) arg;
+    int i, j, err = 0;
+
+    /* write phase; each thread writes every NTHREADS'th domain */
+    for (i = tid; i < NDOMS; i += NTHREADS)
+        err += write_domain(i);
+
+    pthread_barrier_wait(&barrier);
+
+    /* read phase; each thread visits every domain, starting at a
+       different place so threads collide on different files */
+    for (j = 0; j < NITERS; j++)
+        for (i = 0; i < NDOMS; i++)
+            err += read_domain((i + tid * 3 + j) % NDOMS);
+
+    pthread_mutex_lock(&err_lock);
+    nerrors += err;
+    pthread_mutex_unlock(&err_lock);
+    return 0;
+}
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    int i;
+    int show_all_errors = FALSE;
+#if SILO_THREADSAFE
+    pthread_t threads[NTHREADS];
+#endif
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            ext = "pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            ext = "h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+#if !SILO_THREADSAFE
+    fprintf(stderr, "Silo was not configured with --enable-threadsafe; skipping\n");
+    return 77; /* autotest's code for a skipped test */
+#else
+    /* Reading "no_such_var" is supposed to fail; keep quiet about it */
+    DBShowErrors(show_all_errors ? DB_ALL_AND_DRVR : DB_NONE, 0);
+
+    pthread_barrier_init(&barrier, 0, NTHREADS);
+    for (i = 0; i < NTHREADS; i++)
+        pthread_create(&threads[i], 0, thread_main, (void *) (long) i);
+    for (i = 0; i < NTHREADS; i++)
+        pthread_join(threads[i], 0);
+    pthread_barrier_destroy(&barrier);
+
+    if (nerrors)
+        fprintf(stderr, "%d domain reads or writes failed\n", nerrors);
+
+    CleanupDriverStuff();
+    return nerrors != 0;
+#endif
+}
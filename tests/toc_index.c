@@ -0,0 +1,269 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+#define NDOMS 40
+#define NX 5
+
+static void
+write_dom(DBfile *dbfile, int dom)
+{
+    char dirname[32];
+    float x[NX], y[NX], v[(NX-1)*(NX-1)];
+    float *coords[2] = {x, y};
+    int dims[2] = {NX, NX}, zdims[2] = {NX-1, NX-1}, one = NX;
+    int i;
+
+    for (i = 0; i < NX; i++) x[i] = y[i] = (float) (dom + i);
+    for (i = 0; i < (NX-1)*(NX-1); i++) v[i] = (float) i;
+
+    sprintf(dirname, "dom_%d", dom);
+    DBMkDir(dbfile, dirname);
+    DBSetDir(dbfile, dirname);
+    DBPutQuadmesh(dbfile, "mesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "pressure", "mesh", v, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBPutCurve(dbfile, "curve", x, y, DB_FLOAT, NX, 0);
+    DBWrite(dbfile, "raw", x, &one, 1, DB_FLOAT);
+    DBMkSymlink(dbfile, "mesh", "meshlink");
+    DBMkDir(dbfile, "sub");
+    DBSetDir(dbfile, "sub");
+    DBWrite(dbfile, "deep", y, &one, 1, DB_FLOAT);
+    DBSetDir(dbfile, "../..");
+}
+
+static int
+same_names(char const *what, char **a, int na, char **b, int nb)
+{
+    int i;
+    if (na != nb)
+    {
+        fprintf(stderr, "%s: %d names versus %d\n", what, na, nb);
+        return 1;
+    }
+    for (i = 0; i < na; i++)
+    {
+        if (strcmp(a[i], b[i]))
+        {
+            fprintf(stderr, "%s: \"%s\" versus \"%s\"\n", what, a[i], b[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Compare the tocs of the current directories of two files */
+static int
+same_toc(DBfile *f1, DBfile *f2, char const *dir)
+{
+    DBtoc *t1, *t2;
+    int i, err = 0;
+
+    DBSetDir(f1, dir);
+    DBSetDir(f2, dir);
+    t1 = DBGetToc(f1);
+    t2 = DBGetToc(f2);
+    if (!t1 || !t2)
+    {
+        fprintf(stderr, "%s: no toc\n", dir);
+        return 1;
+    }
+    err |= same_names("dirs", t1->dir_names, t1->ndir, t2->dir_names, t2->ndir);
+    err |= same_names("quadmeshes", t1->qmesh_names, t1->nqmesh, t2->qmesh_names, t2->nqmesh);
+    err |= same_names("quadvars", t1->qvar_names, t1->nqvar, t2->qvar_names, t2->nqvar);
+    err |= same_names("curves", t1->curve_names, t1->ncurve, t2->curve_names, t2->ncurve);
+    err |= same_names("vars", t1->var_names, t1->nvar, t2->var_names, t2->nvar);
+    err |= same_names("symlinks", t1->symlink_names, t1->nsymlink, t2->symlink_names, t2->nsymlink);
+    err |= same_names("symlink targets", t1->symlink_target_names, t1->nsymlink,
+                      t2->symlink_target_names, t2->nsymlink);
+    if (!err && t1->ndir)
+    {
+        /* the tocs are replaced as we descend */
+        int ndir = t1->ndir;
+        char **dirs = (char **) malloc(ndir * sizeof(char*));
+        for (i = 0; i < ndir; i++)
+            dirs[i] = strdup(t1->dir_names[i]);
+        for (i = 0; i < ndir; i++)
+        {
+            char subdir[256];
+            snprintf(subdir, sizeof(subdir), "%s/%s", strcmp(dir, "/") ? dir : "", dirs[i]);
+            if (!err) err |= same_toc(f1, f2, subdir);
+            free(dirs[i]);
+        }
+        free(dirs);
+    }
+    if (err)
+        fprintf(stderr, "tocs of %s differ\n", dir);
+    return err;
+}
+
+static int
+compare_files(char const *indexed, char const *plain)
+{
+    DBfile *f1 = DBOpen(indexed, DB_UNKNOWN, DB_READ);
+    DBfile *f2 = DBOpen(plain, DB_UNKNOWN, DB_READ);
+    int err = same_toc(f1, f2, "/");
+    DBClose(f1);
+    DBClose(f2);
+    return err;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0;
+    int show_all_errors = FALSE;
+    int optset, on = 1;
+    char const *indexed = "toc_index.h5", *plain = "toc_plain.h5";
+    DBoptlist *opts;
+    DBfile *f1, *f2;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            fprintf(stderr, "DBOPT_H5_TOC_INDEX applies only to the HDF5 driver; skipping\n");
+            return 77;
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            continue; /* uses its own options set */
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    opts = DBMakeOptlist(1);
+    DBAddOption(opts, DBOPT_H5_TOC_INDEX, &on);
+    optset = DBRegisterFileOptionsSet(opts);
+
+    /* The same contents with and without the index */
+    f1 = DBCreate(indexed, DB_CLOBBER, DB_LOCAL, "toc index test", DB_HDF5_OPTS(optset));
+    f2 = DBCreate(plain, DB_CLOBBER, DB_LOCAL, "toc index test", DB_HDF5);
+    for (i = 0; i < NDOMS; i++)
+    {
+        write_dom(f1, i);
+        write_dom(f2, i);
+    }
+    DBMkSymlink(f1, "/dom_0", "firstdom");
+    DBMkSymlink(f2, "/dom_0", "firstdom");
+    DBClose(f1);
+    DBClose(f2);
+    err |= compare_files(indexed, plain);
+
+    /* Appending without the option leaves stale indices behind, which
+       must be noticed */
+    f1 = DBOpen(indexed, DB_HDF5, DB_APPEND);
+    f2 = DBOpen(plain, DB_HDF5, DB_APPEND);
+    write_dom(f1, NDOMS);
+    write_dom(f2, NDOMS);
+    DBSetDir(f1, "/dom_3");
+    DBSetDir(f2, "/dom_3");
+    DBWrite(f1, "late", &on, &on, 1, DB_INT);
+    DBWrite(f2, "late", &on, &on, 1, DB_INT);
+    DBClose(f1);
+    DBClose(f2);
+    err |= compare_files(indexed, plain);
+
+    /* Appending with the option brings them up to date */
+    f1 = DBOpen(indexed, DB_HDF5_OPTS(optset), DB_APPEND);
+    f2 = DBOpen(plain, DB_HDF5, DB_APPEND);
+    DBSetDir(f1, "/dom_5/sub");
+    DBSetDir(f2, "/dom_5/sub");
+    DBWrite(f1, "later", &on, &on, 1, DB_INT);
+    DBWrite(f2, "later", &on, &on, 1, DB_INT);
+    DBClose(f1);
+    DBClose(f2);
+    err |= compare_files(indexed, plain);
+
+    /* Replacing an object with one of another type keeps the number of
+       links, so the index must be dropped some other way */
+    f1 = DBOpen(indexed, DB_HDF5_OPTS(optset), DB_APPEND);
+    f2 = DBOpen(plain, DB_HDF5, DB_APPEND);
+    DBSetDir(f1, "/dom_7");
+    DBSetDir(f2, "/dom_7");
+    {
+        float x[NX], y[NX];
+        for (i = 0; i < NX; i++) x[i] = y[i] = (float) i;
+        DBPutCurve(f1, "pressure", x, y, DB_FLOAT, NX, 0);
+        DBPutCurve(f2, "pressure", x, y, DB_FLOAT, NX, 0);
+    }
+    DBClose(f1);
+    DBClose(f2);
+    err |= compare_files(indexed, plain);
+
+    /* The same through paths from another directory, which must drop
+       the index of the object's directory rather than the current one */
+    f1 = DBOpen(indexed, DB_HDF5_OPTS(optset), DB_APPEND);
+    f2 = DBOpen(plain, DB_HDF5, DB_APPEND);
+    {
+        float x[NX], y[NX];
+        for (i = 0; i < NX; i++) x[i] = y[i] = (float) i;
+        DBPutCurve(f1, "dom_8/pressure", x, y, DB_FLOAT, NX, 0);
+        DBPutCurve(f2, "dom_8/pressure", x, y, DB_FLOAT, NX, 0);
+        DBSetDir(f1, "/dom_0");
+        DBSetDir(f2, "/dom_0");
+        DBPutCurve(f1, "/dom_9/pressure", x, y, DB_FLOAT, NX, 0);
+        DBPutCurve(f2, "/dom_9/pressure", x, y, DB_FLOAT, NX, 0);
+    }
+    DBClose(f1);
+    DBClose(f2);
+    err |= compare_files(indexed, plain);
+
+    DBUnregisterFileOptionsSet(optset);
+    DBFreeOptlist(opts);
+    CleanupDriverStuff();
+    return err;
+}
@@ -0,0 +1,247 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std.c>
+
+/* Exercises DBSetTrace: a trace of a small dump must hold balanced entry
+   and exit events for the outermost API calls only, with their names,
+   and a ring that overflows between dumps must report dropped events. */
+
+#define NX 10
+
+typedef struct trace_t
+{
+    char names[256][64];
+    int nnames;
+    int nevents;
+    int nenter;
+    int nexit;
+    long dropped;
+    long long nbytes;
+    int counts[256];
+} trace_t;
+
+static int
+read_trace(char const *filename, trace_t *t)
+{
+    FILE *f = fopen(filename, "rb");
+    char magic[8];
+    unsigned int hdr[4], i;
+    DBtraceevent e, last;
+
+    memset(t, 0, sizeof(*t));
+    memset(&last, 0, sizeof(last));
+    if (!f || fread(magic, 1, 8, f) != 8 || memcmp(magic, "SILOTRC1", 8) ||
+        fread(hdr, sizeof(unsigned int), 3, f) != 3 ||
+        hdr[0] != sizeof(DBtraceevent))
+    {
+        fprintf(stderr, "%s: bad header\n", filename);
+        return 1;
+    }
+    while (fread(hdr, sizeof(unsigned int), 4, f) == 4)
+    {
+        if (hdr[0] == DB_TRACE_BLOCK_NAMES)
+        {
+            char *buf = (char *) malloc(hdr[3]), *p = buf;
+            if (hdr[1] != (unsigned) t->nnames || hdr[1] + hdr[2] > 256 ||
+                fread(buf, 1, hdr[3], f) != hdr[3])
+            {
+                fprintf(stderr, "bad names block\n");
+                return 1;
+            }
+            for (i = 0; i < hdr[2]; i++, p += strlen(p) + 1)
+                strncpy(t->names[t->nnames++], p, 63);
+            free(buf);
+        }
+        else if (hdr[0] == DB_TRACE_BLOCK_EVENTS)
+        {
+            t->dropped += hdr[3];
+            for (i = 0; i < hdr[2]; i++)
+            {
+                if (fread(&e, sizeof(e), 1, f) != 1 || e.name >= (unsigned) t->nnames ||
+                    (e.kind != DB_TRACE_ENTER && e.kind != DB_TRACE_EXIT) ||
+                    (t->nevents && e.time < last.time))
+                {
+                    fprintf(stderr, "bad event %d\n", t->nevents);
+                    return 1;
+                }
+                if (e.kind == DB_TRACE_ENTER)
+                {
+                    t->nenter++;
+                    t->counts[e.name]++;
+                }
+                else
+                {
+                    t->nexit++;
+                    t->nbytes += e.nbytes;
+                    if (!hdr[3] && (last.kind != DB_TRACE_ENTER || last.name != e.name))
+                    {
+                        fprintf(stderr, "exit of %s does not follow its entry\n",
+                            t->names[e.name]);
+                        return 1;
+                    }
+                }
+                last = e;
+                t->nevents++;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "bad block %u\n", hdr[0]);
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int
+count(trace_t const *t, char const *name)
+{
+    int i;
+    for (i = 0; i < t->nnames; i++)
+        if (!strcmp(t->names[i], name))
+            return t->counts[i];
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, err = 0, driver = DB_PDB;
+    int show_all_errors = FALSE;
+    char const *filename = "trace.pdb";
+    float x[NX], y[NX], v[(NX-1)*(NX-1)];
+    float *coords[2] = {x, y};
+    int dims[2] = {NX, NX}, zdims[2] = {NX-1, NX-1};
+    DBquadvar *qv;
+    DBfile *dbfile;
+    trace_t *t = (trace_t *) malloc(sizeof(trace_t));
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            driver = StringToDriver(argv[i]);
+            filename = "trace.pdb";
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            driver = StringToDriver(argv[i]);
+            filename = "trace.h5";
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    for (i = 0; i < NX; i++) x[i] = y[i] = (float) i;
+    for (i = 0; i < (NX-1)*(NX-1); i++) v[i] = (float) i;
+
+    if (DBSetTrace(64, "trace.silotrace") != 0)
+    {
+        fprintf(stderr, "DBSetTrace failed\n");
+        return 1;
+    }
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "trace test", driver);
+    DBPutQuadmesh(dbfile, "mesh", 0, coords, dims, 2, DB_FLOAT, DB_COLLINEAR, 0);
+    DBPutQuadvar1(dbfile, "pressure", "mesh", v, zdims, 2, 0, 0, DB_FLOAT, DB_ZONECENT, 0);
+    DBClose(dbfile);
+
+    /* DBClose dumps, so the trace is complete but for DBClose's exit */
+    err |= read_trace("trace.silotrace", t);
+    if (!err && (count(t, "DBCreate") != 1 || count(t, "DBPutQuadmesh") != 1 ||
+        count(t, "DBPutQuadvar1") != 1 || count(t, "DBClose") != 1 ||
+        t->nenter != t->nexit + 1 || t->nbytes < (long long) sizeof(v) ||
+        t->dropped))
+    {
+        fprintf(stderr, "%d entries, %d exits, %lld bytes, %ld dropped\n",
+            t->nenter, t->nexit, t->nbytes, t->dropped);
+        err = 1;
+    }
+
+    /* Overflow the ring before the next dump; the events that survive
+       are the latest ones */
+    dbfile = DBOpen(filename, driver, DB_READ);
+    for (i = 0; i < 100; i++)
+    {
+        qv = DBGetQuadvar(dbfile, "pressure");
+        DBFreeQuadvar(qv);
+    }
+    DBClose(dbfile);
+    DBSetTrace(0, 0);
+    err |= read_trace("trace.silotrace", t);
+    if (!err && (t->dropped == 0 || count(t, "DBGetQuadvar") == 0 ||
+        count(t, "DBGetQuadvar") >= 100 || count(t, "DBSetTrace") != 1))
+    {
+        fprintf(stderr, "after overflow: %d DBGetQuadvar, %ld dropped\n",
+            count(t, "DBGetQuadvar"), t->dropped);
+        err = 1;
+    }
+
+    /* Nothing is recorded once tracing is off */
+    i = t->nevents;
+    dbfile = DBOpen(filename, driver, DB_READ);
+    DBClose(dbfile);
+    err |= read_trace("trace.silotrace", t);
+    if (!err && t->nevents != i)
+    {
+        fprintf(stderr, "events recorded with tracing off\n");
+        err = 1;
+    }
+
+    free(t);
+    CleanupDriverStuff();
+    return err;
+}
@@ -0,0 +1,218 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+States Government  nor Lawrence  Livermore National Security,  LLC nor
+any of  their employees,  makes any warranty,  express or  implied, or
+assumes   any   liability   or   responsibility  for   the   accuracy,
+completeness, or usefulness of any information, apparatus, product, or
+process  disclosed, or  represents  that its  use  would not  infringe
+privately-owned   rights.  Any  reference   herein  to   any  specific
+commercial products,  process, or  services by trade  name, trademark,
+manufacturer or otherwise does not necessarily constitute or imply its
+endorsement,  recommendation,   or  favoring  by   the  United  States
+Government or Lawrence Livermore National Security, LLC. The views and
+opinions  of authors  expressed  herein do  not  necessarily state  or
+reflect those  of the United  States Government or  Lawrence Livermore
+National  Security, LLC,  and shall  not  be used  for advertising  or
+product endorsement purposes.
+*/
+#include <silo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <std.c>
+
+#define NDOMS 48
+#define NSMALL 20
+#define NBIG 3000
+#define BLKSZ 4096
+
+static double
+val(int dom, int i)
+{
+    return (double) (dom * 100000 + i);
+}
+
+static int
+check_dom(DBfile *dbfile, int dom)
+{
+    char name[64];
+    float small[NSMALL];
+    double big[NBIG];
+    int i, err = 0;
+
+    memset(small, 0, sizeof(small));
+    memset(big, 0, sizeof(big));
+    sprintf(name, "/dom_%d/small", dom);
+    if (DBReadVar(dbfile, name, small) != 0) err = 1;
+    sprintf(name, "/dom_%d/big", dom);
+    if (DBReadVar(dbfile, name, big) != 0) err = 1;
+    for (i = 0; !err && i < NSMALL; i++)
+        if (small[i] != (float) val(dom, i)) err = 1;
+    for (i = 0; !err && i < NBIG; i++)
+        if (big[i] != val(dom, i)) err = 1;
+    if (err)
+        fprintf(stderr, "domain %d read back wrong\n", dom);
+    return err;
+}
+
+/* Return the count logged on the line beginning with label */
+static long
+logged_count(char const *logname, char const *label)
+{
+    char line[256];
+    long n = -1;
+    FILE *f = fopen(logname, "r");
+
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (!strncmp(line, label, strlen(label)))
+        {
+            n = atol(line + strlen(label));
+            break;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static int
+make_optset(DBoptlist **opts, int count, int ahead, int log)
+{
+    static int vfd = DB_H5VFD_SILO, blksz = BLKSZ;
+    static int ints[3][3], nsets = 0;
+    int *p = ints[nsets++];
+
+    p[0] = count; p[1] = ahead; p[2] = log;
+    *opts = DBMakeOptlist(5);
+    DBAddOption(*opts, DBOPT_H5_VFD, &vfd);
+    DBAddOption(*opts, DBOPT_H5_SILO_BLOCK_SIZE, &blksz);
+    DBAddOption(*opts, DBOPT_H5_SILO_BLOCK_COUNT, &p[0]);
+    DBAddOption(*opts, DBOPT_H5_SILO_READ_AHEAD, &p[1]);
+    DBAddOption(*opts, DBOPT_H5_SILO_LOG_STATS, &p[2]);
+    return DBRegisterFileOptionsSet(*opts);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, j, err = 0;
+    int show_all_errors = FALSE;
+    int wrset, rdset, nocacheset;
+    int dims[1];
+    char const *filename = "vfd_readahead.h5";
+    char const *logname = "vfd_readahead.h5-h5-vfd-log";
+    float small[NSMALL];
+    double big[NBIG];
+    DBoptlist *wropts, *rdopts, *nocacheopts;
+    DBfile *dbfile;
+    long used, uncached;
+
+    for (i=1; i<argc; i++) {
+        if (!strncmp(argv[i], "DB_PDB", 6)) {
+            fprintf(stderr, "The silo block VFD applies only to the HDF5 driver; skipping\n");
+            return 77;
+        } else if (!strncmp(argv[i], "DB_HDF5", 7)) {
+            continue; /* uses its own options sets */
+        } else if (!strcmp(argv[i], "show-all-errors")) {
+            show_all_errors = 1;
+        } else if (argv[i][0] != '\0') {
+            fprintf(stderr, "%s: ignored argument `%s'\n", argv[0], argv[i]);
+        }
+    }
+
+    if (show_all_errors) DBShowErrors(DB_ALL_AND_DRVR, 0);
+
+    wrset = make_optset(&wropts, 16, 0, 0);
+    rdset = make_optset(&rdopts, 16, 4, 1);
+    nocacheset = make_optset(&nocacheopts, 4, 0, 0);
+
+    /* Many small domain groups, each with a little and a big variable */
+    dbfile = DBCreate(filename, DB_CLOBBER, DB_LOCAL, "silo vfd read ahead test",
+        DB_HDF5_OPTS(wrset));
+    for (i = 0; i < NDOMS; i++)
+    {
+        char dirname[32];
+        for (j = 0; j < NSMALL; j++) small[j] = (float) val(i, j);
+        for (j = 0; j < NBIG; j++) big[j] = val(i, j);
+        sprintf(dirname, "dom_%d", i);
+        DBMkDir(dbfile, dirname);
+        DBSetDir(dbfile, dirname);
+        dims[0] = NSMALL;
+        DBWrite(dbfile, "small", small, dims, 1, DB_FLOAT);
+        dims[0] = NBIG;
+        DBWrite(dbfile, "big", big, dims, 1, DB_DOUBLE);
+        DBSetDir(dbfile, "..");
+    }
+    DBClose(dbfile);
+
+    /* Forward sweep, as a reader of PMPIO domain groups does */
+    unlink(logname);
+    dbfile = DBOpen(filename, DB_HDF5_OPTS(rdset), DB_READ);
+    for (i = 0; i < NDOMS; i++)
+        err |= check_dom(dbfile, i);
+    DBClose(dbfile);
+
+    used = logged_count(logname, "number of read ahead blocks used = ");
+    uncached = logged_count(logname, "number of uncached raw reads = ");
+    if (used <= 0)
+    {
+        fprintf(stderr, "no read ahead blocks were used (%ld)\n", used);
+        err = 1;
+    }
+    if (uncached <= 0)
+    {
+        fprintf(stderr, "no raw data bypassed the block cache (%ld)\n", uncached);
+        err = 1;
+    }
+
+    /* Backward sweep through a tiny cache, evicting constantly */
+    dbfile = DBOpen(filename, DB_HDF5_OPTS(nocacheset), DB_READ);
+    for (i = NDOMS-1; i >= 0; i--)
+        err |= check_dom(dbfile, i);
+    DBClose(dbfile);
+
+    DBUnregisterFileOptionsSet(wrset);
+    DBUnregisterFileOptionsSet(rdset);
+    DBUnregisterFileOptionsSet(nocacheset);
+    DBFreeOptlist(wropts);
+    DBFreeOptlist(rdopts);
+    DBFreeOptlist(nocacheopts);
+    CleanupDriverStuff();
+    return err;
+}
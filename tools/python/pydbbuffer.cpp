@@ -0,0 +1,446 @@
+// Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+// LLNL-CODE-425250.
+// All rights reserved.
+// 
+// This file is part of Silo. For details, see silo.llnl.gov.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 
+//    * Redistributions of source code must retain the above copyright
+//      notice, this list of conditions and the disclaimer below.
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the disclaimer (as noted
+//      below) in the documentation and/or other materials provided with
+//      the distribution.
+//    * Neither the name of the LLNS/LLNL nor the names of its
+//      contributors may be used to endorse or promote products derived
+//      from this software without specific prior written permission.
+// 
+// THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+// "AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+// LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+// LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+// CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+// PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+// NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+// This work was produced at Lawrence Livermore National Laboratory under
+// Contract  No.   DE-AC52-07NA27344 with  the  DOE.  Neither the  United
+// States Government  nor Lawrence  Livermore National Security,  LLC nor
+// any of  their employees,  makes any warranty,  express or  implied, or
+// assumes   any   liability   or   responsibility  for   the   accuracy,
+// completeness, or usefulness of any information, apparatus, product, or
+// process  disclosed, or  represents  that its  use  would not  infringe
+// privately-owned   rights.  Any  reference   herein  to   any  specific
+// commercial products,  process, or  services by trade  name, trademark,
+// manufacturer or otherwise does not necessarily constitute or imply its
+// endorsement,  recommendation,   or  favoring  by   the  United  States
+// Government or Lawrence Livermore National Security, LLC. The views and
+// opinions  of authors  expressed  herein do  not  necessarily state  or
+// reflect those  of the United  States Government or  Lawrence Livermore
+// National  Security, LLC,  and shall  not  be used  for advertising  or
+// product endorsement purposes.
+
+#include "pydbbuffer.h"
+#include "pysilo.h"
+
+#include <stdlib.h>
+
+// ****************************************************************************
+//  Method:  DBbuffer_Format
+//
+//  Purpose:
+//    Return the buffer protocol format of a Silo datatype and the size of
+//    one value, or NULL if the datatype has none.
+//
+// ****************************************************************************
+static char const *DBbuffer_Format(int datatype, Py_ssize_t *itemsize)
+{
+    switch (datatype)
+    {
+      case DB_CHAR:      *itemsize = sizeof(char);      return "b";
+      case DB_SHORT:     *itemsize = sizeof(short);     return "h";
+      case DB_INT:       *itemsize = sizeof(int);       return "i";
+      case DB_LONG:      *itemsize = sizeof(long);      return "l";
+      case DB_LONG_LONG: *itemsize = sizeof(long long); return "q";
+      case DB_FLOAT:     *itemsize = sizeof(float);     return "f";
+      case DB_DOUBLE:    *itemsize = sizeof(double);    return "d";
+    }
+    *itemsize = 0;
+    return NULL;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_Itemsize
+//
+//  Purpose:
+//    Return the size of one value of a Silo datatype, or 0 if a DBbuffer
+//    cannot hold it.
+//
+// ****************************************************************************
+Py_ssize_t DBbuffer_Itemsize(int datatype)
+{
+    Py_ssize_t itemsize;
+    DBbuffer_Format(datatype, &itemsize);
+    return itemsize;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_Datatype
+//
+//  Purpose:
+//    Return the Silo datatype of the values of a buffer another object
+//    exported, or -1 if Silo has none for them. Bytes are DB_CHAR.
+//
+// ****************************************************************************
+int DBbuffer_Datatype(Py_buffer const *view)
+{
+    char const *format = view->format ? view->format : "B";
+    int datatype;
+    Py_ssize_t itemsize;
+
+    if (*format == '@' || *format == '=')
+        format++;
+    if (!format[0] || format[1])
+        return -1;
+    switch (format[0])
+    {
+      case 'c': case 'b': case 'B': datatype = DB_CHAR;      break;
+      case 'h':                     datatype = DB_SHORT;     break;
+      case 'i':                     datatype = DB_INT;       break;
+      case 'l':                     datatype = DB_LONG;      break;
+      case 'q':                     datatype = DB_LONG_LONG; break;
+      case 'f':                     datatype = DB_FLOAT;     break;
+      case 'd':                     datatype = DB_DOUBLE;    break;
+      default:                      return -1;
+    }
+    DBbuffer_Format(datatype, &itemsize);
+    return view->itemsize == itemsize ? datatype : -1;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_Count
+//
+//  Purpose:
+//    Return the number of values in the buffer.
+//
+// ****************************************************************************
+static Py_ssize_t DBbuffer_Count(PyObject *self)
+{
+    DBbufferObject *obj = (DBbufferObject*)self;
+    Py_ssize_t n = 1;
+    for (int i = 0; i < obj->ndims; i++)
+        n *= obj->shape[i];
+    return n;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_dealloc
+//
+//  Purpose:
+//    Free the values and the object.
+//
+// ****************************************************************************
+static void DBbuffer_dealloc(PyObject *self)
+{
+    free(((DBbufferObject*)self)->data);
+    PyObject_Del(self);
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_getbuffer
+//
+//  Purpose:
+//    Export the values as a writable C-contiguous array. Exports keep a
+//    reference to the object, so the values outlive the object's last
+//    reference from Python code.
+//
+// ****************************************************************************
+static int DBbuffer_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    DBbufferObject *obj = (DBbufferObject*)self;
+    Py_ssize_t itemsize;
+    char const *format = DBbuffer_Format(obj->datatype, &itemsize);
+
+    view->buf = obj->data;
+    view->obj = self;
+    Py_INCREF(self);
+    view->len = DBbuffer_Count(self) * itemsize;
+    view->itemsize = itemsize;
+    view->readonly = 0;
+    view->format = (flags & PyBUF_FORMAT) ? (char *) format : NULL;
+    view->ndim = obj->ndims;
+    view->shape = (flags & PyBUF_ND) ? obj->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? obj->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_length
+//
+//  Purpose:
+//    Return the number of values, for len().
+//
+// ****************************************************************************
+static Py_ssize_t DBbuffer_length(PyObject *self)
+{
+    return DBbuffer_Count(self);
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_item
+//
+//  Purpose:
+//    Return the value at a flat index as a Python scalar, so the buffer
+//    can be indexed and iterated without NumPy or a memoryview.
+//
+// ****************************************************************************
+static PyObject *DBbuffer_item(PyObject *self, Py_ssize_t i)
+{
+    DBbufferObject *obj = (DBbufferObject*)self;
+
+    if (i < 0 || i >= DBbuffer_Count(self))
+    {
+        PyErr_SetString(PyExc_IndexError, "DBbuffer index out of range");
+        return NULL;
+    }
+    switch (obj->datatype)
+    {
+      case DB_CHAR:      return PyInt_FromLong((long)((char*)obj->data)[i]);
+      case DB_SHORT:     return PyInt_FromLong((long)((short*)obj->data)[i]);
+      case DB_INT:       return PyInt_FromLong((long)((int*)obj->data)[i]);
+      case DB_LONG:      return PyInt_FromLong(((long*)obj->data)[i]);
+      case DB_LONG_LONG: return PyLong_FromLongLong(((long long*)obj->data)[i]);
+      case DB_FLOAT:     return PyFloat_FromDouble((double)((float*)obj->data)[i]);
+      case DB_DOUBLE:    return PyFloat_FromDouble(((double*)obj->data)[i]);
+    }
+    SiloErrorFunc("Unknown variable type.");
+    return NULL;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_as_string
+//
+//  Purpose:
+//    Convert the DBbufferObject to a string representation.
+//
+//  Arguments:
+//    s          the target string, with space already allocated
+//
+// ****************************************************************************
+static void DBbuffer_as_string(PyObject *self, char *s)
+{
+    DBbufferObject *obj = (DBbufferObject*)self;
+    Py_ssize_t itemsize;
+
+    sprintf(s, "<DBbuffer object, format='%s', shape=(",
+        DBbuffer_Format(obj->datatype, &itemsize));
+    for (int i = 0; i < obj->ndims; i++)
+        sprintf(s + strlen(s), i ? ", %ld" : "%ld", (long) obj->shape[i]);
+    strcat(s, obj->ndims == 1 ? ",)>" : ")>");
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_str
+//
+//  Purpose:
+//    Convert the DBbufferObject to a PyString
+//
+// ****************************************************************************
+static PyObject *DBbuffer_str(PyObject *self)
+{
+    char str[1000];
+    DBbuffer_as_string(self, str);
+    return PyString_FromString(str);
+}
+
+// ****************************************************************************
+//  Method: DBbuffer_getattr
+//
+//  Purpose:
+//    Return an attribute by name: the Silo datatype of the values or
+//    their shape.
+//
+//  Arguments:
+//    name       the name of the attribute to return
+//
+// ****************************************************************************
+static PyObject *DBbuffer_getattr(PyObject *self, char *name)
+{
+    DBbufferObject *obj = (DBbufferObject*)self;
+
+    if (!strcmp(name, "datatype"))
+        return PyInt_FromLong(obj->datatype);
+    if (!strcmp(name, "shape"))
+    {
+        PyObject *shape = PyTuple_New(obj->ndims);
+        for (int i = 0; shape && i < obj->ndims; i++)
+            PyTuple_SET_ITEM(shape, i, PyInt_FromLong((long) obj->shape[i]));
+        return shape;
+    }
+    PyErr_SetString(PyExc_AttributeError, name);
+    return NULL;
+}
+
+static PySequenceMethods DBbuffer_as_sequence =
+{
+    (lenfunc)DBbuffer_length,            // sq_length
+    0,                                   // sq_concat
+    0,                                   // sq_repeat
+    (ssizeargfunc)DBbuffer_item,         // sq_item
+};
+
+static PyBufferProcs DBbuffer_as_buffer =
+{
+#if !PY_VERSION_GE(3,0,0)
+    0, 0, 0, 0,                          // old buffer protocol
+#endif
+    (getbufferproc)DBbuffer_getbuffer,   // bf_getbuffer
+    0                                    // bf_releasebuffer
+};
+
+#if PY_VERSION_GE(3,0,0)
+    #define DBBUFFER_TPFLAGS Py_TPFLAGS_DEFAULT
+#else
+    #define DBBUFFER_TPFLAGS (Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER)
+#endif
+
+// ****************************************************************************
+//  DBbuffer Python Type Object
+//
+// ****************************************************************************
+PyTypeObject DBbufferType =
+{
+    //
+    // Type header
+    //
+    PyVarObject_HEAD_INIT(&PyType_Type,0)
+    "DBbuffer",                          // tp_name
+    sizeof(DBbufferObject),              // tp_basicsize
+    0,                                   // tp_itemsize
+
+    //
+    // Standard methods
+    //
+    (destructor)DBbuffer_dealloc,        // tp_dealloc
+    0,                                   // tp_print
+    (getattrfunc)DBbuffer_getattr,       // tp_getattr
+    0,                                   // tp_setattr -- this object is read-only
+    0,                                   // tp_compare -- removed in python 3
+    (reprfunc)DBbuffer_str,              // tp_repr
+
+    //
+    // Type categories
+    //
+    0,                                   // tp_as_number
+    &DBbuffer_as_sequence,               // tp_as_sequence
+    0,                                   // tp_as_mapping
+
+    //
+    // More methods
+    //
+    0,                                   // tp_hash
+    0,                                   // tp_call
+    (reprfunc)DBbuffer_str,              // tp_str
+    0,                                   // tp_getattro
+    0,                                   // tp_setattro
+    &DBbuffer_as_buffer,                 // tp_as_buffer
+    DBBUFFER_TPFLAGS,                    // tp_flags
+    "Silo-allocated values exported through the buffer protocol.", // tp_doc
+    0,                                   // tp_traverse
+    0,                                   // tp_clear
+    0,                                   // tp_richcompare
+    0                                    // tp_weaklistoffset
+};
+
+// ****************************************************************************
+//  Method:  DBbuffer_NEW
+//
+//  Purpose:
+//    Wrap an array of values Silo allocated with malloc, taking ownership
+//    of it. The array is freed if the object cannot be made.
+//
+//  Arguments:
+//    data       the values
+//    datatype   their Silo datatype
+//    ndims      the number of dimensions of the array
+//    dims       the size of each dimension, slowest varying first
+//
+// ****************************************************************************
+PyObject *DBbuffer_NEW(void *data, int datatype, int ndims, int const *dims)
+{
+    Py_ssize_t itemsize;
+
+    if (!DBbuffer_Format(datatype, &itemsize))
+    {
+        free(data);
+        SiloErrorFunc("Unknown variable type.");
+        return NULL;
+    }
+    if (ndims < 1 || ndims > DBBUFFER_MAXDIMS)
+    {
+        free(data);
+        SiloErrorFunc("Too many dimensions for a DBbuffer.");
+        return NULL;
+    }
+
+    DBbufferObject *obj = PyObject_NEW(DBbufferObject, &DBbufferType);
+    if (!obj)
+    {
+        free(data);
+        return NULL;
+    }
+    obj->data = data;
+    obj->datatype = datatype;
+    obj->ndims = ndims;
+    for (int i = ndims - 1; i >= 0; i--)
+    {
+        obj->shape[i] = dims[i];
+        obj->strides[i] = i == ndims - 1 ? itemsize : obj->strides[i+1] * dims[i+1];
+    }
+    return (PyObject*)obj;
+}
+
+// ****************************************************************************
+//  Method:  DBbuffer_AsArray
+//
+//  Purpose:
+//    Return a NumPy array viewing the values of a DBbuffer when NumPy can
+//    be imported, or else the DBbuffer itself. Steals the reference to
+//    the buffer, which the array keeps alive.
+//
+// ****************************************************************************
+PyObject *DBbuffer_AsArray(PyObject *buffer)
+{
+    static PyObject *asarray = NULL;
+    static bool triedNumPy = false;
+
+    if (!buffer)
+        return NULL;
+    if (!triedNumPy)
+    {
+        triedNumPy = true;
+        PyObject *numpy = PyImport_ImportModule("numpy");
+        if (numpy)
+        {
+            asarray = PyObject_GetAttrString(numpy, "asarray");
+            Py_DECREF(numpy);
+        }
+        PyErr_Clear();
+    }
+    if (!asarray)
+        return buffer;
+
+    PyObject *array = PyObject_CallFunctionObjArgs(asarray, buffer, NULL);
+    Py_DECREF(buffer);
+    return array;
+}
@@ -48,10 +48,12 @@
 // National  Security, LLC,  and shall  not  be used  for advertising  or
 // product endorsement purposes.
 
+#include "pydbbuffer.h"
 #include "pydbfile.h"
 #include "pydbtoc.h"
 #include "pysilo.h"
 
+#include <climits>
 #include <string>
 
 using std::string;
@@ -251,6 +253,277 @@ static PyObject *DBfile_DBGetVar(PyObject *self, PyObject *args)
     return NULL;
 }
 
+// ****************************************************************************
+//  Method:  DBfile_GetInts
+//
+//  Purpose:
+//    Convert a Python int, or a tuple or list of them, to at most MAXN
+//    ints. Returns how many there are, or -1 with a TypeError set.
+//
+// ****************************************************************************
+static int DBfile_GetInts(PyObject *obj, int *vals, int maxn, char const *what)
+{
+    char msg[256];
+
+    if (PyInt_Check(obj))
+    {
+        vals[0] = (int) PyInt_AS_LONG(obj);
+        return 1;
+    }
+    if ((PyTuple_Check(obj) || PyList_Check(obj)) &&
+        PySequence_Size(obj) > 0 && PySequence_Size(obj) <= maxn)
+    {
+        int n = (int) PySequence_Size(obj);
+        for (int i = 0; i < n; i++)
+        {
+            PyObject *item = PySequence_GetItem(obj, i);
+            if (!PyInt_Check(item))
+            {
+                Py_DECREF(item);
+                break;
+            }
+            vals[i] = (int) PyInt_AS_LONG(item);
+            Py_DECREF(item);
+            if (i == n - 1)
+                return n;
+        }
+    }
+    snprintf(msg, sizeof(msg), "%s must be an int or a tuple of at most %d ints",
+        what, maxn);
+    PyErr_SetString(PyExc_TypeError, msg);
+    return -1;
+}
+
+// ****************************************************************************
+//  Method:  DBfile_DBGetVarArray
+//
+//  Purpose:
+//    Like GetVar, but return the values of a variable without converting
+//    them to Python objects, as a NumPy array when NumPy is available or
+//    otherwise as a DBbuffer exporting them through the buffer protocol.
+//
+//  Python Arguments:
+//    form 1: varname
+//
+// ****************************************************************************
+static PyObject *DBfile_DBGetVarArray(PyObject *self, PyObject *args)
+{
+    DBfile *db = ((DBfileObject*)self)->db;
+
+    if (!db)
+    {
+        SiloErrorFunc("This file has been closed.");
+        return NULL;
+    }
+
+    char *str;
+    if (!PyArg_ParseTuple(args, "s", &str))
+        return NULL;
+
+    char msg[256];
+    int dims[DBBUFFER_MAXDIMS];
+    int ndims = DBGetVarDims(db, str, DBBUFFER_MAXDIMS, dims);
+    int type = DBGetVarType(db, str);
+    if (ndims < 1 || type < 0)
+    {
+        snprintf(msg, sizeof(msg), "Unable to get the dims and type of \"%s\"", str);
+        SiloErrorFunc(msg);
+        return NULL;
+    }
+    void *var = DBGetVar(db, str);
+    if (!var)
+    {
+        snprintf(msg, sizeof(msg), "Unable to read \"%s\"", str);
+        SiloErrorFunc(msg);
+        return NULL;
+    }
+    return DBbuffer_AsArray(DBbuffer_NEW(var, type, ndims, dims));
+}
+
+// ****************************************************************************
+//  Method:  DBfile_DBReadVarSlice
+//
+//  Purpose:
+//    Encapsulates DBReadVarSlice. Returns the slice like GetVarArray.
+//
+//  Python Arguments:
+//    form 1: varname, offset, length
+//    form 2: varname, offset, length, stride
+//    Each of offset, length and stride is an int or a tuple of one int
+//    per dimension.
+//
+// ****************************************************************************
+static PyObject *DBfile_DBReadVarSlice(PyObject *self, PyObject *args)
+{
+    DBfile *db = ((DBfileObject*)self)->db;
+
+    if (!db)
+    {
+        SiloErrorFunc("This file has been closed.");
+        return NULL;
+    }
+
+    char *str;
+    PyObject *offsetObj, *lengthObj, *strideObj = NULL;
+    if (!PyArg_ParseTuple(args, "sOO|O", &str, &offsetObj, &lengthObj, &strideObj))
+        return NULL;
+
+    int offset[DBBUFFER_MAXDIMS], length[DBBUFFER_MAXDIMS], stride[DBBUFFER_MAXDIMS];
+    int ndims = DBfile_GetInts(offsetObj, offset, DBBUFFER_MAXDIMS, "offset");
+    if (ndims < 0)
+        return NULL;
+    if (DBfile_GetInts(lengthObj, length, ndims, "length") != ndims)
+    {
+        PyErr_SetString(PyExc_TypeError, "offset and length must have the same size");
+        return NULL;
+    }
+    if (!strideObj)
+    {
+        for (int i = 0; i < ndims; i++)
+            stride[i] = 1;
+    }
+    else if (DBfile_GetInts(strideObj, stride, ndims, "stride") != ndims)
+    {
+        PyErr_SetString(PyExc_TypeError, "offset and stride must have the same size");
+        return NULL;
+    }
+
+    // The slice has ceil(length/stride) values in each dimension
+    int dims[DBBUFFER_MAXDIMS];
+    long long nvals = 1;
+    for (int i = 0; i < ndims; i++)
+    {
+        if (offset[i] < 0 || length[i] < 1 || stride[i] < 1)
+        {
+            PyErr_SetString(PyExc_ValueError,
+                "offset must be >= 0 and length and stride > 0");
+            return NULL;
+        }
+        dims[i] = (length[i] + stride[i] - 1) / stride[i];
+        nvals *= dims[i];
+    }
+
+    char msg[256];
+    Py_ssize_t itemsize;
+    int type = DBGetVarType(db, str);
+    if (type < 0 || (itemsize = DBbuffer_Itemsize(type)) <= 0)
+    {
+        snprintf(msg, sizeof(msg), "Unable to get the type of \"%s\"", str);
+        SiloErrorFunc(msg);
+        return NULL;
+    }
+    void *var = malloc((size_t) (nvals * itemsize));
+    if (!var)
+        return PyErr_NoMemory();
+    if (DBReadVarSlice(db, str, offset, length, stride, ndims, var) < 0)
+    {
+        free(var);
+        snprintf(msg, sizeof(msg), "Unable to read a slice of \"%s\"", str);
+        SiloErrorFunc(msg);
+        return NULL;
+    }
+    return DBbuffer_AsArray(DBbuffer_NEW(var, type, ndims, dims));
+}
+
+// ****************************************************************************
+//  Method:  DBfile_DBReadVarVals
+//
+//  Purpose:
+//    Encapsulates DBReadVarVals for the points of a variable. Returns the
+//    values in the order of their indices, like GetVarArray.
+//
+//  Python Arguments:
+//    form 1: varname, indices
+//    indices is a sequence of ints for a 1D variable, a sequence of tuples
+//    of one int per dimension, or an (nvals, ndims) buffer of ints.
+//
+// ****************************************************************************
+static PyObject *DBfile_DBReadVarVals(PyObject *self, PyObject *args)
+{
+    DBfile *db = ((DBfileObject*)self)->db;
+
+    if (!db)
+    {
+        SiloErrorFunc("This file has been closed.");
+        return NULL;
+    }
+
+    char *str;
+    PyObject *indicesObj;
+    if (!PyArg_ParseTuple(args, "sO", &str, &indicesObj))
+        return NULL;
+
+    int nvals = 0, ndims = 0;
+    int *indices = NULL;
+    Py_buffer view;
+    bool haveView = false;
+    if (PyObject_CheckBuffer(indicesObj))
+    {
+        if (PyObject_GetBuffer(indicesObj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+            return NULL;
+        haveView = true;
+        if (DBbuffer_Datatype(&view) != DB_INT || view.ndim < 1 || view.ndim > 2 ||
+            view.shape[0] < 1)
+        {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_TypeError, "indices must be a 1D or 2D buffer of ints");
+            return NULL;
+        }
+        nvals = (int) view.shape[0];
+        ndims = view.ndim == 2 ? (int) view.shape[1] : 1;
+        indices = (int *) view.buf;
+    }
+    else if (PySequence_Check(indicesObj) && PySequence_Size(indicesObj) > 0)
+    {
+        nvals = (int) PySequence_Size(indicesObj);
+        for (int i = 0; i < nvals; i++)
+        {
+            int point[DBBUFFER_MAXDIMS];
+            PyObject *item = PySequence_GetItem(indicesObj, i);
+            int n = DBfile_GetInts(item, point, DBBUFFER_MAXDIMS, "each index");
+            Py_DECREF(item);
+            if (n < 0 || (i > 0 && n != ndims))
+            {
+                delete [] indices;
+                if (n >= 0)
+                    PyErr_SetString(PyExc_TypeError, "indices must all have the same size");
+                return NULL;
+            }
+            if (i == 0)
+            {
+                ndims = n;
+                indices = new int[nvals * ndims];
+            }
+            for (int j = 0; j < ndims; j++)
+                indices[i * ndims + j] = point[j];
+        }
+    }
+    else
+    {
+        PyErr_SetString(PyExc_TypeError, "indices must be a non-empty sequence or a buffer");
+        return NULL;
+    }
+
+    char msg[256];
+    void *var = NULL;
+    int ncomps = 0, nitems = 0;
+    int type = DBInqVarType(db, str) == DB_VARIABLE ? DBGetVarType(db, str) : -1;
+    int err = type < 0 ? -1 : DBReadVarVals(db, str, DB_PARTIO_POINTS, nvals, ndims,
+                                            indices, &var, &ncomps, &nitems);
+    if (haveView)
+        PyBuffer_Release(&view);
+    else
+        delete [] indices;
+    if (err < 0 || !var || ncomps != 1)
+    {
+        free(var);
+        snprintf(msg, sizeof(msg), "Unable to read values of variable \"%s\"", str);
+        SiloErrorFunc(msg);
+        return NULL;
+    }
+    return DBbuffer_AsArray(DBbuffer_NEW(var, type, 1, &nitems));
+}
+
 // ****************************************************************************
 //  Method:  DBfile_DBGetVarInfo
 //
@@ -418,6 +691,7 @@ static PyObject *DBfile_DBGetVarInfo(PyObject *self, PyObject *args)
 //    form 2: varname, real
 //    form 3: varname, string
 //    form 4: varname, tuple
+//    form 5: varname, C-contiguous buffer (e.g. a NumPy array)
 //
 //  Programmer:  Jeremy Meredith
 //  Creation:    July 12, 2005
@@ -426,6 +700,9 @@ static PyObject *DBfile_DBGetVarInfo(PyObject *self, PyObject *args)
 //  Mark C. Miller, Thu Dec 20 00:05:41 PST 2012
 //  Adjust parsing logic to avoid deprecation warning for parsing a float into
 //  an integer variable.
+//
+//  Write any object exporting a C-contiguous buffer of a Silo datatype
+//  straight from its memory, with its shape as the variable's dims.
 // ****************************************************************************
 static PyObject *DBfile_DBWrite(PyObject *self, PyObject *args)
 {
@@ -444,8 +721,38 @@ static PyObject *DBfile_DBWrite(PyObject *self, PyObject *args)
     int ivar;
     double dvar;
     char *svar;
-    PyObject *tuple;
-    if (PyArg_ParseTuple(args, "sd", &str, &dvar))
+    PyObject *tuple, *bufobj;
+    if (PyArg_ParseTuple(args, "sO", &str, &bufobj) && PyObject_CheckBuffer(bufobj) &&
+        !PyString_Check(bufobj))
+    {
+        Py_buffer view;
+        if (PyObject_GetBuffer(bufobj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+            return NULL;
+
+        int type = DBbuffer_Datatype(&view);
+        int ndims = view.ndim > 0 ? view.ndim : 1;
+        int *bufdims = new int[ndims];
+        bufdims[0] = 1;
+        for (int i = 0; i < view.ndim; i++)
+        {
+            if (view.shape[i] < 1 || view.shape[i] > INT_MAX)
+                type = -1;
+            bufdims[i] = (int) view.shape[i];
+        }
+        if (type < 0)
+        {
+            delete [] bufdims;
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_TypeError,
+                "Only non-empty buffers of char, short, int, long, long long, "
+                "float or double are supported");
+            return NULL;
+        }
+        err = DBWrite(db, str, view.buf, bufdims, ndims, type);
+        delete [] bufdims;
+        PyBuffer_Release(&view);
+    }
+    else if (PyArg_ParseTuple(args, "sd", &str, &dvar))
     {
         dims = 1;
         if (dvar == (int) dvar)
@@ -831,6 +1138,27 @@ static struct PyMethodDef DBfile_methods[] = {
         ">>> x = db.GetVar('cycle')\n"
         ">>> print(x)\n"
         "48\n"},
+    {"GetVarArray", DBfile_DBGetVarArray, METH_VARARGS,
+        "Return a Silo variable's values without copying them, as a NumPy array\n"
+        "when NumPy is available or else as a DBbuffer object that supports the\n"
+        "buffer protocol, len() and indexing. For example...\n"
+        ">>> db = Silo.Open('globe.silo')\n"
+        ">>> x = db.GetVarArray('dx_data')\n"
+        ">>> memoryview(x).shape\n"
+        "(1200,)\n"},
+    {"ReadVarSlice", DBfile_DBReadVarSlice, METH_VARARGS,
+        "Return a hyperslab of a Silo variable like GetVarArray. Offset, length and\n"
+        "optional stride are ints or tuples with an int per dimension. For example...\n"
+        ">>> x = db.ReadVarSlice('dx_data', 100, 10, 2)\n"
+        ">>> len(x)\n"
+        "5\n"},
+    {"ReadVarVals", DBfile_DBReadVarVals, METH_VARARGS,
+        "Return the values of a Silo variable at the given indices like GetVarArray.\n"
+        "Indices are ints, tuples of an int per dimension or a 2D buffer of ints.\n"
+        "For example...\n"
+        ">>> x = db.ReadVarVals('dx_data', (0, 10, 1199))\n"
+        ">>> len(x)\n"
+        "3\n"},
     {"GetVarInfo", DBfile_DBGetVarInfo, METH_VARARGS,
         "Return either metadata or metadata+rawdata for any Silo object. For example...\n"
         ">>> db = Silo.Open('globe.silo')\n"
@@ -844,10 +1172,13 @@ static struct PyMethodDef DBfile_methods[] = {
         "{'name': 'dx', 'type': 'ucdvar', 'meshid': 'mesh1',\n"
         " 'value0': (0.125606125, 0.113311, 0.089924125, 0.057734875, ...\n"},
     {"Write", DBfile_DBWrite, METH_VARARGS,
-        "Write a miscellaneous scalar or array to a Silo file. For example...\n"
+        "Write a miscellaneous scalar or array to a Silo file. Arrays are tuples,\n"
+        "or objects with a C-contiguous buffer such as NumPy arrays, which are\n"
+        "written without copying. For example...\n"
         ">>> db = Silo.Create('foo.silo', 'no comment', Silo.DB_PDB, Silo.DB_CLOBBER)\n"
         ">>> x=(1,2,3,4)\n"
         ">>> db.Write('x', x)\n"
+        ">>> db.Write('y', array.array('d', x))\n"
         ">>> db.Close()\n"},
     {"WriteObject", DBfile_DBWriteObject, METH_VARARGS,
         "Write a Silo object to a Silo file. For example...\n"
@@ -50,6 +50,7 @@
 
 #include <Python.h>
 #include <silo.h>
+#include "pydbbuffer.h"
 #include "pydbfile.h"
 #include "pysilo.h"
 
@@ -225,6 +226,8 @@ PyObject *silo_Create(PyObject *self, PyObject *args)
 //    Added a slew of constants so calllers can properly examine dict
 //    contents returned by GetVarInfo method.
 //
+//    Added the DBbuffer type.
+//
 // ****************************************************************************
 #define ADD_CONSTANT(C)  PyDict_SetItemString(d, #C, PyInt_FromLong(C))
 extern "C"
@@ -338,6 +341,13 @@ void initSilo(void)
     ADD_CONSTANT(DB_ZONETYPE_PRISM);
     ADD_CONSTANT(DB_ZONETYPE_HEX);
 
+    // The buffer type's slots must be readied before any export
+    if (PyType_Ready(&DBbufferType) == 0)
+    {
+        Py_INCREF(&DBbufferType);
+        PyModule_AddObject(siloModule, "DBbuffer", (PyObject *) &DBbufferType);
+    }
+
 #if PY_VERSION_GE(3,0,0)
 
     Py_INCREF(&DBfileType);
@@ -61,6 +61,11 @@ be used for advertising or product endorsement purposes.
  *      Mark C. Miller, Thu Nov  5 10:49:43 PST 2009
  *      Added logic to handle an HDF5 file without friendly names.
  *      Added isinf to test for valid float/double.
+ *
+ *      Arrays are read in slices of SLICE_BYTES with DBReadVarSlice and
+ *      classified a block at a time by testing exponent bits, and
+ *      progress is updated per slice. Several files may be given and
+ *      -j scans them on a pool of worker processes.
  *-------------------------------------------------------------------------
  */
 #include <config.h>
@@ -68,9 +73,13 @@ be used for advertising or product endorsement purposes.
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <silo.h>
 #ifdef HAVE_IEEEFP_H
 #include <ieeefp.h>
@@ -79,7 +88,9 @@ be used for advertising or product endorsement purposes.
 #define True                    1
 #define False                   0
 #define UPDATE_INTERVAL         5      /* seconds */
-#define INITIAL_CHECK_RATE      500000 /* tests per second */
+#define SLICE_BYTES             (8<<20) /* bytes read per DBReadVarSlice */
+#define BLOCK_SIZE              1024   /* values classified per block */
+#define MAX_DIMS                8
 
 
 /* if isnan is not available, this tool cannot operate. So, we define
@@ -93,20 +104,23 @@ be used for advertising or product endorsement purposes.
 #define IS_VALID_DOUBLE(val)        ((val)!=0.0)  /* bogus test */
 #endif
 
+/* An IEEE value is a NaN or an Inf when all of its exponent bits are set */
+#define FLT_EXP_MASK            0x7f800000U
+#define DBL_EXP_MASK            0x7ff0000000000000ULL
+
 int disableProgress;
 int disableVerbose;
-int totalBytes;
+int multiFile;
+long long totalBytes;
 char fileName[1024];
 
-int fBufSize;
-int dBufSize;
-float  *fBuf;
-double *dBuf;
+size_t sliceBufSize;
+void *sliceBuf;
 
 
 /* this function is only called if a NaN issue has been discovered */
 static void
-handleInvalidValue(char *theDir, char *varName, int index, double value)
+handleInvalidValue(char *theDir, char *varName, long long index, double value)
 {
    static char lastDir[1024], lastVar[1024];
    char errMsg[128];
@@ -137,17 +151,22 @@ handleInvalidValue(char *theDir, char *varName, int index, double value)
       /* strip off leading slash for root dir */
       if (strcmp(lastDir, theDir) || strcmp(lastVar, varName))
       {
+         if (multiFile)
+            printf("   %s:\n", fileName);
          if (!strcmp(theDir,"/"))
             printf("   simple array /%s...\n", varName);
          else
             printf("   simple array %s/%s...\n", theDir, varName);
       }
-      printf("   ...has %s issue at index %d\n", errMsg, index);
+      printf("   ...has %s issue at index %lld\n", errMsg, index);
    }
    else
    {
       /* early termination of we not using verbose mode */
-      printf("   found %s issue\n", errMsg);
+      if (multiFile)
+         printf("   %s: found %s issue\n", fileName, errMsg);
+      else
+         printf("   found %s issue\n", errMsg);
       exit(-1);
    }
 
@@ -163,54 +182,152 @@ handleInvalidValue(char *theDir, char *varName, int index, double value)
    of bytes in the file is primarily float and double data. Of course, there
    can be a lot of integer data too, but rarely is it more than 10-20% of
    the whole file. So, our % complete measure is a rough approximation that
-   is always an underestimate. Next, we would like to update the user about
-   progress on an elapsed time basis. So, we need to know how much time has
-   gone by. However, if we call gettimeofday after every NaN test, that would
-   kill us! So, we predict how long in the future, in terms of number of
-   NaN checks, we can go before we need to peek at the time. Then, we call
-   gettimeofday. At that point, we know how much time has passed since the
-   last call and we know how many checks we've done. We can compute the
-   current check rate and a new count of checks into the future before we
-   need to call gettimeofday again. */
+   is always an underestimate. Progress is updated once per slice read,
+   which is rare enough that we can simply look at the time on each call
+   and report every UPDATE_INTERVAL seconds. */
 static void
-updateProgress(int bytes)
+updateProgress(long long bytes)
 {
-   static int nextUpdate;
-   static int processedBytes;
-   static int checksPerformed;
+   static long long processedBytes;
    static double tLast;
    struct timeval timeVal;
-   struct timezone timeZone;
+   double tNow;
+
+   gettimeofday(&timeVal, NULL);
+   tNow = (double) timeVal.tv_sec + (double) timeVal.tv_usec * 1.0E-6;
 
    /* bytes==0 ==> initialization */
    if (bytes == 0)
    {
-      nextUpdate = INITIAL_CHECK_RATE * UPDATE_INTERVAL;
       processedBytes = 0;
-      checksPerformed = 0;
-      gettimeofday(&timeVal, &timeZone);
-      tLast = (double) timeVal.tv_sec + (double) timeVal.tv_usec * 1.0E-6;
+      tLast = tNow;
+      return;
    }
-   else
+
+   processedBytes += bytes;
+   if (tNow - tLast >= UPDATE_INTERVAL && totalBytes > 0)
    {
+      if (multiFile)
+         printf("\n*** %s: %2d %% completed ***\n", fileName,
+            (int) (processedBytes*100/totalBytes));
+      else
+         printf("\n*** %2d %% completed ***\n",
+            (int) (processedBytes*100/totalBytes));
+      tLast = tNow;
+   }
+}
 
-      processedBytes += bytes;
-      checksPerformed++;
 
-      if (checksPerformed >= nextUpdate)
-      {
-         double currentCheckRate;
-         double tNow;
+/* Classify N values at p, BLOCK_SIZE at a time. The test on each block
+   is a branch-free OR over the exponent bits of its values which the
+   compiler can vectorize. Only a block that has a NaN or Inf in it is
+   looked at value by value to report where. */
+static void
+scanFloats(char *theDir, char *varName, float const *p, long long n,
+   long long base)
+{
+   uint32_t const *u = (uint32_t const *) p;
+   long long i, j;
+
+   for (i = 0; i < n; i += BLOCK_SIZE)
+   {
+      long long m = n - i < BLOCK_SIZE ? n - i : BLOCK_SIZE;
+      int bad = 0;
+
+      for (j = 0; j < m; j++)
+         bad |= (u[i+j] & FLT_EXP_MASK) == FLT_EXP_MASK;
+      if (!bad)
+         continue;
+      for (j = 0; j < m; j++)
+         if (!IS_VALID_FLOAT(p[i+j]))
+            handleInvalidValue(theDir, varName, base+i+j, (double) p[i+j]);
+   }
+}
+
+static void
+scanDoubles(char *theDir, char *varName, double const *p, long long n,
+   long long base)
+{
+   uint64_t const *u = (uint64_t const *) p;
+   long long i, j;
+
+   for (i = 0; i < n; i += BLOCK_SIZE)
+   {
+      long long m = n - i < BLOCK_SIZE ? n - i : BLOCK_SIZE;
+      int bad = 0;
+
+      for (j = 0; j < m; j++)
+         bad |= (u[i+j] & DBL_EXP_MASK) == DBL_EXP_MASK;
+      if (!bad)
+         continue;
+      for (j = 0; j < m; j++)
+         if (!IS_VALID_DOUBLE(p[i+j]))
+            handleInvalidValue(theDir, varName, base+i+j, p[i+j]);
+   }
+}
 
-         printf("\n*** %2d %% completed ***\n", processedBytes*100/totalBytes);
 
-         gettimeofday(&timeVal, &timeZone);
-         tNow = (double) timeVal.tv_sec + (double) timeVal.tv_usec * 1.0E-6;
-         currentCheckRate = checksPerformed / (tNow - tLast);
-         nextUpdate += (currentCheckRate * UPDATE_INTERVAL);
-         tLast = tNow;
+/* Read a float or double array in slices of about SLICE_BYTES along its
+   slowest varying dimension, so memory use does not grow with the size
+   of the largest array in the file, and scan each slice. */
+static void
+scanArray(DBfile *siloFile, char *theDir, char *varName, int dbType)
+{
+   int dims[MAX_DIMS], offset[MAX_DIMS], length[MAX_DIMS], stride[MAX_DIMS];
+   int i, ndims, rows;
+   size_t size = dbType == DB_FLOAT ? sizeof(float) : sizeof(double);
+   long long rowLen = 1, row;
+
+   ndims = DBGetVarDims(siloFile, varName, MAX_DIMS, dims);
+   if (ndims <= 0)
+      return;
+   for (i = 1; i < ndims; i++)
+      rowLen *= dims[i];
+   if (dims[0] <= 0 || rowLen <= 0)
+      return;
+   rows = (int) (SLICE_BYTES / (rowLen * size));
+   if (rows < 1)
+      rows = 1;
+   if (rows > dims[0])
+      rows = dims[0];
+
+   /* grow the one slice buffer if necessary */
+   if (rows * rowLen * size > sliceBufSize)
+   {
+      free(sliceBuf);
+      sliceBufSize = rows * rowLen * size;
+      sliceBuf = malloc(sliceBufSize);
+      if (!sliceBuf)
+      {
+         fprintf(stderr, "unable to allocate %lld bytes\n",
+            (long long) sliceBufSize);
+         exit(-1);
       }
    }
+
+   for (i = 0; i < ndims; i++)
+   {
+      offset[i] = 0;
+      length[i] = dims[i];
+      stride[i] = 1;
+   }
+   for (row = 0; row < dims[0]; row += rows)
+   {
+      long long n;
+
+      offset[0] = (int) row;
+      length[0] = (int) (dims[0] - row < rows ? dims[0] - row : rows);
+      n = length[0] * rowLen;
+      if (DBReadVarSlice(siloFile, varName, offset, length, stride, ndims,
+             sliceBuf) < 0)
+         return;
+      if (dbType == DB_FLOAT)
+         scanFloats(theDir, varName, (float const *) sliceBuf, n, row*rowLen);
+      else
+         scanDoubles(theDir, varName, (double const *) sliceBuf, n, row*rowLen);
+      if (!disableProgress)
+         updateProgress(n * (long long) size);
+   }
 }
 
 
@@ -218,14 +335,10 @@ updateProgress(int bytes)
    in the file. Ultimately, the data associated with all of Silo's abstract
    objects, excpet for object headers, is implemented in terms of simple
    arrays. This function finds all the simple arrays in the current dir
-   and for each float or double array, reads it and examines it for NaNs.
-   To avoid constantly allocating and freeing the buffers for arrays, we
-   simply keep a growing buffer that grows to the largest array in the file
-   and is freed only upon exit. We use Silo's non-allocating simple array
-   read function. To make the loops for checking a NaN as fast as possible,
-   we have two versions of the loop, one where progress is checked and 
-   one where progress is not checked. We first examine all the simple
-   arrays in the current dir, then we loop over subdirs and recurse */
+   and for each float or double array, reads it in slices and examines it
+   for NaNs. We first examine all the simple arrays in the current dir,
+   then we loop over subdirs and recurse. DBGetToc builds the table of
+   contents of the current dir itself, so we do not ask for a new one. */
 static void
 scanSiloDir(DBfile *siloFile, char *theDir)
 {
@@ -233,7 +346,6 @@ scanSiloDir(DBfile *siloFile, char *theDir)
    int i,nDirs,nObjects;
    DBtoc *toc;
 
-   DBNewToc(siloFile);
    toc = DBGetToc(siloFile);
 
    if (toc == NULL)
@@ -248,11 +360,9 @@ scanSiloDir(DBfile *siloFile, char *theDir)
    for (i = 0; i < toc->nvar; i++)
    {
       char *varName = toc->var_names[i];
-      int n         = DBGetVarLength(siloFile, varName);
       int dbType    = DBGetVarType(siloFile, varName);
-      int j;
 
-      if (!disableVerbose)
+      if (!disableVerbose && !multiFile)
       {
          if (dbType == DB_FLOAT || dbType == DB_DOUBLE)
             printf("CHECKING array %-56s\r", varName);
@@ -260,68 +370,8 @@ scanSiloDir(DBfile *siloFile, char *theDir)
             printf("skipping array %-56s\r", varName);
       }
 
-      /* for float arrays */
-      if (dbType == DB_FLOAT)
-      {
-
-         /* increase allocated buffer if necessary */
-         if (n*sizeof(float) > fBufSize)
-         {
-            if (fBuf != NULL)
-               free(fBuf);
-            fBuf = (float *) malloc(n * sizeof(float));
-            fBufSize = n;
-         }
-
-         DBReadVar(siloFile, varName, fBuf);
-
-         if (disableProgress)
-         {
-            for (j = 0; j < n; j++)
-               if (!IS_VALID_FLOAT(fBuf[j]))
-                  handleInvalidValue(theDir, varName, j, (double) fBuf[j]);
-         }
-         else
-         {
-            for (j = 0; j < n; j++)
-            {
-               if (!IS_VALID_FLOAT(fBuf[j]))
-                  handleInvalidValue(theDir, varName, j, (double) fBuf[j]);
-               updateProgress(sizeof(float));
-            }
-         }
-      }
-
-      /* for double arrays */
-      if (dbType == DB_DOUBLE)
-      {
-         /* increase allocated buffer if necessary */
-         if (n*sizeof(double) > dBufSize)
-         {
-            if (dBuf != NULL)
-               free(dBuf);
-            dBuf = (double *) malloc(n * sizeof(double));
-            dBufSize = n;
-         }
-
-         DBReadVar(siloFile, varName, dBuf);
-
-         if (disableProgress)
-         {
-            for (j = 0; j < n; j++)
-               if (!IS_VALID_DOUBLE(dBuf[j]))
-                  handleInvalidValue(theDir, varName, j, dBuf[j]);
-         }
-         else
-         {
-            for (j = 0; j < n; j++)
-            {
-               if (!IS_VALID_DOUBLE(dBuf[j]))
-                  handleInvalidValue(theDir, varName, j, dBuf[j]);
-               updateProgress(sizeof(double));
-            }
-         }
-      }
+      if (dbType == DB_FLOAT || dbType == DB_DOUBLE)
+         scanArray(siloFile, theDir, varName, dbType);
    } /* for i */
 
    /* save off the dir-stuff out of the toc so we don't loose it during the
@@ -349,21 +399,143 @@ scanSiloDir(DBfile *siloFile, char *theDir)
 }
 
 
+/* Scan one file. Returns 0 on success, -1 if it cannot be opened. */
+static int
+scanSiloFile(char const *name, char const *progName)
+{
+   DBfile *siloFile;
+   struct stat stat_buf;
+
+   strncpy(fileName, name, sizeof(fileName)-1);
+   totalBytes = stat(fileName, &stat_buf) == 0 ? (long long) stat_buf.st_size : 0;
+
+   /* initialize progress meter */
+   updateProgress(0);
+
+   DBShowErrors(DB_NONE, NULL);
+
+   siloFile = DBOpen(fileName, DB_UNKNOWN, DB_READ);
+
+   if (siloFile == NULL)
+   {
+      fprintf(stderr, "unable to open silo file \"%s\"\n", fileName);
+      return -1;
+   }
+
+   DBShowErrors(DB_TOP, NULL);
+
+   if (DBGetDriverType(siloFile) == DB_HDF5 && !DBGuessHasFriendlyHDF5Names(siloFile))
+   {
+       fprintf(stderr,"WARNING: This is an HDF5 file without \"Friendly\" HDF5 array names.\n");
+       fprintf(stderr,"WARNING: Consequently, while %s will be able to find/detect nans/infs,\n",
+           strrchr(progName,'/')?strrchr(progName,'/')+1:progName);
+       fprintf(stderr,"WARNING: the names of the arrays in which it finds them will be cryptic.\n");
+       fprintf(stderr,"WARNING: You will most likely have to use h5ls/h5dump to determine which\n");
+       fprintf(stderr,"WARNING: Silo objects are involved.\n");
+       DBSetDir(siloFile, "/.silo");
+       scanSiloDir(siloFile, "/.silo");
+   }
+   else
+   {
+       scanSiloDir(siloFile, "/");
+   }
+
+   DBClose(siloFile);
+
+   if (!disableProgress)
+   {
+      if (multiFile)
+         printf("\n*** %s: 100 %% completed ***\n", fileName);
+      else
+         printf("\n*** 100 %% completed ***\n");
+   }
+
+   return 0;
+}
+
+
+/* Scan the files on a pool of nWorkers worker processes. The library
+   keeps per-process state for open files, so each file gets a process
+   of its own rather than a thread. Returns 0 if every file scanned
+   cleanly, -1 otherwise. In quiet mode the first file with a bad value
+   stops the others. */
+static int
+scanSiloFiles(char **names, int nFiles, int nWorkers, char const *progName)
+{
+   pid_t *pids = (pid_t *) calloc(nWorkers, sizeof(pid_t));
+   int next = 0, running = 0, result = 0, i;
+
+   while (next < nFiles || running > 0)
+   {
+      pid_t pid;
+      int status;
+
+      while (running < nWorkers && next < nFiles)
+      {
+         fflush(stdout);
+         fflush(stderr);
+         pid = fork();
+         if (pid == 0)
+            exit(scanSiloFile(names[next], progName) ? 1 : 0);
+         if (pid < 0)
+         {
+            /* no more processes; scan this one ourselves */
+            if (scanSiloFile(names[next], progName))
+               result = -1;
+            next++;
+            continue;
+         }
+         for (i = 0; i < nWorkers && pids[i]; i++)
+            ;
+         pids[i] = pid;
+         running++;
+         next++;
+      }
+      if (running == 0)
+         continue;
+
+      pid = wait(&status);
+      if (pid < 0)
+         break;
+      for (i = 0; i < nWorkers; i++)
+      {
+         if (pids[i] == pid)
+         {
+            pids[i] = 0;
+            running--;
+         }
+      }
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      {
+         result = -1;
+         if (disableVerbose)
+         {
+            for (i = 0; i < nWorkers; i++)
+               if (pids[i])
+                  kill(pids[i], SIGTERM);
+            next = nFiles;
+         }
+      }
+   }
+
+   free(pids);
+   return result;
+}
+
+
 int
 main(int argc, char *argv[])
 {
-   int i;
-   DBfile *siloFile;
+   int i, nFiles = 0, nWorkers = 1, result;
+   char **fileNames = (char **) malloc(argc * sizeof(char*));
 
    /* set default values */
    disableProgress = False;
    disableVerbose  = False;
 
    /* initialization */
-   fBufSize = 0;
-   dBufSize = 0;
-   fBuf = NULL;
-   dBuf = NULL;
+   sliceBufSize = 0;
+   sliceBuf = NULL;
 
    /* here's where we issue an error message if we have no isnan() test */
 #ifndef HAVE_ISNAN
@@ -379,78 +551,65 @@ main(int argc, char *argv[])
          disableProgress = True;
       else if (!strcmp(argv[i], "-q"))
          disableVerbose = True;
+      else if (!strcmp(argv[i], "-j") && i+1 < argc)
+      {
+         nWorkers = atoi(argv[++i]);
+         if (nWorkers < 1)
+            nWorkers = 1;
+      }
       else if (!strcmp(argv[i], "-help"))
       {
-         fprintf(stderr,"Scan a silo file for NaN/Inf floating point data\n"); 
+         fprintf(stderr,"Scan silo files for NaN/Inf floating point data\n"); 
          fprintf(stderr,"Warning: As a precaution, you should use this tool\n");
          fprintf(stderr,"         only on the same class of platform the\n");
          fprintf(stderr,"         data was generated on.\n");
-         fprintf(stderr,"usage: silock [-q] [-progress]"
-            " silofile\n");
+         fprintf(stderr,"usage: silock [-q] [-progress] [-j nworkers]"
+            " silofile [silofile...]\n");
          fprintf(stderr,"available options...\n");
          fprintf(stderr,"   -progress: Disable progress display\n");
          fprintf(stderr,"   -q:        Quiet. Report only if bad values\n");
          fprintf(stderr,"              exist and exit on first occurence\n");
+         fprintf(stderr,"   -j:        Scan up to nworkers files at once\n");
          exit(-1);
       }
       else /* assume its a file and try to open it */
       {
          struct stat stat_buf;
 
-         strncpy(fileName, argv[i], sizeof(fileName)-1);
-         if (stat(fileName, &stat_buf) != 0)
+         if (stat(argv[i], &stat_buf) != 0)
          {
             fprintf(stderr,"unrecognized option \"%s\". Use -help for usage\n",
-               fileName);
+               argv[i]);
             exit(-1);
          }
-         totalBytes = stat_buf.st_size;
+         fileNames[nFiles++] = argv[i];
       }
    }
 
-   /* initialize progress meter */
-   updateProgress(0);
-
-   DBShowErrors(DB_NONE, NULL);
-
-   siloFile = DBOpen(fileName, DB_UNKNOWN, DB_READ);
-
-   if (siloFile == NULL)
+   if (nFiles == 0)
    {
-      fprintf(stderr, "unable to open silo file \"%s\"\n", fileName);
+      fprintf(stderr, "no silo file given. Use -help for usage\n");
       exit(-1);
    }
 
-   DBShowErrors(DB_TOP, NULL);
-
-   if (DBGetDriverType(siloFile) == DB_HDF5 && !DBGuessHasFriendlyHDF5Names(siloFile))
+   multiFile = nFiles > 1;
+   if (nFiles == 1 || nWorkers == 1)
    {
-       fprintf(stderr,"WARNING: This is an HDF5 file without \"Friendly\" HDF5 array names.\n");
-       fprintf(stderr,"WARNING: Consequently, while %s will be able to find/detect nans/infs,\n",
-           strrchr(argv[0],'/')?strrchr(argv[0],'/')+1:argv[0]);
-       fprintf(stderr,"WARNING: the names of the arrays in which it finds them will be cryptic.\n");
-       fprintf(stderr,"WARNING: You will most likely have to use h5ls/h5dump to determine which\n");
-       fprintf(stderr,"WARNING: Silo objects are involved.\n");
-       DBSetDir(siloFile, "/.silo");
-       scanSiloDir(siloFile, "/.silo");
+      for (i = 0, result = 0; i < nFiles; i++)
+         if (scanSiloFile(fileNames[i], argv[0]))
+            exit(-1);
    }
    else
    {
-       scanSiloDir(siloFile, "/");
+      result = scanSiloFiles(fileNames, nFiles, nWorkers, argv[0]);
    }
 
-   DBClose(siloFile);
-
-   if (fBuf != NULL)
-      free(fBuf);
-   if (dBuf != NULL)
-      free(dBuf);
-
-   if (!disableProgress)
-      printf("\n*** 100 %% completed ***\n");
+   if (sliceBuf != NULL)
+      free(sliceBuf);
+   free(fileNames);
 
    if (!disableVerbose)
       printf("\n");
 
-   return 0;
+   return result;
 }
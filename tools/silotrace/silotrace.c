@@ -0,0 +1,235 @@
+/*
+Copyright (C) 1994-2016 Lawrence Livermore National Security, LLC.
+LLNL-CODE-425250.
+All rights reserved.
+
+This file is part of Silo. For details, see silo.llnl.gov.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the disclaimer below.
+   * Redistributions in binary form must reproduce the above copyright
+     notice, this list of conditions and the disclaimer (as noted
+     below) in the documentation and/or other materials provided with
+     the distribution.
+   * Neither the name of the LLNS/LLNL nor the names of its
+     contributors may be used to endorse or promote products derived
+     from this software without specific prior written permission.
+
+THIS SOFTWARE  IS PROVIDED BY  THE COPYRIGHT HOLDERS  AND CONTRIBUTORS
+"AS  IS" AND  ANY EXPRESS  OR IMPLIED  WARRANTIES, INCLUDING,  BUT NOT
+LIMITED TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A  PARTICULAR  PURPOSE ARE  DISCLAIMED.  IN  NO  EVENT SHALL  LAWRENCE
+LIVERMORE  NATIONAL SECURITY, LLC,  THE U.S.  DEPARTMENT OF  ENERGY OR
+CONTRIBUTORS BE LIABLE FOR  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR  CONSEQUENTIAL DAMAGES  (INCLUDING, BUT NOT  LIMITED TO,
+PROCUREMENT OF  SUBSTITUTE GOODS  OR SERVICES; LOSS  OF USE,  DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER  IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING
+NEGLIGENCE OR  OTHERWISE) ARISING IN  ANY WAY OUT  OF THE USE  OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This work was produced at Lawrence Livermore National Laboratory under
+Contract No.  DE-AC52-07NA27344 with the DOE.
+
+Neither the  United States Government nor  Lawrence Livermore National
+Security, LLC nor any of  their employees, makes any warranty, express
+or  implied,  or  assumes  any  liability or  responsibility  for  the
+accuracy, completeness,  or usefulness of  any information, apparatus,
+product, or  process disclosed, or  represents that its use  would not
+infringe privately-owned rights.
+
+Any reference herein to  any specific commercial products, process, or
+services by trade name,  trademark, manufacturer or otherwise does not
+necessarily  constitute or imply  its endorsement,  recommendation, or
+favoring  by  the  United  States  Government  or  Lawrence  Livermore
+National Security,  LLC. The views  and opinions of  authors expressed
+herein do not necessarily state  or reflect those of the United States
+Government or Lawrence Livermore National Security, LLC, and shall not
+be used for advertising or product endorsement purposes.
+*/
+/*-------------------------------------------------------------------------
+ * silotrace: convert Silo API traces written by DBSetTrace to the Chrome
+ * trace event JSON format, for chrome://tracing or Perfetto. Each input
+ * file becomes one process in the output; its threads keep the numbers
+ * Silo gave them.
+ *-------------------------------------------------------------------------
+ */
+#include <config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <silo.h>
+
+static char const *
+driver_name(int driver)
+{
+    switch (driver)
+    {
+        case DB_NETCDF:  return "netcdf";
+        case DB_PDB:     return "pdb";
+        case DB_TAURUS:  return "taurus";
+        case DB_UNKNOWN: return "unknown";
+        case DB_DEBUG:   return "debug";
+        case DB_HDF5X:   return "hdf5";
+        case DB_PDBP:    return "pdbp";
+    }
+    return 0;
+}
+
+/* Write one trace file's events; return the number of events dropped */
+static long
+convert(FILE *in, char const *filename, FILE *out, int *first)
+{
+    char magic[8];
+    unsigned int hdr[4], pid;
+    char **names = 0, *buf;
+    unsigned int nnames = 0, i;
+    long dropped = 0;
+    DBtraceevent e;
+
+    if (fread(magic, 1, 8, in) != 8 || memcmp(magic, "SILOTRC1", 8) ||
+        fread(hdr, sizeof(unsigned int), 3, in) != 3)
+    {
+        fprintf(stderr, "%s: not a Silo trace\n", filename);
+        return -1;
+    }
+    if (hdr[0] != sizeof(DBtraceevent))
+    {
+        fprintf(stderr, "%s: written by an incompatible Silo\n", filename);
+        return -1;
+    }
+    pid = hdr[1];
+
+    while (fread(hdr, sizeof(unsigned int), 4, in) == 4)
+    {
+        if (hdr[0] == DB_TRACE_BLOCK_NAMES)
+        {
+            char *p;
+            if (hdr[1] + hdr[2] > nnames)
+            {
+                names = (char **) realloc(names, (hdr[1] + hdr[2]) * sizeof(char*));
+                for (i = nnames; i < hdr[1] + hdr[2]; i++)
+                    names[i] = 0;
+                nnames = hdr[1] + hdr[2];
+            }
+            buf = (char *) malloc(hdr[3] + 1);
+            if (fread(buf, 1, hdr[3], in) != hdr[3])
+            {
+                fprintf(stderr, "%s: truncated\n", filename);
+                free(buf);
+                break;
+            }
+            buf[hdr[3]] = '\0';
+            for (i = 0, p = buf; i < hdr[2] && p < buf + hdr[3]; i++, p += strlen(p) + 1)
+                names[hdr[1] + i] = strdup(p);
+            free(buf);
+        }
+        else if (hdr[0] == DB_TRACE_BLOCK_EVENTS)
+        {
+            dropped += (long) hdr[3];
+            for (i = 0; i < hdr[2] && fread(&e, sizeof(e), 1, in) == 1; i++)
+            {
+                char const *name = e.name < nnames && names[e.name] ? names[e.name] : "?";
+                char const *drv = driver_name(e.driver);
+
+                fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"silo\",\"ph\":\"%s\","
+                    "\"ts\":%.3f,\"pid\":%u,\"tid\":%u", *first ? "" : ",", name,
+                    e.kind == DB_TRACE_ENTER ? "B" : "E", e.time / 1000.0, pid,
+                    e.thread);
+                *first = 0;
+                if (e.kind == DB_TRACE_ENTER)
+                {
+                    fprintf(out, ",\"args\":{");
+                    if (e.objhash)
+                        fprintf(out, "\"object\":\"%08x\",", e.objhash);
+                    if (drv)
+                        fprintf(out, "\"driver\":\"%s\"", drv);
+                    else
+                        fprintf(out, "\"driver\":%d", (int) e.driver);
+                    fprintf(out, "}");
+                }
+                else
+                {
+                    fprintf(out, ",\"args\":{\"bytes\":%lld}", e.nbytes);
+                }
+                fprintf(out, "}");
+            }
+            if (i < hdr[2])
+            {
+                fprintf(stderr, "%s: truncated\n", filename);
+                break;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s: unknown block %u\n", filename, hdr[0]);
+            break;
+        }
+    }
+
+    for (i = 0; i < nnames; i++)
+        free(names[i]);
+    free(names);
+    return dropped;
+}
+
+int
+main(int argc, char *argv[])
+{
+    FILE *out = stdout, *in;
+    int i, first = 1, nfiles = 0, err = 0;
+    long n, dropped = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o") && i+1 < argc)
+        {
+            if ((out = fopen(argv[++i], "w")) == 0)
+            {
+                fprintf(stderr, "cannot create \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "-help") || argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: silotrace [-o out.json] trace-file...\n");
+            return argv[i][1] == 'h' ? 0 : 1;
+        }
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-o"))
+        {
+            i++;
+            continue;
+        }
+        nfiles++;
+        if ((in = fopen(argv[i], "rb")) == 0)
+        {
+            fprintf(stderr, "cannot open \"%s\"\n", argv[i]);
+            err = 1;
+            continue;
+        }
+        if ((n = convert(in, argv[i], out, &first)) < 0)
+            err = 1;
+        else
+            dropped += n;
+        fclose(in);
+    }
+    fprintf(out, "\n]}\n");
+    if (out != stdout)
+        fclose(out);
+
+    if (!nfiles)
+        fprintf(stderr, "usage: silotrace [-o out.json] trace-file...\n");
+    if (dropped)
+        fprintf(stderr, "%ld events were dropped; use a larger ring in DBSetTrace\n",
+            dropped);
+    return err || !nfiles;
+}